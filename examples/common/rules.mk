@@ -26,8 +26,10 @@ IOTC_EXAMPLE_SRCDIR := $(CURDIR)/src
 IOTC_EXAMPLE_OBJDIR := $(CURDIR)/obj
 IOTC_EXAMPLE_BINDIR ?= $(CURDIR)/bin
 
-IOTC_EXAMPLE_SRCS += common/commandline.c
-IOTC_EXAMPLE_SRCS += common/example_utils.c
+# the shared sources of the Cloud IoT Core examples
+IOTC_EXAMPLE_COMMON_SRCS ?= commandline.c example_utils.c
+
+IOTC_EXAMPLE_SRCS += $(addprefix common/,$(IOTC_EXAMPLE_COMMON_SRCS))
 IOTC_EXAMPLE_SRCS += $(IOTC_EXAMPLE_NAME).c
 
 IOTC_EXAMPLE_DEPS := $(subst $(IOTC_EXAMPLE_SRCDIR)/,,$(IOTC_EXAMPLE_SRCS:.c=.d))
@@ -0,0 +1,136 @@
+/* Copyright 2018-2020 Google LLC
+ *
+ * This is part of the Google Cloud IoT Device SDK for Embedded C.
+ * It is licensed under the BSD 3-Clause license; you may not use this file
+ * except in compliance with the License.
+ *
+ * You may obtain a copy of the License at:
+ *  https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "load_stats.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <time.h>
+#include <unistd.h>
+
+#define LOAD_STATS_SUB_BUCKETS (1 << LOAD_STATS_SUB_BUCKET_BITS)
+
+uint64_t load_stats_now_us(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+static size_t load_stats_bucket_of(uint64_t value) {
+  if (value < 2 * LOAD_STATS_SUB_BUCKETS) {
+    return (size_t)value;
+  }
+
+  const int msb = 63 - __builtin_clzll(value);
+  const int shift = msb - LOAD_STATS_SUB_BUCKET_BITS;
+  const size_t bucket = ((size_t)(shift + 1) << LOAD_STATS_SUB_BUCKET_BITS) +
+                        (size_t)(value >> shift) - LOAD_STATS_SUB_BUCKETS;
+
+  return bucket < LOAD_STATS_HISTOGRAM_BUCKETS
+             ? bucket
+             : LOAD_STATS_HISTOGRAM_BUCKETS - 1;
+}
+
+/* The smallest value that falls into the bucket. */
+static uint64_t load_stats_bucket_start(size_t bucket) {
+  if (bucket < 2 * LOAD_STATS_SUB_BUCKETS) {
+    return bucket;
+  }
+
+  const int shift = (int)(bucket >> LOAD_STATS_SUB_BUCKET_BITS) - 1;
+  const uint64_t sub_bucket =
+      (bucket & (LOAD_STATS_SUB_BUCKETS - 1)) + LOAD_STATS_SUB_BUCKETS;
+
+  return sub_bucket << shift;
+}
+
+void load_stats_histogram_record(load_stats_histogram_t* histogram,
+                                 uint64_t value_us) {
+  ++histogram->counts[load_stats_bucket_of(value_us)];
+  ++histogram->total;
+
+  if (value_us > histogram->max) {
+    histogram->max = value_us;
+  }
+}
+
+void load_stats_histogram_merge(load_stats_histogram_t* into,
+                                const load_stats_histogram_t* from) {
+  size_t bucket = 0;
+  for (; bucket < LOAD_STATS_HISTOGRAM_BUCKETS; ++bucket) {
+    into->counts[bucket] += from->counts[bucket];
+  }
+
+  into->total += from->total;
+
+  if (from->max > into->max) {
+    into->max = from->max;
+  }
+}
+
+uint64_t load_stats_histogram_percentile(
+    const load_stats_histogram_t* histogram, double percent) {
+  if (0 == histogram->total) {
+    return 0;
+  }
+
+  /* the rank of the value, counting from 1 */
+  uint64_t rank = (uint64_t)(percent / 100.0 * histogram->total + 0.5);
+  if (0 == rank) {
+    rank = 1;
+  }
+
+  uint64_t seen = 0;
+  size_t bucket = 0;
+  for (; bucket < LOAD_STATS_HISTOGRAM_BUCKETS; ++bucket) {
+    seen += histogram->counts[bucket];
+
+    if (seen >= rank) {
+      /* the end of the bucket, never above the largest value recorded */
+      const uint64_t end = load_stats_bucket_start(bucket + 1) - 1;
+      return end < histogram->max ? end : histogram->max;
+    }
+  }
+
+  return histogram->max;
+}
+
+void load_stats_get_usage(load_stats_usage_t* usage) {
+  memset(usage, 0, sizeof(load_stats_usage_t));
+
+  struct rusage rusage;
+  if (0 == getrusage(RUSAGE_SELF, &rusage)) {
+    usage->cpu_seconds = rusage.ru_utime.tv_sec + rusage.ru_stime.tv_sec +
+                         (rusage.ru_utime.tv_usec + rusage.ru_stime.tv_usec) /
+                             1000000.0;
+    /* kilobytes on Linux */
+    usage->max_rss_kb = rusage.ru_maxrss;
+  }
+
+  /* the resident set is the second field, in pages */
+  FILE* statm = fopen("/proc/self/statm", "r");
+  if (NULL != statm) {
+    unsigned long size_pages = 0;
+    unsigned long resident_pages = 0;
+
+    if (2 == fscanf(statm, "%lu %lu", &size_pages, &resident_pages)) {
+      usage->rss_kb = resident_pages * (sysconf(_SC_PAGESIZE) / 1024);
+    }
+
+    fclose(statm);
+  }
+}
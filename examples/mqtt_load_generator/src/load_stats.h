@@ -0,0 +1,64 @@
+/* Copyright 2018-2020 Google LLC
+ *
+ * This is part of the Google Cloud IoT Device SDK for Embedded C.
+ * It is licensed under the BSD 3-Clause license; you may not use this file
+ * except in compliance with the License.
+ *
+ * You may obtain a copy of the License at:
+ *  https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __LOAD_STATS_H__
+#define __LOAD_STATS_H__
+
+#include <stdint.h>
+
+/*
+ * This module implements the measurements of the load generator: latency
+ * histograms and the resource usage of the process.
+ */
+
+/* Latencies are kept in microseconds, in buckets 1/16 of a power of two
+   wide, so percentiles are within about 6% of the exact value. */
+#define LOAD_STATS_SUB_BUCKET_BITS 4
+#define LOAD_STATS_MAX_VALUE_BITS 40
+#define LOAD_STATS_HISTOGRAM_BUCKETS                                   \
+  ((LOAD_STATS_MAX_VALUE_BITS - LOAD_STATS_SUB_BUCKET_BITS + 1) << \
+   LOAD_STATS_SUB_BUCKET_BITS)
+
+typedef struct load_stats_histogram_s {
+  uint64_t counts[LOAD_STATS_HISTOGRAM_BUCKETS];
+  uint64_t total;
+  uint64_t max;
+} load_stats_histogram_t;
+
+typedef struct load_stats_usage_s {
+  /* user and system time of all the threads */
+  double cpu_seconds;
+  unsigned long rss_kb;
+  unsigned long max_rss_kb;
+} load_stats_usage_t;
+
+/* The monotonic clock in microseconds. */
+uint64_t load_stats_now_us(void);
+
+void load_stats_histogram_record(load_stats_histogram_t* histogram,
+                                 uint64_t value_us);
+
+void load_stats_histogram_merge(load_stats_histogram_t* into,
+                                const load_stats_histogram_t* from);
+
+/* Returns the value below which the given percent of the recorded values
+   fall, or 0 if nothing was recorded. */
+uint64_t load_stats_histogram_percentile(
+    const load_stats_histogram_t* histogram, double percent);
+
+void load_stats_get_usage(load_stats_usage_t* usage);
+
+#endif /* __LOAD_STATS_H__ */
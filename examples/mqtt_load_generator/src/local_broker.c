@@ -0,0 +1,446 @@
+/* Copyright 2018-2020 Google LLC
+ *
+ * This is part of the Google Cloud IoT Device SDK for Embedded C.
+ * It is licensed under the BSD 3-Clause license; you may not use this file
+ * except in compliance with the License.
+ *
+ * You may obtain a copy of the License at:
+ *  https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "local_broker.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/prctl.h>
+#endif
+
+/* The buffers of a client grow by this much when they are full. */
+#define LOCAL_BROKER_BUFFER_CHUNK 4096
+
+/* MQTT v3.1.1 control packet types. */
+#define LOCAL_BROKER_CONNECT 1
+#define LOCAL_BROKER_PUBLISH 3
+#define LOCAL_BROKER_SUBSCRIBE 8
+#define LOCAL_BROKER_UNSUBSCRIBE 10
+#define LOCAL_BROKER_PINGREQ 12
+#define LOCAL_BROKER_DISCONNECT 14
+
+typedef struct local_broker_buffer_s {
+  uint8_t* data;
+  size_t length;
+  size_t capacity;
+} local_broker_buffer_t;
+
+typedef struct local_broker_client_s {
+  local_broker_buffer_t in;
+  local_broker_buffer_t out;
+  int closing;
+} local_broker_client_t;
+
+typedef struct local_broker_s {
+  /* pollfds[0] is the listening socket, pollfds[i + 1] the socket of
+     clients[i] */
+  struct pollfd* pollfds;
+  local_broker_client_t* clients;
+  size_t clients_length;
+  size_t clients_capacity;
+  unsigned long long clients_served;
+  unsigned long long publishes_received;
+} local_broker_t;
+
+static volatile sig_atomic_t local_broker_stopped = 0;
+
+static void local_broker_on_signal(int signal_number) {
+  (void)signal_number;
+  local_broker_stopped = 1;
+}
+
+static int local_broker_reserve(local_broker_buffer_t* buffer, size_t length) {
+  if (buffer->length + length <= buffer->capacity) {
+    return 0;
+  }
+
+  const size_t capacity = buffer->length + length + LOCAL_BROKER_BUFFER_CHUNK;
+  uint8_t* data = realloc(buffer->data, capacity);
+  if (NULL == data) {
+    return -1;
+  }
+
+  buffer->data = data;
+  buffer->capacity = capacity;
+  return 0;
+}
+
+static void local_broker_append(local_broker_client_t* client,
+                                const uint8_t* data, size_t length) {
+  if (0 != local_broker_reserve(&client->out, length)) {
+    client->closing = 1;
+    return;
+  }
+
+  memcpy(client->out.data + client->out.length, data, length);
+  client->out.length += length;
+}
+
+/* Answers one complete control packet. */
+static void local_broker_handle_packet(local_broker_t* broker,
+                                       local_broker_client_t* client,
+                                       uint8_t header, const uint8_t* body,
+                                       size_t length) {
+  switch (header >> 4) {
+    case LOCAL_BROKER_CONNECT: {
+      static const uint8_t connack[] = {0x20, 0x02, 0x00, 0x00};
+      local_broker_append(client, connack, sizeof(connack));
+    } break;
+    case LOCAL_BROKER_PUBLISH: {
+      ++broker->publishes_received;
+
+      const size_t topic_length = length < 2 ? 0 : (body[0] << 8) | body[1];
+      if (0 != ((header >> 1) & 0x03) && 2 + topic_length + 2 <= length) {
+        const uint8_t puback[] = {0x40, 0x02, body[2 + topic_length],
+                                  body[2 + topic_length + 1]};
+        local_broker_append(client, puback, sizeof(puback));
+      }
+    } break;
+    case LOCAL_BROKER_SUBSCRIBE: {
+      /* the SDK sends a single topic filter per SUBSCRIBE */
+      if (5 <= length) {
+        const uint8_t requested_qos = body[length - 1];
+        const uint8_t suback[] = {0x90, 0x03, body[0], body[1],
+                                  requested_qos > 1 ? 1 : requested_qos};
+        local_broker_append(client, suback, sizeof(suback));
+      }
+    } break;
+    case LOCAL_BROKER_UNSUBSCRIBE: {
+      if (2 <= length) {
+        const uint8_t unsuback[] = {0xB0, 0x02, body[0], body[1]};
+        local_broker_append(client, unsuback, sizeof(unsuback));
+      }
+    } break;
+    case LOCAL_BROKER_PINGREQ: {
+      static const uint8_t pingresp[] = {0xD0, 0x00};
+      local_broker_append(client, pingresp, sizeof(pingresp));
+    } break;
+    case LOCAL_BROKER_DISCONNECT:
+      client->closing = 1;
+      break;
+    default:
+      break;
+  }
+}
+
+/* Answers the complete packets at the start of the input buffer and keeps
+   the incomplete one for the next read. */
+static void local_broker_handle_input(local_broker_t* broker,
+                                      local_broker_client_t* client) {
+  size_t offset = 0;
+
+  while (0 == client->closing && offset + 2 <= client->in.length) {
+    const uint8_t* packet = client->in.data + offset;
+    const size_t available = client->in.length - offset;
+
+    /* the remaining length takes up to four bytes */
+    size_t remaining_length = 0;
+    size_t header_length = 1;
+    int complete = 0;
+    for (; header_length <= 4 && header_length < available; ++header_length) {
+      remaining_length |= (size_t)(packet[header_length] & 0x7F)
+                          << (7 * (header_length - 1));
+      if (0 == (packet[header_length] & 0x80)) {
+        complete = 1;
+        break;
+      }
+    }
+
+    if (0 == complete) {
+      if (4 < header_length) {
+        client->closing = 1;
+      }
+      break;
+    }
+
+    ++header_length;
+    if (available < header_length + remaining_length) {
+      break;
+    }
+
+    local_broker_handle_packet(broker, client, packet[0],
+                               packet + header_length, remaining_length);
+    offset += header_length + remaining_length;
+  }
+
+  memmove(client->in.data, client->in.data + offset,
+          client->in.length - offset);
+  client->in.length -= offset;
+}
+
+static void local_broker_read(local_broker_t* broker, size_t client_id) {
+  local_broker_client_t* client = &broker->clients[client_id];
+  const int fd = broker->pollfds[client_id + 1].fd;
+
+  while (0 == client->closing) {
+    if (0 != local_broker_reserve(&client->in, LOCAL_BROKER_BUFFER_CHUNK)) {
+      client->closing = 1;
+      break;
+    }
+
+    const ssize_t received =
+        read(fd, client->in.data + client->in.length,
+             client->in.capacity - client->in.length);
+
+    if (0 < received) {
+      client->in.length += received;
+      local_broker_handle_input(broker, client);
+    } else if (0 > received && (EAGAIN == errno || EWOULDBLOCK == errno)) {
+      break;
+    } else if (0 > received && EINTR == errno) {
+      continue;
+    } else {
+      client->closing = 1;
+    }
+  }
+}
+
+static void local_broker_write(local_broker_t* broker, size_t client_id) {
+  local_broker_client_t* client = &broker->clients[client_id];
+  struct pollfd* pollfd = &broker->pollfds[client_id + 1];
+
+  size_t written = 0;
+  while (written < client->out.length) {
+    const ssize_t sent = write(pollfd->fd, client->out.data + written,
+                               client->out.length - written);
+
+    if (0 < sent) {
+      written += sent;
+    } else if (0 > sent && EINTR == errno) {
+      continue;
+    } else {
+      if (0 > sent && EAGAIN != errno && EWOULDBLOCK != errno) {
+        client->closing = 1;
+      }
+      break;
+    }
+  }
+
+  memmove(client->out.data, client->out.data + written,
+          client->out.length - written);
+  client->out.length -= written;
+
+  /* wait for the socket to drain before writing the rest */
+  pollfd->events = 0 < client->out.length ? POLLIN | POLLOUT : POLLIN;
+}
+
+static void local_broker_close(local_broker_t* broker, size_t client_id) {
+  close(broker->pollfds[client_id + 1].fd);
+  free(broker->clients[client_id].in.data);
+  free(broker->clients[client_id].out.data);
+
+  /* the last client takes the place of the closed one */
+  --broker->clients_length;
+  broker->clients[client_id] = broker->clients[broker->clients_length];
+  broker->pollfds[client_id + 1] = broker->pollfds[broker->clients_length + 1];
+}
+
+static void local_broker_accept(local_broker_t* broker) {
+  for (;;) {
+    const int fd = accept(broker->pollfds[0].fd, NULL, NULL);
+    if (0 > fd) {
+      return;
+    }
+
+    if (broker->clients_length == broker->clients_capacity) {
+      const size_t capacity = 2 * broker->clients_capacity + 64;
+      local_broker_client_t* clients =
+          realloc(broker->clients, capacity * sizeof(local_broker_client_t));
+      struct pollfd* pollfds =
+          realloc(broker->pollfds, (capacity + 1) * sizeof(struct pollfd));
+
+      if (NULL != clients) {
+        broker->clients = clients;
+      }
+
+      if (NULL != pollfds) {
+        broker->pollfds = pollfds;
+      }
+
+      if (NULL == clients || NULL == pollfds) {
+        close(fd);
+        return;
+      }
+
+      broker->clients_capacity = capacity;
+    }
+
+    /* acknowledgements are small, don't let Nagle hold them back */
+    const int flag = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+
+    memset(&broker->clients[broker->clients_length], 0,
+           sizeof(local_broker_client_t));
+    broker->pollfds[broker->clients_length + 1].fd = fd;
+    broker->pollfds[broker->clients_length + 1].events = POLLIN;
+    broker->pollfds[broker->clients_length + 1].revents = 0;
+
+    ++broker->clients_length;
+    ++broker->clients_served;
+  }
+}
+
+static int local_broker_listen(uint16_t port) {
+  const int fd = socket(AF_INET, SOCK_STREAM, 0);
+  if (0 > fd) {
+    return -1;
+  }
+
+  const int flag = 1;
+  setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &flag, sizeof(flag));
+
+  struct sockaddr_in address;
+  memset(&address, 0, sizeof(address));
+  address.sin_family = AF_INET;
+  address.sin_port = htons(port);
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+  if (0 != bind(fd, (struct sockaddr*)&address, sizeof(address)) ||
+      0 != listen(fd, SOMAXCONN)) {
+    close(fd);
+    return -1;
+  }
+
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+  return fd;
+}
+
+static void local_broker_run(int listen_fd) {
+  local_broker_t broker;
+  memset(&broker, 0, sizeof(broker));
+
+  broker.pollfds = malloc(sizeof(struct pollfd));
+  if (NULL == broker.pollfds) {
+    return;
+  }
+
+  broker.pollfds[0].fd = listen_fd;
+  broker.pollfds[0].events = POLLIN;
+
+  while (0 == local_broker_stopped) {
+    if (0 > poll(broker.pollfds, broker.clients_length + 1, -1)) {
+      continue;
+    }
+
+    /* walk backwards, closing a client moves the last one into its place */
+    size_t client_id = broker.clients_length;
+    while (0 < client_id--) {
+      const short revents = broker.pollfds[client_id + 1].revents;
+
+      if (revents & (POLLIN | POLLHUP | POLLERR)) {
+        local_broker_read(&broker, client_id);
+      }
+
+      if (0 < broker.clients[client_id].out.length) {
+        local_broker_write(&broker, client_id);
+      }
+
+      if (0 != broker.clients[client_id].closing) {
+        local_broker_close(&broker, client_id);
+      }
+    }
+
+    if (broker.pollfds[0].revents & POLLIN) {
+      local_broker_accept(&broker);
+    }
+  }
+
+  while (0 < broker.clients_length) {
+    local_broker_close(&broker, broker.clients_length - 1);
+  }
+
+  fprintf(stderr, "local broker: %llu clients served, %llu publishes\n",
+          broker.clients_served, broker.publishes_received);
+
+  free(broker.clients);
+  free(broker.pollfds);
+}
+
+pid_t local_broker_start(uint16_t port) {
+  int ready[2];
+  if (0 != pipe(ready)) {
+    return -1;
+  }
+
+  const pid_t pid = fork();
+
+  if (0 == pid) {
+    close(ready[0]);
+
+#ifdef __linux__
+    /* don't outlive the load generator */
+    prctl(PR_SET_PDEATHSIG, SIGTERM);
+#endif
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = &local_broker_on_signal;
+    sigaction(SIGTERM, &action, NULL);
+    signal(SIGINT, SIG_IGN);
+    signal(SIGPIPE, SIG_IGN);
+
+    const int listen_fd = local_broker_listen(port);
+    const char status = 0 <= listen_fd ? 1 : 0;
+    if ((ssize_t)sizeof(status) != write(ready[1], &status, sizeof(status))) {
+      _exit(1);
+    }
+    close(ready[1]);
+
+    if (0 <= listen_fd) {
+      local_broker_run(listen_fd);
+      close(listen_fd);
+    }
+
+    _exit(0 <= listen_fd ? 0 : 1);
+  }
+
+  close(ready[1]);
+
+  char status = 0;
+  const ssize_t received =
+      0 > pid ? -1 : read(ready[0], &status, sizeof(status));
+
+  if ((ssize_t)sizeof(status) != received || 1 != status) {
+    close(ready[0]);
+    if (0 < pid) {
+      waitpid(pid, NULL, 0);
+    }
+    return -1;
+  }
+
+  close(ready[0]);
+  return pid;
+}
+
+void local_broker_stop(pid_t broker_pid) {
+  if (0 < broker_pid) {
+    kill(broker_pid, SIGTERM);
+    waitpid(broker_pid, NULL, 0);
+  }
+}
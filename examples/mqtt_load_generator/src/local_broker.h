@@ -0,0 +1,42 @@
+/* Copyright 2018-2020 Google LLC
+ *
+ * This is part of the Google Cloud IoT Device SDK for Embedded C.
+ * It is licensed under the BSD 3-Clause license; you may not use this file
+ * except in compliance with the License.
+ *
+ * You may obtain a copy of the License at:
+ *  https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __LOCAL_BROKER_H__
+#define __LOCAL_BROKER_H__
+
+#include <stdint.h>
+#include <sys/types.h>
+
+/*
+ * This module implements a stand-in for an MQTT broker on the loopback
+ * interface. It accepts any number of clients and answers CONNECT, SUBSCRIBE,
+ * UNSUBSCRIBE, QoS 1 PUBLISH and PINGREQ with the matching acknowledgements.
+ * Publishes are counted and dropped, nothing is routed to the subscribers.
+ *
+ * It answers the same packets as the MQTT broker mode of the SDK's echo
+ * server in src/tests/tools, which serves a single client on a thread of the
+ * benchmark process and can't stand in for thousands of devices.
+ */
+
+/* Forks a process that runs the broker on 127.0.0.1 at the given port, so its
+   CPU and memory usage stay out of the numbers of the calling process.
+   Returns the pid of the broker once it listens, or -1. */
+pid_t local_broker_start(uint16_t port);
+
+/* Stops the broker and waits for it to exit. */
+void local_broker_stop(pid_t broker_pid);
+
+#endif /* __LOCAL_BROKER_H__ */
@@ -0,0 +1,739 @@
+/* Copyright 2018-2020 Google LLC
+ *
+ * This is part of the Google Cloud IoT Device SDK for Embedded C.
+ * It is licensed under the BSD 3-Clause license; you may not use this file
+ * except in compliance with the License.
+ *
+ * You may obtain a copy of the License at:
+ *  https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * This example application simulates many devices from one process to size a
+ * broker or a gateway. Every device connects, subscribes to its commands topic
+ * and publishes to its events topic at a fixed rate. The application reports
+ * the connect rate, the publish throughput and latency, and its own memory
+ * and CPU usage.
+ *
+ * It connects to any MQTT broker without TLS, such as a broker container on
+ * the same machine, or to the stand-in broker it starts with --local_broker.
+ *
+ * Run the example with the flag --help for more information.
+ */
+
+#include <iotc.h>
+#include <iotc_error.h>
+
+#include <getopt.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+
+#include "load_stats.h"
+#include "local_broker.h"
+
+#define IOTC_UNUSED(x) (void)(x)
+
+/* How long the devices get to disconnect at the end of the run. */
+#define LOAD_GENERATOR_SHUTDOWN_GRACE_US (10 * 1000000ULL)
+
+/* Parameters set by commandline arguments. */
+typedef struct load_generator_options_s {
+  unsigned devices;
+  const char* host;
+  uint16_t port;
+  unsigned connect_rate;
+  unsigned publish_interval;
+  unsigned publishes_per_interval;
+  size_t payload_size;
+  iotc_mqtt_qos_t qos;
+  unsigned duration;
+  unsigned report_interval;
+  uint16_t keepalive;
+  unsigned shards;
+  int local_broker;
+} load_generator_options_t;
+
+typedef struct load_device_s {
+  iotc_context_handle_t context;
+  char client_id[32];
+  char events_topic[64];
+  char commands_topic[64];
+  iotc_timed_task_handle_t publish_task;
+  uint64_t connect_started_us;
+} load_device_t;
+
+/* The counters of the run. The callbacks of the devices run on the event
+   loop shards, so they update the counters under the mutex. */
+typedef struct load_generator_stats_s {
+  pthread_mutex_t mutex;
+  /* set once the run ends, the devices don't reconnect anymore */
+  int stopping;
+  unsigned connected;
+  uint64_t all_connected_us;
+  uint64_t connects;
+  uint64_t connect_failures;
+  uint64_t disconnects;
+  uint64_t publishes_sent;
+  uint64_t publishes_completed;
+  uint64_t publish_failures;
+  uint64_t messages_received;
+  load_stats_histogram_t connect_latency;
+  /* since the last report */
+  load_stats_histogram_t publish_latency;
+} load_generator_stats_t;
+
+/* What the previous report was computed from. */
+typedef struct load_generator_report_s {
+  uint64_t at_us;
+  uint64_t connects;
+  uint64_t publishes_completed;
+  double cpu_seconds;
+} load_generator_report_t;
+
+static load_generator_options_t options = {
+    .devices = 100,
+    .host = "127.0.0.1",
+    .port = 1883,
+    .connect_rate = 100,
+    .publish_interval = 1,
+    .publishes_per_interval = 1,
+    .payload_size = 64,
+    .qos = IOTC_MQTT_QOS_AT_LEAST_ONCE,
+    .duration = 30,
+    .report_interval = 5,
+    .keepalive = 60,
+    .shards = 0,
+    .local_broker = 0};
+
+static load_generator_stats_t stats = {.mutex = PTHREAD_MUTEX_INITIALIZER};
+static load_stats_histogram_t publish_latency_total;
+static load_generator_report_t last_report;
+
+static load_device_t* devices = NULL;
+static unsigned devices_started = 0;
+static uint8_t* payload = NULL;
+
+static uint64_t run_started_us = 0;
+static uint64_t stop_started_us = 0;
+static volatile sig_atomic_t interrupted = 0;
+
+static void on_device_connection_state_changed(
+    iotc_context_handle_t in_context_handle, void* data, iotc_state_t state);
+
+static void load_generator_usage(void) {
+  printf(
+      "Usage:\n"
+      "-n --devices\n\tThe number of simulated devices. Defaults to %u.\n"
+      "-H --host\n\tThe host of the MQTT broker. Defaults to %s.\n"
+      "-p --port\n\tThe port of the MQTT broker. Defaults to %u.\n"
+      "-c --connect_rate\n\tThe devices connecting per second, 0 connects "
+      "them all at once.\n\tDefaults to %u.\n"
+      "-i --publish_interval\n\tThe seconds between two publishes of a "
+      "device. Defaults to %u.\n"
+      "-b --publishes_per_interval\n\tThe messages a device publishes at "
+      "once. Defaults to %u.\n"
+      "-s --payload_size\n\tThe size of the messages in bytes. Defaults to "
+      "%lu.\n"
+      "-q --qos\n\tThe QoS of the publishes, 0 or 1. Defaults to %d.\n"
+      "-t --duration\n\tThe seconds to run for. Defaults to %u.\n"
+      "-r --report_interval\n\tThe seconds between two reports. Defaults to "
+      "%u.\n"
+      "-k --keepalive\n\tThe MQTT keepalive in seconds. Defaults to %u.\n"
+      "-j --shards\n\tThe event processing threads running the devices, see "
+      "iotc_start_event_loop_shards.\n\tRequires the threading CONFIG flag. "
+      "Defaults to none.\n"
+      "-l --local_broker\n\tStarts the stand-in broker of this example on "
+      "127.0.0.1 at the port\n\tof --port, in a process of its own.\n\n",
+      options.devices, options.host, options.port, options.connect_rate,
+      options.publish_interval, options.publishes_per_interval,
+      (unsigned long)options.payload_size, options.qos, options.duration,
+      options.report_interval, options.keepalive);
+}
+
+static int load_generator_parse(int argc, char** argv) {
+  static struct option long_options[] = {
+      {"help", no_argument, 0, 'h'},
+      {"devices", required_argument, 0, 'n'},
+      {"host", required_argument, 0, 'H'},
+      {"port", required_argument, 0, 'p'},
+      {"connect_rate", required_argument, 0, 'c'},
+      {"publish_interval", required_argument, 0, 'i'},
+      {"publishes_per_interval", required_argument, 0, 'b'},
+      {"payload_size", required_argument, 0, 's'},
+      {"qos", required_argument, 0, 'q'},
+      {"duration", required_argument, 0, 't'},
+      {"report_interval", required_argument, 0, 'r'},
+      {"keepalive", required_argument, 0, 'k'},
+      {"shards", required_argument, 0, 'j'},
+      {"local_broker", no_argument, 0, 'l'},
+      {0, 0, 0, 0}};
+
+  for (;;) {
+    /* getopt_long stores the option index here. */
+    int option_index = 0;
+    const int c = getopt_long(argc, argv, "hn:H:p:c:i:b:s:q:t:r:k:j:l",
+                              long_options, &option_index);
+
+    /* Detect the end of the options. */
+    if (-1 == c) {
+      break;
+    }
+
+    switch (c) {
+      case 'n':
+        options.devices = strtoul(optarg, NULL, 10);
+        break;
+      case 'H':
+        options.host = optarg;
+        break;
+      case 'p':
+        options.port = (uint16_t)strtoul(optarg, NULL, 10);
+        break;
+      case 'c':
+        options.connect_rate = strtoul(optarg, NULL, 10);
+        break;
+      case 'i':
+        options.publish_interval = strtoul(optarg, NULL, 10);
+        break;
+      case 'b':
+        options.publishes_per_interval = strtoul(optarg, NULL, 10);
+        break;
+      case 's':
+        options.payload_size = strtoul(optarg, NULL, 10);
+        break;
+      case 'q':
+        options.qos = (iotc_mqtt_qos_t)strtoul(optarg, NULL, 10);
+        break;
+      case 't':
+        options.duration = strtoul(optarg, NULL, 10);
+        break;
+      case 'r':
+        options.report_interval = strtoul(optarg, NULL, 10);
+        break;
+      case 'k':
+        options.keepalive = (uint16_t)strtoul(optarg, NULL, 10);
+        break;
+      case 'j':
+        options.shards = strtoul(optarg, NULL, 10);
+        break;
+      case 'l':
+        options.local_broker = 1;
+        break;
+      case 'h':
+      default:
+        load_generator_usage();
+        return -1;
+    }
+  }
+
+  if (0 == options.devices || 0 == options.port ||
+      0 == options.publish_interval || 0 == options.report_interval ||
+      IOTC_MQTT_QOS_AT_LEAST_ONCE < options.qos) {
+    printf("Invalid arguments, see --help.\n");
+    return -1;
+  }
+
+  return 0;
+}
+
+/* Every connection needs a descriptor, ask for as many as allowed. */
+static void load_generator_raise_descriptor_limit(void) {
+  struct rlimit limit;
+  if (0 != getrlimit(RLIMIT_NOFILE, &limit)) {
+    return;
+  }
+
+  limit.rlim_cur = limit.rlim_max;
+  setrlimit(RLIMIT_NOFILE, &limit);
+
+  if (limit.rlim_cur < options.devices + 64) {
+    printf(
+        "WARNING: only %lu file descriptors are available for %u devices, "
+        "raise the hard limit with ulimit -Hn.\n",
+        (unsigned long)limit.rlim_cur, options.devices);
+  }
+}
+
+static int compare_devices(const void* a, const void* b) {
+  const iotc_context_handle_t context_a = ((const load_device_t*)a)->context;
+  const iotc_context_handle_t context_b = ((const load_device_t*)b)->context;
+
+  return context_a < context_b ? -1 : (context_a > context_b ? 1 : 0);
+}
+
+/* The connection callbacks only get the context, so the devices are sorted
+   by context and looked up with a binary search. */
+static load_device_t* find_device(iotc_context_handle_t context) {
+  load_device_t key;
+  key.context = context;
+
+  return bsearch(&key, devices, options.devices, sizeof(load_device_t),
+                 &compare_devices);
+}
+
+static void connect_device(load_device_t* device) {
+  device->connect_started_us = load_stats_now_us();
+
+  const iotc_state_t state = iotc_connect_to(
+      device->context, options.host, options.port,
+      /*username=*/"load", /*password=*/"load", device->client_id,
+      /*connection_timeout=*/10, options.keepalive,
+      &on_device_connection_state_changed);
+
+  if (IOTC_STATE_OK != state) {
+    printf("%s failed to start connecting, error: %d\n", device->client_id,
+           state);
+
+    pthread_mutex_lock(&stats.mutex);
+    ++stats.connect_failures;
+    pthread_mutex_unlock(&stats.mutex);
+  }
+}
+
+static void on_publish_completed(iotc_context_handle_t in_context_handle,
+                                 void* data, iotc_state_t state) {
+  IOTC_UNUSED(in_context_handle);
+
+  /* the time the message was published at */
+  uint64_t* published_us = (uint64_t*)data;
+  const uint64_t latency_us = load_stats_now_us() - *published_us;
+  free(published_us);
+
+  pthread_mutex_lock(&stats.mutex);
+  if (IOTC_STATE_OK == state) {
+    ++stats.publishes_completed;
+    load_stats_histogram_record(&stats.publish_latency, latency_us);
+  } else {
+    ++stats.publish_failures;
+  }
+  pthread_mutex_unlock(&stats.mutex);
+}
+
+static void publish_function(iotc_context_handle_t context_handle,
+                             iotc_timed_task_handle_t timed_task,
+                             void* user_data) {
+  IOTC_UNUSED(timed_task);
+
+  load_device_t* device = (load_device_t*)user_data;
+  uint64_t sent = 0;
+  uint64_t failed = 0;
+
+  unsigned i = 0;
+  for (; i < options.publishes_per_interval; ++i) {
+    uint64_t* published_us = malloc(sizeof(uint64_t));
+    if (NULL == published_us) {
+      ++failed;
+      continue;
+    }
+
+    *published_us = load_stats_now_us();
+
+    const iotc_state_t state = iotc_publish_data(
+        context_handle, device->events_topic, payload, options.payload_size,
+        options.qos, &on_publish_completed, published_us);
+
+    if (IOTC_STATE_OK == state) {
+      ++sent;
+    } else {
+      free(published_us);
+      ++failed;
+    }
+  }
+
+  pthread_mutex_lock(&stats.mutex);
+  stats.publishes_sent += sent;
+  stats.publish_failures += failed;
+  pthread_mutex_unlock(&stats.mutex);
+}
+
+static void on_command(iotc_context_handle_t in_context_handle,
+                       iotc_sub_call_type_t call_type,
+                       const iotc_sub_call_params_t* const params,
+                       iotc_state_t state, void* user_data) {
+  IOTC_UNUSED(in_context_handle);
+  IOTC_UNUSED(params);
+  IOTC_UNUSED(state);
+  IOTC_UNUSED(user_data);
+
+  if (IOTC_SUB_CALL_MESSAGE == call_type) {
+    pthread_mutex_lock(&stats.mutex);
+    ++stats.messages_received;
+    pthread_mutex_unlock(&stats.mutex);
+  }
+}
+
+/* The library caps the number of timed tasks, tell once that a device
+   doesn't publish. */
+static void report_task_failure(iotc_state_t state) {
+  static int reported = 0;
+
+  pthread_mutex_lock(&stats.mutex);
+  const int report = !reported;
+  reported = 1;
+  pthread_mutex_unlock(&stats.mutex);
+
+  if (report) {
+    printf(
+        "WARNING: a device can't schedule its publishes, error: %d. Build "
+        "the library with\nIOTC_MAX_TIMED_EVENT=<devices>, see "
+        "doc/porting_guide.md.\n",
+        state);
+  }
+}
+
+static void on_device_connection_state_changed(
+    iotc_context_handle_t in_context_handle, void* data, iotc_state_t state) {
+  IOTC_UNUSED(state);
+
+  iotc_connection_data_t* conn_data = (iotc_connection_data_t*)data;
+  load_device_t* device = find_device(in_context_handle);
+
+  if (NULL == device) {
+    return;
+  }
+
+  switch (conn_data->connection_state) {
+    case IOTC_CONNECTION_STATE_OPENED: {
+      const uint64_t latency_us =
+          load_stats_now_us() - device->connect_started_us;
+
+      pthread_mutex_lock(&stats.mutex);
+      ++stats.connected;
+      ++stats.connects;
+      load_stats_histogram_record(&stats.connect_latency, latency_us);
+      if (0 == stats.all_connected_us && options.devices == stats.connected) {
+        stats.all_connected_us = load_stats_now_us();
+      }
+      const int stopping = stats.stopping;
+      pthread_mutex_unlock(&stats.mutex);
+
+      /* connected after the end of the run */
+      if (stopping) {
+        iotc_shutdown_connection(in_context_handle);
+        break;
+      }
+
+      iotc_subscribe(in_context_handle, device->commands_topic,
+                     IOTC_MQTT_QOS_AT_LEAST_ONCE, &on_command, device);
+
+      /* the devices connected in the same second publish together */
+      device->publish_task = iotc_schedule_timed_task(
+          in_context_handle, &publish_function, options.publish_interval,
+          /*repeats_forever=*/1, device);
+
+      if (IOTC_INVALID_TIMED_TASK_HANDLE >= device->publish_task) {
+        report_task_failure(-device->publish_task);
+        device->publish_task = IOTC_INVALID_TIMED_TASK_HANDLE;
+      }
+    } break;
+
+    case IOTC_CONNECTION_STATE_OPEN_FAILED: {
+      pthread_mutex_lock(&stats.mutex);
+      ++stats.connect_failures;
+      const int stopping = stats.stopping;
+      pthread_mutex_unlock(&stats.mutex);
+
+      if (!stopping) {
+        connect_device(device);
+      }
+    } break;
+
+    case IOTC_CONNECTION_STATE_CLOSED: {
+      if (IOTC_INVALID_TIMED_TASK_HANDLE != device->publish_task) {
+        iotc_cancel_timed_task(device->publish_task);
+        device->publish_task = IOTC_INVALID_TIMED_TASK_HANDLE;
+      }
+
+      pthread_mutex_lock(&stats.mutex);
+      --stats.connected;
+      const int stopping = stats.stopping;
+      if (!stopping) {
+        ++stats.disconnects;
+      }
+      pthread_mutex_unlock(&stats.mutex);
+
+      if (!stopping) {
+        connect_device(device);
+      }
+    } break;
+
+    default:
+      break;
+  }
+}
+
+static void print_latencies(const char* name,
+                            const load_stats_histogram_t* histogram) {
+  printf("%s ms p50 %.2f p90 %.2f p99 %.2f max %.2f", name,
+         load_stats_histogram_percentile(histogram, 50) / 1000.0,
+         load_stats_histogram_percentile(histogram, 90) / 1000.0,
+         load_stats_histogram_percentile(histogram, 99) / 1000.0,
+         histogram->max / 1000.0);
+}
+
+static void report(uint64_t now_us) {
+  load_stats_usage_t usage;
+  load_stats_get_usage(&usage);
+
+  pthread_mutex_lock(&stats.mutex);
+  const unsigned connected = stats.connected;
+  const uint64_t connects = stats.connects;
+  const uint64_t publishes_completed = stats.publishes_completed;
+  const load_stats_histogram_t publish_latency = stats.publish_latency;
+  memset(&stats.publish_latency, 0, sizeof(stats.publish_latency));
+  pthread_mutex_unlock(&stats.mutex);
+
+  load_stats_histogram_merge(&publish_latency_total, &publish_latency);
+
+  const double seconds = (now_us - last_report.at_us) / 1000000.0;
+
+  printf("[%4lus] connected %u/%u  connects/s %.1f  publishes/s %.1f  ",
+         (unsigned long)((now_us - run_started_us) / 1000000), connected,
+         options.devices, (connects - last_report.connects) / seconds,
+         (publishes_completed - last_report.publishes_completed) / seconds);
+  print_latencies("latency", &publish_latency);
+  printf("  rss %.1f MB  cpu %.1f%%\n", usage.rss_kb / 1024.0,
+         100.0 * (usage.cpu_seconds - last_report.cpu_seconds) / seconds);
+  fflush(stdout);
+
+  last_report.at_us = now_us;
+  last_report.connects = connects;
+  last_report.publishes_completed = publishes_completed;
+  last_report.cpu_seconds = usage.cpu_seconds;
+}
+
+static void print_summary(uint64_t stopped_us) {
+  load_stats_usage_t usage;
+  load_stats_get_usage(&usage);
+
+  const double seconds = (stop_started_us - run_started_us) / 1000000.0;
+
+  printf("\nSummary of %u devices over %.1f s:\n", options.devices, seconds);
+
+  if (0 != stats.all_connected_us) {
+    const double ramp_seconds =
+        (stats.all_connected_us - run_started_us) / 1000000.0;
+    printf("  all devices connected after %.2f s, %.1f connects/s\n",
+           ramp_seconds, options.devices / ramp_seconds);
+  }
+
+  printf("  connects %llu, failed %llu, disconnects %llu\n  ",
+         (unsigned long long)stats.connects,
+         (unsigned long long)stats.connect_failures,
+         (unsigned long long)stats.disconnects);
+  print_latencies("connect latency", &stats.connect_latency);
+
+  printf(
+      "\n  publishes sent %llu, completed %llu, failed %llu, %.1f/s\n"
+      "  messages received %llu\n  ",
+      (unsigned long long)stats.publishes_sent,
+      (unsigned long long)stats.publishes_completed,
+      (unsigned long long)stats.publish_failures,
+      stats.publishes_completed / seconds,
+      (unsigned long long)stats.messages_received);
+  print_latencies("publish latency", &publish_latency_total);
+
+  printf(
+      "\n  peak rss %.1f MB, %.1f KB per device\n"
+      "  cpu %.2f s, %.1f%% of one core\n",
+      usage.max_rss_kb / 1024.0, (double)usage.max_rss_kb / options.devices,
+      usage.cpu_seconds,
+      100.0 * usage.cpu_seconds / ((stopped_us - run_started_us) / 1e6));
+}
+
+/* Ramps the connects up, reports and ends the run, once per second on the
+   main event engine. */
+static void control_function(iotc_context_handle_t context_handle,
+                             iotc_timed_task_handle_t timed_task,
+                             void* user_data) {
+  IOTC_UNUSED(context_handle);
+  IOTC_UNUSED(timed_task);
+  IOTC_UNUSED(user_data);
+
+  const uint64_t now_us = load_stats_now_us();
+
+  if (0 == stop_started_us) {
+    const unsigned batch =
+        0 == options.connect_rate ? options.devices : options.connect_rate;
+
+    unsigned i = 0;
+    for (; i < batch && devices_started < options.devices; ++i) {
+      connect_device(&devices[devices_started++]);
+    }
+  }
+
+  pthread_mutex_lock(&stats.mutex);
+  const unsigned connected = stats.connected;
+  pthread_mutex_unlock(&stats.mutex);
+
+  if (now_us - last_report.at_us >= options.report_interval * 1000000ULL) {
+    report(now_us);
+  }
+
+  if (0 == stop_started_us &&
+      (0 != interrupted ||
+       now_us - run_started_us >= options.duration * 1000000ULL)) {
+    stop_started_us = now_us;
+
+    pthread_mutex_lock(&stats.mutex);
+    stats.stopping = 1;
+    pthread_mutex_unlock(&stats.mutex);
+
+    if (last_report.at_us != now_us) {
+      report(now_us);
+    }
+
+    unsigned device_id = 0;
+    for (; device_id < options.devices; ++device_id) {
+      iotc_shutdown_connection(devices[device_id].context);
+    }
+  } else if (0 != stop_started_us &&
+             (0 == connected ||
+              now_us - stop_started_us >= LOAD_GENERATOR_SHUTDOWN_GRACE_US)) {
+    iotc_events_stop();
+  }
+}
+
+static void on_interrupt(int signal_number) {
+  IOTC_UNUSED(signal_number);
+  interrupted = 1;
+}
+
+int main(int argc, char* argv[]) {
+  /* log the executable name and library version */
+  printf("\n%s\n%s\n", argv[0], iotc_cilent_version_str);
+
+  if (0 != load_generator_parse(argc, argv)) {
+    return -1;
+  }
+
+  load_generator_raise_descriptor_limit();
+
+  /* Fork the broker before the library starts any thread. */
+  pid_t broker_pid = -1;
+  if (options.local_broker) {
+    broker_pid = local_broker_start(options.port);
+
+    if (0 > broker_pid) {
+      printf("Failed to start the local broker on port %u.\n", options.port);
+      return -1;
+    }
+  }
+
+  int result = -1;
+  iotc_context_handle_t control_context = IOTC_INVALID_CONTEXT_HANDLE;
+
+  devices = calloc(options.devices, sizeof(load_device_t));
+  payload = malloc(options.payload_size + 1);
+  if (NULL == devices || NULL == payload) {
+    printf("Out of memory.\n");
+    goto stop_broker;
+  }
+
+  memset(payload, 'x', options.payload_size);
+
+  const iotc_state_t error_init = iotc_initialize();
+  if (IOTC_STATE_OK != error_init) {
+    printf(" iotc failed to initialize, error: %d\n", error_init);
+    goto stop_broker;
+  }
+
+  /* The control task runs on the main event engine, so its context is
+     created before the shards start. */
+  control_context = iotc_create_context();
+  if (IOTC_INVALID_CONTEXT_HANDLE >= control_context) {
+    printf(" iotc failed to create context, error: %d\n", -control_context);
+    goto shutdown;
+  }
+
+  if (0 < options.shards) {
+    const iotc_state_t state = iotc_start_event_loop_shards(options.shards);
+    if (IOTC_STATE_OK != state) {
+      printf("Running without shards, iotc_start_event_loop_shards: %s\n",
+             iotc_get_state_string(state));
+    }
+  }
+
+  unsigned device_id = 0;
+  for (; device_id < options.devices; ++device_id) {
+    devices[device_id].context = iotc_create_context();
+    devices[device_id].publish_task = IOTC_INVALID_TIMED_TASK_HANDLE;
+
+    if (IOTC_INVALID_CONTEXT_HANDLE >= devices[device_id].context) {
+      printf(" iotc failed to create context %u, error: %d\n", device_id,
+             -devices[device_id].context);
+      if (IOTC_NO_MORE_RESOURCE_AVAILABLE == -devices[device_id].context) {
+        printf(
+            "Build the library with IOTC_MAX_NUM_CONTEXTS=<devices + 1>, see "
+            "doc/porting_guide.md.\n");
+      }
+      options.devices = device_id;
+      goto delete_contexts;
+    }
+  }
+
+  qsort(devices, options.devices, sizeof(load_device_t), &compare_devices);
+
+  for (device_id = 0; device_id < options.devices; ++device_id) {
+    load_device_t* device = &devices[device_id];
+
+    snprintf(device->client_id, sizeof(device->client_id), "load-%u",
+             device_id);
+    snprintf(device->events_topic, sizeof(device->events_topic),
+             "/devices/load-%u/events", device_id);
+    snprintf(device->commands_topic, sizeof(device->commands_topic),
+             "/devices/load-%u/commands/#", device_id);
+  }
+
+  struct sigaction action;
+  memset(&action, 0, sizeof(action));
+  action.sa_handler = &on_interrupt;
+  sigaction(SIGINT, &action, NULL);
+
+  printf("%u devices against %s:%u, %u connects/s, %u x %lu bytes QoS %d "
+         "every %u s, for %u s\n\n",
+         options.devices, options.host, options.port, options.connect_rate,
+         options.publishes_per_interval, (unsigned long)options.payload_size,
+         options.qos, options.publish_interval, options.duration);
+
+  run_started_us = load_stats_now_us();
+  last_report.at_us = run_started_us;
+
+  iotc_schedule_timed_task(control_context, &control_function,
+                           /*seconds_from_now=*/1, /*repeats_forever=*/1,
+                           NULL);
+  control_function(control_context, IOTC_INVALID_TIMED_TASK_HANDLE, NULL);
+
+  iotc_events_process_blocking();
+
+  print_summary(load_stats_now_us());
+  result = 0;
+
+delete_contexts:
+  for (device_id = 0; device_id < options.devices; ++device_id) {
+    iotc_delete_context(devices[device_id].context);
+  }
+
+  iotc_stop_event_loop_shards();
+  iotc_delete_context(control_context);
+
+shutdown:
+  iotc_shutdown();
+
+stop_broker:
+  local_broker_stop(broker_pid);
+  free(devices);
+  free(payload);
+
+  return result;
+}
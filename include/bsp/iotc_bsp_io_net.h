@@ -226,6 +226,43 @@ typedef struct iotc_bsp_socket_events_s {
   uint8_t out_socket_connect_finished : 1;
 } iotc_bsp_socket_events_t;
 
+/**
+ * @typedef iotc_bsp_socket_options_t
+ * @brief The tuning options of a socket.
+ * @see #iotc_bsp_socket_options_s
+ *
+ * @struct iotc_bsp_socket_options_s
+ * @brief The tuning options of a socket.
+ *
+ * @details A zero field keeps the platform default, so a zero-initialized
+ * structure changes nothing. BSPs skip the options their networking stack
+ * doesn't support.
+ */
+typedef struct iotc_bsp_socket_options_s {
+  /** <code>1</code> to send small segments right away (TCP_NODELAY),
+   * <code>0</code> to coalesce them. */
+  uint8_t tcp_nodelay;
+  /** <code>1</code> to send TCP keepalive probes on an idle connection
+   * (SO_KEEPALIVE). */
+  uint8_t tcp_keepalive;
+  /** The seconds of inactivity before the first keepalive probe. */
+  uint16_t tcp_keepalive_idle;
+  /** The seconds between two keepalive probes. */
+  uint16_t tcp_keepalive_interval;
+  /** The number of unanswered probes after which the connection is dropped. */
+  uint16_t tcp_keepalive_count;
+  /** The milliseconds that sent data may stay unacknowledged before the
+   * connection is dropped (TCP_USER_TIMEOUT). */
+  uint32_t tcp_user_timeout_ms;
+  /** The size, in bytes, of the kernel send buffer (SO_SNDBUF). */
+  uint32_t send_buffer_size;
+  /** The size, in bytes, of the kernel receive buffer (SO_RCVBUF). */
+  uint32_t receive_buffer_size;
+  /** The type of service byte of the outgoing packets (IP_TOS on IPv4,
+   * IPV6_TCLASS on IPv6), for example DSCP marking. */
+  uint8_t ip_tos;
+} iotc_bsp_socket_options_t;
+
 /**
  * @details Creates a socket and connects it to an endpoint.
  *
@@ -235,10 +272,14 @@ typedef struct iotc_bsp_socket_events_s {
  *     host at which to connect.
  * @param [in] port The port number of the endpoint.
  * @param [in] socket_type The {@link #iotc_bsp_socket_type_e socket protocol}.
+ * @param [in] socket_options The {@link #iotc_bsp_socket_options_s tuning
+ *     options} to set before connecting, <code>NULL</code> for the platform
+ *     defaults.
  */
 iotc_bsp_io_net_state_t iotc_bsp_io_net_socket_connect(
     iotc_bsp_socket_t* iotc_socket, const char* host, uint16_t port,
-    iotc_bsp_socket_type_t socket_type);
+    iotc_bsp_socket_type_t socket_type,
+    const iotc_bsp_socket_options_t* socket_options);
 
 /**
  * @brief Checks a {@link iotc_bsp_io_net_socket_connect() socket} for scheduled
@@ -21,6 +21,7 @@
 #include <stdlib.h>
 
 #include <iotc_connection_data.h>
+#include <iotc_gateway.h>
 #include <iotc_mqtt.h>
 #include <iotc_time.h>
 #include <iotc_types.h>
@@ -74,11 +75,23 @@ extern "C" {
  * | iotc_initialize() | Initializes the <a href="../../bsp/html/d8/dc3/iotc__bsp__time_8h.html">time</a> and <a href="../../bsp/html/d8/dc3/iotc__bsp__rng_8h.html">random number</a> libraries in the <a href="../../bsp/html/index.html">BSP</a>. | 
  * | iotc_shutdown() | Shuts down the SDK and frees all resources created during {@link iotc_initialize() initialization}. |
  * | iotc_get_heap_usage() | Gets the amount of heap memory allocated to the SDK. |
+ * | iotc_get_context_heap_usage() | Gets the amount of heap memory allocated on behalf of a context. |
  * | iotc_get_network_timeout() | Gets the {@link iotc_set_network_timeout() connection timeout}.
  * | iotc_get_state_string() | Gets the {@link ::iotc_state_t state message} associated with a numeric code. |
  * | iotc_set_fs_functions() | Sets the file operations to the <a href="../../bsp/html/d8/dc3/iotc__bsp__io__fs_8h.html">custom file management functions</a> in the <a href="../../bsp/html/index.html">BSP</a>. |
  * | iotc_set_maximum_heap_usage() | Sets the maximum heap memory that the SDK can use. |
+ * | iotc_set_context_maximum_heap_usage() | Sets the maximum heap memory that a single context can use. |
  * | iotc_set_network_timeout() | Sets the connection timeout. |
+ * | iotc_get_max_concurrent_connects() | Gets the {@link iotc_set_max_concurrent_connects() maximum number of simultaneous connects}. |
+ * | iotc_set_max_concurrent_connects() | Sets the maximum number of contexts that can connect simultaneously. |
+ * | iotc_set_dns_server() | Sets the DNS server that resolves the hosts without blocking the event loop. |
+ * | iotc_flush_dns_cache() | Drops the {@link iotc_set_dns_server() resolved hosts} shared by all contexts. |
+ * | iotc_export_layer_trace() | Writes the recorded layer transitions as Chrome trace event JSON. |
+ * | iotc_clear_layer_trace() | Drops the recorded layer transitions. |
+ * | iotc_set_debug_log_filter() | Selects the level and the modules of the binary debug log at runtime. |
+ * | iotc_drain_debug_log() | Formats the recorded binary debug log. |
+ * | iotc_dump_heap_profile() | Writes the allocation counters of every call site of the SDK. |
+ * | iotc_reset_heap_profile() | Starts a new heap profiling window. |
  *
  * ## Defining and managing connection contexts
  * | Function | Description |
@@ -86,6 +99,11 @@ extern "C" {
  * | iotc_create_context() | Creates a connection context. |
  * | iotc_delete_context() | Deletes and frees the provided context. |
  * | iotc_is_context_connected() | Checks if a context is {@link iotc_connect() connected to an MQTT broker}. | 
+ * | iotc_set_socket_options() | Sets the socket tuning options of the connections of a context. |
+ * | iotc_set_offline_queue() | Queues the publishes of a context while it is disconnected. |
+ * | iotc_set_session_store() | Keeps the MQTT session and the in-flight QoS 1 publishes of a context across connections. |
+ * | iotc_get_context_stats() | Gets the runtime statistics of a context. |
+ * | iotc_reset_context_stats() | Resets the runtime statistics of a context. |
  *
  * ## Creating and managing MQTT connections
  * | Function | Description |
@@ -102,6 +120,14 @@ extern "C" {
  * | iotc_publish_data() | Publishes binary data to an MQTT topic. | 
  * | iotc_subscribe() | Subscribes to an MQTT topic. |
  *
+ * ## Relaying messages of devices attached to a gateway
+ * | Function | Description |
+ * | --- | --- |
+ * | iotc_gateway_attach_device() | Attaches a device to the gateway's connection. |
+ * | iotc_gateway_detach_device() | Detaches a device from the gateway's connection. |
+ * | iotc_gateway_publish() | Publishes binary data on behalf of an attached device. |
+ * | iotc_gateway_subscribe() | Subscribes to a topic on behalf of an attached device. |
+ *
  * ## Scheduling functions
  * | Function | Description |
  * | --- | --- |
@@ -110,6 +136,8 @@ extern "C" {
  * | iotc_events_process_blocking() | Invokes the event processing loop and executes the event engine as the main application process. |
  * | iotc_events_process_tick() | Invokes the event processing loop on RTOS or non-OS devices that must yield for standard tick operations. |
  * | iotc_events_stop() | Shuts down the event engine. |
+ * | iotc_start_event_loop_shards() | Runs the connections of new contexts on several event processing threads. |
+ * | iotc_stop_event_loop_shards() | Shuts down the event processing threads. |
  *
  * # Board Support Package 
  * The SDK depends on hardware-specific drivers and routines to implement
@@ -183,6 +211,125 @@ extern iotc_state_t iotc_delete_context(iotc_context_handle_t context_handle);
  */
 extern uint8_t iotc_is_context_connected(iotc_context_handle_t context_handle);
 
+/**
+ * @brief Sets the socket tuning options of the connections of a context.
+ *
+ * @details The options are passed to the
+ * <a href="../../bsp/html/index.html">BSP</a> with the connection data and
+ * apply from the next iotc_connect() on. For example, TCP_NODELAY lowers the
+ * latency of small publishes and their acknowledgements, and TCP keepalive
+ * with a user timeout detects a dead broker long before the MQTT keepalive.
+ *
+ * @param [in] context_handle The context whose connections to tune.
+ * @param [in] socket_options The options, <code>NULL</code> for the platform
+ *     defaults.
+ *
+ * @retval IOTC_STATE_OK The options are stored.
+ * @retval IOTC_NULL_CONTEXT The context handle is invalid.
+ */
+extern iotc_state_t iotc_set_socket_options(
+    iotc_context_handle_t context_handle,
+    const iotc_bsp_socket_options_t* socket_options);
+
+/**
+ * @brief Queues the publishes of a context while it is disconnected.
+ *
+ * @details Without the queue, messages published while the context isn't
+ * connected or while the backoff is applied are dropped. With the queue they
+ * are kept, within the budget, and sent in order as soon as the broker
+ * accepts the next connection: all the QoS 1 messages at once, the QoS 0 ones
+ * back to back. The publish callbacks are invoked when the messages are
+ * actually delivered or dropped.
+ *
+ * If the configuration names a persistence resource, the messages still
+ * queued when the context is deleted are saved there with the
+ * <a href="../../bsp/html/index.html">BSP</a> file system functions, and this
+ * function restores them, without their callbacks. The queue is saved only
+ * when the context is deleted, not on every publish or delivery, so the
+ * messages queued when the application crashes or loses power are lost. A
+ * resource that can't be parsed is kept and none of its messages are queued.
+ *
+ * @param [in] context_handle The context whose publishes to queue.
+ * @param [in] config The budget and the drop policy. A
+ *     <code>max_messages</code> of <code>0</code> disables the queue.
+ *
+ * @retval IOTC_STATE_OK The queue is configured.
+ * @retval IOTC_NULL_CONTEXT The context handle is invalid.
+ * @retval IOTC_INVALID_PARAMETER The configuration is <code>NULL</code>.
+ * @retval IOTC_SERIALIZATION_ERROR The persistence resource is not a saved
+ *     queue or is truncated. The queue is configured, but empty.
+ */
+extern iotc_state_t iotc_set_offline_queue(
+    iotc_context_handle_t context_handle,
+    const iotc_offline_queue_config_t* config);
+
+/**
+ * @brief Keeps the MQTT session of a context across connections.
+ *
+ * @details With a session store the next iotc_connect() asks the broker to
+ * continue the previous session instead of starting a clean one. The QoS 1
+ * publishes that were sent but not acknowledged are retransmitted, flagged as
+ * duplicates, as soon as the broker accepts the connection.
+ *
+ * If the configuration names a log resource, every in-flight publish and its
+ * acknowledgement is appended to it with the
+ * <a href="../../bsp/html/index.html">BSP</a> file system functions. The
+ * records are written once per event loop iteration, the log is never
+ * synced from the event loop. This function replays the log, so the
+ * publishes of a previous run of the application are retransmitted, without
+ * their callbacks, after the next connection.
+ *
+ * Call it before iotc_connect().
+ *
+ * @param [in] context_handle The context whose session to keep.
+ * @param [in] config Where to keep the session, <code>NULL</code> goes back
+ *     to clean sessions.
+ *
+ * @retval IOTC_STATE_OK The session store is configured.
+ * @retval IOTC_NULL_CONTEXT The context handle is invalid.
+ */
+extern iotc_state_t iotc_set_session_store(
+    iotc_context_handle_t context_handle,
+    const iotc_session_store_config_t* config);
+
+/**
+ * @brief Gets the runtime statistics of a context.
+ *
+ * @details The counters are kept by the network, TLS and MQTT layers of the
+ * context: the bytes and messages that went in and out, the QoS 1
+ * retransmissions and PUBACK timeouts, the keepalive round trip time and the
+ * connections. The queue depths are taken at the time of the call.
+ *
+ * The statistics are updated on the thread that processes the events of the
+ * context. Called from another thread, the values may be slightly behind.
+ *
+ * This function requires the SDK built without the
+ * <code>no_context_stats</code> flag in the
+ * <a href="../../../porting_guide.md#config">CONFIG</a> argument, otherwise it
+ * returns IOTC_NOT_SUPPORTED.
+ *
+ * @param [in] context_handle The context to query.
+ * @param [out] stats The statistics.
+ *
+ * @retval IOTC_STATE_OK The statistics are filled in.
+ * @retval IOTC_NULL_CONTEXT The context handle is invalid.
+ * @retval IOTC_INVALID_PARAMETER The stats pointer is <code>NULL</code>.
+ * @retval IOTC_NOT_SUPPORTED The statistics are compiled out.
+ */
+extern iotc_state_t iotc_get_context_stats(iotc_context_handle_t context_handle,
+                                           iotc_context_stats_t* stats);
+
+/**
+ * @brief Sets all the {@link iotc_get_context_stats() statistics} of a
+ * context back to zero.
+ *
+ * @retval IOTC_STATE_OK The statistics are reset.
+ * @retval IOTC_NULL_CONTEXT The context handle is invalid.
+ * @retval IOTC_NOT_SUPPORTED The statistics are compiled out.
+ */
+extern iotc_state_t iotc_reset_context_stats(
+    iotc_context_handle_t context_handle);
+
 /**
  * @details Invokes the event processing loop and executes event engine
  * as the main application process. This function processes events on platforms
@@ -219,6 +366,37 @@ extern iotc_state_t iotc_events_process_tick();
  */
 extern void iotc_events_stop();
 
+/**
+ * @details Starts <code>num_shards</code> event processing threads, each
+ * with its own event engine. Contexts created afterwards are assigned to the
+ * thread with the fewest contexts, and their connections, callbacks and
+ * {@link iotc_schedule_timed_task() timed tasks} run on that thread. Contexts
+ * created before this call stay on the main event engine.
+ *
+ * The client application must still run iotc_events_process_blocking() or
+ * iotc_events_process_tick(); the main event engine processes the tasks that
+ * all the contexts share, such as the connection backoff.
+ *
+ * This function requires the <code>threading</code> flag in the
+ * <a href="../../../porting_guide.md#config">CONFIG</a> argument, otherwise it
+ * returns IOTC_NOT_SUPPORTED.
+ *
+ * @param [in] num_shards The number of threads, from <code>1</code> to
+ *     <code>IOTC_EVENT_LOOP_MAX_SHARDS</code>.
+ *
+ * @retval IOTC_STATE_OK The threads are running.
+ * @retval IOTC_ALREADY_INITIALIZED The threads are already running.
+ */
+extern iotc_state_t iotc_start_event_loop_shards(const uint8_t num_shards);
+
+/**
+ * @details Stops and joins the threads that
+ * iotc_start_event_loop_shards() started.
+ * {@link iotc_delete_context() Delete} the contexts assigned to the threads
+ * first, otherwise this function returns IOTC_INVALID_PARAMETER.
+ */
+extern iotc_state_t iotc_stop_event_loop_shards();
+
 /**
  * @brief Connects to Cloud IoT Core.
  *
@@ -239,7 +417,10 @@ extern void iotc_events_stop();
  *     number of seconds</a> the broker will wait for the client application to
  *     send a <code>PINGREQ</code> message. The <code>PINGREQ</code> is
  *     automatically sent at the specified interval, so you don't need to write
- *     the <code>PINGREQ</code> message contents.
+ *     the <code>PINGREQ</code> message contents. It is also the longest time
+ *     the client waits for a <code>PINGRESP</code> or a QoS 1
+ *     <code>PUBACK</code>; once round trip times were measured, the wait
+ *     follows them, see iotc_get_context_stats().
  * @param [in] (Optional) client_callback The callback function. Invoked when
  *     the client connects to or is disconnected from the MQTT broker. 
  */
@@ -350,6 +531,10 @@ extern iotc_state_t iotc_subscribe(iotc_context_handle_t iotc_h,
  * @details After disconnecting, the disconnection status code is passed to the
  * iotc_connect() callback. You may reuse disconnected contexts until
  * iotc_events_stop() returns; you don't need to destroy and recreate contexts.
+ * A connect still waiting for {@link iotc_set_max_concurrent_connects()
+ * admission} is dropped from the queue and the callback gets
+ * <code>IOTC_CONNECTION_STATE_OPEN_FAILED</code> with
+ * <code>IOTC_CONNECTION_CANCELLED_ERROR</code>.
  *
  * @param [in] iotc_h A {@link iotc_create_context() context handle}.
  */
@@ -411,6 +596,54 @@ extern void iotc_set_network_timeout(uint32_t timeout);
  */
 extern uint32_t iotc_get_network_timeout(void);
 
+/**
+ * @brief Sets the maximum number of contexts that can connect simultaneously.
+ *
+ * @details When many contexts connect at the same time, for example after
+ * the network comes back, only this number of them resolve the host, open a
+ * socket and do the TLS and MQTT handshakes at once. The other contexts wait
+ * in the order iotc_connect() was called for them. A context whose previous
+ * connection was lost on an error additionally waits a random jitter before
+ * it reconnects.
+ *
+ * @param [in] max_concurrent_connects The maximum number of simultaneous
+ *     connects. If <code>0</code>, there's no limit.
+ */
+extern void iotc_set_max_concurrent_connects(uint16_t max_concurrent_connects);
+
+/**
+ * @brief Gets the
+ * {@link iotc_set_max_concurrent_connects() maximum number of simultaneous
+ * connects}.
+ */
+extern uint16_t iotc_get_max_concurrent_connects(void);
+
+/**
+ * @brief Sets the DNS server that resolves the hosts of the connections.
+ *
+ * @details By default the <a href="../../bsp/html/index.html">BSP</a>
+ * resolves the host when it opens the socket, which blocks the event loop on
+ * the POSIX BSP. With a DNS server set, the SDK sends the queries to it over
+ * UDP and waits for the answer on the event loop instead. The addresses are
+ * cached for all contexts for as long as their TTL allows, and hosts that
+ * don't exist are cached as well for the negative caching TTL of their zone.
+ *
+ * @param [in] address The numeric IPv4 or IPv6 address of a recursive DNS
+ *     server. If <code>NULL</code>, the BSP resolves the hosts again.
+ * @param [in] port The port of the DNS server, usually <code>53</code>.
+ *
+ * @retval IOTC_STATE_OK The server is set and the cache is flushed.
+ * @retval IOTC_INVALID_PARAMETER The address isn't a numeric address or the
+ *     port is <code>0</code>.
+ */
+extern iotc_state_t iotc_set_dns_server(const char* address, uint16_t port);
+
+/**
+ * @brief Drops all the hosts resolved by the
+ * {@link iotc_set_dns_server() DNS server}, the next connects query it again.
+ */
+extern void iotc_flush_dns_cache(void);
+
 /**
  * @details Sets the maximum heap memory that the SDK can use.
  *
@@ -432,6 +665,127 @@ iotc_state_t iotc_set_maximum_heap_usage(const size_t max_bytes);
  */
 iotc_state_t iotc_get_heap_usage(size_t* const heap_usage);
 
+/**
+ * @details Sets the maximum heap memory that a single context can use.
+ *
+ * This function is part of the
+ * <a href="../../../user_guide.md#memory-accounting">memory accounting</a>.
+ * Allocations that would exceed the budget fail with IOTC_OUT_OF_MEMORY, so
+ * one misbehaving context can't starve the other contexts.
+ *
+ * Every context gets its own accounting slot, up to the
+ * <code>IOTC_MAX_NUM_CONTEXTS</code> contexts the SDK is built for, so the
+ * budget can be set for any context iotc_create_context() returned. Returns
+ * IOTC_INVALID_PARAMETER for a handle that isn't a live context.
+ *
+ * @param [in] context_handle The context to which the budget applies.
+ * @param [in] max_bytes The maximum amount of heap memory, in bytes, that
+ *     the context can use. <code>0</code> removes the budget.
+ */
+iotc_state_t iotc_set_context_maximum_heap_usage(
+    iotc_context_handle_t context_handle, const size_t max_bytes);
+
+/**
+ * @details Gets the amount of heap memory allocated on behalf of a context.
+ *
+ * This function is part of the
+ * <a href="../../../user_guide.md#memory-accounting">memory accounting</a>.
+ *
+ * @param [in] context_handle The context to query.
+ * @param [out] heap_usage The number of bytes currently allocated.
+ */
+iotc_state_t iotc_get_context_heap_usage(iotc_context_handle_t context_handle,
+                                         size_t* const heap_usage);
+
+/**
+ * @details Writes the recorded layer transitions as Chrome trace event JSON.
+ *
+ * This function is part of the
+ * <a href="../../../user_guide.md#layer-tracing">layer tracing</a>. Every
+ * context is a process and every layer a thread of the trace. The time a
+ * message spends in a layer shows as a slice, the time it waits in the event
+ * queue between two layers as an arrow. Load the output in chrome://tracing or
+ * Perfetto.
+ *
+ * @param [in] writer Called with the consecutive chunks of the document.
+ * @param [in] user_data Passed to the writer.
+ */
+iotc_state_t iotc_export_layer_trace(iotc_layer_trace_writer_t* writer,
+                                     void* user_data);
+
+/**
+ * @details Drops the recorded layer transitions.
+ *
+ * This function is part of the
+ * <a href="../../../user_guide.md#layer-tracing">layer tracing</a>. Call it
+ * while no context is processing events.
+ */
+iotc_state_t iotc_clear_layer_trace(void);
+
+/**
+ * @details Selects the statements recorded by the binary debug log.
+ *
+ * This function is part of the
+ * <a href="../../../user_guide.md#binary-debug-log">binary debug log</a>.
+ * Filtered out statements cost a comparison, so the log can stay compiled in
+ * and be turned on in the field when needed. By default, everything up to
+ * IOTC_DEBUG_LOG_LEVEL_DEBUG is recorded.
+ *
+ * @param [in] max_level The most detailed level recorded,
+ *     IOTC_DEBUG_LOG_LEVEL_NONE turns the log off.
+ * @param [in] modules The {@link ::iotc_debug_log_module_t modules} recorded,
+ *     ORed together.
+ */
+iotc_state_t iotc_set_debug_log_filter(const iotc_debug_log_level_t max_level,
+                                       const uint32_t modules);
+
+/**
+ * @details Formats the recorded binary debug log.
+ *
+ * This function is part of the
+ * <a href="../../../user_guide.md#binary-debug-log">binary debug log</a>.
+ * The statements are recorded in the ring of the thread that runs them, as a
+ * reference to the format string and the raw arguments. This function turns
+ * the pending records of all the threads into text, oldest first, so the
+ * formatting cost moves off the event loop. Call it periodically from a low
+ * priority thread, concurrent calls wait for each other.
+ *
+ * @param [in] writer Called with the consecutive pieces of the log.
+ * @param [in] user_data Passed to the writer.
+ */
+iotc_state_t iotc_drain_debug_log(iotc_debug_log_writer_t* writer,
+                                  void* user_data);
+
+/**
+ * @details Writes the allocation counters of every call site of the SDK.
+ *
+ * This function is part of the
+ * <a href="../../../user_guide.md#heap-profiler">heap profiler</a>. For each
+ * iotc_alloc call site, the profile has the number of allocations and frees,
+ * the live and the peak bytes and a histogram of the allocation sizes. The
+ * CSV format has one line per site. The pprof format is the legacy text heap
+ * profile, followed by the memory map of the process so pprof can symbolize
+ * the sites.
+ *
+ * @param [in] format The {@link ::iotc_heap_profile_format_t format} of the
+ *     profile.
+ * @param [in] writer Called with the consecutive pieces of the profile.
+ * @param [in] user_data Passed to the writer.
+ */
+iotc_state_t iotc_dump_heap_profile(const iotc_heap_profile_format_t format,
+                                    iotc_heap_profile_writer_t* writer,
+                                    void* user_data);
+
+/**
+ * @details Starts a new heap profiling window.
+ *
+ * This function is part of the
+ * <a href="../../../user_guide.md#heap-profiler">heap profiler</a>. The
+ * allocation counts, the sizes and the histograms restart from the allocations
+ * still alive, so a profile taken later shows what happened in between.
+ */
+iotc_state_t iotc_reset_heap_profile(void);
+
 /**
  * @brief The SDK major version number.
  **/
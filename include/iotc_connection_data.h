@@ -17,6 +17,7 @@
 #ifndef __IOTC_CONNECTION_DATA_H__
 #define __IOTC_CONNECTION_DATA_H__
 
+#include <iotc_bsp_io_net.h>
 #include <iotc_mqtt.h>
 #include "iotc_types.h"
 
@@ -98,6 +99,8 @@ typedef struct iotc_connection_data_s {
   iotc_mqtt_qos_t will_qos;
   /** Unused. */
   iotc_mqtt_retain_t will_retain;
+  /** The {@link iotc_set_socket_options() socket tuning options}. */
+  iotc_bsp_socket_options_t socket_options;
 } iotc_connection_data_t;
 
 #ifdef __cplusplus
@@ -107,6 +107,7 @@ typedef enum {
   /** The buffer is too small for the data. @internal Numeric code: 74 @endinternal */ IOTC_BUFFER_TOO_SMALL_ERROR,
   /** The buffer for storing formatted and signed JWTs is null. @internal Numeric code: 75 @endinternal */ IOTC_NULL_KEY_DATA_ERROR,
   /** @cond Numeric code: 76 */ IOTC_NULL_CLIENT_ID_ERROR, /** @endcond */
+  /** The connection was shut down while its connect waited for admission. @internal Numeric code: 77 @endinternal */ IOTC_CONNECTION_CANCELLED_ERROR,
 
   /** @cond */ IOTC_ERROR_COUNT /** @endcond */ /* Add errors above this line; this should always be last line. */
 } iotc_state_t;
@@ -0,0 +1,146 @@
+/* Copyright 2018-2020 Google LLC
+ *
+ * This is part of the Google Cloud IoT Device SDK for Embedded C.
+ * It is licensed under the BSD 3-Clause license; you may not use this file
+ * except in compliance with the License.
+ *
+ * You may obtain a copy of the License at:
+ *  https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __IOTC_GATEWAY_H__
+#define __IOTC_GATEWAY_H__
+
+#include <iotc_error.h>
+#include <iotc_mqtt.h>
+#include <iotc_types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*! \file
+ * @brief Communicates on behalf of devices attached to a gateway.
+ *
+ * @details A gateway is a device that connects to Cloud IoT Core with
+ * iotc_connect() and relays the traffic of other devices. All the attached
+ * devices share the connection, the socket, the TLS session and the keepalive
+ * of the gateway's context.
+ *
+ * Attach a device with iotc_gateway_attach_device() before publishing or
+ * subscribing on its behalf. Cloud IoT Core reports attach and detach failures
+ * on the <code>/devices/<gateway_id>/errors</code> topic; subscribe to it with
+ * iotc_subscribe() to receive them.
+ */
+
+/** The maximum length, in characters, of an attached device's ID. */
+#define IOTC_GATEWAY_DEVICE_ID_MAX_LEN 128
+
+/**
+ * @brief Attaches a device to the gateway.
+ *
+ * @details Publishes a QoS 1 message to the
+ * <code>/devices/<device_id>/attach</code> topic.
+ *
+ * @param [in] iotc_h A {@link iotc_connect() connected} context handle of the
+ *     gateway.
+ * @param [in] device_id The ID of the device to attach. Can't contain
+ *     <code>/</code>, <code>+</code> or <code>#</code>.
+ * @param [in] device_jwt (Optional) A {@link iotc_create_iotcore_jwt() JWT}
+ *     signed with the device's key. Required only if the gateway
+ *     authenticates its devices with the device credentials.
+ * @param [in] callback (Optional) The callback function. Invoked after the
+ *     attach message is successfully or unsuccessfully delivered.
+ * @param [in] user_data (Optional) Abstract data passed to the callback
+ *     function.
+ */
+extern iotc_state_t iotc_gateway_attach_device(iotc_context_handle_t iotc_h,
+                                               const char* device_id,
+                                               const char* device_jwt,
+                                               iotc_user_callback_t* callback,
+                                               void* user_data);
+
+/**
+ * @brief Detaches a device from the gateway.
+ *
+ * @details Publishes a QoS 1 message to the
+ * <code>/devices/<device_id>/detach</code> topic. The callbacks of the
+ * subscriptions made on behalf of the device with iotc_gateway_subscribe()
+ * are unregistered, messages that still arrive on the device's topics are
+ * dropped. A subscription whose SUBACK arrives after the detach keeps its
+ * callback.
+ *
+ * @param [in] iotc_h A {@link iotc_connect() connected} context handle of the
+ *     gateway.
+ * @param [in] device_id The ID of an attached device.
+ * @param [in] callback (Optional) The callback function. Invoked after the
+ *     detach message is successfully or unsuccessfully delivered.
+ * @param [in] user_data (Optional) Abstract data passed to the callback
+ *     function.
+ */
+extern iotc_state_t iotc_gateway_detach_device(iotc_context_handle_t iotc_h,
+                                               const char* device_id,
+                                               iotc_user_callback_t* callback,
+                                               void* user_data);
+
+/**
+ * @brief Publishes binary data on behalf of an attached device.
+ *
+ * @details Performs the same operations as iotc_publish_data() on the
+ * <code>/devices/<device_id>/<subtopic></code> topic.
+ *
+ * @param [in] iotc_h A {@link iotc_connect() connected} context handle of the
+ *     gateway.
+ * @param [in] device_id The ID of an attached device.
+ * @param [in] subtopic The device topic, for example <code>events</code>,
+ *     <code>events/alerts</code> or <code>state</code>.
+ * @param [in] data A pointer to a buffer with the message payload.
+ * @param [in] data_len The size, in bytes, of the message.
+ * @param [in] qos The Quality of Service (QoS) level. Can be <code>0</code> or
+ *     <code>1</code>.
+ * @param [in] callback (Optional) The callback function. Invoked after a
+ *     message is successfully or unsuccessfully delivered.
+ * @param [in] user_data (Optional) Abstract data passed to the callback
+ *     function.
+ */
+extern iotc_state_t iotc_gateway_publish(
+    iotc_context_handle_t iotc_h, const char* device_id, const char* subtopic,
+    const uint8_t* data, size_t data_len, const iotc_mqtt_qos_t qos,
+    iotc_user_callback_t* callback, void* user_data);
+
+/**
+ * @brief Subscribes to a topic on behalf of an attached device.
+ *
+ * @details Performs the same operations as iotc_subscribe() on the
+ * <code>/devices/<device_id>/<subtopic></code> topic. Each subscription has
+ * its own callback, so the messages of the attached devices are delivered to
+ * the callbacks registered for them.
+ *
+ * @param [in] iotc_h A {@link iotc_connect() connected} context handle of the
+ *     gateway.
+ * @param [in] device_id The ID of an attached device.
+ * @param [in] subtopic The device topic, for example <code>config</code> or
+ *     <code>commands/#</code>.
+ * @param [in] qos The Quality of Service (QoS) level. Can be <code>0</code> or
+ *     <code>1</code>.
+ * @param [in] callback The {@link ::iotc_user_subscription_callback_t callback}
+ *     invoked after a message is published to the device topic.
+ * @param [in] user_data (Optional) A pointer that to the callback function's
+ *     user_data parameter.
+ */
+extern iotc_state_t iotc_gateway_subscribe(
+    iotc_context_handle_t iotc_h, const char* device_id, const char* subtopic,
+    const iotc_mqtt_qos_t qos, iotc_user_subscription_callback_t* callback,
+    void* user_data);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __IOTC_GATEWAY_H__ */
@@ -268,6 +268,178 @@ typedef struct {
   iotc_crypto_key_signature_algorithm_t crypto_key_signature_algorithm;
 } iotc_crypto_key_data_t;
 
+/**
+ * @typedef iotc_offline_queue_policy_t
+ * @brief What to drop when a publish doesn't fit in the
+ *     {@link iotc_set_offline_queue() offline queue}.
+ */
+typedef enum iotc_offline_queue_policy_e {
+  /** The oldest messages are dropped to make room for the new one. Their
+   * callbacks are invoked with <code>IOTC_BUFFER_OVERFLOW</code>. */
+  IOTC_OFFLINE_QUEUE_DROP_OLDEST = 0,
+  /** The new message is rejected, the publish function returns
+   * <code>IOTC_BUFFER_OVERFLOW</code>. */
+  IOTC_OFFLINE_QUEUE_DROP_NEWEST
+} iotc_offline_queue_policy_t;
+
+/**
+ * @typedef iotc_offline_queue_config_t
+ * @struct iotc_offline_queue_config_t
+ * @brief The budget and the policy of the
+ *     {@link iotc_set_offline_queue() offline queue} of a context.
+ */
+typedef struct iotc_offline_queue_config_s {
+  /** The maximum number of queued messages, <code>0</code> disables the
+   * queue. */
+  uint16_t max_messages;
+  /** The maximum number of queued bytes, topics included. <code>0</code> means
+   * no byte limit. */
+  size_t max_bytes;
+  /** What to drop when the budget is exhausted. */
+  iotc_offline_queue_policy_t policy;
+  /** (Optional) The file the queue is saved to when the context is deleted and
+   * restored from by iotc_set_offline_queue(). <code>NULL</code> keeps the
+   * queue in memory only. */
+  const char* persistence_resource_name;
+} iotc_offline_queue_config_t;
+
+/**
+ * @typedef iotc_session_store_config_t
+ * @struct iotc_session_store_config_t
+ * @brief Where the {@link iotc_set_session_store() session store} of a
+ *     context keeps its in-flight QoS 1 publishes.
+ */
+typedef struct iotc_session_store_config_s {
+  /** (Optional) The append-only log the in-flight publishes are recorded in,
+   * so that they survive a restart of the application. <code>NULL</code>
+   * keeps them in memory only. */
+  const char* log_resource_name;
+  /** The number of obsolete log records, those of acknowledged publishes,
+   * after which the log is rewritten with the in-flight publishes only.
+   * <code>0</code> selects the default of 64. */
+  uint16_t compaction_threshold;
+} iotc_session_store_config_t;
+
+/**
+ * @typedef iotc_context_stats_t
+ * @struct iotc_context_stats_t
+ * @brief The runtime statistics of a context, see iotc_get_context_stats().
+ *
+ * The counters accumulate over all the connections of the context since it
+ * was created or since the last iotc_reset_context_stats().
+ */
+typedef struct iotc_context_stats_s {
+  /** The bytes written to and read from the sockets, TLS records included. */
+  uint64_t bytes_sent;
+  uint64_t bytes_received;
+  /** The MQTT messages of any type sent and received. */
+  uint32_t messages_sent;
+  uint32_t messages_received;
+  /** The MQTT PUBLISH messages sent and received. */
+  uint32_t publishes_sent;
+  uint32_t publishes_received;
+  /** The QoS 1 publishes sent again with the duplicate flag set. */
+  uint32_t qos1_retransmits;
+  /** The QoS 1 publishes whose PUBACK didn't arrive in time. */
+  uint32_t puback_timeouts;
+  /** The completed TLS handshakes. */
+  uint32_t tls_handshakes;
+  /** The connections accepted by the broker, and the ones among them that
+   * followed an earlier connection of the context. */
+  uint32_t connects;
+  uint32_t reconnects;
+  /** The time between the last PINGREQ and its PINGRESP, in milliseconds. */
+  uint32_t keepalive_rtt_ms;
+  /** The smoothed round trip time to the broker and its variance, in
+   * milliseconds, estimated like TCP does from the PINGREQ/PINGRESP and the
+   * QoS 1 PUBLISH/PUBACK pairs. They set how long the client waits for a
+   * PUBACK before retransmitting and for a PINGRESP. 0 before the first
+   * measurement. */
+  uint32_t smoothed_rtt_ms;
+  uint32_t rtt_variance_ms;
+  /** The messages waiting in the MQTT codec layer to be written and the
+   * MQTT tasks waiting in the logic layer, at the time of the call. */
+  uint16_t codec_queue_depth;
+  uint16_t logic_queue_depth;
+} iotc_context_stats_t;
+
+/**
+ * @typedef iotc_layer_trace_writer_t
+ * @brief Receives the layer trace one chunk at a time, see
+ * iotc_export_layer_trace().
+ *
+ * @param [in] chunk The next piece of the JSON document, not NUL-terminated.
+ * @param [in] length The length of the chunk in bytes.
+ * @param [in] user_data The data provided to iotc_export_layer_trace().
+ */
+typedef void(iotc_layer_trace_writer_t)(const char* chunk, size_t length,
+                                        void* user_data);
+
+/**
+ * @typedef iotc_debug_log_level_t
+ * @brief The detail of the debug log, see iotc_set_debug_log_filter().
+ */
+typedef enum iotc_debug_log_level_e {
+  /** Records nothing. */
+  IOTC_DEBUG_LOG_LEVEL_NONE = 0,
+  /** The progress of the connections and the MQTT messages. */
+  IOTC_DEBUG_LOG_LEVEL_DEBUG,
+  /** Adds the function entries and the dumps of the MQTT messages and the
+   * buffers. */
+  IOTC_DEBUG_LOG_LEVEL_TRACE
+} iotc_debug_log_level_t;
+
+/**
+ * @typedef iotc_debug_log_module_t
+ * @brief The parts of the SDK whose debug log can be turned on and off, see
+ * iotc_set_debug_log_filter().
+ */
+typedef enum iotc_debug_log_module_e {
+  IOTC_DEBUG_LOG_MODULE_CORE = 1 << 0,
+  IOTC_DEBUG_LOG_MODULE_EVENTS = 1 << 1,
+  IOTC_DEBUG_LOG_MODULE_IO = 1 << 2,
+  IOTC_DEBUG_LOG_MODULE_TLS = 1 << 3,
+  IOTC_DEBUG_LOG_MODULE_MQTT = 1 << 4,
+  IOTC_DEBUG_LOG_MODULE_CONTROL_TOPIC = 1 << 5,
+  IOTC_DEBUG_LOG_MODULE_MEMORY = 1 << 6,
+  IOTC_DEBUG_LOG_MODULE_PLATFORM = 1 << 7,
+  IOTC_DEBUG_LOG_MODULE_ALL = 0xFF
+} iotc_debug_log_module_t;
+
+/**
+ * @typedef iotc_debug_log_writer_t
+ * @brief Receives the formatted debug log, see iotc_drain_debug_log().
+ *
+ * @param [in] text The next piece of the log, not NUL-terminated.
+ * @param [in] length The length of the text in bytes.
+ * @param [in] user_data The data provided to iotc_drain_debug_log().
+ */
+typedef void(iotc_debug_log_writer_t)(const char* text, size_t length,
+                                      void* user_data);
+
+/**
+ * @typedef iotc_heap_profile_format_t
+ * @brief The output formats of iotc_dump_heap_profile().
+ */
+typedef enum iotc_heap_profile_format_e {
+  /** One line per allocation site with all its counters. */
+  IOTC_HEAP_PROFILE_FORMAT_CSV = 0,
+  /** The legacy text heap profile read by pprof, with the memory map of the
+   * process so pprof can symbolize the allocation sites. */
+  IOTC_HEAP_PROFILE_FORMAT_PPROF
+} iotc_heap_profile_format_t;
+
+/**
+ * @typedef iotc_heap_profile_writer_t
+ * @brief Receives the heap profile, see iotc_dump_heap_profile().
+ *
+ * @param [in] text The next piece of the profile, not NUL-terminated.
+ * @param [in] length The length of the text in bytes.
+ * @param [in] user_data The data provided to iotc_dump_heap_profile().
+ */
+typedef void(iotc_heap_profile_writer_t)(const char* text, size_t length,
+                                         void* user_data);
+
 #ifdef __cplusplus
 }
 #endif
@@ -65,6 +65,15 @@ ifneq (,$(findstring debug,$(TARGET)))
 	IOTC_DEBUG_EXTRA_INFO ?= 1
 endif
 
+# DEBUG_EXTENSION: record the debug log in binary form, cheap enough to keep it
+# in release builds
+ifneq (,$(findstring binary_log,$(CONFIG)))
+	IOTC_DEBUG_OUTPUT := 1
+	IOTC_CONFIG_FLAGS += -DIOTC_DEBUG_BINARY_LOG
+	IOTC_DEBUG_BINARY_LOG := 1
+	IOTC_SRCDIRS += $(LIBIOTC_SOURCE_DIR)/debug_extensions/binary_log
+endif
+
 # Settings that will work only on linux and only against clang-4.0 and greater
 ifneq (,$(findstring fuzz_test,$(CONFIG)))
     IOTC_CONFIG_FLAGS += -fsanitize=address -fomit-frame-pointer -fsanitize-coverage=inline-8bit-counters -g
@@ -126,6 +135,27 @@ ifneq (,$(findstring memory_limiter,$(CONFIG)))
 	IOTC_CONFIG_FLAGS += -DIOTC_MEMORY_LIMITER_ENABLED
 	IOTC_MEMORY_LIMITER_ENABLED := 1
 	IOTC_SRCDIRS += $(LIBIOTC_SOURCE_DIR)/debug_extensions/memory_limiter
+
+	# DEBUG_EXTENSION: per allocation site counters of the memory limiter
+	ifneq (,$(findstring heap_profiler,$(CONFIG)))
+		IOTC_CONFIG_FLAGS += -DIOTC_MEMORY_LIMITER_PROFILER_ENABLED
+		IOTC_MEMORY_LIMITER_PROFILER_ENABLED := 1
+	endif
+else ifneq (,$(findstring memory_accounting,$(CONFIG)))
+	IOTC_CONFIG_FLAGS += -DIOTC_MEMORY_ACCOUNTING_ENABLED
+	IOTC_MEMORY_ACCOUNTING_ENABLED := 1
+endif
+
+# DEBUG_EXTENSION: record the transitions between the layers
+ifneq (,$(findstring layer_tracing,$(CONFIG)))
+	IOTC_CONFIG_FLAGS += -DIOTC_LAYER_TRACING_ENABLED
+	IOTC_LAYER_TRACING_ENABLED := 1
+	IOTC_SRCDIRS += $(LIBIOTC_SOURCE_DIR)/debug_extensions/layer_tracing
+endif
+
+# CONFIG: compile out the per context statistics
+ifneq (,$(findstring no_context_stats,$(CONFIG)))
+	IOTC_CONFIG_FLAGS += -DIOTC_NO_CONTEXT_STATS
 endif
 
 # CONFIG: modules here we are going to check each defined module
@@ -138,6 +168,16 @@ ifneq (,$(findstring threading,$(CONFIG)))
 	IOTC_PLATFORM_MODULES_ENABLED += iotc_thread
 endif
 
+# CONFIG: the number of contexts and of timed tasks the library hands out at
+# once, 2 and 64 by default
+ifdef IOTC_MAX_NUM_CONTEXTS
+	IOTC_CONFIG_FLAGS += -DIOTC_MAX_NUM_CONTEXTS=$(IOTC_MAX_NUM_CONTEXTS)
+endif
+
+ifdef IOTC_MAX_TIMED_EVENT
+	IOTC_CONFIG_FLAGS += -DIOTC_MAX_TIMED_EVENT=$(IOTC_MAX_TIMED_EVENT)
+endif
+
 # CONFIG: choose modules platform
 ifneq (,$(findstring posix_platform,$(CONFIG)))
 	IOTC_PLATFORM_BASE = posix
@@ -234,6 +274,7 @@ IOTC_SOURCES_CXX := $(wildcard ./src/*.cc)
 IOTC_SOURCES_CXX += $(foreach layerdir,$(IOTC_SRCDIRS),\
 	$(wildcard $(layerdir)/*.cc))
 IOTC_SOURCES_CXX := $(filter-out $(IOTC_GTEST_SOURCES), $(IOTC_SOURCES_CXX)) # Filter out tests
+IOTC_SOURCES_CXX := $(filter-out %_benchmark.cc, $(IOTC_SOURCES_CXX)) # Filter out microbenchmarks
 
 ifeq ($(IOTC_DEBUG_OUTPUT),0)
 IOTC_SOURCES := $(filter-out $(LIBIOTC_SOURCE_DIR)/iotc_debug.c, $(IOTC_SOURCES) )
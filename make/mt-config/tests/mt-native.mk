@@ -19,5 +19,8 @@ IOTC_FTEST_MAX_LEN ?= 256
 #IOTC_RUN_UTESTS = $(IOTC_UTESTS) -l0 --terse
 IOTC_RUN_UTESTS := (cd $(dir $(IOTC_UTESTS)) && LD_LIBRARY_PATH=$(dir $(XI)):$$LD_LIBRARY_PATH exec $(IOTC_UTESTS) -l0)
 IOTC_RUN_ITESTS := (cd $(dir $(IOTC_ITESTS)) && LD_LIBRARY_PATH=$(dir $(XI)):$$LD_LIBRARY_PATH exec $(IOTC_ITESTS))
-IOTC_RUN_FUZZ_TEST = (cd $(IOTC_FUZZ_TESTS_BINDIR) && $(1) $(IOTC_FUZZ_TESTS_CORPUS_DIR)/$(notdir $(1))/ -max_total_time=$(IOTC_FTEST_MAX_TOTAL_TIME) -max_len=$(IOTC_FTEST_MAX_LEN));
+IOTC_RUN_FUZZ_TEST = (cd $(IOTC_FUZZ_TESTS_BINDIR) && $(1) $(IOTC_FUZZ_TESTS_WORK_CORPUS_DIR)/$(notdir $(1))/ $(IOTC_FUZZ_TESTS_CORPUS_DIR)/$(notdir $(1))/ -max_total_time=$(IOTC_FTEST_MAX_TOTAL_TIME) -max_len=$(IOTC_FTEST_MAX_LEN));
+IOTC_RUN_FUZZ_TEST_REPLAY = (cd $(IOTC_FUZZ_TESTS_REPLAY_BINDIR) && $(1) --runs $(IOTC_FTEST_REPLAY_RUNS) --output $(notdir $(1)).json $(IOTC_FUZZ_TESTS_CORPUS_DIR)/$(notdir $(1)) && cat $(notdir $(1)).json);
+IOTC_RUN_BENCHMARK = (cd $(IOTC_BENCHMARKS_BINDIR) && $(1) --output $(notdir $(1)).json $(IOTC_BENCHMARK_ARGS) && cat $(notdir $(1)).json);
+IOTC_RUN_MICROBENCHMARKS = (cd $(dir $(IOTC_MICROBENCHMARKS)) && $(IOTC_MICROBENCHMARKS) --benchmark_out=$(notdir $(IOTC_MICROBENCHMARKS)).json --benchmark_out_format=json $(IOTC_MICROBENCHMARK_ARGS))
 IOTC_RUN_GTESTS := (cd $(dir $(IOTC_ITESTS)) && LD_LIBRARY_PATH=$(dir $(XI)):$$LD_LIBRARY_PATH exec $(IOTC_GTESTS))
@@ -0,0 +1,74 @@
+# Copyright 2018-2020 Google LLC
+#
+# This is part of the Google Cloud IoT Device SDK for Embedded C.
+# It is licensed under the BSD 3-Clause license; you may not use this file
+# except in compliance with the License.
+#
+# You may obtain a copy of the License at:
+#  https://opensource.org/licenses/BSD-3-Clause
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+
+include make/mt-config/tests/mt-tests.mk
+
+IOTC_BENCHMARKS_BINDIR := $(IOTC_TEST_BINDIR)/benchmarks
+
+IOTC_BENCHMARKS_SOURCE_DIR := $(IOTC_TEST_DIR)/benchmarks
+IOTC_BENCHMARKS_SOURCES := $(wildcard $(IOTC_BENCHMARKS_SOURCE_DIR)/*.cpp)
+IOTC_BENCHMARKS := $(foreach benchmark,$(IOTC_BENCHMARKS_SOURCES),$(notdir $(benchmark)))
+IOTC_BENCHMARKS := $(IOTC_BENCHMARKS:.cpp=)
+IOTC_BENCHMARKS := $(foreach benchmark, $(IOTC_BENCHMARKS), $(IOTC_BENCHMARKS_BINDIR)/$(benchmark))
+
+# the loopback MQTT broker is built into every benchmark
+IOTC_BENCHMARKS_TOOLS_SOURCES := $(IOTC_TEST_DIR)/tools/iotc_test_echoserver.cc
+
+IOTC_BENCHMARKS_CXX_FLAGS := -O2 -std=c++11 -pthread -I$(IOTC_TEST_DIR)/tools
+IOTC_BENCHMARKS_LIB_FLAGS :=
+
+# allocations are counted by wrapping the memory BSP at link time
+ifeq ($(IOTC_HOST_PLATFORM),Linux)
+	IOTC_BENCHMARKS_CXX_FLAGS += -DIOTC_BENCHMARK_COUNT_ALLOCATIONS
+	IOTC_BENCHMARKS_LIB_FLAGS += -Wl,--wrap=iotc_bsp_mem_alloc -Wl,--wrap=iotc_bsp_mem_realloc
+endif
+
+# with a TLS BSP the broker terminates TLS with OpenSSL
+ifndef IOTC_NO_TLS_LAYER
+	IOTC_BENCHMARKS_CXX_FLAGS += -DIOTC_TEST_ECHOSERVER_TLS
+	IOTC_BENCHMARKS_LIB_FLAGS += -lssl
+endif
+
+# extra arguments of the benchmark runs, e.g. --messages or --tls_cert
+IOTC_BENCHMARK_ARGS ?=
+
+# Set up the Google Benchmark microbenchmarks: files ending in _benchmark.cc
+# next to the code they measure, all linked into one binary.
+IOTC_MICROBENCHMARKS_OBJDIR := $(IOTC_TEST_OBJDIR)/microbenchmarks
+
+IOTC_MICROBENCHMARKS_SOURCES := $(shell find $(LIBIOTC)/src -name "*_benchmark.cc")
+
+# the crypto BSP only exists in the builds with a TLS layer
+ifdef IOTC_NO_TLS_LAYER
+	IOTC_MICROBENCHMARKS_SOURCES := $(filter-out %/iotc_jwt_benchmark.cc %/iotc_bsp_crypto_benchmark.cc, \
+		$(IOTC_MICROBENCHMARKS_SOURCES))
+endif
+
+# the threadpool only exists in the builds with threading
+ifeq (,$(findstring threading,$(CONFIG)))
+	IOTC_MICROBENCHMARKS_SOURCES := $(filter-out %/iotc_thread_posix_threadpool_benchmark.cc, \
+		$(IOTC_MICROBENCHMARKS_SOURCES))
+endif
+
+IOTC_MICROBENCHMARKS_OBJS := $(subst $(LIBIOTC_SRC),$(IOTC_MICROBENCHMARKS_OBJDIR)/,$(IOTC_MICROBENCHMARKS_SOURCES:.cc=.o))
+
+IOTC_MICROBENCHMARKS := $(IOTC_TEST_BINDIR)/iotc_microbenchmarks
+
+IOTC_MICROBENCHMARKS_CXX_FLAGS := $(IOTC_GTEST_CXX_FLAGS) -O2
+IOTC_MICROBENCHMARKS_LIB_FLAGS := -lbenchmark_main -lbenchmark -lpthread
+
+# extra arguments of the microbenchmark run, e.g. --benchmark_filter=Mqtt
+IOTC_MICROBENCHMARK_ARGS ?=
@@ -24,11 +24,23 @@ IOTC_FUZZ_TESTS_SOURCES := $(wildcard $(IOTC_FUZZ_TESTS_SOURCE_DIR)/*.cpp)
 IOTC_FUZZ_TESTS := $(foreach fuzztest,$(IOTC_FUZZ_TESTS_SOURCES),$(notdir $(fuzztest)))
 IOTC_FUZZ_TESTS := $(IOTC_FUZZ_TESTS:.cpp=)
 IOTC_FUZZ_TESTS_CORPUS_DIR := $(IOTC_FUZZ_TESTS_SOURCE_DIR)/corpuses
-IOTC_FUZZ_TESTS_CORPUS_DIRS := $(foreach fuzztest, $(IOTC_FUZZ_TESTS), $(IOTC_FUZZ_TESTS_CORPUS_DIR)/$(fuzztest))
+# the seed corpus stays as it is, libFuzzer writes the new inputs here
+IOTC_FUZZ_TESTS_WORK_CORPUS_DIR := $(IOTC_FUZZ_TESTS_BINDIR)/corpuses
+IOTC_FUZZ_TESTS_CORPUS_DIRS := $(foreach fuzztest, $(IOTC_FUZZ_TESTS), $(IOTC_FUZZ_TESTS_WORK_CORPUS_DIR)/$(fuzztest))
 IOTC_FUZZ_TESTS := $(foreach fuzztest, $(IOTC_FUZZ_TESTS), $(IOTC_FUZZ_TESTS_BINDIR)/$(fuzztest))
 
 IOTC_FUZZ_TEST_LIBRARY := -lFuzzer
 
+# Replay of the seed corpus as a benchmark: each fuzz test linked with a main
+# of its own instead of libFuzzer, so it builds with any compiler.
+IOTC_FUZZ_TESTS_REPLAY_BINDIR := $(IOTC_TEST_BINDIR)/fuzztests_replay
+IOTC_FUZZ_TESTS_REPLAY_SOURCES := $(IOTC_FUZZ_TESTS_SOURCE_DIR)/replay/iotc_fuzztest_replay.cpp
+IOTC_FUZZ_TESTS_REPLAY := $(foreach fuzztest, $(IOTC_FUZZ_TESTS), $(IOTC_FUZZ_TESTS_REPLAY_BINDIR)/$(notdir $(fuzztest)))
+IOTC_FUZZ_TESTS_REPLAY_CXX_FLAGS := -O2 -std=c++11
+
+# how many times the corpus is replayed
+IOTC_FTEST_REPLAY_RUNS ?= 100
+
 #### =========================================================
 
 IOTC_CLANG_TOOLS_DIR := $(LIBIOTC)/src/import/clang_tools
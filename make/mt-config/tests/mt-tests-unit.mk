@@ -28,6 +28,22 @@ ifndef IOTC_MEMORY_LIMITER_ENABLED
     IOTC_UTEST_EXCLUDED += iotc_utest_memory_limiter.c
 endif
 
+ifndef IOTC_MEMORY_LIMITER_PROFILER_ENABLED
+    IOTC_UTEST_EXCLUDED += iotc_utest_memory_profiler.c
+endif
+
+ifndef IOTC_MEMORY_ACCOUNTING_ENABLED
+    IOTC_UTEST_EXCLUDED += iotc_utest_memory_accounting.c
+endif
+
+ifndef IOTC_LAYER_TRACING_ENABLED
+    IOTC_UTEST_EXCLUDED += iotc_utest_layer_tracing.c
+endif
+
+ifndef IOTC_DEBUG_BINARY_LOG
+    IOTC_UTEST_EXCLUDED += iotc_utest_debug_log.c
+endif
+
 ifndef IOTC_LIBCRYPTO_AVAILABLE
     IOTC_UTEST_EXCLUDED += iotc_utest_jwt_openssl_validation.c
 endif
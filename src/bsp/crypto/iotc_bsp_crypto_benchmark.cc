@@ -0,0 +1,57 @@
+/* Copyright 2018-2020 Google LLC
+ *
+ * This is part of the Google Cloud IoT Device SDK for Embedded C.
+ * It is licensed under the BSD 3-Clause license; you may not use this file
+ * except in compliance with the License.
+ *
+ * You may obtain a copy of the License at:
+ *  https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+#include "iotc_bsp_crypto.h"
+
+namespace iotctest {
+namespace {
+
+constexpr unsigned int kSHA256HashSize = 32;
+
+void BM_BspSha256(benchmark::State& state) {
+  const std::vector<uint8_t> input(state.range(0), 'a');
+  uint8_t hash[kSHA256HashSize] = {0};
+
+  for (auto _ : state) {
+    iotc_bsp_sha256(hash, input.data(), input.size());
+    benchmark::DoNotOptimize(hash);
+  }
+
+  state.SetBytesProcessed(state.iterations() * input.size());
+}
+BENCHMARK(BM_BspSha256)->Arg(64)->Arg(256)->Arg(1024);
+
+void BM_BspBase64EncodeUrlsafe(benchmark::State& state) {
+  const std::vector<uint8_t> input(state.range(0), 'a');
+  std::vector<unsigned char> output(2 * input.size() + 4);
+
+  for (auto _ : state) {
+    size_t bytes_written = 0;
+    iotc_bsp_base64_encode_urlsafe(output.data(), output.size(),
+                                   &bytes_written, input.data(), input.size());
+    benchmark::DoNotOptimize(bytes_written);
+  }
+
+  state.SetBytesProcessed(state.iterations() * input.size());
+}
+BENCHMARK(BM_BspBase64EncodeUrlsafe)->Arg(64)->Arg(256)->Arg(1024);
+
+}  // namespace
+}  // namespace iotctest
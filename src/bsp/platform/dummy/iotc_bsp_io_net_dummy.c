@@ -28,11 +28,13 @@ extern "C" {
 
 iotc_bsp_io_net_state_t iotc_bsp_io_net_socket_connect(
     iotc_bsp_socket_t* iotc_socket, const char* host, uint16_t port,
-    iotc_bsp_socket_type_t socket_type) {
+    iotc_bsp_socket_type_t socket_type,
+    const iotc_bsp_socket_options_t* socket_options) {
   IOTC_UNUSED(iotc_socket);
   IOTC_UNUSED(host);
   IOTC_UNUSED(port);
   IOTC_UNUSED(socket_type);
+  IOTC_UNUSED(socket_options);
   return IOTC_BSP_IO_NET_STATE_OK;
 }
 
@@ -20,6 +20,8 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <stdio.h>
 #include <string.h>
 #include <sys/socket.h>
@@ -35,9 +37,89 @@ extern "C" {
 #define MAX(a, b) (((a) > (b)) ? (a) : (b))
 #endif
 
+/* Options are best effort: the ones this system doesn't know are skipped and
+ * a refused value leaves the default in place. */
+static void iotc_bsp_io_net_set_options(
+    int fd, int family, iotc_bsp_socket_type_t socket_type,
+    const iotc_bsp_socket_options_t* options) {
+  int value = 0;
+
+  if (NULL == options) {
+    return;
+  }
+
+  if (0 < options->send_buffer_size) {
+    value = (int)options->send_buffer_size;
+    setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &value, sizeof(value));
+  }
+
+  if (0 < options->receive_buffer_size) {
+    value = (int)options->receive_buffer_size;
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &value, sizeof(value));
+  }
+
+  if (0 < options->ip_tos) {
+    value = options->ip_tos;
+    if (AF_INET == family) {
+      setsockopt(fd, IPPROTO_IP, IP_TOS, &value, sizeof(value));
+    }
+#ifdef IPV6_TCLASS
+    if (AF_INET6 == family) {
+      setsockopt(fd, IPPROTO_IPV6, IPV6_TCLASS, &value, sizeof(value));
+    }
+#endif
+  }
+
+  if (SOCKET_STREAM != socket_type) {
+    return;
+  }
+
+  if (1 == options->tcp_nodelay) {
+    value = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &value, sizeof(value));
+  }
+
+  if (1 == options->tcp_keepalive) {
+    value = 1;
+    setsockopt(fd, SOL_SOCKET, SO_KEEPALIVE, &value, sizeof(value));
+
+#ifdef TCP_KEEPIDLE
+    if (0 < options->tcp_keepalive_idle) {
+      value = options->tcp_keepalive_idle;
+      setsockopt(fd, IPPROTO_TCP, TCP_KEEPIDLE, &value, sizeof(value));
+    }
+#elif defined(TCP_KEEPALIVE)
+    if (0 < options->tcp_keepalive_idle) {
+      value = options->tcp_keepalive_idle;
+      setsockopt(fd, IPPROTO_TCP, TCP_KEEPALIVE, &value, sizeof(value));
+    }
+#endif
+#ifdef TCP_KEEPINTVL
+    if (0 < options->tcp_keepalive_interval) {
+      value = options->tcp_keepalive_interval;
+      setsockopt(fd, IPPROTO_TCP, TCP_KEEPINTVL, &value, sizeof(value));
+    }
+#endif
+#ifdef TCP_KEEPCNT
+    if (0 < options->tcp_keepalive_count) {
+      value = options->tcp_keepalive_count;
+      setsockopt(fd, IPPROTO_TCP, TCP_KEEPCNT, &value, sizeof(value));
+    }
+#endif
+  }
+
+#ifdef TCP_USER_TIMEOUT
+  if (0 < options->tcp_user_timeout_ms) {
+    unsigned int timeout = options->tcp_user_timeout_ms;
+    setsockopt(fd, IPPROTO_TCP, TCP_USER_TIMEOUT, &timeout, sizeof(timeout));
+  }
+#endif
+}
+
 iotc_bsp_io_net_state_t iotc_bsp_io_net_socket_connect(
     iotc_bsp_socket_t* iotc_socket, const char* host, uint16_t port,
-    iotc_bsp_socket_type_t socket_type) {
+    iotc_bsp_socket_type_t socket_type,
+    const iotc_bsp_socket_options_t* socket_options) {
   struct addrinfo hints;
   struct addrinfo *result, *rp = NULL;
   int status;
@@ -77,6 +159,9 @@ iotc_bsp_io_net_state_t iotc_bsp_io_net_socket_connect(
         break;
     }
 
+    iotc_bsp_io_net_set_options(*iotc_socket, rp->ai_family, socket_type,
+                                socket_options);
+
     // Attempt to connect.
     status = connect(*iotc_socket, rp->ai_addr, rp->ai_addrlen);
 
@@ -17,7 +17,12 @@
 #include "iotc_bsp_io_net.h"
 
 #include <memory>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <stdio.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
 
 #include "gtest.h"
 #include "iotc_test_echoserver.h"
@@ -93,8 +98,9 @@ TEST_P(ServerTest, EndToEndCommunicationWorks) {
   std::unique_ptr<EchoTestServer> test_server = test_server->Create(
       listening_addr, kTestPort, socket_type, protocol_type);
 
-  ASSERT_EQ(iotc_bsp_io_net_socket_connect(
-                &test_socket_, listening_addr.c_str(), kTestPort, socket_type),
+  ASSERT_EQ(iotc_bsp_io_net_socket_connect(&test_socket_,
+                                           listening_addr.c_str(), kTestPort,
+                                           socket_type, nullptr),
             IOTC_BSP_IO_NET_STATE_OK);
   ASSERT_EQ(iotc_bsp_io_net_connection_check(test_socket_,
                                              listening_addr.c_str(), kTestPort),
@@ -134,5 +140,113 @@ INSTANTIATE_TEST_CASE_P(
                     const_cast<char*>("127.0.0.1")),
         NetworkType(SOCKET_DGRAM, PROTOCOL_IPV6, const_cast<char*>("::1"))));
 
+// Accepts one connection on an ephemeral loopback port and keeps it open until
+// the client closes it.
+class LoopbackAcceptor {
+ public:
+  LoopbackAcceptor() {
+    struct sockaddr_in addr = {};
+    socklen_t addr_len = sizeof(addr);
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    listen_socket_ = socket(AF_INET, SOCK_STREAM, 0);
+    bind(listen_socket_, reinterpret_cast<struct sockaddr*>(&addr),
+         sizeof(addr));
+    listen(listen_socket_, 1);
+    getsockname(listen_socket_, reinterpret_cast<struct sockaddr*>(&addr),
+                &addr_len);
+    port_ = ntohs(addr.sin_port);
+
+    thread_ = std::thread([this]() { Serve(); });
+  }
+
+  ~LoopbackAcceptor() {
+    thread_.join();
+    close(listen_socket_);
+  }
+
+  uint16_t port() const { return port_; }
+
+ private:
+  void Serve() {
+    const int client = accept(listen_socket_, nullptr, nullptr);
+    uint8_t byte = 0;
+
+    if (0 <= client) {
+      while (0 < read(client, &byte, sizeof(byte))) {
+      }
+      close(client);
+    }
+  }
+
+  int listen_socket_ = -1;
+  uint16_t port_ = 0;
+  std::thread thread_;
+};
+
+class SocketOptionsTest : public ServerTest {
+ protected:
+  void Connect(uint16_t port, const iotc_bsp_socket_options_t* options) {
+    ASSERT_EQ(iotc_bsp_io_net_socket_connect(&test_socket_, "127.0.0.1", port,
+                                             SOCKET_STREAM, options),
+              IOTC_BSP_IO_NET_STATE_OK);
+    ASSERT_TRUE(WaitUntilSocketReadyForWrite());
+    ASSERT_EQ(iotc_bsp_io_net_connection_check(test_socket_, "127.0.0.1", port),
+              IOTC_BSP_IO_NET_STATE_OK);
+  }
+
+  int GetSocketOption(int level, int name) {
+    int value = 0;
+    socklen_t len = sizeof(value);
+
+    EXPECT_EQ(0, getsockopt(test_socket_, level, name, &value, &len));
+    return value;
+  }
+};
+
+TEST_F(SocketOptionsTest, OptionsAreSetBeforeConnecting) {
+  iotc_bsp_socket_options_t options = {};
+  options.tcp_nodelay = 1;
+  options.tcp_keepalive = 1;
+  options.tcp_keepalive_idle = 30;
+  options.receive_buffer_size = 64 * 1024;
+
+  LoopbackAcceptor acceptor;
+  Connect(acceptor.port(), &options);
+
+  EXPECT_NE(0, GetSocketOption(IPPROTO_TCP, TCP_NODELAY));
+  EXPECT_NE(0, GetSocketOption(SOL_SOCKET, SO_KEEPALIVE));
+#ifdef TCP_KEEPIDLE
+  EXPECT_EQ(30, GetSocketOption(IPPROTO_TCP, TCP_KEEPIDLE));
+#endif
+  EXPECT_LE(64 * 1024, GetSocketOption(SOL_SOCKET, SO_RCVBUF));
+
+  iotc_bsp_io_net_close_socket(&test_socket_);
+}
+
+TEST_F(SocketOptionsTest, NoOptionsKeepThePlatformDefaults) {
+  LoopbackAcceptor acceptor;
+  Connect(acceptor.port(), nullptr);
+
+  // Nagle's algorithm stays on unless TCP_NODELAY is asked for.
+  EXPECT_EQ(0, GetSocketOption(IPPROTO_TCP, TCP_NODELAY));
+  EXPECT_EQ(0, GetSocketOption(SOL_SOCKET, SO_KEEPALIVE));
+
+  iotc_bsp_io_net_close_socket(&test_socket_);
+}
+
+TEST_F(SocketOptionsTest, ZeroOptionsKeepThePlatformDefaults) {
+  iotc_bsp_socket_options_t options = {};
+
+  LoopbackAcceptor acceptor;
+  Connect(acceptor.port(), &options);
+
+  EXPECT_EQ(0, GetSocketOption(IPPROTO_TCP, TCP_NODELAY));
+  EXPECT_EQ(0, GetSocketOption(SOL_SOCKET, SO_KEEPALIVE));
+
+  iotc_bsp_io_net_close_socket(&test_socket_);
+}
+
 } // namespace
 } // namespace iotctest
@@ -148,16 +148,20 @@ iotc_bsp_io_fs_state_t iotc_bsp_io_fs_open(
     return IOTC_BSP_IO_FS_INVALID_PARAMETER;
   }
 
-  /* append not supported */
-  if (IOTC_BSP_IO_FS_OPEN_APPEND == (open_flags & IOTC_BSP_IO_FS_OPEN_APPEND)) {
-    return IOTC_BSP_IO_FS_INVALID_PARAMETER;
-  }
-
   iotc_bsp_io_fs_posix_file_handle_container_t* new_entry = NULL;
   iotc_bsp_io_fs_state_t ret = IOTC_BSP_IO_FS_STATE_OK;
 
-  int fd = open(resource_name,
-                (open_flags & IOTC_BSP_IO_FS_OPEN_READ) ? O_RDONLY : O_WRONLY);
+  /* a resource opened for writing is created or replaced, one opened for
+   * appending is created or extended, the offsets of its writes are ignored */
+  int fd = -1;
+
+  if (open_flags & IOTC_BSP_IO_FS_OPEN_READ) {
+    fd = open(resource_name, O_RDONLY);
+  } else if (open_flags & IOTC_BSP_IO_FS_OPEN_APPEND) {
+    fd = open(resource_name, O_WRONLY | O_CREAT | O_APPEND, 0600);
+  } else {
+    fd = open(resource_name, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+  }
 
   /* if error on fopen check the errno value */
   IOTC_BSP_IO_FS_CHECK_CND(
@@ -19,11 +19,14 @@
 #include <arpa/inet.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <limits.h>
 #include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
 #include <stdio.h>
 #include <string.h>
 #include <sys/socket.h>
-#include <sys/time.h>
 #include <sys/types.h>
 #include <unistd.h>
 #include "iotc_macros.h"
@@ -32,13 +35,89 @@
 extern "C" {
 #endif
 
-#ifndef MAX
-#define MAX(a, b) (((a) > (b)) ? (a) : (b))
+/* Options are best effort: the ones this system doesn't know are skipped and
+ * a refused value leaves the default in place. */
+static void iotc_bsp_io_net_set_options(
+    int fd, int family, iotc_bsp_socket_type_t socket_type,
+    const iotc_bsp_socket_options_t* options) {
+  int value = 0;
+
+  if (NULL == options) {
+    return;
+  }
+
+  if (0 < options->send_buffer_size) {
+    value = (int)options->send_buffer_size;
+    setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &value, sizeof(value));
+  }
+
+  if (0 < options->receive_buffer_size) {
+    value = (int)options->receive_buffer_size;
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &value, sizeof(value));
+  }
+
+  if (0 < options->ip_tos) {
+    value = options->ip_tos;
+    if (AF_INET == family) {
+      setsockopt(fd, IPPROTO_IP, IP_TOS, &value, sizeof(value));
+    }
+#ifdef IPV6_TCLASS
+    if (AF_INET6 == family) {
+      setsockopt(fd, IPPROTO_IPV6, IPV6_TCLASS, &value, sizeof(value));
+    }
+#endif
+  }
+
+  if (SOCKET_STREAM != socket_type) {
+    return;
+  }
+
+  if (1 == options->tcp_nodelay) {
+    value = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &value, sizeof(value));
+  }
+
+  if (1 == options->tcp_keepalive) {
+    value = 1;
+    setsockopt(fd, SOL_SOCKET, SO_KEEPALIVE, &value, sizeof(value));
+
+#ifdef TCP_KEEPIDLE
+    if (0 < options->tcp_keepalive_idle) {
+      value = options->tcp_keepalive_idle;
+      setsockopt(fd, IPPROTO_TCP, TCP_KEEPIDLE, &value, sizeof(value));
+    }
+#elif defined(TCP_KEEPALIVE)
+    if (0 < options->tcp_keepalive_idle) {
+      value = options->tcp_keepalive_idle;
+      setsockopt(fd, IPPROTO_TCP, TCP_KEEPALIVE, &value, sizeof(value));
+    }
 #endif
+#ifdef TCP_KEEPINTVL
+    if (0 < options->tcp_keepalive_interval) {
+      value = options->tcp_keepalive_interval;
+      setsockopt(fd, IPPROTO_TCP, TCP_KEEPINTVL, &value, sizeof(value));
+    }
+#endif
+#ifdef TCP_KEEPCNT
+    if (0 < options->tcp_keepalive_count) {
+      value = options->tcp_keepalive_count;
+      setsockopt(fd, IPPROTO_TCP, TCP_KEEPCNT, &value, sizeof(value));
+    }
+#endif
+  }
+
+#ifdef TCP_USER_TIMEOUT
+  if (0 < options->tcp_user_timeout_ms) {
+    unsigned int timeout = options->tcp_user_timeout_ms;
+    setsockopt(fd, IPPROTO_TCP, TCP_USER_TIMEOUT, &timeout, sizeof(timeout));
+  }
+#endif
+}
 
 iotc_bsp_io_net_state_t iotc_bsp_io_net_socket_connect(
     iotc_bsp_socket_t* iotc_socket, const char* host, uint16_t port,
-    iotc_bsp_socket_type_t socket_type) {
+    iotc_bsp_socket_type_t socket_type,
+    const iotc_bsp_socket_options_t* socket_options) {
   struct addrinfo hints;
   struct addrinfo *result, *rp = NULL;
   int status;
@@ -78,6 +157,9 @@ iotc_bsp_io_net_state_t iotc_bsp_io_net_socket_connect(
         break;
     }
 
+    iotc_bsp_io_net_set_options(*iotc_socket, rp->ai_family, socket_type,
+                                socket_options);
+
     // Attempt to connect.
     status = connect(*iotc_socket, rp->ai_addr, rp->ai_addrlen);
 
@@ -212,23 +294,11 @@ iotc_bsp_io_net_state_t iotc_bsp_io_net_close_socket(
 iotc_bsp_io_net_state_t iotc_bsp_io_net_select(
     iotc_bsp_socket_events_t* socket_events_array,
     size_t socket_events_array_size, long timeout_sec) {
-  fd_set rfds;
-  fd_set wfds;
-  fd_set efds;
+  /* poll has no FD_SETSIZE limit on the descriptor values, a process with
+   * thousands of connections has descriptors way above it */
+  struct pollfd pollfds[socket_events_array_size + 1];
 
-  FD_ZERO(&rfds);
-  FD_ZERO(&wfds);
-  FD_ZERO(&efds);
-
-  int max_fd_read = 0;
-  int max_fd_write = 0;
-  int max_fd_error = 0;
-
-  struct timeval tv = {0, 0};
-
-  /* translate the library socket events settings to the event sets used by
-   * posix select
-   */
+  /* translate the library socket events settings to the poll events */
   size_t socket_id = 0;
   for (socket_id = 0; socket_id < socket_events_array_size; ++socket_id) {
     iotc_bsp_socket_events_t* socket_events = &socket_events_array[socket_id];
@@ -237,47 +307,52 @@ iotc_bsp_io_net_state_t iotc_bsp_io_net_select(
       return IOTC_BSP_IO_NET_STATE_ERROR;
     }
 
+    pollfds[socket_id].events = 0;
+    pollfds[socket_id].revents = 0;
+
     if (1 == socket_events->in_socket_want_read) {
-      FD_SET(socket_events->iotc_socket, &rfds);
-      max_fd_read = socket_events->iotc_socket > max_fd_read
-                        ? socket_events->iotc_socket
-                        : max_fd_read;
+      pollfds[socket_id].events |= POLLIN;
     }
 
     if ((1 == socket_events->in_socket_want_write) ||
         (1 == socket_events->in_socket_want_connect)) {
-      FD_SET(socket_events->iotc_socket, &wfds);
-      max_fd_write = socket_events->iotc_socket > max_fd_write
-                         ? socket_events->iotc_socket
-                         : max_fd_write;
+      pollfds[socket_id].events |= POLLOUT;
     }
 
+    /* the exceptional condition of select */
     if (1 == socket_events->in_socket_want_error) {
-      FD_SET(socket_events->iotc_socket, &efds);
-      max_fd_error = socket_events->iotc_socket > max_fd_error
-                         ? socket_events->iotc_socket
-                         : max_fd_error;
+      pollfds[socket_id].events |= POLLPRI;
     }
-  }
 
-  /* calculate max fd */
-  const int max_fd = MAX(max_fd_read, MAX(max_fd_write, max_fd_error));
+    /* like select, ignore the sockets nothing is expected from, poll would
+     * report their hang ups */
+    pollfds[socket_id].fd =
+        0 != pollfds[socket_id].events ? socket_events->iotc_socket : -1;
+  }
 
-  tv.tv_sec = timeout_sec;
+  const int timeout_ms =
+      (int)IOTC_MIN(timeout_sec, (long)(INT_MAX / 1000)) * 1000;
 
-  /* call the actual posix select */
-  const int result = select(max_fd + 1, &rfds, &wfds, &efds, &tv);
+  /* call the actual posix poll */
+  const int result = poll(pollfds, socket_events_array_size, timeout_ms);
 
   if (0 < result) {
-    /* translate the result back to the socket events structure */
+    /* translate the result back to the socket events structure, errors and
+     * hang ups make a socket readable and writable as they do with select */
     for (socket_id = 0; socket_id < socket_events_array_size; ++socket_id) {
       iotc_bsp_socket_events_t* socket_events = &socket_events_array[socket_id];
+      const short revents = pollfds[socket_id].revents;
+
+      if (revents & POLLNVAL) {
+        return IOTC_BSP_IO_NET_STATE_ERROR;
+      }
 
-      if (FD_ISSET(socket_events->iotc_socket, &rfds)) {
+      if ((1 == socket_events->in_socket_want_read) &&
+          (revents & (POLLIN | POLLHUP | POLLERR))) {
         socket_events->out_socket_can_read = 1;
       }
 
-      if (FD_ISSET(socket_events->iotc_socket, &wfds)) {
+      if (revents & (POLLOUT | POLLHUP | POLLERR)) {
         if (1 == socket_events->in_socket_want_connect) {
           socket_events->out_socket_connect_finished = 1;
         }
@@ -287,7 +362,7 @@ iotc_bsp_io_net_state_t iotc_bsp_io_net_select(
         }
       }
 
-      if (FD_ISSET(socket_events->iotc_socket, &efds)) {
+      if (revents & POLLPRI) {
         socket_events->out_socket_error = 1;
       }
     }
@@ -32,9 +32,52 @@ int* z_impl_z_errno(void) {
 #define MAX(a, b) (((a) > (b)) ? (a) : (b))
 #endif
 
+/* Only the options the configured Zephyr network stack defines are set. */
+static void iotc_bsp_io_net_set_options(
+    int fd, iotc_bsp_socket_type_t socket_type,
+    const iotc_bsp_socket_options_t* options) {
+  int value = 0;
+
+  IOTC_UNUSED(fd);
+  IOTC_UNUSED(value);
+
+  if (NULL == options || SOCKET_STREAM != socket_type) {
+    return;
+  }
+
+#ifdef TCP_NODELAY
+  if (1 == options->tcp_nodelay) {
+    value = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &value, sizeof(value));
+  }
+#endif
+
+#ifdef SO_KEEPALIVE
+  if (1 == options->tcp_keepalive) {
+    value = 1;
+    setsockopt(fd, SOL_SOCKET, SO_KEEPALIVE, &value, sizeof(value));
+  }
+#endif
+
+#ifdef SO_SNDBUF
+  if (0 < options->send_buffer_size) {
+    value = (int)options->send_buffer_size;
+    setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &value, sizeof(value));
+  }
+#endif
+
+#ifdef SO_RCVBUF
+  if (0 < options->receive_buffer_size) {
+    value = (int)options->receive_buffer_size;
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &value, sizeof(value));
+  }
+#endif
+}
+
 iotc_bsp_io_net_state_t iotc_bsp_io_net_socket_connect(
     iotc_bsp_socket_t* iotc_socket, const char* host, uint16_t port,
-    iotc_bsp_socket_type_t socket_type) {
+    iotc_bsp_socket_type_t socket_type,
+    const iotc_bsp_socket_options_t* socket_options) {
   struct addrinfo hints;
   struct addrinfo *result, *rp = NULL;
   int status;
@@ -74,6 +117,8 @@ iotc_bsp_io_net_state_t iotc_bsp_io_net_socket_connect(
         break;
     }
 
+    iotc_bsp_io_net_set_options(*iotc_socket, socket_type, socket_options);
+
     // Attempt to connect.
     status = connect(*iotc_socket, rp->ai_addr, rp->ai_addrlen);
 
@@ -0,0 +1,219 @@
+/* Copyright 2018-2020 Google LLC
+ *
+ * This is part of the Google Cloud IoT Device SDK for Embedded C.
+ * It is licensed under the BSD 3-Clause license; you may not use this file
+ * except in compliance with the License.
+ *
+ * You may obtain a copy of the License at:
+ *  https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+#include "iotc_list.h"
+#include "iotc_vector.h"
+
+namespace iotctest {
+namespace {
+
+// The vectors of the event dispatcher hold one element per socket or time
+// event, a few dozen for a handful of connections.
+constexpr int kMaxVectorSize = 64;
+
+iotc_vector_selector_u MakeSelector(int32_t value) {
+  iotc_vector_selector_u selector;
+  selector.i32_value = value;
+  return selector;
+}
+
+int8_t CompareI32(const iotc_vector_selector_u* e0,
+                  const iotc_vector_selector_u* e1) {
+  return e0->i32_value < e1->i32_value
+             ? -1
+             : (e0->i32_value > e1->i32_value ? 1 : 0);
+}
+
+void Accumulate(iotc_vector_selector_u* element, void* arg) {
+  *static_cast<int64_t*>(arg) += element->i32_value;
+}
+
+void BM_VectorPush(benchmark::State& state) {
+  const int size = static_cast<int>(state.range(0));
+
+  for (auto _ : state) {
+    iotc_vector_t* vector = iotc_vector_create();
+    for (int i = 0; i < size; ++i) {
+      iotc_vector_push(vector, MakeSelector(i));
+    }
+    benchmark::DoNotOptimize(vector->elem_no);
+    iotc_vector_destroy(vector);
+  }
+
+  state.SetItemsProcessed(state.iterations() * size);
+}
+BENCHMARK(BM_VectorPush)->Arg(8)->Arg(32)->Arg(kMaxVectorSize);
+
+// Looks up the last element, the worst case of the linear search.
+void BM_VectorFind(benchmark::State& state) {
+  const int size = static_cast<int>(state.range(0));
+
+  iotc_vector_t* vector = iotc_vector_create();
+  for (int i = 0; i < size; ++i) {
+    iotc_vector_push(vector, MakeSelector(i));
+  }
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        iotc_vector_find(vector, MakeSelector(size - 1), &CompareI32));
+  }
+
+  iotc_vector_destroy(vector);
+}
+BENCHMARK(BM_VectorFind)->Arg(8)->Arg(32)->Arg(kMaxVectorSize);
+
+// Deletes and pushes back the first element so the size stays the same.
+void BM_VectorDelFirst(benchmark::State& state) {
+  const int size = static_cast<int>(state.range(0));
+
+  iotc_vector_t* vector = iotc_vector_create();
+  for (int i = 0; i < size; ++i) {
+    iotc_vector_push(vector, MakeSelector(i));
+  }
+
+  for (auto _ : state) {
+    const int32_t first = vector->array[0].selector_t.i32_value;
+    iotc_vector_del(vector, 0);
+    iotc_vector_push(vector, MakeSelector(first));
+  }
+
+  iotc_vector_destroy(vector);
+}
+BENCHMARK(BM_VectorDelFirst)->Arg(8)->Arg(32)->Arg(kMaxVectorSize);
+
+void BM_VectorForEach(benchmark::State& state) {
+  const int size = static_cast<int>(state.range(0));
+
+  iotc_vector_t* vector = iotc_vector_create();
+  for (int i = 0; i < size; ++i) {
+    iotc_vector_push(vector, MakeSelector(i));
+  }
+
+  for (auto _ : state) {
+    int64_t sum = 0;
+    iotc_vector_for_each(vector, &Accumulate, &sum, 0);
+    benchmark::DoNotOptimize(sum);
+  }
+
+  state.SetItemsProcessed(state.iterations() * size);
+  iotc_vector_destroy(vector);
+}
+BENCHMARK(BM_VectorForEach)->Arg(8)->Arg(32)->Arg(kMaxVectorSize);
+
+struct ListElement {
+  int value;
+  ListElement* __next;
+};
+
+bool HasValue(const ListElement* element, int value) {
+  return element->value == value;
+}
+
+void AccumulateListElement(ListElement* element, int64_t* sum) {
+  *sum += element->value;
+}
+
+// IOTC_LIST_PUSH_BACK walks the whole list, building one is quadratic.
+void BM_ListPushBack(benchmark::State& state) {
+  const int size = static_cast<int>(state.range(0));
+  std::vector<ListElement> elements(size);
+
+  for (auto _ : state) {
+    ListElement* list = nullptr;
+    for (int i = 0; i < size; ++i) {
+      ListElement* element = &elements[i];
+      element->value = i;
+      element->__next = nullptr;
+      IOTC_LIST_PUSH_BACK(ListElement, list, element);
+    }
+    benchmark::DoNotOptimize(list);
+  }
+
+  state.SetItemsProcessed(state.iterations() * size);
+}
+BENCHMARK(BM_ListPushBack)->Arg(8)->Arg(64)->Arg(512);
+
+void BM_ListPushFrontPop(benchmark::State& state) {
+  const int size = static_cast<int>(state.range(0));
+  std::vector<ListElement> elements(size);
+
+  for (auto _ : state) {
+    ListElement* list = nullptr;
+    for (int i = 0; i < size; ++i) {
+      ListElement* element = &elements[i];
+      element->value = i;
+      element->__next = nullptr;
+      IOTC_LIST_PUSH_FRONT(ListElement, list, element);
+    }
+    while (!IOTC_LIST_EMPTY(ListElement, list)) {
+      ListElement* element = nullptr;
+      IOTC_LIST_POP(ListElement, list, element);
+      benchmark::DoNotOptimize(element);
+    }
+  }
+
+  state.SetItemsProcessed(state.iterations() * size);
+}
+BENCHMARK(BM_ListPushFrontPop)->Arg(8)->Arg(64)->Arg(512);
+
+void BM_ListFindLast(benchmark::State& state) {
+  const int size = static_cast<int>(state.range(0));
+  std::vector<ListElement> elements(size);
+
+  ListElement* list = nullptr;
+  for (int i = size - 1; i >= 0; --i) {
+    ListElement* element = &elements[i];
+    element->value = i;
+    element->__next = nullptr;
+    IOTC_LIST_PUSH_FRONT(ListElement, list, element);
+  }
+
+  for (auto _ : state) {
+    ListElement* found = nullptr;
+    IOTC_LIST_FIND(ListElement, list, HasValue, size - 1, found);
+    benchmark::DoNotOptimize(found);
+  }
+}
+BENCHMARK(BM_ListFindLast)->Arg(8)->Arg(64)->Arg(512);
+
+void BM_ListForEach(benchmark::State& state) {
+  const int size = static_cast<int>(state.range(0));
+  std::vector<ListElement> elements(size);
+
+  ListElement* list = nullptr;
+  for (int i = size - 1; i >= 0; --i) {
+    ListElement* element = &elements[i];
+    element->value = i;
+    element->__next = nullptr;
+    IOTC_LIST_PUSH_FRONT(ListElement, list, element);
+  }
+
+  for (auto _ : state) {
+    int64_t sum = 0;
+    IOTC_LIST_FOREACH_WITH_ARG(ListElement, list, AccumulateListElement, &sum);
+    benchmark::DoNotOptimize(sum);
+  }
+
+  state.SetItemsProcessed(state.iterations() * size);
+}
+BENCHMARK(BM_ListForEach)->Arg(8)->Arg(64)->Arg(512);
+
+}  // namespace
+}  // namespace iotctest
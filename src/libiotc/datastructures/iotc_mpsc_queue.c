@@ -0,0 +1,117 @@
+/* Copyright 2018-2020 Google LLC
+ *
+ * This is part of the Google Cloud IoT Device SDK for Embedded C.
+ * It is licensed under the BSD 3-Clause license; you may not use this file
+ * except in compliance with the License.
+ *
+ * You may obtain a copy of the License at:
+ *  https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stddef.h>
+
+#include "iotc_debug.h"
+#include "iotc_mpsc_queue.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Without the thread module all the producers and the consumer run on the same
+ * thread, plain loads and stores are enough. */
+#if defined(IOTC_MODULE_THREAD_ENABLED) && defined(__GNUC__)
+#define iotc_mpsc_exchange(ptr, value) \
+  __atomic_exchange_n(ptr, value, __ATOMIC_ACQ_REL)
+#define iotc_mpsc_load(ptr) __atomic_load_n(ptr, __ATOMIC_ACQUIRE)
+#define iotc_mpsc_store(ptr, value) \
+  __atomic_store_n(ptr, value, __ATOMIC_RELEASE)
+#else
+static iotc_mpsc_queue_node_t* iotc_mpsc_exchange(
+    iotc_mpsc_queue_node_t* volatile* ptr, iotc_mpsc_queue_node_t* value) {
+  iotc_mpsc_queue_node_t* prev = *ptr;
+  *ptr = value;
+  return prev;
+}
+#define iotc_mpsc_load(ptr) (*(ptr))
+#define iotc_mpsc_store(ptr, value) (*(ptr) = (value))
+#endif
+
+void iotc_mpsc_queue_init(iotc_mpsc_queue_t* queue) {
+  assert(NULL != queue);
+
+  queue->stub.next = NULL;
+  queue->head = &queue->stub;
+  queue->tail = &queue->stub;
+}
+
+void iotc_mpsc_queue_push(iotc_mpsc_queue_t* queue,
+                          iotc_mpsc_queue_node_t* node) {
+  assert(NULL != queue);
+  assert(NULL != node);
+
+  node->next = NULL;
+
+  /* the exchange is the linearization point, between it and the store below
+   * the queue is temporarily cut and pop reports nothing to pop */
+  iotc_mpsc_queue_node_t* prev = iotc_mpsc_exchange(&queue->head, node);
+  iotc_mpsc_store(&prev->next, node);
+}
+
+iotc_mpsc_queue_node_t* iotc_mpsc_queue_pop(iotc_mpsc_queue_t* queue) {
+  assert(NULL != queue);
+
+  iotc_mpsc_queue_node_t* tail = queue->tail;
+  iotc_mpsc_queue_node_t* next = iotc_mpsc_load(&tail->next);
+
+  /* skip the stub */
+  if (&queue->stub == tail) {
+    if (NULL == next) {
+      return NULL;
+    }
+
+    iotc_mpsc_store(&queue->tail, next);
+    tail = next;
+    next = iotc_mpsc_load(&next->next);
+  }
+
+  if (NULL != next) {
+    iotc_mpsc_store(&queue->tail, next);
+    return tail;
+  }
+
+  /* a producer has already swapped the head but hasn't linked its node yet */
+  if (iotc_mpsc_load(&queue->head) != tail) {
+    return NULL;
+  }
+
+  /* tail is the last node, the stub is pushed behind it so that the tail
+   * never becomes NULL */
+  iotc_mpsc_queue_push(queue, &queue->stub);
+
+  next = iotc_mpsc_load(&tail->next);
+
+  if (NULL != next) {
+    iotc_mpsc_store(&queue->tail, next);
+    return tail;
+  }
+
+  return NULL;
+}
+
+uint8_t iotc_mpsc_queue_is_empty(iotc_mpsc_queue_t* queue) {
+  assert(NULL != queue);
+
+  iotc_mpsc_queue_node_t* tail = iotc_mpsc_load(&queue->tail);
+
+  return (&queue->stub == tail && NULL == iotc_mpsc_load(&tail->next)) ? 1 : 0;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,75 @@
+/* Copyright 2018-2020 Google LLC
+ *
+ * This is part of the Google Cloud IoT Device SDK for Embedded C.
+ * It is licensed under the BSD 3-Clause license; you may not use this file
+ * except in compliance with the License.
+ *
+ * You may obtain a copy of the License at:
+ *  https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __IOTC_MPSC_QUEUE_H__
+#define __IOTC_MPSC_QUEUE_H__
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Intrusive multi-producer/single-consumer queue.
+ *
+ * Any number of threads may push concurrently, push is wait-free and O(1).
+ * Only one thread at a time may pop; callers with several consumers have to
+ * serialize the pops themselves. Nodes are embedded in the queued elements
+ * and are never allocated nor freed by the queue.
+ *
+ * Pop may return NULL while a push is still in progress on another thread,
+ * the element becomes visible as soon as that push completes.
+ */
+typedef struct iotc_mpsc_queue_node_s {
+  struct iotc_mpsc_queue_node_s* volatile next;
+} iotc_mpsc_queue_node_t;
+
+typedef struct iotc_mpsc_queue_s {
+  iotc_mpsc_queue_node_t* volatile head; /* last pushed, shared by producers */
+  iotc_mpsc_queue_node_t* volatile tail; /* next to pop, owned by consumer */
+  iotc_mpsc_queue_node_t stub;
+} iotc_mpsc_queue_t;
+
+/**
+ * @brief initializes an empty queue, the queue must not be moved afterwards
+ * since it points to its own stub node
+ */
+extern void iotc_mpsc_queue_init(iotc_mpsc_queue_t* queue);
+
+/**
+ * @brief appends the node, safe to call from any thread
+ */
+extern void iotc_mpsc_queue_push(iotc_mpsc_queue_t* queue,
+                                 iotc_mpsc_queue_node_t* node);
+
+/**
+ * @brief removes the oldest node, consumer side only
+ *
+ * @return the node or NULL if there is nothing to pop yet
+ */
+extern iotc_mpsc_queue_node_t* iotc_mpsc_queue_pop(iotc_mpsc_queue_t* queue);
+
+/**
+ * @brief returns 1 if the consumer has nothing left to pop
+ */
+extern uint8_t iotc_mpsc_queue_is_empty(iotc_mpsc_queue_t* queue);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __IOTC_MPSC_QUEUE_H__ */
@@ -0,0 +1,116 @@
+/* Copyright 2018-2020 Google LLC
+ *
+ * This is part of the Google Cloud IoT Device SDK for Embedded C.
+ * It is licensed under the BSD 3-Clause license; you may not use this file
+ * except in compliance with the License.
+ *
+ * You may obtain a copy of the License at:
+ *  https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __IOTC_QUEUE_H__
+#define __IOTC_QUEUE_H__
+
+/* Intrusive doubly linked FIFO. The queue is a struct with `head` and `tail`
+ * pointers, the elements carry `__next` and `__prev` pointers. Push, pop and
+ * unlink are O(1). Since the elements are linked through `__next` the
+ * read-only IOTC_LIST_* macros (FIND, FOREACH, ...) can walk `queue.head`. */
+
+#define IOTC_QUEUE_INIT(queue) \
+  {                            \
+    (queue).head = NULL;       \
+    (queue).tail = NULL;       \
+  }
+
+#define IOTC_QUEUE_EMPTY(queue) (NULL == (queue).head)
+
+#define IOTC_QUEUE_PUSH_BACK(type, queue, elem) \
+  {                                             \
+    type* __elem = (elem);                      \
+    __elem->__next = NULL;                      \
+    __elem->__prev = (queue).tail;              \
+    if (NULL == (queue).tail) {                 \
+      (queue).head = __elem;                    \
+    } else {                                    \
+      (queue).tail->__next = __elem;            \
+    }                                           \
+    (queue).tail = __elem;                      \
+  }
+
+#define IOTC_QUEUE_PUSH_FRONT(type, queue, elem) \
+  {                                              \
+    type* __elem = (elem);                       \
+    __elem->__prev = NULL;                       \
+    __elem->__next = (queue).head;               \
+    if (NULL == (queue).head) {                  \
+      (queue).tail = __elem;                     \
+    } else {                                     \
+      (queue).head->__prev = __elem;             \
+    }                                            \
+    (queue).head = __elem;                       \
+  }
+
+/* an element which is not linked into the queue is left untouched */
+#define IOTC_QUEUE_UNLINK(type, queue, elem)                \
+  {                                                         \
+    type* __elem = (elem);                                  \
+    if (NULL != __elem->__prev || (queue).head == __elem) { \
+      if (NULL == __elem->__prev) {                         \
+        (queue).head = __elem->__next;                      \
+      } else {                                              \
+        __elem->__prev->__next = __elem->__next;            \
+      }                                                     \
+      if (NULL == __elem->__next) {                         \
+        (queue).tail = __elem->__prev;                      \
+      } else {                                              \
+        __elem->__next->__prev = __elem->__prev;            \
+      }                                                     \
+      __elem->__next = NULL;                                \
+      __elem->__prev = NULL;                                \
+    }                                                       \
+  }
+
+#define IOTC_QUEUE_POP_FRONT(type, queue, out) \
+  {                                            \
+    out = (queue).head;                        \
+    if (NULL != out) {                         \
+      IOTC_QUEUE_UNLINK(type, queue, out);     \
+    }                                          \
+  }
+
+/* moves the elements matching the predicate to the back of the out queue,
+ * keeping their order */
+#define IOTC_QUEUE_SPLIT_I(type, queue, pred, pred_params, out) \
+  {                                                             \
+    type* __curr = (queue).head;                                \
+    type* __tmp = NULL;                                         \
+    int __i = 0;                                                \
+    while (NULL != __curr) {                                    \
+      __tmp = __curr->__next;                                   \
+      if (pred((pred_params), __curr, __i++) == 1) {            \
+        IOTC_QUEUE_UNLINK(type, queue, __curr);                 \
+        IOTC_QUEUE_PUSH_BACK(type, out, __curr);                \
+      }                                                         \
+      __curr = __tmp;                                           \
+    }                                                           \
+  }
+
+/* takes over a NULL terminated list of elements which have been linked by a
+ * queue before, finding the tail is O(n) */
+#define IOTC_QUEUE_ATTACH(type, queue, list) \
+  {                                          \
+    (queue).head = (list);                   \
+    (queue).tail = (list);                   \
+    while (NULL != (queue).tail &&           \
+           NULL != (queue).tail->__next) {   \
+      (queue).tail = (queue).tail->__next;   \
+    }                                        \
+  }
+
+#endif /* __IOTC_QUEUE_H__ */
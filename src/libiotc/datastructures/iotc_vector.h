@@ -27,8 +27,9 @@
 extern "C" {
 #endif
 
-/* ! This type has to be SIGNED ! */
-typedef int8_t iotc_vector_index_type_t;
+/* ! This type has to be SIGNED ! It's wide enough for the sockets and time
+   events of thousands of connections on one event dispatcher. */
+typedef int32_t iotc_vector_index_type_t;
 
 union iotc_vector_selector_u {
   void* ptr_value;
@@ -0,0 +1,655 @@
+/* Copyright 2018-2020 Google LLC
+ *
+ * This is part of the Google Cloud IoT Device SDK for Embedded C.
+ * It is licensed under the BSD 3-Clause license; you may not use this file
+ * except in compliance with the License.
+ *
+ * You may obtain a copy of the License at:
+ *  https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "iotc_debug.h"
+#include "iotc_debug_log.h"
+#include "iotc_macros.h"
+
+#include <iotc_bsp_time.h>
+
+#ifdef IOTC_PLATFORM_BASE_POSIX
+#include <pthread.h>
+#endif
+
+#define IOTC_DEBUG_LOG_INDEX_MASK (IOTC_DEBUG_LOG_RING_SIZE - 1)
+
+/* a formatted line, longer messages are cut */
+#define IOTC_DEBUG_LOG_LINE_SIZE 256
+
+/* the longest conversion specification rewritten by the drain */
+#define IOTC_DEBUG_LOG_SPEC_SIZE 32
+
+/* Single producer, single consumer: only the owner thread moves the head and
+ * only the drain moves the tail. A thread that exits hands its ring back, the
+ * next owner appends to the records it left. */
+typedef struct iotc_debug_log_ring_s {
+  uint32_t head;
+  uint32_t tail;
+  uint8_t is_taken;
+  iotc_debug_log_record_t records[IOTC_DEBUG_LOG_RING_SIZE];
+} iotc_debug_log_ring_t;
+
+typedef enum iotc_debug_log_arg_e {
+  IOTC_DEBUG_LOG_ARG_NONE = 0,
+  IOTC_DEBUG_LOG_ARG_SIGNED,
+  IOTC_DEBUG_LOG_ARG_UNSIGNED,
+  IOTC_DEBUG_LOG_ARG_DOUBLE,
+  IOTC_DEBUG_LOG_ARG_POINTER,
+  IOTC_DEBUG_LOG_ARG_STRING,
+  /* %n, the argument is consumed but nothing is stored */
+  IOTC_DEBUG_LOG_ARG_SKIP
+} iotc_debug_log_arg_t;
+
+/* One parsed conversion specification of a format string. */
+typedef struct iotc_debug_log_spec_s {
+  const char* begin;
+  const char* end;
+  /* the number of '*' of the width and the precision */
+  uint8_t stars;
+  /* the length modifier, 'H' for hh and 'q' for ll */
+  char length;
+  char conversion;
+  iotc_debug_log_arg_t arg;
+} iotc_debug_log_spec_t;
+
+uint8_t iotc_debug_log_max_level = IOTC_DEBUG_LOG_LEVEL_DEBUG;
+static uint32_t iotc_debug_log_modules = IOTC_DEBUG_LOG_MODULE_ALL;
+
+static iotc_debug_log_ring_t iotc_debug_log_rings[IOTC_DEBUG_LOG_MAX_THREADS];
+static uint32_t iotc_debug_log_dropped = 0;
+
+#ifdef IOTC_PLATFORM_BASE_POSIX
+static __thread iotc_debug_log_ring_t* iotc_debug_log_thread_ring = NULL;
+
+/* its destructor hands the ring of an exiting thread back */
+static pthread_key_t iotc_debug_log_ring_key;
+static pthread_once_t iotc_debug_log_ring_key_once = PTHREAD_ONCE_INIT;
+
+static pthread_mutex_t iotc_debug_log_drain_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static void iotc_debug_log_release_ring(void* ring) {
+  iotc_debug_log_thread_ring = NULL;
+  __atomic_store_n(&((iotc_debug_log_ring_t*)ring)->is_taken, 0,
+                   __ATOMIC_RELEASE);
+}
+
+static void iotc_debug_log_create_ring_key(void) {
+  pthread_key_create(&iotc_debug_log_ring_key, &iotc_debug_log_release_ring);
+}
+
+static iotc_debug_log_ring_t* iotc_debug_log_take_ring(void) {
+  pthread_once(&iotc_debug_log_ring_key_once, &iotc_debug_log_create_ring_key);
+
+  size_t i = 0;
+  for (; i < IOTC_DEBUG_LOG_MAX_THREADS; ++i) {
+    iotc_debug_log_ring_t* ring = &iotc_debug_log_rings[i];
+    uint8_t is_taken = 0;
+
+    if (!__atomic_compare_exchange_n(&ring->is_taken, &is_taken, 1, 0,
+                                     __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+      continue;
+    }
+
+    if (0 != pthread_setspecific(iotc_debug_log_ring_key, ring)) {
+      __atomic_store_n(&ring->is_taken, 0, __ATOMIC_RELEASE);
+      return NULL;
+    }
+
+    return ring;
+  }
+
+  return NULL;
+}
+#endif
+
+static iotc_debug_log_ring_t* iotc_debug_log_get_ring(void) {
+#ifdef IOTC_PLATFORM_BASE_POSIX
+  /* a thread without a ring tries again on its next record */
+  if (NULL == iotc_debug_log_thread_ring) {
+    iotc_debug_log_thread_ring = iotc_debug_log_take_ring();
+  }
+
+  return iotc_debug_log_thread_ring;
+#else
+  return &iotc_debug_log_rings[0];
+#endif
+}
+
+static uint8_t iotc_debug_log_resolve_module(const char* file) {
+  static const struct {
+    const char* path;
+    iotc_debug_log_module_t module;
+  } modules[] = {{"/control_topic/", IOTC_DEBUG_LOG_MODULE_CONTROL_TOPIC},
+                 {"/mqtt", IOTC_DEBUG_LOG_MODULE_MQTT},
+                 {"/tls/", IOTC_DEBUG_LOG_MODULE_TLS},
+                 {"/io/", IOTC_DEBUG_LOG_MODULE_IO},
+                 {"/event_", IOTC_DEBUG_LOG_MODULE_EVENTS},
+                 {"/memory/", IOTC_DEBUG_LOG_MODULE_MEMORY},
+                 {"/platform/", IOTC_DEBUG_LOG_MODULE_PLATFORM}};
+
+  size_t i = 0;
+  for (; i < IOTC_ARRAYSIZE(modules); ++i) {
+    if (NULL != strstr(file, modules[i].path)) {
+      return (uint8_t)modules[i].module;
+    }
+  }
+
+  return IOTC_DEBUG_LOG_MODULE_CORE;
+}
+
+/* Parses the conversion specification that starts at the '%' pointed by
+ * format. */
+static void iotc_debug_log_parse_spec(const char* format,
+                                      iotc_debug_log_spec_t* spec) {
+  memset(spec, 0, sizeof(iotc_debug_log_spec_t));
+  spec->begin = format++;
+
+  /* flags, width and precision */
+  while ('\0' != *format && NULL != strchr("-+ #0123456789.*", *format)) {
+    if ('*' == *format) {
+      ++spec->stars;
+    }
+    ++format;
+  }
+
+  /* length modifier */
+  if ('h' == format[0] && 'h' == format[1]) {
+    spec->length = 'H';
+    format += 2;
+  } else if ('l' == format[0] && 'l' == format[1]) {
+    spec->length = 'q';
+    format += 2;
+  } else if ('\0' != *format && NULL != strchr("hljztLq", *format)) {
+    spec->length = ('q' == *format) ? 'q' : *format;
+    ++format;
+  }
+
+  spec->conversion = *format;
+  spec->end = ('\0' == *format) ? format : format + 1;
+
+  switch (spec->conversion) {
+    case 'd':
+    case 'i':
+    case 'c':
+      spec->arg = IOTC_DEBUG_LOG_ARG_SIGNED;
+      break;
+    case 'u':
+    case 'o':
+    case 'x':
+    case 'X':
+      spec->arg = IOTC_DEBUG_LOG_ARG_UNSIGNED;
+      break;
+    case 'e':
+    case 'E':
+    case 'f':
+    case 'F':
+    case 'g':
+    case 'G':
+    case 'a':
+    case 'A':
+      spec->arg = IOTC_DEBUG_LOG_ARG_DOUBLE;
+      break;
+    case 'p':
+      spec->arg = IOTC_DEBUG_LOG_ARG_POINTER;
+      break;
+    case 's':
+      spec->arg = IOTC_DEBUG_LOG_ARG_STRING;
+      break;
+    case 'n':
+      spec->arg = IOTC_DEBUG_LOG_ARG_SKIP;
+      break;
+    default:
+      /* %% or an unknown conversion, printed as it is */
+      spec->arg = IOTC_DEBUG_LOG_ARG_NONE;
+      break;
+  }
+}
+
+static int64_t iotc_debug_log_read_signed(char length, va_list* args) {
+  switch (length) {
+    case 'H':
+      return (signed char)va_arg(*args, int);
+    case 'h':
+      return (short)va_arg(*args, int);
+    case 'l':
+      return va_arg(*args, long);
+    case 'q':
+      return va_arg(*args, long long);
+    case 'j':
+      return va_arg(*args, intmax_t);
+    case 'z':
+      return (int64_t)va_arg(*args, size_t);
+    case 't':
+      return va_arg(*args, ptrdiff_t);
+    default:
+      return va_arg(*args, int);
+  }
+}
+
+static uint64_t iotc_debug_log_read_unsigned(char length, va_list* args) {
+  switch (length) {
+    case 'H':
+      return (unsigned char)va_arg(*args, unsigned int);
+    case 'h':
+      return (unsigned short)va_arg(*args, unsigned int);
+    case 'l':
+      return va_arg(*args, unsigned long);
+    case 'q':
+      return va_arg(*args, unsigned long long);
+    case 'j':
+      return va_arg(*args, uintmax_t);
+    case 'z':
+      return va_arg(*args, size_t);
+    case 't':
+      return (uint64_t)va_arg(*args, ptrdiff_t);
+    default:
+      return va_arg(*args, unsigned int);
+  }
+}
+
+static uint8_t iotc_debug_log_store(iotc_debug_log_record_t* record,
+                                    const void* value, size_t size) {
+  if ((size_t)(IOTC_DEBUG_LOG_ARGS_SIZE - record->args_length) < size) {
+    record->truncated = 1;
+    return 0;
+  }
+
+  memcpy(record->args + record->args_length, value, size);
+  record->args_length += (uint8_t)size;
+  return 1;
+}
+
+/* Copies the string into the record, bounded by the precision of the
+ * conversion so %.*s can point into buffers that aren't NUL-terminated. */
+static uint8_t iotc_debug_log_store_string(iotc_debug_log_record_t* record,
+                                           const char* string,
+                                           int64_t precision) {
+  if (NULL == string) {
+    string = "(null)";
+  }
+
+  size_t length = 0;
+  while ((0 > precision || (int64_t)length < precision) &&
+         '\0' != string[length]) {
+    ++length;
+  }
+
+  const size_t room = IOTC_DEBUG_LOG_ARGS_SIZE - record->args_length;
+  if (1 > room) {
+    record->truncated = 1;
+    return 0;
+  }
+
+  if (length > room - 1 || length > UINT8_MAX) {
+    length = IOTC_MIN(room - 1, UINT8_MAX);
+    record->truncated = 1;
+  }
+
+  record->args[record->args_length++] = (uint8_t)length;
+  memcpy(record->args + record->args_length, string, length);
+  record->args_length += (uint8_t)length;
+
+  return !record->truncated;
+}
+
+static void iotc_debug_log_capture(iotc_debug_log_record_t* record,
+                                   const char* format, va_list* args) {
+  while (NULL != (format = strchr(format, '%'))) {
+    iotc_debug_log_spec_t spec;
+    iotc_debug_log_parse_spec(format, &spec);
+    format = spec.end;
+
+    if (IOTC_DEBUG_LOG_ARG_NONE == spec.arg) {
+      continue;
+    }
+
+    /* the width and the precision given as arguments, the last one is the
+     * precision of a %.*s */
+    int64_t star = -1;
+    uint8_t i = 0;
+    for (; i < spec.stars; ++i) {
+      star = va_arg(*args, int);
+      if (!iotc_debug_log_store(record, &star, sizeof(star))) {
+        return;
+      }
+    }
+
+    int64_t value = 0;
+    double double_value = 0;
+
+    switch (spec.arg) {
+      case IOTC_DEBUG_LOG_ARG_SIGNED:
+        value = iotc_debug_log_read_signed(spec.length, args);
+        break;
+      case IOTC_DEBUG_LOG_ARG_UNSIGNED:
+        value = (int64_t)iotc_debug_log_read_unsigned(spec.length, args);
+        break;
+      case IOTC_DEBUG_LOG_ARG_DOUBLE:
+        double_value = ('L' == spec.length)
+                           ? (double)va_arg(*args, long double)
+                           : va_arg(*args, double);
+        break;
+      case IOTC_DEBUG_LOG_ARG_POINTER:
+      case IOTC_DEBUG_LOG_ARG_SKIP:
+        value = (int64_t)(uintptr_t)va_arg(*args, void*);
+        break;
+      case IOTC_DEBUG_LOG_ARG_STRING: {
+        const char* string = va_arg(*args, const char*);
+        const char* dot = memchr(spec.begin, '.', spec.end - spec.begin);
+        int64_t precision = -1;
+        if (NULL != dot) {
+          precision = ('*' == dot[1]) ? star : strtol(dot + 1, NULL, 10);
+        }
+        if (!iotc_debug_log_store_string(record, string, precision)) {
+          return;
+        }
+        continue;
+      }
+      default:
+        continue;
+    }
+
+    const uint8_t stored =
+        (IOTC_DEBUG_LOG_ARG_DOUBLE == spec.arg)
+            ? iotc_debug_log_store(record, &double_value, sizeof(double_value))
+            : (IOTC_DEBUG_LOG_ARG_SKIP == spec.arg)
+                  ? 1
+                  : iotc_debug_log_store(record, &value, sizeof(value));
+
+    if (!stored) {
+      return;
+    }
+  }
+}
+
+void iotc_debug_log_write(iotc_debug_log_site_t* site, const char* format,
+                          ...) {
+  if (0 == site->module) {
+    site->module = iotc_debug_log_resolve_module(site->file);
+  }
+
+  if (0 == (site->module &
+            __atomic_load_n(&iotc_debug_log_modules, __ATOMIC_RELAXED))) {
+    return;
+  }
+
+  iotc_debug_log_ring_t* ring = iotc_debug_log_get_ring();
+  const uint32_t head = (NULL != ring) ? ring->head : 0;
+
+  if (NULL == ring ||
+      IOTC_DEBUG_LOG_RING_SIZE ==
+          head - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE)) {
+    __atomic_fetch_add(&iotc_debug_log_dropped, 1, __ATOMIC_RELAXED);
+    return;
+  }
+
+  iotc_debug_log_record_t* record =
+      &ring->records[head & IOTC_DEBUG_LOG_INDEX_MASK];
+  record->site = site;
+  record->timestamp_ms = iotc_bsp_time_getcurrenttime_milliseconds();
+  record->args_length = 0;
+  record->truncated = 0;
+
+  va_list args;
+  va_start(args, format);
+  iotc_debug_log_capture(record, format, &args);
+  va_end(args);
+
+  __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+}
+
+uint8_t iotc_debug_log_is_enabled(iotc_debug_log_level_t level,
+                                  uint32_t modules) {
+  return level <= iotc_debug_log_max_level &&
+         0 != (modules &
+               __atomic_load_n(&iotc_debug_log_modules, __ATOMIC_RELAXED));
+}
+
+void iotc_debug_log_set_filter(iotc_debug_log_level_t max_level,
+                               uint32_t modules) {
+  __atomic_store_n(&iotc_debug_log_modules, modules, __ATOMIC_RELAXED);
+  __atomic_store_n(&iotc_debug_log_max_level, (uint8_t)max_level,
+                   __ATOMIC_RELAXED);
+}
+
+static int64_t iotc_debug_log_load(const iotc_debug_log_record_t* record,
+                                   size_t* offset) {
+  int64_t value = 0;
+  memcpy(&value, record->args + *offset, sizeof(value));
+  *offset += sizeof(value);
+  return value;
+}
+
+/* Rewrites the specification with the stored width and precision in place of
+ * the stars and the 64 bit length modifier in place of the original one. */
+static void iotc_debug_log_rewrite_spec(const iotc_debug_log_spec_t* spec,
+                                        const int64_t* stars, char* out) {
+  char* const out_end = out + IOTC_DEBUG_LOG_SPEC_SIZE - 4;
+  const char* in = spec->begin;
+  uint8_t star = 0;
+
+  for (; in < spec->end - 1 && out < out_end; ++in) {
+    if ('*' == *in) {
+      const uint8_t precision = ('.' == in[-1]);
+      if (precision && 0 > stars[star]) {
+        /* a negative precision is taken as if it was omitted */
+        --out;
+      } else {
+        out += snprintf(out, out_end - out, "%d", (int)stars[star]);
+      }
+      ++star;
+    } else if (NULL == strchr("hljztLq", *in)) {
+      *out++ = *in;
+    }
+  }
+
+  if (IOTC_DEBUG_LOG_ARG_SIGNED == spec->arg && 'c' != spec->conversion) {
+    *out++ = 'l';
+    *out++ = 'l';
+  } else if (IOTC_DEBUG_LOG_ARG_UNSIGNED == spec->arg) {
+    *out++ = 'l';
+    *out++ = 'l';
+  }
+
+  *out++ = spec->conversion;
+  *out = '\0';
+}
+
+static size_t iotc_debug_log_format(const iotc_debug_log_record_t* record,
+                                    char* line, size_t size) {
+  const char* format = record->site->format;
+  size_t offset = 0;
+  size_t length = 0;
+
+#define IOTC_DEBUG_LOG_APPEND(...)                                       \
+  if (length < size) {                                                   \
+    const int written =                                                  \
+        snprintf(line + length, size - length, __VA_ARGS__);             \
+    length += (0 < written) ? (size_t)written : 0;                       \
+  }
+
+  while ('\0' != *format) {
+    const char* percent = strchr(format, '%');
+    const size_t literal =
+        (NULL == percent) ? strlen(format) : (size_t)(percent - format);
+
+    IOTC_DEBUG_LOG_APPEND("%.*s", (int)literal, format);
+    if (NULL == percent) {
+      break;
+    }
+
+    iotc_debug_log_spec_t spec;
+    iotc_debug_log_parse_spec(percent, &spec);
+    format = spec.end;
+
+    if (IOTC_DEBUG_LOG_ARG_NONE == spec.arg) {
+      IOTC_DEBUG_LOG_APPEND("%s", '%' == spec.conversion ? "%" : "");
+      continue;
+    }
+
+    /* nothing more was stored */
+    const size_t needed =
+        spec.stars * sizeof(int64_t) +
+        ((IOTC_DEBUG_LOG_ARG_STRING == spec.arg)
+             ? 1
+             : (IOTC_DEBUG_LOG_ARG_SKIP == spec.arg) ? 0 : sizeof(int64_t));
+    if (offset + needed > record->args_length) {
+      break;
+    }
+
+    int64_t stars[2] = {0, 0};
+    uint8_t i = 0;
+    for (; i < spec.stars && i < 2; ++i) {
+      stars[i] = iotc_debug_log_load(record, &offset);
+    }
+
+    char rewritten[IOTC_DEBUG_LOG_SPEC_SIZE] = {0};
+    iotc_debug_log_rewrite_spec(&spec, stars, rewritten);
+
+    switch (spec.arg) {
+      case IOTC_DEBUG_LOG_ARG_SIGNED: {
+        const int64_t value = iotc_debug_log_load(record, &offset);
+        if ('c' == spec.conversion) {
+          IOTC_DEBUG_LOG_APPEND(rewritten, (int)value);
+        } else {
+          IOTC_DEBUG_LOG_APPEND(rewritten, (long long)value);
+        }
+        break;
+      }
+      case IOTC_DEBUG_LOG_ARG_UNSIGNED: {
+        const int64_t value = iotc_debug_log_load(record, &offset);
+        IOTC_DEBUG_LOG_APPEND(rewritten, (unsigned long long)value);
+        break;
+      }
+      case IOTC_DEBUG_LOG_ARG_DOUBLE: {
+        double value = 0;
+        memcpy(&value, record->args + offset, sizeof(value));
+        offset += sizeof(value);
+        IOTC_DEBUG_LOG_APPEND(rewritten, value);
+        break;
+      }
+      case IOTC_DEBUG_LOG_ARG_POINTER:
+        IOTC_DEBUG_LOG_APPEND(
+            rewritten, (void*)(uintptr_t)iotc_debug_log_load(record, &offset));
+        break;
+      case IOTC_DEBUG_LOG_ARG_STRING: {
+        char string[IOTC_DEBUG_LOG_ARGS_SIZE] = {0};
+        const uint8_t string_length = record->args[offset++];
+        memcpy(string, record->args + offset, string_length);
+        offset += string_length;
+        IOTC_DEBUG_LOG_APPEND(rewritten, string);
+        break;
+      }
+      default:
+        break;
+    }
+  }
+
+  if (record->truncated) {
+    IOTC_DEBUG_LOG_APPEND("...");
+  }
+
+#undef IOTC_DEBUG_LOG_APPEND
+
+  return IOTC_MIN(length, size - 1);
+}
+
+iotc_state_t iotc_debug_log_drain(iotc_debug_log_writer_t* writer,
+                                  void* user_data) {
+  if (NULL == writer) {
+    return IOTC_INVALID_PARAMETER;
+  }
+
+  char line[IOTC_DEBUG_LOG_LINE_SIZE] = {0};
+
+#ifdef IOTC_PLATFORM_BASE_POSIX
+  /* the tails have a single consumer */
+  pthread_mutex_lock(&iotc_debug_log_drain_mutex);
+#endif
+
+  const uint32_t dropped =
+      __atomic_exchange_n(&iotc_debug_log_dropped, 0, __ATOMIC_RELAXED);
+  if (0 < dropped) {
+    const int length = snprintf(line, sizeof(line),
+                                "[%lu debug log records dropped]\n",
+                                (unsigned long)dropped);
+    writer(line, (size_t)length, user_data);
+  }
+
+  /* merges the rings by time, the records of one ring are in order */
+  for (;;) {
+    iotc_debug_log_ring_t* oldest = NULL;
+    const iotc_debug_log_record_t* oldest_record = NULL;
+
+    size_t i = 0;
+    for (; i < IOTC_DEBUG_LOG_MAX_THREADS; ++i) {
+      iotc_debug_log_ring_t* ring = &iotc_debug_log_rings[i];
+      const uint32_t tail = ring->tail;
+      if (tail == __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE)) {
+        continue;
+      }
+
+      const iotc_debug_log_record_t* record =
+          &ring->records[tail & IOTC_DEBUG_LOG_INDEX_MASK];
+      if (NULL == oldest_record ||
+          record->timestamp_ms < oldest_record->timestamp_ms) {
+        oldest = ring;
+        oldest_record = record;
+      }
+    }
+
+    if (NULL == oldest) {
+      break;
+    }
+
+    const iotc_debug_log_site_t* site = oldest_record->site;
+    size_t length = 0;
+
+    if (0 == site->raw) {
+      const int written = snprintf(
+          line, sizeof(line), "[%lld][%s:%d (%s)] ",
+          (long long)oldest_record->timestamp_ms,
+          iotc_debug_dont_print_the_path(site->file), site->line, site->func);
+      length = IOTC_MIN((size_t)written, sizeof(line) - 1);
+    }
+
+    length += iotc_debug_log_format(oldest_record, line + length,
+                                    sizeof(line) - length);
+
+    if (0 == site->raw) {
+      if (length == sizeof(line) - 1) {
+        --length;
+      }
+      line[length++] = '\n';
+    }
+
+    writer(line, length, user_data);
+
+    __atomic_store_n(&oldest->tail, oldest->tail + 1, __ATOMIC_RELEASE);
+  }
+
+#ifdef IOTC_PLATFORM_BASE_POSIX
+  pthread_mutex_unlock(&iotc_debug_log_drain_mutex);
+#endif
+
+  return IOTC_STATE_OK;
+}
@@ -0,0 +1,110 @@
+/* Copyright 2018-2020 Google LLC
+ *
+ * This is part of the Google Cloud IoT Device SDK for Embedded C.
+ * It is licensed under the BSD 3-Clause license; you may not use this file
+ * except in compliance with the License.
+ *
+ * You may obtain a copy of the License at:
+ *  https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __IOTC_DEBUG_LOG_H__
+#define __IOTC_DEBUG_LOG_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "iotc_time.h"
+#include "iotc_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Number of records in the ring of each thread, must be a power of two.
+ * Records logged while the ring is full are dropped and counted. */
+#ifndef IOTC_DEBUG_LOG_RING_SIZE
+#define IOTC_DEBUG_LOG_RING_SIZE 64
+#endif
+
+#if (IOTC_DEBUG_LOG_RING_SIZE & (IOTC_DEBUG_LOG_RING_SIZE - 1))
+#error "IOTC_DEBUG_LOG_RING_SIZE must be a power of two"
+#endif
+
+/* Number of threads that have a ring at the same time, the records of the
+ * others are dropped. A thread's ring is handed to another one when it exits.
+ * Without POSIX thread-local storage all threads share the first ring. */
+#ifndef IOTC_DEBUG_LOG_MAX_THREADS
+#define IOTC_DEBUG_LOG_MAX_THREADS 8
+#endif
+
+/* Room for the raw arguments of one record, longer strings are cut. */
+#ifndef IOTC_DEBUG_LOG_ARGS_SIZE
+#define IOTC_DEBUG_LOG_ARGS_SIZE 96
+#endif
+
+/* A log statement. The macros of iotc_debug.h keep one static instance per
+ * call site, its address identifies the format string of the records. */
+typedef struct iotc_debug_log_site_s {
+  const char* format;
+  const char* file;
+  const char* func;
+  int line;
+  uint8_t level;
+  /* printed without the time and location prefix */
+  uint8_t raw;
+  /* one of iotc_debug_log_module_t, resolved from the file path on the first
+   * call */
+  uint8_t module;
+} iotc_debug_log_site_t;
+
+typedef struct iotc_debug_log_record_s {
+  const iotc_debug_log_site_t* site;
+  iotc_time_t timestamp_ms;
+  uint8_t args_length;
+  /* the arguments didn't fit, the message is cut after the last one stored */
+  uint8_t truncated;
+  uint8_t args[IOTC_DEBUG_LOG_ARGS_SIZE];
+} iotc_debug_log_record_t;
+
+/* Checked by the macros before the arguments are recorded. */
+extern uint8_t iotc_debug_log_max_level;
+
+/**
+ * @brief iotc_debug_log_write
+ *
+ * Stores the site and the raw arguments in the ring of the calling thread.
+ * The arguments are read according to the conversions of the site's format,
+ * strings are copied.
+ */
+void iotc_debug_log_write(iotc_debug_log_site_t* site, const char* format,
+                          ...);
+
+/* Tells whether a statement of the given level and module would be recorded,
+ * lets expensive dumps bail out early. */
+uint8_t iotc_debug_log_is_enabled(iotc_debug_log_level_t level,
+                                  uint32_t modules);
+
+void iotc_debug_log_set_filter(iotc_debug_log_level_t max_level,
+                               uint32_t modules);
+
+/**
+ * @brief iotc_debug_log_drain
+ *
+ * Formats the pending records of all the rings, oldest first, and passes them
+ * to the writer one line at a time. Concurrent calls are serialized.
+ */
+iotc_state_t iotc_debug_log_drain(iotc_debug_log_writer_t* writer,
+                                  void* user_data);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __IOTC_DEBUG_LOG_H__ */
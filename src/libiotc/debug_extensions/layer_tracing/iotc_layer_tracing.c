@@ -0,0 +1,371 @@
+/* Copyright 2018-2020 Google LLC
+ *
+ * This is part of the Google Cloud IoT Device SDK for Embedded C.
+ * It is licensed under the BSD 3-Clause license; you may not use this file
+ * except in compliance with the License.
+ *
+ * You may obtain a copy of the License at:
+ *  https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef IOTC_PLATFORM_BASE_POSIX
+#include <time.h>
+#endif
+
+#include "iotc_layer_api.h"
+#include "iotc_layer_tracing.h"
+#include "iotc_layers_ids.h"
+#include "iotc_macros.h"
+
+#include <iotc_bsp_time.h>
+
+#define IOTC_LAYER_TRACING_INDEX_MASK (IOTC_LAYER_TRACING_BUFFER_SIZE - 1)
+
+/* contexts told apart in an export, the ones above share the last pid */
+#define IOTC_LAYER_TRACING_MAX_EXPORTED_CONTEXTS 8
+
+/* big enough for the longest event the export writes */
+#define IOTC_LAYER_TRACING_CHUNK_SIZE 256
+
+/* The ring is shared by all the contexts. Writers claim a slot with an atomic
+ * increment of the head and publish the record with a release store of its
+ * seq, so tracing doesn't need a lock on the event dispatcher threads. */
+static iotc_layer_tracing_record_t
+    iotc_layer_tracing_ring[IOTC_LAYER_TRACING_BUFFER_SIZE];
+static uint32_t iotc_layer_tracing_head = 0;
+
+static const char* const iotc_layer_tracing_layer_names[] = {
+    [IOTC_LAYER_TYPE_IO] = "io",
+#ifndef IOTC_NO_TLS_LAYER
+    [IOTC_LAYER_TYPE_TLS] = "tls",
+#endif
+    [IOTC_LAYER_TYPE_MQTT_CODEC] = "mqtt codec",
+    [IOTC_LAYER_TYPE_MQTT_LOGIC] = "mqtt logic",
+    [IOTC_LAYER_TYPE_CONTROL_TOPIC] = "control topic"};
+
+static const char* const iotc_layer_tracing_func_names[] = {
+    [IOTC_LAYER_TRACING_FUNC_PUSH] = "push",
+    [IOTC_LAYER_TRACING_FUNC_PULL] = "pull",
+    [IOTC_LAYER_TRACING_FUNC_CLOSE] = "close",
+    [IOTC_LAYER_TRACING_FUNC_CLOSE_EXTERNALLY] = "close externally",
+    [IOTC_LAYER_TRACING_FUNC_INIT] = "init",
+    [IOTC_LAYER_TRACING_FUNC_CONNECT] = "connect",
+    [IOTC_LAYER_TRACING_FUNC_POST_CONNECT] = "post connect",
+    [IOTC_LAYER_TRACING_FUNC_UNKNOWN] = "unknown"};
+
+static int64_t iotc_layer_tracing_now_us(void) {
+#ifdef IOTC_PLATFORM_BASE_POSIX
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (int64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+#else
+  return (int64_t)iotc_bsp_time_getcurrenttime_milliseconds() * 1000;
+#endif
+}
+
+static const char* iotc_layer_tracing_layer_name(uint8_t layer) {
+  if (layer < IOTC_ARRAYSIZE(iotc_layer_tracing_layer_names) &&
+      NULL != iotc_layer_tracing_layer_names[layer]) {
+    return iotc_layer_tracing_layer_names[layer];
+  }
+
+  return "unknown";
+}
+
+static iotc_layer_tracing_func_t iotc_layer_tracing_func_kind(
+    iotc_layer_func_t* func, const iotc_layer_t* layer) {
+  const iotc_layer_interface_t* funcs = layer->layer_funcs;
+
+  if (func == funcs->push) {
+    return IOTC_LAYER_TRACING_FUNC_PUSH;
+  } else if (func == funcs->pull) {
+    return IOTC_LAYER_TRACING_FUNC_PULL;
+  } else if (func == funcs->close) {
+    return IOTC_LAYER_TRACING_FUNC_CLOSE;
+  } else if (func == funcs->close_externally) {
+    return IOTC_LAYER_TRACING_FUNC_CLOSE_EXTERNALLY;
+  } else if (func == funcs->init) {
+    return IOTC_LAYER_TRACING_FUNC_INIT;
+  } else if (func == funcs->connect) {
+    return IOTC_LAYER_TRACING_FUNC_CONNECT;
+  } else if (func == funcs->post_connect) {
+    return IOTC_LAYER_TRACING_FUNC_POST_CONNECT;
+  }
+
+  return IOTC_LAYER_TRACING_FUNC_UNKNOWN;
+}
+
+/* Returns the seq of the written record, which doubles as the flow id of an
+ * enqueue. */
+static uint32_t iotc_layer_tracing_record(iotc_layer_tracing_phase_t phase,
+                                          iotc_layer_tracing_func_t func,
+                                          uint8_t from_layer, uint8_t to_layer,
+                                          const void* context_data,
+                                          const void* data, iotc_state_t state,
+                                          uint32_t flow_id) {
+  const uint32_t index =
+      __atomic_fetch_add(&iotc_layer_tracing_head, 1, __ATOMIC_RELAXED);
+  iotc_layer_tracing_record_t* record =
+      &iotc_layer_tracing_ring[index & IOTC_LAYER_TRACING_INDEX_MASK];
+
+  /* readers skip the record until it is published again */
+  __atomic_store_n(&record->seq, 0, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+
+  record->flow_id = (IOTC_LAYER_TRACING_PHASE_ENQUEUE == phase) ? index + 1
+                                                                : flow_id;
+  record->timestamp_us = iotc_layer_tracing_now_us();
+  record->context_data = context_data;
+  record->data = data;
+  record->state = state;
+  record->phase = (uint8_t)phase;
+  record->func = (uint8_t)func;
+  record->from_layer = from_layer;
+  record->to_layer = to_layer;
+
+  __atomic_store_n(&record->seq, index + 1, __ATOMIC_RELEASE);
+
+  return index + 1;
+}
+
+/* Runs in place of the layer function and records around it. The layer may
+ * be gone once the function returns, so everything the end record needs is
+ * read beforehand. */
+static iotc_state_t iotc_layer_tracing_call(void* context, void* data,
+                                            iotc_state_t state, void* func,
+                                            void* flow_id) {
+  iotc_layer_func_t* layer_func = (iotc_layer_func_t*)func;
+  const iotc_layer_t* layer = IOTC_THIS_LAYER(context);
+  const uint8_t layer_id = layer->layer_type_id;
+  const void* context_data = layer->context_data;
+  const iotc_layer_tracing_func_t func_kind =
+      iotc_layer_tracing_func_kind(layer_func, layer);
+  const uint32_t flow = (uint32_t)(uintptr_t)flow_id;
+
+  iotc_layer_tracing_record(IOTC_LAYER_TRACING_PHASE_BEGIN, func_kind,
+                            layer_id, layer_id, context_data, data, state,
+                            flow);
+
+  const iotc_state_t ret = layer_func(context, data, state);
+
+  iotc_layer_tracing_record(IOTC_LAYER_TRACING_PHASE_END, func_kind, layer_id,
+                            layer_id, context_data, data, ret, flow);
+
+  return ret;
+}
+
+iotc_event_handle_t iotc_layer_tracing_make_handle(iotc_layer_func_t* func,
+                                                   void* from_context,
+                                                   void* context, void* data,
+                                                   iotc_state_t state) {
+  const iotc_layer_t* layer = IOTC_THIS_LAYER(context);
+
+  const uint32_t flow_id = iotc_layer_tracing_record(
+      IOTC_LAYER_TRACING_PHASE_ENQUEUE,
+      iotc_layer_tracing_func_kind(func, layer),
+      IOTC_THIS_LAYER(from_context)->layer_type_id, layer->layer_type_id,
+      layer->context_data, data, state, 0);
+
+  return iotc_make_handle(&iotc_layer_tracing_call, context, data, state,
+                          (void*)func, (void*)(uintptr_t)flow_id);
+}
+
+/* Copies the record at the given position, fails if it is being written or
+ * has been overwritten meanwhile. */
+static int iotc_layer_tracing_read(uint32_t index,
+                                   iotc_layer_tracing_record_t* out) {
+  const iotc_layer_tracing_record_t* record =
+      &iotc_layer_tracing_ring[index & IOTC_LAYER_TRACING_INDEX_MASK];
+
+  const uint32_t seq_before = __atomic_load_n(&record->seq, __ATOMIC_ACQUIRE);
+  if (seq_before != index + 1) {
+    return 0;
+  }
+
+  memcpy(out, record, sizeof(iotc_layer_tracing_record_t));
+  __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+  return __atomic_load_n(&record->seq, __ATOMIC_RELAXED) == seq_before;
+}
+
+typedef struct iotc_layer_tracing_export_s {
+  iotc_layer_trace_writer_t* writer;
+  void* user_data;
+  const void* contexts[IOTC_LAYER_TRACING_MAX_EXPORTED_CONTEXTS];
+  uint8_t context_count;
+  uint8_t first_event;
+} iotc_layer_tracing_export_t;
+
+static void iotc_layer_tracing_write(iotc_layer_tracing_export_t* export,
+                                     const char* format, ...) {
+  char chunk[IOTC_LAYER_TRACING_CHUNK_SIZE] = {0};
+
+  /* events are separated by a comma */
+  int length = 0;
+  if (0 == export->first_event) {
+    chunk[length++] = ',';
+  }
+  export->first_event = 0;
+
+  va_list args;
+  va_start(args, format);
+  const int written =
+      vsnprintf(chunk + length, sizeof(chunk) - length, format, args);
+  va_end(args);
+
+  if (written < 0) {
+    return;
+  }
+
+  length += written;
+  if ((size_t)length >= sizeof(chunk)) {
+    length = sizeof(chunk) - 1;
+  }
+
+  export->writer(chunk, (size_t)length, export->user_data);
+}
+
+/* Maps a context to a Chrome trace process, naming the process and its layer
+ * threads the first time the context shows up. */
+static int iotc_layer_tracing_pid(iotc_layer_tracing_export_t* export,
+                                  const void* context_data) {
+  uint8_t i = 0;
+  for (; i < export->context_count; ++i) {
+    if (export->contexts[i] == context_data) {
+      return i + 1;
+    }
+  }
+
+  if (export->context_count == IOTC_LAYER_TRACING_MAX_EXPORTED_CONTEXTS) {
+    return IOTC_LAYER_TRACING_MAX_EXPORTED_CONTEXTS;
+  }
+
+  export->contexts[export->context_count++] = context_data;
+  const int pid = export->context_count;
+
+  iotc_layer_tracing_write(export,
+                           "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,"
+                           "\"args\":{\"name\":\"iotc context %p\"}}",
+                           pid, context_data);
+
+  size_t layer = 0;
+  for (; layer < IOTC_ARRAYSIZE(iotc_layer_tracing_layer_names); ++layer) {
+    if (NULL == iotc_layer_tracing_layer_names[layer]) {
+      continue;
+    }
+
+    iotc_layer_tracing_write(
+        export,
+        "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,"
+        "\"args\":{\"name\":\"%s layer\"}}",
+        pid, (int)layer, iotc_layer_tracing_layer_names[layer]);
+    iotc_layer_tracing_write(
+        export,
+        "{\"name\":\"thread_sort_index\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,"
+        "\"args\":{\"sort_index\":%d}}",
+        pid, (int)layer, (int)layer);
+  }
+
+  return pid;
+}
+
+static void iotc_layer_tracing_export_record(
+    iotc_layer_tracing_export_t* export,
+    const iotc_layer_tracing_record_t* record) {
+  const int pid = iotc_layer_tracing_pid(export, record->context_data);
+  const char* layer_name = iotc_layer_tracing_layer_name(record->to_layer);
+  const char* func_name = iotc_layer_tracing_func_names[record->func];
+
+  switch (record->phase) {
+    case IOTC_LAYER_TRACING_PHASE_ENQUEUE:
+      /* the queueing time shows as an arrow from the layer that asked for
+       * the transition to the slice of the target layer */
+      iotc_layer_tracing_write(
+          export,
+          "{\"name\":\"%s %s\",\"cat\":\"queue\",\"ph\":\"s\",\"id\":%u,"
+          "\"ts\":%lld,\"pid\":%d,\"tid\":%d}",
+          layer_name, func_name, record->flow_id,
+          (long long)record->timestamp_us, pid, (int)record->from_layer);
+      break;
+    case IOTC_LAYER_TRACING_PHASE_BEGIN:
+      iotc_layer_tracing_write(
+          export,
+          "{\"name\":\"%s %s\",\"cat\":\"queue\",\"ph\":\"f\",\"bp\":\"e\","
+          "\"id\":%u,\"ts\":%lld,\"pid\":%d,\"tid\":%d}",
+          layer_name, func_name, record->flow_id,
+          (long long)record->timestamp_us, pid, (int)record->to_layer);
+      iotc_layer_tracing_write(
+          export,
+          "{\"name\":\"%s %s\",\"cat\":\"layer\",\"ph\":\"B\",\"ts\":%lld,"
+          "\"pid\":%d,\"tid\":%d,\"args\":{\"data\":\"%p\",\"state\":%d}}",
+          layer_name, func_name, (long long)record->timestamp_us, pid,
+          (int)record->to_layer, record->data, (int)record->state);
+      break;
+    case IOTC_LAYER_TRACING_PHASE_END:
+      iotc_layer_tracing_write(
+          export,
+          "{\"name\":\"%s %s\",\"cat\":\"layer\",\"ph\":\"E\",\"ts\":%lld,"
+          "\"pid\":%d,\"tid\":%d,\"args\":{\"state\":%d}}",
+          layer_name, func_name, (long long)record->timestamp_us, pid,
+          (int)record->to_layer, (int)record->state);
+      break;
+  }
+}
+
+iotc_state_t iotc_layer_tracing_export(iotc_layer_trace_writer_t* writer,
+                                       void* user_data) {
+  if (NULL == writer) {
+    return IOTC_INVALID_PARAMETER;
+  }
+
+  iotc_layer_tracing_export_t export;
+  memset(&export, 0, sizeof(export));
+  export.writer = writer;
+  export.user_data = user_data;
+  export.first_event = 1;
+
+  static const char header[] = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+  static const char footer[] = "]}\n";
+
+  writer(header, sizeof(header) - 1, user_data);
+
+  const uint32_t head =
+      __atomic_load_n(&iotc_layer_tracing_head, __ATOMIC_ACQUIRE);
+  uint32_t index = (head > IOTC_LAYER_TRACING_BUFFER_SIZE)
+                       ? head - IOTC_LAYER_TRACING_BUFFER_SIZE
+                       : 0;
+
+  for (; index != head; ++index) {
+    iotc_layer_tracing_record_t record;
+    if (iotc_layer_tracing_read(index, &record)) {
+      iotc_layer_tracing_export_record(&export, &record);
+    }
+  }
+
+  writer(footer, sizeof(footer) - 1, user_data);
+
+  return IOTC_STATE_OK;
+}
+
+void iotc_layer_tracing_clear(void) {
+  size_t i = 0;
+  for (; i < IOTC_LAYER_TRACING_BUFFER_SIZE; ++i) {
+    __atomic_store_n(&iotc_layer_tracing_ring[i].seq, 0, __ATOMIC_RELAXED);
+  }
+
+  __atomic_store_n(&iotc_layer_tracing_head, 0, __ATOMIC_RELEASE);
+}
+
+uint32_t iotc_layer_tracing_get_record_count(void) {
+  return __atomic_load_n(&iotc_layer_tracing_head, __ATOMIC_ACQUIRE);
+}
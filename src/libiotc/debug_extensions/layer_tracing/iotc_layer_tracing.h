@@ -0,0 +1,107 @@
+/* Copyright 2018-2020 Google LLC
+ *
+ * This is part of the Google Cloud IoT Device SDK for Embedded C.
+ * It is licensed under the BSD 3-Clause license; you may not use this file
+ * except in compliance with the License.
+ *
+ * You may obtain a copy of the License at:
+ *  https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __IOTC_LAYER_TRACING_H__
+#define __IOTC_LAYER_TRACING_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "iotc_event_handle.h"
+#include "iotc_layer.h"
+#include "iotc_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Number of records kept by the trace ring, must be a power of two. Once the
+ * ring is full the oldest records are overwritten. */
+#ifndef IOTC_LAYER_TRACING_BUFFER_SIZE
+#define IOTC_LAYER_TRACING_BUFFER_SIZE 4096
+#endif
+
+#if (IOTC_LAYER_TRACING_BUFFER_SIZE & (IOTC_LAYER_TRACING_BUFFER_SIZE - 1))
+#error "IOTC_LAYER_TRACING_BUFFER_SIZE must be a power of two"
+#endif
+
+typedef enum iotc_layer_tracing_phase_e {
+  /* the transition has been put on the event dispatcher's queue */
+  IOTC_LAYER_TRACING_PHASE_ENQUEUE = 0,
+  /* the target layer function starts */
+  IOTC_LAYER_TRACING_PHASE_BEGIN,
+  /* the target layer function has returned */
+  IOTC_LAYER_TRACING_PHASE_END
+} iotc_layer_tracing_phase_t;
+
+typedef enum iotc_layer_tracing_func_e {
+  IOTC_LAYER_TRACING_FUNC_PUSH = 0,
+  IOTC_LAYER_TRACING_FUNC_PULL,
+  IOTC_LAYER_TRACING_FUNC_CLOSE,
+  IOTC_LAYER_TRACING_FUNC_CLOSE_EXTERNALLY,
+  IOTC_LAYER_TRACING_FUNC_INIT,
+  IOTC_LAYER_TRACING_FUNC_CONNECT,
+  IOTC_LAYER_TRACING_FUNC_POST_CONNECT,
+  IOTC_LAYER_TRACING_FUNC_UNKNOWN
+} iotc_layer_tracing_func_t;
+
+/* One tracepoint. A record is valid when its seq equals its ring index + 1,
+ * seq is 0 while a writer fills the record in. */
+typedef struct iotc_layer_tracing_record_s {
+  uint32_t seq;
+  uint32_t flow_id;
+  int64_t timestamp_us;
+  const void* context_data;
+  const void* data;
+  iotc_state_t state;
+  uint8_t phase;
+  uint8_t func;
+  uint8_t from_layer;
+  uint8_t to_layer;
+} iotc_layer_tracing_record_t;
+
+/**
+ * @brief iotc_layer_tracing_make_handle
+ *
+ * Records the enqueue of a layer transition and wraps the target function into
+ * a handle that records its begin and end. Used by
+ * iotc_layer_continue_with_impl instead of a plain iotc_make_handle.
+ */
+iotc_event_handle_t iotc_layer_tracing_make_handle(iotc_layer_func_t* func,
+                                                   void* from_context,
+                                                   void* context, void* data,
+                                                   iotc_state_t state);
+
+/**
+ * @brief iotc_layer_tracing_export
+ *
+ * Writes the records that are in the ring as Chrome trace event JSON, one
+ * chunk at a time. Records overwritten while exporting are skipped.
+ */
+iotc_state_t iotc_layer_tracing_export(iotc_layer_trace_writer_t* writer,
+                                       void* user_data);
+
+void iotc_layer_tracing_clear(void);
+
+/* Number of records written since the last clear, including the overwritten
+ * ones. */
+uint32_t iotc_layer_tracing_get_record_count(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __IOTC_LAYER_TRACING_H__ */
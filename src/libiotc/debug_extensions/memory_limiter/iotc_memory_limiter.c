@@ -43,6 +43,14 @@ extern "C" {
 #define get_entry_from_ptr_const(p) \
   (iotc_memory_limiter_entry_t*)get_entry_from_ptr(p)
 
+/* the code address the profiler attributes an allocation to, taken in the
+ * function called by the library code */
+#if defined(IOTC_MEMORY_LIMITER_PROFILER_ENABLED) && defined(__GNUC__)
+#define IOTC_MEMORY_LIMITER_CALLER __builtin_return_address(0)
+#else
+#define IOTC_MEMORY_LIMITER_CALLER NULL
+#endif
+
 #if IOTC_DEBUG_EXTRA_INFO
 static iotc_memory_limiter_entry_t* iotc_memory_limiter_entry_list_head;
 
@@ -82,6 +90,11 @@ static volatile size_t iotc_memory_total_limit =
     IOTC_MEMORY_LIMITER_APPLICATION_MEMORY_LIMIT +
     IOTC_MEMORY_LIMITER_SYSTEM_MEMORY_LIMIT;
 static volatile size_t iotc_memory_allocated = 0;
+static volatile size_t iotc_memory_allocation_count = 0;
+
+#ifdef IOTC_MEMORY_LIMITER_PROFILER_ENABLED
+static iotc_memory_profiler_t iotc_memory_limiter_profiler;
+#endif
 
 static iotc_state_t iotc_memory_limiter_will_allocation_fit(
     iotc_memory_limiter_allocation_type_t memory_type, size_t size_to_alloc) {
@@ -138,9 +151,13 @@ size_t iotc_memory_limiter_get_allocated_space() {
   return iotc_memory_allocated;
 }
 
-void* iotc_memory_limiter_alloc(
+size_t iotc_memory_limiter_get_allocation_count() {
+  return iotc_memory_allocation_count;
+}
+
+static void* iotc_memory_limiter_alloc_at(
     iotc_memory_limiter_allocation_type_t limit_type, size_t size_to_alloc,
-    const char* file, size_t line) {
+    const char* file, size_t line, const void* caller) {
   assert(limit_type < IOTC_MEMORY_LIMITER_ALLOCATION_TYPE_COUNT);
   assert(NULL != file);
 
@@ -197,20 +214,35 @@ void* iotc_memory_limiter_alloc(
   IOTC_UNUSED(line);
 #endif
 
+#ifdef IOTC_MEMORY_LIMITER_PROFILER_ENABLED
+  entry->profiler_site = iotc_memory_profiler_on_alloc(
+      &iotc_memory_limiter_profiler, file, line, caller, size_to_alloc);
+#else
+  IOTC_UNUSED(caller);
+#endif
+
   entry->size = real_size_to_alloc;
   iotc_memory_allocated += real_size_to_alloc;
+  iotc_memory_allocation_count += 1;
 
 end:
   iotc_unlock_critical_section(&iotc_memory_limiter_cs);
   return ptr_to_ret;
 }
 
-void* iotc_memory_limiter_calloc(
+void* iotc_memory_limiter_alloc(
+    iotc_memory_limiter_allocation_type_t limit_type, size_t size_to_alloc,
+    const char* file, size_t line) {
+  return iotc_memory_limiter_alloc_at(limit_type, size_to_alloc, file, line,
+                                      IOTC_MEMORY_LIMITER_CALLER);
+}
+
+static void* iotc_memory_limiter_calloc_at(
     iotc_memory_limiter_allocation_type_t limit_type, size_t num,
-    size_t size_to_alloc, const char* file, size_t line) {
+    size_t size_to_alloc, const char* file, size_t line, const void* caller) {
   const size_t allocation_size = num * size_to_alloc;
-  void* ret =
-      iotc_memory_limiter_alloc(limit_type, allocation_size, file, line);
+  void* ret = iotc_memory_limiter_alloc_at(limit_type, allocation_size, file,
+                                           line, caller);
 
   /* it's unspecified if memset works with NULL pointer */
   if (NULL != ret) {
@@ -220,13 +252,20 @@ void* iotc_memory_limiter_calloc(
   return ret;
 }
 
+void* iotc_memory_limiter_calloc(
+    iotc_memory_limiter_allocation_type_t limit_type, size_t num,
+    size_t size_to_alloc, const char* file, size_t line) {
+  return iotc_memory_limiter_calloc_at(limit_type, num, size_to_alloc, file,
+                                       line, IOTC_MEMORY_LIMITER_CALLER);
+}
+
 /**
  * @brief simulate realloc on limited memory this will return valid pointer or
  * NULL if memory isn't availible
  */
-void* iotc_memory_limiter_realloc(
+static void* iotc_memory_limiter_realloc_at(
     iotc_memory_limiter_allocation_type_t limit_type, void* ptr,
-    size_t size_to_alloc, const char* file, size_t line) {
+    size_t size_to_alloc, const char* file, size_t line, const void* caller) {
   if (NULL == ptr) {
     return NULL;
   }
@@ -275,6 +314,16 @@ void* iotc_memory_limiter_realloc(
 
   entry = (iotc_memory_limiter_entry_t*)r_ptr;
 
+#ifdef IOTC_MEMORY_LIMITER_PROFILER_ENABLED
+  /* the block moves to the site of the realloc */
+  iotc_memory_profiler_on_free(
+      entry->profiler_site, entry->size - sizeof(iotc_memory_limiter_entry_t));
+  entry->profiler_site = iotc_memory_profiler_on_alloc(
+      &iotc_memory_limiter_profiler, file, line, caller, size_to_alloc);
+#else
+  IOTC_UNUSED(caller);
+#endif
+
 #if IOTC_DEBUG_EXTRA_INFO
   entry->allocation_origin_file_name = file;
   entry->allocation_origin_line_number = line;
@@ -293,6 +342,7 @@ void* iotc_memory_limiter_realloc(
 
   entry->size = real_size_to_alloc;
   iotc_memory_allocated += real_diff;
+  iotc_memory_allocation_count += 1;
 
   ptr_to_ret = get_ptr_from_entry(r_ptr);
 
@@ -301,6 +351,13 @@ end:
   return ptr_to_ret;
 }
 
+void* iotc_memory_limiter_realloc(
+    iotc_memory_limiter_allocation_type_t limit_type, void* ptr,
+    size_t size_to_alloc, const char* file, size_t line) {
+  return iotc_memory_limiter_realloc_at(limit_type, ptr, size_to_alloc, file,
+                                        line, IOTC_MEMORY_LIMITER_CALLER);
+}
+
 void iotc_memory_limiter_free(void* ptr) {
   if (NULL == ptr) {
     return;
@@ -337,6 +394,11 @@ void iotc_memory_limiter_free(void* ptr) {
   }
 #endif
 
+#ifdef IOTC_MEMORY_LIMITER_PROFILER_ENABLED
+  iotc_memory_profiler_on_free(
+      entry->profiler_site, size_to_free - sizeof(iotc_memory_limiter_entry_t));
+#endif
+
   /* this is actual free */
   __iotc_free(entry);
 
@@ -348,59 +410,96 @@ void iotc_memory_limiter_free(void* ptr) {
 
 void* iotc_memory_limiter_alloc_application(size_t size_to_alloc,
                                             const char* file, size_t line) {
-  return iotc_memory_limiter_alloc(
+  return iotc_memory_limiter_alloc_at(
       IOTC_MEMORY_LIMITER_ALLOCATION_TYPE_APPLICATION, size_to_alloc, file,
-      line);
+      line, IOTC_MEMORY_LIMITER_CALLER);
 }
 
 void* iotc_memory_limiter_calloc_application(size_t num, size_t size_to_alloc,
                                              const char* file, size_t line) {
-  return iotc_memory_limiter_calloc(
+  return iotc_memory_limiter_calloc_at(
       IOTC_MEMORY_LIMITER_ALLOCATION_TYPE_APPLICATION, num, size_to_alloc, file,
-      line);
+      line, IOTC_MEMORY_LIMITER_CALLER);
 }
 
 void* iotc_memory_limiter_realloc_application(void* ptr, size_t size_to_alloc,
                                               const char* file, size_t line) {
-  return iotc_memory_limiter_realloc(
+  return iotc_memory_limiter_realloc_at(
       IOTC_MEMORY_LIMITER_ALLOCATION_TYPE_APPLICATION, ptr, size_to_alloc, file,
-      line);
+      line, IOTC_MEMORY_LIMITER_CALLER);
 }
 
 void* iotc_memory_limiter_alloc_system(size_t size_to_alloc, const char* file,
                                        size_t line) {
-  return iotc_memory_limiter_alloc(IOTC_MEMORY_LIMITER_ALLOCATION_TYPE_SYSTEM,
-                                   size_to_alloc, file, line);
+  return iotc_memory_limiter_alloc_at(
+      IOTC_MEMORY_LIMITER_ALLOCATION_TYPE_SYSTEM, size_to_alloc, file, line,
+      IOTC_MEMORY_LIMITER_CALLER);
 }
 
 void* iotc_memory_limiter_calloc_system(size_t num, size_t size_to_alloc,
                                         const char* file, size_t line) {
-  return iotc_memory_limiter_calloc(IOTC_MEMORY_LIMITER_ALLOCATION_TYPE_SYSTEM,
-                                    num, size_to_alloc, file, line);
+  return iotc_memory_limiter_calloc_at(
+      IOTC_MEMORY_LIMITER_ALLOCATION_TYPE_SYSTEM, num, size_to_alloc, file,
+      line, IOTC_MEMORY_LIMITER_CALLER);
 }
 
 void* iotc_memory_limiter_realloc_system(void* ptr, size_t size_to_alloc,
                                          const char* file, size_t line) {
-  return iotc_memory_limiter_realloc(IOTC_MEMORY_LIMITER_ALLOCATION_TYPE_SYSTEM,
-                                     ptr, size_to_alloc, file, line);
+  return iotc_memory_limiter_realloc_at(
+      IOTC_MEMORY_LIMITER_ALLOCATION_TYPE_SYSTEM, ptr, size_to_alloc, file,
+      line, IOTC_MEMORY_LIMITER_CALLER);
 }
 
 void* iotc_memory_limiter_alloc_application_export(size_t size_to_alloc) {
-  return iotc_memory_limiter_alloc_application(size_to_alloc, "exported alloc",
-                                               0);
+  return iotc_memory_limiter_alloc_at(
+      IOTC_MEMORY_LIMITER_ALLOCATION_TYPE_APPLICATION, size_to_alloc,
+      "exported alloc", 0, IOTC_MEMORY_LIMITER_CALLER);
 }
 
 void* iotc_memory_limiter_calloc_application_export(size_t num,
                                                     size_t size_to_alloc) {
-  return iotc_memory_limiter_calloc_application(num, size_to_alloc,
-                                                "exported calloc", 0);
+  return iotc_memory_limiter_calloc_at(
+      IOTC_MEMORY_LIMITER_ALLOCATION_TYPE_APPLICATION, num, size_to_alloc,
+      "exported calloc", 0, IOTC_MEMORY_LIMITER_CALLER);
 }
 
 void* iotc_memory_limiter_realloc_application_export(void* ptr,
                                                      size_t size_to_alloc) {
-  return iotc_memory_limiter_realloc_application(ptr, size_to_alloc,
-                                                 "exported re-alloc", 0);
+  return iotc_memory_limiter_realloc_at(
+      IOTC_MEMORY_LIMITER_ALLOCATION_TYPE_APPLICATION, ptr, size_to_alloc,
+      "exported re-alloc", 0, IOTC_MEMORY_LIMITER_CALLER);
+}
+
+#ifdef IOTC_MEMORY_LIMITER_PROFILER_ENABLED
+iotc_state_t iotc_memory_limiter_dump_profile(
+    iotc_heap_profile_format_t format, iotc_heap_profile_writer_t* writer,
+    void* user_data) {
+  /* the copy bypasses the limiter so the dump doesn't show up in itself */
+  iotc_memory_profiler_t* snapshot =
+      __iotc_alloc(sizeof(iotc_memory_profiler_t));
+
+  if (NULL == snapshot) {
+    return IOTC_OUT_OF_MEMORY;
+  }
+
+  iotc_lock_critical_section(&iotc_memory_limiter_cs);
+  memcpy(snapshot, &iotc_memory_limiter_profiler,
+         sizeof(iotc_memory_profiler_t));
+  iotc_unlock_critical_section(&iotc_memory_limiter_cs);
+
+  const iotc_state_t state =
+      iotc_memory_profiler_write(snapshot, format, writer, user_data);
+
+  __iotc_free(snapshot);
+  return state;
+}
+
+void iotc_memory_limiter_reset_profile() {
+  iotc_lock_critical_section(&iotc_memory_limiter_cs);
+  iotc_memory_profiler_reset(&iotc_memory_limiter_profiler);
+  iotc_unlock_critical_section(&iotc_memory_limiter_cs);
 }
+#endif /* IOTC_MEMORY_LIMITER_PROFILER_ENABLED */
 
 #if IOTC_DEBUG_EXTRA_INFO
 void iotc_memory_limiter_gc() {
@@ -21,6 +21,10 @@
 
 #include <iotc_error.h>
 
+#ifdef IOTC_MEMORY_LIMITER_PROFILER_ENABLED
+#include "iotc_memory_profiler.h"
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -44,6 +48,9 @@ typedef struct iotc_memory_limiter_entry_s {
   int backtrace_symbols_buffer_size;
 #endif
   size_t allocation_origin_line_number;
+#endif
+#ifdef IOTC_MEMORY_LIMITER_PROFILER_ENABLED
+  iotc_memory_profiler_site_t* profiler_site;
 #endif
   size_t size;
 } iotc_memory_limiter_entry_t;
@@ -101,6 +108,14 @@ extern size_t iotc_memory_limiter_get_current_limit(
  */
 extern size_t iotc_memory_limiter_get_allocated_space();
 
+/**
+ * @brief iotc_memory_limiter_get_allocation_count
+ *
+ * Returns the number of successful allocations and reallocations since the
+ * start of the process, tests take the difference of two calls.
+ */
+extern size_t iotc_memory_limiter_get_allocation_count();
+
 /**
  * @brief simulates free operation on memory block it just re-add the memory to
  * the pool it will
@@ -192,6 +207,28 @@ extern void* iotc_memory_limiter_calloc_application_export(
 extern void* iotc_memory_limiter_realloc_application_export(
     void* ptr, size_t size_to_alloc);
 
+#ifdef IOTC_MEMORY_LIMITER_PROFILER_ENABLED
+
+/**
+ * @brief iotc_memory_limiter_dump_profile
+ *
+ * Writes the counters of the allocation sites. The counters are copied within
+ * the critical section and formatted outside of it, so the writer may use the
+ * allocator.
+ */
+extern iotc_state_t iotc_memory_limiter_dump_profile(
+    iotc_heap_profile_format_t format, iotc_heap_profile_writer_t* writer,
+    void* user_data);
+
+/**
+ * @brief iotc_memory_limiter_reset_profile
+ *
+ * Starts a new profiling window, the live allocations are carried over.
+ */
+extern void iotc_memory_limiter_reset_profile();
+
+#endif /* IOTC_MEMORY_LIMITER_PROFILER_ENABLED */
+
 #if IOTC_DEBUG_EXTRA_INFO
 
 /**
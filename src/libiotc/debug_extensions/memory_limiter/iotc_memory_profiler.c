@@ -0,0 +1,258 @@
+/* Copyright 2018-2020 Google LLC
+ *
+ * This is part of the Google Cloud IoT Device SDK for Embedded C.
+ * It is licensed under the BSD 3-Clause license; you may not use this file
+ * except in compliance with the License.
+ *
+ * You may obtain a copy of the License at:
+ *  https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "iotc_macros.h"
+#include "iotc_memory_profiler.h"
+
+#define IOTC_MEMORY_PROFILER_SITES_MASK (IOTC_MEMORY_PROFILER_MAX_SITES - 1)
+
+/* big enough for the longest line of both formats */
+#define IOTC_MEMORY_PROFILER_CHUNK_SIZE 512
+
+static uint8_t iotc_memory_profiler_site_matches(
+    const iotc_memory_profiler_site_t* site, const char* file, size_t line) {
+  /* __FILE__ literals of the same file are usually merged by the linker */
+  return site->line == line &&
+         (site->file == file || 0 == strcmp(site->file, file));
+}
+
+static uint8_t iotc_memory_profiler_histogram_bucket(size_t size) {
+  uint8_t bucket = 0;
+  size_t bucket_size = IOTC_MEMORY_PROFILER_HISTOGRAM_MIN_SIZE;
+
+  while (size > bucket_size &&
+         bucket < IOTC_MEMORY_PROFILER_HISTOGRAM_BUCKETS - 1) {
+    bucket_size <<= 1;
+    ++bucket;
+  }
+
+  return bucket;
+}
+
+/* Open addressing on the line number, the lines of the library's iotc_alloc
+ * calls are spread enough to keep the probe sequences short. */
+static iotc_memory_profiler_site_t* iotc_memory_profiler_find_site(
+    iotc_memory_profiler_t* profiler, const char* file, size_t line) {
+  size_t i = (line * 2654435761u) & IOTC_MEMORY_PROFILER_SITES_MASK;
+  size_t probes = 0;
+
+  for (; probes < IOTC_MEMORY_PROFILER_MAX_SITES; ++probes) {
+    iotc_memory_profiler_site_t* site = &profiler->sites[i];
+
+    if (NULL == site->file) {
+      site->file = file;
+      site->line = line;
+      return site;
+    }
+
+    if (iotc_memory_profiler_site_matches(site, file, line)) {
+      return site;
+    }
+
+    i = (i + 1) & IOTC_MEMORY_PROFILER_SITES_MASK;
+  }
+
+  profiler->other.file = "(other sites)";
+  return &profiler->other;
+}
+
+iotc_memory_profiler_site_t* iotc_memory_profiler_on_alloc(
+    iotc_memory_profiler_t* profiler, const char* file, size_t line,
+    const void* caller, size_t size) {
+  iotc_memory_profiler_site_t* site =
+      iotc_memory_profiler_find_site(profiler, file, line);
+
+  if (NULL == site->caller) {
+    site->caller = caller;
+  }
+
+  ++site->allocs;
+  ++site->live_allocs;
+  site->total_bytes += size;
+  site->live_bytes += size;
+  site->peak_bytes = IOTC_MAX(site->peak_bytes, site->live_bytes);
+  ++site->histogram[iotc_memory_profiler_histogram_bucket(size)];
+
+  return site;
+}
+
+void iotc_memory_profiler_on_free(iotc_memory_profiler_site_t* site,
+                                  size_t size) {
+  if (NULL == site) {
+    return;
+  }
+
+  ++site->frees;
+  --site->live_allocs;
+  site->live_bytes -= size;
+}
+
+static void iotc_memory_profiler_reset_site(iotc_memory_profiler_site_t* site) {
+  site->allocs = site->live_allocs;
+  site->frees = 0;
+  site->total_bytes = site->live_bytes;
+  site->peak_bytes = site->live_bytes;
+  memset(site->histogram, 0, sizeof(site->histogram));
+}
+
+void iotc_memory_profiler_reset(iotc_memory_profiler_t* profiler) {
+  size_t i = 0;
+  for (; i < IOTC_MEMORY_PROFILER_MAX_SITES; ++i) {
+    iotc_memory_profiler_reset_site(&profiler->sites[i]);
+  }
+
+  iotc_memory_profiler_reset_site(&profiler->other);
+}
+
+static void iotc_memory_profiler_printf(iotc_heap_profile_writer_t* writer,
+                                        void* user_data, const char* format,
+                                        ...) {
+  char chunk[IOTC_MEMORY_PROFILER_CHUNK_SIZE] = {0};
+
+  va_list args;
+  va_start(args, format);
+  const int written = vsnprintf(chunk, sizeof(chunk), format, args);
+  va_end(args);
+
+  if (written < 0) {
+    return;
+  }
+
+  writer(chunk, IOTC_MIN((size_t)written, sizeof(chunk) - 1), user_data);
+}
+
+static void iotc_memory_profiler_write_csv_site(
+    const iotc_memory_profiler_site_t* site, iotc_heap_profile_writer_t* writer,
+    void* user_data) {
+  const uint32_t* h = site->histogram;
+
+  iotc_memory_profiler_printf(
+      writer, user_data,
+      "%s,%lu,%llu,%llu,%llu,%llu,%llu,%llu,%u,%u,%u,%u,%u,%u,%u,%u,%u\n",
+      site->file, (unsigned long)site->line, (unsigned long long)site->allocs,
+      (unsigned long long)site->frees, (unsigned long long)site->live_allocs,
+      (unsigned long long)site->live_bytes,
+      (unsigned long long)site->peak_bytes,
+      (unsigned long long)site->total_bytes, h[0], h[1], h[2], h[3], h[4],
+      h[5], h[6], h[7], h[8]);
+}
+
+static void iotc_memory_profiler_write_pprof_site(
+    const iotc_memory_profiler_site_t* site, iotc_heap_profile_writer_t* writer,
+    void* user_data) {
+  /* pprof can't place a sample without a frame */
+  if (NULL == site->caller) {
+    return;
+  }
+
+  iotc_memory_profiler_printf(
+      writer, user_data, "%llu: %llu [%llu: %llu] @ 0x%lx\n",
+      (unsigned long long)site->live_allocs,
+      (unsigned long long)site->live_bytes, (unsigned long long)site->allocs,
+      (unsigned long long)site->total_bytes,
+      (unsigned long)(uintptr_t)site->caller);
+}
+
+/* pprof maps the frames to the binary with the memory map of the process. */
+static void iotc_memory_profiler_write_mapped_libraries(
+    iotc_heap_profile_writer_t* writer, void* user_data) {
+  static const char header[] = "\nMAPPED_LIBRARIES:\n";
+  writer(header, sizeof(header) - 1, user_data);
+
+#ifdef IOTC_PLATFORM_BASE_POSIX
+  FILE* maps = fopen("/proc/self/maps", "r");
+  if (NULL == maps) {
+    return;
+  }
+
+  char chunk[IOTC_MEMORY_PROFILER_CHUNK_SIZE];
+  size_t read = 0;
+  while (0 < (read = fread(chunk, 1, sizeof(chunk), maps))) {
+    writer(chunk, read, user_data);
+  }
+
+  fclose(maps);
+#endif
+}
+
+iotc_state_t iotc_memory_profiler_write(const iotc_memory_profiler_t* profiler,
+                                        iotc_heap_profile_format_t format,
+                                        iotc_heap_profile_writer_t* writer,
+                                        void* user_data) {
+  if (NULL == profiler || NULL == writer) {
+    return IOTC_INVALID_PARAMETER;
+  }
+
+  size_t i = 0;
+
+  switch (format) {
+    case IOTC_HEAP_PROFILE_FORMAT_CSV: {
+      static const char header[] =
+          "file,line,allocs,frees,live_allocs,live_bytes,peak_bytes,"
+          "total_bytes,le16,le32,le64,le128,le256,le512,le1024,le2048,"
+          "gt2048\n";
+      writer(header, sizeof(header) - 1, user_data);
+
+      for (; i < IOTC_MEMORY_PROFILER_MAX_SITES; ++i) {
+        if (NULL != profiler->sites[i].file) {
+          iotc_memory_profiler_write_csv_site(&profiler->sites[i], writer,
+                                              user_data);
+        }
+      }
+
+      if (NULL != profiler->other.file) {
+        iotc_memory_profiler_write_csv_site(&profiler->other, writer,
+                                            user_data);
+      }
+    } break;
+    case IOTC_HEAP_PROFILE_FORMAT_PPROF: {
+      uint64_t live_allocs = profiler->other.live_allocs;
+      uint64_t live_bytes = profiler->other.live_bytes;
+      uint64_t allocs = profiler->other.allocs;
+      uint64_t total_bytes = profiler->other.total_bytes;
+
+      for (; i < IOTC_MEMORY_PROFILER_MAX_SITES; ++i) {
+        live_allocs += profiler->sites[i].live_allocs;
+        live_bytes += profiler->sites[i].live_bytes;
+        allocs += profiler->sites[i].allocs;
+        total_bytes += profiler->sites[i].total_bytes;
+      }
+
+      iotc_memory_profiler_printf(
+          writer, user_data,
+          "heap profile: %llu: %llu [%llu: %llu] @ heapprofile\n",
+          (unsigned long long)live_allocs, (unsigned long long)live_bytes,
+          (unsigned long long)allocs, (unsigned long long)total_bytes);
+
+      for (i = 0; i < IOTC_MEMORY_PROFILER_MAX_SITES; ++i) {
+        iotc_memory_profiler_write_pprof_site(&profiler->sites[i], writer,
+                                              user_data);
+      }
+
+      iotc_memory_profiler_write_pprof_site(&profiler->other, writer,
+                                            user_data);
+      iotc_memory_profiler_write_mapped_libraries(writer, user_data);
+    } break;
+    default:
+      return IOTC_INVALID_PARAMETER;
+  }
+
+  return IOTC_STATE_OK;
+}
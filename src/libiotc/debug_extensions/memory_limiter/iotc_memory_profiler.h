@@ -0,0 +1,98 @@
+/* Copyright 2018-2020 Google LLC
+ *
+ * This is part of the Google Cloud IoT Device SDK for Embedded C.
+ * It is licensed under the BSD 3-Clause license; you may not use this file
+ * except in compliance with the License.
+ *
+ * You may obtain a copy of the License at:
+ *  https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __IOTC_MEMORY_PROFILER_H__
+#define __IOTC_MEMORY_PROFILER_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "iotc_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Number of distinct allocation sites tracked, must be a power of two. The
+ * allocations of the sites above the limit are counted together. */
+#ifndef IOTC_MEMORY_PROFILER_MAX_SITES
+#define IOTC_MEMORY_PROFILER_MAX_SITES 256
+#endif
+
+#if (IOTC_MEMORY_PROFILER_MAX_SITES & (IOTC_MEMORY_PROFILER_MAX_SITES - 1))
+#error "IOTC_MEMORY_PROFILER_MAX_SITES must be a power of two"
+#endif
+
+/* Allocation sizes up to 16, 32, ..., 2048 bytes and above. */
+#define IOTC_MEMORY_PROFILER_HISTOGRAM_BUCKETS 9
+#define IOTC_MEMORY_PROFILER_HISTOGRAM_MIN_SIZE 16
+
+/* The counters of one iotc_alloc call site. */
+typedef struct iotc_memory_profiler_site_s {
+  const char* file;
+  size_t line;
+  /* the code address of the first allocation, for pprof */
+  const void* caller;
+  uint64_t allocs;
+  uint64_t frees;
+  uint64_t total_bytes;
+  uint64_t live_allocs;
+  uint64_t live_bytes;
+  uint64_t peak_bytes;
+  uint32_t histogram[IOTC_MEMORY_PROFILER_HISTOGRAM_BUCKETS];
+} iotc_memory_profiler_site_t;
+
+/* The state of the profiler. The functions below aren't thread safe, the
+ * memory limiter calls them within its critical section. */
+typedef struct iotc_memory_profiler_s {
+  iotc_memory_profiler_site_t sites[IOTC_MEMORY_PROFILER_MAX_SITES];
+  /* the allocations of the sites that didn't fit into the table */
+  iotc_memory_profiler_site_t other;
+} iotc_memory_profiler_t;
+
+/**
+ * @brief iotc_memory_profiler_on_alloc
+ *
+ * Accounts an allocation to its call site.
+ *
+ * @return the site to pass to iotc_memory_profiler_on_free.
+ */
+iotc_memory_profiler_site_t* iotc_memory_profiler_on_alloc(
+    iotc_memory_profiler_t* profiler, const char* file, size_t line,
+    const void* caller, size_t size);
+
+void iotc_memory_profiler_on_free(iotc_memory_profiler_site_t* site,
+                                  size_t size);
+
+/* Zeroes the counters except for the live allocations, so the frees that
+ * follow stay balanced. */
+void iotc_memory_profiler_reset(iotc_memory_profiler_t* profiler);
+
+/**
+ * @brief iotc_memory_profiler_write
+ *
+ * Writes the sites of a copy of the profiler in the given format.
+ */
+iotc_state_t iotc_memory_profiler_write(const iotc_memory_profiler_t* profiler,
+                                        iotc_heap_profile_format_t format,
+                                        iotc_heap_profile_writer_t* writer,
+                                        void* user_data);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __IOTC_MEMORY_PROFILER_H__ */
@@ -18,7 +18,44 @@
 
 #include "iotc_event_dispatcher_api.h"
 #include "iotc_helpers.h"
-#include "iotc_list.h"
+
+#ifdef IOTC_MEMORY_ACCOUNTING_ENABLED
+#include "iotc_memory_accounting.h"
+
+/* Handles run by the dispatcher are accounted to the owner that scheduled
+ * them, this way the allocations of a whole layer chain follow its context. */
+#define iotc_evtd_mark_handle_owner(handle) \
+  (handle).memory_owner = iotc_memory_accounting_get_owner()
+
+static iotc_event_handle_return_t iotc_evtd_execute_scheduled_handle(
+    iotc_event_handle_t* handle) {
+  const iotc_memory_accounting_owner_t prev_owner =
+      iotc_memory_accounting_set_owner(handle->memory_owner);
+
+  const iotc_event_handle_return_t ret = iotc_evtd_execute_handle(handle);
+
+  iotc_memory_accounting_set_owner(prev_owner);
+
+  return ret;
+}
+#else
+#define iotc_evtd_mark_handle_owner(handle)
+#define iotc_evtd_execute_scheduled_handle iotc_evtd_execute_handle
+#endif
+
+#ifdef IOTC_MODULE_THREAD_ENABLED
+/* Wakes the event loop up if it is blocked waiting on this dispatcher. Only the
+ * first submission after arming pays for the system call, the loop thread
+ * itself never does since it disarms before running the handles. */
+static void iotc_evtd_wakeup(iotc_evtd_instance_t* instance) {
+  if (NULL != instance->wakeup &&
+      0 != __atomic_exchange_n(&instance->wakeup_armed, 0, __ATOMIC_SEQ_CST)) {
+    iotc_wakeup_signal(instance->wakeup);
+  }
+}
+#else
+#define iotc_evtd_wakeup(instance)
+#endif
 
 static inline int8_t iotc_evtd_cmp_fd(
     const union iotc_vector_selector_u* e0,
@@ -51,6 +88,9 @@ static int8_t iotc_evtd_register_fd(iotc_evtd_instance_t* instance,
 
   iotc_state_t state = IOTC_STATE_OK;
 
+  iotc_evtd_mark_handle_owner(read_handle);
+  iotc_evtd_mark_handle_owner(current_handle);
+
   iotc_lock_critical_section(instance->cs);
 
   /* add an entry with the proper event for file descriptor */
@@ -73,6 +113,8 @@ static int8_t iotc_evtd_register_fd(iotc_evtd_instance_t* instance,
 
   iotc_unlock_critical_section(instance->cs);
 
+  iotc_evtd_wakeup(instance);
+
   return 1;
 
 err_handling:
@@ -137,6 +179,21 @@ int8_t iotc_evtd_unregister_socket_fd(iotc_evtd_instance_t* instance,
   return iotc_evtd_unregister_fd(instance, instance->handles_and_socket_fd, fd);
 }
 
+uint8_t iotc_evtd_is_socket_fd_registered(iotc_evtd_instance_t* instance,
+                                          iotc_fd_t fd) {
+  assert(NULL != instance);
+
+  iotc_lock_critical_section(instance->cs);
+
+  const iotc_vector_index_type_t id = iotc_vector_find(
+      instance->handles_and_socket_fd,
+      IOTC_VEC_CONST_VALUE_PARAM(IOTC_VEC_VALUE_IPTR(fd)), &iotc_evtd_cmp_fd);
+
+  iotc_unlock_critical_section(instance->cs);
+
+  return (-1 != id) ? 1 : 0;
+}
+
 int8_t iotc_evtd_continue_when_evt_on_socket(iotc_evtd_instance_t* instance,
                                              iotc_event_type_t event_type,
                                              iotc_event_handle_t handle,
@@ -144,6 +201,8 @@ int8_t iotc_evtd_continue_when_evt_on_socket(iotc_evtd_instance_t* instance,
   /* PRECONDITIONS */
   assert(instance != 0);
 
+  iotc_evtd_mark_handle_owner(handle);
+
   iotc_lock_critical_section(instance->cs);
 
   iotc_vector_index_type_t id = iotc_vector_find(
@@ -163,6 +222,8 @@ int8_t iotc_evtd_continue_when_evt_on_socket(iotc_evtd_instance_t* instance,
 
     iotc_unlock_critical_section(instance->cs);
 
+    iotc_evtd_wakeup(instance);
+
     return 1;
   }
 
@@ -173,6 +234,7 @@ int8_t iotc_evtd_continue_when_evt_on_socket(iotc_evtd_instance_t* instance,
 
 void iotc_evtd_continue_when_empty(iotc_evtd_instance_t* instance,
                                    iotc_event_handle_t handle) {
+  iotc_evtd_mark_handle_owner(handle);
   instance->on_empty = handle;
 }
 
@@ -182,13 +244,12 @@ iotc_event_handle_queue_t* iotc_evtd_execute(iotc_evtd_instance_t* instance,
   IOTC_ALLOC_SYSTEM(iotc_event_handle_queue_t, queue_elem, state);
 
   queue_elem->handle = handle;
+  iotc_evtd_mark_handle_owner(queue_elem->handle);
 
-  iotc_lock_critical_section(instance->cs);
-
-  IOTC_LIST_PUSH_BACK(iotc_event_handle_queue_t, instance->call_queue,
-                      queue_elem);
+  /* lock-free, producers on other threads don't contend with the dispatcher */
+  iotc_mpsc_queue_push(&instance->call_queue, &queue_elem->node);
 
-  iotc_unlock_critical_section(instance->cs);
+  iotc_evtd_wakeup(instance);
 
   return queue_elem;
 
@@ -204,6 +265,7 @@ iotc_state_t iotc_evtd_execute_in(
   IOTC_ALLOC(iotc_time_event_t, time_event, ret_state);
 
   time_event->event_handle = handle;
+  iotc_evtd_mark_handle_owner(time_event->event_handle);
   time_event->time_of_execution = instance->current_step + time_diff;
 
   iotc_lock_critical_section(instance->cs);
@@ -211,8 +273,19 @@ iotc_state_t iotc_evtd_execute_in(
   ret_state = iotc_time_event_add(instance->time_events_container, time_event,
                                   ret_time_event_handle);
 
+  /* only a new earliest event shortens the wait */
+  const uint8_t is_earliest =
+      (IOTC_STATE_OK == ret_state &&
+       time_event == iotc_time_event_peek_top(instance->time_events_container))
+          ? 1
+          : 0;
+
   iotc_unlock_critical_section(instance->cs);
 
+  if (1 == is_earliest) {
+    iotc_evtd_wakeup(instance);
+  }
+
   return ret_state;
 
 err_handling:
@@ -249,6 +322,8 @@ iotc_state_t iotc_evtd_restart(iotc_evtd_instance_t* instance,
 
   iotc_unlock_critical_section(instance->cs);
 
+  iotc_evtd_wakeup(instance);
+
   return ret_state;
 }
 
@@ -267,6 +342,8 @@ iotc_evtd_instance_t* iotc_evtd_create_instance(void) {
 
   IOTC_CHECK_STATE(iotc_init_critical_section(&evtd_instance->cs));
 
+  iotc_mpsc_queue_init(&evtd_instance->call_queue);
+
   return evtd_instance;
 
 err_handling:
@@ -283,6 +360,18 @@ void iotc_evtd_destroy_instance(iotc_evtd_instance_t* instance) {
 
   iotc_lock_critical_section(cs);
 
+#ifdef IOTC_MODULE_THREAD_ENABLED
+  if (NULL != instance->wakeup) {
+    iotc_wakeup_destroy(&instance->wakeup);
+  }
+#endif
+
+  iotc_mpsc_queue_node_t* node = NULL;
+  while (NULL != (node = iotc_mpsc_queue_pop(&instance->call_queue))) {
+    iotc_event_handle_queue_t* queue_elem = (iotc_event_handle_queue_t*)node;
+    IOTC_SAFE_FREE(queue_elem);
+  }
+
   iotc_vector_destroy(instance->handles_and_file_fd);
   iotc_vector_destroy(instance->handles_and_socket_fd);
   iotc_time_event_destroy(instance->time_events_container);
@@ -353,18 +442,18 @@ extern uint8_t iotc_evtd_single_step(iotc_evtd_instance_t* evtd_instance,
 
   evtd_instance->current_step = new_step;
 
-  iotc_event_handle_queue_t* queue_elem = NULL;
-
+  /* the queue has a single consumer, the lock serializes the threads sharing
+   * one dispatcher, e.g. the workers of a threadpool */
   iotc_lock_critical_section(evtd_instance->cs);
-  if (!IOTC_LIST_EMPTY(iotc_event_handle_queue_t, evtd_instance->call_queue)) {
-    IOTC_LIST_POP(iotc_event_handle_queue_t, evtd_instance->call_queue,
-                  queue_elem);
-  }
+  iotc_event_handle_queue_t* queue_elem =
+      (iotc_event_handle_queue_t*)iotc_mpsc_queue_pop(
+          &evtd_instance->call_queue);
   iotc_unlock_critical_section(evtd_instance->cs);
 
   if (queue_elem == NULL) return 0;
 
-  const iotc_state_t result = iotc_evtd_execute_handle(&queue_elem->handle);
+  const iotc_state_t result =
+      iotc_evtd_execute_scheduled_handle(&queue_elem->handle);
 
   if (iotc_state_is_fatal(result) == 1) {
     iotc_debug_logger("error while processing normal events");
@@ -398,7 +487,7 @@ void iotc_evtd_step(iotc_evtd_instance_t* evtd_instance, iotc_time_t new_step) {
 
       iotc_unlock_critical_section(evtd_instance->cs);
 
-      iotc_state_t result = iotc_evtd_execute_handle(handle);
+      iotc_state_t result = iotc_evtd_execute_scheduled_handle(handle);
 
       IOTC_SAFE_FREE(tmp);
 
@@ -437,7 +526,7 @@ void iotc_evtd_step(iotc_evtd_instance_t* evtd_instance, iotc_time_t new_step) {
     iotc_debug_logger("calling on_empty_handler");
 
     iotc_unlock_critical_section(evtd_instance->cs);
-    iotc_evtd_execute_handle(&evtd_instance->on_empty);
+    iotc_evtd_execute_scheduled_handle(&evtd_instance->on_empty);
     iotc_lock_critical_section(evtd_instance->cs);
 
     iotc_dispose_handle(&evtd_instance->on_empty);
@@ -491,7 +580,7 @@ iotc_state_t iotc_evtd_update_event_on_fd(iotc_evtd_instance_t* instance,
      * so we don't won't to override that again */
     iotc_unlock_critical_section(instance->cs);
 
-    iotc_evtd_execute_handle(&to_exec);
+    iotc_evtd_execute_scheduled_handle(&to_exec);
 
     iotc_lock_critical_section(instance->cs);
   } else {
@@ -522,6 +611,8 @@ void iotc_evtd_stop(iotc_evtd_instance_t* instance) {
   assert(instance != 0);
 
   instance->stop = 1;
+
+  iotc_evtd_wakeup(instance);
 }
 
 uint8_t iotc_evtd_update_file_fd_events(
@@ -572,3 +663,49 @@ iotc_state_t iotc_evtd_get_time_of_earliest_event(
 
   return ret_state;
 }
+
+#ifdef IOTC_MODULE_THREAD_ENABLED
+iotc_state_t iotc_evtd_enable_wakeup(iotc_evtd_instance_t* instance) {
+  assert(NULL != instance);
+
+  if (NULL != instance->wakeup) {
+    return IOTC_STATE_OK;
+  }
+
+  return iotc_wakeup_create(&instance->wakeup);
+}
+
+uint8_t iotc_evtd_arm_wakeup(iotc_evtd_instance_t* instance,
+                             iotc_fd_t* out_fd) {
+  assert(NULL != instance);
+  assert(NULL != out_fd);
+
+  if (NULL == instance->wakeup) {
+    return 0;
+  }
+
+  /* must be visible before the loop looks at the call queue and the timed
+   * events, a submission racing with that look then signals the descriptor */
+  __atomic_store_n(&instance->wakeup_armed, 1, __ATOMIC_SEQ_CST);
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+  *out_fd = iotc_wakeup_get_fd(instance->wakeup);
+
+  return 1;
+}
+
+void iotc_evtd_disarm_wakeup(iotc_evtd_instance_t* instance,
+                             uint8_t signaled) {
+  assert(NULL != instance);
+
+  if (NULL == instance->wakeup) {
+    return;
+  }
+
+  __atomic_store_n(&instance->wakeup_armed, 0, __ATOMIC_SEQ_CST);
+
+  if (0 != signaled) {
+    iotc_wakeup_drain(instance->wakeup);
+  }
+}
+#endif
@@ -26,11 +26,13 @@
 #include "iotc_event_handle.h"
 #include "iotc_event_handle_queue.h"
 #include "iotc_macros.h"
+#include "iotc_mpsc_queue.h"
 #include "iotc_time.h"
 #include "iotc_time_event.h"
 #include "iotc_vector.h"
 
 #include "iotc_critical_section.h"
+#include "iotc_wakeup.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -54,12 +56,16 @@ typedef struct iotc_evtd_tuple_s {
 typedef struct iotc_evtd_instance_s {
   iotc_time_t current_step;
   iotc_vector_t* time_events_container;
-  iotc_event_handle_queue_t* call_queue;
+  iotc_mpsc_queue_t call_queue;
   struct iotc_critical_section_s* cs;
   iotc_vector_t* handles_and_socket_fd;
   iotc_vector_t* handles_and_file_fd;
   iotc_event_handle_t on_empty;
   uint8_t stop;
+#ifdef IOTC_MODULE_THREAD_ENABLED
+  struct iotc_wakeup_s* wakeup;
+  volatile uint8_t wakeup_armed;
+#endif
 } iotc_evtd_instance_t;
 
 extern int8_t iotc_evtd_register_file_fd(iotc_evtd_instance_t* instance,
@@ -77,6 +83,12 @@ extern int8_t iotc_evtd_unregister_file_fd(iotc_evtd_instance_t* instance,
 extern int8_t iotc_evtd_unregister_socket_fd(iotc_evtd_instance_t* instance,
                                              iotc_fd_t fd);
 
+/**
+ * @brief returns 1 if the socket is registered with the dispatcher
+ */
+extern uint8_t iotc_evtd_is_socket_fd_registered(
+    iotc_evtd_instance_t* instance, iotc_fd_t fd);
+
 extern int8_t iotc_evtd_continue_when_evt_on_socket(
     iotc_evtd_instance_t* instance, iotc_event_type_t event_type,
     iotc_event_handle_t handle, iotc_fd_t fd);
@@ -157,6 +169,44 @@ extern uint8_t iotc_evtd_update_file_fd_events(
 extern iotc_state_t iotc_evtd_get_time_of_earliest_event(
     iotc_evtd_instance_t* instance, iotc_time_t* out_timeout);
 
+#ifdef IOTC_MODULE_THREAD_ENABLED
+/**
+ * @brief iotc_evtd_enable_wakeup
+ *
+ * Lets other threads interrupt the blocking wait of the event loop running
+ * this dispatcher. Once enabled, scheduling a handle, an earlier timed event
+ * or stopping the dispatcher from any thread wakes the loop up immediately.
+ *
+ * @param instance of an event dispatcher
+ * @return IOTC_STATE_OK in case of success, an error state otherwise
+ */
+extern iotc_state_t iotc_evtd_enable_wakeup(iotc_evtd_instance_t* instance);
+
+/**
+ * @brief iotc_evtd_arm_wakeup
+ *
+ * Called by the event loop right before it starts waiting. From now on
+ * submissions signal the wakeup descriptor.
+ *
+ * @param instance of an event dispatcher
+ * @param out_fd the descriptor the event loop has to wait for reading on
+ * @return 1 if the dispatcher has a wakeup descriptor, 0 otherwise
+ */
+extern uint8_t iotc_evtd_arm_wakeup(iotc_evtd_instance_t* instance,
+                                    iotc_fd_t* out_fd);
+
+/**
+ * @brief iotc_evtd_disarm_wakeup
+ *
+ * Called by the event loop once the wait is over.
+ *
+ * @param instance of an event dispatcher
+ * @param signaled 1 if the wakeup descriptor became readable
+ */
+extern void iotc_evtd_disarm_wakeup(iotc_evtd_instance_t* instance,
+                                    uint8_t signaled);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
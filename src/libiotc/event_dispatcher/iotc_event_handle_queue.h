@@ -18,9 +18,11 @@
 #define __IOTC_EVENT_HANDLE_QUEUE_H__
 
 #include "iotc_event_handle.h"
+#include "iotc_mpsc_queue.h"
 
+/* node has to stay the first member, queued elements are cast back from it */
 typedef struct iotc_event_handle_queue_s {
-  struct iotc_event_handle_queue_s* __next;
+  iotc_mpsc_queue_node_t node;
   iotc_event_handle_t handle;
 } iotc_event_handle_queue_t;
 
@@ -21,6 +21,10 @@
 #include "iotc_event_dispatcher_macros.h"
 #include "iotc_layer.h"
 
+#ifdef IOTC_MEMORY_ACCOUNTING_ENABLED
+#include "iotc_memory_accounting.h"
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -115,6 +119,11 @@ typedef struct iotc_event_handle_s {
   } handlers;
 
   uint8_t target_tid;
+#ifdef IOTC_MEMORY_ACCOUNTING_ENABLED
+  /* accounting slot of the code that scheduled the handle, set by the event
+   * dispatcher */
+  iotc_memory_accounting_owner_t memory_owner;
+#endif
 } iotc_event_handle_t;
 
 #define iotc_make_empty_event_handle(target_tid) \
@@ -0,0 +1,126 @@
+/* Copyright 2018-2020 Google LLC
+ *
+ * This is part of the Google Cloud IoT Device SDK for Embedded C.
+ * It is licensed under the BSD 3-Clause license; you may not use this file
+ * except in compliance with the License.
+ *
+ * You may obtain a copy of the License at:
+ *  https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <string.h>
+
+#include <vector>
+
+extern "C" {
+#include "iotc_time_event.h"
+}
+
+namespace iotctest {
+namespace {
+
+// A few time events per connection, 64 covers a handful of connections.
+constexpr int kMaxHeapSize = 64;
+
+// Fixed pseudo-random execution times, the same on every run.
+std::vector<iotc_time_t> ExecutionTimes(int size) {
+  std::vector<iotc_time_t> times(size);
+  uint32_t seed = 12345;
+  for (int i = 0; i < size; ++i) {
+    seed = seed * 1103515245 + 12345;
+    times[i] = (seed >> 16) % 1000;
+  }
+  return times;
+}
+
+class TimeEventHeap {
+ public:
+  explicit TimeEventHeap(int size)
+      : times_(ExecutionTimes(size)), events_(size), handles_(size) {
+    vector_ = iotc_vector_create();
+  }
+  ~TimeEventHeap() { iotc_vector_destroy(vector_); }
+
+  void Fill() {
+    for (size_t i = 0; i < events_.size(); ++i) {
+      // the empty event macros use designated initializers, C only
+      memset(&events_[i], 0, sizeof(iotc_time_event_t));
+      events_[i].time_of_execution = times_[i];
+      events_[i].position = IOTC_TIME_EVENT_POSITION_INVALID;
+      handles_[i].ptr_to_position = nullptr;
+      iotc_time_event_add(vector_, &events_[i], &handles_[i]);
+    }
+  }
+
+  iotc_vector_t* vector() { return vector_; }
+  iotc_time_event_handle_t* handle(int i) { return &handles_[i]; }
+
+ private:
+  const std::vector<iotc_time_t> times_;
+  std::vector<iotc_time_event_t> events_;
+  std::vector<iotc_time_event_handle_t> handles_;
+  iotc_vector_t* vector_;
+};
+
+// Adds all the time events, then takes them off the top in order.
+void BM_TimeEventAddGetTop(benchmark::State& state) {
+  const int size = static_cast<int>(state.range(0));
+  TimeEventHeap heap(size);
+
+  for (auto _ : state) {
+    heap.Fill();
+    while (iotc_time_event_t* top = iotc_time_event_get_top(heap.vector())) {
+      benchmark::DoNotOptimize(top);
+    }
+  }
+
+  state.SetItemsProcessed(state.iterations() * size);
+}
+BENCHMARK(BM_TimeEventAddGetTop)->Arg(8)->Arg(32)->Arg(kMaxHeapSize);
+
+// Moves one time event up and down the heap, like a restarted timeout.
+void BM_TimeEventRestart(benchmark::State& state) {
+  const int size = static_cast<int>(state.range(0));
+  TimeEventHeap heap(size);
+  heap.Fill();
+
+  iotc_time_t new_time = 0;
+  for (auto _ : state) {
+    iotc_time_event_restart(heap.vector(), heap.handle(size / 2),
+                            new_time = 1000 - new_time);
+  }
+}
+BENCHMARK(BM_TimeEventRestart)->Arg(8)->Arg(32)->Arg(kMaxHeapSize);
+
+// Cancels the time events from the middle of the heap.
+void BM_TimeEventCancel(benchmark::State& state) {
+  const int size = static_cast<int>(state.range(0));
+  TimeEventHeap heap(size);
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    heap.Fill();
+    state.ResumeTiming();
+
+    for (int i = 0; i < size; ++i) {
+      iotc_time_event_t* cancelled = nullptr;
+      iotc_time_event_cancel(heap.vector(), heap.handle((i + size / 2) % size),
+                             &cancelled);
+      benchmark::DoNotOptimize(cancelled);
+    }
+  }
+
+  state.SetItemsProcessed(state.iterations() * size);
+}
+BENCHMARK(BM_TimeEventCancel)->Arg(8)->Arg(32)->Arg(kMaxHeapSize);
+
+}  // namespace
+}  // namespace iotctest
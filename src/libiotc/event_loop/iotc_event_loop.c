@@ -45,6 +45,59 @@ static size_t iotc_bsp_event_loop_count_all_sockets(
   return ret_num_of_sockets;
 }
 
+#ifdef IOTC_MODULE_THREAD_ENABLED
+/**
+ * @brief iotc_event_loop_arm_wakeups
+ *
+ * Appends the wakeup descriptors of the dispatchers to the select array.
+ * Has to be called before the timeout is calculated.
+ *
+ * @return number of wakeup descriptors added
+ */
+static size_t iotc_event_loop_arm_wakeups(
+    iotc_evtd_instance_t** event_dispatchers, uint8_t num_evtds,
+    iotc_bsp_socket_events_t* out_wakeup_events_array) {
+  size_t wakeup_id = 0;
+
+  uint8_t evtd_id = 0;
+  for (; evtd_id < num_evtds; ++evtd_id) {
+    iotc_fd_t wakeup_fd = 0;
+
+    if (1 == iotc_evtd_arm_wakeup(event_dispatchers[evtd_id], &wakeup_fd)) {
+      out_wakeup_events_array[wakeup_id].iotc_socket = wakeup_fd;
+      out_wakeup_events_array[wakeup_id].in_socket_want_read = 1;
+      wakeup_id += 1;
+    }
+  }
+
+  return wakeup_id;
+}
+
+static void iotc_event_loop_disarm_wakeups(
+    iotc_evtd_instance_t** event_dispatchers, uint8_t num_evtds,
+    iotc_bsp_socket_events_t* wakeup_events_array,
+    iotc_bsp_io_net_state_t select_state) {
+  size_t wakeup_id = 0;
+
+  uint8_t evtd_id = 0;
+  for (; evtd_id < num_evtds; ++evtd_id) {
+    iotc_evtd_instance_t* event_dispatcher = event_dispatchers[evtd_id];
+
+    if (NULL == event_dispatcher->wakeup) {
+      continue;
+    }
+
+    iotc_evtd_disarm_wakeup(
+        event_dispatcher,
+        (IOTC_BSP_IO_NET_STATE_OK == select_state &&
+         1 == wakeup_events_array[wakeup_id].out_socket_can_read)
+            ? 1
+            : 0);
+    wakeup_id += 1;
+  }
+}
+#endif
+
 iotc_state_t iotc_bsp_event_loop_transform_to_bsp_select(
     iotc_evtd_instance_t** in_event_dispatchers, uint8_t in_num_evtds,
     iotc_bsp_socket_events_t* in_socket_events_array,
@@ -66,6 +119,12 @@ iotc_state_t iotc_bsp_event_loop_transform_to_bsp_select(
 
     iotc_vector_index_type_t i = 0;
 
+    /* handles submitted by other threads are due right away */
+    if (0 == iotc_mpsc_queue_is_empty(&event_dispatcher->call_queue)) {
+      timeout_candidate = 0;
+      was_timeout_candidate_set = 1;
+    }
+
     /* pick the smallest possible timeout with respect to all dispatchers */
     {
       iotc_time_t tmp_timeout = 0;
@@ -152,49 +211,53 @@ iotc_state_t iotc_bsp_event_loop_update_event_dispatcher(
     return IOTC_INVALID_PARAMETER;
   }
 
+  /* mark things unused cause release build won't compile assertions */
+  IOTC_UNUSED(in_socket_events_array_length);
+
   iotc_state_t state = IOTC_STATE_OK;
   size_t socket_id = 0;
 
+  /* The handlers register and unregister sockets while the events are
+   * dispatched, so the sockets of each dispatcher are counted before the
+   * first handler runs and the array filled by the select is walked instead
+   * of the dispatcher's socket vector. */
+  size_t num_sockets_of_evtd[in_num_evtds];
+
   uint8_t evtd_id = 0;
   for (evtd_id = 0; evtd_id < in_num_evtds; ++evtd_id) {
-    iotc_evtd_instance_t* event_dispatcher = in_event_dispatchers[evtd_id];
-
-    iotc_vector_index_type_t i = 0;
-
-    for (i = 0; i < event_dispatcher->handles_and_socket_fd->elem_no; ++i) {
-      iotc_evtd_fd_tuple_t* tuple =
-          (iotc_evtd_fd_tuple_t*)event_dispatcher->handles_and_socket_fd
-              ->array[i]
-              .selector_t.ptr_value;
+    num_sockets_of_evtd[evtd_id] =
+        (size_t)in_event_dispatchers[evtd_id]->handles_and_socket_fd->elem_no;
+  }
 
-      /* mark things unused cause release build won't compile assertions */
-      IOTC_UNUSED(tuple);
-      IOTC_UNUSED(in_socket_events_array_length);
+  for (evtd_id = 0; evtd_id < in_num_evtds; ++evtd_id) {
+    iotc_evtd_instance_t* event_dispatcher = in_event_dispatchers[evtd_id];
 
-      /* sanity check */
-      assert(NULL != tuple);
+    size_t i = 0;
 
+    for (i = 0; i < num_sockets_of_evtd[evtd_id]; ++i) {
       /* make sure that the socket_id is valid */
       assert(socket_id < in_socket_events_array_length);
       iotc_bsp_socket_events_t* socket_to_update =
           &in_socket_events_array[socket_id];
 
-      /* sanity check on retrieved value */
-      assert(NULL != socket_to_update);
+      socket_id += 1;
 
-      /* sanity check on socket id */
-      assert(tuple->fd == socket_to_update->iotc_socket);
+      if (0 == socket_to_update->out_socket_can_read &&
+          0 == socket_to_update->out_socket_can_write &&
+          0 == socket_to_update->out_socket_connect_finished &&
+          0 == socket_to_update->out_socket_error) {
+        continue;
+      }
 
-      if (0 != socket_to_update->out_socket_can_read ||
-          0 != socket_to_update->out_socket_can_write ||
-          0 != socket_to_update->out_socket_connect_finished ||
-          0 != socket_to_update->out_socket_error) {
-        state = iotc_evtd_update_event_on_socket(event_dispatcher,
-                                                 socket_to_update->iotc_socket);
-        IOTC_CHECK_STATE(state);
+      /* a handler which ran before may have closed the socket */
+      if (0 == iotc_evtd_is_socket_fd_registered(
+                   event_dispatcher, socket_to_update->iotc_socket)) {
+        continue;
       }
 
-      socket_id += 1;
+      state = iotc_evtd_update_event_on_socket(event_dispatcher,
+                                               socket_to_update->iotc_socket);
+      IOTC_CHECK_STATE(state);
     }
   }
 
@@ -220,14 +283,30 @@ iotc_state_t iotc_event_loop_with_evtds(
     const size_t no_of_sockets_to_update =
         iotc_bsp_event_loop_count_all_sockets(event_dispatchers, num_evtds);
 
+#ifdef IOTC_MODULE_THREAD_ENABLED
+    /* one extra slot per dispatcher for its wakeup descriptor */
+    const size_t no_of_wakeup_slots = num_evtds;
+#else
+    const size_t no_of_wakeup_slots = 0;
+#endif
+
     /* allocate and prepare space for the sockets */
     iotc_bsp_socket_events_t
-        array_of_sockets_to_update[no_of_sockets_to_update];
+        array_of_sockets_to_update[no_of_sockets_to_update +
+                                   no_of_wakeup_slots];
     memset(array_of_sockets_to_update, 0,
-           sizeof(iotc_bsp_socket_events_t) * no_of_sockets_to_update);
+           sizeof(iotc_bsp_socket_events_t) *
+               (no_of_sockets_to_update + no_of_wakeup_slots));
 
     /* for storing the timeout */
     iotc_time_t timeout = 0;
+    size_t no_of_wakeups = 0;
+
+#ifdef IOTC_MODULE_THREAD_ENABLED
+    no_of_wakeups = iotc_event_loop_arm_wakeups(
+        event_dispatchers, num_evtds,
+        &array_of_sockets_to_update[no_of_sockets_to_update]);
+#endif
 
     /* transpose data from event dispatcher to socketd to update array */
     state = iotc_bsp_event_loop_transform_to_bsp_select(
@@ -238,7 +317,13 @@ iotc_state_t iotc_event_loop_with_evtds(
     /* call the bsp select function */
     const iotc_bsp_io_net_state_t select_state = iotc_bsp_io_net_select(
         (iotc_bsp_socket_events_t*)&array_of_sockets_to_update,
-        no_of_sockets_to_update, timeout);
+        no_of_sockets_to_update + no_of_wakeups, timeout);
+
+#ifdef IOTC_MODULE_THREAD_ENABLED
+    iotc_event_loop_disarm_wakeups(
+        event_dispatchers, num_evtds,
+        &array_of_sockets_to_update[no_of_sockets_to_update], select_state);
+#endif
 
     if (IOTC_BSP_IO_NET_STATE_OK == select_state) {
       /* tranform output from bsp select to event dispatcher updates */
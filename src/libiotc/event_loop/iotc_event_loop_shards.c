@@ -0,0 +1,187 @@
+/* Copyright 2018-2020 Google LLC
+ *
+ * This is part of the Google Cloud IoT Device SDK for Embedded C.
+ * It is licensed under the BSD 3-Clause license; you may not use this file
+ * except in compliance with the License.
+ *
+ * You may obtain a copy of the License at:
+ *  https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "iotc_event_loop_shards.h"
+#include "iotc_critical_section.h"
+#include "iotc_critical_section_def.h"
+#include "iotc_debug.h"
+#include "iotc_macros.h"
+#include "iotc_thread_loopthread.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef IOTC_MODULE_THREAD_ENABLED
+
+typedef struct iotc_event_loop_shard_s {
+  iotc_evtd_instance_t* evtd_instance;
+  struct iotc_loopthread_s* loopthread;
+  uint32_t num_contexts;
+} iotc_event_loop_shard_t;
+
+/* static initialisation of the critical section */
+static struct iotc_critical_section_s iotc_event_loop_shards_cs = {0};
+
+static iotc_event_loop_shard_t
+    iotc_event_loop_shards[IOTC_EVENT_LOOP_MAX_SHARDS];
+static uint8_t iotc_event_loop_num_shards = 0;
+
+static void iotc_event_loop_shards_destroy(const uint8_t num_shards) {
+  uint8_t shard_id = 0;
+
+  /* stop all the loops first so that the joins overlap */
+  for (; shard_id < num_shards; ++shard_id) {
+    if (NULL != iotc_event_loop_shards[shard_id].evtd_instance) {
+      iotc_evtd_stop(iotc_event_loop_shards[shard_id].evtd_instance);
+    }
+  }
+
+  for (shard_id = 0; shard_id < num_shards; ++shard_id) {
+    iotc_event_loop_shard_t* shard = &iotc_event_loop_shards[shard_id];
+
+    iotc_loopthread_destroy_instance(&shard->loopthread);
+    iotc_evtd_destroy_instance(shard->evtd_instance);
+
+    shard->evtd_instance = NULL;
+    shard->num_contexts = 0;
+  }
+}
+
+iotc_state_t iotc_event_loop_shards_start(uint8_t num_shards) {
+  if (0 == num_shards || IOTC_EVENT_LOOP_MAX_SHARDS < num_shards) {
+    return IOTC_INVALID_PARAMETER;
+  }
+
+  iotc_state_t state = IOTC_STATE_OK;
+  uint8_t shard_id = 0;
+
+  iotc_lock_critical_section(&iotc_event_loop_shards_cs);
+
+  if (0 != iotc_event_loop_num_shards) {
+    iotc_unlock_critical_section(&iotc_event_loop_shards_cs);
+    return IOTC_ALREADY_INITIALIZED;
+  }
+
+  for (; shard_id < num_shards; ++shard_id) {
+    iotc_event_loop_shard_t* shard = &iotc_event_loop_shards[shard_id];
+
+    shard->num_contexts = 0;
+    shard->evtd_instance = iotc_evtd_create_instance();
+
+    IOTC_CHECK_MEMORY(shard->evtd_instance, state);
+    IOTC_CHECK_STATE(state = iotc_evtd_enable_wakeup(shard->evtd_instance));
+
+    shard->loopthread = iotc_loopthread_create_instance(shard->evtd_instance);
+
+    IOTC_CHECK_CND_DBGMESSAGE(NULL == shard->loopthread, IOTC_THREAD_ERROR,
+                              state, "could not start the shard loopthread");
+  }
+
+  iotc_event_loop_num_shards = num_shards;
+
+  iotc_unlock_critical_section(&iotc_event_loop_shards_cs);
+
+  return IOTC_STATE_OK;
+
+err_handling:
+  iotc_event_loop_shards_destroy(shard_id + 1);
+  iotc_unlock_critical_section(&iotc_event_loop_shards_cs);
+
+  return state;
+}
+
+iotc_state_t iotc_event_loop_shards_stop(void) {
+  uint8_t shard_id = 0;
+
+  iotc_lock_critical_section(&iotc_event_loop_shards_cs);
+
+  for (; shard_id < iotc_event_loop_num_shards; ++shard_id) {
+    if (0 != iotc_event_loop_shards[shard_id].num_contexts) {
+      iotc_unlock_critical_section(&iotc_event_loop_shards_cs);
+      return IOTC_INVALID_PARAMETER;
+    }
+  }
+
+  iotc_event_loop_shards_destroy(iotc_event_loop_num_shards);
+  iotc_event_loop_num_shards = 0;
+
+  iotc_unlock_critical_section(&iotc_event_loop_shards_cs);
+
+  return IOTC_STATE_OK;
+}
+
+iotc_evtd_instance_t* iotc_event_loop_shards_acquire(void) {
+  iotc_event_loop_shard_t* least_loaded = NULL;
+  uint8_t shard_id = 0;
+
+  iotc_lock_critical_section(&iotc_event_loop_shards_cs);
+
+  for (; shard_id < iotc_event_loop_num_shards; ++shard_id) {
+    iotc_event_loop_shard_t* shard = &iotc_event_loop_shards[shard_id];
+
+    if (NULL == least_loaded ||
+        shard->num_contexts < least_loaded->num_contexts) {
+      least_loaded = shard;
+    }
+  }
+
+  if (NULL != least_loaded) {
+    least_loaded->num_contexts += 1;
+  }
+
+  iotc_unlock_critical_section(&iotc_event_loop_shards_cs);
+
+  return (NULL != least_loaded) ? least_loaded->evtd_instance : NULL;
+}
+
+void iotc_event_loop_shards_release(iotc_evtd_instance_t* evtd) {
+  uint8_t shard_id = 0;
+
+  iotc_lock_critical_section(&iotc_event_loop_shards_cs);
+
+  for (; shard_id < iotc_event_loop_num_shards; ++shard_id) {
+    iotc_event_loop_shard_t* shard = &iotc_event_loop_shards[shard_id];
+
+    if (evtd == shard->evtd_instance && 0 < shard->num_contexts) {
+      shard->num_contexts -= 1;
+      break;
+    }
+  }
+
+  iotc_unlock_critical_section(&iotc_event_loop_shards_cs);
+}
+
+#else
+
+iotc_state_t iotc_event_loop_shards_start(uint8_t num_shards) {
+  IOTC_UNUSED(num_shards);
+  return IOTC_NOT_SUPPORTED;
+}
+
+iotc_state_t iotc_event_loop_shards_stop(void) { return IOTC_NOT_SUPPORTED; }
+
+iotc_evtd_instance_t* iotc_event_loop_shards_acquire(void) { return NULL; }
+
+void iotc_event_loop_shards_release(iotc_evtd_instance_t* evtd) {
+  IOTC_UNUSED(evtd);
+}
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,73 @@
+/* Copyright 2018-2020 Google LLC
+ *
+ * This is part of the Google Cloud IoT Device SDK for Embedded C.
+ * It is licensed under the BSD 3-Clause license; you may not use this file
+ * except in compliance with the License.
+ *
+ * You may obtain a copy of the License at:
+ *  https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __IOTC_EVENT_LOOP_SHARDS_H__
+#define __IOTC_EVENT_LOOP_SHARDS_H__
+
+#include <stdint.h>
+
+#include "iotc_event_dispatcher_api.h"
+
+#include <iotc_error.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef IOTC_EVENT_LOOP_MAX_SHARDS
+#define IOTC_EVENT_LOOP_MAX_SHARDS 16
+#endif
+
+/**
+ * Event loop shards: a fixed set of dispatchers, each one run by the blocking
+ * event loop on its own thread. Contexts are pinned to a shard when they are
+ * created and all of their layers, io timeouts and timed tasks run on that
+ * shard's thread. Only available with the thread module, without it start
+ * returns IOTC_NOT_SUPPORTED and acquire always returns NULL.
+ */
+
+/**
+ * @brief creates the dispatchers and starts one loop thread per shard
+ *
+ * @return IOTC_ALREADY_INITIALIZED if the shards are already running
+ */
+extern iotc_state_t iotc_event_loop_shards_start(uint8_t num_shards);
+
+/**
+ * @brief stops and joins the loop threads, then destroys the dispatchers
+ *
+ * @return IOTC_INVALID_PARAMETER while contexts are still assigned to a shard
+ */
+extern iotc_state_t iotc_event_loop_shards_stop(void);
+
+/**
+ * @brief picks the shard with the fewest contexts and counts one more on it
+ *
+ * @return the dispatcher of the shard or NULL if no shards are running
+ */
+extern iotc_evtd_instance_t* iotc_event_loop_shards_acquire(void);
+
+/**
+ * @brief counts one context less on the shard that owns the dispatcher,
+ * dispatchers that don't belong to a shard are ignored
+ */
+extern void iotc_event_loop_shards_release(iotc_evtd_instance_t* evtd);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __IOTC_EVENT_LOOP_SHARDS_H__ */
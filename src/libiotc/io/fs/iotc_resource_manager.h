@@ -18,6 +18,7 @@
 #define __IOTC_RESOURCE_MANAGER_H__
 
 #include "iotc_data_desc.h"
+#include "iotc_event_dispatcher_api.h"
 #include "iotc_event_handle.h"
 #include "iotc_fs_api.h"
 
@@ -33,6 +34,9 @@ typedef struct iotc_resource_manager_context_s {
    * While it is set means that one of the operation is pending( open, read,
    * write, close )*/
   iotc_event_handle_t callback;
+  /* dispatcher the operations and the callback are scheduled on, defaults to
+   * the global one */
+  iotc_evtd_instance_t* evtd_instance;
   iotc_fs_stat_t resource_stat; /* copy of the resource stat passed with open */
   iotc_fs_resource_handle_t resource_handle; /* handle to the opened resource */
   iotc_fs_open_flags_t open_flags; /* copy of open flags passed with open */
@@ -0,0 +1,177 @@
+/* Copyright 2018-2020 Google LLC
+ *
+ * This is part of the Google Cloud IoT Device SDK for Embedded C.
+ * It is licensed under the BSD 3-Clause license; you may not use this file
+ * except in compliance with the License.
+ *
+ * You may obtain a copy of the License at:
+ *  https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "iotc_dns_cache.h"
+
+#include <string.h>
+
+#include "iotc_critical_section.h"
+#include "iotc_critical_section_def.h"
+#include "iotc_debug.h"
+#include "iotc_macros.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct iotc_dns_cache_entry_s {
+  char host[IOTC_DNS_HOST_MAX_LEN + 1]; /* empty if the entry is free */
+  iotc_dns_addresses_t addresses;       /* no address for negative entries */
+  iotc_time_t expires_at;
+} iotc_dns_cache_entry_t;
+
+static iotc_dns_cache_entry_t iotc_dns_cache[IOTC_DNS_CACHE_SIZE];
+
+static struct iotc_critical_section_s iotc_dns_cache_cs = {0};
+
+/* host names are case insensitive, a trailing dot doesn't matter */
+static uint8_t iotc_dns_cache_host_equals(const char* cached,
+                                          const char* host) {
+  for (; '\0' != *cached && '\0' != *host; ++cached, ++host) {
+    char a = *cached;
+    char b = *host;
+
+    a = ('A' <= a && 'Z' >= a) ? a - 'A' + 'a' : a;
+    b = ('A' <= b && 'Z' >= b) ? b - 'A' + 'a' : b;
+
+    if (a != b) {
+      return 0;
+    }
+  }
+
+  if ('.' == *host) {
+    ++host;
+  }
+
+  return ('\0' == *cached && '\0' == *host) ? 1 : 0;
+}
+
+static iotc_dns_cache_entry_t* iotc_dns_cache_find_locked(const char* host) {
+  size_t i = 0;
+  for (; i < IOTC_DNS_CACHE_SIZE; ++i) {
+    if ('\0' != iotc_dns_cache[i].host[0] &&
+        1 == iotc_dns_cache_host_equals(iotc_dns_cache[i].host, host)) {
+      return &iotc_dns_cache[i];
+    }
+  }
+
+  return NULL;
+}
+
+uint8_t iotc_dns_cache_lookup(const char* host, iotc_time_t now,
+                              iotc_dns_addresses_t* out_addresses,
+                              iotc_state_t* out_state) {
+  assert(NULL != out_addresses);
+  assert(NULL != out_state);
+
+  if (NULL == host) {
+    return 0;
+  }
+
+  /* just to satisfy the compiler */
+  (void)iotc_dns_cache_cs;
+
+  uint8_t hit = 0;
+
+  iotc_lock_critical_section(&iotc_dns_cache_cs);
+
+  iotc_dns_cache_entry_t* entry = iotc_dns_cache_find_locked(host);
+
+  if (NULL != entry) {
+    if (now < entry->expires_at) {
+      *out_addresses = entry->addresses;
+      *out_state = (0 < entry->addresses.count)
+                       ? IOTC_STATE_OK
+                       : IOTC_SOCKET_GETHOSTBYNAME_ERROR;
+      hit = 1;
+    } else {
+      entry->host[0] = '\0';
+    }
+  }
+
+  iotc_unlock_critical_section(&iotc_dns_cache_cs);
+
+  return hit;
+}
+
+void iotc_dns_cache_store(const char* host,
+                          const iotc_dns_addresses_t* addresses, uint32_t ttl,
+                          iotc_time_t now) {
+  if (NULL == host || IOTC_DNS_HOST_MAX_LEN < strlen(host)) {
+    return;
+  }
+
+  const uint8_t is_negative =
+      (NULL == addresses || 0 == addresses->count) ? 1 : 0;
+
+  ttl = IOTC_MIN(ttl, (uint32_t)(is_negative ? IOTC_DNS_NEGATIVE_CACHE_MAX_TTL
+                                             : IOTC_DNS_CACHE_MAX_TTL));
+
+  iotc_lock_critical_section(&iotc_dns_cache_cs);
+
+  iotc_dns_cache_entry_t* entry = iotc_dns_cache_find_locked(host);
+
+  if (0 == ttl) {
+    if (NULL != entry) {
+      entry->host[0] = '\0';
+    }
+
+    iotc_unlock_critical_section(&iotc_dns_cache_cs);
+    return;
+  }
+
+  /* a free or expired entry, otherwise the one that expires first */
+  size_t i = 0;
+  for (; NULL == entry && i < IOTC_DNS_CACHE_SIZE; ++i) {
+    if ('\0' == iotc_dns_cache[i].host[0] ||
+        iotc_dns_cache[i].expires_at <= now) {
+      entry = &iotc_dns_cache[i];
+    }
+  }
+
+  if (NULL == entry) {
+    entry = &iotc_dns_cache[0];
+
+    for (i = 1; i < IOTC_DNS_CACHE_SIZE; ++i) {
+      if (iotc_dns_cache[i].expires_at < entry->expires_at) {
+        entry = &iotc_dns_cache[i];
+      }
+    }
+  }
+
+  strcpy(entry->host, host);
+  memset(&entry->addresses, 0, sizeof(entry->addresses));
+
+  if (0 == is_negative) {
+    entry->addresses = *addresses;
+  }
+
+  entry->expires_at = now + ttl;
+
+  iotc_unlock_critical_section(&iotc_dns_cache_cs);
+}
+
+void iotc_dns_cache_flush(void) {
+  iotc_lock_critical_section(&iotc_dns_cache_cs);
+
+  memset(iotc_dns_cache, 0, sizeof(iotc_dns_cache));
+
+  iotc_unlock_critical_section(&iotc_dns_cache_cs);
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,66 @@
+/* Copyright 2018-2020 Google LLC
+ *
+ * This is part of the Google Cloud IoT Device SDK for Embedded C.
+ * It is licensed under the BSD 3-Clause license; you may not use this file
+ * except in compliance with the License.
+ *
+ * You may obtain a copy of the License at:
+ *  https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __IOTC_DNS_CACHE_H__
+#define __IOTC_DNS_CACHE_H__
+
+#include <stdint.h>
+
+#include "iotc_dns_message.h"
+
+#include <iotc_error.h>
+#include <iotc_time.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Process wide cache of resolved host names shared by all the contexts.
+ *
+ * Positive entries live for the lowest TTL of their records, capped at
+ * IOTC_DNS_CACHE_MAX_TTL. Names which don't exist or have no address are
+ * cached as negative entries for the negative caching TTL of their zone,
+ * capped at IOTC_DNS_NEGATIVE_CACHE_MAX_TTL. When the cache is full the entry
+ * closest to its expiry is replaced.
+ */
+
+/**
+ * @brief looks the host up
+ *
+ * @return 1 on a hit, the addresses are copied out and out_state is set to
+ * IOTC_SOCKET_GETHOSTBYNAME_ERROR for a negative entry; 0 if there is no
+ * entry or it has expired
+ */
+extern uint8_t iotc_dns_cache_lookup(const char* host, iotc_time_t now,
+                                     iotc_dns_addresses_t* out_addresses,
+                                     iotc_state_t* out_state);
+
+/**
+ * @brief stores the addresses of the host, a NULL or empty addresses stores
+ * a negative entry; a zero TTL removes the host from the cache
+ */
+extern void iotc_dns_cache_store(const char* host,
+                                 const iotc_dns_addresses_t* addresses,
+                                 uint32_t ttl, iotc_time_t now);
+
+extern void iotc_dns_cache_flush(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __IOTC_DNS_CACHE_H__ */
@@ -0,0 +1,409 @@
+/* Copyright 2018-2020 Google LLC
+ *
+ * This is part of the Google Cloud IoT Device SDK for Embedded C.
+ * It is licensed under the BSD 3-Clause license; you may not use this file
+ * except in compliance with the License.
+ *
+ * You may obtain a copy of the License at:
+ *  https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "iotc_dns_message.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "iotc_debug.h"
+#include "iotc_macros.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define IOTC_DNS_HEADER_SIZE 12
+#define IOTC_DNS_LABEL_MAX_LEN 63
+
+#define IOTC_DNS_TYPE_CNAME 5
+#define IOTC_DNS_TYPE_SOA 6
+#define IOTC_DNS_CLASS_IN 1
+
+#define IOTC_DNS_FLAG_RESPONSE 0x8000
+#define IOTC_DNS_FLAG_TRUNCATED 0x0200
+#define IOTC_DNS_FLAG_RECURSION_DESIRED 0x0100
+#define IOTC_DNS_OPCODE_MASK 0x7800
+#define IOTC_DNS_RCODE_MASK 0x000F
+
+#define IOTC_DNS_RCODE_NO_ERROR 0
+#define IOTC_DNS_RCODE_NAME_ERROR 3
+
+/* serial, refresh, retry, expire, minimum */
+#define IOTC_DNS_SOA_TAIL_SIZE 20
+
+static uint16_t iotc_dns_read_u16(const uint8_t* ptr) {
+  return (uint16_t)((ptr[0] << 8) | ptr[1]);
+}
+
+static uint32_t iotc_dns_read_u32(const uint8_t* ptr) {
+  return ((uint32_t)ptr[0] << 24) | ((uint32_t)ptr[1] << 16) |
+         ((uint32_t)ptr[2] << 8) | (uint32_t)ptr[3];
+}
+
+static void iotc_dns_write_u16(uint8_t* ptr, uint16_t value) {
+  ptr[0] = (uint8_t)(value >> 8);
+  ptr[1] = (uint8_t)(value & 0xFF);
+}
+
+/* returns the offset right behind the name, 0 if the name is malformed */
+static size_t iotc_dns_skip_name(const uint8_t* buffer, size_t len,
+                                 size_t pos) {
+  while (pos < len) {
+    const uint8_t label_len = buffer[pos];
+
+    if (0 == label_len) {
+      return pos + 1;
+    }
+
+    /* a compression pointer ends the name */
+    if (0xC0 == (label_len & 0xC0)) {
+      return (pos + 2 <= len) ? pos + 2 : 0;
+    }
+
+    if (0 != (label_len & 0xC0)) {
+      return 0;
+    }
+
+    pos += 1 + label_len;
+  }
+
+  return 0;
+}
+
+static char iotc_dns_to_lower(char c) {
+  return ('A' <= c && 'Z' >= c) ? (char)(c - 'A' + 'a') : c;
+}
+
+/* Walks the labels of the name at pos, following the compression pointers.
+ * With a NULL out_name the labels are compared with the first name_len
+ * characters of name, case insensitively, otherwise they are copied to
+ * out_name, name_len being its size. Pointers have to point backwards so
+ * they can't loop. Returns 1 if the name matches or fits, 0 otherwise. */
+static uint8_t iotc_dns_walk_name(const uint8_t* buffer, size_t len,
+                                  size_t pos, const char* name,
+                                  char* out_name, size_t name_len) {
+  size_t i = 0;
+
+  while (pos < len) {
+    const uint8_t label_len = buffer[pos];
+
+    if (0 == label_len) {
+      if (NULL != out_name) {
+        out_name[i] = '\0';
+        return 1;
+      }
+
+      return (i == name_len) ? 1 : 0;
+    }
+
+    if (0xC0 == (label_len & 0xC0)) {
+      if (len < pos + 2) {
+        return 0;
+      }
+
+      const size_t target = ((size_t)(label_len & 0x3F) << 8) | buffer[pos + 1];
+
+      if (target >= pos) {
+        return 0;
+      }
+
+      pos = target;
+      continue;
+    }
+
+    if (0 != (label_len & 0xC0) || len < pos + 1 + label_len) {
+      return 0;
+    }
+
+    /* the separator, then the label */
+    size_t j = 0;
+    for (; j <= label_len; ++j) {
+      const char c = (0 == j) ? '.' : (char)buffer[pos + j];
+
+      if (0 == j && 0 == i) {
+        continue;
+      }
+
+      if (i >= name_len || (0 != j && '.' == c)) {
+        return 0;
+      }
+
+      if (NULL != out_name) {
+        out_name[i] = c;
+      } else if (iotc_dns_to_lower(name[i]) != iotc_dns_to_lower(c)) {
+        return 0;
+      }
+
+      i += 1;
+    }
+
+    pos += 1 + label_len;
+  }
+
+  return 0;
+}
+
+static uint8_t iotc_dns_name_equals(const uint8_t* buffer, size_t len,
+                                    size_t pos, const char* name,
+                                    size_t name_len) {
+  return iotc_dns_walk_name(buffer, len, pos, name, NULL, name_len);
+}
+
+/* copies the name at pos to name as a dotted, NUL terminated string */
+static uint8_t iotc_dns_read_name(const uint8_t* buffer, size_t len,
+                                  size_t pos, char* name, size_t name_size) {
+  /* room for the terminator */
+  return iotc_dns_walk_name(buffer, len, pos, NULL, name, name_size - 1);
+}
+
+static void iotc_dns_format_address(const uint8_t* rdata, uint16_t type,
+                                    iotc_dns_address_t* address) {
+  if (IOTC_DNS_TYPE_A == type) {
+    address->protocol = PROTOCOL_IPV4;
+    snprintf(address->host, sizeof(address->host), "%u.%u.%u.%u", rdata[0],
+             rdata[1], rdata[2], rdata[3]);
+  } else {
+    address->protocol = PROTOCOL_IPV6;
+    snprintf(address->host, sizeof(address->host), "%x:%x:%x:%x:%x:%x:%x:%x",
+             iotc_dns_read_u16(rdata), iotc_dns_read_u16(rdata + 2),
+             iotc_dns_read_u16(rdata + 4), iotc_dns_read_u16(rdata + 6),
+             iotc_dns_read_u16(rdata + 8), iotc_dns_read_u16(rdata + 10),
+             iotc_dns_read_u16(rdata + 12), iotc_dns_read_u16(rdata + 14));
+  }
+}
+
+iotc_state_t iotc_dns_message_encode_query(uint16_t id, const char* host,
+                                           uint16_t type, uint8_t* buffer,
+                                           size_t buffer_size,
+                                           size_t* out_len) {
+  if (NULL == host || NULL == buffer || NULL == out_len) {
+    return IOTC_INVALID_PARAMETER;
+  }
+
+  size_t host_len = strlen(host);
+
+  /* a fully qualified name may end with the root label */
+  if (0 < host_len && '.' == host[host_len - 1]) {
+    host_len -= 1;
+  }
+
+  if (0 == host_len || IOTC_DNS_HOST_MAX_LEN < host_len) {
+    return IOTC_INVALID_PARAMETER;
+  }
+
+  /* header, length prefixed labels, root label, type and class */
+  if (buffer_size < IOTC_DNS_HEADER_SIZE + host_len + 2 + 4) {
+    return IOTC_BUFFER_TOO_SMALL_ERROR;
+  }
+
+  memset(buffer, 0, IOTC_DNS_HEADER_SIZE);
+  iotc_dns_write_u16(buffer, id);
+  iotc_dns_write_u16(buffer + 2, IOTC_DNS_FLAG_RECURSION_DESIRED);
+  iotc_dns_write_u16(buffer + 4, 1);
+
+  size_t pos = IOTC_DNS_HEADER_SIZE;
+  size_t label_start = 0;
+  size_t i = 0;
+
+  for (; i <= host_len; ++i) {
+    if (i < host_len && '.' != host[i]) {
+      continue;
+    }
+
+    const size_t label_len = i - label_start;
+
+    if (0 == label_len || IOTC_DNS_LABEL_MAX_LEN < label_len) {
+      return IOTC_INVALID_PARAMETER;
+    }
+
+    buffer[pos++] = (uint8_t)label_len;
+    memcpy(buffer + pos, host + label_start, label_len);
+    pos += label_len;
+
+    label_start = i + 1;
+  }
+
+  buffer[pos++] = 0;
+
+  iotc_dns_write_u16(buffer + pos, type);
+  iotc_dns_write_u16(buffer + pos + 2, IOTC_DNS_CLASS_IN);
+  pos += 4;
+
+  *out_len = pos;
+
+  return IOTC_STATE_OK;
+}
+
+iotc_dns_answer_t iotc_dns_message_parse_response(
+    const uint8_t* buffer, size_t len, uint16_t id, const char* host,
+    uint16_t type, iotc_dns_addresses_t* addresses, uint32_t* ttl) {
+  assert(NULL != host);
+  assert(NULL != addresses);
+  assert(NULL != ttl);
+
+  if (NULL == buffer || len < IOTC_DNS_HEADER_SIZE ||
+      iotc_dns_read_u16(buffer) != id) {
+    return IOTC_DNS_ANSWER_MALFORMED;
+  }
+
+  /* the end of the chain of aliases, the host to begin with */
+  char chain_name[IOTC_DNS_HOST_MAX_LEN + 1];
+  size_t chain_name_len = strlen(host);
+
+  if (0 < chain_name_len && '.' == host[chain_name_len - 1]) {
+    chain_name_len -= 1;
+  }
+
+  if (IOTC_DNS_HOST_MAX_LEN < chain_name_len) {
+    return IOTC_DNS_ANSWER_MALFORMED;
+  }
+
+  memcpy(chain_name, host, chain_name_len);
+  chain_name[chain_name_len] = '\0';
+
+  const uint16_t flags = iotc_dns_read_u16(buffer + 2);
+  const uint16_t question_count = iotc_dns_read_u16(buffer + 4);
+  const uint16_t answer_count = iotc_dns_read_u16(buffer + 6);
+  const uint16_t authority_count = iotc_dns_read_u16(buffer + 8);
+
+  if (0 == (flags & IOTC_DNS_FLAG_RESPONSE) ||
+      0 != (flags & IOTC_DNS_OPCODE_MASK) || 1 != question_count) {
+    return IOTC_DNS_ANSWER_MALFORMED;
+  }
+
+  /* the question has to be the one that was asked */
+  size_t pos = iotc_dns_skip_name(buffer, len, IOTC_DNS_HEADER_SIZE);
+
+  if (0 == pos || len < pos + 4 || iotc_dns_read_u16(buffer + pos) != type ||
+      0 == iotc_dns_name_equals(buffer, len, IOTC_DNS_HEADER_SIZE, chain_name,
+                                chain_name_len)) {
+    return IOTC_DNS_ANSWER_MALFORMED;
+  }
+
+  pos += 4;
+
+  const uint16_t rcode = flags & IOTC_DNS_RCODE_MASK;
+
+  if ((IOTC_DNS_RCODE_NO_ERROR != rcode &&
+       IOTC_DNS_RCODE_NAME_ERROR != rcode) ||
+      0 != (flags & IOTC_DNS_FLAG_TRUNCATED)) {
+    return IOTC_DNS_ANSWER_SERVER_FAILURE;
+  }
+
+  /* nothing is handed out unless the whole message is well formed */
+  iotc_dns_addresses_t parsed = *addresses;
+  uint8_t found = 0;
+  uint32_t min_ttl = UINT32_MAX;
+  uint32_t negative_ttl = IOTC_DNS_NEGATIVE_CACHE_TTL;
+
+  const uint32_t record_count = (uint32_t)answer_count + authority_count;
+  uint32_t record = 0;
+
+  for (; record < record_count; ++record) {
+    const size_t name_pos = pos;
+    pos = iotc_dns_skip_name(buffer, len, pos);
+
+    /* type, class, ttl and rdata length */
+    if (0 == pos || len < pos + 10) {
+      return IOTC_DNS_ANSWER_MALFORMED;
+    }
+
+    const uint16_t record_type = iotc_dns_read_u16(buffer + pos);
+    const uint16_t record_class = iotc_dns_read_u16(buffer + pos + 2);
+    const uint32_t record_ttl = iotc_dns_read_u32(buffer + pos + 4);
+    const uint16_t rdata_len = iotc_dns_read_u16(buffer + pos + 8);
+    const uint8_t* rdata = buffer + pos + 10;
+
+    pos += 10 + rdata_len;
+
+    if (len < pos) {
+      return IOTC_DNS_ANSWER_MALFORMED;
+    }
+
+    if (IOTC_DNS_CLASS_IN != record_class) {
+      continue;
+    }
+
+    if (record < answer_count) {
+      /* records of other names, e.g. injected ones, are not answers */
+      if (0 == iotc_dns_name_equals(buffer, len, name_pos, chain_name,
+                                    chain_name_len)) {
+        continue;
+      }
+
+      /* the chain of aliases expires with its shortest lived link */
+      if (IOTC_DNS_TYPE_CNAME == record_type) {
+        if (0 == iotc_dns_read_name(buffer, len, (size_t)(rdata - buffer),
+                                    chain_name, sizeof(chain_name))) {
+          return IOTC_DNS_ANSWER_MALFORMED;
+        }
+
+        chain_name_len = strlen(chain_name);
+        min_ttl = IOTC_MIN(min_ttl, record_ttl);
+      } else if (type == record_type &&
+                 rdata_len == (IOTC_DNS_TYPE_A == type ? 4 : 16)) {
+        min_ttl = IOTC_MIN(min_ttl, record_ttl);
+        found = 1;
+
+        if (parsed.count < IOTC_DNS_MAX_ADDRESSES) {
+          iotc_dns_format_address(rdata, type, &parsed.address[parsed.count]);
+          parsed.count += 1;
+        }
+      }
+    } else if (IOTC_DNS_TYPE_SOA == record_type &&
+               IOTC_DNS_SOA_TAIL_SIZE <= rdata_len) {
+      /* RFC 2308: the lower of the SOA TTL and its minimum field */
+      const uint32_t soa_minimum =
+          iotc_dns_read_u32(rdata + rdata_len - sizeof(uint32_t));
+      negative_ttl = IOTC_MIN(record_ttl, soa_minimum);
+    }
+  }
+
+  if (1 == found) {
+    *addresses = parsed;
+    *ttl = min_ttl;
+    return IOTC_DNS_ANSWER_ADDRESSES;
+  }
+
+  *ttl = negative_ttl;
+
+  return (IOTC_DNS_RCODE_NAME_ERROR == rcode) ? IOTC_DNS_ANSWER_NAME_ERROR
+                                              : IOTC_DNS_ANSWER_NO_DATA;
+}
+
+uint8_t iotc_dns_message_is_address_literal(const char* host) {
+  if (NULL == host || '\0' == *host) {
+    return 0;
+  }
+
+  /* host names never contain colons */
+  if (NULL != strchr(host, ':')) {
+    return 1;
+  }
+
+  for (; '\0' != *host; ++host) {
+    if (('0' > *host || '9' < *host) && '.' != *host) {
+      return 0;
+    }
+  }
+
+  return 1;
+}
+
+#ifdef __cplusplus
+}
+#endif
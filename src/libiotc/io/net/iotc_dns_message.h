@@ -0,0 +1,105 @@
+/* Copyright 2018-2020 Google LLC
+ *
+ * This is part of the Google Cloud IoT Device SDK for Embedded C.
+ * It is licensed under the BSD 3-Clause license; you may not use this file
+ * except in compliance with the License.
+ *
+ * You may obtain a copy of the License at:
+ *  https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __IOTC_DNS_MESSAGE_H__
+#define __IOTC_DNS_MESSAGE_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "iotc_bsp_io_net.h"
+#include "iotc_config.h"
+
+#include <iotc_error.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* resource record types the resolver asks for */
+#define IOTC_DNS_TYPE_A 1
+#define IOTC_DNS_TYPE_AAAA 28
+
+/* the longest name that fits a DNS message, without the trailing dot */
+#define IOTC_DNS_HOST_MAX_LEN 253
+
+/* plain UDP without EDNS, the server truncates anything longer */
+#define IOTC_DNS_MESSAGE_MAX_SIZE 512
+
+/* "ffff:ffff:ffff:ffff:ffff:ffff:ffff:ffff" and the terminating zero */
+#define IOTC_DNS_ADDRESS_MAX_LEN 40
+
+/* a resolved address in the numeric form accepted by the BSP connect */
+typedef struct iotc_dns_address_s {
+  iotc_bsp_protocol_type_t protocol;
+  char host[IOTC_DNS_ADDRESS_MAX_LEN];
+} iotc_dns_address_t;
+
+typedef struct iotc_dns_addresses_s {
+  iotc_dns_address_t address[IOTC_DNS_MAX_ADDRESSES];
+  uint8_t count;
+} iotc_dns_addresses_t;
+
+typedef enum iotc_dns_answer_e {
+  /* at least one address of the requested type */
+  IOTC_DNS_ANSWER_ADDRESSES = 0,
+  /* the name exists but has no address of the requested type */
+  IOTC_DNS_ANSWER_NO_DATA,
+  /* NXDOMAIN, the name does not exist */
+  IOTC_DNS_ANSWER_NAME_ERROR,
+  /* SERVFAIL, REFUSED, truncation, nothing that may be cached */
+  IOTC_DNS_ANSWER_SERVER_FAILURE,
+  /* not a well formed response to the given query, to be ignored */
+  IOTC_DNS_ANSWER_MALFORMED
+} iotc_dns_answer_t;
+
+/**
+ * @brief encodes a recursive query for a single record type of the host
+ *
+ * @return IOTC_INVALID_PARAMETER if the host is not a valid name,
+ * IOTC_BUFFER_TOO_SMALL_ERROR if the buffer can't hold the query
+ */
+extern iotc_state_t iotc_dns_message_encode_query(uint16_t id, const char* host,
+                                                  uint16_t type,
+                                                  uint8_t* buffer,
+                                                  size_t buffer_size,
+                                                  size_t* out_len);
+
+/**
+ * @brief parses the response to the query with the given id, host and type
+ *
+ * The question has to name the host, case insensitively. Only the address
+ * records of the host, or of the end of the CNAME chain followed from it in
+ * the order of the answer section, are taken. The addresses found are appended to the addresses as long as there is room.
+ * The ttl is set to the lowest TTL of the answer records for positive answers,
+ * and for negative ones to the negative caching TTL of the SOA record in the
+ * authority section, IOTC_DNS_NEGATIVE_CACHE_TTL if there is none.
+ */
+extern iotc_dns_answer_t iotc_dns_message_parse_response(
+    const uint8_t* buffer, size_t len, uint16_t id, const char* host,
+    uint16_t type, iotc_dns_addresses_t* addresses, uint32_t* ttl);
+
+/**
+ * @brief returns 1 if the host is an IPv4 or IPv6 address literal which
+ * doesn't need to be resolved
+ */
+extern uint8_t iotc_dns_message_is_address_literal(const char* host);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __IOTC_DNS_MESSAGE_H__ */
@@ -0,0 +1,335 @@
+/* Copyright 2018-2020 Google LLC
+ *
+ * This is part of the Google Cloud IoT Device SDK for Embedded C.
+ * It is licensed under the BSD 3-Clause license; you may not use this file
+ * except in compliance with the License.
+ *
+ * You may obtain a copy of the License at:
+ *  https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "iotc_dns_resolver.h"
+
+#include <string.h>
+
+#include "iotc_allocator.h"
+#include "iotc_bsp_io_net.h"
+#include "iotc_bsp_rng.h"
+#include "iotc_critical_section.h"
+#include "iotc_critical_section_def.h"
+#include "iotc_debug.h"
+#include "iotc_dns_cache.h"
+#include "iotc_globals.h"
+#include "iotc_macros.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* A and AAAA are asked for in parallel */
+#define IOTC_DNS_QUESTION_COUNT 2
+
+static const uint16_t iotc_dns_question_type[IOTC_DNS_QUESTION_COUNT] = {
+    IOTC_DNS_TYPE_A, IOTC_DNS_TYPE_AAAA};
+
+typedef struct iotc_dns_query_s {
+  char host[IOTC_DNS_HOST_MAX_LEN + 1];
+  iotc_evtd_instance_t* evtd;
+  iotc_dns_result_t* result;
+  iotc_event_handle_t continuation;
+  iotc_time_event_handle_t timeout;
+  iotc_bsp_socket_t socket;
+  uint16_t id[IOTC_DNS_QUESTION_COUNT];
+  iotc_dns_answer_t answer[IOTC_DNS_QUESTION_COUNT];
+  uint8_t is_answered[IOTC_DNS_QUESTION_COUNT];
+  uint32_t ttl;
+  uint8_t attempt;
+} iotc_dns_query_t;
+
+/* guards the server address in iotc_globals */
+static struct iotc_critical_section_s iotc_dns_resolver_cs = {0};
+
+static iotc_state_t iotc_dns_resolver_on_timeout(void* data);
+
+iotc_state_t iotc_dns_resolver_set_server(const char* address,
+                                          uint16_t port) {
+  if (NULL != address &&
+      (IOTC_DNS_ADDRESS_MAX_LEN <= strlen(address) ||
+       0 == iotc_dns_message_is_address_literal(address) || 0 == port)) {
+    return IOTC_INVALID_PARAMETER;
+  }
+
+  /* just to satisfy the compiler */
+  (void)iotc_dns_resolver_cs;
+
+  iotc_lock_critical_section(&iotc_dns_resolver_cs);
+
+  memset(&iotc_globals.dns_server, 0, sizeof(iotc_globals.dns_server));
+
+  if (NULL != address) {
+    strcpy(iotc_globals.dns_server.address, address);
+    iotc_globals.dns_server.port = port;
+  }
+
+  iotc_unlock_critical_section(&iotc_dns_resolver_cs);
+
+  /* answers of the previous server are not trusted any more */
+  iotc_dns_cache_flush();
+
+  return IOTC_STATE_OK;
+}
+
+static iotc_dns_server_t iotc_dns_resolver_get_server(void) {
+  iotc_lock_critical_section(&iotc_dns_resolver_cs);
+
+  const iotc_dns_server_t server = iotc_globals.dns_server;
+
+  iotc_unlock_critical_section(&iotc_dns_resolver_cs);
+
+  return server;
+}
+
+uint8_t iotc_dns_resolver_is_needed(const char* host) {
+  if (NULL == host || 1 == iotc_dns_message_is_address_literal(host)) {
+    return 0;
+  }
+
+  const iotc_dns_server_t server = iotc_dns_resolver_get_server();
+
+  return ('\0' != server.address[0]) ? 1 : 0;
+}
+
+/* (re)sends the questions that are still unanswered, a lost datagram is
+ * recovered by the next attempt */
+static void iotc_dns_resolver_send(iotc_dns_query_t* query) {
+  uint8_t buffer[IOTC_DNS_MESSAGE_MAX_SIZE];
+  size_t len = 0;
+  int written = 0;
+
+  size_t i = 0;
+  for (; i < IOTC_DNS_QUESTION_COUNT; ++i) {
+    if (1 == query->is_answered[i] ||
+        IOTC_STATE_OK != iotc_dns_message_encode_query(
+                             query->id[i], query->host,
+                             iotc_dns_question_type[i], buffer, sizeof(buffer),
+                             &len)) {
+      continue;
+    }
+
+    if (IOTC_BSP_IO_NET_STATE_OK !=
+        iotc_bsp_io_net_write(query->socket, &written, buffer, len)) {
+      iotc_debug_format("sending DNS query for %s failed", query->host);
+    }
+  }
+}
+
+static void iotc_dns_resolver_free_query(iotc_dns_query_t** query) {
+  if (NULL != (*query)->timeout.ptr_to_position) {
+    iotc_evtd_cancel((*query)->evtd, &(*query)->timeout);
+  }
+
+  iotc_evtd_unregister_socket_fd((*query)->evtd, (*query)->socket);
+  iotc_bsp_io_net_close_socket(&(*query)->socket);
+
+  IOTC_SAFE_FREE(*query);
+}
+
+static void iotc_dns_resolver_finish(iotc_dns_query_t* query) {
+  iotc_dns_result_t* result = query->result;
+  uint8_t is_authoritative_negative = 1;
+
+  size_t i = 0;
+  for (; i < IOTC_DNS_QUESTION_COUNT; ++i) {
+    if (0 == query->is_answered[i] ||
+        (IOTC_DNS_ANSWER_NO_DATA != query->answer[i] &&
+         IOTC_DNS_ANSWER_NAME_ERROR != query->answer[i])) {
+      is_authoritative_negative = 0;
+    }
+  }
+
+  if (0 < result->addresses.count) {
+    result->state = IOTC_STATE_OK;
+    iotc_dns_cache_store(query->host, &result->addresses, query->ttl,
+                         query->evtd->current_step);
+  } else {
+    result->state = IOTC_SOCKET_GETHOSTBYNAME_ERROR;
+
+    /* timeouts and server failures are not remembered */
+    if (1 == is_authoritative_negative) {
+      iotc_dns_cache_store(query->host, NULL, query->ttl,
+                           query->evtd->current_step);
+    }
+  }
+
+  iotc_debug_format("resolved %s: %d address(es), state %d", query->host,
+                    result->addresses.count, result->state);
+
+  iotc_event_handle_t continuation = query->continuation;
+
+  result->query = NULL;
+  iotc_dns_resolver_free_query(&query);
+
+  iotc_evtd_execute_handle(&continuation);
+}
+
+static iotc_state_t iotc_dns_resolver_on_readable(void* data) {
+  iotc_dns_query_t* query = (iotc_dns_query_t*)data;
+  uint8_t buffer[IOTC_DNS_MESSAGE_MAX_SIZE];
+  int len = 0;
+
+  /* every read returns a single datagram */
+  while (IOTC_BSP_IO_NET_STATE_OK ==
+         iotc_bsp_io_net_read(query->socket, &len, buffer, sizeof(buffer))) {
+    size_t i = 0;
+    for (; i < IOTC_DNS_QUESTION_COUNT; ++i) {
+      if (1 == query->is_answered[i]) {
+        continue;
+      }
+
+      uint32_t ttl = 0;
+      const iotc_dns_answer_t answer = iotc_dns_message_parse_response(
+          buffer, (size_t)len, query->id[i], query->host,
+          iotc_dns_question_type[i], &query->result->addresses, &ttl);
+
+      if (IOTC_DNS_ANSWER_MALFORMED == answer) {
+        continue;
+      }
+
+      query->answer[i] = answer;
+      query->is_answered[i] = 1;
+
+      /* the entry expires with the shortest lived answer */
+      if (IOTC_DNS_ANSWER_SERVER_FAILURE != answer) {
+        query->ttl = IOTC_MIN(query->ttl, ttl);
+      }
+
+      break;
+    }
+
+    if (1 == query->is_answered[0] && 1 == query->is_answered[1]) {
+      iotc_dns_resolver_finish(query);
+      return IOTC_STATE_OK;
+    }
+  }
+
+  return IOTC_STATE_OK;
+}
+
+static iotc_state_t iotc_dns_resolver_on_timeout(void* data) {
+  iotc_dns_query_t* query = (iotc_dns_query_t*)data;
+
+  query->timeout.ptr_to_position = NULL;
+  query->attempt += 1;
+
+  /* one family is enough once the other one has been waited for */
+  if (IOTC_DNS_QUERY_ATTEMPTS <= query->attempt ||
+      0 < query->result->addresses.count) {
+    iotc_dns_resolver_finish(query);
+    return IOTC_STATE_OK;
+  }
+
+  iotc_dns_resolver_send(query);
+
+  return iotc_evtd_execute_in(
+      query->evtd, iotc_make_handle(&iotc_dns_resolver_on_timeout, query),
+      IOTC_DNS_QUERY_TIMEOUT, &query->timeout);
+}
+
+iotc_state_t iotc_dns_resolve(iotc_evtd_instance_t* evtd, const char* host,
+                              iotc_dns_result_t* result,
+                              iotc_event_handle_t continuation) {
+  assert(NULL != evtd);
+  assert(NULL != result);
+
+  iotc_state_t state = IOTC_STATE_OK;
+  iotc_dns_query_t* query = NULL;
+
+  memset(result, 0, sizeof(iotc_dns_result_t));
+
+  IOTC_CHECK_CND_DBGMESSAGE(
+      NULL == host || IOTC_DNS_HOST_MAX_LEN < strlen(host),
+      IOTC_INVALID_PARAMETER, state, "host name too long to be resolved");
+
+  if (1 == iotc_dns_cache_lookup(host, evtd->current_step, &result->addresses,
+                                 &result->state)) {
+    return IOTC_STATE_OK;
+  }
+
+  const iotc_dns_server_t server = iotc_dns_resolver_get_server();
+
+  IOTC_CHECK_CND_DBGMESSAGE('\0' == server.address[0], IOTC_INVALID_PARAMETER,
+                            state, "no DNS server configured");
+
+  IOTC_ALLOC_AT(iotc_dns_query_t, query, state);
+
+  strcpy(query->host, host);
+  query->evtd = evtd;
+  query->result = result;
+  query->continuation = continuation;
+  query->ttl = UINT32_MAX;
+  query->socket = -1;
+
+  size_t i = 0;
+  for (; i < IOTC_DNS_QUESTION_COUNT; ++i) {
+    /* random ids make spoofed answers harder to slip in */
+    query->id[i] = (uint16_t)iotc_bsp_rng_get();
+  }
+
+  /* the BSP leaves the socket undefined when the connect fails */
+  iotc_bsp_socket_t dns_socket = -1;
+
+  IOTC_CHECK_CND_DBGMESSAGE(
+      IOTC_BSP_IO_NET_STATE_OK !=
+          iotc_bsp_io_net_socket_connect(&dns_socket, server.address,
+                                         server.port, SOCKET_DGRAM, NULL),
+      IOTC_SOCKET_INITIALIZATION_ERROR, state,
+      "could not open the socket to the DNS server");
+
+  query->socket = dns_socket;
+
+  IOTC_CHECK_CND_DBGMESSAGE(
+      0 > iotc_evtd_register_socket_fd(
+              evtd, query->socket,
+              iotc_make_handle(&iotc_dns_resolver_on_readable, query)),
+      IOTC_INTERNAL_ERROR, state, "could not register the DNS socket");
+
+  IOTC_CHECK_STATE(state = iotc_evtd_execute_in(
+                       evtd,
+                       iotc_make_handle(&iotc_dns_resolver_on_timeout, query),
+                       IOTC_DNS_QUERY_TIMEOUT, &query->timeout));
+
+  iotc_dns_resolver_send(query);
+
+  result->query = query;
+
+  return IOTC_STATE_WANT_READ;
+
+err_handling:
+  if (NULL != query) {
+    if (-1 == query->socket) {
+      IOTC_SAFE_FREE(query);
+    } else {
+      iotc_dns_resolver_free_query(&query);
+    }
+  }
+
+  return state;
+}
+
+void iotc_dns_resolve_cancel(iotc_dns_result_t* result) {
+  if (NULL == result || NULL == result->query) {
+    return;
+  }
+
+  iotc_dns_resolver_free_query(&result->query);
+}
+
+#ifdef __cplusplus
+}
+#endif
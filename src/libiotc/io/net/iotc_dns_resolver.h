@@ -0,0 +1,92 @@
+/* Copyright 2018-2020 Google LLC
+ *
+ * This is part of the Google Cloud IoT Device SDK for Embedded C.
+ * It is licensed under the BSD 3-Clause license; you may not use this file
+ * except in compliance with the License.
+ *
+ * You may obtain a copy of the License at:
+ *  https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __IOTC_DNS_RESOLVER_H__
+#define __IOTC_DNS_RESOLVER_H__
+
+#include <stdint.h>
+
+#include "iotc_dns_message.h"
+#include "iotc_event_dispatcher_api.h"
+
+#include <iotc_error.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Non-blocking resolver.
+ *
+ * A and AAAA queries are sent over UDP to the configured recursive server
+ * with the BSP sockets, the answer is read on the event dispatcher of the
+ * caller so a slow server never stalls the event loop. Results go to the
+ * process wide cache, see iotc_dns_cache.h. Without a configured server the
+ * BSP keeps resolving the hosts itself.
+ */
+
+/* the recursive server, kept in iotc_globals; an empty address disables the
+ * resolver */
+typedef struct iotc_dns_server_s {
+  char address[IOTC_DNS_ADDRESS_MAX_LEN];
+  uint16_t port;
+} iotc_dns_server_t;
+
+struct iotc_dns_query_s;
+
+typedef struct iotc_dns_result_s {
+  iotc_dns_addresses_t addresses;
+  /* IOTC_STATE_OK or IOTC_SOCKET_GETHOSTBYNAME_ERROR */
+  iotc_state_t state;
+  /* set while the query is in flight */
+  struct iotc_dns_query_s* query;
+} iotc_dns_result_t;
+
+/**
+ * @brief sets the server by its numeric address, NULL disables the resolver
+ */
+extern iotc_state_t iotc_dns_resolver_set_server(const char* address,
+                                                 uint16_t port);
+
+/**
+ * @brief returns 1 if the host has to be resolved by this resolver, 0 if it is
+ * an address literal or no server is configured
+ */
+extern uint8_t iotc_dns_resolver_is_needed(const char* host);
+
+/**
+ * @brief resolves the host
+ *
+ * @return IOTC_STATE_OK if the result has been filled right away from the
+ * cache, IOTC_STATE_WANT_READ if a query has been sent - the continuation is
+ * executed on the event dispatcher once the result is filled - or an error if
+ * the query couldn't be sent
+ */
+extern iotc_state_t iotc_dns_resolve(iotc_evtd_instance_t* evtd,
+                                     const char* host,
+                                     iotc_dns_result_t* result,
+                                     iotc_event_handle_t continuation);
+
+/**
+ * @brief drops the query in flight, the continuation won't be executed
+ */
+extern void iotc_dns_resolve_cancel(iotc_dns_result_t* result);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __IOTC_DNS_RESOLVER_H__ */
@@ -26,7 +26,6 @@
 #include "iotc_types_internal.h"
 
 #include "iotc_globals.h"
-#include "iotc_io_timeouts.h"
 
 iotc_state_t iotc_io_net_layer_connect(void* context, void* data,
                                        iotc_state_t in_out_state) {
@@ -46,7 +45,9 @@ iotc_state_t iotc_io_net_layer_connect(void* context, void* data,
                                               IOTC_INTERNAL_ERROR);
   }
 
-  iotc_bsp_io_net_state_t state = IOTC_BSP_IO_NET_STATE_OK;
+  iotc_state_t resolve_state = IOTC_STATE_OK;
+  iotc_state_t race_state = IOTC_STATE_OK;
+  uint8_t host_count = 1;
 
   iotc_connection_data_t* connection_data = (iotc_connection_data_t*)data;
   iotc_evtd_instance_t* event_dispatcher =
@@ -58,35 +59,56 @@ iotc_state_t iotc_io_net_layer_connect(void* context, void* data,
                     IOTC_THIS_LAYER(context)->layer_type_id,
                     connection_data->host, connection_data->port);
 
-  state =
-      iotc_bsp_io_net_socket_connect(&layer_data->socket, connection_data->host,
-                                     connection_data->port, SOCKET_STREAM);
+  layer_data->race_hosts[0] = connection_data->host;
 
-  IOTC_CHECK_CND_DBGMESSAGE(IOTC_BSP_IO_NET_STATE_OK != state,
-                            IOTC_SOCKET_CONNECTION_ERROR, in_out_state,
-                            "Connecting to the endpoint [failed]");
+  /* without a DNS server configured the BSP resolves the host by itself */
+  if (1 == iotc_dns_resolver_is_needed(connection_data->host)) {
+    resolve_state = iotc_dns_resolve(
+        event_dispatcher, connection_data->host, &layer_data->dns_result,
+        iotc_make_handle(&iotc_io_net_layer_connect, context, data,
+                         IOTC_STATE_OK));
 
-  {
-    iotc_evtd_register_socket_fd(
-        event_dispatcher, layer_data->socket,
-        iotc_make_handle(&iotc_io_net_layer_pull, context, 0, IOTC_STATE_OK));
-
-    iotc_evtd_continue_when_evt_on_socket(
-        event_dispatcher, IOTC_EVENT_WANT_CONNECT,
-        iotc_make_handle(&iotc_io_net_layer_connect, (void*)context, data,
-                         IOTC_STATE_OK),
-        layer_data->socket);
+    IOTC_CHECK_CND_DBGMESSAGE(IOTC_STATE_OK != resolve_state &&
+                                  IOTC_STATE_WANT_READ != resolve_state,
+                              IOTC_SOCKET_GETHOSTBYNAME_ERROR, in_out_state,
+                              "Resolving the endpoint [failed]");
+
+    // Return here once the answer is in.
+    IOTC_CR_YIELD_ON(layer_data->layer_connect_cs,
+                     IOTC_STATE_WANT_READ == resolve_state, IOTC_STATE_OK);
+
+    IOTC_CHECK_CND_DBGMESSAGE(
+        IOTC_STATE_OK != layer_data->dns_result.state,
+        IOTC_SOCKET_GETHOSTBYNAME_ERROR, in_out_state,
+        "Resolving the endpoint [failed]");
+
+    host_count = iotc_io_net_race_order(&layer_data->dns_result.addresses,
+                                        layer_data->race_hosts);
   }
 
-  // Return here whenever we can write.
+  race_state = iotc_io_net_race_start(
+      &layer_data->race, event_dispatcher, layer_data->race_hosts, host_count,
+      connection_data->port, &connection_data->socket_options,
+      iotc_make_handle(&iotc_io_net_layer_connect, context, data,
+                       IOTC_STATE_OK));
+
+  IOTC_CHECK_CND_DBGMESSAGE(IOTC_STATE_WANT_WRITE != race_state,
+                            IOTC_SOCKET_CONNECTION_ERROR, in_out_state,
+                            "Connecting to the endpoint [failed]");
+
+  // Return here once one of the addresses is connected or all have failed.
   IOTC_CR_YIELD(layer_data->layer_connect_cs, IOTC_STATE_OK);
 
-  state = iotc_bsp_io_net_connection_check(
-      layer_data->socket, connection_data->host, connection_data->port);
+  IOTC_CHECK_CND_DBGMESSAGE(IOTC_STATE_OK != layer_data->race.state,
+                            layer_data->race.state, in_out_state,
+                            "Connecting to the endpoint [failed]");
+
+  layer_data->socket = layer_data->race.socket;
+
+  iotc_evtd_register_socket_fd(
+      event_dispatcher, layer_data->socket,
+      iotc_make_handle(&iotc_io_net_layer_pull, context, 0, IOTC_STATE_OK));
 
-  IOTC_CHECK_CND_DBGMESSAGE(IOTC_BSP_IO_NET_STATE_OK != state,
-                            IOTC_SOCKET_GETSOCKOPT_ERROR, in_out_state,
-                            "Error while calling getsockopt.");
   iotc_debug_logger("Connection successful!");
 
   IOTC_CR_EXIT(layer_data->layer_connect_cs, IOTC_PROCESS_CONNECT_ON_NEXT_LAYER(
@@ -199,6 +221,8 @@ iotc_state_t iotc_io_net_layer_push(void* context, void* data,
 
       buffer->curr_pos += len;
       left = buffer->capacity - buffer->curr_pos;
+
+      IOTC_CONTEXT_STATS_ADD(IOTC_CONTEXT_DATA(context), bytes_sent, len);
     } while (left > 0);
   }
 
@@ -276,14 +300,11 @@ iotc_state_t iotc_io_net_layer_pull(void* context, void* data,
     goto err_handling;
   }
 
-  /* restart io timeouts if needed */
-  if (IOTC_CONTEXT_DATA(context)->io_timeouts->elem_no > 0 &&
-      IOTC_CONTEXT_DATA(context)->connection_data->connection_timeout > 0) {
-    iotc_io_timeouts_restart(
-        iotc_globals.evtd_instance,
-        IOTC_CONTEXT_DATA(context)->connection_data->connection_timeout,
-        IOTC_CONTEXT_DATA(context)->io_timeouts);
-  }
+  /* the io timeouts check it when they expire, no timer is touched here */
+  IOTC_CONTEXT_DATA(context)->io_last_read_time =
+      IOTC_CONTEXT_DATA(context)->evtd_instance->current_step;
+
+  IOTC_CONTEXT_STATS_ADD(IOTC_CONTEXT_DATA(context), bytes_received, len);
 
   buffer_desc->length = len;
   buffer_desc->curr_pos = 0;
@@ -317,6 +338,9 @@ iotc_state_t iotc_io_net_layer_close_externally(void* context, void* data,
                                                        in_out_state);
   }
 
+  iotc_dns_resolve_cancel(&layer_data->dns_result);
+  iotc_io_net_race_cancel(&layer_data->race);
+
   /* unregister the fd */
   iotc_evtd_unregister_socket_fd(IOTC_CONTEXT_DATA(context)->evtd_instance,
                                  layer_data->socket);
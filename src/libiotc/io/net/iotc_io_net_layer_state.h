@@ -19,9 +19,14 @@
 
 #include <stdint.h>
 #include "iotc_bsp_io_net.h"
+#include "iotc_dns_resolver.h"
+#include "iotc_io_net_race.h"
 
 typedef struct iotc_io_net_layer_state_s {
   iotc_bsp_socket_t socket;
+  iotc_dns_result_t dns_result;
+  iotc_io_net_race_t race;
+  const char* race_hosts[IOTC_IO_NET_RACE_MAX_ATTEMPTS];
 
   uint16_t layer_connect_cs;
 } iotc_io_net_layer_state_t;
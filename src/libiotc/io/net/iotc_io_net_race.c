@@ -0,0 +1,269 @@
+/* Copyright 2018-2020 Google LLC
+ *
+ * This is part of the Google Cloud IoT Device SDK for Embedded C.
+ * It is licensed under the BSD 3-Clause license; you may not use this file
+ * except in compliance with the License.
+ *
+ * You may obtain a copy of the License at:
+ *  https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "iotc_io_net_race.h"
+
+#include <string.h>
+
+#include "iotc_config.h"
+#include "iotc_debug.h"
+#include "iotc_macros.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+static iotc_state_t iotc_io_net_race_on_next_attempt(void* data);
+
+uint8_t iotc_io_net_race_order(const iotc_dns_addresses_t* addresses,
+                               const char** out_hosts) {
+  assert(NULL != addresses);
+  assert(NULL != out_hosts);
+
+  const iotc_bsp_protocol_type_t family_order[2] = {PROTOCOL_IPV6,
+                                                    PROTOCOL_IPV4};
+  uint8_t taken[IOTC_DNS_MAX_ADDRESSES] = {0};
+  uint8_t count = 0;
+  uint8_t family = 0;
+
+  while (count < addresses->count) {
+    uint8_t i = 0;
+
+    /* the next address of the preferred family, any address otherwise */
+    for (; i < addresses->count; ++i) {
+      if (0 == taken[i] &&
+          family_order[family] == addresses->address[i].protocol) {
+        break;
+      }
+    }
+
+    if (i == addresses->count) {
+      for (i = 0; 1 == taken[i]; ++i) {
+      }
+    }
+
+    taken[i] = 1;
+    out_hosts[count++] = addresses->address[i].host;
+    family = 1 - family;
+  }
+
+  return count;
+}
+
+static void iotc_io_net_race_close_attempt(iotc_io_net_race_attempt_t* attempt) {
+  if (0 == attempt->is_open) {
+    return;
+  }
+
+  iotc_evtd_unregister_socket_fd(attempt->race->evtd, attempt->socket);
+  iotc_bsp_io_net_close_socket(&attempt->socket);
+
+  attempt->is_open = 0;
+}
+
+static void iotc_io_net_race_stop(iotc_io_net_race_t* race,
+                                  iotc_io_net_race_attempt_t* winner) {
+  if (NULL != race->next_attempt.ptr_to_position) {
+    iotc_evtd_cancel(race->evtd, &race->next_attempt);
+  }
+
+  uint8_t i = 0;
+  for (; i < race->started_count; ++i) {
+    if (winner != &race->attempt[i]) {
+      iotc_io_net_race_close_attempt(&race->attempt[i]);
+    }
+  }
+
+  race->is_running = 0;
+}
+
+static void iotc_io_net_race_finish(iotc_io_net_race_t* race,
+                                    iotc_io_net_race_attempt_t* winner) {
+  iotc_io_net_race_stop(race, winner);
+
+  if (NULL != winner) {
+    iotc_debug_format("connected to %s", winner->host);
+
+    /* the owner of the socket registers it with its own handlers */
+    iotc_evtd_unregister_socket_fd(race->evtd, winner->socket);
+    winner->is_open = 0;
+
+    race->socket = winner->socket;
+    race->state = IOTC_STATE_OK;
+  } else {
+    race->state = IOTC_SOCKET_CONNECTION_ERROR;
+  }
+
+  iotc_event_handle_t continuation = race->continuation;
+  iotc_evtd_execute_handle(&continuation);
+}
+
+static iotc_state_t iotc_io_net_race_on_connect(void* race_ptr,
+                                                void* attempt_ptr);
+
+/* starts the next attempt, and the ones after it if it fails right away */
+static void iotc_io_net_race_start_next(iotc_io_net_race_t* race) {
+  while (race->started_count < race->attempt_count) {
+    iotc_io_net_race_attempt_t* attempt =
+        &race->attempt[race->started_count++];
+    iotc_bsp_socket_t socket = 0;
+
+    iotc_debug_format("connect attempt %d to %s:%hu", race->started_count,
+                      attempt->host, race->port);
+
+    if (IOTC_BSP_IO_NET_STATE_OK !=
+        iotc_bsp_io_net_socket_connect(&socket, attempt->host, race->port,
+                                       SOCKET_STREAM, race->socket_options)) {
+      continue;
+    }
+
+    const iotc_event_handle_t on_connect =
+        iotc_make_handle(&iotc_io_net_race_on_connect, race, attempt);
+
+    if (0 > iotc_evtd_register_socket_fd(race->evtd, socket, on_connect)) {
+      iotc_bsp_io_net_close_socket(&socket);
+      continue;
+    }
+
+    attempt->socket = socket;
+    attempt->is_open = 1;
+
+    iotc_evtd_continue_when_evt_on_socket(race->evtd, IOTC_EVENT_WANT_CONNECT,
+                                          on_connect, socket);
+
+    /* the next address gets its chance if this one is slow */
+    if (race->started_count < race->attempt_count &&
+        IOTC_STATE_OK !=
+            iotc_evtd_execute_in(
+                race->evtd,
+                iotc_make_handle(&iotc_io_net_race_on_next_attempt, race),
+                IOTC_IO_NET_RACE_ATTEMPT_DELAY, &race->next_attempt)) {
+      iotc_debug_logger("could not schedule the next connect attempt");
+    }
+
+    return;
+  }
+}
+
+static uint8_t iotc_io_net_race_has_open_attempt(
+    const iotc_io_net_race_t* race) {
+  uint8_t i = 0;
+  for (; i < race->started_count; ++i) {
+    if (1 == race->attempt[i].is_open) {
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+static iotc_state_t iotc_io_net_race_on_next_attempt(void* data) {
+  iotc_io_net_race_t* race = (iotc_io_net_race_t*)data;
+
+  race->next_attempt.ptr_to_position = NULL;
+
+  iotc_io_net_race_start_next(race);
+
+  if (0 == iotc_io_net_race_has_open_attempt(race)) {
+    iotc_io_net_race_finish(race, NULL);
+  }
+
+  return IOTC_STATE_OK;
+}
+
+static iotc_state_t iotc_io_net_race_on_connect(void* race_ptr,
+                                                void* attempt_ptr) {
+  iotc_io_net_race_t* race = (iotc_io_net_race_t*)race_ptr;
+  iotc_io_net_race_attempt_t* attempt =
+      (iotc_io_net_race_attempt_t*)attempt_ptr;
+
+  if (0 == race->is_running || 0 == attempt->is_open) {
+    return IOTC_STATE_OK;
+  }
+
+  if (IOTC_BSP_IO_NET_STATE_OK ==
+      iotc_bsp_io_net_connection_check(attempt->socket, attempt->host,
+                                       race->port)) {
+    iotc_io_net_race_finish(race, attempt);
+    return IOTC_STATE_OK;
+  }
+
+  iotc_debug_format("connect attempt to %s failed", attempt->host);
+
+  iotc_io_net_race_close_attempt(attempt);
+
+  /* a failure doesn't wait for the attempt delay */
+  if (NULL != race->next_attempt.ptr_to_position) {
+    iotc_evtd_cancel(race->evtd, &race->next_attempt);
+  }
+
+  iotc_io_net_race_start_next(race);
+
+  if (0 == iotc_io_net_race_has_open_attempt(race)) {
+    iotc_io_net_race_finish(race, NULL);
+  }
+
+  return IOTC_STATE_OK;
+}
+
+iotc_state_t iotc_io_net_race_start(iotc_io_net_race_t* race,
+                                    iotc_evtd_instance_t* evtd,
+                                    const char** hosts, uint8_t host_count,
+                                    uint16_t port,
+                                    const iotc_bsp_socket_options_t* options,
+                                    iotc_event_handle_t continuation) {
+  assert(NULL != race);
+  assert(NULL != evtd);
+  assert(NULL != hosts);
+
+  memset(race, 0, sizeof(iotc_io_net_race_t));
+
+  race->evtd = evtd;
+  race->continuation = continuation;
+  race->port = port;
+  race->socket_options = options;
+  race->attempt_count = IOTC_MIN(host_count, IOTC_IO_NET_RACE_MAX_ATTEMPTS);
+  race->state = IOTC_SOCKET_CONNECTION_ERROR;
+
+  uint8_t i = 0;
+  for (; i < race->attempt_count; ++i) {
+    race->attempt[i].race = race;
+    race->attempt[i].host = hosts[i];
+  }
+
+  race->is_running = 1;
+
+  iotc_io_net_race_start_next(race);
+
+  if (0 == iotc_io_net_race_has_open_attempt(race)) {
+    race->is_running = 0;
+    return IOTC_SOCKET_CONNECTION_ERROR;
+  }
+
+  return IOTC_STATE_WANT_WRITE;
+}
+
+void iotc_io_net_race_cancel(iotc_io_net_race_t* race) {
+  if (NULL == race || 0 == race->is_running) {
+    return;
+  }
+
+  iotc_io_net_race_stop(race, NULL);
+}
+
+#ifdef __cplusplus
+}
+#endif
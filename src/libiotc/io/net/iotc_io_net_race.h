@@ -0,0 +1,101 @@
+/* Copyright 2018-2020 Google LLC
+ *
+ * This is part of the Google Cloud IoT Device SDK for Embedded C.
+ * It is licensed under the BSD 3-Clause license; you may not use this file
+ * except in compliance with the License.
+ *
+ * You may obtain a copy of the License at:
+ *  https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __IOTC_IO_NET_RACE_H__
+#define __IOTC_IO_NET_RACE_H__
+
+#include <stdint.h>
+
+#include "iotc_bsp_io_net.h"
+#include "iotc_dns_message.h"
+#include "iotc_event_dispatcher_api.h"
+
+#include <iotc_error.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Happy eyeballs (RFC 8305) connect.
+ *
+ * The addresses of the endpoint are tried in parallel: a new non-blocking
+ * connect is started every IOTC_IO_NET_RACE_ATTEMPT_DELAY seconds, or as soon
+ * as the previous one fails, while the earlier ones keep going. The first
+ * socket to connect wins and the others are closed, so an address that
+ * blackholes costs one attempt delay instead of the whole connection timeout.
+ */
+
+#define IOTC_IO_NET_RACE_MAX_ATTEMPTS IOTC_DNS_MAX_ADDRESSES
+
+struct iotc_io_net_race_s;
+
+typedef struct iotc_io_net_race_attempt_s {
+  struct iotc_io_net_race_s* race;
+  const char* host;
+  iotc_bsp_socket_t socket;
+  uint8_t is_open;
+} iotc_io_net_race_attempt_t;
+
+typedef struct iotc_io_net_race_s {
+  iotc_io_net_race_attempt_t attempt[IOTC_IO_NET_RACE_MAX_ATTEMPTS];
+  iotc_evtd_instance_t* evtd;
+  const iotc_bsp_socket_options_t* socket_options;
+  iotc_event_handle_t continuation;
+  iotc_time_event_handle_t next_attempt;
+  uint16_t port;
+  uint8_t attempt_count;
+  uint8_t started_count;
+  uint8_t is_running;
+  /* the outcome, valid once the continuation runs */
+  iotc_state_t state;
+  iotc_bsp_socket_t socket;
+} iotc_io_net_race_t;
+
+/**
+ * @brief orders the addresses the way they are raced: the families
+ * alternate, IPv6 first, keeping the order of the DNS answer within a family
+ *
+ * @return the number of hosts set
+ */
+extern uint8_t iotc_io_net_race_order(const iotc_dns_addresses_t* addresses,
+                                      const char** out_hosts);
+
+/**
+ * @brief starts connecting to the hosts, the hosts and the options (NULL for
+ * the platform defaults) must outlive the race
+ *
+ * @return IOTC_STATE_WANT_WRITE if the race is on - the continuation is
+ * executed on the event dispatcher once it is decided, the winner socket is
+ * not registered with the event dispatcher anymore - or
+ * IOTC_SOCKET_CONNECTION_ERROR if no connect could even be started
+ */
+extern iotc_state_t iotc_io_net_race_start(
+    iotc_io_net_race_t* race, iotc_evtd_instance_t* evtd, const char** hosts,
+    uint8_t host_count, uint16_t port, const iotc_bsp_socket_options_t* options,
+    iotc_event_handle_t continuation);
+
+/**
+ * @brief closes all the attempts of a race that is still running, the
+ * continuation won't be executed
+ */
+extern void iotc_io_net_race_cancel(iotc_io_net_race_t* race);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __IOTC_IO_NET_RACE_H__ */
@@ -23,9 +23,17 @@
 #include "iotc_backoff_lut_config.h"
 #include "iotc_backoff_status_api.h"
 #include "iotc_common.h"
+#include "iotc_config.h"
+#include "iotc_connect_scheduler.h"
 #include "iotc_connection_data_internal.h"
+#include "iotc_critical_section.h"
+#include "iotc_critical_section_def.h"
 #include "iotc_debug.h"
+#include "iotc_dns_cache.h"
+#include "iotc_dns_resolver.h"
 #include "iotc_event_loop.h"
+#include "iotc_event_loop_shards.h"
+#include "iotc_event_thread_dispatcher.h"
 #include "iotc_globals.h"
 #include "iotc_handle.h"
 #include "iotc_helpers.h"
@@ -39,11 +47,20 @@
 #include "iotc_layer_macros.h"
 #include "iotc_list.h"
 #include "iotc_macros.h"
+#include "iotc_memory_accounting.h"
+#include "iotc_mqtt_codec_layer.h"
+#include "iotc_mqtt_logic_layer.h"
+#include "iotc_offline_queue.h"
+#include "iotc_session_store.h"
 #include "iotc_timed_task.h"
 #include "iotc_version.h"
 
 #include "iotc_layer_stack.h"
 
+#ifdef IOTC_LAYER_TRACING_ENABLED
+#include "iotc_layer_tracing.h"
+#endif
+
 #include "iotc_thread_threadpool.h"
 
 #include "iotc_user_sub_call_wrapper.h"
@@ -61,10 +78,6 @@ extern "C" {
  * CONSTANTS
  */
 
-#ifndef IOTC_MAX_NUM_CONTEXTS
-#define IOTC_MAX_NUM_CONTEXTS 2
-#endif
-
 const uint16_t iotc_major = IOTC_MAJOR;
 const uint16_t iotc_minor = IOTC_MINOR;
 const uint16_t iotc_revision = IOTC_REVISION;
@@ -75,6 +88,10 @@ const uint16_t iotc_revision = IOTC_REVISION;
 const char iotc_cilent_version_str[] = "IoTC Embedded C Client Version: " STR(
     IOTC_MAJOR) "." STR(IOTC_MINOR) "." STR(IOTC_REVISION);
 
+/* guards the reference counted globals, contexts may be created and deleted
+ * from the threads of the event loop shards */
+static struct iotc_critical_section_s iotc_globals_cs = {0};
+
 /*
  * HELPER FUNCTIONS
  */
@@ -84,6 +101,20 @@ void iotc_set_network_timeout(uint32_t timeout) {
 
 uint32_t iotc_get_network_timeout(void) { return iotc_globals.network_timeout; }
 
+void iotc_set_max_concurrent_connects(uint16_t max_concurrent_connects) {
+  iotc_connect_scheduler_set_max_concurrent(max_concurrent_connects);
+}
+
+uint16_t iotc_get_max_concurrent_connects(void) {
+  return iotc_connect_scheduler_get_max_concurrent();
+}
+
+iotc_state_t iotc_set_dns_server(const char* address, uint16_t port) {
+  return iotc_dns_resolver_set_server(address, port);
+}
+
+void iotc_flush_dns_cache(void) { iotc_dns_cache_flush(); }
+
 /*
  * MAIN LIBRARY FUNCTIONS
  */
@@ -100,6 +131,50 @@ iotc_state_t iotc_shutdown() {
   return IOTC_STATE_OK;
 }
 
+static iotc_state_t iotc_create_globals(void) {
+  iotc_state_t state = IOTC_STATE_OK;
+
+  iotc_globals.evtd_instance = iotc_evtd_create_instance();
+
+  IOTC_CHECK_STATE(iotc_backoff_configure_using_data(
+      (iotc_vector_elem_t*)IOTC_BACKOFF_LUT,
+      (iotc_vector_elem_t*)IOTC_DECAY_LUT, IOTC_ARRAYSIZE(IOTC_BACKOFF_LUT),
+      IOTC_MEMORY_TYPE_UNMANAGED));
+
+  IOTC_CHECK_MEMORY(iotc_globals.evtd_instance, state);
+
+#ifdef IOTC_MODULE_THREAD_ENABLED
+  /* callbacks run on other threads, their calls into the library must not
+   * wait for the blocking event loop to time out */
+  IOTC_CHECK_STATE(state = iotc_evtd_enable_wakeup(iotc_globals.evtd_instance));
+#endif
+
+  /* Note: this is NULL if thread module is disabled. */
+  iotc_globals.main_threadpool = iotc_threadpool_create_instance(
+      IOTC_MAIN_THREADPOOL_NUM_OF_THREADS);
+
+  iotc_globals.context_handles =
+      iotc_handle_table_create(IOTC_MAX_NUM_CONTEXTS);
+  iotc_globals.timed_tasks_container = iotc_make_timed_task_container();
+
+err_handling:
+  return state;
+}
+
+static void iotc_destroy_globals(void) {
+  iotc_cancel_backoff_event();
+  iotc_backoff_release();
+  iotc_evtd_destroy_instance(iotc_globals.evtd_instance);
+  iotc_globals.evtd_instance = NULL;
+  iotc_threadpool_destroy_instance(&iotc_globals.main_threadpool);
+
+  iotc_handle_table_destroy(iotc_globals.context_handles);
+  iotc_globals.context_handles = NULL;
+
+  iotc_destroy_timed_task_container(iotc_globals.timed_tasks_container);
+  iotc_globals.timed_tasks_container = NULL;
+}
+
 iotc_state_t iotc_create_context_with_custom_layers_and_evtd(
     iotc_context_t** context, iotc_layer_type_t layer_config[],
     iotc_layer_type_id_t layer_chain[], size_t layer_chain_size,
@@ -113,24 +188,19 @@ iotc_state_t iotc_create_context_with_custom_layers_and_evtd(
   }
 
   *context = NULL;
-  iotc_globals.globals_ref_count += 1;
-
-  if (1 == iotc_globals.globals_ref_count) {
-    iotc_globals.evtd_instance = iotc_evtd_create_instance();
-
-    IOTC_CHECK_STATE(iotc_backoff_configure_using_data(
-        (iotc_vector_elem_t*)IOTC_BACKOFF_LUT,
-        (iotc_vector_elem_t*)IOTC_DECAY_LUT, IOTC_ARRAYSIZE(IOTC_BACKOFF_LUT),
-        IOTC_MEMORY_TYPE_UNMANAGED));
 
-    IOTC_CHECK_MEMORY(iotc_globals.evtd_instance, state);
+  /* just to satisfy the compiler */
+  (void)iotc_globals_cs;
 
-    /* Note: this is NULL if thread module is disabled. */
-    iotc_globals.main_threadpool = iotc_threadpool_create_instance(1);
+  iotc_lock_critical_section(&iotc_globals_cs);
+  iotc_globals.globals_ref_count += 1;
 
-    iotc_globals.context_handles_vector = iotc_vector_create();
-    iotc_globals.timed_tasks_container = iotc_make_timed_task_container();
+  if (1 == iotc_globals.globals_ref_count) {
+    state = iotc_create_globals();
   }
+  iotc_unlock_critical_section(&iotc_globals_cs);
+
+  IOTC_CHECK_STATE(state);
 
   /* Allocate the structure to store new context. */
   IOTC_ALLOC_AT(iotc_context_t, *context, state);
@@ -139,7 +209,12 @@ iotc_state_t iotc_create_context_with_custom_layers_and_evtd(
   (*context)->context_data.io_timeouts = iotc_vector_create();
 
   IOTC_CHECK_MEMORY((*context)->context_data.io_timeouts, state);
-  /* Set the event dispatcher to the global one, if none is provided. */
+  /* Set the event dispatcher to the least loaded shard or to the global one,
+   * if none is provided. */
+  if (NULL == event_dispatcher) {
+    event_dispatcher = iotc_event_loop_shards_acquire();
+  }
+
   (*context)->context_data.evtd_instance = (NULL == event_dispatcher)
                                                ? iotc_globals.evtd_instance
                                                : event_dispatcher;
@@ -150,15 +225,47 @@ iotc_state_t iotc_create_context_with_custom_layers_and_evtd(
   (*context)->layer_chain = iotc_layer_chain_create(
       layer_chain, layer_chain_size, &(*context)->context_data, layer_config);
 
+  iotc_context_handle_t context_handle = IOTC_INVALID_CONTEXT_HANDLE;
+
   IOTC_CHECK_STATE(state = iotc_register_handle_for_object(
-                       iotc_globals.context_handles_vector,
-                       IOTC_MAX_NUM_CONTEXTS, *context));
+                       iotc_globals.context_handles, *context,
+                       &context_handle));
+
+#ifdef IOTC_MEMORY_ACCOUNTING_ENABLED
+  /* the budget and the counters of a deleted context don't carry over */
+  iotc_memory_accounting_reset_owner(
+      iotc_memory_accounting_owner_for_context(context_handle));
+#else
+  IOTC_UNUSED(context_handle);
+#endif
 
   return IOTC_STATE_OK;
 
 err_handling:
-  /* @TODO release any allocated buffers. */
+  /* e.g. the context handles are all taken, undo what was done so far */
+  if (NULL != *context) {
+    if (NULL != (*context)->layer_chain.bottom) {
+      iotc_layer_chain_delete(&(*context)->layer_chain, layer_chain_size,
+                              layer_config);
+    }
+
+    iotc_event_loop_shards_release((*context)->context_data.evtd_instance);
+
+    if (NULL != (*context)->context_data.io_timeouts) {
+      iotc_vector_destroy((*context)->context_data.io_timeouts);
+    }
+  }
+
   IOTC_SAFE_FREE(*context);
+
+  iotc_lock_critical_section(&iotc_globals_cs);
+  iotc_globals.globals_ref_count -= 1;
+
+  if (0 == iotc_globals.globals_ref_count) {
+    iotc_destroy_globals();
+  }
+  iotc_unlock_critical_section(&iotc_globals_cs);
+
   return state;
 }
 
@@ -178,9 +285,8 @@ iotc_context_handle_t iotc_create_context() {
                        IOTC_LAYER_CHAIN_DEFAULTSIZE_SUFFIX));
 
   iotc_context_handle_t context_handle;
-  IOTC_CHECK_STATE(
-      state = iotc_find_handle_for_object(iotc_globals.context_handles_vector,
-                                          context, &context_handle));
+  IOTC_CHECK_STATE(state = iotc_find_handle_for_object(
+                       iotc_globals.context_handles, context, &context_handle));
 
   goto end;
 err_handling:
@@ -231,6 +337,11 @@ static void iotc_free_context_data(iotc_context_t* context) {
     IOTC_SAFE_FREE(context_data->updateable_files);
   }
 
+  /* the messages which never reached the broker may survive the context */
+  iotc_offline_queue_save(&context_data->offline_queue);
+  iotc_offline_queue_destroy(&context_data->offline_queue);
+  iotc_session_store_destroy(&context_data->session_store);
+
   iotc_free_connection_data(&context_data->connection_data);
 
   /* Remember: event dispatcher ownership is not taken, this is why we don't
@@ -247,42 +358,42 @@ iotc_state_t iotc_delete_context_with_custom_layers(
 
   iotc_state_t state = IOTC_STATE_OK;
 
-  state = iotc_delete_handle_for_object(iotc_globals.context_handles_vector,
-                                        *context);
+  state = iotc_delete_handle_for_object(iotc_globals.context_handles, *context);
 
   if (IOTC_STATE_OK != state) {
     return IOTC_ELEMENT_NOT_FOUND;
   }
 
+  if (NULL != (*context)->context_data.connect_handler.ptr_to_position) {
+    iotc_evtd_cancel((*context)->context_data.evtd_instance,
+                     &(*context)->context_data.connect_handler);
+  }
+
+  iotc_connect_scheduler_cancel(&(*context)->context_data);
+
   iotc_layer_chain_delete(&((*context)->layer_chain), layer_chain_size,
                           layer_config);
 
+  iotc_event_loop_shards_release((*context)->context_data.evtd_instance);
+
   iotc_free_context_data(*context);
 
   IOTC_SAFE_FREE(*context);
 
+  iotc_lock_critical_section(&iotc_globals_cs);
   iotc_globals.globals_ref_count -= 1;
 
   if (0 == iotc_globals.globals_ref_count) {
-    iotc_cancel_backoff_event();
-    iotc_backoff_release();
-    iotc_evtd_destroy_instance(iotc_globals.evtd_instance);
-    iotc_globals.evtd_instance = NULL;
-    iotc_threadpool_destroy_instance(&iotc_globals.main_threadpool);
-
-    iotc_vector_destroy(iotc_globals.context_handles_vector);
-    iotc_globals.context_handles_vector = NULL;
-
-    iotc_destroy_timed_task_container(iotc_globals.timed_tasks_container);
-    iotc_globals.timed_tasks_container = NULL;
+    iotc_destroy_globals();
   }
+  iotc_unlock_critical_section(&iotc_globals_cs);
 
   return IOTC_STATE_OK;
 }
 
 iotc_state_t iotc_delete_context(iotc_context_handle_t context_handle) {
   iotc_context_t* context = iotc_object_for_handle(
-      iotc_globals.context_handles_vector, context_handle);
+      iotc_globals.context_handles, context_handle);
   assert(context != NULL);
 
   return iotc_delete_context_with_custom_layers(
@@ -305,9 +416,8 @@ iotc_state_t iotc_user_callback_wrapper(void* context, void* data,
 
   iotc_state_t state = IOTC_STATE_OK;
   iotc_context_handle_t context_handle;
-  IOTC_CHECK_STATE(
-      state = iotc_find_handle_for_object(iotc_globals.context_handles_vector,
-                                          context, &context_handle));
+  IOTC_CHECK_STATE(state = iotc_find_handle_for_object(
+                       iotc_globals.context_handles, context, &context_handle));
 
   ((iotc_user_callback_t*)(client_callback))(context_handle, data, in_state);
 
@@ -321,7 +431,7 @@ extern uint8_t iotc_is_context_connected(iotc_context_handle_t iotc_h) {
   }
 
   iotc_context_t* iotc = (iotc_context_t*)iotc_object_for_handle(
-      iotc_globals.context_handles_vector, iotc_h);
+      iotc_globals.context_handles, iotc_h);
 
   if (NULL == iotc || NULL == iotc->context_data.connection_data) {
     return 0;
@@ -332,8 +442,96 @@ extern uint8_t iotc_is_context_connected(iotc_context_handle_t iotc_h) {
          IOTC_SHUTDOWN_UNINITIALISED == iotc->context_data.shutdown_state;
 }
 
+iotc_state_t iotc_set_socket_options(
+    iotc_context_handle_t iotc_h,
+    const iotc_bsp_socket_options_t* socket_options) {
+  if (IOTC_INVALID_CONTEXT_HANDLE >= iotc_h) {
+    return IOTC_NULL_CONTEXT;
+  }
+
+  iotc_context_t* iotc = (iotc_context_t*)iotc_object_for_handle(
+      iotc_globals.context_handles, iotc_h);
+
+  if (NULL == iotc) {
+    return IOTC_NULL_CONTEXT;
+  }
+
+  if (NULL == socket_options) {
+    memset(&iotc->context_data.socket_options, 0,
+           sizeof(iotc_bsp_socket_options_t));
+  } else {
+    iotc->context_data.socket_options = *socket_options;
+  }
+
+  return IOTC_STATE_OK;
+}
+
+iotc_state_t iotc_set_offline_queue(iotc_context_handle_t iotc_h,
+                                    const iotc_offline_queue_config_t* config) {
+  if (IOTC_INVALID_CONTEXT_HANDLE >= iotc_h) {
+    return IOTC_NULL_CONTEXT;
+  }
+
+  if (NULL == config) {
+    return IOTC_INVALID_PARAMETER;
+  }
+
+  iotc_context_t* iotc = (iotc_context_t*)iotc_object_for_handle(
+      iotc_globals.context_handles, iotc_h);
+
+  if (NULL == iotc) {
+    return IOTC_NULL_CONTEXT;
+  }
+
+  iotc_state_t state = IOTC_STATE_OK;
+
+  IOTC_MEMORY_ACCOUNTING_ENTER_CONTEXT(iotc_h);
+
+  state = iotc_offline_queue_configure(&iotc->context_data.offline_queue,
+                                       config,
+                                       iotc->context_data.evtd_instance);
+
+  IOTC_MEMORY_ACCOUNTING_LEAVE_CONTEXT();
+
+  return state;
+}
+
+iotc_state_t iotc_set_session_store(iotc_context_handle_t iotc_h,
+                                    const iotc_session_store_config_t* config) {
+  if (IOTC_INVALID_CONTEXT_HANDLE >= iotc_h) {
+    return IOTC_NULL_CONTEXT;
+  }
+
+  iotc_context_t* iotc = (iotc_context_t*)iotc_object_for_handle(
+      iotc_globals.context_handles, iotc_h);
+
+  if (NULL == iotc) {
+    return IOTC_NULL_CONTEXT;
+  }
+
+  iotc_state_t state = IOTC_STATE_OK;
+
+  IOTC_MEMORY_ACCOUNTING_ENTER_CONTEXT(iotc_h);
+
+  state = iotc_session_store_configure(&iotc->context_data.session_store,
+                                       config,
+                                       iotc->context_data.evtd_instance);
+
+  IOTC_MEMORY_ACCOUNTING_LEAVE_CONTEXT();
+
+  return state;
+}
+
 void iotc_events_stop() { iotc_evtd_stop(iotc_globals.evtd_instance); }
 
+iotc_state_t iotc_start_event_loop_shards(const uint8_t num_shards) {
+  return iotc_event_loop_shards_start(num_shards);
+}
+
+iotc_state_t iotc_stop_event_loop_shards() {
+  return iotc_event_loop_shards_stop();
+}
+
 void iotc_events_process_blocking() {
   iotc_event_loop_with_evtds(0, &iotc_globals.evtd_instance, 1);
 }
@@ -365,17 +563,17 @@ iotc_state_t iotc_connect(iotc_context_handle_t iotc_h, const char* username,
                          client_callback);
 }
 
-iotc_state_t iotc_connect_to(iotc_context_handle_t iotc_h, const char* host,
-                             uint16_t port, const char* username,
-                             const char* password, const char* client_id,
-                             uint16_t connection_timeout,
-                             uint16_t keepalive_timeout,
-                             iotc_user_callback_t* client_callback) {
+static iotc_state_t iotc_connect_to_impl(
+    iotc_context_handle_t iotc_h, const char* host, uint16_t port,
+    const char* username, const char* password, const char* client_id,
+    uint16_t connection_timeout, uint16_t keepalive_timeout,
+    iotc_user_callback_t* client_callback) {
   iotc_state_t state = IOTC_STATE_OK;
   iotc_context_t* iotc = NULL;
   iotc_event_handle_t event_handle = iotc_make_empty_event_handle();
   iotc_layer_t* input_layer = NULL;
   uint32_t new_backoff = 0;
+  iotc_session_type_t session_type = IOTC_SESSION_CLEAN;
 
   IOTC_CHECK_CND_DBGMESSAGE(NULL == host, IOTC_NULL_HOST, state,
                             "ERROR: NULL host provided");
@@ -390,7 +588,7 @@ iotc_state_t iotc_connect_to(iotc_context_handle_t iotc_h, const char* host,
     username = "";
   }
 
-  iotc = iotc_object_for_handle(iotc_globals.context_handles_vector, iotc_h);
+  iotc = iotc_object_for_handle(iotc_globals.context_handles, iotc_h);
 
   IOTC_CHECK_CND_DBGMESSAGE(NULL == iotc, IOTC_NULL_CONTEXT, state,
                             "ERROR: NULL context provided");
@@ -398,11 +596,12 @@ iotc_state_t iotc_connect_to(iotc_context_handle_t iotc_h, const char* host,
   assert(NULL != client_callback);
 
   event_handle = iotc_make_threaded_handle(
-      IOTC_THREADID_THREAD_0, &iotc_user_callback_wrapper, iotc, NULL,
-      IOTC_STATE_OK, (void*)client_callback);
+      IOTC_CONTEXT_CALLBACK_THREADID(iotc_h), &iotc_user_callback_wrapper,
+      iotc, NULL, IOTC_STATE_OK, (void*)client_callback);
 
   /* Guard against adding two connection requests. */
-  if (NULL != iotc->context_data.connect_handler.ptr_to_position) {
+  if (NULL != iotc->context_data.connect_handler.ptr_to_position ||
+      iotc_connect_scheduler_is_waiting(&iotc->context_data)) {
     iotc_debug_format(
         "Connect could not be performed due to connection state = %d,"
         "check if connect operation hasn't been already started.",
@@ -429,20 +628,27 @@ iotc_state_t iotc_connect_to(iotc_context_handle_t iotc_h, const char* host,
   input_layer = iotc->layer_chain.top;
   iotc->protocol = IOTC_MQTT;
 
+  if (1 == iotc_session_store_is_enabled(&iotc->context_data.session_store)) {
+    session_type = IOTC_SESSION_CONTINUE;
+  }
+
   if (NULL != iotc->context_data.connection_data) {
     IOTC_CHECK_STATE(iotc_connection_data_update_lastwill(
         iotc->context_data.connection_data, host, port, username, password,
-        client_id, connection_timeout, keepalive_timeout, IOTC_SESSION_CLEAN,
-        NULL, NULL, (iotc_mqtt_qos_t)0, (iotc_mqtt_retain_t)0));
+        client_id, connection_timeout, keepalive_timeout, session_type, NULL,
+        NULL, (iotc_mqtt_qos_t)0, (iotc_mqtt_retain_t)0));
   } else {
     iotc->context_data.connection_data = iotc_alloc_connection_data_lastwill(
         host, port, username, password, client_id, connection_timeout,
-        keepalive_timeout, IOTC_SESSION_CLEAN, NULL, NULL, (iotc_mqtt_qos_t)0,
+        keepalive_timeout, session_type, NULL, NULL, (iotc_mqtt_qos_t)0,
         (iotc_mqtt_retain_t)0);
 
     IOTC_CHECK_MEMORY(iotc->context_data.connection_data, state);
   }
 
+  iotc->context_data.connection_data->socket_options =
+      iotc->context_data.socket_options;
+
   iotc_debug_format("New host:port [%s]:[%hu]",
                     iotc->context_data.connection_data->host,
                     iotc->context_data.connection_data->port);
@@ -461,13 +667,13 @@ iotc_state_t iotc_connect_to(iotc_context_handle_t iotc_h, const char* host,
 
   iotc_debug_format("new backoff value: %d", new_backoff);
 
-  /* Register the execution in next init. */
-  state = iotc_evtd_execute_in(
-      iotc->context_data.evtd_instance,
+  /* Register the execution in next init, once the connect is admitted. */
+  state = iotc_connect_scheduler_submit(
+      &iotc->context_data,
       iotc_make_handle(input_layer->layer_connection.self->layer_funcs->init,
                        &input_layer->layer_connection,
                        iotc->context_data.connection_data, IOTC_STATE_OK),
-      new_backoff, &iotc->context_data.connect_handler);
+      new_backoff);
 
   IOTC_CHECK_STATE(state);
 
@@ -477,6 +683,197 @@ err_handling:
   return state;
 }
 
+iotc_state_t iotc_connect_to(iotc_context_handle_t iotc_h, const char* host,
+                             uint16_t port, const char* username,
+                             const char* password, const char* client_id,
+                             uint16_t connection_timeout,
+                             uint16_t keepalive_timeout,
+                             iotc_user_callback_t* client_callback) {
+  IOTC_MEMORY_ACCOUNTING_ENTER_CONTEXT(iotc_h);
+
+  const iotc_state_t state = iotc_connect_to_impl(
+      iotc_h, host, port, username, password, client_id, connection_timeout,
+      keepalive_timeout, client_callback);
+
+  IOTC_MEMORY_ACCOUNTING_LEAVE_CONTEXT();
+
+  return state;
+}
+
+#ifndef IOTC_NO_CONTEXT_STATS
+static uint16_t iotc_logic_task_queue_depth(
+    const iotc_mqtt_logic_task_queue_t* queue) {
+  uint16_t depth = 0;
+  const iotc_mqtt_logic_task_t* task = queue->head;
+
+  for (; NULL != task; task = task->__next) {
+    ++depth;
+  }
+
+  return depth;
+}
+
+static void iotc_sample_queue_depths(iotc_context_t* iotc,
+                                     iotc_context_stats_t* stats) {
+  stats->logic_queue_depth = 0;
+  stats->codec_queue_depth = 0;
+
+  iotc_layer_t* logic_layer = iotc_mqtt_logic_layer_find(&iotc->layer_chain);
+
+  if (NULL == logic_layer) {
+    return;
+  }
+
+  const iotc_mqtt_logic_layer_data_t* logic_data =
+      (iotc_mqtt_logic_layer_data_t*)logic_layer->user_data;
+
+  if (NULL != logic_data) {
+    stats->logic_queue_depth =
+        iotc_logic_task_queue_depth(&logic_data->q0_tasks_queue) +
+        iotc_logic_task_queue_depth(&logic_data->q12_tasks_queue) +
+        iotc_logic_task_queue_depth(&logic_data->q12_recv_tasks_queue);
+  }
+
+  iotc_layer_t* codec_layer = logic_layer->layer_connection.prev;
+
+  if (NULL == codec_layer ||
+      &iotc_mqtt_codec_layer_push != codec_layer->layer_funcs->push ||
+      NULL == codec_layer->user_data) {
+    return;
+  }
+
+  const iotc_mqtt_codec_layer_data_t* codec_data =
+      (iotc_mqtt_codec_layer_data_t*)codec_layer->user_data;
+  const iotc_mqtt_codec_layer_task_t* task = codec_data->task_queue.head;
+
+  for (; NULL != task; task = task->__next) {
+    ++stats->codec_queue_depth;
+  }
+}
+#endif
+
+iotc_state_t iotc_get_context_stats(iotc_context_handle_t iotc_h,
+                                    iotc_context_stats_t* stats) {
+#ifdef IOTC_NO_CONTEXT_STATS
+  IOTC_UNUSED(iotc_h);
+  IOTC_UNUSED(stats);
+  return IOTC_NOT_SUPPORTED;
+#else
+  if (IOTC_INVALID_CONTEXT_HANDLE >= iotc_h) {
+    return IOTC_NULL_CONTEXT;
+  }
+
+  if (NULL == stats) {
+    return IOTC_INVALID_PARAMETER;
+  }
+
+  iotc_context_t* iotc = (iotc_context_t*)iotc_object_for_handle(
+      iotc_globals.context_handles, iotc_h);
+
+  if (NULL == iotc) {
+    return IOTC_NULL_CONTEXT;
+  }
+
+  *stats = iotc->context_data.stats.counters;
+  /* the estimate is not a counter, a reset doesn't forget it */
+  stats->smoothed_rtt_ms = iotc->context_data.rtt_estimator.srtt_ms;
+  stats->rtt_variance_ms = iotc->context_data.rtt_estimator.rttvar_ms;
+  iotc_sample_queue_depths(iotc, stats);
+
+  return IOTC_STATE_OK;
+#endif
+}
+
+iotc_state_t iotc_reset_context_stats(iotc_context_handle_t iotc_h) {
+#ifdef IOTC_NO_CONTEXT_STATS
+  IOTC_UNUSED(iotc_h);
+  return IOTC_NOT_SUPPORTED;
+#else
+  if (IOTC_INVALID_CONTEXT_HANDLE >= iotc_h) {
+    return IOTC_NULL_CONTEXT;
+  }
+
+  iotc_context_t* iotc = (iotc_context_t*)iotc_object_for_handle(
+      iotc_globals.context_handles, iotc_h);
+
+  if (NULL == iotc) {
+    return IOTC_NULL_CONTEXT;
+  }
+
+  /* connected_before stays, the next CONNACK is still a reconnect */
+  memset(&iotc->context_data.stats.counters, 0,
+         sizeof(iotc->context_data.stats.counters));
+
+  return IOTC_STATE_OK;
+#endif
+}
+
+/* the offline queue asks this with its lock held, see
+ * iotc_offline_queue_push_unless_online */
+static uint8_t iotc_can_publish_now(iotc_context_handle_t iotc_h) {
+  return (IOTC_BACKOFF_CLASS_NONE ==
+              iotc_globals.backoff_status.backoff_class &&
+          1 == iotc_is_context_connected(iotc_h))
+             ? 1
+             : 0;
+}
+
+/* Runs on the context's event loop, the only thread that may look at the q0
+ * lane of the logic layer. Either hands the message straight to the codec or
+ * falls back to a regular logic task when the lane is busy. */
+static iotc_state_t iotc_publish_q0_on_event_loop(void* context_handle,
+                                                  void* topic,
+                                                  iotc_state_t in_state,
+                                                  void* data, void* user_data,
+                                                  void* callback) {
+  IOTC_UNUSED(in_state);
+
+  const iotc_context_handle_t iotc_h =
+      (iotc_context_handle_t)(intptr_t)context_handle;
+  char* topic_copy = (char*)topic;
+  iotc_data_desc_t* payload = (iotc_data_desc_t*)data;
+  iotc_mqtt_logic_task_t* task = NULL;
+  iotc_layer_t* logic_layer = NULL;
+  iotc_state_t state = IOTC_STATE_OK;
+
+  /* the context may have been deleted since the publish */
+  iotc_context_t* iotc = (iotc_context_t*)iotc_object_for_handle(
+      iotc_globals.context_handles, iotc_h);
+
+  IOTC_CHECK_CND_DBGMESSAGE(NULL == iotc, IOTC_NULL_CONTEXT, state,
+                            "context deleted before its publish ran");
+
+  iotc_event_handle_t event_handle = iotc_make_threaded_handle(
+      IOTC_CONTEXT_CALLBACK_THREADID(iotc_h), &iotc_user_callback_wrapper,
+      iotc, user_data, IOTC_STATE_OK, callback);
+
+  logic_layer = iotc_mqtt_logic_layer_find(&iotc->layer_chain);
+
+  if (1 == iotc_mqtt_logic_layer_can_publish_q0_fast(
+               &logic_layer->layer_connection, payload->length)) {
+    return iotc_mqtt_logic_layer_publish_q0_fast(
+        &logic_layer->layer_connection, topic_copy, payload, event_handle);
+  }
+
+  task = iotc_mqtt_logic_make_publish_task(topic_copy, payload,
+                                           IOTC_MQTT_QOS_AT_MOST_ONCE,
+                                           (iotc_mqtt_retain_t)0, event_handle);
+
+  IOTC_CHECK_MEMORY(task, state);
+
+  /* the task made its own copy of the topic and owns the payload */
+  IOTC_SAFE_FREE(topic_copy);
+
+  /* already on the loop, the same way the offline queue drains */
+  return iotc_mqtt_logic_layer_push(&logic_layer->layer_connection, task,
+                                    IOTC_STATE_OK);
+
+err_handling:
+  IOTC_SAFE_FREE(topic_copy);
+  iotc_free_desc(&payload);
+  return state;
+}
+
 iotc_state_t iotc_publish_data_impl(iotc_context_handle_t iotc_h,
                                     const char* topic, iotc_data_desc_t* data,
                                     const iotc_mqtt_qos_t qos,
@@ -485,7 +882,7 @@ iotc_state_t iotc_publish_data_impl(iotc_context_handle_t iotc_h,
   /* PRE-CONDITIONS */
   assert(IOTC_INVALID_CONTEXT_HANDLE < iotc_h);
   iotc_context_t* iotc = (iotc_context_t*)iotc_object_for_handle(
-      iotc_globals.context_handles_vector, iotc_h);
+      iotc_globals.context_handles, iotc_h);
   assert(NULL != iotc);
 
   if (NULL == callback) {
@@ -494,12 +891,23 @@ iotc_state_t iotc_publish_data_impl(iotc_context_handle_t iotc_h,
   }
 
   iotc_event_handle_t event_handle = iotc_make_threaded_handle(
-      IOTC_THREADID_THREAD_0, &iotc_user_callback_wrapper, iotc, user_data,
-      IOTC_STATE_OK, (void*)callback);
+      IOTC_CONTEXT_CALLBACK_THREADID(iotc_h), &iotc_user_callback_wrapper,
+      iotc, user_data, IOTC_STATE_OK, (void*)callback);
 
   assert(IOTC_EVENT_HANDLE_ARGC4 == event_handle.handle_type ||
          IOTC_EVENT_HANDLE_UNSET == event_handle.handle_type);
 
+  iotc_state_t state = IOTC_STATE_OK;
+
+  /* stored until the next CONNACK, the queue keeps the order of the messages
+   * published meanwhile until it is drained */
+  if (1 == iotc_offline_queue_push_unless_online(
+               &iotc->context_data.offline_queue, &iotc_can_publish_now, iotc_h,
+               topic, data, qos, event_handle,
+               iotc->context_data.evtd_instance, &state)) {
+    return state;
+  }
+
   if (IOTC_BACKOFF_CLASS_NONE != iotc_globals.backoff_status.backoff_class) {
     iotc_free_desc(&data);
     return IOTC_BACKOFF_TERMINAL;
@@ -508,7 +916,6 @@ iotc_state_t iotc_publish_data_impl(iotc_context_handle_t iotc_h,
   iotc_mqtt_qos_t effective_qos = qos;
 
   iotc_mqtt_logic_task_t* task = NULL;
-  iotc_state_t state = IOTC_STATE_OK;
   iotc_layer_t* input_layer = iotc->layer_chain.top;
 
   iotc_mqtt_logic_layer_data_t* layer_data =
@@ -516,6 +923,28 @@ iotc_state_t iotc_publish_data_impl(iotc_context_handle_t iotc_h,
 
   IOTC_UNUSED(layer_data);
 
+  /* fire-and-forget messages skip the logic task while the q0 lane is idle,
+   * which only the context's event loop can tell */
+  if (IOTC_MQTT_QOS_AT_MOST_ONCE == effective_qos &&
+      data->length <= IOTC_MQTT_MAX_PAYLOAD_SIZE &&
+      NULL != iotc_mqtt_logic_layer_find(&iotc->layer_chain)) {
+    char* topic_copy = iotc_str_dup(topic);
+
+    if (NULL == topic_copy ||
+        NULL == iotc_evtd_execute(
+                    iotc->context_data.evtd_instance,
+                    iotc_make_handle(&iotc_publish_q0_on_event_loop,
+                                     (void*)(intptr_t)iotc_h, topic_copy,
+                                     IOTC_STATE_OK, data, user_data,
+                                     (void*)callback))) {
+      IOTC_SAFE_FREE(topic_copy);
+      iotc_free_desc(&data);
+      return IOTC_OUT_OF_MEMORY;
+    }
+
+    return IOTC_STATE_OK;
+  }
+
   task = iotc_mqtt_logic_make_publish_task(topic, data, effective_qos,
                                            (iotc_mqtt_retain_t)0, event_handle);
 
@@ -541,14 +970,17 @@ iotc_state_t iotc_publish(iotc_context_handle_t iotc_h, const char* topic,
 
   iotc_state_t state = IOTC_STATE_OK;
 
+  IOTC_MEMORY_ACCOUNTING_ENTER_CONTEXT(iotc_h);
+
   iotc_data_desc_t* data_desc = iotc_make_desc_from_string_copy(msg);
 
   IOTC_CHECK_MEMORY(data_desc, state);
 
-  return iotc_publish_data_impl(iotc_h, topic, data_desc, qos, callback,
-                                user_data);
+  state = iotc_publish_data_impl(iotc_h, topic, data_desc, qos, callback,
+                                 user_data);
 
 err_handling:
+  IOTC_MEMORY_ACCOUNTING_LEAVE_CONTEXT();
   return state;
 }
 
@@ -564,21 +996,23 @@ iotc_state_t iotc_publish_data(iotc_context_handle_t iotc_h, const char* topic,
 
   iotc_state_t state = IOTC_STATE_OK;
 
+  IOTC_MEMORY_ACCOUNTING_ENTER_CONTEXT(iotc_h);
+
   iotc_data_desc_t* data_desc = iotc_make_desc_from_buffer_copy(data, data_len);
 
   IOTC_CHECK_MEMORY(data_desc, state);
 
-  return iotc_publish_data_impl(iotc_h, topic, data_desc, qos, callback,
-                                user_data);
+  state = iotc_publish_data_impl(iotc_h, topic, data_desc, qos, callback,
+                                 user_data);
 
 err_handling:
+  IOTC_MEMORY_ACCOUNTING_LEAVE_CONTEXT();
   return state;
 }
 
-iotc_state_t iotc_subscribe(iotc_context_handle_t iotc_h, const char* topic,
-                            const iotc_mqtt_qos_t qos,
-                            iotc_user_subscription_callback_t* callback,
-                            void* user_data) {
+static iotc_state_t iotc_subscribe_impl(
+    iotc_context_handle_t iotc_h, const char* topic, const iotc_mqtt_qos_t qos,
+    iotc_user_subscription_callback_t* callback, void* user_data) {
   if ((IOTC_INVALID_CONTEXT_HANDLE == iotc_h) || (NULL == topic) ||
       (NULL == callback)) {
     return IOTC_INVALID_PARAMETER;
@@ -591,13 +1025,14 @@ iotc_state_t iotc_subscribe(iotc_context_handle_t iotc_h, const char* topic,
   iotc_event_handle_t event_handle = iotc_make_empty_event_handle();
 
   iotc_context_t* iotc = (iotc_context_t*)iotc_object_for_handle(
-      iotc_globals.context_handles_vector, iotc_h);
+      iotc_globals.context_handles, iotc_h);
 
   IOTC_CHECK_MEMORY(iotc, state);
 
   event_handle = iotc_make_threaded_handle(
-      IOTC_THREADID_THREAD_0, &iotc_user_sub_call_wrapper, iotc, NULL,
-      IOTC_STATE_OK, (void*)callback, (void*)user_data, (void*)NULL);
+      IOTC_CONTEXT_CALLBACK_THREADID(iotc_h), &iotc_user_sub_call_wrapper,
+      iotc, NULL, IOTC_STATE_OK, (void*)callback, (void*)user_data,
+      (void*)NULL);
 
   if (IOTC_BACKOFF_CLASS_NONE != iotc_globals.backoff_status.backoff_class) {
     return IOTC_BACKOFF_TERMINAL;
@@ -632,16 +1067,50 @@ err_handling:
   return state;
 }
 
-iotc_state_t iotc_shutdown_connection(iotc_context_handle_t iotc_h) {
+iotc_state_t iotc_subscribe(iotc_context_handle_t iotc_h, const char* topic,
+                            const iotc_mqtt_qos_t qos,
+                            iotc_user_subscription_callback_t* callback,
+                            void* user_data) {
+  IOTC_MEMORY_ACCOUNTING_ENTER_CONTEXT(iotc_h);
+
+  const iotc_state_t state =
+      iotc_subscribe_impl(iotc_h, topic, qos, callback, user_data);
+
+  IOTC_MEMORY_ACCOUNTING_LEAVE_CONTEXT();
+
+  return state;
+}
+
+static iotc_state_t iotc_shutdown_connection_impl(
+    iotc_context_handle_t iotc_h) {
   assert(IOTC_INVALID_CONTEXT_HANDLE < iotc_h);
   iotc_context_t* itoc =
-      iotc_object_for_handle(iotc_globals.context_handles_vector, iotc_h);
+      iotc_object_for_handle(iotc_globals.context_handles, iotc_h);
   assert(NULL != itoc);
 
   iotc_state_t state = IOTC_STATE_OK;
   iotc_layer_t* input_layer = itoc->layer_chain.top;
   iotc_mqtt_logic_task_t* task = NULL;
 
+  /* the connect is delayed until other contexts finish their handshakes,
+   * it never started so the user learns about its end from here */
+  if (iotc_connect_scheduler_is_waiting(&itoc->context_data)) {
+    iotc_connect_scheduler_cancel(&itoc->context_data);
+
+    itoc->context_data.connection_data->connection_state =
+        IOTC_CONNECTION_STATE_OPEN_FAILED;
+
+    itoc->context_data.connection_callback.handlers.h3.a2 =
+        itoc->context_data.connection_data;
+    itoc->context_data.connection_callback.handlers.h3.a3 =
+        IOTC_CONNECTION_CANCELLED_ERROR;
+
+    iotc_evttd_execute(itoc->context_data.evtd_instance,
+                       itoc->context_data.connection_callback);
+
+    return IOTC_STATE_OK;
+  }
+
   /* check if connect operation has been finished */
   if (NULL == itoc->context_data.connect_handler.ptr_to_position) {
     /* check if the connection is not established for any reason */
@@ -657,6 +1126,8 @@ iotc_state_t iotc_shutdown_connection(iotc_context_handle_t iotc_h) {
 
     IOTC_CHECK_STATE(state);
 
+    iotc_connect_scheduler_cancel(&itoc->context_data);
+
     return IOTC_STATE_OK;
   }
 
@@ -685,13 +1156,37 @@ err_handling:
   return state;
 }
 
+iotc_state_t iotc_shutdown_connection(iotc_context_handle_t iotc_h) {
+  IOTC_MEMORY_ACCOUNTING_ENTER_CONTEXT(iotc_h);
+
+  const iotc_state_t state = iotc_shutdown_connection_impl(iotc_h);
+
+  IOTC_MEMORY_ACCOUNTING_LEAVE_CONTEXT();
+
+  return state;
+}
+
 iotc_timed_task_handle_t iotc_schedule_timed_task(
     iotc_context_handle_t iotc_h, iotc_user_task_callback_t* callback,
     const iotc_time_t seconds_from_now, const uint8_t repeats_forever,
     void* data) {
-  return iotc_add_timed_task(iotc_globals.timed_tasks_container,
-                             iotc_globals.evtd_instance, iotc_h, callback,
-                             seconds_from_now, repeats_forever, data);
+  iotc_context_t* iotc = (iotc_context_t*)iotc_object_for_handle(
+      iotc_globals.context_handles, iotc_h);
+
+  if (NULL == iotc) {
+    return -IOTC_NULL_CONTEXT;
+  }
+
+  IOTC_MEMORY_ACCOUNTING_ENTER_CONTEXT(iotc_h);
+
+  /* the task runs on the dispatcher of its context */
+  const iotc_timed_task_handle_t timed_task_handle = iotc_add_timed_task(
+      iotc_globals.timed_tasks_container, iotc->context_data.evtd_instance,
+      iotc_h, callback, seconds_from_now, repeats_forever, data);
+
+  IOTC_MEMORY_ACCOUNTING_LEAVE_CONTEXT();
+
+  return timed_task_handle;
 }
 
 void iotc_cancel_timed_task(iotc_timed_task_handle_t timed_task_handle) {
@@ -699,25 +1194,156 @@ void iotc_cancel_timed_task(iotc_timed_task_handle_t timed_task_handle) {
 }
 
 iotc_state_t iotc_set_maximum_heap_usage(const size_t max_bytes) {
-#ifndef IOTC_MEMORY_LIMITER_ENABLED
+#if defined(IOTC_MEMORY_LIMITER_ENABLED)
+  return iotc_memory_limiter_set_limit(max_bytes);
+#elif defined(IOTC_MEMORY_ACCOUNTING_ENABLED)
+  return iotc_memory_accounting_set_limit(max_bytes);
+#else
   IOTC_UNUSED(max_bytes);
   return IOTC_NOT_SUPPORTED;
-#else
-  return iotc_memory_limiter_set_limit(max_bytes);
 #endif
 }
 
 iotc_state_t iotc_get_heap_usage(size_t* const heap_usage) {
-#ifndef IOTC_MEMORY_LIMITER_ENABLED
+#if defined(IOTC_MEMORY_LIMITER_ENABLED) || \
+    defined(IOTC_MEMORY_ACCOUNTING_ENABLED)
+  if (NULL == heap_usage) {
+    return IOTC_INVALID_PARAMETER;
+  }
+
+#ifdef IOTC_MEMORY_LIMITER_ENABLED
+  *heap_usage = iotc_memory_limiter_get_allocated_space();
+#else
+  *heap_usage = iotc_memory_accounting_get_allocated_space();
+#endif
+  return IOTC_STATE_OK;
+#else
   IOTC_UNUSED(heap_usage);
   return IOTC_NOT_SUPPORTED;
+#endif
+}
+
+#ifdef IOTC_MEMORY_ACCOUNTING_ENABLED
+/* The accounting slot of a live context, none for a deleted one: the slot
+ * doesn't tell the generations of a handle apart. */
+static iotc_memory_accounting_owner_t iotc_memory_accounting_owner_for_handle(
+    iotc_context_handle_t context_handle) {
+  if (NULL == iotc_globals.context_handles ||
+      NULL == iotc_object_for_handle(iotc_globals.context_handles,
+                                     context_handle)) {
+    return IOTC_MEMORY_ACCOUNTING_OWNER_NONE;
+  }
+
+  return iotc_memory_accounting_owner_for_context(context_handle);
+}
+#endif
+
+iotc_state_t iotc_set_context_maximum_heap_usage(
+    iotc_context_handle_t context_handle, const size_t max_bytes) {
+#ifndef IOTC_MEMORY_ACCOUNTING_ENABLED
+  IOTC_UNUSED(context_handle);
+  IOTC_UNUSED(max_bytes);
+  return IOTC_NOT_SUPPORTED;
 #else
-  if (NULL == heap_usage) {
+  const iotc_memory_accounting_owner_t owner =
+      iotc_memory_accounting_owner_for_handle(context_handle);
+
+  if (IOTC_MEMORY_ACCOUNTING_OWNER_NONE == owner) {
     return IOTC_INVALID_PARAMETER;
   }
 
-  *heap_usage = iotc_memory_limiter_get_allocated_space();
+  return iotc_memory_accounting_set_budget(owner, max_bytes);
+#endif
+}
+
+iotc_state_t iotc_get_context_heap_usage(iotc_context_handle_t context_handle,
+                                         size_t* const heap_usage) {
+#ifndef IOTC_MEMORY_ACCOUNTING_ENABLED
+  IOTC_UNUSED(context_handle);
+  IOTC_UNUSED(heap_usage);
+  return IOTC_NOT_SUPPORTED;
+#else
+  const iotc_memory_accounting_owner_t owner =
+      iotc_memory_accounting_owner_for_handle(context_handle);
+  iotc_memory_accounting_stats_t stats;
+
+  if (NULL == heap_usage || IOTC_MEMORY_ACCOUNTING_OWNER_NONE == owner) {
+    return IOTC_INVALID_PARAMETER;
+  }
+
+  const iotc_state_t state = iotc_memory_accounting_get_stats(owner, &stats);
+  *heap_usage = stats.current;
+
+  return state;
+#endif
+}
+
+iotc_state_t iotc_export_layer_trace(iotc_layer_trace_writer_t* writer,
+                                     void* user_data) {
+#ifdef IOTC_LAYER_TRACING_ENABLED
+  return iotc_layer_tracing_export(writer, user_data);
+#else
+  IOTC_UNUSED(writer);
+  IOTC_UNUSED(user_data);
+  return IOTC_NOT_SUPPORTED;
+#endif
+}
+
+iotc_state_t iotc_clear_layer_trace(void) {
+#ifdef IOTC_LAYER_TRACING_ENABLED
+  iotc_layer_tracing_clear();
+  return IOTC_STATE_OK;
+#else
+  return IOTC_NOT_SUPPORTED;
+#endif
+}
+
+iotc_state_t iotc_set_debug_log_filter(const iotc_debug_log_level_t max_level,
+                                       const uint32_t modules) {
+#ifdef IOTC_DEBUG_BINARY_LOG
+  if (IOTC_DEBUG_LOG_LEVEL_TRACE < max_level) {
+    return IOTC_INVALID_PARAMETER;
+  }
+
+  iotc_debug_log_set_filter(max_level, modules);
+  return IOTC_STATE_OK;
+#else
+  IOTC_UNUSED(max_level);
+  IOTC_UNUSED(modules);
+  return IOTC_NOT_SUPPORTED;
+#endif
+}
+
+iotc_state_t iotc_drain_debug_log(iotc_debug_log_writer_t* writer,
+                                  void* user_data) {
+#ifdef IOTC_DEBUG_BINARY_LOG
+  return iotc_debug_log_drain(writer, user_data);
+#else
+  IOTC_UNUSED(writer);
+  IOTC_UNUSED(user_data);
+  return IOTC_NOT_SUPPORTED;
+#endif
+}
+
+iotc_state_t iotc_dump_heap_profile(const iotc_heap_profile_format_t format,
+                                    iotc_heap_profile_writer_t* writer,
+                                    void* user_data) {
+#ifdef IOTC_MEMORY_LIMITER_PROFILER_ENABLED
+  return iotc_memory_limiter_dump_profile(format, writer, user_data);
+#else
+  IOTC_UNUSED(format);
+  IOTC_UNUSED(writer);
+  IOTC_UNUSED(user_data);
+  return IOTC_NOT_SUPPORTED;
+#endif
+}
+
+iotc_state_t iotc_reset_heap_profile(void) {
+#ifdef IOTC_MEMORY_LIMITER_PROFILER_ENABLED
+  iotc_memory_limiter_reset_profile();
   return IOTC_STATE_OK;
+#else
+  return IOTC_NOT_SUPPORTED;
 #endif
 }
 
@@ -16,29 +16,60 @@
 
 #include "iotc_backoff_status_api.h"
 #include "iotc_bsp_rng.h"
+#include "iotc_critical_section.h"
+#include "iotc_critical_section_def.h"
 #include "iotc_globals.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/* the backoff is shared by the contexts of every loop shard, the public
+ * functions lock, the static ones expect the lock to be held */
+static struct iotc_critical_section_s iotc_backoff_cs = {0};
+
 /* local functions */
 static iotc_state_t iotc_apply_cooldown(void);
+static iotc_state_t iotc_restart_update_time_locked(void);
 
-void iotc_inc_backoff_penalty() {
+static void iotc_inc_backoff_penalty_locked(void) {
   iotc_globals.backoff_status.backoff_lut_i =
       IOTC_MIN(iotc_globals.backoff_status.backoff_lut_i + 1,
                iotc_globals.backoff_status.backoff_lut->elem_no - 1);
 
-  iotc_restart_update_time();
+  iotc_restart_update_time_locked();
 }
 
-void iotc_dec_backoff_penalty() {
+static void iotc_dec_backoff_penalty_locked(void) {
   iotc_globals.backoff_status.backoff_lut_i =
       IOTC_MAX(iotc_globals.backoff_status.backoff_lut_i - 1, 0);
 }
 
+static void iotc_cancel_backoff_event_locked(void) {
+  if (NULL != iotc_globals.backoff_status.next_update.ptr_to_position) {
+    iotc_evtd_cancel(iotc_globals.evtd_instance,
+                     &iotc_globals.backoff_status.next_update);
+  }
+}
+
+void iotc_inc_backoff_penalty() {
+  /* just to satisfy the compiler */
+  (void)iotc_backoff_cs;
+
+  iotc_lock_critical_section(&iotc_backoff_cs);
+  iotc_inc_backoff_penalty_locked();
+  iotc_unlock_critical_section(&iotc_backoff_cs);
+}
+
+void iotc_dec_backoff_penalty() {
+  iotc_lock_critical_section(&iotc_backoff_cs);
+  iotc_dec_backoff_penalty_locked();
+  iotc_unlock_critical_section(&iotc_backoff_cs);
+}
+
 uint32_t iotc_get_backoff_penalty() {
+  iotc_lock_critical_section(&iotc_backoff_cs);
+
   const iotc_backoff_lut_index_t prev_backoff_index =
       IOTC_MAX(iotc_globals.backoff_status.backoff_lut_i - 1, 0);
 
@@ -88,21 +119,26 @@ uint32_t iotc_get_backoff_penalty() {
       backoff_value, (int32_t)iotc_globals.backoff_status.backoff_lut->array[0]
                          .selector_t.ui32_value);
 
+  iotc_unlock_critical_section(&iotc_backoff_cs);
+
   return ret_value;
 }
 
 void iotc_cancel_backoff_event() {
-  if (NULL != iotc_globals.backoff_status.next_update.ptr_to_position) {
-    iotc_evtd_cancel(iotc_globals.evtd_instance,
-                     &iotc_globals.backoff_status.next_update);
-  }
+  iotc_lock_critical_section(&iotc_backoff_cs);
+  iotc_cancel_backoff_event_locked();
+  iotc_unlock_critical_section(&iotc_backoff_cs);
 }
 
 #ifdef IOTC_BACKOFF_RESET
 void iotc_reset_backoff_penalty() {
+  iotc_lock_critical_section(&iotc_backoff_cs);
+
   iotc_globals.backoff_status.backoff_lut_i = 0;
 
-  iotc_cancel_backoff_event();
+  iotc_cancel_backoff_event_locked();
+
+  iotc_unlock_critical_section(&iotc_backoff_cs);
 }
 #endif
 
@@ -165,12 +201,14 @@ iotc_backoff_class_t iotc_backoff_classify_state(const iotc_state_t state) {
 iotc_backoff_class_t iotc_update_backoff_penalty(const iotc_state_t state) {
   iotc_backoff_class_t backoff_class = iotc_backoff_classify_state(state);
 
+  iotc_lock_critical_section(&iotc_backoff_cs);
+
   iotc_globals.backoff_status.backoff_class = backoff_class;
 
   switch (backoff_class) {
     case IOTC_BACKOFF_CLASS_TERMINAL:
     case IOTC_BACKOFF_CLASS_RECOVERABLE:
-      iotc_inc_backoff_penalty();
+      iotc_inc_backoff_penalty_locked();
       iotc_debug_format("inc backoff index: %d",
                         iotc_globals.backoff_status.backoff_lut_i);
       break;
@@ -181,10 +219,20 @@ iotc_backoff_class_t iotc_update_backoff_penalty(const iotc_state_t state) {
       assert(0);
   }
 
+  iotc_unlock_critical_section(&iotc_backoff_cs);
+
   return backoff_class;
 }
 
 iotc_state_t iotc_restart_update_time() {
+  iotc_lock_critical_section(&iotc_backoff_cs);
+  const iotc_state_t local_state = iotc_restart_update_time_locked();
+  iotc_unlock_critical_section(&iotc_backoff_cs);
+
+  return local_state;
+}
+
+static iotc_state_t iotc_restart_update_time_locked(void) {
   iotc_state_t local_state = IOTC_STATE_OK;
   iotc_evtd_instance_t* event_dispatcher = iotc_globals.evtd_instance;
 
@@ -207,21 +255,27 @@ iotc_state_t iotc_restart_update_time() {
 }
 
 static iotc_state_t iotc_apply_cooldown(void) {
+  iotc_state_t local_state = IOTC_STATE_OK;
+
+  iotc_lock_critical_section(&iotc_backoff_cs);
+
   /* clearing the event pointer is the first thing to do */
   assert(NULL == iotc_globals.backoff_status.next_update.ptr_to_position);
 
   if (iotc_globals.backoff_status.backoff_class == IOTC_BACKOFF_CLASS_NONE) {
-    iotc_dec_backoff_penalty();
+    iotc_dec_backoff_penalty_locked();
     iotc_debug_format("dec backoff index: %d",
                       iotc_globals.backoff_status.backoff_lut_i);
   }
 
   /* if the backoff lut index is greater than 0 */
   if (iotc_globals.backoff_status.backoff_lut_i > 0) {
-    return iotc_restart_update_time();
+    local_state = iotc_restart_update_time_locked();
   }
 
-  return IOTC_STATE_OK;
+  iotc_unlock_critical_section(&iotc_backoff_cs);
+
+  return local_state;
 }
 
 #ifdef __cplusplus
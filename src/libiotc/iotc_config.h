@@ -17,6 +17,12 @@
 #ifndef __IOTC_CONFIG_H__
 #define __IOTC_CONFIG_H__
 
+/* contexts the handle table hands out, the memory accounting has a slot for
+ * each */
+#ifndef IOTC_MAX_NUM_CONTEXTS
+#define IOTC_MAX_NUM_CONTEXTS 2
+#endif
+
 #ifndef IOTC_IO_BUFFER_SIZE
 #define IOTC_IO_BUFFER_SIZE 32
 #endif
@@ -37,6 +43,51 @@
 #define IOTC_MAX_IDLE_TIMEOUT 5
 #endif
 
+#ifndef IOTC_MAX_CONCURRENT_CONNECTS
+#define IOTC_MAX_CONCURRENT_CONNECTS 8
+#endif
+
+#ifndef IOTC_CONNECT_JITTER_BASE
+#define IOTC_CONNECT_JITTER_BASE 1
+#endif
+
+#ifndef IOTC_CONNECT_JITTER_CAP
+#define IOTC_CONNECT_JITTER_CAP 64
+#endif
+
+#ifndef IOTC_DNS_MAX_ADDRESSES
+#define IOTC_DNS_MAX_ADDRESSES 4
+#endif
+
+#ifndef IOTC_DNS_CACHE_SIZE
+#define IOTC_DNS_CACHE_SIZE 8
+#endif
+
+#ifndef IOTC_DNS_CACHE_MAX_TTL
+#define IOTC_DNS_CACHE_MAX_TTL 3600
+#endif
+
+#ifndef IOTC_DNS_NEGATIVE_CACHE_TTL
+#define IOTC_DNS_NEGATIVE_CACHE_TTL 60
+#endif
+
+#ifndef IOTC_DNS_NEGATIVE_CACHE_MAX_TTL
+#define IOTC_DNS_NEGATIVE_CACHE_MAX_TTL 300
+#endif
+
+#ifndef IOTC_DNS_QUERY_TIMEOUT
+#define IOTC_DNS_QUERY_TIMEOUT 2
+#endif
+
+#ifndef IOTC_DNS_QUERY_ATTEMPTS
+#define IOTC_DNS_QUERY_ATTEMPTS 3
+#endif
+
+/* seconds between the connect attempts to the addresses of a host */
+#ifndef IOTC_IO_NET_RACE_ATTEMPT_DELAY
+#define IOTC_IO_NET_RACE_ATTEMPT_DELAY 1
+#endif
+
 #ifndef IOTC_MQTT_PORT
 #define IOTC_MQTT_PORT 8883
 /* note: usually port 1883 is used for insecure MQTT connections */
@@ -0,0 +1,287 @@
+/* Copyright 2018-2020 Google LLC
+ *
+ * This is part of the Google Cloud IoT Device SDK for Embedded C.
+ * It is licensed under the BSD 3-Clause license; you may not use this file
+ * except in compliance with the License.
+ *
+ * You may obtain a copy of the License at:
+ *  https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "iotc_connect_scheduler.h"
+#include "iotc_bsp_rng.h"
+#include "iotc_config.h"
+#include "iotc_critical_section.h"
+#include "iotc_critical_section_def.h"
+#include "iotc_debug.h"
+#include "iotc_globals.h"
+#include "iotc_macros.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* contexts of every loop shard share the slots, the public functions lock,
+ * the static ones expect the lock to be held, without threads the lock
+ * macros expand to nothing */
+#ifdef IOTC_MODULE_THREAD_ENABLED
+static struct iotc_critical_section_s iotc_connect_scheduler_cs = {0};
+#endif
+
+static uint8_t iotc_connect_scheduler_has_free_slot_locked(void) {
+  const iotc_connect_scheduler_t* scheduler = &iotc_globals.connect_scheduler;
+
+  return (0 == scheduler->max_concurrent ||
+          scheduler->admitted_count < scheduler->max_concurrent)
+             ? 1
+             : 0;
+}
+
+static void iotc_connect_scheduler_enqueue_locked(
+    iotc_context_data_t* context_data) {
+  iotc_connect_scheduler_t* scheduler = &iotc_globals.connect_scheduler;
+
+  context_data->connect_admission.next_waiting = NULL;
+  context_data->connect_admission.state = IOTC_CONNECT_ADMISSION_WAITING;
+
+  if (NULL == scheduler->waiting_tail) {
+    scheduler->waiting_head = context_data;
+  } else {
+    scheduler->waiting_tail->connect_admission.next_waiting = context_data;
+  }
+
+  scheduler->waiting_tail = context_data;
+}
+
+static void iotc_connect_scheduler_remove_locked(
+    iotc_context_data_t* context_data) {
+  iotc_connect_scheduler_t* scheduler = &iotc_globals.connect_scheduler;
+  iotc_context_data_t* prev = NULL;
+  iotc_context_data_t* curr = scheduler->waiting_head;
+
+  while (NULL != curr && context_data != curr) {
+    prev = curr;
+    curr = curr->connect_admission.next_waiting;
+  }
+
+  if (NULL == curr) {
+    return;
+  }
+
+  if (NULL == prev) {
+    scheduler->waiting_head = curr->connect_admission.next_waiting;
+  } else {
+    prev->connect_admission.next_waiting = curr->connect_admission.next_waiting;
+  }
+
+  if (scheduler->waiting_tail == curr) {
+    scheduler->waiting_tail = prev;
+  }
+
+  curr->connect_admission.next_waiting = NULL;
+}
+
+/* takes a slot for the first waiting context, the caller starts its connect
+ * after leaving the critical section */
+static iotc_context_data_t* iotc_connect_scheduler_admit_next_locked(void) {
+  iotc_connect_scheduler_t* scheduler = &iotc_globals.connect_scheduler;
+  iotc_context_data_t* next = scheduler->waiting_head;
+
+  if (NULL == next || 0 == iotc_connect_scheduler_has_free_slot_locked()) {
+    return NULL;
+  }
+
+  iotc_connect_scheduler_remove_locked(next);
+
+  next->connect_admission.state = IOTC_CONNECT_ADMISSION_ADMITTED;
+  scheduler->admitted_count += 1;
+
+  return next;
+}
+
+static void iotc_connect_scheduler_release_locked(
+    iotc_context_data_t* context_data) {
+  if (IOTC_CONNECT_ADMISSION_ADMITTED == context_data->connect_admission.state) {
+    assert(0 < iotc_globals.connect_scheduler.admitted_count);
+    iotc_globals.connect_scheduler.admitted_count -= 1;
+  } else if (IOTC_CONNECT_ADMISSION_WAITING ==
+             context_data->connect_admission.state) {
+    iotc_connect_scheduler_remove_locked(context_data);
+  }
+
+  context_data->connect_admission.state = IOTC_CONNECT_ADMISSION_NONE;
+}
+
+static void iotc_connect_scheduler_start(iotc_context_data_t* context_data) {
+  if (NULL == context_data) {
+    return;
+  }
+
+  const iotc_state_t state = iotc_evtd_execute_in(
+      context_data->evtd_instance, context_data->connect_admission.init_handle,
+      0, &context_data->connect_handler);
+
+  if (IOTC_STATE_OK != state) {
+    iotc_debug_format("could not start an admitted connect, state: %d", state);
+  }
+}
+
+/**
+ * Decorrelated jitter: random( base, 3 * previous ) capped, the sleeps of the
+ * contexts spread out instead of growing in lockstep.
+ */
+static uint32_t iotc_connect_scheduler_next_jitter(uint32_t prev_jitter) {
+  const uint32_t base = IOTC_CONNECT_JITTER_BASE;
+  const uint32_t upper = IOTC_MAX(prev_jitter, base) * 3;
+
+  const uint32_t jitter = base + iotc_bsp_rng_get() % (upper - base + 1);
+
+  return IOTC_MIN(jitter, (uint32_t)IOTC_CONNECT_JITTER_CAP);
+}
+
+/* runs on the context's event dispatcher once the delay has passed */
+static iotc_state_t iotc_connect_scheduler_request(void* data) {
+  iotc_context_data_t* context_data = (iotc_context_data_t*)data;
+  iotc_context_data_t* admitted = NULL;
+
+  iotc_lock_critical_section(&iotc_connect_scheduler_cs);
+
+  iotc_connect_scheduler_enqueue_locked(context_data);
+
+  /* FIFO: the context is admitted only if nobody waits in front of it */
+  admitted = iotc_connect_scheduler_admit_next_locked();
+
+  iotc_unlock_critical_section(&iotc_connect_scheduler_cs);
+
+  if (NULL == admitted) {
+    iotc_debug_format("connect waits for admission, %d handshakes in progress",
+                      iotc_globals.connect_scheduler.admitted_count);
+  }
+
+  iotc_connect_scheduler_start(admitted);
+
+  return IOTC_STATE_OK;
+}
+
+iotc_state_t iotc_connect_scheduler_submit(iotc_context_data_t* context_data,
+                                           iotc_event_handle_t init_handle,
+                                           uint32_t delay) {
+  assert(NULL != context_data);
+
+  iotc_lock_critical_section(&iotc_connect_scheduler_cs);
+
+  iotc_connect_scheduler_release_locked(context_data);
+
+  if (0 < context_data->connect_admission.jitter) {
+    context_data->connect_admission.jitter =
+        iotc_connect_scheduler_next_jitter(
+            context_data->connect_admission.jitter);
+
+    delay = IOTC_MAX(delay, context_data->connect_admission.jitter);
+  }
+
+  context_data->connect_admission.init_handle = init_handle;
+
+  iotc_unlock_critical_section(&iotc_connect_scheduler_cs);
+
+  /* an undelayed connect is queued right away so that waiting for admission
+   * doesn't hold a slot of the dispatcher's timed events */
+  if (0 == delay) {
+    return iotc_connect_scheduler_request(context_data);
+  }
+
+  return iotc_evtd_execute_in(
+      context_data->evtd_instance,
+      iotc_make_handle(&iotc_connect_scheduler_request, context_data), delay,
+      &context_data->connect_handler);
+}
+
+uint8_t iotc_connect_scheduler_is_waiting(iotc_context_data_t* context_data) {
+  assert(NULL != context_data);
+
+  iotc_lock_critical_section(&iotc_connect_scheduler_cs);
+
+  const uint8_t is_waiting = (IOTC_CONNECT_ADMISSION_WAITING ==
+                              context_data->connect_admission.state)
+                                 ? 1
+                                 : 0;
+
+  iotc_unlock_critical_section(&iotc_connect_scheduler_cs);
+
+  return is_waiting;
+}
+
+void iotc_connect_scheduler_connection_state_changed(
+    iotc_context_data_t* context_data, iotc_state_t state) {
+  assert(NULL != context_data);
+
+  iotc_lock_critical_section(&iotc_connect_scheduler_cs);
+
+  iotc_connect_scheduler_release_locked(context_data);
+
+  /* only a session lost on an error makes the next connect jittered */
+  context_data->connect_admission.jitter =
+      (IOTC_STATE_OK == state)
+          ? 0
+          : IOTC_MAX(context_data->connect_admission.jitter,
+                     (uint32_t)IOTC_CONNECT_JITTER_BASE);
+
+  iotc_context_data_t* admitted = iotc_connect_scheduler_admit_next_locked();
+
+  iotc_unlock_critical_section(&iotc_connect_scheduler_cs);
+
+  iotc_connect_scheduler_start(admitted);
+}
+
+void iotc_connect_scheduler_cancel(iotc_context_data_t* context_data) {
+  assert(NULL != context_data);
+
+  iotc_lock_critical_section(&iotc_connect_scheduler_cs);
+
+  iotc_connect_scheduler_release_locked(context_data);
+
+  iotc_context_data_t* admitted = iotc_connect_scheduler_admit_next_locked();
+
+  iotc_unlock_critical_section(&iotc_connect_scheduler_cs);
+
+  iotc_connect_scheduler_start(admitted);
+}
+
+void iotc_connect_scheduler_set_max_concurrent(uint16_t max_concurrent) {
+  iotc_lock_critical_section(&iotc_connect_scheduler_cs);
+
+  iotc_globals.connect_scheduler.max_concurrent = max_concurrent;
+
+  iotc_context_data_t* admitted = NULL;
+  iotc_context_data_t* admitted_list = NULL;
+
+  /* a raised limit admits the waiting contexts right away */
+  while (NULL != (admitted = iotc_connect_scheduler_admit_next_locked())) {
+    admitted->connect_admission.next_waiting = admitted_list;
+    admitted_list = admitted;
+  }
+
+  iotc_unlock_critical_section(&iotc_connect_scheduler_cs);
+
+  while (NULL != admitted_list) {
+    admitted = admitted_list;
+    admitted_list = admitted->connect_admission.next_waiting;
+    admitted->connect_admission.next_waiting = NULL;
+
+    iotc_connect_scheduler_start(admitted);
+  }
+}
+
+uint16_t iotc_connect_scheduler_get_max_concurrent(void) {
+  return iotc_globals.connect_scheduler.max_concurrent;
+}
+
+#ifdef __cplusplus
+}
+#endif
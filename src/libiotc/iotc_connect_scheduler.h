@@ -0,0 +1,100 @@
+/* Copyright 2018-2020 Google LLC
+ *
+ * This is part of the Google Cloud IoT Device SDK for Embedded C.
+ * It is licensed under the BSD 3-Clause license; you may not use this file
+ * except in compliance with the License.
+ *
+ * You may obtain a copy of the License at:
+ *  https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __IOTC_CONNECT_SCHEDULER_H__
+#define __IOTC_CONNECT_SCHEDULER_H__
+
+#include <stdint.h>
+
+#include "iotc_event_handle.h"
+
+#include <iotc_error.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct iotc_context_data_s;
+
+/**
+ * Connect admission control.
+ *
+ * At most max_concurrent contexts may be between the start of the connect
+ * (DNS, TCP, TLS, MQTT CONNECT) and its outcome, the others wait in FIFO order
+ * and are admitted as soon as a slot is released. A context which lost its
+ * connection on an error waits a decorrelated jitter before reconnecting, so
+ * a fleet of contexts dropped at the same moment does not reconnect in lockstep.
+ */
+typedef enum iotc_connect_admission_state_e {
+  IOTC_CONNECT_ADMISSION_NONE = 0,
+  IOTC_CONNECT_ADMISSION_WAITING,
+  IOTC_CONNECT_ADMISSION_ADMITTED
+} iotc_connect_admission_state_t;
+
+/* per context part, embedded in iotc_context_data_t */
+typedef struct iotc_connect_admission_s {
+  struct iotc_context_data_s* next_waiting;
+  iotc_event_handle_t init_handle;
+  uint32_t jitter; /* last reconnect jitter, 0 if the last session ended well */
+  iotc_connect_admission_state_t state;
+} iotc_connect_admission_t;
+
+/* process wide part, kept in iotc_globals */
+typedef struct iotc_connect_scheduler_s {
+  struct iotc_context_data_s* waiting_head;
+  struct iotc_context_data_s* waiting_tail;
+  uint16_t admitted_count;
+  uint16_t max_concurrent; /* 0 means no limit */
+} iotc_connect_scheduler_t;
+
+/**
+ * @brief schedules the init handle on the context's event dispatcher after
+ * the delay (plus the reconnect jitter), or queues it until a slot is free
+ */
+extern iotc_state_t iotc_connect_scheduler_submit(
+    struct iotc_context_data_s* context_data, iotc_event_handle_t init_handle,
+    uint32_t delay);
+
+/**
+ * @brief returns 1 if the context has a connect waiting for admission
+ */
+extern uint8_t iotc_connect_scheduler_is_waiting(
+    struct iotc_context_data_s* context_data);
+
+/**
+ * @brief reports the outcome of an admitted connect or the end of a session,
+ * releases the context's slot and admits the next waiting context, the layer
+ * api calls it when a connect or close_externally reaches the top layer
+ */
+extern void iotc_connect_scheduler_connection_state_changed(
+    struct iotc_context_data_s* context_data, iotc_state_t state);
+
+/**
+ * @brief removes the context from the queue or releases its slot, used when
+ * the connect is cancelled before it started and on context deletion
+ */
+extern void iotc_connect_scheduler_cancel(
+    struct iotc_context_data_s* context_data);
+
+extern void iotc_connect_scheduler_set_max_concurrent(uint16_t max_concurrent);
+
+extern uint16_t iotc_connect_scheduler_get_max_concurrent(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __IOTC_CONNECT_SCHEDULER_H__ */
@@ -0,0 +1,80 @@
+/* Copyright 2018-2020 Google LLC
+ *
+ * This is part of the Google Cloud IoT Device SDK for Embedded C.
+ * It is licensed under the BSD 3-Clause license; you may not use this file
+ * except in compliance with the License.
+ *
+ * You may obtain a copy of the License at:
+ *  https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __IOTC_CONTEXT_STATS_H__
+#define __IOTC_CONTEXT_STATS_H__
+
+#include <stdint.h>
+
+#include <iotc_types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Runtime statistics of a context.
+ *
+ * The counters are embedded in iotc_context_data_t and bumped in place by
+ * the io net, TLS, MQTT codec and MQTT logic layers through the macros
+ * below, which compile to nothing with IOTC_NO_CONTEXT_STATS. The queue
+ * depths are not counted, iotc_get_context_stats walks the queues instead.
+ */
+#ifndef IOTC_NO_CONTEXT_STATS
+
+typedef struct iotc_context_stats_data_s {
+  iotc_context_stats_t counters;
+  /* survives the resets so that the reconnects stay reconnects */
+  uint8_t connected_before;
+} iotc_context_stats_data_t;
+
+static inline void iotc_context_stats_connected(
+    iotc_context_stats_data_t* stats) {
+  ++stats->counters.connects;
+
+  if (1 == stats->connected_before) {
+    ++stats->counters.reconnects;
+  }
+
+  stats->connected_before = 1;
+}
+
+#define IOTC_CONTEXT_STATS_ADD(context_data, counter, value) \
+  ((context_data)->stats.counters.counter += (value))
+
+#define IOTC_CONTEXT_STATS_INC(context_data, counter) \
+  IOTC_CONTEXT_STATS_ADD(context_data, counter, 1)
+
+#define IOTC_CONTEXT_STATS_SET(context_data, counter, value) \
+  ((context_data)->stats.counters.counter = (value))
+
+#define IOTC_CONTEXT_STATS_CONNECTED(context_data) \
+  iotc_context_stats_connected(&(context_data)->stats)
+
+#else /* IOTC_NO_CONTEXT_STATS */
+
+#define IOTC_CONTEXT_STATS_ADD(context_data, counter, value)
+#define IOTC_CONTEXT_STATS_INC(context_data, counter)
+#define IOTC_CONTEXT_STATS_SET(context_data, counter, value)
+#define IOTC_CONTEXT_STATS_CONNECTED(context_data)
+
+#endif /* IOTC_NO_CONTEXT_STATS */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __IOTC_CONTEXT_STATS_H__ */
@@ -0,0 +1,81 @@
+/* Copyright 2018-2020 Google LLC
+ *
+ * This is part of the Google Cloud IoT Device SDK for Embedded C.
+ * It is licensed under the BSD 3-Clause license; you may not use this file
+ * except in compliance with the License.
+ *
+ * You may obtain a copy of the License at:
+ *  https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+#include "iotc_data_desc.h"
+
+namespace iotctest {
+namespace {
+
+constexpr size_t kChunkSize = 16;
+
+// Appends into a buffer that is big enough from the start.
+void BM_DataDescAppendBytes(benchmark::State& state) {
+  const size_t total = state.range(0);
+  const std::vector<uint8_t> chunk(kChunkSize, 'x');
+
+  iotc_data_desc_t* desc = iotc_make_empty_desc_alloc(total);
+
+  for (auto _ : state) {
+    desc->length = 0;
+    for (size_t written = 0; written < total; written += kChunkSize) {
+      iotc_data_desc_append_bytes(desc, chunk.data(), kChunkSize);
+    }
+    benchmark::DoNotOptimize(desc->data_ptr);
+  }
+
+  state.SetBytesProcessed(state.iterations() * total);
+  iotc_free_desc(&desc);
+}
+BENCHMARK(BM_DataDescAppendBytes)->Arg(256)->Arg(4096);
+
+// Grows the buffer from a single chunk, every growth goes through the pow2
+// realloc strategy.
+void BM_DataDescAppendDataResize(benchmark::State& state) {
+  const size_t total = state.range(0);
+  const std::vector<char> chunk(kChunkSize, 'x');
+
+  for (auto _ : state) {
+    iotc_data_desc_t* desc = iotc_make_empty_desc_alloc(kChunkSize);
+    for (size_t written = 0; written < total; written += kChunkSize) {
+      iotc_data_desc_append_data_resize(desc, chunk.data(), kChunkSize);
+    }
+    benchmark::DoNotOptimize(desc->data_ptr);
+    iotc_free_desc(&desc);
+  }
+
+  state.SetBytesProcessed(state.iterations() * total);
+}
+BENCHMARK(BM_DataDescAppendDataResize)->Arg(256)->Arg(4096);
+
+void BM_DataDescRealloc(benchmark::State& state) {
+  const uint32_t capacity = state.range(0);
+
+  for (auto _ : state) {
+    iotc_data_desc_t* desc = iotc_make_empty_desc_alloc(kChunkSize);
+    iotc_data_desc_realloc(desc, capacity,
+                           &iotc_data_desc_pow2_realloc_strategy);
+    benchmark::DoNotOptimize(desc->data_ptr);
+    iotc_free_desc(&desc);
+  }
+}
+BENCHMARK(BM_DataDescRealloc)->Arg(256)->Arg(4096);
+
+}  // namespace
+}  // namespace iotctest
@@ -27,6 +27,10 @@
 #include "iotc_data_desc.h"
 #include <stdio.h>
 
+#ifdef IOTC_DEBUG_BINARY_LOG
+#include "iotc_debug_log.h"
+#endif
+
 #ifdef IOTC_PLATFORM_BASE_WMSDK
 #include <wm_os.h>
 #endif
@@ -48,6 +52,34 @@ const char* iotc_debug_dont_print_the_path(const char* msg);
 void iotc_debug_data_logger_impl(const char* msg,
                                  const iotc_data_desc_t* data_desc);
 
+#ifdef IOTC_DEBUG_BINARY_LOG
+/* The statements only store a reference to their call site and the raw
+ * arguments, the text is formatted later by iotc_drain_debug_log(). */
+#define IOTC_DEBUG_LOG_FORMAT(format, ...) format
+#define IOTC_DEBUG_LOG_RECORD(level, raw, ...)                     \
+  do {                                                             \
+    static iotc_debug_log_site_t iotc_debug_log_site = {           \
+        IOTC_DEBUG_LOG_FORMAT(__VA_ARGS__, 0), __FILE__, __func__, \
+        __LINE__, (level), (raw), 0};                              \
+    if ((level) <= iotc_debug_log_max_level) {                     \
+      iotc_debug_log_write(&iotc_debug_log_site, __VA_ARGS__);     \
+    }                                                              \
+  } while (0)
+
+#define iotc_debug_logger(msg) \
+  IOTC_DEBUG_LOG_RECORD(IOTC_DEBUG_LOG_LEVEL_DEBUG, 0, "%s", msg)
+#define iotc_debug_format(...) \
+  IOTC_DEBUG_LOG_RECORD(IOTC_DEBUG_LOG_LEVEL_DEBUG, 0, __VA_ARGS__)
+#define iotc_debug_printf(...) \
+  IOTC_DEBUG_LOG_RECORD(IOTC_DEBUG_LOG_LEVEL_TRACE, 1, __VA_ARGS__)
+#define iotc_debug_function_entered() \
+  IOTC_DEBUG_LOG_RECORD(IOTC_DEBUG_LOG_LEVEL_TRACE, 0, "-> entered")
+#define iotc_debug_data_logger(msg, dsc)                                   \
+  IOTC_DEBUG_LOG_RECORD(IOTC_DEBUG_LOG_LEVEL_TRACE, 0, "%s = [%.*s]", msg, \
+                        (int)(dsc)->length, (const char*)(dsc)->data_ptr)
+#define iotc_debug_is_enabled(level, modules) \
+  iotc_debug_log_is_enabled(level, modules)
+#else /* IOTC_DEBUG_BINARY_LOG */
 #define iotc_debug_logger(msg)                                               \
   __iotc_printf(                                                             \
       "[%lld][%s:%d (%s)] %s\n", iotc_bsp_time_getcurrenttime_milliseconds(), \
@@ -67,12 +99,15 @@ void iotc_debug_data_logger_impl(const char* msg,
                 iotc_bsp_time_getcurrenttime_milliseconds(),                   \
                 iotc_debug_dont_print_the_path(__FILE__), __LINE__, __func__); \
   iotc_debug_data_logger_impl(msg, dsc)
+#define iotc_debug_is_enabled(level, modules) 1
+#endif /* IOTC_DEBUG_BINARY_LOG */
 #else /* IOTC_DEBUG_OUTPUT */
 #define iotc_debug_logger(...)
 #define iotc_debug_format(...)
 #define iotc_debug_printf(...)
 #define iotc_debug_function_entered()
 #define iotc_debug_data_logger(...)
+#define iotc_debug_is_enabled(level, modules) 0
 #endif /* IOTC_DEBUG_OUTPUT */
 
 #define IOTC_LAYER_FUNCTION_PRINT_FUNCTION_DIGEST()
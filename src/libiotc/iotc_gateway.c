@@ -0,0 +1,219 @@
+/* Copyright 2018-2020 Google LLC
+ *
+ * This is part of the Google Cloud IoT Device SDK for Embedded C.
+ * It is licensed under the BSD 3-Clause license; you may not use this file
+ * except in compliance with the License.
+ *
+ * You may obtain a copy of the License at:
+ *  https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "iotc_gateway.h"
+#include "iotc.h"
+#include "iotc_debug.h"
+#include "iotc_globals.h"
+#include "iotc_handle.h"
+#include "iotc_helpers.h"
+#include "iotc_macros.h"
+#include "iotc_mqtt_logic_layer.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define IOTC_GATEWAY_TOPIC_FORMAT "/devices/%s/%s"
+#define IOTC_GATEWAY_ATTACH_PAYLOAD_FORMAT "{\"authorization\":\"%s\"}"
+
+static const char iotc_gateway_detach_subtopic[] = "detach";
+
+static uint8_t iotc_gateway_is_valid_device_id(const char* device_id) {
+  if (NULL == device_id) {
+    return 0;
+  }
+
+  const size_t device_id_len = strlen(device_id);
+
+  if (0 == device_id_len || IOTC_GATEWAY_DEVICE_ID_MAX_LEN < device_id_len) {
+    return 0;
+  }
+
+  /* the id becomes a topic level, it can neither split it nor be a wildcard */
+  return (NULL == strpbrk(device_id, "/+#")) ? 1 : 0;
+}
+
+/**
+ * Allocates /devices/<device_id>/<subtopic>, the caller frees the topic.
+ */
+static iotc_state_t iotc_gateway_make_topic(char** topic, const char* device_id,
+                                            const char* subtopic) {
+  assert(NULL != topic);
+  assert(NULL == *topic);
+
+  if (0 == iotc_gateway_is_valid_device_id(device_id) || NULL == subtopic ||
+      '\0' == subtopic[0]) {
+    return IOTC_INVALID_PARAMETER;
+  }
+
+  iotc_state_t state = IOTC_STATE_OK;
+
+  /* sizeof counts the terminating zero but also the two "%s" */
+  const size_t topic_size = sizeof(IOTC_GATEWAY_TOPIC_FORMAT) - 4 +
+                            strlen(device_id) + strlen(subtopic);
+
+  IOTC_ALLOC_BUFFER_AT(char, *topic, topic_size, state);
+
+  snprintf(*topic, topic_size, IOTC_GATEWAY_TOPIC_FORMAT, device_id, subtopic);
+
+err_handling:
+  return state;
+}
+
+/**
+ * Schedules the removal of the subscription handlers of the device's topics,
+ * the layer chain is only touched from the event dispatcher.
+ */
+static iotc_state_t iotc_gateway_unregister_device_handlers(
+    iotc_context_handle_t iotc_h, const char* detach_topic) {
+  iotc_state_t state = IOTC_STATE_OK;
+  char* topic_prefix = NULL;
+
+  iotc_context_t* iotc = (iotc_context_t*)iotc_object_for_handle(
+      iotc_globals.context_handles, iotc_h);
+
+  IOTC_CHECK_CND_DBGMESSAGE(NULL == iotc, IOTC_INVALID_PARAMETER, state,
+                            "no context for the handle");
+
+  iotc_layer_t* logic_layer = iotc_mqtt_logic_layer_find(&iotc->layer_chain);
+
+  if (NULL == logic_layer) {
+    return IOTC_STATE_OK;
+  }
+
+  /* /devices/<device_id>/ */
+  IOTC_CHECK_MEMORY(topic_prefix = iotc_str_dup(detach_topic), state);
+  topic_prefix[strlen(topic_prefix) -
+               (sizeof(iotc_gateway_detach_subtopic) - 1)] = '\0';
+
+  IOTC_CHECK_MEMORY(
+      iotc_evtd_execute(
+          iotc->context_data.evtd_instance,
+          iotc_make_handle(&iotc_mqtt_logic_layer_unregister_topic_handlers,
+                           &logic_layer->layer_connection, topic_prefix)),
+      state);
+
+  return IOTC_STATE_OK;
+
+err_handling:
+  IOTC_SAFE_FREE(topic_prefix);
+  return state;
+}
+
+iotc_state_t iotc_gateway_attach_device(iotc_context_handle_t iotc_h,
+                                        const char* device_id,
+                                        const char* device_jwt,
+                                        iotc_user_callback_t* callback,
+                                        void* user_data) {
+  if (IOTC_INVALID_CONTEXT_HANDLE >= iotc_h) {
+    return IOTC_INVALID_PARAMETER;
+  }
+
+  iotc_state_t state = IOTC_STATE_OK;
+  char* topic = NULL;
+  char* payload = NULL;
+
+  IOTC_CHECK_STATE(state = iotc_gateway_make_topic(&topic, device_id, "attach"));
+
+  if (NULL == device_jwt) {
+    /* the broker rejects an attach message without a payload */
+    IOTC_CHECK_MEMORY(payload = iotc_str_dup("{}"), state);
+  } else {
+    /* sizeof counts the terminating zero but also the "%s" */
+    const size_t payload_size =
+        sizeof(IOTC_GATEWAY_ATTACH_PAYLOAD_FORMAT) - 2 + strlen(device_jwt);
+
+    IOTC_ALLOC_BUFFER_AT(char, payload, payload_size, state);
+
+    snprintf(payload, payload_size, IOTC_GATEWAY_ATTACH_PAYLOAD_FORMAT,
+             device_jwt);
+  }
+
+  state = iotc_publish(iotc_h, topic, payload, IOTC_MQTT_QOS_AT_LEAST_ONCE,
+                       callback, user_data);
+
+err_handling:
+  IOTC_SAFE_FREE(payload);
+  IOTC_SAFE_FREE(topic);
+  return state;
+}
+
+iotc_state_t iotc_gateway_detach_device(iotc_context_handle_t iotc_h,
+                                        const char* device_id,
+                                        iotc_user_callback_t* callback,
+                                        void* user_data) {
+  if (IOTC_INVALID_CONTEXT_HANDLE >= iotc_h) {
+    return IOTC_INVALID_PARAMETER;
+  }
+
+  iotc_state_t state = IOTC_STATE_OK;
+  char* topic = NULL;
+
+  IOTC_CHECK_STATE(state = iotc_gateway_make_topic(
+                       &topic, device_id, iotc_gateway_detach_subtopic));
+
+  IOTC_CHECK_STATE(state = iotc_publish(iotc_h, topic, "{}",
+                                        IOTC_MQTT_QOS_AT_LEAST_ONCE, callback,
+                                        user_data));
+
+  state = iotc_gateway_unregister_device_handlers(iotc_h, topic);
+
+err_handling:
+  IOTC_SAFE_FREE(topic);
+  return state;
+}
+
+iotc_state_t iotc_gateway_publish(iotc_context_handle_t iotc_h,
+                                  const char* device_id, const char* subtopic,
+                                  const uint8_t* data, size_t data_len,
+                                  const iotc_mqtt_qos_t qos,
+                                  iotc_user_callback_t* callback,
+                                  void* user_data) {
+  if (IOTC_INVALID_CONTEXT_HANDLE >= iotc_h || NULL == data || 0 == data_len) {
+    return IOTC_INVALID_PARAMETER;
+  }
+
+  iotc_state_t state = IOTC_STATE_OK;
+  char* topic = NULL;
+
+  IOTC_CHECK_STATE(state = iotc_gateway_make_topic(&topic, device_id, subtopic));
+
+  state = iotc_publish_data(iotc_h, topic, data, data_len, qos, callback,
+                            user_data);
+
+err_handling:
+  IOTC_SAFE_FREE(topic);
+  return state;
+}
+
+iotc_state_t iotc_gateway_subscribe(iotc_context_handle_t iotc_h,
+                                    const char* device_id, const char* subtopic,
+                                    const iotc_mqtt_qos_t qos,
+                                    iotc_user_subscription_callback_t* callback,
+                                    void* user_data) {
+  iotc_state_t state = IOTC_STATE_OK;
+  char* topic = NULL;
+
+  IOTC_CHECK_STATE(state = iotc_gateway_make_topic(&topic, device_id, subtopic));
+
+  /* the logic layer keeps a handler per topic, messages for the device are
+   * routed to this callback only */
+  state = iotc_subscribe(iotc_h, topic, qos, callback, user_data);
+
+err_handling:
+  IOTC_SAFE_FREE(topic);
+  return state;
+}
@@ -15,6 +15,7 @@
  */
 
 #include "iotc_globals.h"
+#include "iotc_config.h"
 
 iotc_globals_t iotc_globals = {
     .network_timeout = 1500,
@@ -22,8 +23,10 @@ iotc_globals_t iotc_globals = {
     .evtd_instance = NULL,
     .default_context = NULL,
     .default_context_handle = IOTC_INVALID_CONTEXT_HANDLE,
-    .context_handles_vector = NULL,
+    .context_handles = NULL,
     .timed_tasks_container = NULL,
     .main_threadpool = NULL,
     .backoff_status = {iotc_make_empty_time_event_handle(), 0, 0,
-                       IOTC_BACKOFF_CLASS_NONE, 0}};
+                       IOTC_BACKOFF_CLASS_NONE, 0},
+    .connect_scheduler = {NULL, NULL, 0, IOTC_MAX_CONCURRENT_CONNECTS},
+    .dns_server = {"", 0}};
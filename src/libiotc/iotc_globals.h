@@ -20,6 +20,9 @@
 #include <stdint.h>
 
 #include "iotc_backoff_status_api.h"
+#include "iotc_connect_scheduler.h"
+#include "iotc_dns_resolver.h"
+#include "iotc_handle.h"
 #include "iotc_timed_task.h"
 #include "iotc_types_internal.h"
 
@@ -32,14 +35,16 @@ extern "C" {
 /* This struct is used for run-time config */
 typedef struct {
   uint32_t network_timeout;
-  uint8_t globals_ref_count;
+  uint32_t globals_ref_count; /* one per context, see IOTC_MAX_NUM_CONTEXTS */
   iotc_evtd_instance_t* evtd_instance;
   iotc_context_t* default_context;
   iotc_context_handle_t default_context_handle;
-  iotc_vector_t* context_handles_vector;
+  iotc_handle_table_t* context_handles;
   iotc_timed_task_container_t* timed_tasks_container;
   struct iotc_threadpool_s* main_threadpool;
   iotc_backoff_status_t backoff_status;
+  iotc_connect_scheduler_t connect_scheduler;
+  iotc_dns_server_t dns_server;
 } iotc_globals_t;
 
 extern iotc_globals_t iotc_globals;
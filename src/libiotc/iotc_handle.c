@@ -14,72 +14,281 @@
  * limitations under the License.
  */
 
+#include <string.h>
+
+#include "iotc_allocator.h"
+#include "iotc_critical_section.h"
+#include "iotc_critical_section_def.h"
+#include "iotc_debug.h"
 #include "iotc_handle.h"
+#include "iotc_macros.h"
 #include "iotc_types.h"
 
+/* contexts are looked up from the application thread and from every loop
+ * shard, growing the table reallocates the slots under a concurrent lookup */
+static struct iotc_critical_section_s iotc_handle_cs = {0};
+
+#define IOTC_HANDLE_TABLE_NO_SLOT IOTC_HANDLE_INDEX_MASK
+#define IOTC_HANDLE_TABLE_MIN_SLOTS 4
+
 /* -----------------------------------------------------------------------
  *  INTERNAL FUNCTIONS
  * ----------------------------------------------------------------------- */
 
-static inline int8_t iotc_compare_context_pointers(
-    const union iotc_vector_selector_u* e0,
-    const union iotc_vector_selector_u* e1) {
-  return e0->ptr_value == e1->ptr_value ? 0 : 1;
+static inline uint32_t iotc_handle_table_hash(const iotc_handle_table_t* table,
+                                              const void* object) {
+  /* the low bits of a pointer are alignment, multiplicative hashing mixes
+   * the rest */
+  const uint32_t hash = (uint32_t)((uintptr_t)object >> 3) * 2654435761u;
+
+  return hash & (table->index_size - 1);
+}
+
+static inline iotc_handle_t iotc_handle_table_make_handle(
+    const iotc_handle_table_t* table, const uint16_t slot) {
+  return ((iotc_handle_t)table->slots[slot].generation
+          << IOTC_HANDLE_INDEX_BITS) |
+         slot;
+}
+
+/* returns the index position holding the object, or the empty position where
+ * the probe ended */
+static uint32_t iotc_handle_table_probe(const iotc_handle_table_t* table,
+                                        const void* object) {
+  uint32_t position = iotc_handle_table_hash(table, object);
+
+  while (0 != table->index[position] &&
+         table->slots[table->index[position] - 1].object != object) {
+    position = (position + 1) & (table->index_size - 1);
+  }
+
+  return position;
+}
+
+static void iotc_handle_table_index_insert(iotc_handle_table_t* table,
+                                           const uint16_t slot) {
+  uint32_t position =
+      iotc_handle_table_hash(table, table->slots[slot].object);
+
+  /* the same object may be registered more than once, it gets a new entry */
+  while (0 != table->index[position]) {
+    position = (position + 1) & (table->index_size - 1);
+  }
+
+  table->index[position] = slot + 1;
+}
+
+static void iotc_handle_table_index_remove(iotc_handle_table_t* table,
+                                           uint32_t position) {
+  const uint32_t mask = table->index_size - 1;
+  uint32_t next = (position + 1) & mask;
+
+  /* backward shift deletion keeps every probe sequence unbroken without
+   * tombstones */
+  while (0 != table->index[next]) {
+    const uint32_t home = iotc_handle_table_hash(
+        table, table->slots[table->index[next] - 1].object);
+
+    if (((next - home) & mask) >= ((next - position) & mask)) {
+      table->index[position] = table->index[next];
+      position = next;
+    }
+
+    next = (next + 1) & mask;
+  }
+
+  table->index[position] = 0;
+}
+
+static iotc_state_t iotc_handle_table_grow(iotc_handle_table_t* table) {
+  iotc_state_t state = IOTC_STATE_OK;
+
+  const uint16_t new_slots_no = IOTC_MIN(
+      IOTC_MAX(table->slots_no * 2, IOTC_HANDLE_TABLE_MIN_SLOTS),
+      table->capacity);
+
+  /* at most half of the index is used */
+  uint32_t new_index_size = 1;
+  while (new_index_size < 2 * (uint32_t)new_slots_no) {
+    new_index_size <<= 1;
+  }
+
+  IOTC_ALLOC_BUFFER(iotc_handle_slot_t, new_slots,
+                    new_slots_no * sizeof(iotc_handle_slot_t), state);
+  IOTC_ALLOC_BUFFER(uint16_t, new_index, new_index_size * sizeof(uint16_t),
+                    state);
+
+  if (NULL != table->slots) {
+    memcpy(new_slots, table->slots,
+           table->slots_no * sizeof(iotc_handle_slot_t));
+  }
+
+  IOTC_SAFE_FREE(table->slots);
+  IOTC_SAFE_FREE(table->index);
+
+  table->slots = new_slots;
+  table->slots_no = new_slots_no;
+  table->index = new_index;
+  table->index_size = new_index_size;
+
+  uint16_t slot = 0;
+  for (; slot < table->used_slots_no; ++slot) {
+    if (NULL != table->slots[slot].object) {
+      iotc_handle_table_index_insert(table, slot);
+    }
+  }
+
+  return IOTC_STATE_OK;
+
+err_handling:
+  IOTC_SAFE_FREE(new_slots);
+  return state;
 }
 
 /* -----------------------------------------------------------------------
  *  MAIN LIBRARY FUNCTIONS
  * ----------------------------------------------------------------------- */
 
-void* iotc_object_for_handle(iotc_vector_t* vector, iotc_handle_t handle) {
-  assert(vector != NULL);
-  return iotc_vector_get(vector, handle);
+iotc_handle_table_t* iotc_handle_table_create(const uint16_t capacity) {
+  iotc_state_t state = IOTC_STATE_OK;
+
+  IOTC_ALLOC(iotc_handle_table_t, table, state);
+
+  table->capacity =
+      IOTC_MIN(IOTC_MAX(capacity, 1), IOTC_HANDLE_TABLE_MAX_CAPACITY);
+  table->free_head = IOTC_HANDLE_TABLE_NO_SLOT;
+
+  return table;
+
+err_handling:
+  return NULL;
+}
+
+void iotc_handle_table_destroy(iotc_handle_table_t* table) {
+  if (NULL == table) {
+    return;
+  }
+
+  IOTC_SAFE_FREE(table->slots);
+  IOTC_SAFE_FREE(table->index);
+  IOTC_SAFE_FREE(table);
 }
 
-iotc_state_t iotc_find_handle_for_object(iotc_vector_t* vector,
+void* iotc_object_for_handle(iotc_handle_table_t* table, iotc_handle_t handle) {
+  assert(table != NULL);
+
+  /* just to satisfy the compiler */
+  (void)iotc_handle_cs;
+
+  if (0 > handle) {
+    return NULL;
+  }
+
+  const uint16_t slot = IOTC_HANDLE_INDEX(handle);
+  const uint16_t generation =
+      (handle >> IOTC_HANDLE_INDEX_BITS) & IOTC_HANDLE_GENERATION_MASK;
+  void* object = NULL;
+
+  iotc_lock_critical_section(&iotc_handle_cs);
+  if (slot < table->used_slots_no &&
+      generation == table->slots[slot].generation) {
+    object = table->slots[slot].object;
+  }
+  iotc_unlock_critical_section(&iotc_handle_cs);
+
+  return object;
+}
+
+iotc_state_t iotc_find_handle_for_object(iotc_handle_table_t* table,
                                          const void* object,
                                          iotc_handle_t* handle) {
-  assert(vector != NULL);
-  iotc_vector_index_type_t handler_index = iotc_vector_find(
-      vector, IOTC_VEC_CONST_VALUE_PARAM(IOTC_VEC_VALUE_PTR((void*)object)),
-      iotc_compare_context_pointers);
-  if (handler_index < 0) {
-    *handle = IOTC_INVALID_CONTEXT_HANDLE;
+  assert(table != NULL);
+  assert(handle != NULL);
+
+  *handle = IOTC_INVALID_CONTEXT_HANDLE;
+
+  if (NULL == object) {
     return IOTC_ELEMENT_NOT_FOUND;
   }
-  *handle = handler_index;
-  return IOTC_STATE_OK;
+
+  iotc_lock_critical_section(&iotc_handle_cs);
+  if (0 < table->index_size) {
+    const uint32_t position = iotc_handle_table_probe(table, object);
+
+    if (0 != table->index[position]) {
+      *handle =
+          iotc_handle_table_make_handle(table, table->index[position] - 1);
+    }
+  }
+  iotc_unlock_critical_section(&iotc_handle_cs);
+
+  return (IOTC_INVALID_CONTEXT_HANDLE == *handle) ? IOTC_ELEMENT_NOT_FOUND
+                                                  : IOTC_STATE_OK;
 }
 
-iotc_state_t iotc_delete_handle_for_object(iotc_vector_t* vector,
+iotc_state_t iotc_delete_handle_for_object(iotc_handle_table_t* table,
                                            const void* object) {
-  assert(vector != NULL);
-  iotc_vector_index_type_t handler_index = iotc_vector_find(
-      vector, IOTC_VEC_CONST_VALUE_PARAM(IOTC_VEC_VALUE_PTR((void*)object)),
-      iotc_compare_context_pointers);
+  assert(table != NULL);
 
-  if (handler_index < 0) {
-    return IOTC_ELEMENT_NOT_FOUND;
+  iotc_state_t state = IOTC_ELEMENT_NOT_FOUND;
+
+  if (NULL == object) {
+    return state;
   }
-  vector->array[handler_index].selector_t.ptr_value = NULL;
-  return IOTC_STATE_OK;
+
+  iotc_lock_critical_section(&iotc_handle_cs);
+  if (0 < table->index_size) {
+    const uint32_t position = iotc_handle_table_probe(table, object);
+
+    if (0 != table->index[position]) {
+      const uint16_t slot = table->index[position] - 1;
+
+      iotc_handle_table_index_remove(table, position);
+
+      table->slots[slot].object = NULL;
+      table->slots[slot].generation =
+          (table->slots[slot].generation + 1) & IOTC_HANDLE_GENERATION_MASK;
+      table->slots[slot].next_free = table->free_head;
+      table->free_head = slot;
+
+      state = IOTC_STATE_OK;
+    }
+  }
+  iotc_unlock_critical_section(&iotc_handle_cs);
+
+  return state;
 }
 
-iotc_state_t iotc_register_handle_for_object(iotc_vector_t* vector,
-                                             const int32_t max_object_cnt,
-                                             const void* object) {
-  assert(vector != NULL);
-  iotc_vector_index_type_t handler_index = iotc_vector_find(
-      vector, IOTC_VEC_CONST_VALUE_PARAM(IOTC_VEC_VALUE_PTR(NULL)),
-      iotc_compare_context_pointers);
-  if (handler_index < 0) {
-    if (vector->elem_no >= max_object_cnt) {
-      return IOTC_NO_MORE_RESOURCE_AVAILABLE;
+iotc_state_t iotc_register_handle_for_object(iotc_handle_table_t* table,
+                                             const void* object,
+                                             iotc_handle_t* handle) {
+  assert(table != NULL);
+  assert(object != NULL);
+
+  iotc_state_t state = IOTC_STATE_OK;
+  uint16_t slot = IOTC_HANDLE_TABLE_NO_SLOT;
+
+  iotc_lock_critical_section(&iotc_handle_cs);
+  if (IOTC_HANDLE_TABLE_NO_SLOT != table->free_head) {
+    slot = table->free_head;
+    table->free_head = table->slots[slot].next_free;
+  } else if (table->used_slots_no >= table->capacity) {
+    state = IOTC_NO_MORE_RESOURCE_AVAILABLE;
+  } else if (table->used_slots_no < table->slots_no ||
+             IOTC_STATE_OK == (state = iotc_handle_table_grow(table))) {
+    slot = table->used_slots_no++;
+  }
+
+  if (IOTC_HANDLE_TABLE_NO_SLOT != slot) {
+    table->slots[slot].object = (void*)object;
+    table->slots[slot].next_free = IOTC_HANDLE_TABLE_NO_SLOT;
+    iotc_handle_table_index_insert(table, slot);
+
+    if (NULL != handle) {
+      *handle = iotc_handle_table_make_handle(table, slot);
     }
-    iotc_vector_push(
-        vector, IOTC_VEC_CONST_VALUE_PARAM(IOTC_VEC_VALUE_PTR((void*)object)));
-  } else {
-    vector->array[handler_index].selector_t.ptr_value = (void*)object;
   }
-  return IOTC_STATE_OK;
+  iotc_unlock_critical_section(&iotc_handle_cs);
+
+  return state;
 }
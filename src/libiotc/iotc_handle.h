@@ -17,8 +17,9 @@
 #ifndef __IOTC_HANDLE_H__
 #define __IOTC_HANDLE_H__
 
-#include "iotc_handle.h"
-#include "iotc_vector.h"
+#include <stdint.h>
+
+#include <iotc_error.h>
 
 /*-----------------------------------------------------------------------
  *  TYPEDEFS
@@ -26,18 +27,57 @@
 
 typedef int32_t iotc_handle_t;
 
+/* A handle is the slot index in the low bits and the generation of the slot
+ * in the high bits. Deleting an object bumps the generation of its slot so a
+ * stale handle never resolves to the object reusing that slot. */
+#define IOTC_HANDLE_INDEX_BITS 16
+#define IOTC_HANDLE_INDEX_MASK ((1 << IOTC_HANDLE_INDEX_BITS) - 1)
+#define IOTC_HANDLE_GENERATION_MASK 0x7FFF
+
+/* the highest index value marks the end of the free list */
+#define IOTC_HANDLE_TABLE_MAX_CAPACITY (IOTC_HANDLE_INDEX_MASK - 1)
+
+/* slot index of a valid handle, always below the capacity of its table */
+#define IOTC_HANDLE_INDEX(handle) ((handle)&IOTC_HANDLE_INDEX_MASK)
+
+typedef struct iotc_handle_slot_s {
+  void* object;
+  uint16_t generation;
+  uint16_t next_free;
+} iotc_handle_slot_t;
+
+/**
+ * @struct iotc_handle_table_t
+ * @brief Slot map from handles to objects, with an object to slot index.
+ *
+ * Register, lookup and delete are O(1). Slots are allocated on demand, up to
+ * the capacity given at creation.
+ */
+typedef struct iotc_handle_table_s {
+  iotc_handle_slot_t* slots;
+  uint16_t* index; /* object hash -> slot + 1, open addressing */
+  uint32_t index_size;
+  uint16_t slots_no;
+  uint16_t used_slots_no;
+  uint16_t free_head;
+  uint16_t capacity;
+} iotc_handle_table_t;
+
 /*-----------------------------------------------------------------------
  *  PUBLIC FUNCTIONS
  * ----------------------------------------------------------------------- */
 
-void* iotc_object_for_handle(iotc_vector_t* vector, iotc_handle_t handle);
-iotc_state_t iotc_find_handle_for_object(iotc_vector_t* vector,
+iotc_handle_table_t* iotc_handle_table_create(const uint16_t capacity);
+void iotc_handle_table_destroy(iotc_handle_table_t* table);
+
+void* iotc_object_for_handle(iotc_handle_table_t* table, iotc_handle_t handle);
+iotc_state_t iotc_find_handle_for_object(iotc_handle_table_t* table,
                                          const void* object,
                                          iotc_handle_t* handle);
-iotc_state_t iotc_delete_handle_for_object(iotc_vector_t* vector,
+iotc_state_t iotc_delete_handle_for_object(iotc_handle_table_t* table,
                                            const void* object);
-iotc_state_t iotc_register_handle_for_object(iotc_vector_t* vector,
-                                             const int32_t max_object_cnt,
-                                             const void* object);
+iotc_state_t iotc_register_handle_for_object(iotc_handle_table_t* table,
+                                             const void* object,
+                                             iotc_handle_t* handle);
 
 #endif /* __IOTC_HANDLE_H__ */
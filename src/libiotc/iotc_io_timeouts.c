@@ -71,31 +71,38 @@ void iotc_io_timeouts_cancel(iotc_evtd_instance_t* event_dispatcher,
 }
 
 /**
- * @brief iotc_io_timeouts_restart
+ * @brief iotc_io_timeouts_postpone
  *
- * Restarts io events in the timeouts vector.
+ * Keeps the hot path cheap: the I/O only records the time of its last
+ * activity and the expired timeout calls this before acting. If there was
+ * activity within time_diff the timeout is armed again for the rest of the
+ * period, in the vector if one is given, and 1 is returned - the caller has to
+ * return without acting. Returns 0 if the timeout really expired or if it
+ * could not be armed again.
  */
-void iotc_io_timeouts_restart(iotc_evtd_instance_t* event_dispatcher,
-                              iotc_time_t new_time,
-                              iotc_vector_t* io_timeouts) {
-  assert(event_dispatcher != NULL);
-  assert(io_timeouts != NULL);
+uint8_t iotc_io_timeouts_postpone(
+    iotc_evtd_instance_t* event_dispatcher, iotc_event_handle_t handle,
+    iotc_time_t time_diff, iotc_time_t last_activity,
+    iotc_vector_t* io_timeouts, iotc_time_event_handle_t* time_event_handle) {
+  assert(NULL != event_dispatcher);
+  assert(NULL != time_event_handle &&
+         NULL == time_event_handle->ptr_to_position);
 
-  iotc_vector_index_type_t index = 0;
+  const iotc_time_t deadline = last_activity + time_diff;
+  const iotc_time_t now = event_dispatcher->current_step;
 
-  for (index = 0; index < io_timeouts->elem_no; ++index) {
-    iotc_vector_elem_t timeout_element = io_timeouts->array[index];
-    iotc_time_event_handle_t* time_event_handle =
-        timeout_element.selector_t.ptr_value;
+  if (deadline <= now) {
+    return 0;
+  }
 
-    assert(NULL != time_event_handle &&
-           NULL != time_event_handle->ptr_to_position);
+  const iotc_state_t state =
+      (NULL != io_timeouts)
+          ? iotc_io_timeouts_create(event_dispatcher, handle, deadline - now,
+                                    io_timeouts, time_event_handle)
+          : iotc_evtd_execute_in(event_dispatcher, handle, deadline - now,
+                                 time_event_handle);
 
-    const iotc_state_t local_state =
-        iotc_evtd_restart(event_dispatcher, time_event_handle, new_time);
-    IOTC_UNUSED(local_state);
-    assert(IOTC_STATE_OK == local_state);
-  }
+  return (IOTC_STATE_OK == state) ? 1 : 0;
 }
 
 /**
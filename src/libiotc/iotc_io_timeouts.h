@@ -46,8 +46,10 @@ void iotc_io_timeouts_cancel(iotc_evtd_instance_t* instance,
 void iotc_io_timeouts_remove(iotc_time_event_handle_t* time_event_handle,
                              iotc_vector_t* io_timeouts);
 
-void iotc_io_timeouts_restart(iotc_evtd_instance_t* instance,
-                              iotc_time_t new_time, iotc_vector_t* io_timeouts);
+uint8_t iotc_io_timeouts_postpone(
+    iotc_evtd_instance_t* instance, iotc_event_handle_t handle,
+    iotc_time_t time_diff, iotc_time_t last_activity,
+    iotc_vector_t* io_timeouts, iotc_time_event_handle_t* time_event_handle);
 
 #ifdef __cplusplus
 }
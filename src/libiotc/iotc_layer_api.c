@@ -16,8 +16,14 @@
 
 #include "iotc_layer_api.h"
 #include "iotc_config.h"
+#include "iotc_connect_scheduler.h"
 #include "iotc_event_thread_dispatcher.h"
 #include "iotc_globals.h"
+#include "iotc_macros.h"
+
+#ifdef IOTC_LAYER_TRACING_ENABLED
+#include "iotc_layer_tracing.h"
+#endif
 
 /**
  * @brief get_next_layer_state Function that checks what should be the next
@@ -57,6 +63,41 @@ static iotc_layer_state_t get_next_layer_state(
   return IOTC_LAYER_STATE_NONE;
 }
 
+/**
+ * @brief make_layer_handle Wraps the transition into an event handle, a traced
+ * one if the layer tracing is compiled in.
+ */
+static iotc_event_handle_t make_layer_handle(
+    iotc_layer_func_t* func, iotc_layer_connectivity_t* from_context,
+    iotc_layer_connectivity_t* context, void* data, iotc_state_t state) {
+#ifdef IOTC_LAYER_TRACING_ENABLED
+  return iotc_layer_tracing_make_handle(func, from_context, context, data,
+                                        state);
+#else
+  IOTC_UNUSED(from_context);
+  return iotc_make_handle(func, context, data, state);
+#endif
+}
+
+/**
+ * @brief notify_connect_scheduler Reports the end of the handshake to the
+ * connect scheduler once the outcome of the connect, or the close that ends
+ * the session, reaches the top of the layer chain, whatever layers it has.
+ */
+static void notify_connect_scheduler(iotc_layer_func_t* func,
+                                     iotc_layer_connectivity_t* context,
+                                     iotc_state_t state) {
+  if (NULL != context->next || NULL == IOTC_CONTEXT_DATA(context)) {
+    return;
+  }
+
+  if (func == IOTC_THIS_LAYER(context)->layer_funcs->connect ||
+      func == IOTC_THIS_LAYER(context)->layer_funcs->close_externally) {
+    iotc_connect_scheduler_connection_state_changed(IOTC_CONTEXT_DATA(context),
+                                                    state);
+  }
+}
+
 #if IOTC_DEBUG_EXTRA_INFO
 
 iotc_state_t iotc_layer_continue_with_impl(
@@ -73,13 +114,16 @@ iotc_state_t iotc_layer_continue_with_impl(
   if (func != NULL) {
     iotc_event_handle_queue_t* e_ptr =
         iotc_evttd_execute(IOTC_CONTEXT_DATA(context)->evtd_instance,
-                           iotc_make_handle(func, context, data, state));
+                           make_layer_handle(func, from_context, context, data,
+                                             state));
     IOTC_CHECK_MEMORY(e_ptr, local_state);
 
     iotc_layer_state_t next_state =
         get_next_layer_state(func, from_context, context, state);
 
     IOTC_THIS_LAYER_STATE_UPDATE(from_context, next_state);
+
+    notify_connect_scheduler(func, context, state);
   }
 
 err_handling:
@@ -96,13 +140,16 @@ iotc_state_t iotc_layer_continue_with_impl(
   if (func != NULL) {
     iotc_event_handle_queue_t* e_ptr =
         iotc_evttd_execute(IOTC_CONTEXT_DATA(context)->evtd_instance,
-                           iotc_make_handle(func, context, data, state));
+                           make_layer_handle(func, from_context, context, data,
+                                             state));
     IOTC_CHECK_MEMORY(e_ptr, local_state);
 
     iotc_layer_state_t next_state =
         get_next_layer_state(func, from_context, context, state);
 
     IOTC_THIS_LAYER_STATE_UPDATE(from_context, next_state);
+
+    notify_connect_scheduler(func, context, state);
   }
 
 err_handling:
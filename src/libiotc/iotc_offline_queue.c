@@ -0,0 +1,518 @@
+/* Copyright 2018-2020 Google LLC
+ *
+ * This is part of the Google Cloud IoT Device SDK for Embedded C.
+ * It is licensed under the BSD 3-Clause license; you may not use this file
+ * except in compliance with the License.
+ *
+ * You may obtain a copy of the License at:
+ *  https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+
+#include "iotc_debug.h"
+#include "iotc_event_thread_dispatcher.h"
+#include "iotc_fs_api.h"
+#include "iotc_helpers.h"
+#include "iotc_internals.h"
+#include "iotc_macros.h"
+#include "iotc_offline_queue.h"
+#include "iotc_queue.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* The persisted queue is a sequence of records, the integers are big endian:
+ * qos (1 byte), topic length (2 bytes), payload length (4 bytes), topic,
+ * payload. It starts with the magic so that a foreign file is not parsed. */
+static const uint8_t iotc_offline_queue_magic[] = {'I', 'O', 'Q', '1'};
+
+#define IOTC_OFFLINE_QUEUE_RECORD_HEADER_SIZE 7
+
+/* the public functions lock the queue, the static ones ending with _locked
+ * expect the lock to be held, without threads the lock macros expand to
+ * nothing */
+
+static size_t iotc_offline_queue_message_size(
+    const iotc_offline_message_t* message) {
+  return strlen(message->topic) + message->data->length;
+}
+
+static uint8_t iotc_offline_queue_fits_locked(
+    const iotc_offline_queue_t* queue, size_t size) {
+  return (queue->count < queue->max_messages &&
+          (0 == queue->max_bytes || queue->bytes + size <= queue->max_bytes))
+             ? 1
+             : 0;
+}
+
+static void iotc_offline_queue_unlink_locked(iotc_offline_queue_t* queue,
+                                             iotc_offline_message_t* message) {
+  IOTC_QUEUE_UNLINK(iotc_offline_message_t, queue->messages, message);
+
+  queue->count -= 1;
+  queue->bytes -= iotc_offline_queue_message_size(message);
+}
+
+/* the dropped message's callback learns that it has never been sent */
+static void iotc_offline_queue_drop_locked(iotc_offline_queue_t* queue,
+                                           iotc_offline_message_t* message,
+                                           iotc_evtd_instance_t* evtd) {
+  iotc_offline_queue_unlink_locked(queue, message);
+
+  if (NULL != evtd && 0 == iotc_handle_disposed(&message->callback)) {
+    iotc_event_handle_t handle = message->callback;
+    handle.handlers.h3.a3 = IOTC_BUFFER_OVERFLOW;
+
+    iotc_evttd_execute(evtd, handle);
+  }
+
+  iotc_offline_queue_free_message(&message);
+}
+
+/* drops messages according to the policy until size more bytes fit */
+static void iotc_offline_queue_make_room_locked(iotc_offline_queue_t* queue,
+                                                size_t size,
+                                                iotc_evtd_instance_t* evtd) {
+  while (NULL != queue->messages.head &&
+         0 == iotc_offline_queue_fits_locked(queue, size)) {
+    iotc_offline_queue_drop_locked(
+        queue,
+        (IOTC_OFFLINE_QUEUE_DROP_OLDEST == queue->policy)
+            ? queue->messages.head
+            : queue->messages.tail,
+        evtd);
+  }
+}
+
+/* queues the saved records, with a NULL queue it only checks that the whole
+ * buffer parses */
+static iotc_state_t iotc_offline_queue_parse(iotc_offline_queue_t* queue,
+                                             const iotc_data_desc_t* buffer,
+                                             iotc_evtd_instance_t* evtd) {
+  iotc_state_t state = IOTC_STATE_OK;
+  iotc_data_desc_t* data = NULL;
+  char* topic = NULL;
+
+  const uint8_t* ptr = buffer->data_ptr;
+  const uint8_t* const end = buffer->data_ptr + buffer->length;
+
+  IOTC_CHECK_CND_DBGMESSAGE(
+      (size_t)(end - ptr) < sizeof(iotc_offline_queue_magic) ||
+          0 != memcmp(ptr, iotc_offline_queue_magic,
+                      sizeof(iotc_offline_queue_magic)),
+      IOTC_SERIALIZATION_ERROR, state, "not a saved offline queue");
+
+  ptr += sizeof(iotc_offline_queue_magic);
+
+  while (ptr < end) {
+    IOTC_CHECK_CND_DBGMESSAGE(
+        end - ptr < IOTC_OFFLINE_QUEUE_RECORD_HEADER_SIZE,
+        IOTC_SERIALIZATION_ERROR, state, "truncated offline queue record");
+
+    const iotc_mqtt_qos_t qos = (iotc_mqtt_qos_t)ptr[0];
+    const size_t topic_length = ((size_t)ptr[1] << 8) | ptr[2];
+    const size_t data_length = ((size_t)ptr[3] << 24) |
+                               ((size_t)ptr[4] << 16) |
+                               ((size_t)ptr[5] << 8) | ptr[6];
+
+    ptr += IOTC_OFFLINE_QUEUE_RECORD_HEADER_SIZE;
+
+    IOTC_CHECK_CND_DBGMESSAGE(
+        (size_t)(end - ptr) < topic_length + data_length,
+        IOTC_SERIALIZATION_ERROR, state, "truncated offline queue record");
+
+    if (NULL == queue) {
+      ptr += topic_length + data_length;
+      continue;
+    }
+
+    IOTC_ALLOC_BUFFER_AT(char, topic, topic_length + 1, state);
+    memcpy(topic, ptr, topic_length);
+    ptr += topic_length;
+
+    IOTC_CHECK_MEMORY(data = iotc_make_desc_from_buffer_copy(ptr, data_length),
+                      state);
+    ptr += data_length;
+
+    /* the application which published these is gone, there's no callback */
+    iotc_offline_queue_push(queue, topic, data, qos, iotc_make_empty_handle(),
+                            evtd);
+    data = NULL;
+
+    IOTC_SAFE_FREE(topic);
+  }
+
+err_handling:
+  iotc_free_desc(&data);
+  IOTC_SAFE_FREE(topic);
+  return state;
+}
+
+static iotc_state_t iotc_offline_queue_load(iotc_offline_queue_t* queue,
+                                            iotc_evtd_instance_t* evtd) {
+  const iotc_fs_functions_t* fs = &iotc_internals.fs_functions;
+
+  iotc_state_t state = IOTC_STATE_OK;
+  iotc_fs_stat_t resource_stat = {0};
+  iotc_fs_resource_handle_t resource_handle = iotc_fs_init_resource_handle();
+  iotc_data_desc_t* buffer = NULL;
+
+  state = fs->stat_resource(NULL, IOTC_FS_CONFIG_DATA,
+                            queue->persistence_resource_name, &resource_stat);
+
+  /* nothing has been saved */
+  if (IOTC_FS_RESOURCE_NOT_AVAILABLE == state) {
+    return IOTC_STATE_OK;
+  }
+
+  IOTC_CHECK_STATE(state);
+
+  IOTC_CHECK_STATE(state = fs->open_resource(
+                       NULL, IOTC_FS_CONFIG_DATA,
+                       queue->persistence_resource_name, IOTC_FS_OPEN_READ,
+                       &resource_handle));
+
+  IOTC_CHECK_MEMORY(buffer = iotc_make_empty_desc_alloc(
+                        resource_stat.resource_size + 1),
+                    state);
+
+  while (buffer->length < resource_stat.resource_size) {
+    const uint8_t* chunk = NULL;
+    size_t chunk_size = 0;
+
+    IOTC_CHECK_STATE(state = fs->read_resource(NULL, resource_handle,
+                                               buffer->length, &chunk,
+                                               &chunk_size));
+
+    IOTC_CHECK_CND_DBGMESSAGE(NULL == chunk || 0 == chunk_size,
+                              IOTC_FS_READ_ERROR, state,
+                              "offline queue resource ended early");
+
+    IOTC_CHECK_STATE(state = iotc_data_desc_append_data_resize(
+                         buffer, (const char*)chunk, chunk_size));
+  }
+
+  fs->close_resource(NULL, resource_handle);
+  resource_handle = iotc_fs_init_resource_handle();
+
+  /* a resource which doesn't parse is kept and nothing of it is queued */
+  state = iotc_offline_queue_parse(NULL, buffer, NULL);
+
+  if (IOTC_STATE_OK != state) {
+    iotc_debug_format("offline queue resource %s can't be parsed, state: %d",
+                      queue->persistence_resource_name, state);
+    goto err_handling;
+  }
+
+  IOTC_CHECK_STATE(state = iotc_offline_queue_parse(queue, buffer, evtd));
+
+  /* the messages are in memory now, they would be sent twice otherwise */
+  fs->remove_resource(NULL, IOTC_FS_CONFIG_DATA,
+                      queue->persistence_resource_name);
+
+err_handling:
+  if (IOTC_FS_INVALID_RESOURCE_HANDLE != resource_handle) {
+    fs->close_resource(NULL, resource_handle);
+  }
+
+  iotc_free_desc(&buffer);
+  return state;
+}
+
+iotc_state_t iotc_offline_queue_configure(
+    iotc_offline_queue_t* queue, const iotc_offline_queue_config_t* config,
+    iotc_evtd_instance_t* evtd) {
+  assert(NULL != queue);
+  assert(NULL != config);
+
+  iotc_state_t state = IOTC_STATE_OK;
+
+  IOTC_SAFE_FREE(queue->persistence_resource_name);
+
+  iotc_lock_critical_section(&queue->cs);
+
+  queue->max_messages = config->max_messages;
+  queue->max_bytes = config->max_bytes;
+  queue->policy = config->policy;
+
+  iotc_offline_queue_make_room_locked(queue, 0, evtd);
+
+  iotc_unlock_critical_section(&queue->cs);
+
+  if (NULL != config->persistence_resource_name) {
+    IOTC_CHECK_MEMORY(queue->persistence_resource_name =
+                          iotc_str_dup(config->persistence_resource_name),
+                      state);
+
+    IOTC_CHECK_STATE(state = iotc_offline_queue_load(queue, evtd));
+  }
+
+err_handling:
+  return state;
+}
+
+uint8_t iotc_offline_queue_is_enabled(iotc_offline_queue_t* queue) {
+  assert(NULL != queue);
+
+  iotc_lock_critical_section(&queue->cs);
+  const uint8_t is_enabled = (0 < queue->max_messages) ? 1 : 0;
+  iotc_unlock_critical_section(&queue->cs);
+
+  return is_enabled;
+}
+
+uint8_t iotc_offline_queue_is_empty(iotc_offline_queue_t* queue) {
+  assert(NULL != queue);
+
+  iotc_lock_critical_section(&queue->cs);
+  const uint8_t is_empty = IOTC_QUEUE_EMPTY(queue->messages) ? 1 : 0;
+  iotc_unlock_critical_section(&queue->cs);
+
+  return is_empty;
+}
+
+static iotc_state_t iotc_offline_queue_push_locked(
+    iotc_offline_queue_t* queue, const char* topic, iotc_data_desc_t* data,
+    iotc_mqtt_qos_t qos, iotc_event_handle_t callback,
+    iotc_evtd_instance_t* evtd) {
+  iotc_state_t state = IOTC_STATE_OK;
+  iotc_offline_message_t* message = NULL;
+
+  const size_t size = strlen(topic) + data->length;
+
+  /* too big for an empty queue, whatever the policy */
+  IOTC_CHECK_CND_DBGMESSAGE(
+      0 == queue->max_messages ||
+          (0 != queue->max_bytes && size > queue->max_bytes),
+      IOTC_BUFFER_OVERFLOW, state, "message exceeds the offline queue budget");
+
+  IOTC_CHECK_CND_DBGMESSAGE(
+      IOTC_OFFLINE_QUEUE_DROP_NEWEST == queue->policy &&
+          0 == iotc_offline_queue_fits_locked(queue, size),
+      IOTC_BUFFER_OVERFLOW, state, "offline queue is full");
+
+  IOTC_ALLOC_AT(iotc_offline_message_t, message, state);
+  IOTC_CHECK_MEMORY(message->topic = iotc_str_dup(topic), state);
+
+  message->data = data;
+  message->callback = callback;
+  message->qos = qos;
+
+  iotc_offline_queue_make_room_locked(queue, size, evtd);
+
+  IOTC_QUEUE_PUSH_BACK(iotc_offline_message_t, queue->messages, message);
+
+  queue->count += 1;
+  queue->bytes += size;
+
+  return IOTC_STATE_OK;
+
+err_handling:
+  if (NULL != message) {
+    IOTC_SAFE_FREE(message->topic);
+    IOTC_SAFE_FREE(message);
+  }
+
+  iotc_free_desc(&data);
+  return state;
+}
+
+iotc_state_t iotc_offline_queue_push(iotc_offline_queue_t* queue,
+                                     const char* topic, iotc_data_desc_t* data,
+                                     iotc_mqtt_qos_t qos,
+                                     iotc_event_handle_t callback,
+                                     iotc_evtd_instance_t* evtd) {
+  assert(NULL != queue);
+  assert(NULL != topic);
+  assert(NULL != data);
+
+  iotc_lock_critical_section(&queue->cs);
+  const iotc_state_t state =
+      iotc_offline_queue_push_locked(queue, topic, data, qos, callback, evtd);
+  iotc_unlock_critical_section(&queue->cs);
+
+  return state;
+}
+
+uint8_t iotc_offline_queue_push_unless_online(
+    iotc_offline_queue_t* queue, iotc_offline_queue_is_online_t* is_online,
+    iotc_context_handle_t context_handle, const char* topic,
+    iotc_data_desc_t* data, iotc_mqtt_qos_t qos, iotc_event_handle_t callback,
+    iotc_evtd_instance_t* evtd, iotc_state_t* state) {
+  assert(NULL != queue);
+  assert(NULL != is_online);
+  assert(NULL != topic);
+  assert(NULL != data);
+  assert(NULL != state);
+
+  iotc_lock_critical_section(&queue->cs);
+
+  /* the drain pops under the same lock once the context is online, so the
+   * order of the messages is kept whichever comes first */
+  const uint8_t queued =
+      (0 < queue->max_messages &&
+       (0 == (*is_online)(context_handle) ||
+        0 == IOTC_QUEUE_EMPTY(queue->messages)))
+          ? 1
+          : 0;
+
+  if (1 == queued) {
+    *state =
+        iotc_offline_queue_push_locked(queue, topic, data, qos, callback, evtd);
+  }
+
+  iotc_unlock_critical_section(&queue->cs);
+
+  return queued;
+}
+
+iotc_offline_message_t* iotc_offline_queue_pop(iotc_offline_queue_t* queue) {
+  assert(NULL != queue);
+
+  iotc_lock_critical_section(&queue->cs);
+
+  iotc_offline_message_t* message = queue->messages.head;
+
+  if (NULL != message) {
+    iotc_offline_queue_unlink_locked(queue, message);
+  }
+
+  iotc_unlock_critical_section(&queue->cs);
+
+  return message;
+}
+
+void iotc_offline_queue_free_message(iotc_offline_message_t** message) {
+  if (NULL == message || NULL == *message) {
+    return;
+  }
+
+  iotc_free_desc(&(*message)->data);
+  IOTC_SAFE_FREE((*message)->topic);
+  IOTC_SAFE_FREE(*message);
+}
+
+/* one record per queued message after the magic, an empty buffer if there is
+ * nothing to save */
+static iotc_state_t iotc_offline_queue_serialize_locked(
+    const iotc_offline_queue_t* queue, iotc_data_desc_t** out_buffer) {
+  iotc_state_t state = IOTC_STATE_OK;
+  iotc_data_desc_t* buffer = NULL;
+
+  if (NULL == queue->persistence_resource_name ||
+      IOTC_QUEUE_EMPTY(queue->messages)) {
+    return IOTC_STATE_OK;
+  }
+
+  IOTC_CHECK_MEMORY(
+      buffer = iotc_make_empty_desc_alloc(
+          sizeof(iotc_offline_queue_magic) + queue->bytes +
+          queue->count * IOTC_OFFLINE_QUEUE_RECORD_HEADER_SIZE),
+      state);
+
+  IOTC_CHECK_STATE(state = iotc_data_desc_append_bytes(
+                       buffer, iotc_offline_queue_magic,
+                       sizeof(iotc_offline_queue_magic)));
+
+  const iotc_offline_message_t* message = queue->messages.head;
+  for (; NULL != message; message = message->__next) {
+    const size_t topic_length = strlen(message->topic);
+    const size_t data_length = message->data->length;
+
+    const uint8_t header[IOTC_OFFLINE_QUEUE_RECORD_HEADER_SIZE] = {
+        (uint8_t)message->qos,
+        (uint8_t)(topic_length >> 8),
+        (uint8_t)topic_length,
+        (uint8_t)(data_length >> 24),
+        (uint8_t)(data_length >> 16),
+        (uint8_t)(data_length >> 8),
+        (uint8_t)data_length};
+
+    IOTC_CHECK_STATE(
+        state = iotc_data_desc_append_bytes(buffer, header, sizeof(header)));
+    IOTC_CHECK_STATE(state = iotc_data_desc_append_bytes(
+                         buffer, (const uint8_t*)message->topic,
+                         topic_length));
+    IOTC_CHECK_STATE(state = iotc_data_desc_append_bytes(
+                         buffer, message->data->data_ptr, data_length));
+  }
+
+  *out_buffer = buffer;
+  return IOTC_STATE_OK;
+
+err_handling:
+  iotc_free_desc(&buffer);
+  return state;
+}
+
+iotc_state_t iotc_offline_queue_save(iotc_offline_queue_t* queue) {
+  assert(NULL != queue);
+
+  const iotc_fs_functions_t* fs = &iotc_internals.fs_functions;
+
+  iotc_state_t state = IOTC_STATE_OK;
+  iotc_fs_resource_handle_t resource_handle = iotc_fs_init_resource_handle();
+  iotc_data_desc_t* buffer = NULL;
+
+  /* the resource is written without holding the lock */
+  iotc_lock_critical_section(&queue->cs);
+  state = iotc_offline_queue_serialize_locked(queue, &buffer);
+  iotc_unlock_critical_section(&queue->cs);
+
+  IOTC_CHECK_STATE(state);
+
+  if (NULL == buffer) {
+    return IOTC_STATE_OK;
+  }
+
+  IOTC_CHECK_STATE(state = fs->open_resource(
+                       NULL, IOTC_FS_CONFIG_DATA,
+                       queue->persistence_resource_name, IOTC_FS_OPEN_WRITE,
+                       &resource_handle));
+
+  size_t offset = 0;
+  while (offset < buffer->length) {
+    size_t bytes_written = 0;
+
+    IOTC_CHECK_STATE(state = fs->write_resource(
+                         NULL, resource_handle, buffer->data_ptr + offset,
+                         buffer->length - offset, offset, &bytes_written));
+
+    IOTC_CHECK_CND_DBGMESSAGE(0 == bytes_written, IOTC_FS_WRITE_ERROR, state,
+                              "could not write the offline queue");
+
+    offset += bytes_written;
+  }
+
+err_handling:
+  if (IOTC_FS_INVALID_RESOURCE_HANDLE != resource_handle) {
+    fs->close_resource(NULL, resource_handle);
+  }
+
+  iotc_free_desc(&buffer);
+  return state;
+}
+
+void iotc_offline_queue_destroy(iotc_offline_queue_t* queue) {
+  assert(NULL != queue);
+
+  iotc_offline_message_t* message = NULL;
+
+  while (NULL != (message = iotc_offline_queue_pop(queue))) {
+    iotc_offline_queue_free_message(&message);
+  }
+
+  IOTC_SAFE_FREE(queue->persistence_resource_name);
+}
+
+#ifdef __cplusplus
+}
+#endif
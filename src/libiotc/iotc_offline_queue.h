@@ -0,0 +1,149 @@
+/* Copyright 2018-2020 Google LLC
+ *
+ * This is part of the Google Cloud IoT Device SDK for Embedded C.
+ * It is licensed under the BSD 3-Clause license; you may not use this file
+ * except in compliance with the License.
+ *
+ * You may obtain a copy of the License at:
+ *  https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __IOTC_OFFLINE_QUEUE_H__
+#define __IOTC_OFFLINE_QUEUE_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "iotc_critical_section.h"
+#include "iotc_critical_section_def.h"
+#include "iotc_data_desc.h"
+#include "iotc_event_dispatcher_api.h"
+#include "iotc_event_handle.h"
+
+#include <iotc_error.h>
+#include <iotc_mqtt.h>
+#include <iotc_types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Outbound store-and-forward queue of a context.
+ *
+ * Publishes made while the context is not connected, or while the backoff
+ * is applied, are kept here within a message and a byte budget instead of
+ * failing. The MQTT logic layer drains the queue right after the CONNACK,
+ * all the QoS1 messages go out at once and the QoS0 ones back to back. The
+ * queue outlives the connections, it is embedded in iotc_context_data_t.
+ *
+ * The application's thread pushes while the context's event loop drains, so
+ * every function below takes the queue's critical section.
+ */
+typedef struct iotc_offline_message_s {
+  struct iotc_offline_message_s* __next;
+  struct iotc_offline_message_s* __prev;
+  char* topic;
+  iotc_data_desc_t* data;
+  iotc_event_handle_t callback;
+  iotc_mqtt_qos_t qos;
+} iotc_offline_message_t;
+
+typedef struct iotc_offline_queue_s {
+  struct {
+    iotc_offline_message_t* head;
+    iotc_offline_message_t* tail;
+  } messages;
+  char* persistence_resource_name;
+  size_t max_bytes;
+  size_t bytes; /* payloads and topics of the queued messages */
+  uint16_t max_messages;
+  uint16_t count;
+  iotc_offline_queue_policy_t policy;
+  /* zeroed with the context, an unlocked critical section */
+  struct iotc_critical_section_s cs;
+} iotc_offline_queue_t;
+
+/* tells if a publish can be sent right away, see
+ * iotc_offline_queue_push_unless_online */
+typedef uint8_t(iotc_offline_queue_is_online_t)(iotc_context_handle_t);
+
+/**
+ * @brief sets the budget and the policy, messages over the new budget are
+ * dropped according to the policy. If a persistence resource is given, the
+ * messages saved there are restored, without callbacks, and the resource is
+ * removed.
+ */
+extern iotc_state_t iotc_offline_queue_configure(
+    iotc_offline_queue_t* queue, const iotc_offline_queue_config_t* config,
+    iotc_evtd_instance_t* evtd);
+
+/**
+ * @brief returns 1 if the budget allows queueing any message
+ */
+extern uint8_t iotc_offline_queue_is_enabled(iotc_offline_queue_t* queue);
+
+extern uint8_t iotc_offline_queue_is_empty(iotc_offline_queue_t* queue);
+
+/**
+ * @brief queues a publish, takes the ownership of data in every case
+ *
+ * The callbacks of the messages dropped to make room are scheduled on evtd
+ * with IOTC_BUFFER_OVERFLOW.
+ *
+ * @return IOTC_BUFFER_OVERFLOW if the message was rejected, the callback of a
+ * rejected message is not invoked
+ */
+extern iotc_state_t iotc_offline_queue_push(iotc_offline_queue_t* queue,
+                                            const char* topic,
+                                            iotc_data_desc_t* data,
+                                            iotc_mqtt_qos_t qos,
+                                            iotc_event_handle_t callback,
+                                            iotc_evtd_instance_t* evtd);
+
+/**
+ * @brief queues the publish unless the queue is disabled, or is_online says
+ * the context is connected and no older message waits for the drain
+ *
+ * The check and the push are one step for the drain, so a message is either
+ * queued before the drain pops the last one or published after it, never
+ * left behind in the queue until the next CONNACK.
+ *
+ * @return 1 if the queue took the message, it owns data then and state is set
+ * to the result of iotc_offline_queue_push, 0 if the caller has to send it
+ */
+extern uint8_t iotc_offline_queue_push_unless_online(
+    iotc_offline_queue_t* queue, iotc_offline_queue_is_online_t* is_online,
+    iotc_context_handle_t context_handle, const char* topic,
+    iotc_data_desc_t* data, iotc_mqtt_qos_t qos, iotc_event_handle_t callback,
+    iotc_evtd_instance_t* evtd, iotc_state_t* state);
+
+/**
+ * @brief removes the oldest message, NULL if the queue is empty
+ */
+extern iotc_offline_message_t* iotc_offline_queue_pop(
+    iotc_offline_queue_t* queue);
+
+extern void iotc_offline_queue_free_message(iotc_offline_message_t** message);
+
+/**
+ * @brief writes the queued messages to the persistence resource, if any
+ */
+extern iotc_state_t iotc_offline_queue_save(iotc_offline_queue_t* queue);
+
+/**
+ * @brief releases all the messages without invoking their callbacks
+ */
+extern void iotc_offline_queue_destroy(iotc_offline_queue_t* queue);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __IOTC_OFFLINE_QUEUE_H__ */
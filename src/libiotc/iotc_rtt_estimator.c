@@ -0,0 +1,124 @@
+/* Copyright 2018-2020 Google LLC
+ *
+ * This is part of the Google Cloud IoT Device SDK for Embedded C.
+ * It is licensed under the BSD 3-Clause license; you may not use this file
+ * except in compliance with the License.
+ *
+ * You may obtain a copy of the License at:
+ *  https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "iotc_rtt_estimator.h"
+
+#include <assert.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* the gains of RFC 6298: alpha = 1/8 and beta = 1/4 */
+#define IOTC_RTT_ALPHA_SHIFT 3
+#define IOTC_RTT_BETA_SHIFT 2
+
+void iotc_rtt_estimator_add_sample(iotc_rtt_estimator_t* estimator,
+                                   uint32_t rtt_ms) {
+  assert(NULL != estimator);
+
+  if (0 == estimator->has_sample) {
+    estimator->srtt_ms = rtt_ms;
+    estimator->rttvar_ms = rtt_ms / 2;
+    estimator->has_sample = 1;
+  } else {
+    const uint32_t delta = estimator->srtt_ms > rtt_ms
+                               ? estimator->srtt_ms - rtt_ms
+                               : rtt_ms - estimator->srtt_ms;
+
+    /* RTTVAR is updated with the old SRTT, as the RFC says */
+    estimator->rttvar_ms = estimator->rttvar_ms -
+                           (estimator->rttvar_ms >> IOTC_RTT_BETA_SHIFT) +
+                           (delta >> IOTC_RTT_BETA_SHIFT);
+    estimator->srtt_ms = estimator->srtt_ms -
+                         (estimator->srtt_ms >> IOTC_RTT_ALPHA_SHIFT) +
+                         (rtt_ms >> IOTC_RTT_ALPHA_SHIFT);
+  }
+
+  estimator->backoff = 0;
+}
+
+void iotc_rtt_estimator_backoff(iotc_rtt_estimator_t* estimator) {
+  assert(NULL != estimator);
+
+  if (IOTC_RTT_MAX_BACKOFF > estimator->backoff) {
+    ++estimator->backoff;
+  }
+}
+
+uint32_t iotc_rtt_estimator_rto_ms(const iotc_rtt_estimator_t* estimator) {
+  assert(NULL != estimator);
+
+  if (0 == estimator->has_sample) {
+    return 0;
+  }
+
+  uint64_t rto_ms =
+      (uint64_t)estimator->srtt_ms + 4 * (uint64_t)estimator->rttvar_ms;
+  rto_ms <<= estimator->backoff;
+
+  return UINT32_MAX < rto_ms ? UINT32_MAX : (uint32_t)rto_ms;
+}
+
+uint16_t iotc_rtt_estimator_timeout(const iotc_rtt_estimator_t* estimator,
+                                    uint16_t min_sec, uint16_t max_sec) {
+  assert(NULL != estimator);
+
+  if (0 == estimator->has_sample) {
+    return max_sec;
+  }
+
+  /* in 64 bits, the rounding up must not wrap UINT32_MAX around */
+  const uint64_t rto_sec =
+      ((uint64_t)iotc_rtt_estimator_rto_ms(estimator) + 999) / 1000;
+  const uint64_t timeout_sec = min_sec > rto_sec ? min_sec : rto_sec;
+
+  return max_sec < timeout_sec ? max_sec : (uint16_t)timeout_sec;
+}
+
+void iotc_rtt_estimator_pingreq_sent(iotc_rtt_estimator_t* estimator,
+                                     iotc_time_t now_ms) {
+  assert(NULL != estimator);
+
+  estimator->pingreq_time_ms = now_ms;
+}
+
+int64_t iotc_rtt_estimator_pingresp_received(iotc_rtt_estimator_t* estimator,
+                                             iotc_time_t now_ms) {
+  assert(NULL != estimator);
+
+  if (0 == estimator->pingreq_time_ms) {
+    return -1;
+  }
+
+  iotc_time_t rtt_ms = now_ms - estimator->pingreq_time_ms;
+  estimator->pingreq_time_ms = 0;
+
+  /* the wall clock may have been set back meanwhile */
+  if (0 > rtt_ms) {
+    return -1;
+  }
+
+  rtt_ms = UINT32_MAX < rtt_ms ? UINT32_MAX : rtt_ms;
+  iotc_rtt_estimator_add_sample(estimator, (uint32_t)rtt_ms);
+
+  return rtt_ms;
+}
+
+#ifdef __cplusplus
+}
+#endif
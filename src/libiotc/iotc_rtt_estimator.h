@@ -0,0 +1,106 @@
+/* Copyright 2018-2020 Google LLC
+ *
+ * This is part of the Google Cloud IoT Device SDK for Embedded C.
+ * It is licensed under the BSD 3-Clause license; you may not use this file
+ * except in compliance with the License.
+ *
+ * You may obtain a copy of the License at:
+ *  https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __IOTC_RTT_ESTIMATOR_H__
+#define __IOTC_RTT_ESTIMATOR_H__
+
+#include <stdint.h>
+
+#include <iotc_time.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Round trip time estimator of a context.
+ *
+ * The MQTT logic layer feeds it with the time between a PINGREQ and its
+ * PINGRESP and between a QoS1 PUBLISH and its PUBACK. It keeps a smoothed
+ * RTT and an RTT variance the way TCP does (RFC 6298) and derives from them
+ * the time to wait for the responses, bounded by the configured keepalive
+ * timeout. Following Karn's algorithm the retransmitted PUBLISHes give no
+ * sample and every timeout doubles the wait until the next sample.
+ *
+ * The estimator is embedded in iotc_context_data_t and outlives the
+ * connections, the path to the broker rarely changes on a reconnect.
+ */
+typedef struct iotc_rtt_estimator_s {
+  uint32_t srtt_ms;
+  uint32_t rttvar_ms;
+  /* when the pending PINGREQ was written, 0 if none is pending */
+  iotc_time_t pingreq_time_ms;
+  uint8_t has_sample;
+  /* the doublings of the timeout since the last sample */
+  uint8_t backoff;
+} iotc_rtt_estimator_t;
+
+/* the timeouts count whole seconds of the event dispatcher and a broker
+ * under load may hold its acknowledgements back for a while, below a few
+ * seconds a retransmission is more likely spurious than useful */
+#define IOTC_RTT_MIN_TIMEOUT_SEC 5
+/* a missing PINGRESP drops the connection, it gets more slack than a PUBACK
+ * whose absence costs a retransmission only */
+#define IOTC_RTT_PINGRESP_MIN_TIMEOUT_SEC 10
+#define IOTC_RTT_MAX_BACKOFF 6
+
+/**
+ * @brief folds a round trip time sample into the estimate and clears the
+ * backoff
+ */
+extern void iotc_rtt_estimator_add_sample(iotc_rtt_estimator_t* estimator,
+                                          uint32_t rtt_ms);
+
+/**
+ * @brief doubles the timeout, called when a response didn't arrive in time
+ */
+extern void iotc_rtt_estimator_backoff(iotc_rtt_estimator_t* estimator);
+
+/**
+ * @brief returns the retransmission timeout in milliseconds, SRTT + 4 *
+ * RTTVAR with the backoff applied, 0 without any sample
+ */
+extern uint32_t iotc_rtt_estimator_rto_ms(
+    const iotc_rtt_estimator_t* estimator);
+
+/**
+ * @brief returns the time to wait for a response in seconds, the
+ * retransmission timeout rounded up and kept within [min_sec, max_sec]
+ *
+ * Without any sample yet it returns max_sec, the configured timeout.
+ */
+extern uint16_t iotc_rtt_estimator_timeout(
+    const iotc_rtt_estimator_t* estimator, uint16_t min_sec, uint16_t max_sec);
+
+/**
+ * @brief remembers when the PINGREQ was written
+ */
+extern void iotc_rtt_estimator_pingreq_sent(iotc_rtt_estimator_t* estimator,
+                                            iotc_time_t now_ms);
+
+/**
+ * @brief takes the sample of the pending PINGREQ
+ *
+ * @return the round trip time in milliseconds, -1 if no PINGREQ was pending
+ */
+extern int64_t iotc_rtt_estimator_pingresp_received(
+    iotc_rtt_estimator_t* estimator, iotc_time_t now_ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __IOTC_RTT_ESTIMATOR_H__ */
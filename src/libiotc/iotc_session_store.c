@@ -0,0 +1,542 @@
+/* Copyright 2018-2020 Google LLC
+ *
+ * This is part of the Google Cloud IoT Device SDK for Embedded C.
+ * It is licensed under the BSD 3-Clause license; you may not use this file
+ * except in compliance with the License.
+ *
+ * You may obtain a copy of the License at:
+ *  https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+
+#include "iotc_debug.h"
+#include "iotc_fs_api.h"
+#include "iotc_helpers.h"
+#include "iotc_internals.h"
+#include "iotc_list.h"
+#include "iotc_macros.h"
+#include "iotc_queue.h"
+#include "iotc_session_store.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* The log starts with the magic, then come the records, the integers are big
+ * endian:
+ *  - publish: 'P', msg id (2 bytes), topic length (2 bytes), payload length
+ *    (4 bytes), topic, payload
+ *  - acknowledgement: 'A', msg id (2 bytes)
+ * A publish is live if no acknowledgement of its msg id follows it. */
+static const uint8_t iotc_session_store_magic[] = {'I', 'S', 'L', '1'};
+
+#define IOTC_SESSION_STORE_PUBLISH_RECORD 'P'
+#define IOTC_SESSION_STORE_ACK_RECORD 'A'
+#define IOTC_SESSION_STORE_PUBLISH_HEADER_SIZE 9
+#define IOTC_SESSION_STORE_ACK_SIZE 3
+#define IOTC_SESSION_STORE_DEFAULT_COMPACTION_THRESHOLD 64
+
+#define CMP_ENTRY_MSG_ID(entry, id) ((entry)->msg_id == (id))
+
+static void iotc_session_store_free_entry(iotc_session_store_entry_t** entry) {
+  if (NULL == entry || NULL == *entry) {
+    return;
+  }
+
+  iotc_free_desc(&(*entry)->record);
+  IOTC_SAFE_FREE(*entry);
+}
+
+static void iotc_session_store_drop_entries(iotc_session_store_t* store) {
+  while (NULL != store->entries.head) {
+    iotc_session_store_entry_t* entry = store->entries.head;
+    IOTC_QUEUE_UNLINK(iotc_session_store_entry_t, store->entries, entry);
+    iotc_session_store_free_entry(&entry);
+  }
+
+  store->count = 0;
+}
+
+static iotc_session_store_entry_t* iotc_session_store_find(
+    iotc_session_store_t* store, uint16_t msg_id) {
+  iotc_session_store_entry_t* entry = NULL;
+
+  IOTC_LIST_FIND(iotc_session_store_entry_t, store->entries.head,
+                 CMP_ENTRY_MSG_ID, msg_id, entry);
+
+  return entry;
+}
+
+static void iotc_session_store_remove(iotc_session_store_t* store,
+                                      uint16_t msg_id) {
+  iotc_session_store_entry_t* entry = iotc_session_store_find(store, msg_id);
+
+  if (NULL != entry) {
+    IOTC_QUEUE_UNLINK(iotc_session_store_entry_t, store->entries, entry);
+    iotc_session_store_free_entry(&entry);
+    store->count -= 1;
+  }
+}
+
+static iotc_state_t iotc_session_store_add(iotc_session_store_t* store,
+                                           uint16_t msg_id,
+                                           const uint8_t* record,
+                                           size_t record_length,
+                                           uint8_t restored) {
+  iotc_state_t state = IOTC_STATE_OK;
+  iotc_session_store_entry_t* entry = NULL;
+
+  /* a msg id is reused once its previous publish is over */
+  iotc_session_store_remove(store, msg_id);
+
+  IOTC_ALLOC_AT(iotc_session_store_entry_t, entry, state);
+  IOTC_CHECK_MEMORY(
+      entry->record = iotc_make_desc_from_buffer_copy(record, record_length),
+      state);
+
+  entry->msg_id = msg_id;
+  entry->restored = restored;
+
+  IOTC_QUEUE_PUSH_BACK(iotc_session_store_entry_t, store->entries, entry);
+  store->count += 1;
+
+  return IOTC_STATE_OK;
+
+err_handling:
+  iotc_session_store_free_entry(&entry);
+  return state;
+}
+
+static iotc_state_t iotc_session_store_write(const char* resource_name,
+                                             iotc_fs_open_flags_t open_flags,
+                                             const iotc_data_desc_t* buffer) {
+  const iotc_fs_functions_t* fs = &iotc_internals.fs_functions;
+
+  iotc_state_t state = IOTC_STATE_OK;
+  iotc_fs_resource_handle_t resource_handle = iotc_fs_init_resource_handle();
+
+  IOTC_CHECK_STATE(state = fs->open_resource(NULL, IOTC_FS_CONFIG_DATA,
+                                             resource_name, open_flags,
+                                             &resource_handle));
+
+  size_t offset = 0;
+  while (offset < buffer->length) {
+    size_t bytes_written = 0;
+
+    IOTC_CHECK_STATE(state = fs->write_resource(
+                         NULL, resource_handle, buffer->data_ptr + offset,
+                         buffer->length - offset, offset, &bytes_written));
+
+    IOTC_CHECK_CND_DBGMESSAGE(0 == bytes_written, IOTC_FS_WRITE_ERROR, state,
+                              "could not write the session log");
+
+    offset += bytes_written;
+  }
+
+err_handling:
+  if (IOTC_FS_INVALID_RESOURCE_HANDLE != resource_handle) {
+    fs->close_resource(NULL, resource_handle);
+  }
+
+  return state;
+}
+
+/* replaces the log with the live publishes, the pending records are
+ * reflected by the entries already */
+static iotc_state_t iotc_session_store_compact(iotc_session_store_t* store) {
+  iotc_state_t state = IOTC_STATE_OK;
+  iotc_data_desc_t* buffer = NULL;
+  IOTC_CHECK_MEMORY(buffer = iotc_make_empty_desc_alloc(256), state);
+
+  IOTC_CHECK_STATE(state = iotc_data_desc_append_data_resize(
+                       buffer, (const char*)iotc_session_store_magic,
+                       sizeof(iotc_session_store_magic)));
+
+  const iotc_session_store_entry_t* entry = store->entries.head;
+  for (; NULL != entry; entry = entry->__next) {
+    IOTC_CHECK_STATE(state = iotc_data_desc_append_data_resize(
+                         buffer, (const char*)entry->record->data_ptr,
+                         entry->record->length));
+  }
+
+  IOTC_CHECK_STATE(state = iotc_session_store_write(
+                       store->log_resource_name, IOTC_FS_OPEN_WRITE, buffer));
+
+  store->log_records = store->count;
+  store->pending_records = 0;
+
+  if (NULL != store->pending) {
+    store->pending->length = 0;
+  }
+
+err_handling:
+  iotc_free_desc(&buffer);
+  return state;
+}
+
+static iotc_state_t iotc_session_store_flush_event(void* data) {
+  iotc_session_store_t* store = (iotc_session_store_t*)data;
+
+  store->flush_event.ptr_to_position = NULL;
+
+  const iotc_state_t state = iotc_session_store_flush(store);
+
+  if (IOTC_STATE_OK != state) {
+    iotc_debug_format("session log could not be written, state: %d", state);
+  }
+
+  return IOTC_STATE_OK;
+}
+
+/* the records of one event loop iteration are appended together */
+static iotc_state_t iotc_session_store_append(iotc_session_store_t* store,
+                                              const uint8_t* record,
+                                              size_t record_length) {
+  iotc_state_t state = IOTC_STATE_OK;
+
+  if (NULL == store->pending) {
+    IOTC_CHECK_MEMORY(store->pending = iotc_make_empty_desc_alloc(256), state);
+  }
+
+  IOTC_CHECK_STATE(state = iotc_data_desc_append_data_resize(
+                       store->pending, (const char*)record, record_length));
+
+  store->pending_records += 1;
+
+  if (NULL != store->evtd && NULL == store->flush_event.ptr_to_position) {
+    IOTC_CHECK_STATE(
+        state = iotc_evtd_execute_in(
+            store->evtd, iotc_make_handle(&iotc_session_store_flush_event, store),
+            0, &store->flush_event));
+  }
+
+err_handling:
+  return state;
+}
+
+static iotc_state_t iotc_session_store_parse(iotc_session_store_t* store,
+                                             const iotc_data_desc_t* buffer) {
+  iotc_state_t state = IOTC_STATE_OK;
+
+  const uint8_t* ptr = buffer->data_ptr;
+  const uint8_t* const end = buffer->data_ptr + buffer->length;
+
+  IOTC_CHECK_CND_DBGMESSAGE(
+      (size_t)(end - ptr) < sizeof(iotc_session_store_magic) ||
+          0 != memcmp(ptr, iotc_session_store_magic,
+                      sizeof(iotc_session_store_magic)),
+      IOTC_SERIALIZATION_ERROR, state, "not a session log");
+
+  ptr += sizeof(iotc_session_store_magic);
+
+  /* a record cut short by a crash ends the log */
+  while (end - ptr >= IOTC_SESSION_STORE_ACK_SIZE) {
+    const uint16_t msg_id = (uint16_t)((ptr[1] << 8) | ptr[2]);
+
+    if (IOTC_SESSION_STORE_ACK_RECORD == ptr[0]) {
+      iotc_session_store_remove(store, msg_id);
+      ptr += IOTC_SESSION_STORE_ACK_SIZE;
+      continue;
+    }
+
+    IOTC_CHECK_CND_DBGMESSAGE(IOTC_SESSION_STORE_PUBLISH_RECORD != ptr[0],
+                              IOTC_SERIALIZATION_ERROR, state,
+                              "unknown session log record");
+
+    if (end - ptr < IOTC_SESSION_STORE_PUBLISH_HEADER_SIZE) {
+      break;
+    }
+
+    const size_t topic_length = ((size_t)ptr[3] << 8) | ptr[4];
+    const size_t data_length = ((size_t)ptr[5] << 24) |
+                               ((size_t)ptr[6] << 16) |
+                               ((size_t)ptr[7] << 8) | ptr[8];
+    const size_t record_length =
+        IOTC_SESSION_STORE_PUBLISH_HEADER_SIZE + topic_length + data_length;
+
+    if ((size_t)(end - ptr) < record_length) {
+      break;
+    }
+
+    IOTC_CHECK_STATE(state = iotc_session_store_add(store, msg_id, ptr,
+                                                    record_length, 1));
+
+    ptr += record_length;
+  }
+
+err_handling:
+  return state;
+}
+
+static iotc_state_t iotc_session_store_load(iotc_session_store_t* store) {
+  const iotc_fs_functions_t* fs = &iotc_internals.fs_functions;
+
+  iotc_state_t state = IOTC_STATE_OK;
+  iotc_fs_stat_t resource_stat = {0};
+  iotc_fs_resource_handle_t resource_handle = iotc_fs_init_resource_handle();
+  iotc_data_desc_t* buffer = NULL;
+
+  state = fs->stat_resource(NULL, IOTC_FS_CONFIG_DATA,
+                            store->log_resource_name, &resource_stat);
+
+  /* no previous session */
+  if (IOTC_FS_RESOURCE_NOT_AVAILABLE == state) {
+    return IOTC_STATE_OK;
+  }
+
+  IOTC_CHECK_STATE(state);
+
+  IOTC_CHECK_STATE(state = fs->open_resource(
+                       NULL, IOTC_FS_CONFIG_DATA, store->log_resource_name,
+                       IOTC_FS_OPEN_READ, &resource_handle));
+
+  IOTC_CHECK_MEMORY(buffer = iotc_make_empty_desc_alloc(
+                        resource_stat.resource_size + 1),
+                    state);
+
+  while (buffer->length < resource_stat.resource_size) {
+    const uint8_t* chunk = NULL;
+    size_t chunk_size = 0;
+
+    IOTC_CHECK_STATE(state = fs->read_resource(NULL, resource_handle,
+                                               buffer->length, &chunk,
+                                               &chunk_size));
+
+    IOTC_CHECK_CND_DBGMESSAGE(NULL == chunk || 0 == chunk_size,
+                              IOTC_FS_READ_ERROR, state,
+                              "session log ended early");
+
+    IOTC_CHECK_STATE(state = iotc_data_desc_append_data_resize(
+                         buffer, (const char*)chunk, chunk_size));
+  }
+
+  state = iotc_session_store_parse(store, buffer);
+
+err_handling:
+  if (IOTC_FS_INVALID_RESOURCE_HANDLE != resource_handle) {
+    fs->close_resource(NULL, resource_handle);
+  }
+
+  iotc_free_desc(&buffer);
+  return state;
+}
+
+iotc_state_t iotc_session_store_configure(
+    iotc_session_store_t* store, const iotc_session_store_config_t* config,
+    iotc_evtd_instance_t* evtd) {
+  assert(NULL != store);
+
+  iotc_state_t state = IOTC_STATE_OK;
+
+  /* what has been recorded so far belongs to the previous log */
+  iotc_session_store_flush(store);
+
+  if (NULL != store->evtd && NULL != store->flush_event.ptr_to_position) {
+    iotc_evtd_cancel(store->evtd, &store->flush_event);
+  }
+
+  iotc_session_store_drop_entries(store);
+  iotc_free_desc(&store->pending);
+  IOTC_SAFE_FREE(store->log_resource_name);
+
+  store->evtd = evtd;
+  store->log_records = 0;
+  store->pending_records = 0;
+  store->enabled = (NULL != config) ? 1 : 0;
+
+  if (NULL == config) {
+    return IOTC_STATE_OK;
+  }
+
+  store->compaction_threshold =
+      (0 == config->compaction_threshold)
+          ? IOTC_SESSION_STORE_DEFAULT_COMPACTION_THRESHOLD
+          : config->compaction_threshold;
+
+  if (NULL != config->log_resource_name) {
+    IOTC_CHECK_MEMORY(
+        store->log_resource_name = iotc_str_dup(config->log_resource_name),
+        state);
+
+    state = iotc_session_store_load(store);
+
+    /* a damaged log is replaced, whatever could be read is kept */
+    if (IOTC_SERIALIZATION_ERROR == state) {
+      iotc_debug_logger("session log is damaged, it is going to be rewritten");
+      state = IOTC_STATE_OK;
+    }
+
+    IOTC_CHECK_STATE(state);
+    IOTC_CHECK_STATE(state = iotc_session_store_compact(store));
+  }
+
+err_handling:
+  return state;
+}
+
+uint8_t iotc_session_store_is_enabled(const iotc_session_store_t* store) {
+  assert(NULL != store);
+
+  return store->enabled;
+}
+
+iotc_state_t iotc_session_store_record_publish(iotc_session_store_t* store,
+                                               uint16_t msg_id,
+                                               const char* topic,
+                                               const iotc_data_desc_t* data) {
+  assert(NULL != store);
+  assert(NULL != topic);
+  assert(NULL != data);
+
+  if (NULL == store->log_resource_name) {
+    return IOTC_STATE_OK;
+  }
+
+  iotc_state_t state = IOTC_STATE_OK;
+  iotc_data_desc_t* record = NULL;
+
+  const size_t topic_length = strlen(topic);
+  const size_t data_length = data->length;
+
+  const uint8_t header[IOTC_SESSION_STORE_PUBLISH_HEADER_SIZE] = {
+      IOTC_SESSION_STORE_PUBLISH_RECORD,
+      (uint8_t)(msg_id >> 8),
+      (uint8_t)msg_id,
+      (uint8_t)(topic_length >> 8),
+      (uint8_t)topic_length,
+      (uint8_t)(data_length >> 24),
+      (uint8_t)(data_length >> 16),
+      (uint8_t)(data_length >> 8),
+      (uint8_t)data_length};
+
+  IOTC_CHECK_MEMORY(
+      record = iotc_make_empty_desc_alloc(sizeof(header) + topic_length +
+                                          data_length),
+      state);
+
+  IOTC_CHECK_STATE(
+      state = iotc_data_desc_append_bytes(record, header, sizeof(header)));
+  IOTC_CHECK_STATE(state = iotc_data_desc_append_bytes(
+                       record, (const uint8_t*)topic, topic_length));
+  IOTC_CHECK_STATE(state = iotc_data_desc_append_bytes(record, data->data_ptr,
+                                                       data_length));
+
+  IOTC_CHECK_STATE(state = iotc_session_store_add(
+                       store, msg_id, record->data_ptr, record->length, 0));
+
+  IOTC_CHECK_STATE(state = iotc_session_store_append(store, record->data_ptr,
+                                                     record->length));
+
+err_handling:
+  iotc_free_desc(&record);
+  return state;
+}
+
+void iotc_session_store_record_ack(iotc_session_store_t* store,
+                                   uint16_t msg_id) {
+  assert(NULL != store);
+
+  if (NULL == iotc_session_store_find(store, msg_id)) {
+    return;
+  }
+
+  iotc_session_store_remove(store, msg_id);
+
+  const uint8_t record[IOTC_SESSION_STORE_ACK_SIZE] = {
+      IOTC_SESSION_STORE_ACK_RECORD, (uint8_t)(msg_id >> 8), (uint8_t)msg_id};
+
+  /* the next compaction drops the publish anyway */
+  iotc_session_store_append(store, record, sizeof(record));
+}
+
+iotc_session_store_entry_t* iotc_session_store_adopt_restored(
+    iotc_session_store_t* store) {
+  assert(NULL != store);
+
+  iotc_session_store_entry_t* entry = store->entries.head;
+
+  for (; NULL != entry; entry = entry->__next) {
+    if (1 == entry->restored) {
+      entry->restored = 0;
+      return entry;
+    }
+  }
+
+  return NULL;
+}
+
+iotc_state_t iotc_session_store_entry_publish(
+    const iotc_session_store_entry_t* entry, char** topic,
+    iotc_data_desc_t** data) {
+  assert(NULL != entry);
+  assert(NULL != topic);
+  assert(NULL != data);
+
+  iotc_state_t state = IOTC_STATE_OK;
+
+  const uint8_t* ptr = entry->record->data_ptr;
+  const size_t topic_length = ((size_t)ptr[3] << 8) | ptr[4];
+  const size_t data_length = entry->record->length -
+                             IOTC_SESSION_STORE_PUBLISH_HEADER_SIZE -
+                             topic_length;
+
+  ptr += IOTC_SESSION_STORE_PUBLISH_HEADER_SIZE;
+
+  IOTC_ALLOC_BUFFER_AT(char, *topic, topic_length + 1, state);
+  memcpy(*topic, ptr, topic_length);
+
+  IOTC_CHECK_MEMORY(*data = iotc_make_desc_from_buffer_copy(ptr + topic_length,
+                                                            data_length),
+                    state);
+
+  return IOTC_STATE_OK;
+
+err_handling:
+  IOTC_SAFE_FREE(*topic);
+  return state;
+}
+
+iotc_state_t iotc_session_store_flush(iotc_session_store_t* store) {
+  assert(NULL != store);
+
+  if (NULL == store->log_resource_name || NULL == store->pending ||
+      0 == store->pending->length) {
+    return IOTC_STATE_OK;
+  }
+
+  /* the records of the acknowledged publishes would pile up otherwise */
+  if (store->log_records + store->pending_records - store->count >=
+      store->compaction_threshold) {
+    return iotc_session_store_compact(store);
+  }
+
+  /* not every file system appends, rewriting is always possible */
+  if (IOTC_STATE_OK != iotc_session_store_write(store->log_resource_name,
+                                                IOTC_FS_OPEN_APPEND,
+                                                store->pending)) {
+    return iotc_session_store_compact(store);
+  }
+
+  store->log_records += store->pending_records;
+  store->pending_records = 0;
+  store->pending->length = 0;
+
+  return IOTC_STATE_OK;
+}
+
+void iotc_session_store_destroy(iotc_session_store_t* store) {
+  assert(NULL != store);
+
+  iotc_session_store_configure(store, NULL, NULL);
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,129 @@
+/* Copyright 2018-2020 Google LLC
+ *
+ * This is part of the Google Cloud IoT Device SDK for Embedded C.
+ * It is licensed under the BSD 3-Clause license; you may not use this file
+ * except in compliance with the License.
+ *
+ * You may obtain a copy of the License at:
+ *  https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __IOTC_SESSION_STORE_H__
+#define __IOTC_SESSION_STORE_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "iotc_data_desc.h"
+#include "iotc_event_dispatcher_api.h"
+
+#include <iotc_error.h>
+#include <iotc_types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Store of the MQTT session of a context.
+ *
+ * While it is enabled the context connects with IOTC_SESSION_CONTINUE and the
+ * MQTT logic layer keeps its unacknowledged QoS1 tasks across connections.
+ * With a log resource the store also records every in-flight QoS1 publish
+ * and its acknowledgement in an append-only log, so that the publishes of a
+ * previous run can be restored. The records of one event loop iteration are
+ * appended together by a single write, the log is rewritten with the live
+ * publishes only once compaction_threshold of its records are obsolete.
+ */
+typedef struct iotc_session_store_entry_s {
+  struct iotc_session_store_entry_s* __next;
+  struct iotc_session_store_entry_s* __prev;
+  /* the publish record exactly as it is in the log */
+  iotc_data_desc_t* record;
+  uint16_t msg_id;
+  /* loaded from the log and not yet turned into a task */
+  uint8_t restored;
+} iotc_session_store_entry_t;
+
+typedef struct iotc_session_store_s {
+  struct {
+    iotc_session_store_entry_t* head;
+    iotc_session_store_entry_t* tail;
+  } entries;
+  char* log_resource_name;
+  /* records not appended to the log yet */
+  iotc_data_desc_t* pending;
+  iotc_time_event_handle_t flush_event;
+  iotc_evtd_instance_t* evtd;
+  /* records in the log, live or not */
+  uint16_t log_records;
+  uint16_t pending_records;
+  /* live publishes, the entries */
+  uint16_t count;
+  uint16_t compaction_threshold;
+  uint8_t enabled;
+} iotc_session_store_t;
+
+/**
+ * @brief enables the store, or disables it if config is NULL
+ *
+ * If the configuration names a log resource, the publishes recorded there
+ * and never acknowledged are loaded as restored entries and the log is
+ * compacted.
+ */
+extern iotc_state_t iotc_session_store_configure(
+    iotc_session_store_t* store, const iotc_session_store_config_t* config,
+    iotc_evtd_instance_t* evtd);
+
+extern uint8_t iotc_session_store_is_enabled(const iotc_session_store_t* store);
+
+/**
+ * @brief records a QoS1 publish the first time it is sent
+ *
+ * Does nothing unless the store has a log, the publish is in memory anyway.
+ */
+extern iotc_state_t iotc_session_store_record_publish(
+    iotc_session_store_t* store, uint16_t msg_id, const char* topic,
+    const iotc_data_desc_t* data);
+
+/**
+ * @brief records that the publish is over, acknowledged or given up
+ */
+extern void iotc_session_store_record_ack(iotc_session_store_t* store,
+                                          uint16_t msg_id);
+
+/**
+ * @brief returns the next restored entry which no task owns yet and marks it
+ * as owned, NULL if there is none
+ */
+extern iotc_session_store_entry_t* iotc_session_store_adopt_restored(
+    iotc_session_store_t* store);
+
+/**
+ * @brief decodes a copy of the entry's topic and payload
+ */
+extern iotc_state_t iotc_session_store_entry_publish(
+    const iotc_session_store_entry_t* entry, char** topic,
+    iotc_data_desc_t** data);
+
+/**
+ * @brief writes the pending records to the log, compacting it if needed
+ */
+extern iotc_state_t iotc_session_store_flush(iotc_session_store_t* store);
+
+/**
+ * @brief flushes the pending records and releases the store
+ */
+extern void iotc_session_store_destroy(iotc_session_store_t* store);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __IOTC_SESSION_STORE_H__ */
@@ -17,7 +17,10 @@
 #include "iotc_timed_task.h"
 #include "iotc_handle.h"
 
+/* the table grows on demand, this only caps the number of live tasks */
+#ifndef IOTC_MAX_TIMED_EVENT
 #define IOTC_MAX_TIMED_EVENT 64
+#endif
 
 typedef enum {
   IOTC_TTS_SCHEDULED,
@@ -43,19 +46,23 @@ iotc_timed_task_container_t* iotc_make_timed_task_container() {
 
   IOTC_ALLOC(iotc_timed_task_container_t, container, state);
 
-  container->timed_tasks_vector = iotc_vector_create();
+  container->timed_tasks = iotc_handle_table_create(IOTC_MAX_TIMED_EVENT);
+  IOTC_CHECK_MEMORY(container->timed_tasks, state);
   IOTC_CHECK_STATE(state = iotc_init_critical_section(&container->cs));
 
   return container;
 
 err_handling:
+  if (NULL != container) {
+    iotc_handle_table_destroy(container->timed_tasks);
+  }
   IOTC_SAFE_FREE(container);
   return NULL;
 }
 
 void iotc_destroy_timed_task_container(iotc_timed_task_container_t* container) {
   assert(NULL != container);
-  iotc_vector_destroy(container->timed_tasks_vector);
+  iotc_handle_table_destroy(container->timed_tasks);
   iotc_destroy_critical_section(&container->cs);
   IOTC_SAFE_FREE(container);
 }
@@ -82,14 +89,12 @@ iotc_timed_task_handle_t iotc_add_timed_task(
   task->state = IOTC_TTS_SCHEDULED;
 
   iotc_lock_critical_section(container->cs);
-  IOTC_CHECK_STATE(
-      state = iotc_register_handle_for_object(container->timed_tasks_vector,
-                                              IOTC_MAX_TIMED_EVENT, task));
-
-  IOTC_CHECK_STATE(state = iotc_find_handle_for_object(
-                       container->timed_tasks_vector, task, &task_handle));
+  state = iotc_register_handle_for_object(container->timed_tasks, task,
+                                          &task_handle);
   iotc_unlock_critical_section(container->cs);
 
+  IOTC_CHECK_STATE(state);
+
   state =
       iotc_evtd_execute_in(dispatcher,
                            iotc_make_handle(&iotc_timed_task_callback_wrapper,
@@ -115,7 +120,7 @@ void iotc_remove_timed_task(iotc_timed_task_container_t* container,
 
   iotc_timed_task_data_t* task =
       (iotc_timed_task_data_t*)iotc_object_for_handle(
-          container->timed_tasks_vector, timed_task_handle);
+          container->timed_tasks, timed_task_handle);
 
   if (NULL != task) {
     if (IOTC_TTS_SCHEDULED == task->state) {
@@ -123,7 +128,7 @@ void iotc_remove_timed_task(iotc_timed_task_container_t* container,
       assert(IOTC_STATE_OK == state);
 
       state =
-          iotc_delete_handle_for_object(container->timed_tasks_vector, task);
+          iotc_delete_handle_for_object(container->timed_tasks, task);
       IOTC_UNUSED(state);
 
       /* POST-CONDITION */
@@ -150,7 +155,7 @@ iotc_state_t iotc_timed_task_callback_wrapper(void* void_task,
   iotc_timed_task_handle_t task_handle = -1;
 
   iotc_lock_critical_section(container->cs);
-  state = iotc_find_handle_for_object(container->timed_tasks_vector, task,
+  state = iotc_find_handle_for_object(container->timed_tasks, task,
                                       &task_handle);
   if (IOTC_STATE_OK == state) {
     task->state = IOTC_TTS_RUNNING;
@@ -167,7 +172,7 @@ iotc_state_t iotc_timed_task_callback_wrapper(void* void_task,
 
     if (0 == task->seconds_repeat || IOTC_TTS_DELETABLE == task->state) {
       iotc_state_t del_state =
-          iotc_delete_handle_for_object(container->timed_tasks_vector, task);
+          iotc_delete_handle_for_object(container->timed_tasks, task);
 
       IOTC_UNUSED(del_state);
 
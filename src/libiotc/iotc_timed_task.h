@@ -18,13 +18,13 @@
 #define __IOTC_TIMED_TASK_H__
 
 #include "iotc_critical_section.h"
+#include "iotc_handle.h"
 #include "iotc_macros.h"
 #include "iotc_types_internal.h"
-#include "iotc_vector.h"
 
 typedef struct iotc_timed_task_container_s {
   struct iotc_critical_section_s* cs;
-  iotc_vector_t* timed_tasks_vector;
+  iotc_handle_table_t* timed_tasks;
 } iotc_timed_task_container_t;
 
 iotc_timed_task_container_t* iotc_make_timed_task_container();
@@ -18,9 +18,14 @@
 #define __IOTC_TYPES_INTERNAL_H__
 
 #include <iotc_types.h>
+#include "iotc_connect_scheduler.h"
 #include "iotc_connection_data.h"
+#include "iotc_context_stats.h"
 #include "iotc_event_dispatcher_api.h"
 #include "iotc_layer_chain.h"
+#include "iotc_offline_queue.h"
+#include "iotc_rtt_estimator.h"
+#include "iotc_session_store.h"
 #include "iotc_vector.h"
 
 #ifdef __cplusplus
@@ -63,12 +68,28 @@ typedef struct iotc_context_data_s {
 #endif
   /* this is the common part */
   iotc_time_event_handle_t connect_handler;
+  iotc_connect_admission_t connect_admission;
   /* vector or a list of timeouts */
   iotc_vector_t* io_timeouts;
+  /* the time of the last read, the io timeouts are postponed against it
+   * when they expire */
+  iotc_time_t io_last_read_time;
   iotc_connection_data_t* connection_data;
+  /* copied into the connection data on every connect */
+  iotc_bsp_socket_options_t socket_options;
   iotc_evtd_instance_t* evtd_instance;
   iotc_event_handle_t connection_callback;
   iotc_shutdown_state_t shutdown_state;
+  /* publishes waiting for the connection, outlives the connections */
+  iotc_offline_queue_t offline_queue;
+  /* in-flight QoS1 publishes, kept while the session is continued */
+  iotc_session_store_t session_store;
+  /* round trip times to the broker, they set the response timeouts */
+  iotc_rtt_estimator_t rtt_estimator;
+#ifndef IOTC_NO_CONTEXT_STATS
+  /* the counters behind iotc_get_context_stats */
+  iotc_context_stats_data_t stats;
+#endif
 
   char** updateable_files;
   uint16_t updateable_files_count;
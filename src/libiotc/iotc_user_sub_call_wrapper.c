@@ -41,8 +41,8 @@ iotc_state_t iotc_user_sub_call_wrapper(void* context, void* data,
 
   /* Only if the library context is not null. */
   if (NULL != context) {
-    state = iotc_find_handle_for_object(iotc_globals.context_handles_vector,
-                                        context, &context_handle);
+    state = iotc_find_handle_for_object(iotc_globals.context_handles, context,
+                                        &context_handle);
     IOTC_CHECK_STATE(state);
   }
 
@@ -23,6 +23,8 @@
 
 #ifdef IOTC_MEMORY_LIMITER_ENABLED
 #include "iotc_memory_limiter.h"
+#elif defined(IOTC_MEMORY_ACCOUNTING_ENABLED)
+#include "iotc_memory_accounting.h"
 #endif
 
 #ifdef __cplusplus
@@ -74,6 +76,8 @@ extern void __iotc_free(void* ptr);
 #ifdef IOTC_MEMORY_LIMITER_ENABLED
 #define iotc_alloc(b) \
   iotc_memory_limiter_alloc_application(b, __FILE__, __LINE__)
+#elif defined(IOTC_MEMORY_ACCOUNTING_ENABLED)
+#define iotc_alloc iotc_memory_accounting_alloc_application
 #else
 #define iotc_alloc __iotc_alloc
 #endif
@@ -81,6 +85,8 @@ extern void __iotc_free(void* ptr);
 #ifdef IOTC_MEMORY_LIMITER_ENABLED
 #define iotc_calloc(num, byte_count) \
   iotc_memory_limiter_calloc_application(num, byte_count, __FILE__, __LINE__)
+#elif defined(IOTC_MEMORY_ACCOUNTING_ENABLED)
+#define iotc_calloc iotc_memory_accounting_calloc_application
 #else
 #define iotc_calloc __iotc_calloc
 #endif
@@ -91,6 +97,8 @@ extern void __iotc_free(void* ptr);
 #ifdef IOTC_MEMORY_LIMITER_ENABLED
 #define iotc_realloc(p, b) \
   iotc_memory_limiter_realloc_application(p, b, __FILE__, __LINE__)
+#elif defined(IOTC_MEMORY_ACCOUNTING_ENABLED)
+#define iotc_realloc iotc_memory_accounting_realloc_application
 #else
 #define iotc_realloc __iotc_realloc
 #endif
@@ -100,6 +108,8 @@ extern void __iotc_free(void* ptr);
  */
 #ifdef IOTC_MEMORY_LIMITER_ENABLED
 #define iotc_free(p) iotc_memory_limiter_free(p)
+#elif defined(IOTC_MEMORY_ACCOUNTING_ENABLED)
+#define iotc_free iotc_memory_accounting_free
 #else
 #define iotc_free __iotc_free
 #endif
@@ -108,6 +118,8 @@ extern void __iotc_free(void* ptr);
 #ifdef IOTC_MEMORY_LIMITER_ENABLED
 #define iotc_alloc_system(b) \
   iotc_memory_limiter_alloc_system(b, __FILE__, __LINE__)
+#elif defined(IOTC_MEMORY_ACCOUNTING_ENABLED)
+#define iotc_alloc_system(b) iotc_memory_accounting_alloc_system(b)
 #else
 #define iotc_alloc_system(b) __iotc_alloc(b)
 #endif
@@ -115,6 +127,9 @@ extern void __iotc_free(void* ptr);
 #ifdef IOTC_MEMORY_LIMITER_ENABLED
 #define iotc_calloc_system(num, byte_count) \
   iotc_memory_limiter_calloc_system(num, byte_count, __FILE__, __LINE__)
+#elif defined(IOTC_MEMORY_ACCOUNTING_ENABLED)
+#define iotc_calloc_system(num, byte_count) \
+  iotc_memory_accounting_calloc_system(num, byte_count)
 #else
 #define iotc_calloc_system(num, byte_count) __iotc_calloc(num, byte_count)
 #endif
@@ -122,6 +137,8 @@ extern void __iotc_free(void* ptr);
 #ifdef IOTC_MEMORY_LIMITER_ENABLED
 #define iotc_realloc_system(b) \
   iotc_memory_limiter_realloc_system(b, __FILE__, __LINE__)
+#elif defined(IOTC_MEMORY_ACCOUNTING_ENABLED)
+#define iotc_realloc_system(p, b) iotc_memory_accounting_realloc_system(p, b)
 #else
 #define iotc_realloc_system(b) __iotc_realloc(b)
 #endif
@@ -129,24 +146,32 @@ extern void __iotc_free(void* ptr);
 /* For exposing ptr's. */
 #ifdef IOTC_MEMORY_LIMITER_ENABLED
 #define iotc_alloc_ptr &iotc_memory_limiter_alloc_application_export
+#elif defined(IOTC_MEMORY_ACCOUNTING_ENABLED)
+#define iotc_alloc_ptr &iotc_memory_accounting_alloc_application
 #else
 #define iotc_alloc_ptr &__iotc_alloc
 #endif
 
 #ifdef IOTC_MEMORY_LIMITER_ENABLED
 #define iotc_calloc_ptr &iotc_memory_limiter_calloc_application_export
+#elif defined(IOTC_MEMORY_ACCOUNTING_ENABLED)
+#define iotc_calloc_ptr &iotc_memory_accounting_calloc_application
 #else
 #define iotc_calloc_ptr &__iotc_calloc
 #endif
 
 #ifdef IOTC_MEMORY_LIMITER_ENABLED
 #define iotc_realloc_ptr &iotc_memory_limiter_realloc_application_export
+#elif defined(IOTC_MEMORY_ACCOUNTING_ENABLED)
+#define iotc_realloc_ptr &iotc_memory_accounting_realloc_application
 #else
 #define iotc_realloc_ptr &__iotc_realloc
 #endif
 
 #ifdef IOTC_MEMORY_LIMITER_ENABLED
 #define iotc_free_ptr &iotc_memory_limiter_free
+#elif defined(IOTC_MEMORY_ACCOUNTING_ENABLED)
+#define iotc_free_ptr &iotc_memory_accounting_free
 #else
 #define iotc_free_ptr &__iotc_free
 #endif
@@ -0,0 +1,398 @@
+/* Copyright 2018-2020 Google LLC
+ *
+ * This is part of the Google Cloud IoT Device SDK for Embedded C.
+ * It is licensed under the BSD 3-Clause license; you may not use this file
+ * except in compliance with the License.
+ *
+ * You may obtain a copy of the License at:
+ *  https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifdef IOTC_MEMORY_ACCOUNTING_ENABLED
+
+#include <stdint.h>
+#include <string.h>
+
+#include "iotc_allocator.h"
+#include "iotc_critical_section.h"
+#include "iotc_critical_section_def.h"
+#include "iotc_debug.h"
+#include "iotc_handle.h"
+#include "iotc_macros.h"
+#include "iotc_memory_accounting.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* The owner is tracked per thread so that worker threads running handles of
+ * different contexts don't account to each other. */
+#if defined(IOTC_MODULE_THREAD_ENABLED) && defined(__GNUC__)
+#define IOTC_MEMORY_ACCOUNTING_THREAD_LOCAL __thread
+#else
+#define IOTC_MEMORY_ACCOUNTING_THREAD_LOCAL
+#endif
+
+#define get_ptr_from_header(h) \
+  (void*)((intptr_t)h + sizeof(iotc_memory_accounting_header_t))
+
+#define get_header_from_ptr(p)                     \
+  (iotc_memory_accounting_header_t*)((intptr_t)p - \
+                                     sizeof(iotc_memory_accounting_header_t))
+
+/* static initialisation of the critical section */
+static struct iotc_critical_section_s iotc_memory_accounting_cs = {0};
+
+static iotc_memory_accounting_stats_t
+    iotc_memory_accounting_owner_stats[IOTC_MEMORY_ACCOUNTING_MAX_OWNERS];
+static iotc_memory_accounting_stats_t iotc_memory_accounting_total_stats;
+
+static IOTC_MEMORY_ACCOUNTING_THREAD_LOCAL iotc_memory_accounting_owner_t
+    iotc_memory_accounting_current_owner = IOTC_MEMORY_ACCOUNTING_OWNER_NONE;
+
+static iotc_state_t iotc_memory_accounting_will_allocation_fit(
+    iotc_memory_accounting_allocation_type_t type,
+    iotc_memory_accounting_owner_t owner, size_t size_to_alloc) {
+  const size_t total_limit = iotc_memory_accounting_total_stats.budget;
+
+  if (0 != total_limit) {
+    const size_t limit =
+        type == IOTC_MEMORY_ACCOUNTING_ALLOCATION_TYPE_APPLICATION
+            ? total_limit - IOTC_MEMORY_ACCOUNTING_SYSTEM_MEMORY_RESERVE
+            : total_limit;
+
+    if (iotc_memory_accounting_total_stats.current + size_to_alloc > limit) {
+      return IOTC_OUT_OF_MEMORY;
+    }
+  }
+
+  /* System allocations are never refused because of a context budget, they
+   * are what lets the context recover from the application failure. */
+  if (type == IOTC_MEMORY_ACCOUNTING_ALLOCATION_TYPE_APPLICATION) {
+    const iotc_memory_accounting_stats_t* stats =
+        &iotc_memory_accounting_owner_stats[owner];
+
+    if (0 != stats->budget && stats->current + size_to_alloc > stats->budget) {
+      return IOTC_OUT_OF_MEMORY;
+    }
+  }
+
+  return IOTC_STATE_OK;
+}
+
+static void iotc_memory_accounting_stats_grow(
+    iotc_memory_accounting_stats_t* stats, size_t size) {
+  stats->current += size;
+  stats->peak = IOTC_MAX(stats->peak, stats->current);
+}
+
+static void iotc_memory_accounting_add(iotc_memory_accounting_owner_t owner,
+                                       size_t size) {
+  iotc_memory_accounting_stats_grow(&iotc_memory_accounting_owner_stats[owner],
+                                    size);
+  iotc_memory_accounting_stats_grow(&iotc_memory_accounting_total_stats, size);
+}
+
+static void iotc_memory_accounting_sub(iotc_memory_accounting_owner_t owner,
+                                       size_t size) {
+  /* this is the simplest check to verify the memory integrity */
+  assert(iotc_memory_accounting_owner_stats[owner].current >= size);
+
+  iotc_memory_accounting_owner_stats[owner].current -= size;
+  iotc_memory_accounting_total_stats.current -= size;
+}
+
+static void iotc_memory_accounting_count_failure(
+    iotc_memory_accounting_owner_t owner) {
+  iotc_memory_accounting_owner_stats[owner].failures += 1;
+  iotc_memory_accounting_total_stats.failures += 1;
+}
+
+void* iotc_memory_accounting_alloc(
+    iotc_memory_accounting_allocation_type_t type, size_t size_to_alloc) {
+  assert(type < IOTC_MEMORY_ACCOUNTING_ALLOCATION_TYPE_COUNT);
+
+  /* just to satisfy the compiler */
+  (void)iotc_memory_accounting_cs;
+
+  const iotc_memory_accounting_owner_t owner =
+      iotc_memory_accounting_current_owner;
+  const size_t real_size_to_alloc =
+      size_to_alloc + sizeof(iotc_memory_accounting_header_t);
+  iotc_memory_accounting_header_t* header = NULL;
+
+  iotc_lock_critical_section(&iotc_memory_accounting_cs);
+
+  if (IOTC_STATE_OK != iotc_memory_accounting_will_allocation_fit(
+                           type, owner, real_size_to_alloc)) {
+    goto err_handling;
+  }
+
+  header = (iotc_memory_accounting_header_t*)__iotc_alloc(real_size_to_alloc);
+
+  if (NULL == header) {
+    goto err_handling;
+  }
+
+  header->entry.size = real_size_to_alloc;
+  header->entry.owner = owner;
+
+  iotc_memory_accounting_add(owner, real_size_to_alloc);
+  iotc_memory_accounting_owner_stats[owner].allocations += 1;
+  iotc_memory_accounting_total_stats.allocations += 1;
+
+  iotc_unlock_critical_section(&iotc_memory_accounting_cs);
+  return get_ptr_from_header(header);
+
+err_handling:
+  iotc_memory_accounting_count_failure(owner);
+  iotc_unlock_critical_section(&iotc_memory_accounting_cs);
+  return NULL;
+}
+
+void* iotc_memory_accounting_calloc(
+    iotc_memory_accounting_allocation_type_t type, size_t num,
+    size_t size_to_alloc) {
+  const size_t allocation_size = num * size_to_alloc;
+
+  /* Prevent overflow. */
+  if (allocation_size == 0 || num > SIZE_MAX / size_to_alloc) {
+    return NULL;
+  }
+
+  void* ret = iotc_memory_accounting_alloc(type, allocation_size);
+
+  /* it's unspecified if memset works with NULL pointer */
+  if (NULL != ret) {
+    memset(ret, 0, allocation_size);
+  }
+
+  return ret;
+}
+
+void* iotc_memory_accounting_realloc(
+    iotc_memory_accounting_allocation_type_t type, void* ptr,
+    size_t size_to_alloc) {
+  if (NULL == ptr) {
+    return iotc_memory_accounting_alloc(type, size_to_alloc);
+  }
+
+  assert(type < IOTC_MEMORY_ACCOUNTING_ALLOCATION_TYPE_COUNT);
+
+  iotc_memory_accounting_header_t* header = get_header_from_ptr(ptr);
+
+  /* the block stays accounted to the owner that allocated it */
+  const iotc_memory_accounting_owner_t owner = header->entry.owner;
+  const size_t old_size = header->entry.size;
+  const size_t real_size_to_alloc =
+      size_to_alloc + sizeof(iotc_memory_accounting_header_t);
+
+  iotc_lock_critical_section(&iotc_memory_accounting_cs);
+
+  if (real_size_to_alloc > old_size &&
+      IOTC_STATE_OK !=
+          iotc_memory_accounting_will_allocation_fit(
+              type, owner, real_size_to_alloc - old_size)) {
+    goto err_handling;
+  }
+
+  header = (iotc_memory_accounting_header_t*)__iotc_realloc(header,
+                                                            real_size_to_alloc);
+
+  if (NULL == header) {
+    goto err_handling;
+  }
+
+  header->entry.size = real_size_to_alloc;
+
+  iotc_memory_accounting_sub(owner, old_size);
+  iotc_memory_accounting_add(owner, real_size_to_alloc);
+
+  iotc_unlock_critical_section(&iotc_memory_accounting_cs);
+  return get_ptr_from_header(header);
+
+err_handling:
+  iotc_memory_accounting_count_failure(owner);
+  iotc_unlock_critical_section(&iotc_memory_accounting_cs);
+  return NULL;
+}
+
+void iotc_memory_accounting_free(void* ptr) {
+  if (NULL == ptr) {
+    return;
+  }
+
+  iotc_memory_accounting_header_t* header = get_header_from_ptr(ptr);
+  const iotc_memory_accounting_owner_t owner = header->entry.owner;
+
+  iotc_lock_critical_section(&iotc_memory_accounting_cs);
+
+  iotc_memory_accounting_sub(owner, header->entry.size);
+  iotc_memory_accounting_owner_stats[owner].frees += 1;
+  iotc_memory_accounting_total_stats.frees += 1;
+
+  iotc_unlock_critical_section(&iotc_memory_accounting_cs);
+
+  __iotc_free(header);
+}
+
+void* iotc_memory_accounting_alloc_application(size_t size_to_alloc) {
+  return iotc_memory_accounting_alloc(
+      IOTC_MEMORY_ACCOUNTING_ALLOCATION_TYPE_APPLICATION, size_to_alloc);
+}
+
+void* iotc_memory_accounting_calloc_application(size_t num,
+                                                size_t size_to_alloc) {
+  return iotc_memory_accounting_calloc(
+      IOTC_MEMORY_ACCOUNTING_ALLOCATION_TYPE_APPLICATION, num, size_to_alloc);
+}
+
+void* iotc_memory_accounting_realloc_application(void* ptr,
+                                                 size_t size_to_alloc) {
+  return iotc_memory_accounting_realloc(
+      IOTC_MEMORY_ACCOUNTING_ALLOCATION_TYPE_APPLICATION, ptr, size_to_alloc);
+}
+
+void* iotc_memory_accounting_alloc_system(size_t size_to_alloc) {
+  return iotc_memory_accounting_alloc(
+      IOTC_MEMORY_ACCOUNTING_ALLOCATION_TYPE_SYSTEM, size_to_alloc);
+}
+
+void* iotc_memory_accounting_calloc_system(size_t num, size_t size_to_alloc) {
+  return iotc_memory_accounting_calloc(
+      IOTC_MEMORY_ACCOUNTING_ALLOCATION_TYPE_SYSTEM, num, size_to_alloc);
+}
+
+void* iotc_memory_accounting_realloc_system(void* ptr, size_t size_to_alloc) {
+  return iotc_memory_accounting_realloc(
+      IOTC_MEMORY_ACCOUNTING_ALLOCATION_TYPE_SYSTEM, ptr, size_to_alloc);
+}
+
+iotc_state_t iotc_memory_accounting_set_limit(const size_t limit) {
+  iotc_state_t state = IOTC_STATE_OK;
+
+  iotc_lock_critical_section(&iotc_memory_accounting_cs);
+
+  if (0 != limit &&
+      limit < iotc_memory_accounting_total_stats.current +
+                  IOTC_MEMORY_ACCOUNTING_SYSTEM_MEMORY_RESERVE) {
+    state = IOTC_OUT_OF_MEMORY;
+  } else {
+    iotc_memory_accounting_total_stats.budget = limit;
+  }
+
+  iotc_unlock_critical_section(&iotc_memory_accounting_cs);
+
+  return state;
+}
+
+size_t iotc_memory_accounting_get_allocated_space() {
+  return iotc_memory_accounting_total_stats.current;
+}
+
+iotc_state_t iotc_memory_accounting_set_budget(
+    iotc_memory_accounting_owner_t owner, const size_t budget) {
+  if (IOTC_MEMORY_ACCOUNTING_MAX_OWNERS <= owner) {
+    return IOTC_INVALID_PARAMETER;
+  }
+
+  iotc_lock_critical_section(&iotc_memory_accounting_cs);
+  iotc_memory_accounting_owner_stats[owner].budget = budget;
+  iotc_unlock_critical_section(&iotc_memory_accounting_cs);
+
+  return IOTC_STATE_OK;
+}
+
+iotc_state_t iotc_memory_accounting_reset_owner(
+    iotc_memory_accounting_owner_t owner) {
+  if (IOTC_MEMORY_ACCOUNTING_MAX_OWNERS <= owner ||
+      IOTC_MEMORY_ACCOUNTING_OWNER_NONE == owner) {
+    return IOTC_INVALID_PARAMETER;
+  }
+
+  iotc_lock_critical_section(&iotc_memory_accounting_cs);
+
+  iotc_memory_accounting_stats_t* stats =
+      &iotc_memory_accounting_owner_stats[owner];
+  const size_t current = stats->current;
+
+  memset(stats, 0, sizeof(iotc_memory_accounting_stats_t));
+  stats->current = current;
+  stats->peak = current;
+
+  iotc_unlock_critical_section(&iotc_memory_accounting_cs);
+
+  return IOTC_STATE_OK;
+}
+
+iotc_state_t iotc_memory_accounting_get_stats(
+    iotc_memory_accounting_owner_t owner,
+    iotc_memory_accounting_stats_t* out_stats) {
+  if (IOTC_MEMORY_ACCOUNTING_MAX_OWNERS <= owner || NULL == out_stats) {
+    return IOTC_INVALID_PARAMETER;
+  }
+
+  iotc_lock_critical_section(&iotc_memory_accounting_cs);
+  *out_stats = iotc_memory_accounting_owner_stats[owner];
+  iotc_unlock_critical_section(&iotc_memory_accounting_cs);
+
+  return IOTC_STATE_OK;
+}
+
+iotc_state_t iotc_memory_accounting_get_total_stats(
+    iotc_memory_accounting_stats_t* out_stats) {
+  if (NULL == out_stats) {
+    return IOTC_INVALID_PARAMETER;
+  }
+
+  iotc_lock_critical_section(&iotc_memory_accounting_cs);
+  *out_stats = iotc_memory_accounting_total_stats;
+  iotc_unlock_critical_section(&iotc_memory_accounting_cs);
+
+  return IOTC_STATE_OK;
+}
+
+iotc_memory_accounting_owner_t iotc_memory_accounting_owner_for_context(
+    iotc_context_handle_t context_handle) {
+  if (0 > context_handle) {
+    return IOTC_MEMORY_ACCOUNTING_OWNER_NONE;
+  }
+
+  /* the slot of the handle, see the header for the generation */
+  const iotc_handle_t slot = IOTC_HANDLE_INDEX(context_handle);
+
+  if (IOTC_MEMORY_ACCOUNTING_MAX_CONTEXTS <= slot) {
+    return IOTC_MEMORY_ACCOUNTING_OWNER_NONE;
+  }
+
+  return (iotc_memory_accounting_owner_t)(slot + 1);
+}
+
+iotc_memory_accounting_owner_t iotc_memory_accounting_set_owner(
+    iotc_memory_accounting_owner_t owner) {
+  const iotc_memory_accounting_owner_t prev_owner =
+      iotc_memory_accounting_current_owner;
+
+  iotc_memory_accounting_current_owner =
+      IOTC_MEMORY_ACCOUNTING_MAX_OWNERS <= owner
+          ? IOTC_MEMORY_ACCOUNTING_OWNER_NONE
+          : owner;
+
+  return prev_owner;
+}
+
+iotc_memory_accounting_owner_t iotc_memory_accounting_get_owner() {
+  return iotc_memory_accounting_current_owner;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* IOTC_MEMORY_ACCOUNTING_ENABLED */
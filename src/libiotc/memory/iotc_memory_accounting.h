@@ -0,0 +1,198 @@
+/* Copyright 2018-2020 Google LLC
+ *
+ * This is part of the Google Cloud IoT Device SDK for Embedded C.
+ * It is licensed under the BSD 3-Clause license; you may not use this file
+ * except in compliance with the License.
+ *
+ * You may obtain a copy of the License at:
+ *  https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __IOTC_MEMORY_ACCOUNTING_H__
+#define __IOTC_MEMORY_ACCOUNTING_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "iotc_config.h"
+
+#include <iotc_error.h>
+#include <iotc_types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Number of contexts that get their own accounting slot: every context the
+ * handle table can hold, so that no context is accounted as unowned. The
+ * slots are a static array of iotc_memory_accounting_stats_t.
+ */
+#ifndef IOTC_MEMORY_ACCOUNTING_MAX_CONTEXTS
+#define IOTC_MEMORY_ACCOUNTING_MAX_CONTEXTS IOTC_MAX_NUM_CONTEXTS
+#endif
+
+#if IOTC_MEMORY_ACCOUNTING_MAX_CONTEXTS < IOTC_MAX_NUM_CONTEXTS
+#error "IOTC_MEMORY_ACCOUNTING_MAX_CONTEXTS is below IOTC_MAX_NUM_CONTEXTS"
+#endif
+
+/**
+ * Amount of memory reserved for system allocations once the global limit is
+ * set. Same role as IOTC_MEMORY_LIMITER_SYSTEM_MEMORY_LIMIT: it lets the
+ * library schedule the tasks that unwind the layer stacks after an
+ * application allocation failed.
+ */
+#ifndef IOTC_MEMORY_ACCOUNTING_SYSTEM_MEMORY_RESERVE
+#define IOTC_MEMORY_ACCOUNTING_SYSTEM_MEMORY_RESERVE 2048
+#endif
+
+/* Slot 0 collects the allocations not made on behalf of any context. */
+#define IOTC_MEMORY_ACCOUNTING_OWNER_NONE 0
+#define IOTC_MEMORY_ACCOUNTING_MAX_OWNERS \
+  (IOTC_MEMORY_ACCOUNTING_MAX_CONTEXTS + 1)
+
+/* the handle table holds at most 0xFFFE contexts, see iotc_handle.h */
+#if IOTC_MEMORY_ACCOUNTING_MAX_OWNERS > 0xFFFF
+#error "IOTC_MEMORY_ACCOUNTING_MAX_CONTEXTS doesn't fit the owner type"
+#endif
+
+typedef uint16_t iotc_memory_accounting_owner_t;
+
+typedef enum {
+  IOTC_MEMORY_ACCOUNTING_ALLOCATION_TYPE_APPLICATION = 0,
+  IOTC_MEMORY_ACCOUNTING_ALLOCATION_TYPE_SYSTEM,
+  IOTC_MEMORY_ACCOUNTING_ALLOCATION_TYPE_COUNT
+} iotc_memory_accounting_allocation_type_t;
+
+/**
+ * The only per-allocation overhead: the size of the block and the slot it is
+ * accounted to. The union keeps the returned pointer aligned the same way the
+ * platform allocator aligns it.
+ */
+typedef union iotc_memory_accounting_header_u {
+  struct {
+    size_t size;
+    iotc_memory_accounting_owner_t owner;
+  } entry;
+  void* align_ptr;
+  uint64_t align_u64;
+  long double align_ld;
+} iotc_memory_accounting_header_t;
+
+/**
+ * Usage counters of a single slot or of the whole library. Sizes include the
+ * allocation header.
+ */
+typedef struct iotc_memory_accounting_stats_s {
+  size_t current;
+  size_t peak;
+  size_t budget; /* 0 means no budget */
+  uint32_t allocations;
+  uint32_t frees;
+  uint32_t failures;
+} iotc_memory_accounting_stats_t;
+
+extern void* iotc_memory_accounting_alloc(
+    iotc_memory_accounting_allocation_type_t type, size_t size_to_alloc);
+
+extern void* iotc_memory_accounting_calloc(
+    iotc_memory_accounting_allocation_type_t type, size_t num,
+    size_t size_to_alloc);
+
+extern void* iotc_memory_accounting_realloc(
+    iotc_memory_accounting_allocation_type_t type, void* ptr,
+    size_t size_to_alloc);
+
+extern void iotc_memory_accounting_free(void* ptr);
+
+/* Facades with the signatures of the platform allocator. */
+extern void* iotc_memory_accounting_alloc_application(size_t size_to_alloc);
+extern void* iotc_memory_accounting_calloc_application(size_t num,
+                                                       size_t size_to_alloc);
+extern void* iotc_memory_accounting_realloc_application(void* ptr,
+                                                        size_t size_to_alloc);
+extern void* iotc_memory_accounting_alloc_system(size_t size_to_alloc);
+extern void* iotc_memory_accounting_calloc_system(size_t num,
+                                                  size_t size_to_alloc);
+extern void* iotc_memory_accounting_realloc_system(void* ptr,
+                                                   size_t size_to_alloc);
+
+/**
+ * @brief sets the limit of the memory used by the whole library, 0 disables
+ * the limit
+ */
+extern iotc_state_t iotc_memory_accounting_set_limit(const size_t limit);
+
+extern size_t iotc_memory_accounting_get_allocated_space();
+
+/**
+ * @brief sets the budget of a single slot, 0 disables the budget
+ *
+ * Only application allocations are checked against the budget.
+ */
+extern iotc_state_t iotc_memory_accounting_set_budget(
+    iotc_memory_accounting_owner_t owner, const size_t budget);
+
+/**
+ * @brief clears the budget and the counters of a slot a new context takes
+ *
+ * Blocks the previous context left allocated stay accounted to the slot until
+ * they are freed.
+ */
+extern iotc_state_t iotc_memory_accounting_reset_owner(
+    iotc_memory_accounting_owner_t owner);
+
+extern iotc_state_t iotc_memory_accounting_get_stats(
+    iotc_memory_accounting_owner_t owner,
+    iotc_memory_accounting_stats_t* out_stats);
+
+extern iotc_state_t iotc_memory_accounting_get_total_stats(
+    iotc_memory_accounting_stats_t* out_stats);
+
+/**
+ * @brief maps a context handle to its accounting slot
+ *
+ * The generation of the handle is not part of the slot, a stale handle maps to
+ * the slot of the context that reuses its handle table slot. The public API
+ * checks the handle against the context handle table first.
+ */
+extern iotc_memory_accounting_owner_t iotc_memory_accounting_owner_for_context(
+    iotc_context_handle_t context_handle);
+
+/**
+ * @brief makes the calling thread account new allocations to the owner
+ *
+ * @return the previous owner, to be restored when the scope ends
+ */
+extern iotc_memory_accounting_owner_t iotc_memory_accounting_set_owner(
+    iotc_memory_accounting_owner_t owner);
+
+extern iotc_memory_accounting_owner_t iotc_memory_accounting_get_owner();
+
+/**
+ * Scope macros for the public API entry points. Everything allocated between
+ * them, and every handle scheduled in between, is accounted to the context.
+ */
+#ifdef IOTC_MEMORY_ACCOUNTING_ENABLED
+#define IOTC_MEMORY_ACCOUNTING_ENTER_CONTEXT(context_handle) \
+  const iotc_memory_accounting_owner_t iotc_memory_accounting_prev_owner = \
+      iotc_memory_accounting_set_owner(                                     \
+          iotc_memory_accounting_owner_for_context(context_handle))
+#define IOTC_MEMORY_ACCOUNTING_LEAVE_CONTEXT() \
+  iotc_memory_accounting_set_owner(iotc_memory_accounting_prev_owner)
+#else
+#define IOTC_MEMORY_ACCOUNTING_ENTER_CONTEXT(context_handle)
+#define IOTC_MEMORY_ACCOUNTING_LEAVE_CONTEXT()
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __IOTC_MEMORY_ACCOUNTING_H__ */
@@ -19,11 +19,12 @@
 #include "iotc_coroutine.h"
 #include "iotc_layer_api.h"
 #include "iotc_layer_macros.h"
-#include "iotc_list.h"
 #include "iotc_mqtt_message.h"
 #include "iotc_mqtt_parser.h"
 #include "iotc_mqtt_serialiser.h"
+#include "iotc_queue.h"
 #include "iotc_tuples.h"
+#include "iotc_types_internal.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -37,11 +38,11 @@ static void clear_task_queue(void* context) {
       (iotc_mqtt_codec_layer_data_t*)IOTC_THIS_LAYER(context)->user_data;
 
   /* clean the queue */
-  while (layer_data->task_queue) {
+  while (!IOTC_QUEUE_EMPTY(layer_data->task_queue)) {
     iotc_mqtt_codec_layer_task_t* tmp_task = 0;
 
-    IOTC_LIST_POP(iotc_mqtt_codec_layer_task_t, layer_data->task_queue,
-                  tmp_task);
+    IOTC_QUEUE_POP_FRONT(iotc_mqtt_codec_layer_task_t, layer_data->task_queue,
+                         tmp_task);
 
     iotc_mqtt_written_data_t* written_data =
         (iotc_mqtt_written_data_t*)iotc_alloc_make_tuple(
@@ -54,7 +55,7 @@ static void clear_task_queue(void* context) {
   }
 
   /* POST_CONDITIONS */
-  assert(layer_data->task_queue == 0);
+  assert(IOTC_QUEUE_EMPTY(layer_data->task_queue));
 }
 
 iotc_state_t iotc_mqtt_codec_layer_push(void* context, void* data,
@@ -81,8 +82,7 @@ iotc_state_t iotc_mqtt_codec_layer_push(void* context, void* data,
     return IOTC_STATE_OK;
   }
 
-  iotc_mqtt_codec_layer_task_t* task =
-      (iotc_mqtt_codec_layer_task_t*)layer_data->task_queue;
+  iotc_mqtt_codec_layer_task_t* task = layer_data->task_queue.head;
 
   /* There can be only one task that is being sent.
    * If msg != 0 means that we have a notification from next layer. */
@@ -92,8 +92,8 @@ iotc_state_t iotc_mqtt_codec_layer_push(void* context, void* data,
 
     IOTC_CHECK_MEMORY(new_task, in_out_state);
 
-    IOTC_LIST_PUSH_BACK(iotc_mqtt_codec_layer_task_t, layer_data->task_queue,
-                        new_task);
+    IOTC_QUEUE_PUSH_BACK(iotc_mqtt_codec_layer_task_t, layer_data->task_queue,
+                         new_task);
 
     if (IOTC_CR_IS_RUNNING(layer_data->push_cs)) {
       return IOTC_STATE_OK;
@@ -194,6 +194,12 @@ finalise: /* Common part for all messages. */
   if (IOTC_STATE_WRITTEN == in_out_state) {
     iotc_debug_format("[m.id[%d] m.type[%d]] mqtt_codec_layer message sent",
                       layer_data->msg_id, layer_data->msg_type);
+
+    IOTC_CONTEXT_STATS_INC(IOTC_CONTEXT_DATA(context), messages_sent);
+
+    if (IOTC_MQTT_TYPE_PUBLISH == layer_data->msg_type) {
+      IOTC_CONTEXT_STATS_INC(IOTC_CONTEXT_DATA(context), publishes_sent);
+    }
   } else {
     iotc_debug_format("[m.id[%d] m.type[%d]] mqtt_codec_layer message not sent",
                       layer_data->msg_id, layer_data->msg_type);
@@ -218,14 +224,15 @@ finalise: /* Common part for all messages. */
 
   IOTC_PROCESS_PUSH_ON_NEXT_LAYER(context, written_data, in_out_state);
 
-  IOTC_LIST_POP(iotc_mqtt_codec_layer_task_t, layer_data->task_queue, task);
+  IOTC_QUEUE_POP_FRONT(iotc_mqtt_codec_layer_task_t, layer_data->task_queue,
+                       task);
 
   /* Release the task as it's no longer required. */
   iotc_mqtt_codec_layer_free_task(&task);
 
   /* Pop the next task and register it's execution. */
-  if (NULL != layer_data->task_queue) {
-    task = layer_data->task_queue;
+  if (!IOTC_QUEUE_EMPTY(layer_data->task_queue)) {
+    task = layer_data->task_queue.head;
 
     iotc_mqtt_message_t* msg_to_send =
         iotc_mqtt_codec_layer_activate_task(task);
@@ -307,6 +314,13 @@ iotc_state_t iotc_mqtt_codec_layer_pull(void* context, void* data,
 
   iotc_debug_mqtt_message_dump(layer_data->msg);
 
+  IOTC_CONTEXT_STATS_INC(IOTC_CONTEXT_DATA(context), messages_received);
+
+  if (IOTC_MQTT_TYPE_PUBLISH ==
+      layer_data->msg->common.common_u.common_bits.type) {
+    IOTC_CONTEXT_STATS_INC(IOTC_CONTEXT_DATA(context), publishes_received);
+  }
+
   iotc_mqtt_message_t* recvd = layer_data->msg;
   layer_data->msg = NULL;
 
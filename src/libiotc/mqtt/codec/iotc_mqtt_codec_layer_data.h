@@ -26,6 +26,7 @@ extern "C" {
 
 typedef struct iotc_mqtt_codec_layer_task_s {
   struct iotc_mqtt_codec_layer_task_s* __next;
+  struct iotc_mqtt_codec_layer_task_s* __prev;
   iotc_mqtt_message_t* msg;
   uint16_t msg_id;
   iotc_mqtt_type_t msg_type;
@@ -33,7 +34,10 @@ typedef struct iotc_mqtt_codec_layer_task_s {
 
 typedef struct iotc_mqtt_codec_layer_data_s {
   iotc_mqtt_message_t* msg;
-  iotc_mqtt_codec_layer_task_t* task_queue;
+  struct {
+    iotc_mqtt_codec_layer_task_t* head;
+    iotc_mqtt_codec_layer_task_t* tail;
+  } task_queue;
   iotc_mqtt_parser_t parser;
   iotc_state_t local_state;
   uint16_t msg_id;
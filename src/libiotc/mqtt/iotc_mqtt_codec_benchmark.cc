@@ -0,0 +1,188 @@
+/* Copyright 2018-2020 Google LLC
+ *
+ * This is part of the Google Cloud IoT Device SDK for Embedded C.
+ * It is licensed under the BSD 3-Clause license; you may not use this file
+ * except in compliance with the License.
+ *
+ * You may obtain a copy of the License at:
+ *  https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <string>
+#include <vector>
+
+#include "iotc_allocator.h"
+#include "iotc_data_desc.h"
+#include "iotc_mqtt_logic_layer_data_helpers.h"
+#include "iotc_mqtt_message.h"
+#include "iotc_mqtt_parser.h"
+#include "iotc_mqtt_serialiser.h"
+
+namespace iotctest {
+namespace {
+
+constexpr char kTopic[] = "/devices/benchmark-device/events";
+
+iotc_mqtt_message_t* NewMessage() {
+  return static_cast<iotc_mqtt_message_t*>(
+      iotc_calloc(1, sizeof(iotc_mqtt_message_t)));
+}
+
+// Serialises the PUBLISH header the way the codec layer does: the payload is
+// sent straight from the user's buffer so it is not part of the output.
+void BM_MqttSerialisePublish(benchmark::State& state) {
+  const std::vector<uint8_t> payload(state.range(0), 'x');
+  iotc_data_desc_t* content = iotc_make_desc_from_buffer_share(
+      const_cast<uint8_t*>(payload.data()), payload.size());
+
+  iotc_mqtt_message_t* msg = NewMessage();
+  fill_with_publish_data(msg, kTopic, content, IOTC_MQTT_QOS_AT_LEAST_ONCE,
+                         IOTC_MQTT_RETAIN_FALSE, IOTC_MQTT_DUP_FALSE, 17);
+
+  for (auto _ : state) {
+    iotc_mqtt_serialiser_t serialiser;
+    iotc_mqtt_serialiser_init(&serialiser);
+
+    size_t message_len = 0, remaining_len = 0, payload_len = 0;
+    iotc_mqtt_serialiser_size(&message_len, &remaining_len, &payload_len,
+                              &serialiser, msg);
+
+    iotc_data_desc_t* buffer =
+        iotc_make_empty_desc_alloc(message_len - payload_len);
+    iotc_mqtt_serialiser_write(&serialiser, msg, buffer, message_len,
+                               remaining_len);
+    benchmark::DoNotOptimize(buffer->data_ptr);
+    iotc_free_desc(&buffer);
+  }
+
+  iotc_mqtt_message_free(&msg);
+  iotc_free_desc(&content);
+}
+BENCHMARK(BM_MqttSerialisePublish)->Arg(16)->Arg(256)->Arg(4096);
+
+void BM_MqttSerialiseConnect(benchmark::State& state) {
+  iotc_mqtt_message_t* msg = NewMessage();
+  fill_with_connect_data(
+      msg, "unused",
+      "eyJhbGciOiJFUzI1NiIsInR5cCI6IkpXVCJ9.eyJpYXQiOjE1MTYyMzkwMjIsImV4cCI6"
+      "MTUxNjI0MjYyMiwiYXVkIjoiYmVuY2htYXJrLXByb2plY3QifQ.c2lnbmF0dXJl",
+      "projects/benchmark-project/locations/us-central1/registries/"
+      "benchmark-registry/devices/benchmark-device",
+      20, IOTC_SESSION_CLEAN, NULL, NULL, IOTC_MQTT_QOS_AT_MOST_ONCE,
+      IOTC_MQTT_RETAIN_FALSE);
+
+  for (auto _ : state) {
+    iotc_mqtt_serialiser_t serialiser;
+    iotc_mqtt_serialiser_init(&serialiser);
+
+    size_t message_len = 0, remaining_len = 0, payload_len = 0;
+    iotc_mqtt_serialiser_size(&message_len, &remaining_len, &payload_len,
+                              &serialiser, msg);
+
+    iotc_data_desc_t* buffer =
+        iotc_make_empty_desc_alloc(message_len - payload_len);
+    iotc_mqtt_serialiser_write(&serialiser, msg, buffer, message_len,
+                               remaining_len);
+    benchmark::DoNotOptimize(buffer->data_ptr);
+    iotc_free_desc(&buffer);
+  }
+
+  iotc_mqtt_message_free(&msg);
+}
+BENCHMARK(BM_MqttSerialiseConnect);
+
+// A QoS1 PUBLISH as the broker sends it, the fixed input of the parser.
+std::vector<uint8_t> MakePublishFrame(size_t payload_size) {
+  const std::string topic(kTopic);
+  size_t remaining_length = 2 + topic.size() + 2 + payload_size;
+
+  std::vector<uint8_t> frame = {0x32};
+  do {
+    uint8_t byte = remaining_length % 128;
+    remaining_length /= 128;
+    frame.push_back(remaining_length > 0 ? byte | 0x80 : byte);
+  } while (remaining_length > 0);
+
+  frame.push_back(topic.size() >> 8);
+  frame.push_back(topic.size() & 0xFF);
+  frame.insert(frame.end(), topic.begin(), topic.end());
+  frame.push_back(0x00);
+  frame.push_back(0x11);
+  frame.insert(frame.end(), payload_size, 'x');
+
+  return frame;
+}
+
+void BM_MqttParsePublish(benchmark::State& state) {
+  std::vector<uint8_t> frame = MakePublishFrame(state.range(0));
+
+  for (auto _ : state) {
+    iotc_mqtt_parser_t parser;
+    iotc_mqtt_parser_init(&parser);
+
+    iotc_mqtt_message_t* msg = NewMessage();
+    iotc_data_desc_t* data =
+        iotc_make_desc_from_buffer_share(frame.data(), frame.size());
+
+    const iotc_state_t state_parse =
+        iotc_mqtt_parser_execute(&parser, msg, data);
+    if (IOTC_STATE_OK != state_parse) {
+      state.SkipWithError("the PUBLISH frame did not parse");
+    }
+
+    iotc_free_desc(&data);
+    iotc_mqtt_message_free(&msg);
+  }
+
+  state.SetBytesProcessed(state.iterations() * frame.size());
+}
+BENCHMARK(BM_MqttParsePublish)->Arg(16)->Arg(256)->Arg(4096);
+
+// Looks up the handler of an incoming PUBLISH among the subscriptions, the
+// matching one being last.
+void BM_MqttMatchTopics(benchmark::State& state) {
+  const int subscriptions = static_cast<int>(state.range(0));
+
+  std::vector<std::string> topics(subscriptions);
+  std::vector<iotc_mqtt_task_specific_data_t> data(subscriptions);
+  for (int i = 0; i < subscriptions; ++i) {
+    topics[i] = "/devices/benchmark-device/commands/" + std::to_string(i);
+    data[i].subscribe.topic = &topics[i][0];
+  }
+  // the last subscription is the wildcard one
+  topics.back() = "/devices/benchmark-device/config/#";
+  data.back().subscribe.topic = &topics.back()[0];
+
+  iotc_data_desc_t* published =
+      iotc_make_desc_from_string_share("/devices/benchmark-device/config/42");
+
+  iotc_vector_selector_u published_selector;
+  published_selector.ptr_value = published;
+
+  for (auto _ : state) {
+    int index = -1;
+    for (int i = 0; i < subscriptions; ++i) {
+      iotc_vector_selector_u selector;
+      selector.ptr_value = &data[i];
+      if (0 == match_topics(&selector, &published_selector)) {
+        index = i;
+        break;
+      }
+    }
+    benchmark::DoNotOptimize(index);
+  }
+
+  iotc_free_desc(&published);
+}
+BENCHMARK(BM_MqttMatchTopics)->Arg(1)->Arg(8)->Arg(32);
+
+}  // namespace
+}  // namespace iotctest
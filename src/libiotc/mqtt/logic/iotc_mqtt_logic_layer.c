@@ -31,6 +31,9 @@
 #include "iotc_mqtt_message.h"
 #include "iotc_mqtt_parser.h"
 #include "iotc_mqtt_serialiser.h"
+#include "iotc_offline_queue.h"
+#include "iotc_queue.h"
+#include "iotc_session_store.h"
 #include "iotc_tuples.h"
 
 #ifdef __cplusplus
@@ -67,6 +70,88 @@ static void iotc_mqtt_logic_layer_task_make_context_null(
   task->logic.handlers.h4.a1 = NULL;
 }
 
+static iotc_state_t iotc_mqtt_logic_layer_q0_fast_publish_done(
+    void* context, iotc_state_t state) {
+  iotc_mqtt_logic_layer_data_t* layer_data =
+      (iotc_mqtt_logic_layer_data_t*)IOTC_THIS_LAYER(context)->user_data;
+
+  assert(1 == layer_data->q0_fast_publish_pending);
+
+  layer_data->q0_fast_publish_pending = 0;
+
+  iotc_mqtt_logic_defer_users_callback(
+      context, &layer_data->q0_fast_publish_callback,
+      (IOTC_STATE_WRITTEN == state) ? IOTC_STATE_OK : state);
+
+  /* the q0 tasks queued meanwhile */
+  return iotc_mqtt_logic_layer_run_next_q0_task(context);
+}
+
+uint8_t iotc_mqtt_logic_layer_can_publish_q0_fast(void* context,
+                                                  size_t payload_length) {
+  const iotc_mqtt_logic_layer_data_t* layer_data =
+      (iotc_mqtt_logic_layer_data_t*)IOTC_THIS_LAYER(context)->user_data;
+
+  if (IOTC_THIS_LAYER_NOT_OPERATIONAL(context) || NULL == layer_data ||
+      NULL == IOTC_CONTEXT_DATA(context)->connection_data ||
+      payload_length > IOTC_MQTT_MAX_PAYLOAD_SIZE) {
+    return 0;
+  }
+
+  return (IOTC_CONNECTION_STATE_OPENED ==
+              IOTC_CONTEXT_DATA(context)->connection_data->connection_state &&
+          NULL == layer_data->current_q0_task &&
+          IOTC_QUEUE_EMPTY(layer_data->q0_tasks_queue) &&
+          0 == layer_data->q0_fast_publish_pending)
+             ? 1
+             : 0;
+}
+
+iotc_state_t iotc_mqtt_logic_layer_publish_q0_fast(
+    void* context, char* topic, iotc_data_desc_t* data,
+    iotc_event_handle_t callback) {
+  IOTC_LAYER_FUNCTION_PRINT_FUNCTION_DIGEST();
+
+  /* PRECONDITIONS */
+  assert(NULL != topic);
+  assert(NULL != data);
+  assert(1 == iotc_mqtt_logic_layer_can_publish_q0_fast(context,
+                                                        data->length));
+
+  iotc_mqtt_logic_layer_data_t* layer_data =
+      (iotc_mqtt_logic_layer_data_t*)IOTC_THIS_LAYER(context)->user_data;
+
+  iotc_state_t state = IOTC_STATE_OK;
+  iotc_mqtt_message_t* msg = NULL;
+
+  IOTC_ALLOC_AT(iotc_mqtt_message_t, msg, state);
+
+  msg->common.common_u.common_bits.type = IOTC_MQTT_TYPE_PUBLISH;
+  msg->common.common_u.common_bits.qos = IOTC_MQTT_QOS_AT_MOST_ONCE;
+
+  IOTC_CHECK_MEMORY(
+      msg->publish.topic_name = iotc_make_desc_from_string_share(topic), state);
+
+  /* the descriptor takes over the topic, no second copy of it */
+  msg->publish.topic_name->memory_type = IOTC_MEMORY_TYPE_MANAGED;
+  topic = NULL;
+
+  /* the codec releases the message and the payload with it once written */
+  msg->publish.content = data;
+  data = NULL;
+
+  layer_data->q0_fast_publish_callback = callback;
+  layer_data->q0_fast_publish_pending = 1;
+
+  return IOTC_PROCESS_PUSH_ON_PREV_LAYER(context, msg, IOTC_STATE_OK);
+
+err_handling:
+  iotc_mqtt_message_free(&msg);
+  IOTC_SAFE_FREE(topic);
+  iotc_free_desc(&data);
+  return state;
+}
+
 iotc_state_t iotc_mqtt_logic_layer_push(void* context, void* data,
                                         iotc_state_t in_out_state) {
   IOTC_LAYER_FUNCTION_PRINT_FUNCTION_DIGEST();
@@ -103,10 +188,13 @@ iotc_state_t iotc_mqtt_logic_layer_push(void* context, void* data,
     IOTC_SAFE_FREE_TUPLE(written_data);
 
     iotc_mqtt_logic_task_t* task_to_be_called = NULL;
+    uint8_t q0_fast_publish_written = 0;
 
     if (0 == msg_id) {
-      /* This must have been a current_q0 task */
+      /* This must have been a current_q0 task or a fast QoS0 publish */
       task_to_be_called = layer_data->current_q0_task;
+      q0_fast_publish_written = (NULL == task_to_be_called &&
+                                 1 == layer_data->q0_fast_publish_pending);
     } else {
       iotc_mqtt_message_class_t msg_class =
           iotc_mqtt_class_msg_type_sending(msg_type);
@@ -115,10 +203,10 @@ iotc_state_t iotc_mqtt_logic_layer_push(void* context, void* data,
 
       switch (msg_class) {
         case IOTC_MQTT_MESSAGE_CLASS_FROM_SERVER:
-          task_queue = layer_data->q12_recv_tasks_queue;
+          task_queue = layer_data->q12_recv_tasks_queue.head;
           break;
         case IOTC_MQTT_MESSAGE_CLASS_TO_SERVER:
-          task_queue = layer_data->q12_tasks_queue;
+          task_queue = layer_data->q12_tasks_queue.head;
           break;
         case IOTC_MQTT_MESSAGE_CLASS_UNKNOWN:
           in_out_state = IOTC_MQTT_MESSAGE_CLASS_UNKNOWN_ERROR;
@@ -133,16 +221,15 @@ iotc_state_t iotc_mqtt_logic_layer_push(void* context, void* data,
                      msg_id, task_to_be_called);
     }
 
-    /* restart the layer keepalive task timer after every every successful
-     * send */
-    if (IOTC_STATE_WRITTEN == in_out_state &&
-        NULL != layer_data->keepalive_event.ptr_to_position) {
-      iotc_state_t local_state = iotc_evtd_restart(
-          IOTC_CONTEXT_DATA(context)->evtd_instance,
-          &layer_data->keepalive_event,
-          IOTC_CONTEXT_DATA(context)->connection_data->keepalive_timeout);
+    /* every successful send postpones the keepalive, the keepalive event
+     * checks the time when it expires */
+    if (IOTC_STATE_WRITTEN == in_out_state) {
+      layer_data->last_write_time =
+          IOTC_CONTEXT_DATA(context)->evtd_instance->current_step;
+    }
 
-      IOTC_CHECK_STATE(local_state);
+    if (1 == q0_fast_publish_written) {
+      return iotc_mqtt_logic_layer_q0_fast_publish_done(context, in_out_state);
     }
 
     if (task_to_be_called != 0) {
@@ -288,10 +375,12 @@ iotc_state_t iotc_mqtt_logic_layer_pull(void* context, void* data,
       /** pick proper msg queue */
       switch (msg_class) {
         case IOTC_MQTT_MESSAGE_CLASS_FROM_SERVER:
-          task_queue = layer_data->q12_recv_tasks_queue;
+          /* a PUBREL, part of receiving with QoS 2 which isn't supported, the
+           * received tasks only wait for their PUBACK to be written */
+          task_queue = NULL;
           break;
         case IOTC_MQTT_MESSAGE_CLASS_TO_SERVER:
-          task_queue = layer_data->q12_tasks_queue;
+          task_queue = layer_data->q12_tasks_queue.head;
           break;
         case IOTC_MQTT_MESSAGE_CLASS_UNKNOWN:
         default:
@@ -319,12 +408,19 @@ iotc_state_t iotc_mqtt_logic_layer_pull(void* context, void* data,
 
         return IOTC_MQTT_UNKNOWN_MESSAGE_ID;
       }
+    } else if (layer_data->current_q0_task == 0 ||
+               layer_data->current_q0_task->logic.handle_type ==
+                   IOTC_EVENT_HANDLE_UNSET) {
+      /* the broker sent e.g. a PINGRESP or a CONNACK nobody waits for, drop
+       * it the same way as a message of an unknown id */
+      iotc_debug_format("Error, no task waits for message type: %d",
+                        recvd_msg->common.common_u.common_bits.type);
+
+      iotc_debug_mqtt_message_dump(recvd_msg);
+      iotc_mqtt_message_free(&recvd_msg);
+
+      return IOTC_MQTT_UNKNOWN_MESSAGE_ID;
     } else {
-      /* sanity checks */
-      assert(layer_data->current_q0_task != 0);
-      assert(layer_data->current_q0_task->logic.handle_type !=
-             IOTC_EVENT_HANDLE_UNSET);
-
       layer_data->current_q0_task->logic.handlers.h4.a4 = recvd_msg;
       layer_data->current_q0_task->logic.handlers.h4.a3 = in_out_state;
 
@@ -337,6 +433,51 @@ err_handling:
   return in_out_state;
 }
 
+/* Turns the publishes a previous run of the application left in the session
+ * log into tasks. They wait in the q12 queue, like the ones kept in memory,
+ * until the CONNACK resends them. */
+static void iotc_mqtt_logic_layer_adopt_restored_publishes(
+    void* context, iotc_mqtt_logic_layer_data_t* layer_data) {
+  iotc_session_store_t* session_store =
+      &IOTC_CONTEXT_DATA(context)->session_store;
+  iotc_session_store_entry_t* entry = NULL;
+
+  while (NULL != (entry = iotc_session_store_adopt_restored(session_store))) {
+    char* topic = NULL;
+    iotc_data_desc_t* data = NULL;
+    iotc_mqtt_logic_task_t* task = NULL;
+    const uint16_t msg_id = entry->msg_id;
+
+    if (IOTC_STATE_OK ==
+        iotc_session_store_entry_publish(entry, &topic, &data)) {
+      /* whoever waited for the result is gone, there's no callback */
+      task = iotc_mqtt_logic_make_publish_task(
+          topic, data, IOTC_MQTT_QOS_AT_LEAST_ONCE, (iotc_mqtt_retain_t)0,
+          iotc_make_empty_handle());
+    }
+
+    IOTC_SAFE_FREE(topic);
+
+    if (NULL == task) {
+      iotc_free_desc(&data);
+      iotc_session_store_record_ack(session_store, msg_id);
+      continue;
+    }
+
+    task->msg_id = msg_id;
+    task->session_state = IOTC_MQTT_LOGIC_TASK_SESSION_STORE;
+    task->logic = iotc_make_handle(&do_mqtt_publish_q1, context, task,
+                                   IOTC_STATE_OK, 0);
+
+    IOTC_QUEUE_PUSH_BACK(iotc_mqtt_logic_task_t, layer_data->q12_tasks_queue,
+                         task);
+
+    if (msg_id > layer_data->last_msg_id) {
+      layer_data->last_msg_id = msg_id;
+    }
+  }
+}
+
 iotc_state_t iotc_mqtt_logic_layer_init(void* context, void* data,
                                         iotc_state_t in_out_state) {
   IOTC_LAYER_FUNCTION_PRINT_FUNCTION_DIGEST();
@@ -369,13 +510,16 @@ iotc_state_t iotc_mqtt_logic_layer_init(void* context, void* data,
 
     /* same story goes with the qos1&2 unacked messages what we have to do is to
      * re-plug them into the queue and connect task will restart the tasks */
-    layer_data->q12_tasks_queue =
-        context_data->copy_of_q12_unacked_messages_queue;
+    IOTC_QUEUE_ATTACH(iotc_mqtt_logic_task_t, layer_data->q12_tasks_queue,
+                      (iotc_mqtt_logic_task_t*)
+                          context_data->copy_of_q12_unacked_messages_queue);
     context_data->copy_of_q12_unacked_messages_queue = NULL;
 
     /* restoring the last_msg_id */
     layer_data->last_msg_id = context_data->copy_of_last_msg_id;
     context_data->copy_of_last_msg_id = 0;
+
+    iotc_mqtt_logic_layer_adopt_restored_publishes(context, layer_data);
   } else {
     if (NULL != context_data->copy_of_handlers_for_topics) {
       iotc_vector_for_each(context_data->copy_of_handlers_for_topics,
@@ -434,23 +578,102 @@ err_handling:
   return in_out_state;
 }
 
-iotc_state_t iotc_mqtt_logic_layer_post_connect(void* context, void* data,
-                                                iotc_state_t in_out_state) {
-  IOTC_LAYER_FUNCTION_PRINT_FUNCTION_DIGEST();
-
+iotc_state_t iotc_mqtt_logic_layer_drain_offline_queue(void* context) {
   const iotc_mqtt_logic_layer_data_t* layer_data =
       (iotc_mqtt_logic_layer_data_t*)IOTC_THIS_LAYER(context)->user_data;
 
-  if (NULL == layer_data) {
-    return in_out_state;
+  /* closed again before the drain got its turn, keep them for the next
+   * CONNACK */
+  if (IOTC_THIS_LAYER_NOT_OPERATIONAL(context) || NULL == layer_data ||
+      NULL == IOTC_CONTEXT_DATA(context)->connection_data ||
+      IOTC_CONNECTION_STATE_OPENED !=
+          IOTC_CONTEXT_DATA(context)->connection_data->connection_state) {
+    return IOTC_STATE_OK;
   }
 
-  /* set new context and send timeout which will make the qos12 tasks to
-   * continue they work just where they were stopped */
-  IOTC_LIST_FOREACH_WITH_ARG(iotc_mqtt_logic_task_t,
-                             layer_data->q12_tasks_queue,
-                             set_new_context_and_call_resend, context);
+  iotc_offline_queue_t* offline_queue =
+      &IOTC_CONTEXT_DATA(context)->offline_queue;
+  iotc_offline_message_t* message = NULL;
+
+  while (NULL != (message = iotc_offline_queue_pop(offline_queue))) {
+    iotc_mqtt_logic_task_t* task = iotc_mqtt_logic_make_publish_task(
+        message->topic, message->data, message->qos, (iotc_mqtt_retain_t)0,
+        message->callback);
+
+    if (NULL == task) {
+      iotc_mqtt_logic_defer_users_callback(context, &message->callback,
+                                           IOTC_OUT_OF_MEMORY);
+      iotc_offline_queue_free_message(&message);
+      continue;
+    }
+
+    /* the task owns the payload now */
+    message->data = NULL;
+    iotc_offline_queue_free_message(&message);
+
+    iotc_mqtt_logic_layer_push(context, task, IOTC_STATE_OK);
+  }
 
+  return IOTC_STATE_OK;
+}
+
+iotc_layer_t* iotc_mqtt_logic_layer_find(iotc_layer_chain_t* layer_chain) {
+  iotc_layer_t* layer = layer_chain->top;
+
+  while (NULL != layer &&
+         &iotc_mqtt_logic_layer_push != layer->layer_funcs->push) {
+    layer = layer->layer_connection.prev;
+  }
+
+  return layer;
+}
+
+static void iotc_mqtt_logic_layer_remove_topic_handlers(
+    iotc_vector_t* handlers_for_topics, const char* topic_prefix) {
+  const size_t topic_prefix_len = strlen(topic_prefix);
+  iotc_vector_index_type_t i = handlers_for_topics->elem_no - 1;
+
+  /* backwards, the deleted element is replaced with the last one */
+  for (; i >= 0; --i) {
+    iotc_mqtt_task_specific_data_t* subscribe_data =
+        (iotc_mqtt_task_specific_data_t*)handlers_for_topics->array[i]
+            .selector_t.ptr_value;
+
+    if (0 == strncmp(subscribe_data->subscribe.topic, topic_prefix,
+                     topic_prefix_len)) {
+      iotc_mqtt_task_spec_data_free_subscribe_data(&subscribe_data);
+      iotc_vector_del(handlers_for_topics, i);
+    }
+  }
+}
+
+iotc_state_t iotc_mqtt_logic_layer_unregister_topic_handlers(
+    void* context, void* topic_prefix) {
+  iotc_mqtt_logic_layer_data_t* layer_data =
+      (iotc_mqtt_logic_layer_data_t*)IOTC_THIS_LAYER(context)->user_data;
+  iotc_context_data_t* context_data = IOTC_CONTEXT_DATA(context);
+
+  if (NULL != layer_data && NULL != layer_data->handlers_for_topics) {
+    iotc_mqtt_logic_layer_remove_topic_handlers(
+        layer_data->handlers_for_topics, (const char*)topic_prefix);
+  }
+
+  if (NULL != context_data->copy_of_handlers_for_topics) {
+    iotc_mqtt_logic_layer_remove_topic_handlers(
+        context_data->copy_of_handlers_for_topics, (const char*)topic_prefix);
+  }
+
+  IOTC_SAFE_FREE(topic_prefix);
+
+  return IOTC_STATE_OK;
+}
+
+iotc_state_t iotc_mqtt_logic_layer_post_connect(void* context, void* data,
+                                                iotc_state_t in_out_state) {
+  IOTC_LAYER_FUNCTION_PRINT_FUNCTION_DIGEST();
+
+  /* the qos12 tasks of a continued session are resumed by the CONNACK, see
+   * do_mqtt_connect */
   return iotc_layer_default_post_connect(context, data, in_out_state);
 }
 
@@ -482,6 +705,13 @@ static void iotc_mqtt_logic_task_queue_shutdown(
     assert(NULL != tmp_task);
     assert(NULL == tmp_task->timeout.ptr_to_position);
 
+    /* a task that didn't get to send its PUBACK still owns the publish */
+    if (IOTC_MQTT_PUBACK == tmp_task->data.mqtt_settings.scenario) {
+      iotc_mqtt_message_t* recvd_msg =
+          (iotc_mqtt_message_t*)tmp_task->logic.handlers.h4.a4;
+      iotc_mqtt_message_free(&recvd_msg);
+    }
+
     iotc_mqtt_logic_free_task(&tmp_task);
   }
 
@@ -517,11 +747,11 @@ iotc_state_t iotc_mqtt_logic_layer_close_externally(void* context, void* data,
 
   /* disable timeouts of all tasks */
   IOTC_LIST_FOREACH_WITH_ARG(iotc_mqtt_logic_task_t,
-                             layer_data->q12_tasks_queue, cancel_task_timeout,
-                             context);
+                             layer_data->q12_tasks_queue.head,
+                             cancel_task_timeout, context);
 
   IOTC_LIST_FOREACH_WITH_ARG(iotc_mqtt_logic_task_t,
-                             layer_data->q12_recv_tasks_queue,
+                             layer_data->q12_recv_tasks_queue.head,
                              cancel_task_timeout, context);
 
   /* if clean session not set check if we have anything to copy */
@@ -548,15 +778,16 @@ iotc_state_t iotc_mqtt_logic_layer_close_externally(void* context, void* data,
     /* we have to filter it in order to see which one has already been started
      */
     /* we will construct new list out of them */
-    iotc_mqtt_logic_task_t* unacked_list = NULL;
+    iotc_mqtt_logic_task_queue_t unacked_queue;
+    IOTC_QUEUE_INIT(unacked_queue);
 
-    IOTC_LIST_SPLIT_I(iotc_mqtt_logic_task_t, layer_data->q12_tasks_queue,
-                      iotc_mqtt_logic_layer_task_should_be_stored_predicate,
-                      context, unacked_list);
+    IOTC_QUEUE_SPLIT_I(iotc_mqtt_logic_task_t, layer_data->q12_tasks_queue,
+                       iotc_mqtt_logic_layer_task_should_be_stored_predicate,
+                       context, unacked_queue);
 
-    context_data->copy_of_q12_unacked_messages_queue = unacked_list;
+    context_data->copy_of_q12_unacked_messages_queue = unacked_queue.head;
 
-    IOTC_LIST_FOREACH(iotc_mqtt_logic_task_t, unacked_list,
+    IOTC_LIST_FOREACH(iotc_mqtt_logic_task_t, unacked_queue.head,
                       iotc_mqtt_logic_layer_task_make_context_null);
   }
 
@@ -580,6 +811,13 @@ iotc_state_t iotc_mqtt_logic_layer_close_externally(void* context, void* data,
     iotc_mqtt_logic_free_task(&layer_data->current_q0_task);
   }
 
+  /* the write of the fast QoS0 publish won't be confirmed anymore */
+  if (1 == layer_data->q0_fast_publish_pending) {
+    layer_data->q0_fast_publish_pending = 0;
+    iotc_mqtt_logic_defer_users_callback(
+        context, &layer_data->q0_fast_publish_callback, IOTC_STATE_TIMEOUT);
+  }
+
   /* unregister keepalive */
   if (NULL != layer_data->keepalive_event.ptr_to_position) {
     iotc_evtd_cancel(event_dispatcher, &layer_data->keepalive_event);
@@ -590,9 +828,10 @@ iotc_state_t iotc_mqtt_logic_layer_close_externally(void* context, void* data,
 
   /* save queues */
   iotc_mqtt_logic_task_t* current_q0 = layer_data->current_q0_task;
-  iotc_mqtt_logic_task_t* q12_queue = layer_data->q12_tasks_queue;
-  iotc_mqtt_logic_task_t* q12_recv_queue = layer_data->q12_recv_tasks_queue;
-  iotc_mqtt_logic_task_t* q0_queue = layer_data->q0_tasks_queue;
+  iotc_mqtt_logic_task_t* q12_queue = layer_data->q12_tasks_queue.head;
+  iotc_mqtt_logic_task_t* q12_recv_queue =
+      layer_data->q12_recv_tasks_queue.head;
+  iotc_mqtt_logic_task_t* q0_queue = layer_data->q0_tasks_queue.head;
 
   /* destroy user's data */
   IOTC_SAFE_FREE(IOTC_THIS_LAYER(context)->user_data);
@@ -18,7 +18,10 @@
 #define __IOTC_MQTT_LOGIC_LAYER_H__
 
 #include "iotc_common.h"
+#include "iotc_data_desc.h"
+#include "iotc_event_handle.h"
 #include "iotc_layer.h"
+#include "iotc_layer_chain.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -45,6 +48,60 @@ iotc_state_t iotc_mqtt_logic_layer_close(void* context, void* data,
 iotc_state_t iotc_mqtt_logic_layer_close_externally(void* context, void* data,
                                                     iotc_state_t state);
 
+/**
+ * @brief iotc_mqtt_logic_layer_can_publish_q0_fast
+ *
+ * Returns 1 if a QoS0 PUBLISH of the given payload size can skip the logic
+ * task: the connection is open and no other QoS0 message is queued or being
+ * sent. Reads the state of the layer, so it must run on the context's event
+ * loop.
+ */
+uint8_t iotc_mqtt_logic_layer_can_publish_q0_fast(void* context,
+                                                  size_t payload_length);
+
+/**
+ * @brief iotc_mqtt_logic_layer_publish_q0_fast
+ *
+ * Passes the QoS0 PUBLISH straight to the codec without allocating a logic
+ * task. Takes the ownership of topic and data. The callback is deferred with
+ * the result of the write, the same way as for the task path. Must run on
+ * the context's event loop.
+ */
+iotc_state_t iotc_mqtt_logic_layer_publish_q0_fast(void* context,
+                                                   char* topic,
+                                                   iotc_data_desc_t* data,
+                                                   iotc_event_handle_t callback);
+
+/**
+ * @brief iotc_mqtt_logic_layer_drain_offline_queue
+ *
+ * Turns the publishes stored in the context's offline queue into tasks, in
+ * the order they were published. Scheduled right after a successful CONNACK;
+ * does nothing if the connection is not open anymore.
+ */
+iotc_state_t iotc_mqtt_logic_layer_drain_offline_queue(void* context);
+
+/**
+ * @brief iotc_mqtt_logic_layer_find
+ *
+ * Returns the MQTT logic layer of the chain or NULL if there is none. The
+ * logic layer is not necessarily the top one, the control topic layer sits
+ * on it in the default stack.
+ */
+iotc_layer_t* iotc_mqtt_logic_layer_find(iotc_layer_chain_t* layer_chain);
+
+/**
+ * @brief iotc_mqtt_logic_layer_unregister_topic_handlers
+ *
+ * Drops the subscription handlers of the topics starting with topic_prefix,
+ * the messages received on them are discarded from then on. Covers the
+ * handlers kept for the next connection of a persistent session too. Takes
+ * the ownership of topic_prefix, meant to be scheduled on the event
+ * dispatcher.
+ */
+iotc_state_t iotc_mqtt_logic_layer_unregister_topic_handlers(
+    void* context, void* topic_prefix);
+
 #ifdef __cplusplus
 }
 #endif
@@ -24,6 +24,7 @@
 #include "iotc_io_timeouts.h"
 #include "iotc_jwt.h"
 #include "iotc_layer_api.h"
+#include "iotc_mqtt_logic_layer.h"
 #include "iotc_mqtt_logic_layer_data.h"
 #include "iotc_mqtt_logic_layer_data_helpers.h"
 #include "iotc_mqtt_logic_layer_task_helpers.h"
@@ -34,6 +35,7 @@ extern "C" {
 #endif
 
 #include "iotc_mqtt_logic_layer_keepalive_handler.h"
+#include "iotc_types_internal.h"
 
 static inline iotc_state_t get_error_from_connack(int return_code) {
   switch (return_code) {
@@ -68,6 +70,16 @@ static inline iotc_event_handle_return_t do_mqtt_connect_timeout(
                           context->self->context_data->io_timeouts);
   assert(NULL == task->timeout.ptr_to_position);
 
+  /* The broker is still sending, wait for the rest of the timeout. */
+  if (1 == iotc_io_timeouts_postpone(
+               IOTC_CONTEXT_DATA(context)->evtd_instance,
+               iotc_make_handle(&do_mqtt_connect_timeout, context, task),
+               IOTC_CONTEXT_DATA(context)->connection_data->connection_timeout,
+               IOTC_CONTEXT_DATA(context)->io_last_read_time,
+               context->self->context_data->io_timeouts, &task->timeout)) {
+    return IOTC_STATE_OK;
+  }
+
   IOTC_PROCESS_CONNECT_ON_NEXT_LAYER(context, arg2, IOTC_STATE_TIMEOUT);
 
   IOTC_CR_EXIT(task->cs, iotc_mqtt_logic_layer_finalize_task(context, task));
@@ -112,8 +124,12 @@ static inline iotc_state_t do_mqtt_connect(
           IOTC_CONTEXT_DATA(context)->connection_data->will_retain));
 
   if (IOTC_CONTEXT_DATA(context)->connection_data->connection_timeout > 0) {
+    /* the reads of a previous connection don't postpone this timeout */
+    IOTC_CONTEXT_DATA(context)->io_last_read_time =
+        event_dispatcher->current_step;
+
     state = iotc_io_timeouts_create(
-        iotc_globals.evtd_instance,
+        event_dispatcher,
         iotc_make_handle(&do_mqtt_connect_timeout, context, task),
         IOTC_CONTEXT_DATA(context)->connection_data->connection_timeout,
         context->self->context_data->io_timeouts, &task->timeout);
@@ -143,7 +159,7 @@ static inline iotc_state_t do_mqtt_connect(
   if (msg_memory->common.common_u.common_bits.type == IOTC_MQTT_TYPE_CONNACK) {
     /* Cancel the io timeout. */
     if (NULL != task->timeout.ptr_to_position) {
-      iotc_io_timeouts_cancel(iotc_globals.evtd_instance, &task->timeout,
+      iotc_io_timeouts_cancel(event_dispatcher, &task->timeout,
                               IOTC_CONTEXT_DATA(context)->io_timeouts);
       assert(NULL == task->timeout.ptr_to_position);
     }
@@ -165,6 +181,27 @@ static inline iotc_state_t do_mqtt_connect(
       IOTC_CONTEXT_DATA(context)->connection_data->connection_state =
           IOTC_CONNECTION_STATE_OPENED;
 
+      IOTC_CONTEXT_STATS_CONNECTED(IOTC_CONTEXT_DATA(context));
+
+      /* Set the new context and resend, the unacknowledged qos12 tasks of a
+       * continued session go on just where they were stopped. */
+      if (IOTC_SESSION_CONTINUE ==
+          IOTC_CONTEXT_DATA(context)->connection_data->session_type) {
+        IOTC_LIST_FOREACH_WITH_ARG(iotc_mqtt_logic_task_t,
+                                   layer_data->q12_tasks_queue.head,
+                                   set_new_context_and_call_resend, context);
+      }
+
+      /* The publishes stored while offline go out ahead of the ones the
+       * application makes from its connection callback. */
+      if (0 == iotc_offline_queue_is_empty(
+                   &IOTC_CONTEXT_DATA(context)->offline_queue)) {
+        iotc_evtd_execute(
+            event_dispatcher,
+            iotc_make_handle(&iotc_mqtt_logic_layer_drain_offline_queue,
+                             context));
+      }
+
       /* Inform the next layer about a state change. */
       IOTC_PROCESS_CONNECT_ON_NEXT_LAYER(context, data, state);
 
@@ -183,7 +220,7 @@ static inline iotc_state_t do_mqtt_connect(
 
       /* Cancel io timeout. */
       if (NULL != task->timeout.ptr_to_position) {
-        iotc_io_timeouts_cancel(iotc_globals.evtd_instance, &task->timeout,
+        iotc_io_timeouts_cancel(event_dispatcher, &task->timeout,
                                 IOTC_CONTEXT_DATA(context)->io_timeouts);
         assert(NULL == task->timeout.ptr_to_position);
       }
@@ -197,7 +234,7 @@ static inline iotc_state_t do_mqtt_connect(
 
   /* Cancel io timeout. */
   if (NULL != task->timeout.ptr_to_position) {
-    iotc_io_timeouts_cancel(iotc_globals.evtd_instance, &task->timeout,
+    iotc_io_timeouts_cancel(event_dispatcher, &task->timeout,
                             IOTC_CONTEXT_DATA(context)->io_timeouts);
     assert(NULL == task->timeout.ptr_to_position);
   }
@@ -209,7 +246,7 @@ err_handling:
 
   /* Cancel io timeout. */
   if (NULL != task->timeout.ptr_to_position) {
-    iotc_io_timeouts_cancel(iotc_globals.evtd_instance, &task->timeout,
+    iotc_io_timeouts_cancel(event_dispatcher, &task->timeout,
                             IOTC_CONTEXT_DATA(context)->io_timeouts);
     assert(NULL == task->timeout.ptr_to_position);
   }
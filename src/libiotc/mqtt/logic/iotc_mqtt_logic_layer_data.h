@@ -78,16 +78,26 @@ typedef enum {
 
 typedef struct iotc_mqtt_logic_task_s {
   struct iotc_mqtt_logic_task_s* __next;
+  struct iotc_mqtt_logic_task_s* __prev;
   iotc_time_event_handle_t timeout;
   iotc_event_handle_t logic;
   iotc_event_handle_t callback;
   iotc_mqtt_logic_task_data_t data;
   iotc_mqtt_logic_task_priority_t priority;
   iotc_mqtt_logic_task_session_state_t session_state;
+  /* when a QoS1 PUBLISH was first written, 0 once it was retransmitted and
+   * its PUBACK can't be told apart any more */
+  iotc_time_t sent_time_ms;
   uint16_t cs;
   uint16_t msg_id;
 } iotc_mqtt_logic_task_t;
 
+/* see iotc_queue.h */
+typedef struct {
+  iotc_mqtt_logic_task_t* head;
+  iotc_mqtt_logic_task_t* tail;
+} iotc_mqtt_logic_task_queue_t;
+
 typedef struct {
   /* Here we are going to store the mapping of the
    * handle functions versus the subscribed topics
@@ -95,12 +105,18 @@ typedef struct {
    * for each of the subscribed topics. */
 
   /* Handle to the user idle function that suppose to. */
-  iotc_mqtt_logic_task_t* q12_tasks_queue;
-  iotc_mqtt_logic_task_t* q12_recv_tasks_queue;
-  iotc_mqtt_logic_task_t* q0_tasks_queue;
+  iotc_mqtt_logic_task_queue_t q12_tasks_queue;
+  iotc_mqtt_logic_task_queue_t q12_recv_tasks_queue;
+  iotc_mqtt_logic_task_queue_t q0_tasks_queue;
   iotc_mqtt_logic_task_t* current_q0_task;
+  /* callback of the QoS0 PUBLISH sent without a task, while it is pending
+   * no q0 task is started, see iotc_mqtt_logic_layer_publish_q0_fast */
+  iotc_event_handle_t q0_fast_publish_callback;
+  uint8_t q0_fast_publish_pending;
   iotc_vector_t* handlers_for_topics;
   iotc_time_event_handle_t keepalive_event;
+  /* the keepalive event is postponed against it when it expires */
+  iotc_time_t last_write_time;
   uint16_t last_msg_id;
 } iotc_mqtt_logic_layer_data_t;
 
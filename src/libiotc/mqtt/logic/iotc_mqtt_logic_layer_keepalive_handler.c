@@ -15,12 +15,16 @@
  */
 
 #include "iotc_mqtt_logic_layer_keepalive_handler.h"
+#include <iotc_bsp_time.h>
 #include "iotc_coroutine.h"
 #include "iotc_globals.h"
+#include "iotc_io_timeouts.h"
 #include "iotc_layer_api.h"
 #include "iotc_mqtt_logic_layer.h"
 #include "iotc_mqtt_logic_layer_data.h"
 #include "iotc_mqtt_logic_layer_helpers.h"
+#include "iotc_rtt_estimator.h"
+#include "iotc_types_internal.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -39,6 +43,16 @@ iotc_state_t do_mqtt_keepalive_once(void* data) {
 
   layer_data->keepalive_event.ptr_to_position = NULL;
 
+  /* Something was sent within the keepalive period, no PINGREQ needed yet. */
+  if (1 == iotc_io_timeouts_postpone(
+               IOTC_CONTEXT_DATA(context)->evtd_instance,
+               iotc_make_handle(&do_mqtt_keepalive_once, context),
+               IOTC_CONTEXT_DATA(context)->connection_data->keepalive_timeout,
+               layer_data->last_write_time, NULL,
+               &layer_data->keepalive_event)) {
+    return IOTC_STATE_OK;
+  }
+
   IOTC_ALLOC(iotc_mqtt_logic_task_t, task, state);
 
   task->data.mqtt_settings.scenario = IOTC_MQTT_KEEPALIVE;
@@ -84,11 +98,14 @@ iotc_state_t do_mqtt_keepalive_task(void* ctx, void* data, iotc_state_t state,
 
   if (state == IOTC_STATE_WRITTEN) {
     iotc_debug_logger("pingreq message sent... waiting for response");
+    iotc_rtt_estimator_pingreq_sent(
+        &IOTC_CONTEXT_DATA(context)->rtt_estimator,
+        iotc_bsp_time_getcurrenttime_milliseconds());
   } else {
     iotc_debug_format("pingreq message has not been sent... %d", (int)state);
   }
 
-  /* Wait for an interval of keepalive. */
+  /* Wait for the PINGRESP, at most an interval of keepalive. */
   {
     assert(NULL == task->timeout.ptr_to_position);
 
@@ -96,7 +113,10 @@ iotc_state_t do_mqtt_keepalive_task(void* ctx, void* data, iotc_state_t state,
         event_dispatcher,
         iotc_make_handle(&on_keepalive_timeout_expiry, context, task, state,
                          msg_memory),
-        IOTC_CONTEXT_DATA(context)->connection_data->keepalive_timeout,
+        iotc_rtt_estimator_timeout(
+            &IOTC_CONTEXT_DATA(context)->rtt_estimator,
+            IOTC_RTT_PINGRESP_MIN_TIMEOUT_SEC,
+            IOTC_CONTEXT_DATA(context)->connection_data->keepalive_timeout),
         &task->timeout);
 
     IOTC_CHECK_STATE(state);
@@ -119,6 +139,15 @@ iotc_state_t do_mqtt_keepalive_task(void* ctx, void* data, iotc_state_t state,
 
   if (msg_memory->common.common_u.common_bits.type == IOTC_MQTT_TYPE_PINGRESP) {
     iotc_debug_logger("PINGRESP received...");
+
+    const int64_t rtt_ms = iotc_rtt_estimator_pingresp_received(
+        &IOTC_CONTEXT_DATA(context)->rtt_estimator,
+        iotc_bsp_time_getcurrenttime_milliseconds());
+
+    if (0 <= rtt_ms) {
+      IOTC_CONTEXT_STATS_SET(IOTC_CONTEXT_DATA(context), keepalive_rtt_ms,
+                             (uint32_t)rtt_ms);
+    }
   } else {
     iotc_debug_format("PINGRESP expected got: %d",
                       msg_memory->common.common_u.common_bits.type);
@@ -118,6 +118,19 @@ static inline iotc_state_t on_publish_q1_recieved(
   /* If task doesn't exist create and register one. */
   if (NULL == task) {
     uint16_t msg_id = msg->publish.message_id;
+    iotc_mqtt_logic_task_t* pending_task = NULL;
+
+    IOTC_LIST_FIND(iotc_mqtt_logic_task_t,
+                   layer_data->q12_recv_tasks_queue.head, CMP_TASK_MSG_ID,
+                   msg_id, pending_task);
+
+    /* A redelivery of a publish whose PUBACK is still on its way, the pending
+     * task acknowledges the id. */
+    if (NULL != pending_task) {
+      iotc_debug_format("[m.id[%d]] dropping the redelivered publish", msg_id);
+      iotc_mqtt_message_free(&msg);
+      return IOTC_STATE_OK;
+    }
 
     IOTC_ALLOC_AT(iotc_mqtt_logic_task_t, task, state);
 
@@ -129,21 +142,8 @@ static inline iotc_state_t on_publish_q1_recieved(
 
     task->msg_id = msg_id;
 
-/* @TODO: change this into debug only compilation. */
-#if 1
-    {
-      iotc_mqtt_logic_task_t* test_task = NULL;
-
-      IOTC_LIST_FIND(iotc_mqtt_logic_task_t, layer_data->q12_recv_tasks_queue,
-                     CMP_TASK_MSG_ID, task->msg_id, test_task);
-
-      // there must not be similar tasks
-      assert(NULL == test_task);
-    }
-#endif
-
-    IOTC_LIST_PUSH_BACK(iotc_mqtt_logic_task_t,
-                        layer_data->q12_recv_tasks_queue, task);
+    IOTC_QUEUE_PUSH_BACK(iotc_mqtt_logic_task_t,
+                         layer_data->q12_recv_tasks_queue, task);
   }
 
   IOTC_CR_START(task->cs);
@@ -170,8 +170,8 @@ static inline iotc_state_t on_publish_q1_recieved(
   /* Msg sent now proceed with cleaning. */
 
   /* Clean the created task data. */
-  IOTC_LIST_DROP(iotc_mqtt_logic_task_t, layer_data->q12_recv_tasks_queue,
-                 task);
+  IOTC_QUEUE_UNLINK(iotc_mqtt_logic_task_t, layer_data->q12_recv_tasks_queue,
+                    task);
 
   iotc_mqtt_logic_free_task(&task);
 
@@ -216,6 +216,9 @@ static inline iotc_state_t on_publish_recieved(
       break;
   }
 
+  /* dropped, nothing took the ownership of the message */
+  iotc_mqtt_message_free(&msg_memory);
+
   return IOTC_STATE_OK;
 }
 
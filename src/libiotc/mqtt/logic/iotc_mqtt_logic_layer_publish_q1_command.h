@@ -17,6 +17,7 @@
 #ifndef __IOTC_MQTT_LOGIC_LAYER_PUBLISH_Q1_COMMAND_H__
 #define __IOTC_MQTT_LOGIC_LAYER_PUBLISH_Q1_COMMAND_H__
 
+#include <iotc_bsp_time.h>
 #include "iotc_coroutine.h"
 #include "iotc_globals.h"
 #include "iotc_layer_api.h"
@@ -24,6 +25,9 @@
 #include "iotc_mqtt_logic_layer_data_helpers.h"
 #include "iotc_mqtt_logic_layer_task_helpers.h"
 #include "iotc_mqtt_message.h"
+#include "iotc_rtt_estimator.h"
+#include "iotc_session_store.h"
+#include "iotc_types_internal.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -63,6 +67,13 @@ static iotc_state_t do_mqtt_publish_q1(
   do {
     iotc_debug_format("[m.id[%d]]publish q1 preparing message", task->msg_id);
 
+    if (IOTC_STATE_RESEND == state) {
+      IOTC_CONTEXT_STATS_INC(IOTC_CONTEXT_DATA(context), qos1_retransmits);
+
+      /* Karn's algorithm, the PUBACK may belong to any of the copies */
+      task->sent_time_ms = 0;
+    }
+
     IOTC_ALLOC_AT(iotc_mqtt_message_t, msg_memory, state);
 
     /* Note on memory - here the data ptr's are shared, so no data copy. */
@@ -82,10 +93,16 @@ static iotc_state_t do_mqtt_publish_q1(
 
     if (state == IOTC_STATE_WRITTEN) {
       iotc_debug_format("[m.id[%d]]publish q1 has been sent", task->msg_id);
-      task->session_state =
-          task->session_state == IOTC_MQTT_LOGIC_TASK_SESSION_UNSET
-              ? IOTC_MQTT_LOGIC_TASK_SESSION_STORE
-              : task->session_state;
+
+      if (IOTC_MQTT_LOGIC_TASK_SESSION_UNSET == task->session_state) {
+        task->session_state = IOTC_MQTT_LOGIC_TASK_SESSION_STORE;
+        task->sent_time_ms = iotc_bsp_time_getcurrenttime_milliseconds();
+
+        /* in flight from now on, recorded so that a restart won't lose it */
+        iotc_session_store_record_publish(
+            &IOTC_CONTEXT_DATA(context)->session_store, task->msg_id,
+            task->data.data_u->publish.topic, task->data.data_u->publish.data);
+      }
     } else {
       iotc_debug_format("[m.id[%d]]publish q1 has not been sent", task->msg_id);
       state = IOTC_STATE_RESEND;
@@ -95,13 +112,17 @@ static iotc_state_t do_mqtt_publish_q1(
     /* Add a timeout for waiting for the response. */
     assert(NULL == task->timeout.ptr_to_position);
 
-    /* @TODO change it to use the defined timeout. */
+    /* The retransmission timeout follows the measured round trip times, the
+     * keepalive timeout is its upper bound. */
     if (IOTC_CONTEXT_DATA(context)->connection_data->keepalive_timeout > 0) {
       state = iotc_evtd_execute_in(
           event_dispatcher,
           iotc_make_handle(&do_mqtt_publish_q1, context, task,
                            IOTC_STATE_TIMEOUT, NULL),
-          IOTC_CONTEXT_DATA(context)->connection_data->keepalive_timeout,
+          iotc_rtt_estimator_timeout(
+              &IOTC_CONTEXT_DATA(context)->rtt_estimator,
+              IOTC_RTT_MIN_TIMEOUT_SEC,
+              IOTC_CONTEXT_DATA(context)->connection_data->keepalive_timeout),
           &task->timeout);
       IOTC_CHECK_STATE(state);
     }
@@ -112,6 +133,10 @@ static iotc_state_t do_mqtt_publish_q1(
     if (IOTC_STATE_TIMEOUT == state) {
       iotc_debug_format("[m.id[%d]]publish q1 timeout occured", task->msg_id);
 
+      IOTC_CONTEXT_STATS_INC(IOTC_CONTEXT_DATA(context), puback_timeouts);
+
+      iotc_rtt_estimator_backoff(&IOTC_CONTEXT_DATA(context)->rtt_estimator);
+
       /* Clear if it was timeout. */
       assert(NULL == task->timeout.ptr_to_position);
 
@@ -154,6 +179,20 @@ static iotc_state_t do_mqtt_publish_q1(
   iotc_debug_format("[m.id[%d]]publish q1 publish puback received",
                     task->msg_id);
 
+  if (0 != task->sent_time_ms) {
+    const iotc_time_t rtt_ms =
+        iotc_bsp_time_getcurrenttime_milliseconds() - task->sent_time_ms;
+
+    /* the wall clock may have been set back meanwhile */
+    if (0 <= rtt_ms && UINT32_MAX >= rtt_ms) {
+      iotc_rtt_estimator_add_sample(&IOTC_CONTEXT_DATA(context)->rtt_estimator,
+                                    (uint32_t)rtt_ms);
+    }
+  }
+
+  iotc_session_store_record_ack(&IOTC_CONTEXT_DATA(context)->session_store,
+                                task->msg_id);
+
   iotc_mqtt_logic_task_defer_users_callback(context, task, state);
 
   iotc_mqtt_message_free(&msg_memory);
@@ -165,6 +204,10 @@ static iotc_state_t do_mqtt_publish_q1(
   IOTC_CR_END();
 
 err_handling:
+  /* given up, it is not going to be resent either */
+  iotc_session_store_record_ack(&IOTC_CONTEXT_DATA(context)->session_store,
+                                task->msg_id);
+
   iotc_mqtt_logic_task_defer_users_callback(context, task, state);
 
   iotc_mqtt_message_free(&msg_memory);
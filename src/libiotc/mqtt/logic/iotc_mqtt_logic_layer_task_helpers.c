@@ -17,8 +17,8 @@
 #include "iotc_mqtt_logic_layer_task_helpers.h"
 #include "iotc_event_thread_dispatcher.h"
 #include "iotc_layer_api.h"
-#include "iotc_list.h"
 #include "iotc_mqtt_logic_layer_data.h"
+#include "iotc_queue.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -43,16 +43,17 @@ iotc_state_t iotc_mqtt_logic_layer_run_next_q0_task(void* data) {
 
   iotc_mqtt_logic_task_t* task = 0;
 
-  if (layer_data->q0_tasks_queue != 0) {
-    IOTC_LIST_POP(iotc_mqtt_logic_task_t, layer_data->q0_tasks_queue, task);
+  if (!IOTC_QUEUE_EMPTY(layer_data->q0_tasks_queue)) {
+    IOTC_QUEUE_POP_FRONT(iotc_mqtt_logic_task_t, layer_data->q0_tasks_queue,
+                         task);
 
     /* prevent execution of other tasks while connecting */
     if (IOTC_CONTEXT_DATA(context)->connection_data->connection_state ==
         IOTC_CONNECTION_STATE_OPENING) {
       /* we only allow connect while client is disconnected */
       if (task->data.mqtt_settings.scenario != IOTC_MQTT_CONNECT) {
-        IOTC_LIST_PUSH_BACK(iotc_mqtt_logic_task_t, layer_data->q0_tasks_queue,
-                            task);
+        IOTC_QUEUE_PUSH_BACK(iotc_mqtt_logic_task_t, layer_data->q0_tasks_queue,
+                             task);
 
         return IOTC_STATE_OK;
       }
@@ -74,10 +75,20 @@ void iotc_mqtt_logic_task_defer_users_callback(void* context,
   assert(context != NULL);
   assert(task != NULL);
 
+  iotc_mqtt_logic_defer_users_callback(context, &task->callback, state);
+}
+
+void iotc_mqtt_logic_defer_users_callback(void* context,
+                                          iotc_event_handle_t* callback,
+                                          iotc_state_t state) {
+  /* PRECONDITION */
+  assert(context != NULL);
+  assert(callback != NULL);
+
   /* if callback is not disposed */
-  if (iotc_handle_disposed(&task->callback) == 0) {
+  if (iotc_handle_disposed(callback) == 0) {
     /* prepare handle */
-    iotc_event_handle_t handle = task->callback;
+    iotc_event_handle_t handle = *callback;
     handle.handlers.h3.a3 = state;
 
     iotc_evttd_execute(IOTC_CONTEXT_DATA(context)->evtd_instance, handle);
@@ -102,7 +113,8 @@ iotc_state_t iotc_mqtt_logic_layer_finalize_task(
   } else /* I left it for better code readability */
   {
     /* detach the task from the qos 1 and 2 queue */
-    IOTC_LIST_DROP(iotc_mqtt_logic_task_t, layer_data->q12_tasks_queue, task);
+    IOTC_QUEUE_UNLINK(iotc_mqtt_logic_task_t, layer_data->q12_tasks_queue,
+                      task);
 
     /* release task's memory */
     iotc_mqtt_logic_free_task(&task);
@@ -23,6 +23,7 @@
 #include "iotc_layer_api.h"
 #include "iotc_list.h"
 #include "iotc_mqtt_logic_layer_data.h"
+#include "iotc_queue.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -37,6 +38,10 @@ void iotc_mqtt_logic_task_defer_users_callback(void* context,
                                                iotc_mqtt_logic_task_t* task,
                                                iotc_state_t state);
 
+void iotc_mqtt_logic_defer_users_callback(void* context,
+                                          iotc_event_handle_t* callback,
+                                          iotc_state_t state);
+
 #define CMP_TASK_MSG_ID(task, id) (task->msg_id == id)
 
 static inline void cancel_task_timeout(iotc_mqtt_logic_task_t* task,
@@ -114,16 +119,18 @@ static inline iotc_state_t run_task(iotc_layer_connectivity_t* context,
     /* task on qos0 can be prioritized */
     switch (task->priority) {
       case IOTC_MQTT_LOGIC_TASK_NORMAL:
-        IOTC_LIST_PUSH_BACK(iotc_mqtt_logic_task_t, layer_data->q0_tasks_queue,
-                            task);
+        IOTC_QUEUE_PUSH_BACK(iotc_mqtt_logic_task_t, layer_data->q0_tasks_queue,
+                             task);
         break;
       case IOTC_MQTT_LOGIC_TASK_IMMEDIATE:
-        IOTC_LIST_PUSH_FRONT(iotc_mqtt_logic_task_t, layer_data->q0_tasks_queue,
-                             task);
+        IOTC_QUEUE_PUSH_FRONT(iotc_mqtt_logic_task_t,
+                              layer_data->q0_tasks_queue, task);
         break;
     }
 
-    if (layer_data->current_q0_task == 0) {
+    /* a fast QoS0 publish occupies the q0 lane too */
+    if (layer_data->current_q0_task == 0 &&
+        0 == layer_data->q0_fast_publish_pending) {
       return iotc_mqtt_logic_layer_run_next_q0_task(context);
     }
   } else {
@@ -133,7 +140,7 @@ static inline iotc_state_t run_task(iotc_layer_connectivity_t* context,
 
 #ifdef IOTC_DEBUG_EXTRA_INFO
     iotc_mqtt_logic_task_t* needle = NULL;
-    IOTC_LIST_FIND(iotc_mqtt_logic_task_t, layer_data->q12_tasks_queue,
+    IOTC_LIST_FIND(iotc_mqtt_logic_task_t, layer_data->q12_tasks_queue.head,
                    CMP_TASK_MSG_ID,
                    task->msg_id, /* this is linear search so we have O(n)
                                     complexity it can be optimized but for the
@@ -143,8 +150,8 @@ static inline iotc_state_t run_task(iotc_layer_connectivity_t* context,
 #endif
 
     /* add it to the queue which is really a multiplexer of message id's */
-    IOTC_LIST_PUSH_BACK(iotc_mqtt_logic_task_t, layer_data->q12_tasks_queue,
-                        task);
+    IOTC_QUEUE_PUSH_BACK(iotc_mqtt_logic_task_t, layer_data->q12_tasks_queue,
+                         task);
 
     /* execute it immediately
      * @TODO concider a different strategy of execution in order to minimize the
@@ -32,4 +32,16 @@ enum {
   IOTC_THREADID_MAINTHREAD
 };
 
+/* Number of workers of the main threadpool, user callbacks of one context
+ * always run on the same worker so they keep their order. */
+#ifndef IOTC_MAIN_THREADPOOL_NUM_OF_THREADS
+#define IOTC_MAIN_THREADPOOL_NUM_OF_THREADS 1
+#endif
+
+/* Worker of the main threadpool running the callbacks of a context, derived
+ * from the slot index of the context handle. */
+#define IOTC_CONTEXT_CALLBACK_THREADID(context_handle) \
+  ((uint8_t)(IOTC_HANDLE_INDEX(context_handle) %         \
+             IOTC_MAIN_THREADPOOL_NUM_OF_THREADS))
+
 #endif /* __IOTC_THREAD_IDS_H__ */
@@ -0,0 +1,48 @@
+/* Copyright 2018-2020 Google LLC
+ *
+ * This is part of the Google Cloud IoT Device SDK for Embedded C.
+ * It is licensed under the BSD 3-Clause license; you may not use this file
+ * except in compliance with the License.
+ *
+ * You may obtain a copy of the License at:
+ *  https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __IOTC_THREAD_LOOPTHREAD_H__
+#define __IOTC_THREAD_LOOPTHREAD_H__
+
+#ifdef IOTC_MODULE_THREAD_ENABLED
+
+#include <iotc_event_dispatcher_api.h>
+
+struct iotc_loopthread_s;
+
+/**
+ * @brief Creates a thread that runs the blocking event loop on one dispatcher.
+ *
+ * Unlike the workerthread the loop waits on the sockets of the dispatcher, so
+ * contexts can do their io on it. The dispatcher should have its wakeup
+ * enabled, otherwise handles scheduled from other threads wait for the loop
+ * timeout.
+ *
+ * @param evtd The dispatcher to run, the loopthread does not take ownership.
+ */
+struct iotc_loopthread_s* iotc_loopthread_create_instance(
+    iotc_evtd_instance_t* evtd);
+
+/**
+ * @brief Stops the dispatcher and joins the thread.
+ *
+ * The dispatcher is left stopped but not destroyed.
+ */
+void iotc_loopthread_destroy_instance(struct iotc_loopthread_s** loopthread);
+
+#endif
+
+#endif /* __IOTC_THREAD_LOOPTHREAD_H__ */
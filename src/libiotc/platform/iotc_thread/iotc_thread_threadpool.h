@@ -25,14 +25,33 @@
 
 #define IOTC_THREADPOOL_MAXNUMOFTHREADS 10
 
+/* forward declaration of the state the workers share */
+struct iotc_threadpool_shared_s;
+
 /**
- * @brief threadpool, owns workerthreads, coordinates event executions
+ * @brief threadpool, owns workers, each worker has its own deque
+ *
+ * Any-thread handles are spread over the worker deques, an idle worker steals
+ * from the deques of the others. Handles enqueued for a given thread or with
+ * an ordering key are never stolen, so they run one after the other in the
+ * order they were enqueued.
  */
 typedef struct iotc_threadpool_s {
   iotc_vector_t* workerthreads;
-  iotc_evtd_instance_t* threadpool_evtd;
+  struct iotc_threadpool_shared_s* shared;
 } iotc_threadpool_t;
 
+/**
+ * @brief threadpool creation parameters
+ */
+typedef struct iotc_threadpool_config_s {
+  /* the desired number of threads, note: there is a maximum number */
+  uint8_t num_of_threads;
+  /* if set worker i runs on cpu i modulo the number of online cpus, ignored
+   * where the platform can't pin threads */
+  uint8_t pin_threads_to_cpus;
+} iotc_threadpool_config_t;
+
 /**
  * @brief creates a threadpool instance
  *
@@ -41,6 +60,12 @@ typedef struct iotc_threadpool_s {
  */
 iotc_threadpool_t* iotc_threadpool_create_instance(uint8_t num_of_threads);
 
+/**
+ * @brief creates a threadpool instance with the given configuration
+ */
+iotc_threadpool_t* iotc_threadpool_create_instance_with_config(
+    const iotc_threadpool_config_t* config);
+
 /**
  * @brief Destroys a threadpool instance
  *
@@ -71,6 +96,20 @@ iotc_event_handle_queue_t* iotc_threadpool_execute(
 iotc_event_handle_queue_t* iotc_threadpool_execute_on_thread(
     iotc_threadpool_t* threadpool, iotc_event_handle_t handle, uint8_t tid);
 
+/**
+ * @brief Enqueues event for ordered execution
+ *
+ * Events with the same ordering key run in the order they were enqueued,
+ * events with different keys may run in parallel.
+ *
+ * @param threadpool Enqueue the event into this threadpool.
+ * @param handle The event handle will be enqueued.
+ * @param ordering_key e.g. the context handle the event belongs to.
+ */
+iotc_event_handle_queue_t* iotc_threadpool_execute_ordered(
+    iotc_threadpool_t* threadpool, iotc_event_handle_t handle,
+    uint32_t ordering_key);
+
 #else
 
 struct iotc_threadpool_t;
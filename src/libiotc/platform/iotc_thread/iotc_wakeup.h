@@ -0,0 +1,73 @@
+/* Copyright 2018-2020 Google LLC
+ *
+ * This is part of the Google Cloud IoT Device SDK for Embedded C.
+ * It is licensed under the BSD 3-Clause license; you may not use this file
+ * except in compliance with the License.
+ *
+ * You may obtain a copy of the License at:
+ *  https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __IOTC_WAKEUP_H__
+#define __IOTC_WAKEUP_H__
+
+#include <stdint.h>
+
+#include <iotc_error.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef IOTC_MODULE_THREAD_ENABLED
+
+/* forward declaration of the wakeup object */
+struct iotc_wakeup_s;
+
+/**
+ * @brief iotc_wakeup_create Creates a selectable object that other threads can
+ * signal to interrupt a blocking select of the event loop.
+ *
+ * @param wakeup Double pointer to the wakeup object.
+ * @return iotc_state_t
+ */
+extern iotc_state_t iotc_wakeup_create(struct iotc_wakeup_s** wakeup);
+
+/**
+ * @brief iotc_wakeup_destroy Closes the wakeup object and frees its memory.
+ * @param wakeup
+ */
+extern void iotc_wakeup_destroy(struct iotc_wakeup_s** wakeup);
+
+/**
+ * @brief iotc_wakeup_get_fd Returns the descriptor to wait for reading on.
+ * @param wakeup
+ */
+extern intptr_t iotc_wakeup_get_fd(const struct iotc_wakeup_s* wakeup);
+
+/**
+ * @brief iotc_wakeup_signal Makes the descriptor readable, safe to call from
+ * any thread.
+ * @param wakeup
+ */
+extern void iotc_wakeup_signal(struct iotc_wakeup_s* wakeup);
+
+/**
+ * @brief iotc_wakeup_drain Consumes all pending signals.
+ * @param wakeup
+ */
+extern void iotc_wakeup_drain(struct iotc_wakeup_s* wakeup);
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __IOTC_WAKEUP_H__ */
@@ -0,0 +1,150 @@
+/* Copyright 2018-2020 Google LLC
+ *
+ * This is part of the Google Cloud IoT Device SDK for Embedded C.
+ * It is licensed under the BSD 3-Clause license; you may not use this file
+ * except in compliance with the License.
+ *
+ * You may obtain a copy of the License at:
+ *  https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/eventfd.h>
+#endif
+
+#include "iotc_allocator.h"
+#include "iotc_debug.h"
+#include "iotc_macros.h"
+#include "iotc_wakeup.h"
+
+#include <iotc_error.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @struct iotc_wakeup_s
+ * @brief An eventfd on Linux, a non-blocking self-pipe on the other POSIX
+ * systems. With eventfd both ends are the same descriptor.
+ */
+typedef struct iotc_wakeup_s {
+  int read_fd;
+  int write_fd;
+} iotc_wakeup_t;
+
+#ifndef __linux__
+static int iotc_wakeup_set_nonblocking(int fd) {
+  const int flags = fcntl(fd, F_GETFL, 0);
+
+  if (-1 == flags) {
+    return -1;
+  }
+
+  return fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+}
+#endif
+
+iotc_state_t iotc_wakeup_create(struct iotc_wakeup_s** wakeup) {
+  assert(NULL != wakeup);
+
+  iotc_state_t ret_state = IOTC_STATE_OK;
+
+  IOTC_ALLOC_AT(struct iotc_wakeup_s, *wakeup, ret_state);
+
+  (*wakeup)->read_fd = -1;
+  (*wakeup)->write_fd = -1;
+
+#ifdef __linux__
+  (*wakeup)->read_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  (*wakeup)->write_fd = (*wakeup)->read_fd;
+
+  IOTC_CHECK_CND_DBGMESSAGE(-1 == (*wakeup)->read_fd, IOTC_INTERNAL_ERROR,
+                            ret_state, "could not create the wakeup eventfd");
+#else
+  int fds[2] = {-1, -1};
+
+  IOTC_CHECK_CND_DBGMESSAGE(-1 == pipe(fds), IOTC_INTERNAL_ERROR, ret_state,
+                            "could not create the wakeup pipe");
+
+  (*wakeup)->read_fd = fds[0];
+  (*wakeup)->write_fd = fds[1];
+
+  IOTC_CHECK_CND_DBGMESSAGE(-1 == iotc_wakeup_set_nonblocking(fds[0]) ||
+                                -1 == iotc_wakeup_set_nonblocking(fds[1]),
+                            IOTC_INTERNAL_ERROR, ret_state,
+                            "could not make the wakeup pipe non-blocking");
+#endif
+
+  return ret_state;
+
+err_handling:
+  iotc_wakeup_destroy(wakeup);
+  return ret_state;
+}
+
+void iotc_wakeup_destroy(struct iotc_wakeup_s** wakeup) {
+  assert(NULL != wakeup);
+
+  if (NULL == *wakeup) {
+    return;
+  }
+
+  if (-1 != (*wakeup)->write_fd && (*wakeup)->write_fd != (*wakeup)->read_fd) {
+    close((*wakeup)->write_fd);
+  }
+
+  if (-1 != (*wakeup)->read_fd) {
+    close((*wakeup)->read_fd);
+  }
+
+  IOTC_SAFE_FREE(*wakeup);
+}
+
+intptr_t iotc_wakeup_get_fd(const struct iotc_wakeup_s* wakeup) {
+  assert(NULL != wakeup);
+
+  return wakeup->read_fd;
+}
+
+void iotc_wakeup_signal(struct iotc_wakeup_s* wakeup) {
+  assert(NULL != wakeup);
+
+#ifdef __linux__
+  const uint64_t value = 1;
+#else
+  const uint8_t value = 1;
+#endif
+
+  /* EAGAIN means the descriptor is already readable, nothing to do */
+  ssize_t result = 0;
+  do {
+    result = write(wakeup->write_fd, &value, sizeof(value));
+  } while (-1 == result && EINTR == errno);
+}
+
+void iotc_wakeup_drain(struct iotc_wakeup_s* wakeup) {
+  assert(NULL != wakeup);
+
+  uint8_t buffer[64];
+
+  /* eventfd resets on a single read, the pipe has to be emptied */
+  ssize_t result = 0;
+  do {
+    result = read(wakeup->read_fd, buffer, sizeof(buffer));
+  } while (0 < result || (-1 == result && EINTR == errno));
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,74 @@
+/* Copyright 2018-2020 Google LLC
+ *
+ * This is part of the Google Cloud IoT Device SDK for Embedded C.
+ * It is licensed under the BSD 3-Clause license; you may not use this file
+ * except in compliance with the License.
+ *
+ * You may obtain a copy of the License at:
+ *  https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <pthread.h>
+
+#include "iotc_allocator.h"
+#include "iotc_debug.h"
+#include "iotc_event_loop.h"
+#include "iotc_macros.h"
+#include "iotc_thread_loopthread.h"
+
+typedef struct iotc_loopthread_s {
+  iotc_evtd_instance_t* evtd;
+  pthread_t thread;
+} iotc_loopthread_t;
+
+static void* iotc_loopthread_start_routine(void* ctx) {
+  iotc_loopthread_t* loopthread = (iotc_loopthread_t*)ctx;
+
+  /* returns once the dispatcher is stopped */
+  iotc_event_loop_with_evtds(0, &loopthread->evtd, 1);
+
+  return NULL;
+}
+
+iotc_loopthread_t* iotc_loopthread_create_instance(iotc_evtd_instance_t* evtd) {
+  iotc_state_t state = IOTC_STATE_OK;
+
+  IOTC_CHECK_CND_DBGMESSAGE(evtd == NULL, IOTC_INVALID_PARAMETER, state,
+                            "no event dispatcher is provided for loopthread");
+
+  IOTC_ALLOC(iotc_loopthread_t, new_loopthread_instance, state);
+
+  new_loopthread_instance->evtd = evtd;
+
+  const int ret_pthread_create =
+      pthread_create(&new_loopthread_instance->thread, NULL,
+                     iotc_loopthread_start_routine, new_loopthread_instance);
+
+  if (ret_pthread_create != 0) {
+    iotc_debug_format("creation of pthread instance failed with error: %d",
+                      ret_pthread_create);
+    IOTC_SAFE_FREE(new_loopthread_instance);
+  }
+
+  return new_loopthread_instance;
+
+err_handling:
+  return NULL;
+}
+
+void iotc_loopthread_destroy_instance(iotc_loopthread_t** loopthread) {
+  if (loopthread == NULL || *loopthread == NULL) return;
+
+  iotc_evtd_stop((*loopthread)->evtd);
+
+  const int ret_pthread_join = pthread_join((*loopthread)->thread, NULL);
+  IOTC_UNUSED(ret_pthread_join);
+
+  IOTC_SAFE_FREE(*loopthread);
+}
@@ -14,21 +14,342 @@
  * limitations under the License.
  */
 
-#include <iotc_thread_posix_workerthread.h>
+#ifdef __linux__
+/* pthread_setaffinity_np */
+#define _GNU_SOURCE
+#endif
+
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "iotc_allocator.h"
+#include "iotc_debug.h"
+#include "iotc_macros.h"
 #include "iotc_thread_threadpool.h"
 
+#ifdef IOTC_MEMORY_ACCOUNTING_ENABLED
+#include "iotc_memory_accounting.h"
+#endif
+
+/* upper bound of an idle worker's sleep, wakeups normally come earlier */
+#define IOTC_THREADPOOL_PARK_TIME_IN_NANOSECONDS 100000000 /* 1/10 sec */
+
+/**
+ * @struct iotc_threadpool_job_t
+ * @brief A queued handle, linked into exactly one worker deque.
+ */
+typedef struct iotc_threadpool_job_s {
+  iotc_event_handle_queue_t queued; /* returned to the caller */
+  struct iotc_threadpool_job_s* prev;
+  struct iotc_threadpool_job_s* next;
+} iotc_threadpool_job_t;
+
+typedef struct iotc_threadpool_deque_s {
+  iotc_threadpool_job_t* head; /* oldest */
+  iotc_threadpool_job_t* tail; /* newest */
+} iotc_threadpool_deque_t;
+
+/**
+ * @struct iotc_threadpool_worker_t
+ * @brief One thread and its deques. The owner takes the oldest job, thieves
+ * take the newest one from the shared deque only.
+ */
+typedef struct iotc_threadpool_worker_s {
+  iotc_threadpool_t* threadpool;
+  pthread_mutex_t lock;
+  iotc_threadpool_deque_t pinned; /* on_thread and ordered jobs */
+  iotc_threadpool_deque_t shared; /* any-thread jobs */
+  pthread_t thread;
+  uint8_t id;
+  uint8_t thread_started;
+} iotc_threadpool_worker_t;
+
+/**
+ * @struct iotc_threadpool_shared_t
+ * @brief Parking of the idle workers. Submitters bump the epoch after each
+ * push and only take the lock if some worker is idle.
+ */
+typedef struct iotc_threadpool_shared_s {
+  pthread_mutex_t park_lock;
+  pthread_cond_t park_cond;
+  volatile uint32_t epoch;
+  volatile uint32_t num_idle;
+  volatile uint32_t next_worker;
+  volatile uint8_t stopping;
+} iotc_threadpool_shared_t;
+
+#define iotc_threadpool_worker_at(threadpool, i) \
+  ((iotc_threadpool_worker_t*)(threadpool)       \
+       ->workerthreads->array[i]                 \
+       .selector_t.ptr_value)
+
+static void iotc_threadpool_deque_push_back(iotc_threadpool_deque_t* deque,
+                                            iotc_threadpool_job_t* job) {
+  job->next = NULL;
+  job->prev = deque->tail;
+
+  if (NULL == deque->tail) {
+    deque->head = job;
+  } else {
+    deque->tail->next = job;
+  }
+
+  deque->tail = job;
+}
+
+static iotc_threadpool_job_t* iotc_threadpool_deque_pop_front(
+    iotc_threadpool_deque_t* deque) {
+  iotc_threadpool_job_t* job = deque->head;
+
+  if (NULL != job) {
+    deque->head = job->next;
+
+    if (NULL == deque->head) {
+      deque->tail = NULL;
+    } else {
+      deque->head->prev = NULL;
+    }
+  }
+
+  return job;
+}
+
+static iotc_threadpool_job_t* iotc_threadpool_deque_pop_back(
+    iotc_threadpool_deque_t* deque) {
+  iotc_threadpool_job_t* job = deque->tail;
+
+  if (NULL != job) {
+    deque->tail = job->prev;
+
+    if (NULL == deque->tail) {
+      deque->head = NULL;
+    } else {
+      deque->tail->next = NULL;
+    }
+  }
+
+  return job;
+}
+
+static void iotc_threadpool_run_job(iotc_threadpool_job_t* job) {
+#ifdef IOTC_MEMORY_ACCOUNTING_ENABLED
+  const iotc_memory_accounting_owner_t prev_owner =
+      iotc_memory_accounting_set_owner(job->queued.handle.memory_owner);
+#endif
+
+  iotc_evtd_execute_handle(&job->queued.handle);
+
+#ifdef IOTC_MEMORY_ACCOUNTING_ENABLED
+  iotc_memory_accounting_set_owner(prev_owner);
+#endif
+
+  IOTC_SAFE_FREE(job);
+}
+
+static void iotc_threadpool_notify(iotc_threadpool_shared_t* shared,
+                                   const uint8_t wake_all) {
+  /* pairs with the idle count increment in park, either the worker sees the
+   * new epoch or this sees the worker idle */
+  __atomic_add_fetch(&shared->epoch, 1, __ATOMIC_SEQ_CST);
+
+  if (0 < __atomic_load_n(&shared->num_idle, __ATOMIC_SEQ_CST)) {
+    pthread_mutex_lock(&shared->park_lock);
+    if (wake_all) {
+      pthread_cond_broadcast(&shared->park_cond);
+    } else {
+      pthread_cond_signal(&shared->park_cond);
+    }
+    pthread_mutex_unlock(&shared->park_lock);
+  }
+}
+
+static void iotc_threadpool_park(iotc_threadpool_shared_t* shared,
+                                 const uint32_t seen_epoch) {
+  struct timespec wake_at;
+
+  clock_gettime(CLOCK_REALTIME, &wake_at);
+  wake_at.tv_nsec += IOTC_THREADPOOL_PARK_TIME_IN_NANOSECONDS;
+  if (wake_at.tv_nsec >= 1000000000) {
+    wake_at.tv_sec += 1;
+    wake_at.tv_nsec -= 1000000000;
+  }
+
+  pthread_mutex_lock(&shared->park_lock);
+  __atomic_add_fetch(&shared->num_idle, 1, __ATOMIC_SEQ_CST);
+
+  if (seen_epoch == __atomic_load_n(&shared->epoch, __ATOMIC_SEQ_CST) &&
+      0 == __atomic_load_n(&shared->stopping, __ATOMIC_SEQ_CST)) {
+    pthread_cond_timedwait(&shared->park_cond, &shared->park_lock, &wake_at);
+  }
+
+  __atomic_sub_fetch(&shared->num_idle, 1, __ATOMIC_SEQ_CST);
+  pthread_mutex_unlock(&shared->park_lock);
+}
+
+static iotc_threadpool_job_t* iotc_threadpool_take_own(
+    iotc_threadpool_worker_t* worker) {
+  pthread_mutex_lock(&worker->lock);
+
+  iotc_threadpool_job_t* job = iotc_threadpool_deque_pop_front(&worker->pinned);
+
+  if (NULL == job) {
+    job = iotc_threadpool_deque_pop_front(&worker->shared);
+  }
+
+  pthread_mutex_unlock(&worker->lock);
+
+  return job;
+}
+
+static iotc_threadpool_job_t* iotc_threadpool_steal(
+    iotc_threadpool_worker_t* thief) {
+  iotc_threadpool_t* threadpool = thief->threadpool;
+  const uint8_t num_of_workers = threadpool->workerthreads->elem_no;
+  uint8_t distance = 1;
+
+  for (; distance < num_of_workers; ++distance) {
+    iotc_threadpool_worker_t* victim = iotc_threadpool_worker_at(
+        threadpool, (thief->id + distance) % num_of_workers);
+
+    /* a busy victim is skipped rather than waited for */
+    if (0 != pthread_mutex_trylock(&victim->lock)) {
+      continue;
+    }
+
+    iotc_threadpool_job_t* job =
+        iotc_threadpool_deque_pop_back(&victim->shared);
+
+    pthread_mutex_unlock(&victim->lock);
+
+    if (NULL != job) {
+      return job;
+    }
+  }
+
+  return NULL;
+}
+
+static void* iotc_threadpool_worker_start_routine(void* ctx) {
+  iotc_threadpool_worker_t* worker = (iotc_threadpool_worker_t*)ctx;
+  iotc_threadpool_shared_t* shared = worker->threadpool->shared;
+
+  for (;;) {
+    const uint32_t seen_epoch =
+        __atomic_load_n(&shared->epoch, __ATOMIC_SEQ_CST);
+
+    iotc_threadpool_job_t* job = iotc_threadpool_take_own(worker);
+
+    if (NULL == job) {
+      job = iotc_threadpool_steal(worker);
+    }
+
+    if (NULL != job) {
+      iotc_threadpool_run_job(job);
+      continue;
+    }
+
+    /* the own deques are empty, everything enqueued before stop has run */
+    if (0 != __atomic_load_n(&shared->stopping, __ATOMIC_SEQ_CST)) {
+      break;
+    }
+
+    iotc_threadpool_park(shared, seen_epoch);
+  }
+
+  return NULL;
+}
+
+static void iotc_threadpool_pin_worker(iotc_threadpool_worker_t* worker) {
+#ifdef __linux__
+  const long num_of_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+  cpu_set_t cpu_set;
+
+  if (0 >= num_of_cpus) {
+    return;
+  }
+
+  CPU_ZERO(&cpu_set);
+  CPU_SET(worker->id % num_of_cpus, &cpu_set);
+
+  const int ret = pthread_setaffinity_np(worker->thread, sizeof(cpu_set_t),
+                                         &cpu_set);
+
+  if (0 != ret) {
+    iotc_debug_format("could not pin worker %d, error: %d", worker->id, ret);
+  }
+#else
+  iotc_debug_format("cpu affinity is not supported, worker %d is not pinned",
+                    worker->id);
+#endif
+}
+
+static iotc_threadpool_worker_t* iotc_threadpool_worker_create(
+    iotc_threadpool_t* threadpool, const uint8_t id) {
+  iotc_state_t state = IOTC_STATE_OK;
+  IOTC_ALLOC(iotc_threadpool_worker_t, worker, state);
+
+  worker->threadpool = threadpool;
+  worker->id = id;
+
+  IOTC_CHECK_CND_DBGMESSAGE(0 != pthread_mutex_init(&worker->lock, NULL),
+                            IOTC_THREAD_ERROR, state,
+                            "could not initialize the worker lock");
+
+  return worker;
+
+err_handling:
+  IOTC_SAFE_FREE(worker);
+  return NULL;
+}
+
+static void iotc_threadpool_worker_join(iotc_threadpool_worker_t* worker) {
+  if (NULL == worker || 0 == worker->thread_started) return;
+
+  const int ret_pthread_join = pthread_join(worker->thread, NULL);
+  IOTC_UNUSED(ret_pthread_join);
+
+  worker->thread_started = 0;
+}
+
+static void iotc_threadpool_worker_destroy(iotc_threadpool_worker_t** worker) {
+  if (NULL == worker || NULL == *worker) return;
+
+  /* jobs enqueued while the worker was exiting run on the destroying thread */
+  iotc_threadpool_job_t* job = NULL;
+  while (NULL != (job = iotc_threadpool_deque_pop_front(&(*worker)->pinned)) ||
+         NULL != (job = iotc_threadpool_deque_pop_front(&(*worker)->shared))) {
+    iotc_threadpool_run_job(job);
+  }
+
+  pthread_mutex_destroy(&(*worker)->lock);
+
+  IOTC_SAFE_FREE(*worker);
+}
+
 iotc_threadpool_t* iotc_threadpool_create_instance(uint8_t num_of_threads) {
-  num_of_threads =
-      IOTC_MIN(IOTC_MAX(num_of_threads, 1), IOTC_THREADPOOL_MAXNUMOFTHREADS);
+  const iotc_threadpool_config_t config = {num_of_threads, 0};
+
+  return iotc_threadpool_create_instance_with_config(&config);
+}
+
+iotc_threadpool_t* iotc_threadpool_create_instance_with_config(
+    const iotc_threadpool_config_t* config) {
+  if (NULL == config) return NULL;
+
+  const uint8_t num_of_threads = IOTC_MIN(IOTC_MAX(config->num_of_threads, 1),
+                                          IOTC_THREADPOOL_MAXNUMOFTHREADS);
 
   iotc_state_t state = IOTC_STATE_OK;
   IOTC_ALLOC(iotc_threadpool_t, threadpool, state);
 
-  threadpool->threadpool_evtd = iotc_evtd_create_instance();
+  IOTC_ALLOC_AT(iotc_threadpool_shared_t, threadpool->shared, state);
 
-  IOTC_CHECK_CND_DBGMESSAGE(threadpool->threadpool_evtd == NULL,
-                            IOTC_OUT_OF_MEMORY, state,
-                            "could not create event dispatcher for threadpool");
+  IOTC_CHECK_CND_DBGMESSAGE(
+      0 != pthread_mutex_init(&threadpool->shared->park_lock, NULL) ||
+          0 != pthread_cond_init(&threadpool->shared->park_cond, NULL),
+      IOTC_THREAD_ERROR, state, "could not initialize the threadpool parking");
 
   threadpool->workerthreads = iotc_vector_create();
 
@@ -43,22 +364,47 @@ iotc_threadpool_t* iotc_threadpool_create_instance(uint8_t num_of_threads) {
       result == 0, IOTC_OUT_OF_MEMORY, state,
       "could not reserve enough space in vector for workerthreads");
 
+  /* all the workers exist before any thread starts stealing */
   uint8_t counter_workerthread = 0;
   for (; counter_workerthread < num_of_threads; ++counter_workerthread) {
-    iotc_workerthread_t* new_workerthread =
-        iotc_workerthread_create_instance(threadpool->threadpool_evtd);
+    iotc_threadpool_worker_t* new_worker =
+        iotc_threadpool_worker_create(threadpool, counter_workerthread);
 
-    IOTC_CHECK_CND_DBGMESSAGE(new_workerthread == NULL, IOTC_OUT_OF_MEMORY,
-                              state, "could not allocate a workerthread");
+    IOTC_CHECK_CND_DBGMESSAGE(new_worker == NULL, IOTC_OUT_OF_MEMORY, state,
+                              "could not allocate a workerthread");
 
     iotc_vector_push(
         threadpool->workerthreads,
-        IOTC_VEC_CONST_VALUE_PARAM(IOTC_VEC_VALUE_PTR(new_workerthread)));
+        IOTC_VEC_CONST_VALUE_PARAM(IOTC_VEC_VALUE_PTR(new_worker)));
+  }
+
+  for (counter_workerthread = 0; counter_workerthread < num_of_threads;
+       ++counter_workerthread) {
+    iotc_threadpool_worker_t* worker =
+        iotc_threadpool_worker_at(threadpool, counter_workerthread);
+
+    const int ret_pthread_create =
+        pthread_create(&worker->thread, NULL,
+                       iotc_threadpool_worker_start_routine, worker);
+
+    if (ret_pthread_create != 0) {
+      iotc_debug_format("creation of pthread instance failed with error: %d",
+                        ret_pthread_create);
+      state = IOTC_THREAD_ERROR;
+      goto err_handling;
+    }
+
+    worker->thread_started = 1;
+
+    if (config->pin_threads_to_cpus) {
+      iotc_threadpool_pin_worker(worker);
+    }
   }
 
   return threadpool;
 
 err_handling:
+  iotc_threadpool_destroy_instance(&threadpool);
   return NULL;
 }
 
@@ -67,45 +413,84 @@ void iotc_threadpool_destroy_instance(iotc_threadpool_t** threadpool) {
 
   iotc_threadpool_t* threadpool_ptr = *threadpool;
 
-  if (threadpool_ptr->workerthreads != NULL) {
-    /* stop all workerthreads in advance their destroy to avoid summing up join
+  if (threadpool_ptr->shared != NULL) {
+    /* stop all workers in advance their destroy to avoid summing up join
      * times at destruction with that all thread exits are done parallelly */
+    __atomic_store_n(&threadpool_ptr->shared->stopping, 1, __ATOMIC_SEQ_CST);
+    iotc_threadpool_notify(threadpool_ptr->shared, 1);
+  }
+
+  if (threadpool_ptr->workerthreads != NULL) {
+    /* the workers steal from each other, none is freed before all exited */
     uint8_t counter_workerthread = 0;
     for (; counter_workerthread < threadpool_ptr->workerthreads->elem_no;
          ++counter_workerthread) {
-      iotc_evtd_stop(((iotc_workerthread_t*)threadpool_ptr->workerthreads
-                          ->array[counter_workerthread]
-                          .selector_t.ptr_value)
-                         ->thread_evtd);
+      iotc_threadpool_worker_join(
+          iotc_threadpool_worker_at(threadpool_ptr, counter_workerthread));
     }
 
     counter_workerthread = 0;
     for (; counter_workerthread < threadpool_ptr->workerthreads->elem_no;
          ++counter_workerthread) {
-      iotc_workerthread_destroy_instance(
-          (iotc_workerthread_t**)&threadpool_ptr->workerthreads
+      iotc_threadpool_worker_destroy(
+          (iotc_threadpool_worker_t**)&threadpool_ptr->workerthreads
               ->array[counter_workerthread]
               .selector_t.ptr_value);
     }
 
-    if (threadpool_ptr->threadpool_evtd != NULL) {
-      /* ensure all any-thread handlers are executed before destroy */
-      iotc_evtd_step(threadpool_ptr->threadpool_evtd, time(0));
-    }
-
     iotc_vector_destroy(threadpool_ptr->workerthreads);
   }
 
-  iotc_evtd_destroy_instance(threadpool_ptr->threadpool_evtd);
+  if (threadpool_ptr->shared != NULL) {
+    pthread_cond_destroy(&threadpool_ptr->shared->park_cond);
+    pthread_mutex_destroy(&threadpool_ptr->shared->park_lock);
+    IOTC_SAFE_FREE(threadpool_ptr->shared);
+  }
 
   IOTC_SAFE_FREE(*threadpool);
 }
 
+static iotc_event_handle_queue_t* iotc_threadpool_push(
+    iotc_threadpool_t* threadpool, iotc_threadpool_worker_t* worker,
+    iotc_event_handle_t handle, const uint8_t pinned) {
+  iotc_state_t state = IOTC_STATE_OK;
+  IOTC_ALLOC_SYSTEM(iotc_threadpool_job_t, job, state);
+
+  job->queued.handle = handle;
+#ifdef IOTC_MEMORY_ACCOUNTING_ENABLED
+  job->queued.handle.memory_owner = iotc_memory_accounting_get_owner();
+#endif
+
+  pthread_mutex_lock(&worker->lock);
+  iotc_threadpool_deque_push_back(pinned ? &worker->pinned : &worker->shared,
+                                  job);
+  pthread_mutex_unlock(&worker->lock);
+
+  /* a pinned job needs its own worker awake, any idle worker can steal the
+   * other ones */
+  iotc_threadpool_notify(threadpool->shared, pinned);
+
+  return &job->queued;
+
+err_handling:
+  return NULL;
+}
+
 iotc_event_handle_queue_t* iotc_threadpool_execute(
     iotc_threadpool_t* threadpool, iotc_event_handle_t handle) {
-  if (threadpool == NULL || threadpool->threadpool_evtd == NULL) return NULL;
+  if (threadpool == NULL || threadpool->workerthreads == NULL ||
+      threadpool->workerthreads->elem_no == 0)
+    return NULL;
+
+  /* spread the submissions, stealing evens out the rest */
+  const uint32_t next_worker = __atomic_fetch_add(
+      &threadpool->shared->next_worker, 1, __ATOMIC_RELAXED);
 
-  return iotc_evtd_execute(threadpool->threadpool_evtd, handle);
+  return iotc_threadpool_push(
+      threadpool,
+      iotc_threadpool_worker_at(
+          threadpool, next_worker % threadpool->workerthreads->elem_no),
+      handle, 0);
 }
 
 iotc_event_handle_queue_t* iotc_threadpool_execute_on_thread(
@@ -117,15 +502,25 @@ iotc_event_handle_queue_t* iotc_threadpool_execute_on_thread(
   if (tid < threadpool->workerthreads->elem_no &&
       threadpool->workerthreads->array[tid].selector_t.ptr_value !=
           NULL) { /* valid tid */
-    iotc_workerthread_t* workerthread_target =
-        ((iotc_workerthread_t*)threadpool->workerthreads->array[tid]
-             .selector_t.ptr_value);
-
-    if (workerthread_target->thread_evtd != NULL) {
-      return iotc_evtd_execute(workerthread_target->thread_evtd, handle);
-    }
+    return iotc_threadpool_push(
+        threadpool, iotc_threadpool_worker_at(threadpool, tid), handle, 1);
   }
 
   /* invalid tid, fallback: execute handler on any thread */
   return iotc_threadpool_execute(threadpool, handle);
 }
+
+iotc_event_handle_queue_t* iotc_threadpool_execute_ordered(
+    iotc_threadpool_t* threadpool, iotc_event_handle_t handle,
+    uint32_t ordering_key) {
+  if (threadpool == NULL || threadpool->workerthreads == NULL ||
+      threadpool->workerthreads->elem_no == 0)
+    return NULL;
+
+  /* one key always maps to the same worker and pinned jobs are never stolen */
+  return iotc_threadpool_push(
+      threadpool,
+      iotc_threadpool_worker_at(
+          threadpool, ordering_key % threadpool->workerthreads->elem_no),
+      handle, 1);
+}
@@ -0,0 +1,174 @@
+/* Copyright 2018-2020 Google LLC
+ *
+ * This is part of the Google Cloud IoT Device SDK for Embedded C.
+ * It is licensed under the BSD 3-Clause license; you may not use this file
+ * except in compliance with the License.
+ *
+ * You may obtain a copy of the License at:
+ *  https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+extern "C" {
+#include "iotc_thread_threadpool.h"
+}
+
+namespace iotctest {
+namespace {
+
+// Events submitted per benchmark iteration, the iteration ends when all ran.
+constexpr uint32_t kBatchSize = 1000;
+
+// A batch of events, each burns `rounds` rounds of an LCG: 0 measures the
+// queueing alone, 2000 is a few microseconds of work per event, the order of
+// a callback that parses its payload.
+struct Batch {
+  uint32_t rounds;
+  std::atomic<uint32_t> done;
+};
+
+iotc_state_t RunEvent(void* batch_ptr) {
+  Batch* batch = static_cast<Batch*>(batch_ptr);
+
+  uint32_t seed = 12345;
+  for (uint32_t round = 0; round < batch->rounds; ++round) {
+    seed = seed * 1103515245 + 12345;
+  }
+  benchmark::DoNotOptimize(seed);
+
+  batch->done.fetch_add(1, std::memory_order_release);
+
+  return IOTC_STATE_OK;
+}
+
+iotc_event_handle_t MakeEvent(Batch* batch) {
+  return iotc_make_threaded_handle(IOTC_THREADID_ANYTHREAD, &RunEvent, batch);
+}
+
+void WaitForBatch(const Batch& batch) {
+  while (batch.done.load(std::memory_order_acquire) < kBatchSize) {
+    std::this_thread::yield();
+  }
+}
+
+// The baseline: workers that all take from one queue behind one lock.
+class SharedQueuePool {
+ public:
+  explicit SharedQueuePool(int num_of_threads) {
+    for (int i = 0; i < num_of_threads; ++i) {
+      threads_.emplace_back(&SharedQueuePool::Work, this);
+    }
+  }
+
+  ~SharedQueuePool() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stopping_ = true;
+    }
+    cond_.notify_all();
+    for (std::thread& thread : threads_) {
+      thread.join();
+    }
+  }
+
+  void Execute(const iotc_event_handle_t& handle) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      queue_.push_back(handle);
+    }
+    cond_.notify_one();
+  }
+
+ private:
+  void Work() {
+    for (;;) {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cond_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+      if (queue_.empty()) {
+        return;
+      }
+      iotc_event_handle_t handle = queue_.front();
+      queue_.pop_front();
+      lock.unlock();
+
+      iotc_evtd_execute_handle(&handle);
+    }
+  }
+
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  std::deque<iotc_event_handle_t> queue_;
+  bool stopping_ = false;
+  std::vector<std::thread> threads_;
+};
+
+void BM_ThreadpoolSharedQueue(benchmark::State& state) {
+  SharedQueuePool pool(static_cast<int>(state.range(0)));
+  Batch batch;
+  batch.rounds = static_cast<uint32_t>(state.range(1));
+
+  for (auto _ : state) {
+    batch.done.store(0);
+    for (uint32_t i = 0; i < kBatchSize; ++i) {
+      pool.Execute(MakeEvent(&batch));
+    }
+    WaitForBatch(batch);
+  }
+
+  state.SetItemsProcessed(state.iterations() * kBatchSize);
+}
+
+void BM_ThreadpoolWorkerDeques(benchmark::State& state) {
+  iotc_threadpool_t* threadpool =
+      iotc_threadpool_create_instance(static_cast<uint8_t>(state.range(0)));
+  Batch batch;
+  batch.rounds = static_cast<uint32_t>(state.range(1));
+
+  for (auto _ : state) {
+    batch.done.store(0);
+    for (uint32_t i = 0; i < kBatchSize; ++i) {
+      while (nullptr ==
+             iotc_threadpool_execute(threadpool, MakeEvent(&batch))) {
+        std::this_thread::yield();
+      }
+    }
+    WaitForBatch(batch);
+  }
+
+  state.SetItemsProcessed(state.iterations() * kBatchSize);
+  iotc_threadpool_destroy_instance(&threadpool);
+}
+
+// {workers, rounds per event}. The benchmark's own thread submits the events,
+// more workers only add events/s while there are idle CPUs for them and an
+// event costs more than its submission. With empty events the workers drain
+// their deques faster than one submitter fills them, they park after almost
+// every event and each execute pays a condition variable signal and a wakeup:
+// that, not the work, bounds the events/s past a couple of workers.
+void ThreadpoolArgs(benchmark::internal::Benchmark* benchmark) {
+  for (int rounds : {0, 2000}) {
+    for (int workers : {1, 2, 4, 8}) {
+      benchmark->Args({workers, rounds});
+    }
+  }
+}
+
+BENCHMARK(BM_ThreadpoolSharedQueue)->Apply(ThreadpoolArgs)->UseRealTime();
+BENCHMARK(BM_ThreadpoolWorkerDeques)->Apply(ThreadpoolArgs)->UseRealTime();
+
+}  // namespace
+}  // namespace iotctest
@@ -22,6 +22,7 @@
 #include <iotc_macros.h>
 #include <iotc_tls_layer.h>
 #include <iotc_tls_layer_state.h>
+#include <iotc_types_internal.h>
 #include "iotc_fs_filenames.h"
 #include "iotc_layer_api.h"
 #include "iotc_resource_manager.h"
@@ -173,6 +174,8 @@ static iotc_state_t connect_handler(void* context, void* data,
     }
   } while (bsp_tls_state != IOTC_BSP_TLS_STATE_OK);
 
+  IOTC_CONTEXT_STATS_INC(IOTC_CONTEXT_DATA(context), tls_handshakes);
+
   /* connection done we can restore the logic handlers */
   layer_data->tls_layer_logic_recv_handler = &recv_handler;
   layer_data->tls_layer_logic_send_handler = &send_handler;
@@ -472,6 +475,10 @@ iotc_state_t iotc_tls_layer_init(void* context, void* data,
     goto err_handling;
   }
 
+  /* keep the certificate loading on the dispatcher of this context */
+  layer_data->rm_context->evtd_instance =
+      IOTC_CONTEXT_DATA(context)->evtd_instance;
+
   in_out_state = iotc_resource_manager_open(
       layer_data->rm_context,
       iotc_make_handle(&iotc_tls_layer_init, context, data, in_out_state),
@@ -0,0 +1,480 @@
+/* Copyright 2018-2020 Google LLC
+ *
+ * This is part of the Google Cloud IoT Device SDK for Embedded C.
+ * It is licensed under the BSD 3-Clause license; you may not use this file
+ * except in compliance with the License.
+ *
+ * You may obtain a copy of the License at:
+ *  https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Publish throughput and latency against the loopback MQTT broker of
+ * iotc_test_echoserver. The broker runs on its own thread of this process,
+ * the client is driven with iotc_events_process_tick() on the main thread.
+ *
+ * For each QoS the client keeps a window of publishes in flight and
+ * measures, per message:
+ *  - the time from iotc_publish_data() to the callback, that is until the
+ *    PUBACK for QoS1 and until the message was written for QoS0,
+ *  - the bytes the broker received,
+ *  - the SDK heap allocations (when linked with the allocation wrappers),
+ *  - the CPU time of the client thread.
+ *
+ * The results are written as JSON. Whether they were taken over TLS depends
+ * on the TLS BSP the SDK was built with; TLS builds need --tls_cert and
+ * --tls_key for the broker and the certificate has to be trusted by the
+ * SDK's root CA resource.
+ */
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "iotc.h"
+#include "iotc_test_echoserver.h"
+
+#ifndef RUSAGE_THREAD
+#define RUSAGE_THREAD RUSAGE_SELF
+#endif
+
+typedef std::chrono::steady_clock iotc_benchmark_clock;
+
+#ifdef IOTC_BENCHMARK_COUNT_ALLOCATIONS
+/* the link redirects the SDK's calls to the memory BSP here */
+static uint64_t iotc_benchmark_allocations = 0;
+
+extern "C" {
+void* __real_iotc_bsp_mem_alloc(size_t byte_count);
+void* __real_iotc_bsp_mem_realloc(void* ptr, size_t byte_count);
+
+void* __wrap_iotc_bsp_mem_alloc(size_t byte_count) {
+  ++iotc_benchmark_allocations;
+  return __real_iotc_bsp_mem_alloc(byte_count);
+}
+
+void* __wrap_iotc_bsp_mem_realloc(void* ptr, size_t byte_count) {
+  ++iotc_benchmark_allocations;
+  return __real_iotc_bsp_mem_realloc(ptr, byte_count);
+}
+}
+#endif
+
+namespace {
+
+struct Options {
+  std::string host = "127.0.0.1";
+  uint16_t port = 18830;
+  uint32_t messages = 2000;
+  uint32_t payload_size = 64;
+  uint32_t window = 16;
+  uint32_t timeout_seconds = 60;
+  bool tcp_nodelay = false;
+  std::string output;
+  std::string tls_cert;
+  std::string tls_key;
+};
+
+struct Result {
+  int qos = 0;
+  uint32_t messages = 0;
+  uint32_t failed = 0;
+  double seconds = 0;
+  double latency_p50_us = 0;
+  double latency_p99_us = 0;
+  double latency_max_us = 0;
+  double bytes_per_message = 0;
+  double allocations_per_message = -1;
+  double cpu_us_per_message = 0;
+};
+
+/* state shared with the SDK callbacks */
+struct Run {
+  std::vector<iotc_benchmark_clock::time_point> sent_at;
+  std::vector<double> latencies_us;
+  uint32_t completed = 0;
+  uint32_t failed = 0;
+};
+
+Run* current_run = nullptr;
+bool connected = false;
+bool disconnected = false;
+
+void OnConnectionStateChanged(iotc_context_handle_t context_handle,
+                              void* data, iotc_state_t state) {
+  (void)context_handle;
+  (void)state;
+
+  const iotc_connection_data_t* conn_data = (iotc_connection_data_t*)data;
+
+  if (conn_data == nullptr) {
+    return;
+  }
+
+  switch (conn_data->connection_state) {
+    case IOTC_CONNECTION_STATE_OPENED:
+      connected = true;
+      break;
+    case IOTC_CONNECTION_STATE_OPEN_FAILED:
+    case IOTC_CONNECTION_STATE_CLOSED:
+      connected = false;
+      disconnected = true;
+      break;
+    default:
+      break;
+  }
+}
+
+void OnPublish(iotc_context_handle_t context_handle, void* data,
+               iotc_state_t state) {
+  (void)context_handle;
+
+  if (current_run == nullptr) {
+    return;
+  }
+
+  const size_t index = (size_t)(intptr_t)data;
+  const std::chrono::duration<double, std::micro> latency =
+      iotc_benchmark_clock::now() - current_run->sent_at[index];
+
+  current_run->latencies_us.push_back(latency.count());
+  ++current_run->completed;
+
+  if (state != IOTC_STATE_OK) {
+    ++current_run->failed;
+  }
+}
+
+double CpuSeconds() {
+  struct rusage usage;
+  getrusage(RUSAGE_THREAD, &usage);
+
+  return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec +
+         (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+double Percentile(const std::vector<double>& sorted, double percentile) {
+  if (sorted.empty()) {
+    return 0;
+  }
+
+  size_t rank = (size_t)(percentile * sorted.size() + 0.5);
+  rank = std::max<size_t>(rank, 1);
+
+  return sorted[std::min(rank, sorted.size()) - 1];
+}
+
+bool ProcessUntil(const bool& condition, uint32_t timeout_seconds) {
+  const iotc_benchmark_clock::time_point deadline =
+      iotc_benchmark_clock::now() + std::chrono::seconds(timeout_seconds);
+
+  while (!condition && iotc_benchmark_clock::now() < deadline) {
+    if (iotc_events_process_tick() != IOTC_STATE_OK) {
+      break;
+    }
+  }
+
+  return condition;
+}
+
+bool RunPublishes(iotc_context_handle_t context_handle,
+                  iotctest::EchoTestServer* broker, const Options& options,
+                  iotc_mqtt_qos_t qos, Result* result) {
+  const std::vector<uint8_t> payload(options.payload_size, 'x');
+  const char* topic = "benchmark/publish";
+
+  Run run;
+  run.sent_at.resize(options.messages);
+  run.latencies_us.reserve(options.messages);
+  current_run = &run;
+
+  const uint64_t bytes_before = broker->bytes_received();
+  const uint64_t publishes_before = broker->publishes_received();
+#ifdef IOTC_BENCHMARK_COUNT_ALLOCATIONS
+  const uint64_t allocations_before = iotc_benchmark_allocations;
+#endif
+  const double cpu_before = CpuSeconds();
+  const iotc_benchmark_clock::time_point start = iotc_benchmark_clock::now();
+  const iotc_benchmark_clock::time_point deadline =
+      start + std::chrono::seconds(options.timeout_seconds);
+
+  uint32_t sent = 0;
+  while (run.completed < options.messages &&
+         iotc_benchmark_clock::now() < deadline) {
+    while (sent < options.messages && sent - run.completed < options.window) {
+      run.sent_at[sent] = iotc_benchmark_clock::now();
+
+      if (iotc_publish_data(context_handle, topic, payload.data(),
+                            payload.size(), qos, &OnPublish,
+                            (void*)(intptr_t)sent) != IOTC_STATE_OK) {
+        ++run.completed;
+        ++run.failed;
+      }
+
+      ++sent;
+    }
+
+    if (iotc_events_process_tick() != IOTC_STATE_OK) {
+      break;
+    }
+  }
+
+  const std::chrono::duration<double> elapsed =
+      iotc_benchmark_clock::now() - start;
+  const double cpu_seconds = CpuSeconds() - cpu_before;
+
+  current_run = nullptr;
+
+  /* QoS0 publishes complete once written, the broker may still be reading
+   * them */
+  while (broker->publishes_received() < publishes_before + options.messages &&
+         iotc_benchmark_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  if (run.completed < options.messages) {
+    fprintf(stderr, "QoS%d: %u of %u publishes completed before the timeout\n",
+            qos, run.completed, options.messages);
+    return false;
+  }
+
+  std::sort(run.latencies_us.begin(), run.latencies_us.end());
+
+  result->qos = qos;
+  result->messages = options.messages;
+  result->failed = run.failed;
+  result->seconds = elapsed.count();
+  result->latency_p50_us = Percentile(run.latencies_us, 0.50);
+  result->latency_p99_us = Percentile(run.latencies_us, 0.99);
+  result->latency_max_us =
+      run.latencies_us.empty() ? 0 : run.latencies_us.back();
+  result->bytes_per_message =
+      (double)(broker->bytes_received() - bytes_before) / options.messages;
+#ifdef IOTC_BENCHMARK_COUNT_ALLOCATIONS
+  result->allocations_per_message =
+      (double)(iotc_benchmark_allocations - allocations_before) /
+      options.messages;
+#endif
+  result->cpu_us_per_message = cpu_seconds * 1e6 / options.messages;
+
+  return true;
+}
+
+void WriteJson(FILE* out, const Options& options, bool tls,
+               const std::vector<Result>& results) {
+  fprintf(out, "{\n");
+  fprintf(out, "  \"benchmark\": \"publish\",\n");
+  fprintf(out, "  \"tls\": %s,\n", tls ? "true" : "false");
+  fprintf(out, "  \"payload_size\": %u,\n", options.payload_size);
+  fprintf(out, "  \"window\": %u,\n", options.window);
+  fprintf(out, "  \"tcp_nodelay\": %s,\n",
+          options.tcp_nodelay ? "true" : "false");
+  fprintf(out, "  \"results\": [\n");
+
+  for (size_t i = 0; i < results.size(); ++i) {
+    const Result& result = results[i];
+
+    fprintf(out, "    {\n");
+    fprintf(out, "      \"qos\": %d,\n", result.qos);
+    fprintf(out, "      \"messages\": %u,\n", result.messages);
+    fprintf(out, "      \"failed\": %u,\n", result.failed);
+    fprintf(out, "      \"msgs_per_sec\": %.1f,\n",
+            result.seconds > 0 ? result.messages / result.seconds : 0);
+    fprintf(out, "      \"latency_us\": {\"p50\": %.1f, \"p99\": %.1f, "
+                 "\"max\": %.1f},\n",
+            result.latency_p50_us, result.latency_p99_us,
+            result.latency_max_us);
+    fprintf(out, "      \"bytes_per_msg\": %.1f,\n", result.bytes_per_message);
+    if (result.allocations_per_message < 0) {
+      fprintf(out, "      \"allocs_per_msg\": null,\n");
+    } else {
+      fprintf(out, "      \"allocs_per_msg\": %.2f,\n",
+              result.allocations_per_message);
+    }
+    fprintf(out, "      \"cpu_us_per_msg\": %.2f\n", result.cpu_us_per_message);
+    fprintf(out, "    }%s\n", i + 1 < results.size() ? "," : "");
+  }
+
+  fprintf(out, "  ]\n");
+  fprintf(out, "}\n");
+}
+
+void PrintUsage(const char* name) {
+  fprintf(stderr,
+          "usage: %s [--host HOST] [--port PORT] [--messages N]\n"
+          "          [--payload_size BYTES] [--window N] [--timeout SECONDS]\n"
+          "          [--tcp_nodelay] [--output FILE]\n"
+          "          [--tls_cert PEM --tls_key PEM]\n",
+          name);
+}
+
+bool ParseOptions(int argc, char* argv[], Options* options) {
+  static const struct option long_options[] = {
+      {"host", required_argument, nullptr, 'h'},
+      {"port", required_argument, nullptr, 'p'},
+      {"messages", required_argument, nullptr, 'n'},
+      {"payload_size", required_argument, nullptr, 's'},
+      {"window", required_argument, nullptr, 'w'},
+      {"timeout", required_argument, nullptr, 't'},
+      {"tcp_nodelay", no_argument, nullptr, 'd'},
+      {"output", required_argument, nullptr, 'o'},
+      {"tls_cert", required_argument, nullptr, 'c'},
+      {"tls_key", required_argument, nullptr, 'k'},
+      {nullptr, 0, nullptr, 0}};
+
+  int option = 0;
+  while ((option = getopt_long(argc, argv, "", long_options, nullptr)) != -1) {
+    switch (option) {
+      case 'h':
+        options->host = optarg;
+        break;
+      case 'p':
+        options->port = (uint16_t)atoi(optarg);
+        break;
+      case 'n':
+        options->messages = (uint32_t)atoi(optarg);
+        break;
+      case 's':
+        options->payload_size = (uint32_t)atoi(optarg);
+        break;
+      case 'w':
+        options->window = (uint32_t)atoi(optarg);
+        break;
+      case 't':
+        options->timeout_seconds = (uint32_t)atoi(optarg);
+        break;
+      case 'd':
+        options->tcp_nodelay = true;
+        break;
+      case 'o':
+        options->output = optarg;
+        break;
+      case 'c':
+        options->tls_cert = optarg;
+        break;
+      case 'k':
+        options->tls_key = optarg;
+        break;
+      default:
+        return false;
+    }
+  }
+
+  return options->messages > 0 && options->window > 0;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  Options options;
+
+  if (!ParseOptions(argc, argv, &options)) {
+    PrintUsage(argv[0]);
+    return 1;
+  }
+
+#ifdef IOTC_NO_TLS_LAYER
+  const bool tls = false;
+#else
+  const bool tls = true;
+#endif
+
+  std::unique_ptr<iotctest::EchoTestServer> broker =
+      iotctest::EchoTestServer::CreateMqttBroker(options.host, options.port,
+                                               AF_INET);
+
+#ifdef IOTC_TEST_ECHOSERVER_TLS
+  if (tls && !broker->EnableTls(options.tls_cert, options.tls_key)) {
+    fprintf(stderr, "the broker needs --tls_cert and --tls_key\n");
+    return 1;
+  }
+#endif
+
+  broker->Run();
+
+  std::vector<Result> results;
+  int exit_code = 1;
+
+  if (iotc_initialize() != IOTC_STATE_OK) {
+    broker->Stop();
+    return 1;
+  }
+
+  iotc_context_handle_t context_handle = iotc_create_context();
+
+  iotc_bsp_socket_options_t socket_options;
+  memset(&socket_options, 0, sizeof(socket_options));
+  socket_options.tcp_nodelay = options.tcp_nodelay ? 1 : 0;
+
+  if (context_handle > IOTC_INVALID_CONTEXT_HANDLE &&
+      iotc_set_socket_options(context_handle, &socket_options) ==
+          IOTC_STATE_OK &&
+      iotc_connect_to(context_handle, options.host.c_str(), options.port,
+                      "benchmark", "benchmark", "iotc_benchmark_publish",
+                      /*connection_timeout=*/10, /*keepalive_timeout=*/60,
+                      &OnConnectionStateChanged) == IOTC_STATE_OK &&
+      ProcessUntil(connected, options.timeout_seconds)) {
+    const iotc_mqtt_qos_t qos_levels[] = {IOTC_MQTT_QOS_AT_MOST_ONCE,
+                                          IOTC_MQTT_QOS_AT_LEAST_ONCE};
+
+    exit_code = 0;
+
+    for (const iotc_mqtt_qos_t qos : qos_levels) {
+      Result result;
+
+      if (!RunPublishes(context_handle, broker.get(), options, qos, &result)) {
+        exit_code = 1;
+        break;
+      }
+
+      results.push_back(result);
+    }
+
+    iotc_shutdown_connection(context_handle);
+    ProcessUntil(disconnected, options.timeout_seconds);
+  } else {
+    fprintf(stderr, "could not connect to the loopback broker at %s:%u\n",
+            options.host.c_str(), options.port);
+  }
+
+  if (context_handle > IOTC_INVALID_CONTEXT_HANDLE) {
+    iotc_delete_context(context_handle);
+  }
+
+  iotc_shutdown();
+  broker->Stop();
+
+  if (exit_code == 0) {
+    FILE* out = stdout;
+
+    if (!options.output.empty() &&
+        (out = fopen(options.output.c_str(), "w")) == nullptr) {
+      fprintf(stderr, "could not open %s\n", options.output.c_str());
+      return 1;
+    }
+
+    WriteJson(out, options, tls, results);
+
+    if (out != stdout) {
+      fclose(out);
+    }
+  }
+
+  return exit_code;
+}
@@ -0,0 +1,52 @@
+/* Copyright 2018-2020 Google LLC
+ *
+ * This is part of the Google Cloud IoT Device SDK for Embedded C.
+ * It is licensed under the BSD 3-Clause license; you may not use this file
+ * except in compliance with the License.
+ *
+ * You may obtain a copy of the License at:
+ *  https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __IOTC_FUZZTEST_FRAGMENTATION_H__
+#define __IOTC_FUZZTEST_FRAGMENTATION_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <iotc_macros.h>
+
+/* The first byte of a fuzz input picks how the rest of it is cut into the
+ * chunks a socket would return: 0 passes it in one piece, any other value is
+ * both the seed and the maximum of pseudo-random chunk sizes, 1 feeds it byte
+ * by byte. The seed corpus files start with that byte. */
+typedef struct iotc_fuzztest_fragmentation_s {
+  uint32_t seed;
+  uint8_t max_chunk_size;
+} iotc_fuzztest_fragmentation_t;
+
+static inline iotc_fuzztest_fragmentation_t iotc_fuzztest_fragmentation_init(
+    uint8_t first_byte) {
+  iotc_fuzztest_fragmentation_t fragmentation = {first_byte, first_byte};
+  return fragmentation;
+}
+
+static inline size_t iotc_fuzztest_next_chunk_size(
+    iotc_fuzztest_fragmentation_t* fragmentation, size_t bytes_left) {
+  if (0 == fragmentation->max_chunk_size) {
+    return bytes_left;
+  }
+
+  fragmentation->seed = fragmentation->seed * 1103515245 + 12345;
+  return IOTC_MIN(
+      1 + (fragmentation->seed >> 16) % fragmentation->max_chunk_size,
+      bytes_left);
+}
+
+#endif /* __IOTC_FUZZTEST_FRAGMENTATION_H__ */
@@ -14,14 +14,251 @@
  * limitations under the License.
  */
 
-#include <memory.h>
 #include <stddef.h>
 #include <stdint.h>
-#include <string.h>
+
+#include <iotc.h>
+#include <iotc_bsp_time.h>
+
+extern "C" {
+#include <iotc_control_topic_layer.h>
+#include <iotc_globals.h>
+#include <iotc_handle.h>
+#include <iotc_layer_api.h>
+#include <iotc_layer_default_functions.h>
+#include <iotc_layer_macros.h>
+#include <iotc_macros.h>
+#include <iotc_mqtt_codec_layer.h>
+#include <iotc_mqtt_logic_layer.h>
+
+/* not part of a header, the itests declare them the same way */
+iotc_state_t iotc_create_context_with_custom_layers(
+    iotc_context_t** context, iotc_layer_type_t layer_config[],
+    iotc_layer_type_id_t layer_chain[], size_t layer_chain_size);
+
+iotc_state_t iotc_delete_context_with_custom_layers(
+    iotc_context_t** context, iotc_layer_type_t layer_config[],
+    size_t layer_chain_size);
+}
+
+#include "iotc_fuzztest_fragmentation.h"
+
+/* The layer stack of a context without TLS, the io layer replaced by a mock
+ * socket: writes are dropped, reads are the CONNACK and then the fuzz input.
+ * A connected client subscribes and publishes with QoS 1 first, so that the
+ * input can acknowledge those, the SUBSCRIBE has message id 1 and the
+ * PUBLISH 2. */
+
+namespace {
+
+const uint8_t kConnack[] = {0x20, 0x02, 0x00, 0x00};
+const char kSubscribeTopic[] = "/devices/fuzz-device/commands/#";
+const char kPublishTopic[] = "/devices/fuzz-device/events";
+
+/* Set by the mock socket and the callbacks of the current input. */
+struct iotc_fuzztest_connection_s {
+  int connected;
+  int closed;
+} iotc_fuzztest_connection;
+
+iotc_state_t iotc_fuzztest_io_layer_push(void* context, void* data,
+                                         iotc_state_t in_out_state) {
+  IOTC_UNUSED(in_out_state);
+
+  iotc_data_desc_t* data_desc = (iotc_data_desc_t*)data;
+  iotc_free_desc(&data_desc);
+
+  return IOTC_PROCESS_PUSH_ON_NEXT_LAYER(context, NULL, IOTC_STATE_WRITTEN);
+}
+
+iotc_state_t iotc_fuzztest_io_layer_pull(void* context, void* data,
+                                         iotc_state_t in_out_state) {
+  return IOTC_PROCESS_PULL_ON_NEXT_LAYER(context, data, in_out_state);
+}
+
+iotc_state_t iotc_fuzztest_io_layer_close(void* context, void* data,
+                                          iotc_state_t in_out_state) {
+  return IOTC_PROCESS_CLOSE_EXTERNALLY_ON_THIS_LAYER(context, data,
+                                                     in_out_state);
+}
+
+iotc_state_t iotc_fuzztest_io_layer_close_externally(
+    void* context, void* data, iotc_state_t in_out_state) {
+  iotc_fuzztest_connection.closed = 1;
+
+  return IOTC_PROCESS_CLOSE_EXTERNALLY_ON_NEXT_LAYER(context, data,
+                                                     in_out_state);
+}
+
+iotc_state_t iotc_fuzztest_io_layer_init(void* context, void* data,
+                                         iotc_state_t in_out_state) {
+  return IOTC_PROCESS_CONNECT_ON_THIS_LAYER(context, data, in_out_state);
+}
+
+iotc_state_t iotc_fuzztest_io_layer_connect(void* context, void* data,
+                                            iotc_state_t in_out_state) {
+  return IOTC_PROCESS_CONNECT_ON_NEXT_LAYER(context, data, in_out_state);
+}
+
+enum iotc_fuzztest_layer_stack_order_e {
+  IOTC_LAYER_TYPE_FUZZ_IO = 0,
+  IOTC_LAYER_TYPE_FUZZ_MQTT_CODEC,
+  IOTC_LAYER_TYPE_FUZZ_MQTT_LOGIC,
+  IOTC_LAYER_TYPE_FUZZ_CONTROL_TOPIC
+};
+
+#define IOTC_FUZZTEST_LAYER_CHAIN                                    \
+  IOTC_LAYER_TYPE_FUZZ_IO                                            \
+  , IOTC_LAYER_TYPE_FUZZ_MQTT_CODEC, IOTC_LAYER_TYPE_FUZZ_MQTT_LOGIC, \
+      IOTC_LAYER_TYPE_FUZZ_CONTROL_TOPIC
+
+IOTC_DECLARE_LAYER_TYPES_BEGIN(iotc_fuzztest_layer_types)
+IOTC_LAYER_TYPES_ADD(IOTC_LAYER_TYPE_FUZZ_IO, &iotc_fuzztest_io_layer_push,
+                     &iotc_fuzztest_io_layer_pull,
+                     &iotc_fuzztest_io_layer_close,
+                     &iotc_fuzztest_io_layer_close_externally,
+                     &iotc_fuzztest_io_layer_init,
+                     &iotc_fuzztest_io_layer_connect,
+                     &iotc_layer_default_post_connect)
+, IOTC_LAYER_TYPES_ADD(
+      IOTC_LAYER_TYPE_FUZZ_MQTT_CODEC, &iotc_mqtt_codec_layer_push,
+      &iotc_mqtt_codec_layer_pull, &iotc_mqtt_codec_layer_close,
+      &iotc_mqtt_codec_layer_close_externally, &iotc_mqtt_codec_layer_init,
+      &iotc_mqtt_codec_layer_connect, &iotc_layer_default_post_connect),
+    IOTC_LAYER_TYPES_ADD(
+        IOTC_LAYER_TYPE_FUZZ_MQTT_LOGIC, &iotc_mqtt_logic_layer_push,
+        &iotc_mqtt_logic_layer_pull, &iotc_mqtt_logic_layer_close,
+        &iotc_mqtt_logic_layer_close_externally, &iotc_mqtt_logic_layer_init,
+        &iotc_mqtt_logic_layer_connect, &iotc_mqtt_logic_layer_post_connect),
+    IOTC_LAYER_TYPES_ADD(IOTC_LAYER_TYPE_FUZZ_CONTROL_TOPIC,
+                         &iotc_control_topic_layer_push,
+                         &iotc_control_topic_layer_pull,
+                         &iotc_control_topic_layer_close,
+                         &iotc_control_topic_layer_close_externally,
+                         &iotc_control_topic_layer_init,
+                         &iotc_control_topic_layer_connect,
+                         &iotc_layer_default_post_connect)
+        IOTC_DECLARE_LAYER_TYPES_END()
+
+            IOTC_DECLARE_LAYER_CHAIN_SCHEME(IOTC_LAYER_CHAIN_FUZZTEST,
+                                            IOTC_FUZZTEST_LAYER_CHAIN);
+
+void iotc_fuzztest_on_connection_state_changed(
+    iotc_context_handle_t in_context_handle, void* data, iotc_state_t state) {
+  IOTC_UNUSED(in_context_handle);
+  IOTC_UNUSED(state);
+
+  const iotc_connection_data_t* conn_data = (iotc_connection_data_t*)data;
+
+  iotc_fuzztest_connection.connected =
+      NULL != conn_data &&
+      IOTC_CONNECTION_STATE_OPENED == conn_data->connection_state;
+}
+
+void iotc_fuzztest_on_message(iotc_context_handle_t in_context_handle,
+                              iotc_sub_call_type_t call_type,
+                              const iotc_sub_call_params_t* const params,
+                              iotc_state_t state, void* user_data) {
+  IOTC_UNUSED(in_context_handle);
+  IOTC_UNUSED(call_type);
+  IOTC_UNUSED(params);
+  IOTC_UNUSED(state);
+  IOTC_UNUSED(user_data);
+}
+
+/* Runs what is due now, the clock is never moved so no timeout fires. */
+void iotc_fuzztest_step(iotc_context_t* context) {
+  iotc_evtd_step(context->context_data.evtd_instance,
+                 iotc_bsp_time_getcurrenttime_seconds());
+}
+
+/* Hands a copy of the buffer to the layer stack like a socket read. */
+void iotc_fuzztest_receive(iotc_context_t* context, const uint8_t* data,
+                           size_t size) {
+  iotc_data_desc_t* data_desc = iotc_make_desc_from_buffer_copy(data, size);
+
+  if (NULL != data_desc) {
+    IOTC_PROCESS_PULL_ON_THIS_LAYER(
+        &context->layer_chain.bottom->layer_connection, data_desc,
+        IOTC_STATE_OK);
+  }
+
+  iotc_fuzztest_step(context);
+}
+
+}  // namespace
+
+extern "C" int LLVMFuzzerInitialize(int* argc, char*** argv) {
+  IOTC_UNUSED(argc);
+  IOTC_UNUSED(argv);
+
+  return iotc_initialize();
+}
 
 /* This is the fuzzer signature, and we cannot change it */
-extern "C" int LLVMFuzzerTestOneInput( const uint8_t* data, size_t size )
-{
-    /* not implemented */
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+  if (0 == size) {
     return 0;
+  }
+
+  iotc_fuzztest_fragmentation_t fragmentation =
+      iotc_fuzztest_fragmentation_init(data[0]);
+  ++data;
+  --size;
+
+  iotc_fuzztest_connection.connected = 0;
+  iotc_fuzztest_connection.closed = 0;
+
+  iotc_state_t state = IOTC_STATE_OK;
+  iotc_context_t* context = NULL;
+  iotc_context_handle_t context_handle = IOTC_INVALID_CONTEXT_HANDLE;
+
+  IOTC_CHECK_STATE(state = iotc_create_context_with_custom_layers(
+                       &context, iotc_fuzztest_layer_types,
+                       IOTC_LAYER_CHAIN_FUZZTEST,
+                       IOTC_LAYER_CHAIN_SCHEME_LENGTH(
+                           IOTC_LAYER_CHAIN_FUZZTEST)));
+  IOTC_CHECK_STATE(state = iotc_find_handle_for_object(
+                       iotc_globals.context_handles, context,
+                       &context_handle));
+
+  IOTC_CHECK_STATE(state = iotc_connect(
+                       context_handle, "fuzz_username", "fuzz_password",
+                       "fuzz_client_id", /*connection_timeout=*/20,
+                       /*keepalive_timeout=*/20,
+                       &iotc_fuzztest_on_connection_state_changed));
+  iotc_fuzztest_step(context);
+
+  iotc_fuzztest_receive(context, kConnack, sizeof(kConnack));
+
+  if (iotc_fuzztest_connection.connected) {
+    iotc_subscribe(context_handle, kSubscribeTopic, IOTC_MQTT_QOS_AT_LEAST_ONCE,
+                   &iotc_fuzztest_on_message, NULL);
+    iotc_publish(context_handle, kPublishTopic, "fuzz",
+                 IOTC_MQTT_QOS_AT_LEAST_ONCE, NULL, NULL);
+    iotc_fuzztest_step(context);
+  }
+
+  for (size_t offset = 0;
+       offset < size && !iotc_fuzztest_connection.closed;) {
+    const size_t chunk_size =
+        iotc_fuzztest_next_chunk_size(&fragmentation, size - offset);
+
+    iotc_fuzztest_receive(context, data + offset, chunk_size);
+    offset += chunk_size;
+  }
+
+  if (iotc_fuzztest_connection.connected) {
+    iotc_shutdown_connection(context_handle);
+    iotc_fuzztest_step(context);
+  }
+
+err_handling:
+  if (NULL != context) {
+    iotc_delete_context_with_custom_layers(
+        &context, iotc_fuzztest_layer_types,
+        IOTC_LAYER_CHAIN_SCHEME_LENGTH(IOTC_LAYER_CHAIN_FUZZTEST));
+  }
+
+  return 0;
 }
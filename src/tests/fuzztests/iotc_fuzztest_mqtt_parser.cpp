@@ -14,51 +14,64 @@
  * limitations under the License.
  */
 
-#include <memory.h>
 #include <stddef.h>
 #include <stdint.h>
-#include <string.h>
 
-#include <iotc_mqtt_parser.h>
-#include <iotc_mqtt_message.h>
 #include <iotc_macros.h>
+#include <iotc_mqtt_message.h>
+#include <iotc_mqtt_parser.h>
 
-const static size_t IOTC_BUFFER_SIZE = 32;
+#include "iotc_fuzztest_fragmentation.h"
 
 /* This is the fuzzer signature, and we cannot change it */
-extern "C" int LLVMFuzzerTestOneInput( const uint8_t* data, size_t size )
-{
-    iotc_mqtt_parser_t parser;
-    iotc_state_t local_state = IOTC_STATE_OK;
-    iotc_mqtt_message_t* msg = NULL;
-
-    size_t size_eaten = 0;
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+  if (0 == size) {
+    return 0;
+  }
 
-    IOTC_ALLOC_AT( iotc_mqtt_message_t, msg, local_state );
-    iotc_mqtt_parser_init( &parser );
+  iotc_fuzztest_fragmentation_t fragmentation =
+      iotc_fuzztest_fragmentation_init(data[0]);
+  ++data;
+  --size;
 
-    while ( size_eaten != size )
-    {
-        const size_t copied_buffer_size = IOTC_MIN( IOTC_BUFFER_SIZE, ( size - size_eaten ) );
+  iotc_state_t state = IOTC_STATE_OK;
+  iotc_data_desc_t* data_desc = NULL;
+  iotc_mqtt_message_t* msg = NULL;
+  iotc_mqtt_parser_t parser;
 
-        iotc_data_desc_t* data_desc =
-            iotc_make_desc_from_buffer_copy( data + size_eaten, copied_buffer_size );
+  IOTC_ALLOC_AT(iotc_mqtt_message_t, msg, state);
+  iotc_mqtt_parser_init(&parser);
 
-        local_state = iotc_mqtt_parser_execute( &parser, msg, data_desc );
+  for (size_t offset = 0; offset < size;) {
+    const size_t chunk_size =
+        iotc_fuzztest_next_chunk_size(&fragmentation, size - offset);
 
-        if ( local_state == IOTC_STATE_OK || local_state == IOTC_MQTT_PARSER_ERROR )
-        {
-            iotc_mqtt_message_free( &msg );
-            IOTC_ALLOC_AT( iotc_mqtt_message_t, msg, local_state );
-        }
+    /* a copy of exactly the chunk, so that reads past it are caught */
+    data_desc = iotc_make_desc_from_buffer_copy(data + offset, chunk_size);
+    IOTC_CHECK_MEMORY(data_desc, state);
+    offset += chunk_size;
 
-        size_eaten += copied_buffer_size - ( data_desc->length - data_desc->curr_pos );
+    /* fed the way the MQTT codec layer feeds the parser */
+    do {
+      state = iotc_mqtt_parser_execute(&parser, msg, data_desc);
 
-        iotc_free_desc( &data_desc );
-    }
+      if (IOTC_STATE_OK == state) {
+        /* a complete message, the rest of the chunk starts the next one */
+        iotc_mqtt_message_free(&msg);
+        IOTC_ALLOC_AT(iotc_mqtt_message_t, msg, state);
+        iotc_mqtt_parser_init(&parser);
+      } else if (IOTC_STATE_WANT_READ != state) {
+        /* the codec layer drops the connection on a parser error */
+        goto err_handling;
+      }
+    } while (IOTC_STATE_OK == state && data_desc->curr_pos < data_desc->length);
 
-    iotc_mqtt_message_free( &msg );
+    iotc_free_desc(&data_desc);
+  }
 
 err_handling:
-    return 0;
+  iotc_free_desc(&data_desc);
+  iotc_mqtt_message_free(&msg);
+
+  return 0;
 }
@@ -0,0 +1,217 @@
+/* Copyright 2018-2020 Google LLC
+ *
+ * This is part of the Google Cloud IoT Device SDK for Embedded C.
+ * It is licensed under the BSD 3-Clause license; you may not use this file
+ * except in compliance with the License.
+ *
+ * You may obtain a copy of the License at:
+ *  https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Replays the corpus of a fuzz test as a benchmark: the fuzz test source is
+ * linked with this main instead of libFuzzer, so any compiler builds it.
+ * Every input is run through LLVMFuzzerTestOneInput() --runs times and the
+ * throughput is written as JSON. With the sanitizers of the fuzz_test
+ * configuration it checks that the corpus still passes, in a release build
+ * it measures how fast the inputs are processed.
+ */
+
+#include <dirent.h>
+#include <getopt.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size);
+extern "C" int LLVMFuzzerInitialize(int* argc, char*** argv)
+    __attribute__((weak));
+
+typedef std::chrono::steady_clock iotc_fuzztest_clock;
+
+namespace {
+
+struct Options {
+  uint32_t runs = 100;
+  std::string output;
+  std::vector<std::string> paths;
+};
+
+bool ReadFile(const std::string& path, std::vector<uint8_t>* content) {
+  FILE* file = fopen(path.c_str(), "rb");
+  if (file == nullptr) {
+    return false;
+  }
+
+  uint8_t buffer[4096];
+  size_t read = 0;
+  while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+    content->insert(content->end(), buffer, buffer + read);
+  }
+
+  const bool ok = !ferror(file);
+  fclose(file);
+  return ok;
+}
+
+/* Reads a file, or the files of a directory in the order of their names. */
+bool ReadInputs(const std::string& path,
+                std::vector<std::vector<uint8_t>>* inputs) {
+  struct stat path_stat;
+  if (stat(path.c_str(), &path_stat) != 0) {
+    fprintf(stderr, "could not open %s\n", path.c_str());
+    return false;
+  }
+
+  std::vector<std::string> files;
+
+  if (S_ISDIR(path_stat.st_mode)) {
+    DIR* dir = opendir(path.c_str());
+    if (dir == nullptr) {
+      fprintf(stderr, "could not open %s\n", path.c_str());
+      return false;
+    }
+
+    while (struct dirent* entry = readdir(dir)) {
+      const std::string file = path + "/" + entry->d_name;
+      struct stat file_stat;
+      if (stat(file.c_str(), &file_stat) == 0 && S_ISREG(file_stat.st_mode)) {
+        files.push_back(file);
+      }
+    }
+
+    closedir(dir);
+    std::sort(files.begin(), files.end());
+  } else {
+    files.push_back(path);
+  }
+
+  for (const std::string& file : files) {
+    std::vector<uint8_t> content;
+    if (!ReadFile(file, &content)) {
+      fprintf(stderr, "could not read %s\n", file.c_str());
+      return false;
+    }
+    inputs->push_back(content);
+  }
+
+  return true;
+}
+
+void PrintUsage(const char* name) {
+  fprintf(stderr,
+          "usage: %s [--runs N] [--output FILE] CORPUS_DIR_OR_FILE...\n",
+          name);
+}
+
+bool ParseOptions(int argc, char* argv[], Options* options) {
+  static const struct option long_options[] = {
+      {"runs", required_argument, nullptr, 'r'},
+      {"output", required_argument, nullptr, 'o'},
+      {nullptr, 0, nullptr, 0}};
+
+  int option = 0;
+  while ((option = getopt_long(argc, argv, "", long_options, nullptr)) != -1) {
+    switch (option) {
+      case 'r':
+        options->runs = (uint32_t)atoi(optarg);
+        break;
+      case 'o':
+        options->output = optarg;
+        break;
+      default:
+        return false;
+    }
+  }
+
+  for (int i = optind; i < argc; ++i) {
+    options->paths.push_back(argv[i]);
+  }
+
+  return options->runs > 0 && !options->paths.empty();
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  Options options;
+
+  if (!ParseOptions(argc, argv, &options)) {
+    PrintUsage(argv[0]);
+    return 1;
+  }
+
+  std::vector<std::vector<uint8_t>> inputs;
+  for (const std::string& path : options.paths) {
+    if (!ReadInputs(path, &inputs)) {
+      return 1;
+    }
+  }
+
+  if (inputs.empty()) {
+    fprintf(stderr, "the corpus is empty\n");
+    return 1;
+  }
+
+  uint64_t bytes = 0;
+  for (const std::vector<uint8_t>& input : inputs) {
+    bytes += input.size();
+  }
+
+  if (LLVMFuzzerInitialize != nullptr) {
+    LLVMFuzzerInitialize(&argc, &argv);
+  }
+
+  const iotc_fuzztest_clock::time_point start = iotc_fuzztest_clock::now();
+
+  for (uint32_t run = 0; run < options.runs; ++run) {
+    for (const std::vector<uint8_t>& input : inputs) {
+      LLVMFuzzerTestOneInput(input.data(), input.size());
+    }
+  }
+
+  const std::chrono::duration<double> elapsed =
+      iotc_fuzztest_clock::now() - start;
+  const double seconds = std::max(elapsed.count(), 1e-9);
+
+  FILE* out = stdout;
+
+  if (!options.output.empty() &&
+      (out = fopen(options.output.c_str(), "w")) == nullptr) {
+    fprintf(stderr, "could not open %s\n", options.output.c_str());
+    return 1;
+  }
+
+  std::string name(argv[0]);
+  name = name.substr(name.find_last_of('/') + 1);
+
+  fprintf(out, "{\n");
+  fprintf(out, "  \"fuzz_test\": \"%s\",\n", name.c_str());
+  fprintf(out, "  \"inputs\": %zu,\n", inputs.size());
+  fprintf(out, "  \"bytes\": %llu,\n", (unsigned long long)bytes);
+  fprintf(out, "  \"runs\": %u,\n", options.runs);
+  fprintf(out, "  \"seconds\": %.6f,\n", seconds);
+  fprintf(out, "  \"bytes_per_sec\": %.1f,\n",
+          bytes * options.runs / seconds);
+  fprintf(out, "  \"inputs_per_sec\": %.1f\n",
+          inputs.size() * options.runs / seconds);
+  fprintf(out, "}\n");
+
+  if (out != stdout) {
+    fclose(out);
+  }
+
+  return 0;
+}
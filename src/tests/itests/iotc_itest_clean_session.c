@@ -143,7 +143,7 @@ int iotc_itest_clean_session_setup(void** state) {
       &iotc_context, itest_cyassl_context, IOTC_LAYER_CHAIN_DEFAULT,
       IOTC_LAYER_CHAIN_DEFAULTSIZE_SUFFIX));
 
-  iotc_find_handle_for_object(iotc_globals.context_handles_vector, iotc_context,
+  iotc_find_handle_for_object(iotc_globals.context_handles, iotc_context,
                               &iotc_context_handle);
 
   return 0;
@@ -0,0 +1,313 @@
+/* Copyright 2018-2020 Google LLC
+ *
+ * This is part of the Google Cloud IoT Device SDK for Embedded C.
+ * It is licensed under the BSD 3-Clause license; you may not use this file
+ * except in compliance with the License.
+ *
+ * You may obtain a copy of the License at:
+ *  https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <iotc.h>
+#include <iotc_bsp_time.h>
+#include <iotc_layer_api.h>
+#include <iotc_layer_default_functions.h>
+#include <iotc_layer_macros.h>
+#include <iotc_macros.h>
+#include "iotc_backoff_status_api.h"
+#include "iotc_connect_scheduler.h"
+#include "iotc_globals.h"
+#include "iotc_handle.h"
+#include "iotc_itest_connect_scheduler.h"
+#include "iotc_itest_helpers.h"
+#include "iotc_memory_checks.h"
+
+#include <string.h>
+
+/**
+ * iotc_itest_connect_scheduler test suite description
+ *
+ * Two contexts share a single connect slot. Their layer chain has no control
+ * topic layer: an io layer which finishes, fails or holds the connect, and a
+ * top layer which only passes the init down. The slot has to come back from
+ * the layer chain itself, and from iotc_shutdown_connection() for a connect
+ * which never left the queue.
+ */
+
+#define IOTC_ITEST_CONNECT_SCHEDULER_CONTEXTS 2
+
+static iotc_context_t*
+    iotc_connect_scheduler_contexts[IOTC_ITEST_CONNECT_SCHEDULER_CONTEXTS];
+static iotc_context_handle_t iotc_connect_scheduler_context_handles
+    [IOTC_ITEST_CONNECT_SCHEDULER_CONTEXTS];
+
+/* What the io layer does with a connect and how many it has seen. */
+static struct iotc_itest_connect_scheduler_io_s {
+  uint8_t hold_connects;
+  iotc_state_t connect_state;
+  uint8_t started_no;
+} iotc_connect_scheduler_io;
+
+/* What the connection callback has seen. */
+static struct iotc_itest_connect_scheduler_callback_s {
+  uint8_t called_no;
+  iotc_connection_state_t connection_state;
+  iotc_state_t state;
+} iotc_connect_scheduler_callback;
+
+/* Nothing is sent or received, a connect is all the chain does. */
+iotc_state_t iotc_itest_connect_scheduler_layer_push(void* context, void* data,
+                                                     iotc_state_t in_out_state) {
+  IOTC_UNUSED(context);
+  IOTC_UNUSED(data);
+
+  return in_out_state;
+}
+
+iotc_state_t iotc_itest_connect_scheduler_layer_pull(void* context, void* data,
+                                                     iotc_state_t in_out_state) {
+  IOTC_UNUSED(context);
+  IOTC_UNUSED(data);
+
+  return in_out_state;
+}
+
+iotc_state_t iotc_itest_connect_scheduler_io_layer_init(
+    void* context, void* data, iotc_state_t in_out_state) {
+  IOTC_UNUSED(in_out_state);
+
+  iotc_connect_scheduler_io.started_no += 1;
+
+  if (iotc_connect_scheduler_io.hold_connects) {
+    return IOTC_STATE_OK;
+  }
+
+  return IOTC_PROCESS_CONNECT_ON_THIS_LAYER(
+      context, data, iotc_connect_scheduler_io.connect_state);
+}
+
+iotc_state_t iotc_itest_connect_scheduler_io_layer_connect(
+    void* context, void* data, iotc_state_t in_out_state) {
+  return IOTC_PROCESS_CONNECT_ON_NEXT_LAYER(context, data, in_out_state);
+}
+
+iotc_state_t iotc_itest_connect_scheduler_io_layer_close(
+    void* context, void* data, iotc_state_t in_out_state) {
+  return IOTC_PROCESS_CLOSE_EXTERNALLY_ON_THIS_LAYER(context, data,
+                                                     in_out_state);
+}
+
+iotc_state_t iotc_itest_connect_scheduler_io_layer_close_externally(
+    void* context, void* data, iotc_state_t in_out_state) {
+  return IOTC_PROCESS_CLOSE_EXTERNALLY_ON_NEXT_LAYER(context, data,
+                                                     in_out_state);
+}
+
+iotc_state_t iotc_itest_connect_scheduler_top_layer_init(
+    void* context, void* data, iotc_state_t in_out_state) {
+  return IOTC_PROCESS_INIT_ON_PREV_LAYER(context, data, in_out_state);
+}
+
+iotc_state_t iotc_itest_connect_scheduler_top_layer_connect(
+    void* context, void* data, iotc_state_t in_out_state) {
+  IOTC_UNUSED(context);
+  IOTC_UNUSED(data);
+
+  return in_out_state;
+}
+
+iotc_state_t iotc_itest_connect_scheduler_top_layer_close(
+    void* context, void* data, iotc_state_t in_out_state) {
+  return IOTC_PROCESS_CLOSE_ON_PREV_LAYER(context, data, in_out_state);
+}
+
+iotc_state_t iotc_itest_connect_scheduler_top_layer_close_externally(
+    void* context, void* data, iotc_state_t in_out_state) {
+  IOTC_UNUSED(context);
+  IOTC_UNUSED(data);
+
+  return in_out_state;
+}
+
+enum iotc_itest_connect_scheduler_layer_stack_order_e {
+  IOTC_LAYER_TYPE_CONNECT_SCHEDULER_IO = 0,
+  IOTC_LAYER_TYPE_CONNECT_SCHEDULER_TOP
+};
+
+#define IOTC_CONNECT_SCHEDULER_LAYER_CHAIN \
+  IOTC_LAYER_TYPE_CONNECT_SCHEDULER_IO, IOTC_LAYER_TYPE_CONNECT_SCHEDULER_TOP
+
+IOTC_DECLARE_LAYER_TYPES_BEGIN(iotc_itest_connect_scheduler_layer_types)
+IOTC_LAYER_TYPES_ADD(IOTC_LAYER_TYPE_CONNECT_SCHEDULER_IO,
+                     &iotc_itest_connect_scheduler_layer_push,
+                     &iotc_itest_connect_scheduler_layer_pull,
+                     &iotc_itest_connect_scheduler_io_layer_close,
+                     &iotc_itest_connect_scheduler_io_layer_close_externally,
+                     &iotc_itest_connect_scheduler_io_layer_init,
+                     &iotc_itest_connect_scheduler_io_layer_connect,
+                     &iotc_layer_default_post_connect)
+, IOTC_LAYER_TYPES_ADD(IOTC_LAYER_TYPE_CONNECT_SCHEDULER_TOP,
+                       &iotc_itest_connect_scheduler_layer_push,
+                     &iotc_itest_connect_scheduler_layer_pull,
+                       &iotc_itest_connect_scheduler_top_layer_close,
+                       &iotc_itest_connect_scheduler_top_layer_close_externally,
+                       &iotc_itest_connect_scheduler_top_layer_init,
+                       &iotc_itest_connect_scheduler_top_layer_connect,
+                       &iotc_layer_default_post_connect)
+      IOTC_DECLARE_LAYER_TYPES_END()
+
+          IOTC_DECLARE_LAYER_CHAIN_SCHEME(IOTC_LAYER_CHAIN_CONNECT_SCHEDULER,
+                                          IOTC_CONNECT_SCHEDULER_LAYER_CHAIN);
+
+int iotc_itest_connect_scheduler_setup(void** fixture_void) {
+  IOTC_UNUSED(fixture_void);
+
+  iotc_memory_limiter_tearup();
+
+  iotc_globals.backoff_status.backoff_lut_i = 0;
+  iotc_cancel_backoff_event();
+
+  iotc_initialize();
+
+  memset(&iotc_connect_scheduler_io, 0, sizeof(iotc_connect_scheduler_io));
+  memset(&iotc_connect_scheduler_callback, 0,
+         sizeof(iotc_connect_scheduler_callback));
+
+  size_t i = 0;
+  for (; i < IOTC_ITEST_CONNECT_SCHEDULER_CONTEXTS; ++i) {
+    IOTC_CHECK_STATE(iotc_create_context_with_custom_layers(
+        &iotc_connect_scheduler_contexts[i],
+        iotc_itest_connect_scheduler_layer_types,
+        IOTC_LAYER_CHAIN_CONNECT_SCHEDULER,
+        IOTC_LAYER_CHAIN_SCHEME_LENGTH(IOTC_LAYER_CHAIN_CONNECT_SCHEDULER)));
+
+    IOTC_CHECK_STATE(iotc_find_handle_for_object(
+        iotc_globals.context_handles, iotc_connect_scheduler_contexts[i],
+        &iotc_connect_scheduler_context_handles[i]));
+  }
+
+  iotc_set_max_concurrent_connects(1);
+
+  return 0;
+
+err_handling:
+  fail();
+
+  return 1;
+}
+
+int iotc_itest_connect_scheduler_teardown(void** fixture_void) {
+  IOTC_UNUSED(fixture_void);
+
+  iotc_set_max_concurrent_connects(IOTC_MAX_CONCURRENT_CONNECTS);
+
+  size_t i = 0;
+  for (; i < IOTC_ITEST_CONNECT_SCHEDULER_CONTEXTS; ++i) {
+    iotc_delete_context_with_custom_layers(
+        &iotc_connect_scheduler_contexts[i],
+        iotc_itest_connect_scheduler_layer_types,
+        IOTC_LAYER_CHAIN_SCHEME_LENGTH(IOTC_LAYER_CHAIN_CONNECT_SCHEDULER));
+  }
+
+  iotc_shutdown();
+
+  return !iotc_memory_limiter_teardown();
+}
+
+static void iotc_itest_connect_scheduler__on_connection_state_changed(
+    iotc_context_handle_t in_context_handle, void* data, iotc_state_t state) {
+  IOTC_UNUSED(in_context_handle);
+
+  iotc_connect_scheduler_callback.called_no += 1;
+  iotc_connect_scheduler_callback.connection_state =
+      ((iotc_connection_data_t*)data)->connection_state;
+  iotc_connect_scheduler_callback.state = state;
+}
+
+/* Runs what is due now, the contexts share the dispatcher. */
+static void iotc_itest_connect_scheduler__step(void) {
+  iotc_evtd_step(iotc_globals.evtd_instance,
+                 iotc_bsp_time_getcurrenttime_seconds());
+}
+
+static void iotc_itest_connect_scheduler__connect(size_t context_id) {
+  assert_int_equal(
+      IOTC_STATE_OK,
+      iotc_connect(iotc_connect_scheduler_context_handles[context_id],
+                   "itest_username", "itest_password", "itest_client_id",
+                   /*connection_timeout=*/20, /*keepalive_timeout=*/20,
+                   &iotc_itest_connect_scheduler__on_connection_state_changed));
+  iotc_itest_connect_scheduler__step();
+}
+
+void iotc_itest_connect_scheduler__connect_fails_without_control_topic__slot_released(
+    void** state) {
+  IOTC_UNUSED(state);
+
+  iotc_connect_scheduler_io.connect_state = IOTC_SOCKET_CONNECTION_ERROR;
+
+  iotc_itest_connect_scheduler__connect(0);
+  iotc_itest_connect_scheduler__connect(1);
+
+  /* the second connect got the slot the failed first one left */
+  assert_int_equal(2, iotc_connect_scheduler_io.started_no);
+  assert_int_equal(0, iotc_connect_scheduler_is_waiting(
+                          &iotc_connect_scheduler_contexts[1]->context_data));
+  assert_int_equal(0, iotc_globals.connect_scheduler.admitted_count);
+}
+
+void iotc_itest_connect_scheduler__connect_succeeds_without_control_topic__slot_released(
+    void** state) {
+  IOTC_UNUSED(state);
+
+  iotc_connect_scheduler_io.connect_state = IOTC_STATE_OK;
+
+  iotc_itest_connect_scheduler__connect(0);
+  iotc_itest_connect_scheduler__connect(1);
+
+  assert_int_equal(2, iotc_connect_scheduler_io.started_no);
+  assert_int_equal(0, iotc_globals.connect_scheduler.admitted_count);
+}
+
+void iotc_itest_connect_scheduler__shutdown_of_waiting_connect__callback_gets_cancelled(
+    void** state) {
+  IOTC_UNUSED(state);
+
+  /* the first connect keeps the slot */
+  iotc_connect_scheduler_io.hold_connects = 1;
+
+  iotc_itest_connect_scheduler__connect(0);
+  iotc_itest_connect_scheduler__connect(1);
+
+  assert_int_equal(1, iotc_connect_scheduler_io.started_no);
+  assert_int_equal(1, iotc_connect_scheduler_is_waiting(
+                          &iotc_connect_scheduler_contexts[1]->context_data));
+
+  assert_int_equal(IOTC_STATE_OK, iotc_shutdown_connection(
+                                      iotc_connect_scheduler_context_handles[1]));
+  iotc_itest_connect_scheduler__step();
+
+  assert_int_equal(0, iotc_connect_scheduler_is_waiting(
+                          &iotc_connect_scheduler_contexts[1]->context_data));
+  assert_int_equal(1, iotc_connect_scheduler_io.started_no);
+
+#ifndef IOTC_MODULE_THREAD_ENABLED
+  assert_int_equal(1, iotc_connect_scheduler_callback.called_no);
+  assert_int_equal(IOTC_CONNECTION_STATE_OPEN_FAILED,
+                   iotc_connect_scheduler_callback.connection_state);
+  assert_int_equal(IOTC_CONNECTION_CANCELLED_ERROR,
+                   iotc_connect_scheduler_callback.state);
+#endif
+
+  /* the cancelled context may connect again */
+  iotc_connect_scheduler_io.hold_connects = 0;
+  iotc_itest_connect_scheduler__connect(1);
+  assert_int_equal(1, iotc_connect_scheduler_is_waiting(
+                          &iotc_connect_scheduler_contexts[1]->context_data));
+}
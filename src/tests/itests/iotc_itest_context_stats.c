@@ -0,0 +1,208 @@
+/* Copyright 2018-2020 Google LLC
+ *
+ * This is part of the Google Cloud IoT Device SDK for Embedded C.
+ * It is licensed under the BSD 3-Clause license; you may not use this file
+ * except in compliance with the License.
+ *
+ * You may obtain a copy of the License at:
+ *  https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <iotc.h>
+#include <iotc_itest_mock_broker_layerchain.h>
+#include <iotc_macros.h>
+#include "iotc_backoff_status_api.h"
+#include "iotc_globals.h"
+#include "iotc_handle.h"
+#include "iotc_itest_context_stats.h"
+#include "iotc_itest_helpers.h"
+#include "iotc_itest_layerchain_ct_ml_mc.h"
+#include "iotc_memory_checks.h"
+
+/* Depends on the iotc_itest_tls_error.c */
+extern iotc_context_t* iotc_context;
+extern iotc_context_handle_t iotc_context_handle;
+extern iotc_context_t* iotc_context_mockbroker;
+/* end of dependency */
+
+/**
+ * iotc_itest_context_stats test suite description
+ *
+ * Connects the SUT layer chain of iotc_itest_tls_error.c to the mock broker,
+ * publishes a few messages then disconnects, and checks the runtime
+ * statistics of the context. The chain has no network layer so the byte
+ * counters are not part of the test.
+ */
+
+int iotc_itest_context_stats_setup(void** fixture_void) {
+  IOTC_UNUSED(fixture_void);
+
+  iotc_memory_limiter_tearup();
+
+  iotc_globals.backoff_status.backoff_lut_i = 0;
+  iotc_cancel_backoff_event();
+
+  iotc_initialize();
+
+  IOTC_CHECK_STATE(iotc_create_context_with_custom_layers(
+      &iotc_context, itest_ct_ml_mc_layer_chain, IOTC_LAYER_CHAIN_CT_ML_MC,
+      IOTC_LAYER_CHAIN_SCHEME_LENGTH(IOTC_LAYER_CHAIN_CT_ML_MC)));
+
+  iotc_find_handle_for_object(iotc_globals.context_handles, iotc_context,
+                              &iotc_context_handle);
+
+  IOTC_CHECK_STATE(iotc_create_context_with_custom_layers(
+      &iotc_context_mockbroker, itest_mock_broker_codec_layer_chain,
+      IOTC_LAYER_CHAIN_MOCK_BROKER_CODEC,
+      IOTC_LAYER_CHAIN_SCHEME_LENGTH(IOTC_LAYER_CHAIN_MOCK_BROKER_CODEC)));
+
+  return 0;
+
+err_handling:
+  fail();
+
+  return 1;
+}
+
+int iotc_itest_context_stats_teardown(void** fixture_void) {
+  IOTC_UNUSED(fixture_void);
+
+  iotc_delete_context(iotc_context_handle);
+  iotc_delete_context_with_custom_layers(
+      &iotc_context_mockbroker, itest_mock_broker_codec_layer_chain,
+      IOTC_LAYER_CHAIN_SCHEME_LENGTH(IOTC_LAYER_CHAIN_MOCK_BROKER_CODEC));
+
+  iotc_shutdown();
+
+  return !iotc_memory_limiter_teardown();
+}
+
+static void iotc_itest_context_stats__on_connection_state_changed(
+    iotc_context_handle_t in_context_handle, void* data, iotc_state_t state) {
+  IOTC_UNUSED(in_context_handle);
+  IOTC_UNUSED(data);
+  IOTC_UNUSED(state);
+}
+
+/*********************************************************************************
+ * act
+ ****************************************************************************
+ ********************************************************************************/
+static void iotc_itest_context_stats__act() {
+  {
+    /* the test concentrates on the counters, not on the messages */
+    will_return_always(iotc_mock_broker_layer__check_expected__LAYER_LEVEL,
+                       CONTROL_SKIP_CHECK_EXPECTED);
+
+    will_return_always(iotc_mock_broker_layer__check_expected__MQTT_LEVEL,
+                       CONTROL_SKIP_CHECK_EXPECTED);
+
+    will_return_always(iotc_mock_layer_tls_prev__check_expected__LAYER_LEVEL,
+                       CONTROL_SKIP_CHECK_EXPECTED);
+  }
+
+  IOTC_PROCESS_INIT_ON_THIS_LAYER(
+      &iotc_context_mockbroker->layer_chain.top->layer_connection, NULL,
+      IOTC_STATE_OK);
+
+  iotc_evtd_step(iotc_globals.evtd_instance,
+                 iotc_bsp_time_getcurrenttime_seconds());
+
+  iotc_connect(iotc_context_handle, "itest_username", "itest_password",
+               "itest_client_id", /*connection_timeout=*/20,
+               /*keepalive_timeout=*/60,
+               &iotc_itest_context_stats__on_connection_state_changed);
+
+  uint8_t loop_counter = 0;
+  while (iotc_evtd_dispatcher_continue(iotc_globals.evtd_instance) == 1 &&
+         loop_counter < 20) {
+    iotc_evtd_step(iotc_globals.evtd_instance,
+                   iotc_bsp_time_getcurrenttime_seconds() + loop_counter);
+    ++loop_counter;
+
+    if (15 == loop_counter) {
+      iotc_shutdown_connection(iotc_context_handle);
+    }
+  }
+}
+
+/*********************************************************************************
+ * test cases
+ *********************************************************************
+ ********************************************************************************/
+void iotc_itest_context_stats__invalid_arguments__rejected(void** state) {
+  IOTC_UNUSED(state);
+
+  iotc_context_stats_t stats;
+
+  assert_int_equal(IOTC_NULL_CONTEXT,
+                   iotc_get_context_stats(IOTC_INVALID_CONTEXT_HANDLE, &stats));
+  assert_int_equal(IOTC_NULL_CONTEXT,
+                   iotc_reset_context_stats(IOTC_INVALID_CONTEXT_HANDLE));
+  assert_int_equal(IOTC_INVALID_PARAMETER,
+                   iotc_get_context_stats(iotc_context_handle, NULL));
+
+  /* a fresh context has counted nothing */
+  assert_int_equal(IOTC_STATE_OK,
+                   iotc_get_context_stats(iotc_context_handle, &stats));
+  assert_int_equal(0, stats.connects);
+  assert_int_equal(0, stats.messages_sent);
+  assert_int_equal(0, stats.logic_queue_depth);
+}
+
+void iotc_itest_context_stats__connect_and_publish__counted(void** state) {
+  IOTC_UNUSED(state);
+
+  const iotc_offline_queue_config_t config = {
+      8, 0, IOTC_OFFLINE_QUEUE_DROP_OLDEST, NULL};
+
+  assert_int_equal(IOTC_STATE_OK,
+                   iotc_set_offline_queue(iotc_context_handle, &config));
+
+  /* sent once the CONNACK arrives */
+  assert_int_equal(IOTC_STATE_OK,
+                   iotc_publish(iotc_context_handle, "stats/first", "1",
+                                IOTC_MQTT_QOS_AT_LEAST_ONCE, NULL, NULL));
+  assert_int_equal(IOTC_STATE_OK,
+                   iotc_publish(iotc_context_handle, "stats/second", "2",
+                                IOTC_MQTT_QOS_AT_MOST_ONCE, NULL, NULL));
+  assert_int_equal(IOTC_STATE_OK,
+                   iotc_publish(iotc_context_handle, "stats/third", "3",
+                                IOTC_MQTT_QOS_AT_LEAST_ONCE, NULL, NULL));
+
+  iotc_itest_context_stats__act();
+
+  iotc_context_stats_t stats;
+
+  assert_int_equal(IOTC_STATE_OK,
+                   iotc_get_context_stats(iotc_context_handle, &stats));
+
+  assert_int_equal(1, stats.connects);
+  assert_int_equal(0, stats.reconnects);
+  assert_int_equal(3, stats.publishes_sent);
+  /* CONNECT, the three PUBLISHes and the DISCONNECT */
+  assert_int_equal(5, stats.messages_sent);
+  /* CONNACK and the two PUBACKs */
+  assert_int_equal(3, stats.messages_received);
+  assert_int_equal(0, stats.publishes_received);
+  assert_int_equal(0, stats.qos1_retransmits);
+  assert_int_equal(0, stats.puback_timeouts);
+  assert_int_equal(0, stats.logic_queue_depth);
+  assert_int_equal(0, stats.codec_queue_depth);
+
+  assert_int_equal(IOTC_STATE_OK,
+                   iotc_reset_context_stats(iotc_context_handle));
+  assert_int_equal(IOTC_STATE_OK,
+                   iotc_get_context_stats(iotc_context_handle, &stats));
+
+  assert_int_equal(0, stats.connects);
+  assert_int_equal(0, stats.publishes_sent);
+  assert_int_equal(0, stats.messages_sent);
+  assert_int_equal(0, stats.messages_received);
+}
@@ -0,0 +1,38 @@
+/* Copyright 2018-2020 Google LLC
+ *
+ * This is part of the Google Cloud IoT Device SDK for Embedded C.
+ * It is licensed under the BSD 3-Clause license; you may not use this file
+ * except in compliance with the License.
+ *
+ * You may obtain a copy of the License at:
+ *  https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __IOTC_ITEST_CONTEXT_STATS_H__
+#define __IOTC_ITEST_CONTEXT_STATS_H__
+
+extern int iotc_itest_context_stats_setup(void** state);
+extern int iotc_itest_context_stats_teardown(void** state);
+
+extern void iotc_itest_context_stats__invalid_arguments__rejected(
+    void** state);
+extern void iotc_itest_context_stats__connect_and_publish__counted(
+    void** state);
+
+#ifdef IOTC_MOCK_TEST_PREPROCESSOR_RUN
+struct CMUnitTest iotc_itests_context_stats[] = {
+    cmocka_unit_test_setup_teardown(
+        iotc_itest_context_stats__invalid_arguments__rejected,
+        iotc_itest_context_stats_setup, iotc_itest_context_stats_teardown),
+    cmocka_unit_test_setup_teardown(
+        iotc_itest_context_stats__connect_and_publish__counted,
+        iotc_itest_context_stats_setup, iotc_itest_context_stats_teardown)};
+#endif
+
+#endif /* __IOTC_ITEST_CONTEXT_STATS_H__ */
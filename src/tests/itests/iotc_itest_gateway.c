@@ -0,0 +1,386 @@
+/* Copyright 2018-2020 Google LLC
+ *
+ * This is part of the Google Cloud IoT Device SDK for Embedded C.
+ * It is licensed under the BSD 3-Clause license; you may not use this file
+ * except in compliance with the License.
+ *
+ * You may obtain a copy of the License at:
+ *  https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <iotc.h>
+#include <iotc_gateway.h>
+#include <iotc_itest_mock_broker_layerchain.h>
+#include <iotc_macros.h>
+#include "iotc_backoff_status_api.h"
+#include "iotc_globals.h"
+#include "iotc_handle.h"
+#include "iotc_itest_gateway.h"
+#include "iotc_itest_helpers.h"
+#include "iotc_itest_layerchain_ct_ml_mc.h"
+#include "iotc_memory_checks.h"
+#include "iotc_mqtt_logic_layer_data_helpers.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/* Depends on the iotc_itest_tls_error.c */
+extern iotc_context_t* iotc_context;
+extern iotc_context_handle_t iotc_context_handle;
+extern iotc_context_t* iotc_context_mockbroker;
+/* end of dependency */
+
+/**
+ * iotc_itest_gateway test suite description
+ *
+ * Runs the gateway API on the SUT layer chain of iotc_itest_tls_error.c. The
+ * mock broker checks the topic of every message, one CONNECT and one
+ * DISCONNECT prove that all the attached devices share the connection. Config
+ * messages are injected into the mock broker chain to check that inbound
+ * messages reach the callback of the device they are addressed to only, and
+ * none after the device was detached.
+ */
+
+static const char iotc_itest_gateway__device_a[] = "itest-device-a";
+static const char iotc_itest_gateway__device_b[] = "itest-device-b";
+
+static const char iotc_itest_gateway__inbound_topic_a[] =
+    "/devices/itest-device-a/config";
+static const char iotc_itest_gateway__inbound_topic_b[] =
+    "/devices/itest-device-b/config";
+static const char iotc_itest_gateway__inbound_payload[] = "{\"rate\":5}";
+
+/* longer than the topic buffer the gateway used to keep on the stack */
+static char iotc_itest_gateway__long_subtopic[256] = {0};
+static char iotc_itest_gateway__long_topic[sizeof("/devices/itest-device-a/") +
+                                           sizeof(
+                                               iotc_itest_gateway__long_subtopic)] =
+    {0};
+
+static uint8_t iotc_itest_gateway__messages_received_a = 0;
+static uint8_t iotc_itest_gateway__messages_received_b = 0;
+
+int iotc_itest_gateway_setup(void** fixture_void) {
+  IOTC_UNUSED(fixture_void);
+
+  iotc_memory_limiter_tearup();
+
+  iotc_globals.backoff_status.backoff_lut_i = 0;
+  iotc_cancel_backoff_event();
+
+  iotc_initialize();
+
+  IOTC_CHECK_STATE(iotc_create_context_with_custom_layers(
+      &iotc_context, itest_ct_ml_mc_layer_chain, IOTC_LAYER_CHAIN_CT_ML_MC,
+      IOTC_LAYER_CHAIN_SCHEME_LENGTH(IOTC_LAYER_CHAIN_CT_ML_MC)));
+
+  iotc_find_handle_for_object(iotc_globals.context_handles, iotc_context,
+                              &iotc_context_handle);
+
+  IOTC_CHECK_STATE(iotc_create_context_with_custom_layers(
+      &iotc_context_mockbroker, itest_mock_broker_codec_layer_chain,
+      IOTC_LAYER_CHAIN_MOCK_BROKER_CODEC,
+      IOTC_LAYER_CHAIN_SCHEME_LENGTH(IOTC_LAYER_CHAIN_MOCK_BROKER_CODEC)));
+
+  iotc_itest_gateway__messages_received_a = 0;
+  iotc_itest_gateway__messages_received_b = 0;
+
+  memset(iotc_itest_gateway__long_subtopic, 'x',
+         sizeof(iotc_itest_gateway__long_subtopic) - 1);
+  snprintf(iotc_itest_gateway__long_topic,
+           sizeof(iotc_itest_gateway__long_topic), "/devices/%s/%s",
+           iotc_itest_gateway__device_a, iotc_itest_gateway__long_subtopic);
+
+  return 0;
+
+err_handling:
+  fail();
+
+  return 1;
+}
+
+int iotc_itest_gateway_teardown(void** fixture_void) {
+  IOTC_UNUSED(fixture_void);
+
+  iotc_delete_context(iotc_context_handle);
+  iotc_delete_context_with_custom_layers(
+      &iotc_context_mockbroker, itest_mock_broker_codec_layer_chain,
+      IOTC_LAYER_CHAIN_SCHEME_LENGTH(IOTC_LAYER_CHAIN_MOCK_BROKER_CODEC));
+
+  iotc_shutdown();
+
+  return !iotc_memory_limiter_teardown();
+}
+
+static void iotc_itest_gateway__on_connection_state_changed(
+    iotc_context_handle_t in_context_handle, void* data, iotc_state_t state) {
+  IOTC_UNUSED(in_context_handle);
+  IOTC_UNUSED(data);
+  IOTC_UNUSED(state);
+}
+
+static void iotc_itest_gateway__on_config(
+    iotc_context_handle_t in_context_handle, iotc_sub_call_type_t call_type,
+    const iotc_sub_call_params_t* const params, iotc_state_t state,
+    void* user_data) {
+  IOTC_UNUSED(in_context_handle);
+  IOTC_UNUSED(state);
+
+  IOTC_UNUSED(params);
+
+  if (IOTC_SUB_CALL_MESSAGE != call_type) {
+    return;
+  }
+
+  /* counted by the callback it reached, whichever device it was meant for */
+  if (iotc_itest_gateway__device_a == user_data) {
+    ++iotc_itest_gateway__messages_received_a;
+  } else if (iotc_itest_gateway__device_b == user_data) {
+    ++iotc_itest_gateway__messages_received_b;
+  }
+}
+
+/**
+ * Plays the role of the broker sending a message to the gateway: the PUBLISH
+ * is encoded by the mock broker chain and pulled by the SUT's codec layer.
+ */
+static void iotc_itest_gateway__inject_inbound_publish(const char* topic) {
+  iotc_state_t state = IOTC_STATE_OK;
+  iotc_data_desc_t* payload = NULL;
+
+  IOTC_ALLOC(iotc_mqtt_message_t, msg_publish, state);
+
+  IOTC_CHECK_MEMORY(payload = iotc_make_desc_from_string_share(
+                        iotc_itest_gateway__inbound_payload),
+                    state);
+
+  IOTC_CHECK_STATE(
+      state = fill_with_publish_data(
+          msg_publish, topic, payload,
+          IOTC_MQTT_QOS_AT_MOST_ONCE, IOTC_MQTT_RETAIN_FALSE,
+          IOTC_MQTT_DUP_FALSE, 0));
+
+  iotc_free_desc(&payload);
+
+  IOTC_PROCESS_PUSH_ON_PREV_LAYER(
+      &iotc_context_mockbroker->layer_chain.top->layer_connection,
+      msg_publish, IOTC_STATE_OK);
+
+  return;
+
+err_handling:
+  iotc_free_desc(&payload);
+  iotc_mqtt_message_free(&msg_publish);
+  fail();
+}
+
+/*********************************************************************************
+ * act
+ ****************************************************************************
+ ********************************************************************************/
+static void iotc_itest_gateway__act() {
+  {
+    /* the test concentrates on the MQTT messages that reach the broker */
+    will_return_always(iotc_mock_broker_layer__check_expected__LAYER_LEVEL,
+                       CONTROL_SKIP_CHECK_EXPECTED);
+
+    will_return_always(iotc_mock_layer_tls_prev__check_expected__LAYER_LEVEL,
+                       CONTROL_SKIP_CHECK_EXPECTED);
+  }
+
+  IOTC_PROCESS_INIT_ON_THIS_LAYER(
+      &iotc_context_mockbroker->layer_chain.top->layer_connection, NULL,
+      IOTC_STATE_OK);
+
+  iotc_evtd_step(iotc_globals.evtd_instance,
+                 iotc_bsp_time_getcurrenttime_seconds());
+
+  const uint8_t payload[] = {'4', '2'};
+
+  iotc_connect(iotc_context_handle, "itest_username", "itest_password",
+               "itest_gateway_id", /*connection_timeout=*/20,
+               /*keepalive_timeout=*/60,
+               &iotc_itest_gateway__on_connection_state_changed);
+
+  uint8_t loop_counter = 0;
+  while (iotc_evtd_dispatcher_continue(iotc_globals.evtd_instance) == 1 &&
+         loop_counter < 30) {
+    iotc_evtd_step(iotc_globals.evtd_instance,
+                   iotc_bsp_time_getcurrenttime_seconds() + loop_counter);
+    ++loop_counter;
+
+    switch (loop_counter) {
+      case 3:
+        assert_int_equal(IOTC_STATE_OK,
+                         iotc_gateway_attach_device(
+                             iotc_context_handle, iotc_itest_gateway__device_a,
+                             NULL, NULL, NULL));
+        break;
+      case 5:
+        assert_int_equal(IOTC_STATE_OK,
+                         iotc_gateway_attach_device(
+                             iotc_context_handle, iotc_itest_gateway__device_b,
+                             "itest.device.jwt", NULL, NULL));
+        break;
+      case 7:
+        assert_int_equal(
+            IOTC_STATE_OK,
+            iotc_gateway_subscribe(
+                iotc_context_handle, iotc_itest_gateway__device_a, "config",
+                IOTC_MQTT_QOS_AT_LEAST_ONCE, &iotc_itest_gateway__on_config,
+                (void*)iotc_itest_gateway__device_a));
+        break;
+      case 9:
+        assert_int_equal(
+            IOTC_STATE_OK,
+            iotc_gateway_subscribe(
+                iotc_context_handle, iotc_itest_gateway__device_b, "config",
+                IOTC_MQTT_QOS_AT_LEAST_ONCE, &iotc_itest_gateway__on_config,
+                (void*)iotc_itest_gateway__device_b));
+        break;
+      case 11:
+        assert_int_equal(
+            IOTC_STATE_OK,
+            iotc_gateway_publish(iotc_context_handle,
+                                 iotc_itest_gateway__device_a,
+                                 iotc_itest_gateway__long_subtopic,
+                                 payload, sizeof(payload),
+                                 IOTC_MQTT_QOS_AT_LEAST_ONCE, NULL, NULL));
+        break;
+      case 13:
+        assert_int_equal(
+            IOTC_STATE_OK,
+            iotc_gateway_publish(iotc_context_handle,
+                                 iotc_itest_gateway__device_b, "state",
+                                 payload, sizeof(payload),
+                                 IOTC_MQTT_QOS_AT_MOST_ONCE, NULL, NULL));
+        break;
+      case 15:
+        iotc_itest_gateway__inject_inbound_publish(
+            iotc_itest_gateway__inbound_topic_b);
+        break;
+      case 17:
+        assert_int_equal(IOTC_STATE_OK,
+                         iotc_gateway_detach_device(
+                             iotc_context_handle, iotc_itest_gateway__device_a,
+                             NULL, NULL));
+        break;
+      case 19:
+        /* device a has no callback anymore, device b still has its own */
+        iotc_itest_gateway__inject_inbound_publish(
+            iotc_itest_gateway__inbound_topic_a);
+        iotc_itest_gateway__inject_inbound_publish(
+            iotc_itest_gateway__inbound_topic_b);
+        break;
+      case 21:
+        iotc_shutdown_connection(iotc_context_handle);
+        break;
+      default:
+        break;
+    }
+  }
+}
+
+/*********************************************************************************
+ * test cases
+ *********************************************************************
+ ********************************************************************************/
+void iotc_itest_gateway__attached_devices__share_one_connection_and_own_topics(
+    void** state) {
+  IOTC_UNUSED(state);
+
+  /* a single connection for all the devices */
+  expect_value(iotc_mock_broker_layer_pull, recvd_msg_type,
+               IOTC_MQTT_TYPE_CONNECT);
+
+  expect_value(iotc_mock_broker_layer_pull, recvd_msg_type,
+               IOTC_MQTT_TYPE_PUBLISH);
+  expect_string(iotc_mock_broker_layer_pull, publish_topic_name,
+                "/devices/itest-device-a/attach");
+
+  expect_value(iotc_mock_broker_layer_pull, recvd_msg_type,
+               IOTC_MQTT_TYPE_PUBLISH);
+  expect_string(iotc_mock_broker_layer_pull, publish_topic_name,
+                "/devices/itest-device-b/attach");
+
+  expect_value(iotc_mock_broker_layer_pull, recvd_msg_type,
+               IOTC_MQTT_TYPE_SUBSCRIBE);
+  expect_string(iotc_mock_broker_layer_pull, subscribe_topic_name,
+                "/devices/itest-device-a/config");
+
+  expect_value(iotc_mock_broker_layer_pull, recvd_msg_type,
+               IOTC_MQTT_TYPE_SUBSCRIBE);
+  expect_string(iotc_mock_broker_layer_pull, subscribe_topic_name,
+                "/devices/itest-device-b/config");
+
+  expect_value(iotc_mock_broker_layer_pull, recvd_msg_type,
+               IOTC_MQTT_TYPE_PUBLISH);
+  expect_string(iotc_mock_broker_layer_pull, publish_topic_name,
+                iotc_itest_gateway__long_topic);
+
+  expect_value(iotc_mock_broker_layer_pull, recvd_msg_type,
+               IOTC_MQTT_TYPE_PUBLISH);
+  expect_string(iotc_mock_broker_layer_pull, publish_topic_name,
+                "/devices/itest-device-b/state");
+
+  expect_value(iotc_mock_broker_layer_pull, recvd_msg_type,
+               IOTC_MQTT_TYPE_PUBLISH);
+  expect_string(iotc_mock_broker_layer_pull, publish_topic_name,
+                "/devices/itest-device-a/detach");
+
+  expect_value(iotc_mock_broker_layer_pull, recvd_msg_type,
+               IOTC_MQTT_TYPE_DISCONNECT);
+
+  iotc_itest_gateway__act();
+
+#ifndef IOTC_MODULE_THREAD_ENABLED
+  /* the configs of device b must not reach the callback of device a, nor
+   * the config of device a once it was detached */
+  assert_int_equal(0, iotc_itest_gateway__messages_received_a);
+  assert_int_equal(2, iotc_itest_gateway__messages_received_b);
+#endif
+}
+
+void iotc_itest_gateway__invalid_device_id__invalid_parameter_nothing_sent(
+    void** state) {
+  IOTC_UNUSED(state);
+
+  const uint8_t payload[] = {'4', '2'};
+  char long_device_id[IOTC_GATEWAY_DEVICE_ID_MAX_LEN + 2] = {0};
+  memset(long_device_id, 'd', sizeof(long_device_id) - 1);
+
+  assert_int_equal(IOTC_INVALID_PARAMETER,
+                   iotc_gateway_attach_device(iotc_context_handle, NULL, NULL,
+                                              NULL, NULL));
+  assert_int_equal(IOTC_INVALID_PARAMETER,
+                   iotc_gateway_attach_device(iotc_context_handle, "", NULL,
+                                              NULL, NULL));
+  assert_int_equal(IOTC_INVALID_PARAMETER,
+                   iotc_gateway_attach_device(iotc_context_handle,
+                                              long_device_id, NULL, NULL,
+                                              NULL));
+  assert_int_equal(IOTC_INVALID_PARAMETER,
+                   iotc_gateway_detach_device(iotc_context_handle, "dev/ice",
+                                              NULL, NULL));
+  assert_int_equal(
+      IOTC_INVALID_PARAMETER,
+      iotc_gateway_publish(iotc_context_handle, "dev+", "events", payload,
+                           sizeof(payload), IOTC_MQTT_QOS_AT_MOST_ONCE, NULL,
+                           NULL));
+  assert_int_equal(
+      IOTC_INVALID_PARAMETER,
+      iotc_gateway_publish(iotc_context_handle, "device", "", payload,
+                           sizeof(payload), IOTC_MQTT_QOS_AT_MOST_ONCE, NULL,
+                           NULL));
+  assert_int_equal(
+      IOTC_INVALID_PARAMETER,
+      iotc_gateway_subscribe(iotc_context_handle, "dev#", "config",
+                             IOTC_MQTT_QOS_AT_MOST_ONCE,
+                             &iotc_itest_gateway__on_config, NULL));
+}
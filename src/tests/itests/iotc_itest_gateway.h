@@ -0,0 +1,40 @@
+/* Copyright 2018-2020 Google LLC
+ *
+ * This is part of the Google Cloud IoT Device SDK for Embedded C.
+ * It is licensed under the BSD 3-Clause license; you may not use this file
+ * except in compliance with the License.
+ *
+ * You may obtain a copy of the License at:
+ *  https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __IOTC_ITEST_GATEWAY_H__
+#define __IOTC_ITEST_GATEWAY_H__
+
+extern int iotc_itest_gateway_setup(void** state);
+extern int iotc_itest_gateway_teardown(void** state);
+
+extern void
+iotc_itest_gateway__attached_devices__share_one_connection_and_own_topics(
+    void** state);
+extern void
+iotc_itest_gateway__invalid_device_id__invalid_parameter_nothing_sent(
+    void** state);
+
+#ifdef IOTC_MOCK_TEST_PREPROCESSOR_RUN
+struct CMUnitTest iotc_itests_gateway[] = {
+    cmocka_unit_test_setup_teardown(
+        iotc_itest_gateway__attached_devices__share_one_connection_and_own_topics,
+        iotc_itest_gateway_setup, iotc_itest_gateway_teardown),
+    cmocka_unit_test_setup_teardown(
+        iotc_itest_gateway__invalid_device_id__invalid_parameter_nothing_sent,
+        iotc_itest_gateway_setup, iotc_itest_gateway_teardown)};
+#endif
+
+#endif /* __IOTC_ITEST_GATEWAY_H__ */
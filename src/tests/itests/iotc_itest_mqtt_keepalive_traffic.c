@@ -0,0 +1,324 @@
+/* Copyright 2018-2020 Google LLC
+ *
+ * This is part of the Google Cloud IoT Device SDK for Embedded C.
+ * It is licensed under the BSD 3-Clause license; you may not use this file
+ * except in compliance with the License.
+ *
+ * You may obtain a copy of the License at:
+ *  https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <iotc.h>
+#include <iotc_bsp_time.h>
+#include <iotc_control_topic_layer.h>
+#include <iotc_layer_api.h>
+#include <iotc_layer_default_functions.h>
+#include <iotc_layer_macros.h>
+#include <iotc_macros.h>
+#include <iotc_mqtt_codec_layer.h>
+#include <iotc_mqtt_logic_layer.h>
+#include "iotc_backoff_status_api.h"
+#include "iotc_globals.h"
+#include "iotc_handle.h"
+#include "iotc_itest_helpers.h"
+#include "iotc_itest_mqtt_keepalive_traffic.h"
+#include "iotc_memory_checks.h"
+
+/**
+ * iotc_itest_mqtt_keepalive_traffic test suite description
+ *
+ * The keepalive only has to send a PINGREQ if nothing else was sent for a
+ * keepalive period. The io layer at the bottom of the chain writes everything
+ * right away and notes when each PINGREQ was written, the broker's packets are
+ * handed to the MQTT codec in place of a socket read. The test drives the
+ * event dispatcher's clock itself.
+ */
+
+#define IOTC_KEEPALIVE_TRAFFIC_KEEPALIVE_SEC 5
+
+static iotc_context_t* iotc_keepalive_traffic_context = NULL;
+static iotc_context_handle_t iotc_keepalive_traffic_context_handle =
+    IOTC_INVALID_CONTEXT_HANDLE;
+
+/* The clock of the test, seconds since the connect. */
+static iotc_time_t iotc_keepalive_traffic_start = 0;
+
+static struct iotc_itest_keepalive_traffic_io_s {
+  uint8_t pingreq_no;
+  iotc_time_t last_pingreq_time;
+} iotc_keepalive_traffic_io;
+
+static const uint8_t iotc_keepalive_traffic_connack[] = {0x20, 0x02, 0x00,
+                                                         0x00};
+static const uint8_t iotc_keepalive_traffic_pingresp[] = {0xD0, 0x00};
+
+iotc_state_t iotc_itest_keepalive_traffic_io_layer_push(
+    void* context, void* data, iotc_state_t in_out_state) {
+  IOTC_UNUSED(in_out_state);
+
+  iotc_data_desc_t* data_desc = (iotc_data_desc_t*)data;
+
+  if (NULL != data_desc && 0 < data_desc->length &&
+      IOTC_MQTT_TYPE_PINGREQ == (data_desc->data_ptr[0] >> 4)) {
+    iotc_keepalive_traffic_io.pingreq_no += 1;
+    iotc_keepalive_traffic_io.last_pingreq_time =
+        IOTC_CONTEXT_DATA(context)->evtd_instance->current_step -
+        iotc_keepalive_traffic_start;
+  }
+
+  iotc_free_desc(&data_desc);
+
+  return IOTC_PROCESS_PUSH_ON_NEXT_LAYER(context, NULL, IOTC_STATE_WRITTEN);
+}
+
+iotc_state_t iotc_itest_keepalive_traffic_io_layer_pull(
+    void* context, void* data, iotc_state_t in_out_state) {
+  return IOTC_PROCESS_PULL_ON_NEXT_LAYER(context, data, in_out_state);
+}
+
+iotc_state_t iotc_itest_keepalive_traffic_io_layer_close(
+    void* context, void* data, iotc_state_t in_out_state) {
+  return IOTC_PROCESS_CLOSE_EXTERNALLY_ON_THIS_LAYER(context, data,
+                                                     in_out_state);
+}
+
+iotc_state_t iotc_itest_keepalive_traffic_io_layer_close_externally(
+    void* context, void* data, iotc_state_t in_out_state) {
+  return IOTC_PROCESS_CLOSE_EXTERNALLY_ON_NEXT_LAYER(context, data,
+                                                     in_out_state);
+}
+
+iotc_state_t iotc_itest_keepalive_traffic_io_layer_init(
+    void* context, void* data, iotc_state_t in_out_state) {
+  return IOTC_PROCESS_CONNECT_ON_THIS_LAYER(context, data, in_out_state);
+}
+
+iotc_state_t iotc_itest_keepalive_traffic_io_layer_connect(
+    void* context, void* data, iotc_state_t in_out_state) {
+  return IOTC_PROCESS_CONNECT_ON_NEXT_LAYER(context, data, in_out_state);
+}
+
+enum iotc_itest_keepalive_traffic_layer_stack_order_e {
+  IOTC_LAYER_TYPE_KEEPALIVE_TRAFFIC_IO = 0,
+  IOTC_LAYER_TYPE_KEEPALIVE_TRAFFIC_MQTT_CODEC,
+  IOTC_LAYER_TYPE_KEEPALIVE_TRAFFIC_MQTT_LOGIC,
+  IOTC_LAYER_TYPE_KEEPALIVE_TRAFFIC_CONTROL_TOPIC
+};
+
+#define IOTC_KEEPALIVE_TRAFFIC_LAYER_CHAIN          \
+  IOTC_LAYER_TYPE_KEEPALIVE_TRAFFIC_IO              \
+  , IOTC_LAYER_TYPE_KEEPALIVE_TRAFFIC_MQTT_CODEC,   \
+      IOTC_LAYER_TYPE_KEEPALIVE_TRAFFIC_MQTT_LOGIC, \
+      IOTC_LAYER_TYPE_KEEPALIVE_TRAFFIC_CONTROL_TOPIC
+
+IOTC_DECLARE_LAYER_TYPES_BEGIN(iotc_itest_keepalive_traffic_layer_types)
+IOTC_LAYER_TYPES_ADD(IOTC_LAYER_TYPE_KEEPALIVE_TRAFFIC_IO,
+                     &iotc_itest_keepalive_traffic_io_layer_push,
+                     &iotc_itest_keepalive_traffic_io_layer_pull,
+                     &iotc_itest_keepalive_traffic_io_layer_close,
+                     &iotc_itest_keepalive_traffic_io_layer_close_externally,
+                     &iotc_itest_keepalive_traffic_io_layer_init,
+                     &iotc_itest_keepalive_traffic_io_layer_connect,
+                     &iotc_layer_default_post_connect)
+, IOTC_LAYER_TYPES_ADD(IOTC_LAYER_TYPE_KEEPALIVE_TRAFFIC_MQTT_CODEC,
+                       &iotc_mqtt_codec_layer_push,
+                       &iotc_mqtt_codec_layer_pull,
+                       &iotc_mqtt_codec_layer_close,
+                       &iotc_mqtt_codec_layer_close_externally,
+                       &iotc_mqtt_codec_layer_init,
+                       &iotc_mqtt_codec_layer_connect,
+                       &iotc_layer_default_post_connect),
+    IOTC_LAYER_TYPES_ADD(IOTC_LAYER_TYPE_KEEPALIVE_TRAFFIC_MQTT_LOGIC,
+                         &iotc_mqtt_logic_layer_push,
+                         &iotc_mqtt_logic_layer_pull,
+                         &iotc_mqtt_logic_layer_close,
+                         &iotc_mqtt_logic_layer_close_externally,
+                         &iotc_mqtt_logic_layer_init,
+                         &iotc_mqtt_logic_layer_connect,
+                         &iotc_mqtt_logic_layer_post_connect),
+    IOTC_LAYER_TYPES_ADD(IOTC_LAYER_TYPE_KEEPALIVE_TRAFFIC_CONTROL_TOPIC,
+                         &iotc_control_topic_layer_push,
+                         &iotc_control_topic_layer_pull,
+                         &iotc_control_topic_layer_close,
+                         &iotc_control_topic_layer_close_externally,
+                         &iotc_control_topic_layer_init,
+                         &iotc_control_topic_layer_connect,
+                         &iotc_layer_default_post_connect)
+        IOTC_DECLARE_LAYER_TYPES_END()
+
+            IOTC_DECLARE_LAYER_CHAIN_SCHEME(IOTC_LAYER_CHAIN_KEEPALIVE_TRAFFIC,
+                                            IOTC_KEEPALIVE_TRAFFIC_LAYER_CHAIN);
+
+int iotc_itest_mqtt_keepalive_traffic_setup(void** fixture_void) {
+  IOTC_UNUSED(fixture_void);
+
+  iotc_memory_limiter_tearup();
+
+  iotc_globals.backoff_status.backoff_lut_i = 0;
+  iotc_cancel_backoff_event();
+
+  iotc_initialize();
+
+  iotc_keepalive_traffic_io.pingreq_no = 0;
+  iotc_keepalive_traffic_io.last_pingreq_time = 0;
+
+  IOTC_CHECK_STATE(iotc_create_context_with_custom_layers(
+      &iotc_keepalive_traffic_context, iotc_itest_keepalive_traffic_layer_types,
+      IOTC_LAYER_CHAIN_KEEPALIVE_TRAFFIC,
+      IOTC_LAYER_CHAIN_SCHEME_LENGTH(IOTC_LAYER_CHAIN_KEEPALIVE_TRAFFIC)));
+
+  IOTC_CHECK_STATE(iotc_find_handle_for_object(
+      iotc_globals.context_handles, iotc_keepalive_traffic_context,
+      &iotc_keepalive_traffic_context_handle));
+
+  return 0;
+
+err_handling:
+  fail();
+
+  return 1;
+}
+
+int iotc_itest_mqtt_keepalive_traffic_teardown(void** fixture_void) {
+  IOTC_UNUSED(fixture_void);
+
+  iotc_delete_context_with_custom_layers(
+      &iotc_keepalive_traffic_context, iotc_itest_keepalive_traffic_layer_types,
+      IOTC_LAYER_CHAIN_SCHEME_LENGTH(IOTC_LAYER_CHAIN_KEEPALIVE_TRAFFIC));
+
+  iotc_shutdown();
+
+  return !iotc_memory_limiter_teardown();
+}
+
+static void iotc_itest_mqtt_keepalive_traffic__on_connection_state_changed(
+    iotc_context_handle_t in_context_handle, void* data, iotc_state_t state) {
+  IOTC_UNUSED(in_context_handle);
+  IOTC_UNUSED(data);
+  IOTC_UNUSED(state);
+}
+
+/* Runs what is due at the given second of the test's clock. */
+static void iotc_itest_mqtt_keepalive_traffic__step(iotc_time_t time) {
+  iotc_evtd_step(iotc_keepalive_traffic_context->context_data.evtd_instance,
+                 iotc_keepalive_traffic_start + time);
+}
+
+/* Hands a copy of the packet to the codec like a socket read. */
+static void iotc_itest_mqtt_keepalive_traffic__receive(const uint8_t* packet,
+                                                       size_t packet_size,
+                                                       iotc_time_t time) {
+  iotc_data_desc_t* data_desc =
+      iotc_make_desc_from_buffer_copy(packet, packet_size);
+  assert_non_null(data_desc);
+
+  IOTC_PROCESS_PULL_ON_THIS_LAYER(
+      &iotc_keepalive_traffic_context->layer_chain.bottom->layer_connection,
+      data_desc, IOTC_STATE_OK);
+
+  iotc_itest_mqtt_keepalive_traffic__step(time);
+}
+
+/* Connects at second 0 of the test's clock. */
+static void iotc_itest_mqtt_keepalive_traffic__connect(void) {
+  iotc_keepalive_traffic_start = iotc_bsp_time_getcurrenttime_seconds();
+
+  iotc_connect(iotc_keepalive_traffic_context_handle, "itest_username",
+               "itest_password", "itest_client_id", /*connection_timeout=*/20,
+               IOTC_KEEPALIVE_TRAFFIC_KEEPALIVE_SEC,
+               &iotc_itest_mqtt_keepalive_traffic__on_connection_state_changed);
+  iotc_itest_mqtt_keepalive_traffic__step(0);
+
+  iotc_itest_mqtt_keepalive_traffic__receive(
+      iotc_keepalive_traffic_connack, sizeof(iotc_keepalive_traffic_connack),
+      0);
+
+  assert_int_equal(1, iotc_is_context_connected(
+                          iotc_keepalive_traffic_context_handle));
+}
+
+static void iotc_itest_mqtt_keepalive_traffic__disconnect(iotc_time_t time) {
+  iotc_shutdown_connection(iotc_keepalive_traffic_context_handle);
+  iotc_itest_mqtt_keepalive_traffic__step(time);
+}
+
+/*********************************************************************************
+ * test cases
+ ********************************************************************************/
+void iotc_itest_mqtt_keepalive_traffic__publish_within_keepalive__PINGREQ_postponed(
+    void** fixture_void) {
+  IOTC_UNUSED(fixture_void);
+
+  iotc_itest_mqtt_keepalive_traffic__connect();
+
+  iotc_itest_mqtt_keepalive_traffic__step(3);
+  assert_int_equal(
+      IOTC_STATE_OK,
+      iotc_publish(iotc_keepalive_traffic_context_handle, "t", "keepalive",
+                   IOTC_MQTT_QOS_AT_MOST_ONCE, NULL, NULL));
+  iotc_itest_mqtt_keepalive_traffic__step(3);
+
+  /* the keepalive period since the CONNECT is over, not the one since the
+   * PUBLISH */
+  iotc_itest_mqtt_keepalive_traffic__step(IOTC_KEEPALIVE_TRAFFIC_KEEPALIVE_SEC);
+  iotc_itest_mqtt_keepalive_traffic__step(
+      IOTC_KEEPALIVE_TRAFFIC_KEEPALIVE_SEC + 2);
+  assert_int_equal(0, iotc_keepalive_traffic_io.pingreq_no);
+
+  iotc_itest_mqtt_keepalive_traffic__step(
+      3 + IOTC_KEEPALIVE_TRAFFIC_KEEPALIVE_SEC);
+  assert_int_equal(1, iotc_keepalive_traffic_io.pingreq_no);
+  assert_int_equal(3 + IOTC_KEEPALIVE_TRAFFIC_KEEPALIVE_SEC,
+                   iotc_keepalive_traffic_io.last_pingreq_time);
+
+  iotc_itest_mqtt_keepalive_traffic__receive(
+      iotc_keepalive_traffic_pingresp, sizeof(iotc_keepalive_traffic_pingresp),
+      3 + IOTC_KEEPALIVE_TRAFFIC_KEEPALIVE_SEC);
+
+  iotc_itest_mqtt_keepalive_traffic__disconnect(
+      3 + IOTC_KEEPALIVE_TRAFFIC_KEEPALIVE_SEC);
+}
+
+void iotc_itest_mqtt_keepalive_traffic__idle_connection__PINGREQ_every_keepalive(
+    void** fixture_void) {
+  IOTC_UNUSED(fixture_void);
+
+  iotc_itest_mqtt_keepalive_traffic__connect();
+
+  iotc_itest_mqtt_keepalive_traffic__step(IOTC_KEEPALIVE_TRAFFIC_KEEPALIVE_SEC -
+                                          1);
+  assert_int_equal(0, iotc_keepalive_traffic_io.pingreq_no);
+
+  iotc_itest_mqtt_keepalive_traffic__step(IOTC_KEEPALIVE_TRAFFIC_KEEPALIVE_SEC);
+  assert_int_equal(1, iotc_keepalive_traffic_io.pingreq_no);
+  assert_int_equal(IOTC_KEEPALIVE_TRAFFIC_KEEPALIVE_SEC,
+                   iotc_keepalive_traffic_io.last_pingreq_time);
+
+  iotc_itest_mqtt_keepalive_traffic__receive(
+      iotc_keepalive_traffic_pingresp, sizeof(iotc_keepalive_traffic_pingresp),
+      IOTC_KEEPALIVE_TRAFFIC_KEEPALIVE_SEC);
+
+  /* the PINGREQ itself is traffic, the next one is a period after it */
+  iotc_itest_mqtt_keepalive_traffic__step(
+      2 * IOTC_KEEPALIVE_TRAFFIC_KEEPALIVE_SEC - 1);
+  assert_int_equal(1, iotc_keepalive_traffic_io.pingreq_no);
+
+  iotc_itest_mqtt_keepalive_traffic__step(2 *
+                                          IOTC_KEEPALIVE_TRAFFIC_KEEPALIVE_SEC);
+  assert_int_equal(2, iotc_keepalive_traffic_io.pingreq_no);
+  assert_int_equal(2 * IOTC_KEEPALIVE_TRAFFIC_KEEPALIVE_SEC,
+                   iotc_keepalive_traffic_io.last_pingreq_time);
+
+  iotc_itest_mqtt_keepalive_traffic__receive(
+      iotc_keepalive_traffic_pingresp, sizeof(iotc_keepalive_traffic_pingresp),
+      2 * IOTC_KEEPALIVE_TRAFFIC_KEEPALIVE_SEC);
+
+  iotc_itest_mqtt_keepalive_traffic__disconnect(
+      2 * IOTC_KEEPALIVE_TRAFFIC_KEEPALIVE_SEC);
+}
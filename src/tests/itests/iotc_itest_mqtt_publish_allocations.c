@@ -0,0 +1,297 @@
+/* Copyright 2018-2020 Google LLC
+ *
+ * This is part of the Google Cloud IoT Device SDK for Embedded C.
+ * It is licensed under the BSD 3-Clause license; you may not use this file
+ * except in compliance with the License.
+ *
+ * You may obtain a copy of the License at:
+ *  https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <iotc.h>
+#include <iotc_control_topic_layer.h>
+#include <iotc_layer_api.h>
+#include <iotc_layer_default_functions.h>
+#include <iotc_layer_macros.h>
+#include <iotc_macros.h>
+#include <iotc_mqtt_codec_layer.h>
+#include <iotc_mqtt_logic_layer.h>
+#include "iotc_backoff_status_api.h"
+#include "iotc_globals.h"
+#include "iotc_handle.h"
+#include "iotc_itest_helpers.h"
+#include "iotc_itest_mqtt_publish_allocations.h"
+#include "iotc_memory_checks.h"
+
+#if defined(IOTC_MEMORY_LIMITER_ENABLED) && !defined(IOTC_MODULE_THREAD_ENABLED)
+
+/**
+ * iotc_itest_mqtt_publish_allocations test suite description
+ *
+ * Counts the heap allocations of a single QoS0 publish, from iotc_publish()
+ * until the user's callback reported the write. The io layer at the bottom of
+ * the chain writes everything right away, so the count covers the SDK's own
+ * layers only: the socket and TLS layers of a real connection aren't part of
+ * it.
+ */
+
+/* the payload copy, the topic handed to the event loop, the PUBLISH message
+ * taking it over, the codec's write bookkeeping, the serialized packet and one
+ * event dispatcher queue element for each hop and deferred call from
+ * iotc_publish() up to the user's callback */
+#define IOTC_PUBLISH_ALLOCATIONS_Q0_FAST_PATH 18
+
+/* the logic task, its publish data and its own topic copy take the place of
+ * the desc wrapping the topic, the PUBLISH message shares both descs with the
+ * task */
+#define IOTC_PUBLISH_ALLOCATIONS_Q0_TASK_PATH 22
+
+static iotc_context_t* iotc_publish_allocations_context = NULL;
+static iotc_context_handle_t iotc_publish_allocations_context_handle =
+    IOTC_INVALID_CONTEXT_HANDLE;
+
+static uint8_t iotc_publish_allocations_callback_no = 0;
+
+static const uint8_t iotc_publish_allocations_connack[] = {0x20, 0x02, 0x00,
+                                                           0x00};
+
+iotc_state_t iotc_itest_publish_allocations_io_layer_push(
+    void* context, void* data, iotc_state_t in_out_state) {
+  IOTC_UNUSED(in_out_state);
+
+  iotc_data_desc_t* data_desc = (iotc_data_desc_t*)data;
+  iotc_free_desc(&data_desc);
+
+  return IOTC_PROCESS_PUSH_ON_NEXT_LAYER(context, NULL, IOTC_STATE_WRITTEN);
+}
+
+iotc_state_t iotc_itest_publish_allocations_io_layer_pull(
+    void* context, void* data, iotc_state_t in_out_state) {
+  return IOTC_PROCESS_PULL_ON_NEXT_LAYER(context, data, in_out_state);
+}
+
+iotc_state_t iotc_itest_publish_allocations_io_layer_close(
+    void* context, void* data, iotc_state_t in_out_state) {
+  return IOTC_PROCESS_CLOSE_EXTERNALLY_ON_THIS_LAYER(context, data,
+                                                     in_out_state);
+}
+
+iotc_state_t iotc_itest_publish_allocations_io_layer_close_externally(
+    void* context, void* data, iotc_state_t in_out_state) {
+  return IOTC_PROCESS_CLOSE_EXTERNALLY_ON_NEXT_LAYER(context, data,
+                                                     in_out_state);
+}
+
+iotc_state_t iotc_itest_publish_allocations_io_layer_init(
+    void* context, void* data, iotc_state_t in_out_state) {
+  return IOTC_PROCESS_CONNECT_ON_THIS_LAYER(context, data, in_out_state);
+}
+
+iotc_state_t iotc_itest_publish_allocations_io_layer_connect(
+    void* context, void* data, iotc_state_t in_out_state) {
+  return IOTC_PROCESS_CONNECT_ON_NEXT_LAYER(context, data, in_out_state);
+}
+
+enum iotc_itest_publish_allocations_layer_stack_order_e {
+  IOTC_LAYER_TYPE_PUBLISH_ALLOCATIONS_IO = 0,
+  IOTC_LAYER_TYPE_PUBLISH_ALLOCATIONS_MQTT_CODEC,
+  IOTC_LAYER_TYPE_PUBLISH_ALLOCATIONS_MQTT_LOGIC,
+  IOTC_LAYER_TYPE_PUBLISH_ALLOCATIONS_CONTROL_TOPIC
+};
+
+#define IOTC_PUBLISH_ALLOCATIONS_LAYER_CHAIN          \
+  IOTC_LAYER_TYPE_PUBLISH_ALLOCATIONS_IO              \
+  , IOTC_LAYER_TYPE_PUBLISH_ALLOCATIONS_MQTT_CODEC,   \
+      IOTC_LAYER_TYPE_PUBLISH_ALLOCATIONS_MQTT_LOGIC, \
+      IOTC_LAYER_TYPE_PUBLISH_ALLOCATIONS_CONTROL_TOPIC
+
+IOTC_DECLARE_LAYER_TYPES_BEGIN(iotc_itest_publish_allocations_layer_types)
+IOTC_LAYER_TYPES_ADD(IOTC_LAYER_TYPE_PUBLISH_ALLOCATIONS_IO,
+                     &iotc_itest_publish_allocations_io_layer_push,
+                     &iotc_itest_publish_allocations_io_layer_pull,
+                     &iotc_itest_publish_allocations_io_layer_close,
+                     &iotc_itest_publish_allocations_io_layer_close_externally,
+                     &iotc_itest_publish_allocations_io_layer_init,
+                     &iotc_itest_publish_allocations_io_layer_connect,
+                     &iotc_layer_default_post_connect)
+, IOTC_LAYER_TYPES_ADD(IOTC_LAYER_TYPE_PUBLISH_ALLOCATIONS_MQTT_CODEC,
+                       &iotc_mqtt_codec_layer_push,
+                       &iotc_mqtt_codec_layer_pull,
+                       &iotc_mqtt_codec_layer_close,
+                       &iotc_mqtt_codec_layer_close_externally,
+                       &iotc_mqtt_codec_layer_init,
+                       &iotc_mqtt_codec_layer_connect,
+                       &iotc_layer_default_post_connect),
+    IOTC_LAYER_TYPES_ADD(IOTC_LAYER_TYPE_PUBLISH_ALLOCATIONS_MQTT_LOGIC,
+                         &iotc_mqtt_logic_layer_push,
+                         &iotc_mqtt_logic_layer_pull,
+                         &iotc_mqtt_logic_layer_close,
+                         &iotc_mqtt_logic_layer_close_externally,
+                         &iotc_mqtt_logic_layer_init,
+                         &iotc_mqtt_logic_layer_connect,
+                         &iotc_mqtt_logic_layer_post_connect),
+    IOTC_LAYER_TYPES_ADD(IOTC_LAYER_TYPE_PUBLISH_ALLOCATIONS_CONTROL_TOPIC,
+                         &iotc_control_topic_layer_push,
+                         &iotc_control_topic_layer_pull,
+                         &iotc_control_topic_layer_close,
+                         &iotc_control_topic_layer_close_externally,
+                         &iotc_control_topic_layer_init,
+                         &iotc_control_topic_layer_connect,
+                         &iotc_layer_default_post_connect)
+        IOTC_DECLARE_LAYER_TYPES_END()
+
+            IOTC_DECLARE_LAYER_CHAIN_SCHEME(
+                IOTC_LAYER_CHAIN_PUBLISH_ALLOCATIONS,
+                IOTC_PUBLISH_ALLOCATIONS_LAYER_CHAIN);
+
+int iotc_itest_mqtt_publish_allocations_setup(void** fixture_void) {
+  IOTC_UNUSED(fixture_void);
+
+  iotc_memory_limiter_tearup();
+
+  iotc_globals.backoff_status.backoff_lut_i = 0;
+  iotc_cancel_backoff_event();
+
+  iotc_initialize();
+
+  iotc_publish_allocations_callback_no = 0;
+
+  IOTC_CHECK_STATE(iotc_create_context_with_custom_layers(
+      &iotc_publish_allocations_context,
+      iotc_itest_publish_allocations_layer_types,
+      IOTC_LAYER_CHAIN_PUBLISH_ALLOCATIONS,
+      IOTC_LAYER_CHAIN_SCHEME_LENGTH(IOTC_LAYER_CHAIN_PUBLISH_ALLOCATIONS)));
+
+  IOTC_CHECK_STATE(iotc_find_handle_for_object(
+      iotc_globals.context_handles, iotc_publish_allocations_context,
+      &iotc_publish_allocations_context_handle));
+
+  return 0;
+
+err_handling:
+  fail();
+
+  return 1;
+}
+
+int iotc_itest_mqtt_publish_allocations_teardown(void** fixture_void) {
+  IOTC_UNUSED(fixture_void);
+
+  iotc_delete_context_with_custom_layers(
+      &iotc_publish_allocations_context,
+      iotc_itest_publish_allocations_layer_types,
+      IOTC_LAYER_CHAIN_SCHEME_LENGTH(IOTC_LAYER_CHAIN_PUBLISH_ALLOCATIONS));
+
+  iotc_shutdown();
+
+  return !iotc_memory_limiter_teardown();
+}
+
+static void iotc_itest_mqtt_publish_allocations__on_connection_state_changed(
+    iotc_context_handle_t in_context_handle, void* data, iotc_state_t state) {
+  IOTC_UNUSED(in_context_handle);
+  IOTC_UNUSED(data);
+  IOTC_UNUSED(state);
+}
+
+static void iotc_itest_mqtt_publish_allocations__on_publish(
+    iotc_context_handle_t in_context_handle, void* data, iotc_state_t state) {
+  IOTC_UNUSED(in_context_handle);
+  IOTC_UNUSED(data);
+
+  assert_int_equal(IOTC_STATE_OK, state);
+  iotc_publish_allocations_callback_no += 1;
+}
+
+static void iotc_itest_mqtt_publish_allocations__step(void) {
+  iotc_evtd_step(iotc_publish_allocations_context->context_data.evtd_instance,
+                 iotc_bsp_time_getcurrenttime_seconds());
+}
+
+static void iotc_itest_mqtt_publish_allocations__connect(void) {
+  iotc_connect(iotc_publish_allocations_context_handle, "itest_username",
+               "itest_password", "itest_client_id", /*connection_timeout=*/20,
+               /*keepalive_timeout=*/0,
+               &iotc_itest_mqtt_publish_allocations__on_connection_state_changed);
+  iotc_itest_mqtt_publish_allocations__step();
+
+  /* the CONNACK is handed to the codec like a socket read */
+  iotc_data_desc_t* data_desc = iotc_make_desc_from_buffer_copy(
+      iotc_publish_allocations_connack,
+      sizeof(iotc_publish_allocations_connack));
+  assert_non_null(data_desc);
+
+  IOTC_PROCESS_PULL_ON_THIS_LAYER(
+      &iotc_publish_allocations_context->layer_chain.bottom->layer_connection,
+      data_desc, IOTC_STATE_OK);
+  iotc_itest_mqtt_publish_allocations__step();
+
+  assert_int_equal(1, iotc_is_context_connected(
+                          iotc_publish_allocations_context_handle));
+}
+
+static void iotc_itest_mqtt_publish_allocations__disconnect(void) {
+  iotc_shutdown_connection(iotc_publish_allocations_context_handle);
+  iotc_itest_mqtt_publish_allocations__step();
+}
+
+static void iotc_itest_mqtt_publish_allocations__publish(void) {
+  assert_int_equal(
+      IOTC_STATE_OK,
+      iotc_publish(iotc_publish_allocations_context_handle, "t", "telemetry",
+                   IOTC_MQTT_QOS_AT_MOST_ONCE,
+                   &iotc_itest_mqtt_publish_allocations__on_publish, NULL));
+}
+
+/*********************************************************************************
+ * test cases
+ ********************************************************************************/
+void iotc_itest_mqtt_publish_allocations__q0_idle_lane__fast_path_allocations(
+    void** fixture_void) {
+  IOTC_UNUSED(fixture_void);
+
+  iotc_itest_mqtt_publish_allocations__connect();
+
+  const size_t allocation_count = iotc_memory_limiter_get_allocation_count();
+
+  iotc_itest_mqtt_publish_allocations__publish();
+  iotc_itest_mqtt_publish_allocations__step();
+
+  assert_int_equal(1, iotc_publish_allocations_callback_no);
+  assert_int_equal(
+      IOTC_PUBLISH_ALLOCATIONS_Q0_FAST_PATH,
+      iotc_memory_limiter_get_allocation_count() - allocation_count);
+
+  iotc_itest_mqtt_publish_allocations__disconnect();
+}
+
+void iotc_itest_mqtt_publish_allocations__q0_busy_lane__task_path_allocations(
+    void** fixture_void) {
+  IOTC_UNUSED(fixture_void);
+
+  iotc_itest_mqtt_publish_allocations__connect();
+
+  const size_t allocation_count = iotc_memory_limiter_get_allocation_count();
+
+  /* the first publish occupies the q0 lane until it is written, the second
+   * one has to queue a logic task behind it */
+  iotc_itest_mqtt_publish_allocations__publish();
+  iotc_itest_mqtt_publish_allocations__publish();
+  iotc_itest_mqtt_publish_allocations__step();
+
+  assert_int_equal(2, iotc_publish_allocations_callback_no);
+  assert_int_equal(
+      IOTC_PUBLISH_ALLOCATIONS_Q0_FAST_PATH +
+          IOTC_PUBLISH_ALLOCATIONS_Q0_TASK_PATH,
+      iotc_memory_limiter_get_allocation_count() - allocation_count);
+
+  iotc_itest_mqtt_publish_allocations__disconnect();
+}
+
+#endif /* IOTC_MEMORY_LIMITER_ENABLED && !IOTC_MODULE_THREAD_ENABLED */
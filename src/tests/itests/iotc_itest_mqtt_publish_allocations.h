@@ -0,0 +1,48 @@
+/* Copyright 2018-2020 Google LLC
+ *
+ * This is part of the Google Cloud IoT Device SDK for Embedded C.
+ * It is licensed under the BSD 3-Clause license; you may not use this file
+ * except in compliance with the License.
+ *
+ * You may obtain a copy of the License at:
+ *  https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __IOTC_ITEST_MQTT_PUBLISH_ALLOCATIONS_H__
+#define __IOTC_ITEST_MQTT_PUBLISH_ALLOCATIONS_H__
+
+/* the allocations are counted by the memory limiter, the threaded builds would
+ * also count the thread pool's share of the user's callbacks */
+#if defined(IOTC_MEMORY_LIMITER_ENABLED) && !defined(IOTC_MODULE_THREAD_ENABLED)
+
+extern int iotc_itest_mqtt_publish_allocations_setup(void** state);
+extern int iotc_itest_mqtt_publish_allocations_teardown(void** state);
+
+extern void
+iotc_itest_mqtt_publish_allocations__q0_idle_lane__fast_path_allocations(
+    void** state);
+extern void
+iotc_itest_mqtt_publish_allocations__q0_busy_lane__task_path_allocations(
+    void** state);
+
+#ifdef IOTC_MOCK_TEST_PREPROCESSOR_RUN
+struct CMUnitTest iotc_itests_mqtt_publish_allocations[] = {
+    cmocka_unit_test_setup_teardown(
+        iotc_itest_mqtt_publish_allocations__q0_idle_lane__fast_path_allocations,
+        iotc_itest_mqtt_publish_allocations_setup,
+        iotc_itest_mqtt_publish_allocations_teardown),
+    cmocka_unit_test_setup_teardown(
+        iotc_itest_mqtt_publish_allocations__q0_busy_lane__task_path_allocations,
+        iotc_itest_mqtt_publish_allocations_setup,
+        iotc_itest_mqtt_publish_allocations_teardown)};
+#endif
+
+#endif /* IOTC_MEMORY_LIMITER_ENABLED && !IOTC_MODULE_THREAD_ENABLED */
+
+#endif /* __IOTC_ITEST_MQTT_PUBLISH_ALLOCATIONS_H__ */
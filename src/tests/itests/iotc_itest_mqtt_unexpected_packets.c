@@ -0,0 +1,377 @@
+/* Copyright 2018-2020 Google LLC
+ *
+ * This is part of the Google Cloud IoT Device SDK for Embedded C.
+ * It is licensed under the BSD 3-Clause license; you may not use this file
+ * except in compliance with the License.
+ *
+ * You may obtain a copy of the License at:
+ *  https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <iotc.h>
+#include <iotc_bsp_time.h>
+#include <iotc_control_topic_layer.h>
+#include <iotc_layer_api.h>
+#include <iotc_layer_default_functions.h>
+#include <iotc_layer_macros.h>
+#include <iotc_macros.h>
+#include <iotc_mqtt_codec_layer.h>
+#include <iotc_mqtt_logic_layer.h>
+#include "iotc_backoff_status_api.h"
+#include "iotc_globals.h"
+#include "iotc_handle.h"
+#include "iotc_itest_helpers.h"
+#include "iotc_itest_mqtt_unexpected_packets.h"
+#include "iotc_memory_checks.h"
+
+/**
+ * iotc_itest_mqtt_unexpected_packets test suite description
+ *
+ * Replays packets a connected client doesn't expect from the broker, each
+ * handed to the MQTT codec in place of a socket read. The io layer at the
+ * bottom of the chain can hold a write, so that the PUBACK of a QoS1 PUBLISH
+ * is still pending when the next packet arrives. The memory limiter of the
+ * teardown catches what the logic layer leaks.
+ */
+
+static iotc_context_t* iotc_unexpected_packets_context = NULL;
+static iotc_context_handle_t iotc_unexpected_packets_context_handle =
+    IOTC_INVALID_CONTEXT_HANDLE;
+
+/* The layer context of the write the io layer holds, NULL if none. */
+static struct iotc_itest_unexpected_packets_io_s {
+  uint8_t hold_writes;
+  void* pending_write_context;
+} iotc_unexpected_packets_io;
+
+static const uint8_t iotc_unexpected_packets_connack[] = {0x20, 0x02, 0x00,
+                                                          0x00};
+static const uint8_t iotc_unexpected_packets_pingresp[] = {0xD0, 0x00};
+/* topic "t", message id 7, payload "x" */
+static const uint8_t iotc_unexpected_packets_qos1_publish[] = {
+    0x32, 0x06, 0x00, 0x01, 't', 0x00, 0x07, 'x'};
+static const uint8_t iotc_unexpected_packets_qos1_publish_dup[] = {
+    0x3A, 0x06, 0x00, 0x01, 't', 0x00, 0x07, 'x'};
+static const uint8_t iotc_unexpected_packets_qos2_publish[] = {
+    0x34, 0x06, 0x00, 0x01, 't', 0x00, 0x07, 'x'};
+static const uint8_t iotc_unexpected_packets_pubrel[] = {0x62, 0x02, 0x00,
+                                                         0x07};
+
+iotc_state_t iotc_itest_unexpected_packets_io_layer_push(
+    void* context, void* data, iotc_state_t in_out_state) {
+  IOTC_UNUSED(in_out_state);
+
+  iotc_data_desc_t* data_desc = (iotc_data_desc_t*)data;
+  iotc_free_desc(&data_desc);
+
+  if (iotc_unexpected_packets_io.hold_writes) {
+    /* the codec sends one message at a time */
+    assert_null(iotc_unexpected_packets_io.pending_write_context);
+    iotc_unexpected_packets_io.pending_write_context = context;
+    return IOTC_STATE_OK;
+  }
+
+  return IOTC_PROCESS_PUSH_ON_NEXT_LAYER(context, NULL, IOTC_STATE_WRITTEN);
+}
+
+iotc_state_t iotc_itest_unexpected_packets_io_layer_pull(
+    void* context, void* data, iotc_state_t in_out_state) {
+  return IOTC_PROCESS_PULL_ON_NEXT_LAYER(context, data, in_out_state);
+}
+
+iotc_state_t iotc_itest_unexpected_packets_io_layer_close(
+    void* context, void* data, iotc_state_t in_out_state) {
+  return IOTC_PROCESS_CLOSE_EXTERNALLY_ON_THIS_LAYER(context, data,
+                                                     in_out_state);
+}
+
+iotc_state_t iotc_itest_unexpected_packets_io_layer_close_externally(
+    void* context, void* data, iotc_state_t in_out_state) {
+  /* the held write is lost with the connection */
+  iotc_unexpected_packets_io.pending_write_context = NULL;
+
+  return IOTC_PROCESS_CLOSE_EXTERNALLY_ON_NEXT_LAYER(context, data,
+                                                     in_out_state);
+}
+
+iotc_state_t iotc_itest_unexpected_packets_io_layer_init(
+    void* context, void* data, iotc_state_t in_out_state) {
+  return IOTC_PROCESS_CONNECT_ON_THIS_LAYER(context, data, in_out_state);
+}
+
+iotc_state_t iotc_itest_unexpected_packets_io_layer_connect(
+    void* context, void* data, iotc_state_t in_out_state) {
+  return IOTC_PROCESS_CONNECT_ON_NEXT_LAYER(context, data, in_out_state);
+}
+
+enum iotc_itest_unexpected_packets_layer_stack_order_e {
+  IOTC_LAYER_TYPE_UNEXPECTED_PACKETS_IO = 0,
+  IOTC_LAYER_TYPE_UNEXPECTED_PACKETS_MQTT_CODEC,
+  IOTC_LAYER_TYPE_UNEXPECTED_PACKETS_MQTT_LOGIC,
+  IOTC_LAYER_TYPE_UNEXPECTED_PACKETS_CONTROL_TOPIC
+};
+
+#define IOTC_UNEXPECTED_PACKETS_LAYER_CHAIN            \
+  IOTC_LAYER_TYPE_UNEXPECTED_PACKETS_IO                \
+  , IOTC_LAYER_TYPE_UNEXPECTED_PACKETS_MQTT_CODEC,     \
+      IOTC_LAYER_TYPE_UNEXPECTED_PACKETS_MQTT_LOGIC,   \
+      IOTC_LAYER_TYPE_UNEXPECTED_PACKETS_CONTROL_TOPIC
+
+IOTC_DECLARE_LAYER_TYPES_BEGIN(iotc_itest_unexpected_packets_layer_types)
+IOTC_LAYER_TYPES_ADD(IOTC_LAYER_TYPE_UNEXPECTED_PACKETS_IO,
+                     &iotc_itest_unexpected_packets_io_layer_push,
+                     &iotc_itest_unexpected_packets_io_layer_pull,
+                     &iotc_itest_unexpected_packets_io_layer_close,
+                     &iotc_itest_unexpected_packets_io_layer_close_externally,
+                     &iotc_itest_unexpected_packets_io_layer_init,
+                     &iotc_itest_unexpected_packets_io_layer_connect,
+                     &iotc_layer_default_post_connect)
+, IOTC_LAYER_TYPES_ADD(IOTC_LAYER_TYPE_UNEXPECTED_PACKETS_MQTT_CODEC,
+                       &iotc_mqtt_codec_layer_push,
+                       &iotc_mqtt_codec_layer_pull,
+                       &iotc_mqtt_codec_layer_close,
+                       &iotc_mqtt_codec_layer_close_externally,
+                       &iotc_mqtt_codec_layer_init,
+                       &iotc_mqtt_codec_layer_connect,
+                       &iotc_layer_default_post_connect),
+    IOTC_LAYER_TYPES_ADD(IOTC_LAYER_TYPE_UNEXPECTED_PACKETS_MQTT_LOGIC,
+                         &iotc_mqtt_logic_layer_push,
+                         &iotc_mqtt_logic_layer_pull,
+                         &iotc_mqtt_logic_layer_close,
+                         &iotc_mqtt_logic_layer_close_externally,
+                         &iotc_mqtt_logic_layer_init,
+                         &iotc_mqtt_logic_layer_connect,
+                         &iotc_mqtt_logic_layer_post_connect),
+    IOTC_LAYER_TYPES_ADD(IOTC_LAYER_TYPE_UNEXPECTED_PACKETS_CONTROL_TOPIC,
+                         &iotc_control_topic_layer_push,
+                         &iotc_control_topic_layer_pull,
+                         &iotc_control_topic_layer_close,
+                         &iotc_control_topic_layer_close_externally,
+                         &iotc_control_topic_layer_init,
+                         &iotc_control_topic_layer_connect,
+                         &iotc_layer_default_post_connect)
+        IOTC_DECLARE_LAYER_TYPES_END()
+
+            IOTC_DECLARE_LAYER_CHAIN_SCHEME(
+                IOTC_LAYER_CHAIN_UNEXPECTED_PACKETS,
+                IOTC_UNEXPECTED_PACKETS_LAYER_CHAIN);
+
+int iotc_itest_mqtt_unexpected_packets_setup(void** fixture_void) {
+  IOTC_UNUSED(fixture_void);
+
+  iotc_memory_limiter_tearup();
+
+  iotc_globals.backoff_status.backoff_lut_i = 0;
+  iotc_cancel_backoff_event();
+
+  iotc_initialize();
+
+  iotc_unexpected_packets_io.hold_writes = 0;
+  iotc_unexpected_packets_io.pending_write_context = NULL;
+
+  IOTC_CHECK_STATE(iotc_create_context_with_custom_layers(
+      &iotc_unexpected_packets_context,
+      iotc_itest_unexpected_packets_layer_types,
+      IOTC_LAYER_CHAIN_UNEXPECTED_PACKETS,
+      IOTC_LAYER_CHAIN_SCHEME_LENGTH(IOTC_LAYER_CHAIN_UNEXPECTED_PACKETS)));
+
+  IOTC_CHECK_STATE(iotc_find_handle_for_object(
+      iotc_globals.context_handles, iotc_unexpected_packets_context,
+      &iotc_unexpected_packets_context_handle));
+
+  return 0;
+
+err_handling:
+  fail();
+
+  return 1;
+}
+
+int iotc_itest_mqtt_unexpected_packets_teardown(void** fixture_void) {
+  IOTC_UNUSED(fixture_void);
+
+  iotc_delete_context_with_custom_layers(
+      &iotc_unexpected_packets_context,
+      iotc_itest_unexpected_packets_layer_types,
+      IOTC_LAYER_CHAIN_SCHEME_LENGTH(IOTC_LAYER_CHAIN_UNEXPECTED_PACKETS));
+
+  iotc_shutdown();
+
+  return !iotc_memory_limiter_teardown();
+}
+
+static void iotc_itest_mqtt_unexpected_packets__on_connection_state_changed(
+    iotc_context_handle_t in_context_handle, void* data, iotc_state_t state) {
+  IOTC_UNUSED(in_context_handle);
+  IOTC_UNUSED(data);
+  IOTC_UNUSED(state);
+}
+
+/* Runs what is due now, the clock is never moved so no timeout fires. */
+static void iotc_itest_mqtt_unexpected_packets__step(void) {
+  iotc_evtd_step(iotc_unexpected_packets_context->context_data.evtd_instance,
+                 iotc_bsp_time_getcurrenttime_seconds());
+}
+
+/* Hands a copy of the packet to the codec like a socket read. */
+static void iotc_itest_mqtt_unexpected_packets__receive(const uint8_t* packet,
+                                                        size_t packet_size) {
+  iotc_data_desc_t* data_desc =
+      iotc_make_desc_from_buffer_copy(packet, packet_size);
+  assert_non_null(data_desc);
+
+  IOTC_PROCESS_PULL_ON_THIS_LAYER(
+      &iotc_unexpected_packets_context->layer_chain.bottom->layer_connection,
+      data_desc, IOTC_STATE_OK);
+
+  iotc_itest_mqtt_unexpected_packets__step();
+}
+
+/* Lets the held write through, and the ones after it. */
+static void iotc_itest_mqtt_unexpected_packets__release_writes(void) {
+  iotc_unexpected_packets_io.hold_writes = 0;
+
+  void* const context = iotc_unexpected_packets_io.pending_write_context;
+  iotc_unexpected_packets_io.pending_write_context = NULL;
+
+  if (NULL != context) {
+    IOTC_PROCESS_PUSH_ON_NEXT_LAYER(context, NULL, IOTC_STATE_WRITTEN);
+  }
+
+  iotc_itest_mqtt_unexpected_packets__step();
+}
+
+static void iotc_itest_mqtt_unexpected_packets__connect(void) {
+  iotc_connect(
+      iotc_unexpected_packets_context_handle, "itest_username",
+      "itest_password", "itest_client_id", /*connection_timeout=*/20,
+      /*keepalive_timeout=*/20,
+      &iotc_itest_mqtt_unexpected_packets__on_connection_state_changed);
+  iotc_itest_mqtt_unexpected_packets__step();
+
+  iotc_itest_mqtt_unexpected_packets__receive(
+      iotc_unexpected_packets_connack, sizeof(iotc_unexpected_packets_connack));
+
+  assert_int_equal(1, iotc_is_context_connected(
+                          iotc_unexpected_packets_context_handle));
+}
+
+static void iotc_itest_mqtt_unexpected_packets__disconnect(void) {
+  iotc_itest_mqtt_unexpected_packets__release_writes();
+
+  if (iotc_is_context_connected(iotc_unexpected_packets_context_handle)) {
+    iotc_shutdown_connection(iotc_unexpected_packets_context_handle);
+    iotc_itest_mqtt_unexpected_packets__step();
+  }
+}
+
+/*********************************************************************************
+ * test cases
+ ********************************************************************************/
+void iotc_itest_mqtt_unexpected_packets__unsolicited_PINGRESP__dropped(
+    void** fixture_void) {
+  IOTC_UNUSED(fixture_void);
+
+  iotc_itest_mqtt_unexpected_packets__connect();
+
+  iotc_itest_mqtt_unexpected_packets__receive(
+      iotc_unexpected_packets_pingresp,
+      sizeof(iotc_unexpected_packets_pingresp));
+
+  iotc_itest_mqtt_unexpected_packets__disconnect();
+}
+
+void iotc_itest_mqtt_unexpected_packets__second_CONNACK__dropped(
+    void** fixture_void) {
+  IOTC_UNUSED(fixture_void);
+
+  iotc_itest_mqtt_unexpected_packets__connect();
+
+  iotc_itest_mqtt_unexpected_packets__receive(
+      iotc_unexpected_packets_connack, sizeof(iotc_unexpected_packets_connack));
+
+  iotc_itest_mqtt_unexpected_packets__disconnect();
+}
+
+void iotc_itest_mqtt_unexpected_packets__QoS2_PUBLISH__message_freed(
+    void** fixture_void) {
+  IOTC_UNUSED(fixture_void);
+
+  iotc_itest_mqtt_unexpected_packets__connect();
+
+  iotc_itest_mqtt_unexpected_packets__receive(
+      iotc_unexpected_packets_qos2_publish,
+      sizeof(iotc_unexpected_packets_qos2_publish));
+
+  iotc_itest_mqtt_unexpected_packets__disconnect();
+}
+
+void iotc_itest_mqtt_unexpected_packets__PUBREL_while_PUBACK_pending__dropped(
+    void** fixture_void) {
+  IOTC_UNUSED(fixture_void);
+
+  iotc_itest_mqtt_unexpected_packets__connect();
+
+  iotc_unexpected_packets_io.hold_writes = 1;
+
+  iotc_itest_mqtt_unexpected_packets__receive(
+      iotc_unexpected_packets_qos1_publish,
+      sizeof(iotc_unexpected_packets_qos1_publish));
+  assert_non_null(iotc_unexpected_packets_io.pending_write_context);
+
+  /* same message id as the PUBLISH whose PUBACK is on its way */
+  iotc_itest_mqtt_unexpected_packets__receive(
+      iotc_unexpected_packets_pubrel, sizeof(iotc_unexpected_packets_pubrel));
+
+  iotc_itest_mqtt_unexpected_packets__disconnect();
+}
+
+void iotc_itest_mqtt_unexpected_packets__redelivered_QoS1_PUBLISH_while_PUBACK_pending__dropped(
+    void** fixture_void) {
+  IOTC_UNUSED(fixture_void);
+
+  iotc_itest_mqtt_unexpected_packets__connect();
+
+  iotc_unexpected_packets_io.hold_writes = 1;
+
+  iotc_itest_mqtt_unexpected_packets__receive(
+      iotc_unexpected_packets_qos1_publish,
+      sizeof(iotc_unexpected_packets_qos1_publish));
+  assert_non_null(iotc_unexpected_packets_io.pending_write_context);
+
+  iotc_itest_mqtt_unexpected_packets__receive(
+      iotc_unexpected_packets_qos1_publish_dup,
+      sizeof(iotc_unexpected_packets_qos1_publish_dup));
+
+  iotc_itest_mqtt_unexpected_packets__disconnect();
+}
+
+void iotc_itest_mqtt_unexpected_packets__connection_reset_while_PUBACK_pending__message_freed(
+    void** fixture_void) {
+  IOTC_UNUSED(fixture_void);
+
+  iotc_itest_mqtt_unexpected_packets__connect();
+
+  iotc_unexpected_packets_io.hold_writes = 1;
+
+  iotc_itest_mqtt_unexpected_packets__receive(
+      iotc_unexpected_packets_qos1_publish,
+      sizeof(iotc_unexpected_packets_qos1_publish));
+  assert_non_null(iotc_unexpected_packets_io.pending_write_context);
+
+  IOTC_PROCESS_CLOSE_ON_THIS_LAYER(
+      &iotc_unexpected_packets_context->layer_chain.bottom->layer_connection,
+      NULL, IOTC_CONNECTION_RESET_BY_PEER_ERROR);
+  iotc_itest_mqtt_unexpected_packets__step();
+
+  assert_int_equal(0, iotc_is_context_connected(
+                          iotc_unexpected_packets_context_handle));
+
+  iotc_itest_mqtt_unexpected_packets__disconnect();
+}
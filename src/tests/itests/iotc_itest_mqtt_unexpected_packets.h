@@ -0,0 +1,67 @@
+/* Copyright 2018-2020 Google LLC
+ *
+ * This is part of the Google Cloud IoT Device SDK for Embedded C.
+ * It is licensed under the BSD 3-Clause license; you may not use this file
+ * except in compliance with the License.
+ *
+ * You may obtain a copy of the License at:
+ *  https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __IOTC_ITEST_MQTT_UNEXPECTED_PACKETS_H__
+#define __IOTC_ITEST_MQTT_UNEXPECTED_PACKETS_H__
+
+extern int iotc_itest_mqtt_unexpected_packets_setup(void** state);
+extern int iotc_itest_mqtt_unexpected_packets_teardown(void** state);
+
+extern void iotc_itest_mqtt_unexpected_packets__unsolicited_PINGRESP__dropped(
+    void** state);
+extern void iotc_itest_mqtt_unexpected_packets__second_CONNACK__dropped(
+    void** state);
+extern void iotc_itest_mqtt_unexpected_packets__QoS2_PUBLISH__message_freed(
+    void** state);
+extern void
+iotc_itest_mqtt_unexpected_packets__PUBREL_while_PUBACK_pending__dropped(
+    void** state);
+extern void
+iotc_itest_mqtt_unexpected_packets__redelivered_QoS1_PUBLISH_while_PUBACK_pending__dropped(
+    void** state);
+extern void
+iotc_itest_mqtt_unexpected_packets__connection_reset_while_PUBACK_pending__message_freed(
+    void** state);
+
+#ifdef IOTC_MOCK_TEST_PREPROCESSOR_RUN
+struct CMUnitTest iotc_itests_mqtt_unexpected_packets[] = {
+    cmocka_unit_test_setup_teardown(
+        iotc_itest_mqtt_unexpected_packets__unsolicited_PINGRESP__dropped,
+        iotc_itest_mqtt_unexpected_packets_setup,
+        iotc_itest_mqtt_unexpected_packets_teardown),
+    cmocka_unit_test_setup_teardown(
+        iotc_itest_mqtt_unexpected_packets__second_CONNACK__dropped,
+        iotc_itest_mqtt_unexpected_packets_setup,
+        iotc_itest_mqtt_unexpected_packets_teardown),
+    cmocka_unit_test_setup_teardown(
+        iotc_itest_mqtt_unexpected_packets__QoS2_PUBLISH__message_freed,
+        iotc_itest_mqtt_unexpected_packets_setup,
+        iotc_itest_mqtt_unexpected_packets_teardown),
+    cmocka_unit_test_setup_teardown(
+        iotc_itest_mqtt_unexpected_packets__PUBREL_while_PUBACK_pending__dropped,
+        iotc_itest_mqtt_unexpected_packets_setup,
+        iotc_itest_mqtt_unexpected_packets_teardown),
+    cmocka_unit_test_setup_teardown(
+        iotc_itest_mqtt_unexpected_packets__redelivered_QoS1_PUBLISH_while_PUBACK_pending__dropped,
+        iotc_itest_mqtt_unexpected_packets_setup,
+        iotc_itest_mqtt_unexpected_packets_teardown),
+    cmocka_unit_test_setup_teardown(
+        iotc_itest_mqtt_unexpected_packets__connection_reset_while_PUBACK_pending__message_freed,
+        iotc_itest_mqtt_unexpected_packets_setup,
+        iotc_itest_mqtt_unexpected_packets_teardown)};
+#endif
+
+#endif /* __IOTC_ITEST_MQTT_UNEXPECTED_PACKETS_H__ */
@@ -421,7 +421,7 @@ void iotc_itest_mqtt_logic_layer__subscribe_success__success_suback_callback_inv
      * functions
      */
     IOTC_CHECK_STATE(local_state = iotc_find_handle_for_object(
-                         iotc_globals.context_handles_vector,
+                         iotc_globals.context_handles,
                          iotc_context__itest_mqttlogic_layer, &context_handle));
 
     /* let's use the IoTC library subscribe function */
@@ -498,7 +498,7 @@ void iotc_itest_mqtt_logic_layer__subscribe_failure__failed_suback_callback_invo
      * functions
      */
     IOTC_CHECK_STATE(local_state = iotc_find_handle_for_object(
-                         iotc_globals.context_handles_vector,
+                         iotc_globals.context_handles,
                          iotc_context__itest_mqttlogic_layer, &context_handle));
 
     /* let's use the IoTC library subscribe function */
@@ -583,7 +583,7 @@ void iotc_itest_mqtt_logic_layer__subscribe_success__success_message_callback_in
      * functions
      */
     IOTC_CHECK_STATE(local_state = iotc_find_handle_for_object(
-                         iotc_globals.context_handles_vector,
+                         iotc_globals.context_handles,
                          iotc_context__itest_mqttlogic_layer, &context_handle));
 
     /* let's use the IoTC library subscribe function */
@@ -653,3 +653,82 @@ err_handling:
   iotc_mqtt_message_free(&suback);
   iotc_itest_mqttlogic_shutdown_and_disconnect(context_handle);
 }
+
+void iotc_itest_mqtt_logic_layer_publish_callback(
+    iotc_context_handle_t in_context_handle, void* data, iotc_state_t state) {
+  IOTC_UNUSED(in_context_handle);
+  IOTC_UNUSED(data);
+
+#ifndef IOTC_MODULE_THREAD_ENABLED
+  check_expected(state);
+#else
+  IOTC_UNUSED(state);
+#endif
+}
+
+void iotc_itest_mqtt_logic_layer__publish_q0_idle_lane__sent_without_logic_task(
+    void** state) {
+  IOTC_UNUSED(state);
+
+  iotc_state_t local_state = IOTC_STATE_OK;
+  iotc_context_handle_t context_handle = IOTC_INVALID_CONTEXT_HANDLE;
+
+  /* initialisation of the layer chain */
+  iotc_layer_t* top_layer = iotc_context__itest_mqttlogic_layer->layer_chain.top;
+  iotc_itest_mqttlogic_prepare_init_and_connect_layer(top_layer,
+                                                      IOTC_SESSION_CLEAN, 0);
+  iotc_itest_mqttlogic_layer_act();
+
+  IOTC_CHECK_STATE(local_state = iotc_find_handle_for_object(
+                       iotc_globals.context_handles,
+                       iotc_context__itest_mqttlogic_layer, &context_handle));
+
+  assert_int_equal(IOTC_STATE_OK,
+                   iotc_publish(context_handle, "test_topic", "some_data",
+                                IOTC_MQTT_QOS_AT_MOST_ONCE,
+                                &iotc_itest_mqtt_logic_layer_publish_callback,
+                                NULL));
+
+  /* the lane is only looked at on the event loop, not by the caller */
+  iotc_mqtt_logic_layer_data_t* layer_data =
+      (iotc_mqtt_logic_layer_data_t*)top_layer->layer_connection.prev
+          ->user_data;
+  assert_int_equal(0, layer_data->q0_fast_publish_pending);
+
+  /* one handle later no task is queued, the message itself occupies the q0
+   * lane and waits for the codec */
+  assert_int_equal(1, iotc_evtd_single_step(iotc_globals.evtd_instance,
+                                            time(NULL)));
+  assert_null(layer_data->q0_tasks_queue.head);
+  assert_null(layer_data->current_q0_task);
+  assert_int_equal(1, layer_data->q0_fast_publish_pending);
+
+  expect_value(iotc_mock_layer_mqttlogic_prev_push, in_out_state,
+               IOTC_STATE_OK);
+  expect_check(iotc_mock_layer_mqttlogic_prev_push, data, check_msg,
+               iotc_itest_mqttlogic_make_msg_test_matrix(
+                   (iotc_itest_mqttlogic_test_msg_what_to_check_t){
+                       .retain = 0, .qos = 1, .dup = 0, .type = 1},
+                   (iotc_itest_mqttlogic_test_msg_common_bits_check_values_t){
+                       .retain = 0,
+                       .qos = IOTC_MQTT_QOS_AT_MOST_ONCE,
+                       .dup = 0,
+                       .type = IOTC_MQTT_TYPE_PUBLISH}));
+
+#ifndef IOTC_MODULE_THREAD_ENABLED
+  /* the callback is deferred the same way as for the task path */
+  expect_value(iotc_itest_mqtt_logic_layer_publish_callback, state,
+               IOTC_STATE_OK);
+#endif
+
+  iotc_itest_mqttlogic_layer_act();
+
+  assert_int_equal(0, layer_data->q0_fast_publish_pending);
+
+  /* let's close the connection gracefully */
+  iotc_itest_mqttlogic_shutdown_and_disconnect(context_handle);
+
+  return;
+err_handling:
+  iotc_itest_mqttlogic_shutdown_and_disconnect(context_handle);
+}
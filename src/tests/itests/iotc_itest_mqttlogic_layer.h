@@ -35,6 +35,9 @@ iotc_itest_mqtt_logic_layer__subscribe_failure__failed_suback_callback_invocatio
 extern void
 iotc_itest_mqtt_logic_layer__subscribe_success__success_message_callback_invocation(
     void** state);
+extern void
+iotc_itest_mqtt_logic_layer__publish_q0_idle_lane__sent_without_logic_task(
+    void** state);
 
 #ifdef IOTC_MOCK_TEST_PREPROCESSOR_RUN
 struct CMUnitTest iotc_itests_mqttlogic_layer[] = {
@@ -49,6 +52,9 @@ struct CMUnitTest iotc_itests_mqttlogic_layer[] = {
         iotc_itest_mqttlogic_layer_setup, iotc_itest_mqttlogic_layer_teardown),
     cmocka_unit_test_setup_teardown(
         iotc_itest_mqtt_logic_layer__subscribe_failure__failed_suback_callback_invocation,
+        iotc_itest_mqttlogic_layer_setup, iotc_itest_mqttlogic_layer_teardown),
+    cmocka_unit_test_setup_teardown(
+        iotc_itest_mqtt_logic_layer__publish_q0_idle_lane__sent_without_logic_task,
         iotc_itest_mqttlogic_layer_setup, iotc_itest_mqttlogic_layer_teardown)};
 #endif
 
@@ -0,0 +1,203 @@
+/* Copyright 2018-2020 Google LLC
+ *
+ * This is part of the Google Cloud IoT Device SDK for Embedded C.
+ * It is licensed under the BSD 3-Clause license; you may not use this file
+ * except in compliance with the License.
+ *
+ * You may obtain a copy of the License at:
+ *  https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <iotc.h>
+#include <iotc_itest_mock_broker_layerchain.h>
+#include <iotc_macros.h>
+#include "iotc_backoff_status_api.h"
+#include "iotc_globals.h"
+#include "iotc_handle.h"
+#include "iotc_itest_helpers.h"
+#include "iotc_itest_layerchain_ct_ml_mc.h"
+#include "iotc_itest_offline_queue.h"
+#include "iotc_memory_checks.h"
+
+/* Depends on the iotc_itest_tls_error.c */
+extern iotc_context_t* iotc_context;
+extern iotc_context_handle_t iotc_context_handle;
+extern iotc_context_t* iotc_context_mockbroker;
+/* end of dependency */
+
+/**
+ * iotc_itest_offline_queue test suite description
+ *
+ * Publishes on the SUT layer chain of iotc_itest_tls_error.c before it is
+ * connected. The mock broker checks that the queued messages arrive right
+ * after the CONNECT, in the order they were published, and the publish
+ * callbacks report their delivery.
+ */
+
+static uint8_t iotc_itest_offline_queue__delivered = 0;
+
+int iotc_itest_offline_queue_setup(void** fixture_void) {
+  IOTC_UNUSED(fixture_void);
+
+  iotc_memory_limiter_tearup();
+
+  iotc_globals.backoff_status.backoff_lut_i = 0;
+  iotc_cancel_backoff_event();
+
+  iotc_initialize();
+
+  IOTC_CHECK_STATE(iotc_create_context_with_custom_layers(
+      &iotc_context, itest_ct_ml_mc_layer_chain, IOTC_LAYER_CHAIN_CT_ML_MC,
+      IOTC_LAYER_CHAIN_SCHEME_LENGTH(IOTC_LAYER_CHAIN_CT_ML_MC)));
+
+  iotc_find_handle_for_object(iotc_globals.context_handles, iotc_context,
+                              &iotc_context_handle);
+
+  IOTC_CHECK_STATE(iotc_create_context_with_custom_layers(
+      &iotc_context_mockbroker, itest_mock_broker_codec_layer_chain,
+      IOTC_LAYER_CHAIN_MOCK_BROKER_CODEC,
+      IOTC_LAYER_CHAIN_SCHEME_LENGTH(IOTC_LAYER_CHAIN_MOCK_BROKER_CODEC)));
+
+  iotc_itest_offline_queue__delivered = 0;
+
+  return 0;
+
+err_handling:
+  fail();
+
+  return 1;
+}
+
+int iotc_itest_offline_queue_teardown(void** fixture_void) {
+  IOTC_UNUSED(fixture_void);
+
+  iotc_delete_context(iotc_context_handle);
+  iotc_delete_context_with_custom_layers(
+      &iotc_context_mockbroker, itest_mock_broker_codec_layer_chain,
+      IOTC_LAYER_CHAIN_SCHEME_LENGTH(IOTC_LAYER_CHAIN_MOCK_BROKER_CODEC));
+
+  iotc_shutdown();
+
+  return !iotc_memory_limiter_teardown();
+}
+
+static void iotc_itest_offline_queue__on_connection_state_changed(
+    iotc_context_handle_t in_context_handle, void* data, iotc_state_t state) {
+  IOTC_UNUSED(in_context_handle);
+  IOTC_UNUSED(data);
+  IOTC_UNUSED(state);
+}
+
+static void iotc_itest_offline_queue__on_publish(
+    iotc_context_handle_t in_context_handle, void* data, iotc_state_t state) {
+  IOTC_UNUSED(in_context_handle);
+  IOTC_UNUSED(data);
+
+  if (IOTC_STATE_OK == state) {
+    ++iotc_itest_offline_queue__delivered;
+  }
+}
+
+/*********************************************************************************
+ * act
+ ****************************************************************************
+ ********************************************************************************/
+static void iotc_itest_offline_queue__act() {
+  {
+    /* the test concentrates on the MQTT messages that reach the broker */
+    will_return_always(iotc_mock_broker_layer__check_expected__LAYER_LEVEL,
+                       CONTROL_SKIP_CHECK_EXPECTED);
+
+    will_return_always(iotc_mock_layer_tls_prev__check_expected__LAYER_LEVEL,
+                       CONTROL_SKIP_CHECK_EXPECTED);
+  }
+
+  IOTC_PROCESS_INIT_ON_THIS_LAYER(
+      &iotc_context_mockbroker->layer_chain.top->layer_connection, NULL,
+      IOTC_STATE_OK);
+
+  iotc_evtd_step(iotc_globals.evtd_instance,
+                 iotc_bsp_time_getcurrenttime_seconds());
+
+  iotc_connect(iotc_context_handle, "itest_username", "itest_password",
+               "itest_client_id", /*connection_timeout=*/20,
+               /*keepalive_timeout=*/60,
+               &iotc_itest_offline_queue__on_connection_state_changed);
+
+  uint8_t loop_counter = 0;
+  while (iotc_evtd_dispatcher_continue(iotc_globals.evtd_instance) == 1 &&
+         loop_counter < 20) {
+    iotc_evtd_step(iotc_globals.evtd_instance,
+                   iotc_bsp_time_getcurrenttime_seconds() + loop_counter);
+    ++loop_counter;
+
+    if (15 == loop_counter) {
+      iotc_shutdown_connection(iotc_context_handle);
+    }
+  }
+}
+
+/*********************************************************************************
+ * test cases
+ *********************************************************************
+ ********************************************************************************/
+void iotc_itest_offline_queue__published_before_connect__sent_in_order_after_connack(
+    void** state) {
+  IOTC_UNUSED(state);
+
+  const iotc_offline_queue_config_t config = {
+      8, 0, IOTC_OFFLINE_QUEUE_DROP_OLDEST, NULL};
+
+  assert_int_equal(IOTC_STATE_OK,
+                   iotc_set_offline_queue(iotc_context_handle, &config));
+
+  /* nothing is connected yet, these would have been dropped */
+  assert_int_equal(
+      IOTC_STATE_OK,
+      iotc_publish(iotc_context_handle, "offline/first", "1",
+                   IOTC_MQTT_QOS_AT_LEAST_ONCE,
+                   &iotc_itest_offline_queue__on_publish, NULL));
+  assert_int_equal(
+      IOTC_STATE_OK,
+      iotc_publish(iotc_context_handle, "offline/second", "2",
+                   IOTC_MQTT_QOS_AT_MOST_ONCE,
+                   &iotc_itest_offline_queue__on_publish, NULL));
+  assert_int_equal(
+      IOTC_STATE_OK,
+      iotc_publish(iotc_context_handle, "offline/third", "3",
+                   IOTC_MQTT_QOS_AT_LEAST_ONCE,
+                   &iotc_itest_offline_queue__on_publish, NULL));
+
+  expect_value(iotc_mock_broker_layer_pull, recvd_msg_type,
+               IOTC_MQTT_TYPE_CONNECT);
+
+  expect_value(iotc_mock_broker_layer_pull, recvd_msg_type,
+               IOTC_MQTT_TYPE_PUBLISH);
+  expect_string(iotc_mock_broker_layer_pull, publish_topic_name,
+                "offline/first");
+
+  expect_value(iotc_mock_broker_layer_pull, recvd_msg_type,
+               IOTC_MQTT_TYPE_PUBLISH);
+  expect_string(iotc_mock_broker_layer_pull, publish_topic_name,
+                "offline/second");
+
+  expect_value(iotc_mock_broker_layer_pull, recvd_msg_type,
+               IOTC_MQTT_TYPE_PUBLISH);
+  expect_string(iotc_mock_broker_layer_pull, publish_topic_name,
+                "offline/third");
+
+  expect_value(iotc_mock_broker_layer_pull, recvd_msg_type,
+               IOTC_MQTT_TYPE_DISCONNECT);
+
+  iotc_itest_offline_queue__act();
+
+#ifndef IOTC_MODULE_THREAD_ENABLED
+  assert_int_equal(3, iotc_itest_offline_queue__delivered);
+#endif
+}
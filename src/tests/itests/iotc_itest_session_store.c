@@ -0,0 +1,196 @@
+/* Copyright 2018-2020 Google LLC
+ *
+ * This is part of the Google Cloud IoT Device SDK for Embedded C.
+ * It is licensed under the BSD 3-Clause license; you may not use this file
+ * except in compliance with the License.
+ *
+ * You may obtain a copy of the License at:
+ *  https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <iotc.h>
+#include <iotc_itest_mock_broker_layerchain.h>
+#include <iotc_macros.h>
+#include "iotc_backoff_status_api.h"
+#include "iotc_globals.h"
+#include "iotc_handle.h"
+#include "iotc_internals.h"
+#include "iotc_itest_helpers.h"
+#include "iotc_itest_layerchain_ct_ml_mc.h"
+#include "iotc_itest_session_store.h"
+#include "iotc_memory_checks.h"
+#include "iotc_session_store.h"
+
+/* Depends on the iotc_itest_tls_error.c */
+extern iotc_context_t* iotc_context;
+extern iotc_context_handle_t iotc_context_handle;
+extern iotc_context_t* iotc_context_mockbroker;
+/* end of dependency */
+
+/**
+ * iotc_itest_session_store test suite description
+ *
+ * A session log written by a previous run of the application holds a QoS1
+ * publish that was never acknowledged. The SUT layer chain of
+ * iotc_itest_tls_error.c replays the log and the mock broker checks that the
+ * publish is sent again right after the CONNECT.
+ */
+
+#define IOTC_ITEST_SESSION_STORE_RESOURCE "itest_session_store.log"
+
+int iotc_itest_session_store_setup(void** fixture_void) {
+  IOTC_UNUSED(fixture_void);
+
+  iotc_memory_limiter_tearup();
+
+  iotc_globals.backoff_status.backoff_lut_i = 0;
+  iotc_cancel_backoff_event();
+
+  iotc_initialize();
+
+  IOTC_CHECK_STATE(iotc_create_context_with_custom_layers(
+      &iotc_context, itest_ct_ml_mc_layer_chain, IOTC_LAYER_CHAIN_CT_ML_MC,
+      IOTC_LAYER_CHAIN_SCHEME_LENGTH(IOTC_LAYER_CHAIN_CT_ML_MC)));
+
+  iotc_find_handle_for_object(iotc_globals.context_handles, iotc_context,
+                              &iotc_context_handle);
+
+  IOTC_CHECK_STATE(iotc_create_context_with_custom_layers(
+      &iotc_context_mockbroker, itest_mock_broker_codec_layer_chain,
+      IOTC_LAYER_CHAIN_MOCK_BROKER_CODEC,
+      IOTC_LAYER_CHAIN_SCHEME_LENGTH(IOTC_LAYER_CHAIN_MOCK_BROKER_CODEC)));
+
+  return 0;
+
+err_handling:
+  fail();
+
+  return 1;
+}
+
+int iotc_itest_session_store_teardown(void** fixture_void) {
+  IOTC_UNUSED(fixture_void);
+
+  iotc_delete_context(iotc_context_handle);
+  iotc_delete_context_with_custom_layers(
+      &iotc_context_mockbroker, itest_mock_broker_codec_layer_chain,
+      IOTC_LAYER_CHAIN_SCHEME_LENGTH(IOTC_LAYER_CHAIN_MOCK_BROKER_CODEC));
+
+  iotc_internals.fs_functions.remove_resource(
+      NULL, IOTC_FS_CONFIG_DATA, IOTC_ITEST_SESSION_STORE_RESOURCE);
+
+  iotc_shutdown();
+
+  return !iotc_memory_limiter_teardown();
+}
+
+static void iotc_itest_session_store__on_connection_state_changed(
+    iotc_context_handle_t in_context_handle, void* data, iotc_state_t state) {
+  IOTC_UNUSED(in_context_handle);
+  IOTC_UNUSED(data);
+  IOTC_UNUSED(state);
+}
+
+/* what the previous run left behind */
+static void iotc_itest_session_store__write_previous_run_log(
+    const iotc_session_store_config_t* config) {
+  iotc_session_store_t store;
+  memset(&store, 0, sizeof(store));
+
+  iotc_data_desc_t* data = iotc_make_desc_from_string_copy("acked");
+
+  assert_int_equal(IOTC_STATE_OK,
+                   iotc_session_store_configure(&store, config, NULL));
+
+  assert_int_equal(IOTC_STATE_OK, iotc_session_store_record_publish(
+                                      &store, 41, "session/acked", data));
+  iotc_free_desc(&data);
+
+  data = iotc_make_desc_from_string_copy("unacked");
+  assert_int_equal(IOTC_STATE_OK, iotc_session_store_record_publish(
+                                      &store, 42, "session/unacked", data));
+  iotc_free_desc(&data);
+
+  iotc_session_store_record_ack(&store, 41);
+
+  iotc_session_store_destroy(&store);
+}
+
+/*********************************************************************************
+ * act
+ ****************************************************************************
+ ********************************************************************************/
+static void iotc_itest_session_store__act() {
+  {
+    /* the test concentrates on the MQTT messages that reach the broker */
+    will_return_always(iotc_mock_broker_layer__check_expected__LAYER_LEVEL,
+                       CONTROL_SKIP_CHECK_EXPECTED);
+
+    will_return_always(iotc_mock_layer_tls_prev__check_expected__LAYER_LEVEL,
+                       CONTROL_SKIP_CHECK_EXPECTED);
+  }
+
+  IOTC_PROCESS_INIT_ON_THIS_LAYER(
+      &iotc_context_mockbroker->layer_chain.top->layer_connection, NULL,
+      IOTC_STATE_OK);
+
+  iotc_evtd_step(iotc_globals.evtd_instance,
+                 iotc_bsp_time_getcurrenttime_seconds());
+
+  iotc_connect(iotc_context_handle, "itest_username", "itest_password",
+               "itest_client_id", /*connection_timeout=*/20,
+               /*keepalive_timeout=*/60,
+               &iotc_itest_session_store__on_connection_state_changed);
+
+  uint8_t loop_counter = 0;
+  while (iotc_evtd_dispatcher_continue(iotc_globals.evtd_instance) == 1 &&
+         loop_counter < 20) {
+    iotc_evtd_step(iotc_globals.evtd_instance,
+                   iotc_bsp_time_getcurrenttime_seconds() + loop_counter);
+    ++loop_counter;
+
+    if (15 == loop_counter) {
+      iotc_shutdown_connection(iotc_context_handle);
+    }
+  }
+}
+
+/*********************************************************************************
+ * test cases
+ *********************************************************************
+ ********************************************************************************/
+void iotc_itest_session_store__log_of_previous_run__unacked_publish_resent_after_connack(
+    void** state) {
+  IOTC_UNUSED(state);
+
+  const iotc_session_store_config_t config = {
+      IOTC_ITEST_SESSION_STORE_RESOURCE, 0};
+
+  iotc_itest_session_store__write_previous_run_log(&config);
+
+  assert_int_equal(IOTC_STATE_OK,
+                   iotc_set_session_store(iotc_context_handle, &config));
+
+  expect_value(iotc_mock_broker_layer_pull, recvd_msg_type,
+               IOTC_MQTT_TYPE_CONNECT);
+
+  /* the acknowledged one is not sent again */
+  expect_value(iotc_mock_broker_layer_pull, recvd_msg_type,
+               IOTC_MQTT_TYPE_PUBLISH);
+  expect_string(iotc_mock_broker_layer_pull, publish_topic_name,
+                "session/unacked");
+
+  expect_value(iotc_mock_broker_layer_pull, recvd_msg_type,
+               IOTC_MQTT_TYPE_DISCONNECT);
+
+  iotc_itest_session_store__act();
+
+  /* the PUBACK ended the publish */
+  assert_int_equal(0, iotc_context->context_data.session_store.count);
+}
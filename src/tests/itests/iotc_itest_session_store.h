@@ -0,0 +1,33 @@
+/* Copyright 2018-2020 Google LLC
+ *
+ * This is part of the Google Cloud IoT Device SDK for Embedded C.
+ * It is licensed under the BSD 3-Clause license; you may not use this file
+ * except in compliance with the License.
+ *
+ * You may obtain a copy of the License at:
+ *  https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __IOTC_ITEST_SESSION_STORE_H__
+#define __IOTC_ITEST_SESSION_STORE_H__
+
+extern int iotc_itest_session_store_setup(void** state);
+extern int iotc_itest_session_store_teardown(void** state);
+
+extern void
+iotc_itest_session_store__log_of_previous_run__unacked_publish_resent_after_connack(
+    void** state);
+
+#ifdef IOTC_MOCK_TEST_PREPROCESSOR_RUN
+struct CMUnitTest iotc_itests_session_store[] = {cmocka_unit_test_setup_teardown(
+    iotc_itest_session_store__log_of_previous_run__unacked_publish_resent_after_connack,
+    iotc_itest_session_store_setup, iotc_itest_session_store_teardown)};
+#endif
+
+#endif /* __IOTC_ITEST_SESSION_STORE_H__ */
@@ -140,7 +140,7 @@ int iotc_itest_tls_error_setup(void** fixture_void) {
       &iotc_context, itest_ct_ml_mc_layer_chain, IOTC_LAYER_CHAIN_CT_ML_MC,
       IOTC_LAYER_CHAIN_SCHEME_LENGTH(IOTC_LAYER_CHAIN_CT_ML_MC)));
 
-  iotc_find_handle_for_object(iotc_globals.context_handles_vector, iotc_context,
+  iotc_find_handle_for_object(iotc_globals.context_handles, iotc_context,
                               &iotc_context_handle);
 
   IOTC_CHECK_STATE(iotc_create_context_with_custom_layers(
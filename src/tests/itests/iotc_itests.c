@@ -17,11 +17,21 @@
 #define IOTC_MOCK_TEST_PREPROCESSOR_RUN
 #include "iotc_itest_clean_session.h"
 #include "iotc_itest_connect_error.h"
+#include "iotc_itest_connect_scheduler.h"
+#ifndef IOTC_NO_CONTEXT_STATS
+#include "iotc_itest_context_stats.h"
+#endif
+#include "iotc_itest_gateway.h"
+#include "iotc_itest_offline_queue.h"
+#include "iotc_itest_session_store.h"
 #include "iotc_itest_tls_error.h"
 #ifndef IOTC_NO_TLS_LAYER
 #include "iotc_itest_tls_layer.h"
 #endif
 #include "iotc_itest_mqtt_keepalive.h"
+#include "iotc_itest_mqtt_keepalive_traffic.h"
+#include "iotc_itest_mqtt_publish_allocations.h"
+#include "iotc_itest_mqtt_unexpected_packets.h"
 #include "iotc_itest_mqttlogic_layer.h"
 #undef IOTC_MOCK_TEST_PREPROCESSOR_RUN
 
@@ -29,13 +39,28 @@
 #include "iotc_test_utils.h"
 
 struct CMGroupTest groups[] = {cmocka_test_group(iotc_itests_clean_session),
+#if defined(IOTC_MEMORY_LIMITER_ENABLED) && !defined(IOTC_MODULE_THREAD_ENABLED)
+                               cmocka_test_group(
+                                   iotc_itests_mqtt_publish_allocations),
+#endif
                                cmocka_test_group(iotc_itests_tls_error),
 #ifndef IOTC_NO_TLS_LAYER
                                cmocka_test_group(iotc_itests_tls_layer),
 #endif
                                cmocka_test_group(iotc_itests_mqttlogic_layer),
                                cmocka_test_group(iotc_itests_connect_error),
+                               cmocka_test_group(iotc_itests_connect_scheduler),
                                cmocka_test_group(iotc_itests_mqtt_keepalive),
+                               cmocka_test_group(
+                                   iotc_itests_mqtt_keepalive_traffic),
+                               cmocka_test_group(
+                                   iotc_itests_mqtt_unexpected_packets),
+                               cmocka_test_group(iotc_itests_gateway),
+                               cmocka_test_group(iotc_itests_offline_queue),
+                               cmocka_test_group(iotc_itests_session_store),
+#ifndef IOTC_NO_CONTEXT_STATS
+                               cmocka_test_group(iotc_itests_context_stats),
+#endif
                                cmocka_test_group_end};
 
 int8_t iotc_cm_strict_mock = 0;
@@ -16,9 +16,12 @@
 
 #include "iotc_test_echoserver.h"
 
+#include <errno.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <string.h>
 #include <thread>
+#include <vector>
 
 namespace iotctest {
 
@@ -26,7 +29,13 @@ EchoTestServer::EchoTestServer(std::string host, uint16_t port,
                                uint16_t socket_type, uint16_t protocol_type)
     : host_(host), test_port_(port), socket_type_(socket_type),
       protocol_type_(protocol_type) {}
-EchoTestServer::~EchoTestServer() {}
+EchoTestServer::~EchoTestServer() {
+#ifdef IOTC_TEST_ECHOSERVER_TLS
+  if (tls_context_) {
+    SSL_CTX_free(tls_context_);
+  }
+#endif
+}
 
 std::unique_ptr<EchoTestServer> EchoTestServer::Create(std::string host,
                                                        uint16_t port,
@@ -38,12 +47,45 @@ std::unique_ptr<EchoTestServer> EchoTestServer::Create(std::string host,
   return echo_test_server;
 }
 
+std::unique_ptr<EchoTestServer> EchoTestServer::CreateMqttBroker(
+    std::string host, uint16_t port, uint16_t protocol_type) {
+  std::unique_ptr<EchoTestServer> mqtt_broker(
+      new EchoTestServer(host, port, SOCK_STREAM, protocol_type));
+  mqtt_broker->mode_ = Mode::kMqttBroker;
+  mqtt_broker->CreateServer();
+  return mqtt_broker;
+}
+
+#ifdef IOTC_TEST_ECHOSERVER_TLS
+bool EchoTestServer::EnableTls(const std::string& certificate_file,
+                               const std::string& private_key_file) {
+  tls_context_ = SSL_CTX_new(TLS_server_method());
+  if (!tls_context_) {
+    return false;
+  }
+
+  if (SSL_CTX_use_certificate_chain_file(tls_context_,
+                                         certificate_file.c_str()) != 1 ||
+      SSL_CTX_use_PrivateKey_file(tls_context_, private_key_file.c_str(),
+                                  SSL_FILETYPE_PEM) != 1) {
+    SSL_CTX_free(tls_context_);
+    tls_context_ = nullptr;
+    return false;
+  }
+
+  return true;
+}
+#endif
+
 void EchoTestServer::Run() {
   if (server_thread_) {
     Stop();
   }
   runnable_ = true;
-  if (socket_type_ == SOCK_STREAM) {
+  if (mode_ == Mode::kMqttBroker) {
+    server_thread_ = std::unique_ptr<std::thread>(
+        new std::thread(&EchoTestServer::RunMqttBroker, this));
+  } else if (socket_type_ == SOCK_STREAM) {
     // TODO(b/127770330)
     // server_thread_ =
     //     std::make_unique<std::thread>(&EchoTestServer::RunTcpServer, this);
@@ -107,6 +149,194 @@ EchoTestServer::ServerError EchoTestServer::RunUdpServer() {
   return ServerError::kSuccess;
 }
 
+EchoTestServer::ServerError EchoTestServer::RunMqttBroker() {
+  struct sockaddr_storage client_addr;
+  socklen_t client_addr_size = sizeof(struct sockaddr_storage);
+
+  while (runnable_) {
+    client_socket_ = accept(server_socket_, (struct sockaddr*)&client_addr,
+                            &client_addr_size);
+    if (client_socket_ < 0) {
+      // The receive timeout of the server socket lets Stop be noticed.
+      if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+        continue;
+      }
+      close(server_socket_);
+      return ServerError::kFailedAccept;
+    }
+
+    struct timeval tv;
+    tv.tv_sec = kTimeoutSeconds;
+    tv.tv_usec = 0;
+    setsockopt(client_socket_, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    // The acknowledgements are small, they mustn't wait for the client's
+    // delayed ACKs.
+    int no_delay = 1;
+    setsockopt(client_socket_, IPPROTO_TCP, TCP_NODELAY, &no_delay,
+               sizeof(no_delay));
+
+#ifdef IOTC_TEST_ECHOSERVER_TLS
+    if (tls_context_) {
+      tls_ = SSL_new(tls_context_);
+      SSL_set_fd(tls_, client_socket_);
+      if (SSL_accept(tls_) == 1) {
+        ServeMqttClient();
+        SSL_shutdown(tls_);
+      }
+      SSL_free(tls_);
+      tls_ = nullptr;
+      close(client_socket_);
+      continue;
+    }
+#endif
+
+    ServeMqttClient();
+    close(client_socket_);
+  }
+
+  close(server_socket_);
+  return ServerError::kSuccess;
+}
+
+void EchoTestServer::ServeMqttClient() {
+  // Holds the part of a message that hasn't been received completely yet.
+  std::vector<uint8_t> pending;
+  std::vector<char> answers;
+
+  while (runnable_) {
+    recv_len_ = ReadFromClient(recv_buf_, kBufferSize);
+    if (recv_len_ < 0 &&
+        (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+      continue;
+    }
+    if (recv_len_ <= 0) {
+      return;
+    }
+
+    bytes_received_ += recv_len_;
+    pending.insert(pending.end(), recv_buf_, recv_buf_ + recv_len_);
+    answers.clear();
+
+    size_t offset = 0;
+    while (offset + 2 <= pending.size()) {
+      // Fixed header: the type, then the remaining length in at most 4 bytes
+      // of 7 bits each.
+      size_t remaining_length = 0;
+      size_t length_bytes = 0;
+      bool length_complete = false;
+      while (length_bytes < 4 && offset + 1 + length_bytes < pending.size()) {
+        const uint8_t byte = pending[offset + 1 + length_bytes];
+        remaining_length |= (size_t)(byte & 0x7F) << (7 * length_bytes);
+        ++length_bytes;
+        if ((byte & 0x80) == 0) {
+          length_complete = true;
+          break;
+        }
+      }
+      if (!length_complete) {
+        if (length_bytes == 4) {
+          return;  // malformed, drop the client
+        }
+        break;
+      }
+
+      const size_t header_length = 1 + length_bytes;
+      if (offset + header_length + remaining_length > pending.size()) {
+        break;
+      }
+
+      const uint8_t type = pending[offset] >> 4;
+      const uint8_t* body = &pending[offset + header_length];
+
+      switch (type) {
+        case 1: {  // CONNECT -> CONNACK, accepted
+          const char connack[] = {0x20, 0x02, 0x00, 0x00};
+          answers.insert(answers.end(), connack, connack + sizeof(connack));
+        } break;
+        case 3: {  // PUBLISH -> PUBACK for QoS1
+          ++publishes_received_;
+          const uint8_t qos = (pending[offset] >> 1) & 0x03;
+          const size_t topic_length = ((size_t)body[0] << 8) | body[1];
+          if (qos > 0 && 2 + topic_length + 2 <= remaining_length) {
+            const char puback[] = {0x40, 0x02, (char)body[2 + topic_length],
+                                   (char)body[2 + topic_length + 1]};
+            answers.insert(answers.end(), puback, puback + sizeof(puback));
+          }
+        } break;
+        case 8: {  // SUBSCRIBE -> SUBACK granting QoS1
+          if (remaining_length >= 2) {
+            const char suback[] = {(char)0x90, 0x03, (char)body[0],
+                                   (char)body[1], 0x01};
+            answers.insert(answers.end(), suback, suback + sizeof(suback));
+          }
+        } break;
+        case 10: {  // UNSUBSCRIBE -> UNSUBACK
+          if (remaining_length >= 2) {
+            const char unsuback[] = {(char)0xB0, 0x02, (char)body[0],
+                                     (char)body[1]};
+            answers.insert(answers.end(), unsuback,
+                           unsuback + sizeof(unsuback));
+          }
+        } break;
+        case 12: {  // PINGREQ -> PINGRESP
+          const char pingresp[] = {(char)0xD0, 0x00};
+          answers.insert(answers.end(), pingresp, pingresp + sizeof(pingresp));
+        } break;
+        case 14:  // DISCONNECT
+          if (!answers.empty()) {
+            WriteToClient(answers.data(), answers.size());
+          }
+          return;
+        default:
+          break;
+      }
+
+      offset += header_length + remaining_length;
+    }
+
+    pending.erase(pending.begin(), pending.begin() + offset);
+
+    if (!answers.empty() && !WriteToClient(answers.data(), answers.size())) {
+      return;
+    }
+  }
+}
+
+ssize_t EchoTestServer::ReadFromClient(char* buffer, size_t length) {
+#ifdef IOTC_TEST_ECHOSERVER_TLS
+  if (tls_) {
+    const int result = SSL_read(tls_, buffer, (int)length);
+    if (result <= 0 && SSL_get_error(tls_, result) == SSL_ERROR_WANT_READ) {
+      errno = EAGAIN;
+      return -1;
+    }
+    return result;
+  }
+#endif
+  return read(client_socket_, buffer, length);
+}
+
+bool EchoTestServer::WriteToClient(const char* buffer, size_t length) {
+#ifdef IOTC_TEST_ECHOSERVER_TLS
+  if (tls_) {
+    return SSL_write(tls_, buffer, (int)length) == (int)length;
+  }
+#endif
+  while (length > 0) {
+    const ssize_t written = write(client_socket_, buffer, length);
+    if (written < 0 && errno == EINTR) {
+      continue;
+    }
+    if (written <= 0) {
+      return false;
+    }
+    buffer += written;
+    length -= written;
+  }
+  return true;
+}
+
 EchoTestServer::ServerError EchoTestServer::CreateServer() {
   struct timeval tv;
   struct addrinfo hints;
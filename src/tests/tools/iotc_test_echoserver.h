@@ -22,8 +22,15 @@
 #include <stdio.h>
 #include <string.h>
 #include <unistd.h>
+#include <atomic>
+#include <memory>
+#include <string>
 #include <thread>
 
+#ifdef IOTC_TEST_ECHOSERVER_TLS
+#include <openssl/ssl.h>
+#endif
+
 namespace iotctest {
 
 const uint16_t kTimeoutSeconds = 1;
@@ -51,8 +58,32 @@ class EchoTestServer {
   static std::unique_ptr<EchoTestServer> Create(std::string host, uint16_t port,
                                                 uint16_t socket_type,
                                                 uint16_t protocol_type);
+
+  /**
+   * @function
+   * @brief creates a TCP server that answers like an MQTT broker.
+   *
+   * Instead of echoing, the server accepts one client at a time and answers
+   * CONNECT, QoS1 PUBLISH, SUBSCRIBE, UNSUBSCRIBE and PINGREQ messages with
+   * the matching acknowledgements. Payloads are dropped. It stands in for a broker on
+   * the loopback interface where the broker's own cost must not blur the
+   * client's numbers.
+   */
+  static std::unique_ptr<EchoTestServer> CreateMqttBroker(
+      std::string host, uint16_t port, uint16_t protocol_type);
   virtual ~EchoTestServer();
 
+#ifdef IOTC_TEST_ECHOSERVER_TLS
+  /**
+   * @function
+   * @brief makes the MQTT broker accept TLS connections only.
+   *
+   * @return true if the PEM encoded certificate chain and key were loaded.
+   */
+  bool EnableTls(const std::string& certificate_file,
+                 const std::string& private_key_file);
+#endif
+
   /**
    * @function
    * @brief runs proper echo server regarding the type of server
@@ -62,9 +93,19 @@ class EchoTestServer {
 
   void Stop();
 
+  /* counters of the MQTT broker, safe to read while it runs */
+  uint64_t bytes_received() const { return bytes_received_; }
+  uint64_t publishes_received() const { return publishes_received_; }
+
  private:
+  enum class Mode {
+    kEcho = 0,
+    kMqttBroker = 1,
+  };
+
   const std::string host_;
   const uint16_t test_port_, socket_type_, protocol_type_;
+  Mode mode_ = Mode::kEcho;
 
   EchoTestServer(std::string host, uint16_t port, uint16_t socket_type,
                  uint16_t protocol_type);
@@ -113,10 +154,40 @@ class EchoTestServer {
    */
   ServerError RunUdpServer();
 
+  /**
+   * @function
+   * @brief serves MQTT clients one after the other until Stop is called.
+   *
+   * @return
+   * - kSuccess - if the server was stopped.
+   * - kFailedAccept - if accept call finished with error.
+   */
+  ServerError RunMqttBroker();
+
+  /**
+   * @function
+   * @brief answers the MQTT messages of one client until it disconnects.
+   *
+   * Messages may be split across reads or share one, the answers to all the
+   * messages of a read are sent with a single write.
+   */
+  void ServeMqttClient();
+
+  ssize_t ReadFromClient(char* buffer, size_t length);
+  bool WriteToClient(const char* buffer, size_t length);
+
   std::unique_ptr<std::thread> server_thread_;
-  bool runnable_ = true;
+  std::atomic<bool> runnable_{true};
   int server_socket_, client_socket_, recv_len_;
   char recv_buf_[kBufferSize];
+
+  std::atomic<uint64_t> bytes_received_{0};
+  std::atomic<uint64_t> publishes_received_{0};
+
+#ifdef IOTC_TEST_ECHOSERVER_TLS
+  SSL_CTX* tls_context_ = nullptr;
+  SSL* tls_ = nullptr;
+#endif
 };
 };  // namespace iotctest
 #endif
@@ -0,0 +1,146 @@
+/* Copyright 2018-2020 Google LLC
+ *
+ * This is part of the Google Cloud IoT Device SDK for Embedded C.
+ * It is licensed under the BSD 3-Clause license; you may not use this file
+ * except in compliance with the License.
+ *
+ * You may obtain a copy of the License at:
+ *  https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "iotc_tt_testcase_management.h"
+#include "tinytest.h"
+#include "tinytest_macros.h"
+
+#include <iotc_bsp_io_net.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#ifdef IOTC_PLATFORM_BASE_POSIX
+#include <sys/resource.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#ifndef IOTC_TT_TESTCASE_ENUMERATION__SECONDPREPROCESSORRUN
+
+#ifdef IOTC_PLATFORM_BASE_POSIX
+
+/* raises the descriptor limit so that fd can be opened, returns 0 if the hard
+ * limit doesn't allow it */
+int utest_bsp_io_net_allow_fd(int fd) {
+  struct rlimit limit;
+
+  if (0 != getrlimit(RLIMIT_NOFILE, &limit)) {
+    return 0;
+  }
+
+  if (limit.rlim_cur > (rlim_t)fd) {
+    return 1;
+  }
+
+  if (limit.rlim_max <= (rlim_t)fd) {
+    return 0;
+  }
+
+  limit.rlim_cur = (rlim_t)fd + 1;
+  return 0 == setrlimit(RLIMIT_NOFILE, &limit) ? 1 : 0;
+}
+
+#endif /* IOTC_PLATFORM_BASE_POSIX */
+
+#endif /* IOTC_TT_TESTCASE_ENUMERATION__SECONDPREPROCESSORRUN */
+
+IOTC_TT_TESTGROUP_BEGIN(utest_bsp_io_net)
+
+#ifdef IOTC_PLATFORM_BASE_POSIX
+
+IOTC_TT_TESTCASE(
+    utest__iotc_bsp_io_net_select__one_socket_readable__only_that_one_reported,
+    {
+      int readable[2] = {-1, -1};
+      int idle[2] = {-1, -1};
+
+      tt_int_op(0, ==, socketpair(AF_UNIX, SOCK_STREAM, 0, readable));
+      tt_int_op(0, ==, socketpair(AF_UNIX, SOCK_STREAM, 0, idle));
+      tt_int_op(1, ==, write(readable[1], "x", 1));
+
+      iotc_bsp_socket_events_t socket_events[2];
+      memset(socket_events, 0, sizeof(socket_events));
+      socket_events[0].iotc_socket = idle[0];
+      socket_events[0].in_socket_want_read = 1;
+      socket_events[1].iotc_socket = readable[0];
+      socket_events[1].in_socket_want_read = 1;
+
+      tt_int_op(IOTC_BSP_IO_NET_STATE_OK, ==,
+                iotc_bsp_io_net_select(socket_events, 2, 1));
+
+      tt_int_op(0, ==, socket_events[0].out_socket_can_read);
+      tt_int_op(1, ==, socket_events[1].out_socket_can_read);
+      tt_int_op(0, ==, socket_events[1].out_socket_can_write);
+      tt_int_op(0, ==, socket_events[1].out_socket_error);
+
+    end:
+      close(readable[0]);
+      close(readable[1]);
+      close(idle[0]);
+      close(idle[1]);
+    })
+
+/* processes with thousands of connections have descriptors above the
+ * FD_SETSIZE limit of select() */
+IOTC_TT_TESTCASE(
+    utest__iotc_bsp_io_net_select__descriptor_above_fd_setsize__events_reported,
+    {
+      const int high_fd = FD_SETSIZE + 8;
+      int sockets[2] = {-1, -1};
+      int dup_fd = -1;
+
+      if (0 == utest_bsp_io_net_allow_fd(high_fd)) {
+        tt_skip();
+      }
+
+      tt_int_op(0, ==, socketpair(AF_UNIX, SOCK_STREAM, 0, sockets));
+      dup_fd = dup2(sockets[0], high_fd);
+      tt_int_op(high_fd, ==, dup_fd);
+      tt_int_op(1, ==, write(sockets[1], "x", 1));
+
+      iotc_bsp_socket_events_t socket_events[1];
+      memset(socket_events, 0, sizeof(socket_events));
+      socket_events[0].iotc_socket = high_fd;
+      socket_events[0].in_socket_want_read = 1;
+      socket_events[0].in_socket_want_write = 1;
+
+      tt_int_op(IOTC_BSP_IO_NET_STATE_OK, ==,
+                iotc_bsp_io_net_select(socket_events, 1, 1));
+
+      tt_int_op(1, ==, socket_events[0].out_socket_can_read);
+      tt_int_op(1, ==, socket_events[0].out_socket_can_write);
+
+    end:
+      if (0 <= dup_fd) {
+        close(dup_fd);
+      }
+      if (0 <= sockets[0]) {
+        close(sockets[0]);
+        close(sockets[1]);
+      }
+    })
+
+#endif /* IOTC_PLATFORM_BASE_POSIX */
+
+IOTC_TT_TESTGROUP_END
+
+#ifndef IOTC_TT_TESTCASE_ENUMERATION__SECONDPREPROCESSORRUN
+#define IOTC_TT_TESTCASE_ENUMERATION__SECONDPREPROCESSORRUN
+#include __FILE__
+#undef IOTC_TT_TESTCASE_ENUMERATION__SECONDPREPROCESSORRUN
+#endif
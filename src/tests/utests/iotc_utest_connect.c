@@ -20,6 +20,8 @@
 #include "tinytest_macros.h"
 
 #include "iotc.h"
+#include "iotc_config.h"
+#include "iotc_globals.h"
 
 #include <stdio.h>
 
@@ -259,6 +261,54 @@ IOTC_TT_TESTCASE_WITH_SETUP(
     end:;
     })
 
+IOTC_TT_TESTCASE_WITH_SETUP(
+    test_create_context__256th_context__globals_kept, iotc_utest_setup_basic,
+    iotc_utest_teardown_basic, NULL, {
+      iotc_context_handle_t first_context = iotc_create_context();
+      tt_assert(0 <= first_context);
+
+      iotc_handle_table_t* context_handles = iotc_globals.context_handles;
+
+      /* every context holds a reference to the globals, act as if 254 more
+       * contexts were alive */
+      iotc_globals.globals_ref_count += 254;
+
+      iotc_context_handle_t second_context = iotc_create_context();
+      tt_assert(0 <= second_context);
+
+      tt_int_op(iotc_globals.globals_ref_count, ==, 256);
+      tt_assert(context_handles == iotc_globals.context_handles);
+
+      iotc_delete_context(second_context);
+      iotc_globals.globals_ref_count -= 254;
+      iotc_delete_context(first_context);
+
+      tt_int_op(iotc_globals.globals_ref_count, ==, 0);
+    end:;
+    })
+
+IOTC_TT_TESTCASE_WITH_SETUP(
+    test_create_context__max_num_contexts__one_more_refused,
+    iotc_utest_setup_basic, iotc_utest_teardown_basic, NULL, {
+      iotc_context_handle_t contexts[IOTC_MAX_NUM_CONTEXTS];
+      int created = 0;
+
+      for (; created < IOTC_MAX_NUM_CONTEXTS; ++created) {
+        contexts[created] = iotc_create_context();
+        tt_assert(0 <= contexts[created]);
+      }
+
+      tt_int_op(-IOTC_NO_MORE_RESOURCE_AVAILABLE, ==, iotc_create_context());
+
+    end:
+      while (0 < created) {
+        created -= 1;
+        if (0 <= contexts[created]) {
+          iotc_delete_context(contexts[created]);
+        }
+      }
+    })
+
 IOTC_TT_TESTGROUP_END
 
 #ifndef IOTC_TT_TESTCASE_ENUMERATION__SECONDPREPROCESSORRUN
@@ -0,0 +1,285 @@
+/* Copyright 2018-2020 Google LLC
+ *
+ * This is part of the Google Cloud IoT Device SDK for Embedded C.
+ * It is licensed under the BSD 3-Clause license; you may not use this file
+ * except in compliance with the License.
+ *
+ * You may obtain a copy of the License at:
+ *  https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "iotc_memory_checks.h"
+#include "iotc_tt_testcase_management.h"
+#include "tinytest.h"
+#include "tinytest_macros.h"
+
+#include "iotc_config.h"
+#include "iotc_connect_scheduler.h"
+#include "iotc_globals.h"
+#include "iotc_types_internal.h"
+
+#include <string.h>
+
+#ifndef IOTC_TT_TESTCASE_ENUMERATION__SECONDPREPROCESSORRUN
+
+#define IOTC_UTEST_CONNECT_SCHEDULER_CONTEXTS 1000
+
+static iotc_context_data_t
+    utest_connect_scheduler_contexts[IOTC_UTEST_CONNECT_SCHEDULER_CONTEXTS];
+
+/* contexts whose handshake has started and not finished yet */
+static iotc_context_data_t*
+    utest_connect_scheduler_in_flight[IOTC_UTEST_CONNECT_SCHEDULER_CONTEXTS];
+static size_t utest_connect_scheduler_in_flight_no = 0;
+static size_t utest_connect_scheduler_max_in_flight_no = 0;
+static size_t utest_connect_scheduler_started_no = 0;
+
+void utest_connect_scheduler_reset(iotc_evtd_instance_t* evtd) {
+  memset(utest_connect_scheduler_contexts, 0,
+         sizeof(utest_connect_scheduler_contexts));
+
+  size_t i = 0;
+  for (; i < IOTC_UTEST_CONNECT_SCHEDULER_CONTEXTS; ++i) {
+    utest_connect_scheduler_contexts[i].evtd_instance = evtd;
+  }
+
+  utest_connect_scheduler_in_flight_no = 0;
+  utest_connect_scheduler_max_in_flight_no = 0;
+  utest_connect_scheduler_started_no = 0;
+}
+
+/* stands for the init of the layer chain */
+iotc_state_t utest_connect_scheduler_init(void* data) {
+  utest_connect_scheduler_in_flight[utest_connect_scheduler_in_flight_no++] =
+      (iotc_context_data_t*)data;
+  utest_connect_scheduler_started_no += 1;
+
+  if (utest_connect_scheduler_max_in_flight_no <
+      utest_connect_scheduler_in_flight_no) {
+    utest_connect_scheduler_max_in_flight_no =
+        utest_connect_scheduler_in_flight_no;
+  }
+
+  return IOTC_STATE_OK;
+}
+
+iotc_state_t utest_connect_scheduler_submit(iotc_context_data_t* context_data,
+                                            uint32_t delay) {
+  return iotc_connect_scheduler_submit(
+      context_data,
+      iotc_make_handle(&utest_connect_scheduler_init, context_data), delay);
+}
+
+/* finishes every handshake in progress, a slot is released for each */
+void utest_connect_scheduler_finish_in_flight(iotc_state_t state) {
+  iotc_context_data_t* finished[IOTC_UTEST_CONNECT_SCHEDULER_CONTEXTS];
+  const size_t finished_no = utest_connect_scheduler_in_flight_no;
+
+  memcpy(finished, utest_connect_scheduler_in_flight,
+         finished_no * sizeof(iotc_context_data_t*));
+  utest_connect_scheduler_in_flight_no = 0;
+
+  size_t i = 0;
+  for (; i < finished_no; ++i) {
+    iotc_connect_scheduler_connection_state_changed(finished[i], state);
+  }
+}
+
+#endif
+
+IOTC_TT_TESTGROUP_BEGIN(utest_connect_scheduler)
+
+IOTC_TT_TESTCASE(
+    utest__iotc_connect_scheduler_submit__limit_reached__contexts_wait_in_fifo_order,
+    {
+      iotc_evtd_instance_t* evtd = iotc_evtd_create_instance();
+      tt_ptr_op(NULL, !=, evtd);
+
+      utest_connect_scheduler_reset(evtd);
+      iotc_connect_scheduler_set_max_concurrent(2);
+
+      size_t i = 0;
+      for (; i < 3; ++i) {
+        tt_int_op(IOTC_STATE_OK, ==,
+                  utest_connect_scheduler_submit(
+                      &utest_connect_scheduler_contexts[i], 0));
+      }
+
+      /* the init of the two admitted contexts */
+      iotc_evtd_step(evtd, 1);
+
+      tt_int_op(2, ==, utest_connect_scheduler_started_no);
+      tt_ptr_op(&utest_connect_scheduler_contexts[0], ==,
+                utest_connect_scheduler_in_flight[0]);
+      tt_ptr_op(&utest_connect_scheduler_contexts[1], ==,
+                utest_connect_scheduler_in_flight[1]);
+      tt_int_op(1, ==,
+                iotc_connect_scheduler_is_waiting(
+                    &utest_connect_scheduler_contexts[2]));
+
+      /* the first handshake is over, the waiting context takes its slot */
+      iotc_connect_scheduler_connection_state_changed(
+          &utest_connect_scheduler_contexts[0], IOTC_STATE_OK);
+      tt_int_op(0, ==,
+                iotc_connect_scheduler_is_waiting(
+                    &utest_connect_scheduler_contexts[2]));
+
+      iotc_evtd_step(evtd, 3);
+
+      tt_int_op(3, ==, utest_connect_scheduler_started_no);
+      tt_ptr_op(&utest_connect_scheduler_contexts[2], ==,
+                utest_connect_scheduler_in_flight[2]);
+
+      iotc_connect_scheduler_connection_state_changed(
+          &utest_connect_scheduler_contexts[1], IOTC_STATE_OK);
+      iotc_connect_scheduler_connection_state_changed(
+          &utest_connect_scheduler_contexts[2], IOTC_STATE_OK);
+
+      tt_int_op(0, ==, iotc_globals.connect_scheduler.admitted_count);
+
+    end:
+      iotc_connect_scheduler_set_max_concurrent(IOTC_MAX_CONCURRENT_CONNECTS);
+      iotc_evtd_destroy_instance(evtd);
+      tt_int_op(iotc_is_whole_memory_deallocated(), >, 0);
+    })
+
+IOTC_TT_TESTCASE(
+    utest__iotc_connect_scheduler_cancel__waiting_context__never_started, {
+      iotc_evtd_instance_t* evtd = iotc_evtd_create_instance();
+      tt_ptr_op(NULL, !=, evtd);
+
+      utest_connect_scheduler_reset(evtd);
+      iotc_connect_scheduler_set_max_concurrent(1);
+
+      tt_int_op(IOTC_STATE_OK, ==,
+                utest_connect_scheduler_submit(
+                    &utest_connect_scheduler_contexts[0], 0));
+      tt_int_op(IOTC_STATE_OK, ==,
+                utest_connect_scheduler_submit(
+                    &utest_connect_scheduler_contexts[1], 0));
+
+      iotc_evtd_step(evtd, 1);
+
+      tt_int_op(1, ==,
+                iotc_connect_scheduler_is_waiting(
+                    &utest_connect_scheduler_contexts[1]));
+
+      iotc_connect_scheduler_cancel(&utest_connect_scheduler_contexts[1]);
+      utest_connect_scheduler_finish_in_flight(IOTC_STATE_OK);
+
+      iotc_evtd_step(evtd, 3);
+
+      tt_int_op(1, ==, utest_connect_scheduler_started_no);
+      tt_int_op(0, ==, iotc_globals.connect_scheduler.admitted_count);
+      tt_ptr_op(NULL, ==, iotc_globals.connect_scheduler.waiting_head);
+
+    end:
+      iotc_connect_scheduler_set_max_concurrent(IOTC_MAX_CONCURRENT_CONNECTS);
+      iotc_evtd_destroy_instance(evtd);
+      tt_int_op(iotc_is_whole_memory_deallocated(), >, 0);
+    })
+
+IOTC_TT_TESTCASE(
+    utest__iotc_connect_scheduler_submit__session_lost_on_error__reconnect_jittered_within_bounds,
+    {
+      iotc_evtd_instance_t* evtd = iotc_evtd_create_instance();
+      tt_ptr_op(NULL, !=, evtd);
+
+      utest_connect_scheduler_reset(evtd);
+
+      iotc_context_data_t* context_data = &utest_connect_scheduler_contexts[0];
+
+      /* the first connect is not delayed */
+      tt_int_op(IOTC_STATE_OK, ==,
+                utest_connect_scheduler_submit(context_data, 0));
+      tt_int_op(0, ==, context_data->connect_admission.jitter);
+
+      iotc_evtd_step(evtd, 0);
+      tt_int_op(1, ==, utest_connect_scheduler_started_no);
+
+      uint32_t prev_jitter = IOTC_CONNECT_JITTER_BASE;
+      iotc_time_t now = 0;
+
+      size_t i = 0;
+      for (; i < 16; ++i) {
+        utest_connect_scheduler_finish_in_flight(IOTC_STATE_TIMEOUT);
+
+        tt_int_op(IOTC_STATE_OK, ==,
+                  utest_connect_scheduler_submit(context_data, 0));
+
+        const uint32_t jitter = context_data->connect_admission.jitter;
+        tt_int_op(jitter, >=, IOTC_CONNECT_JITTER_BASE);
+        tt_int_op(jitter, <=, IOTC_CONNECT_JITTER_CAP);
+        tt_int_op(jitter, <=, 3 * prev_jitter);
+        prev_jitter = jitter;
+
+        /* nothing starts before the jitter is over */
+        iotc_evtd_step(evtd, now + jitter - 1);
+        tt_int_op(1 + i, ==, utest_connect_scheduler_started_no);
+
+        now += jitter;
+        iotc_evtd_step(evtd, now);
+        iotc_evtd_step(evtd, now);
+        tt_int_op(2 + i, ==, utest_connect_scheduler_started_no);
+      }
+
+      /* a good session clears the jitter */
+      utest_connect_scheduler_finish_in_flight(IOTC_STATE_OK);
+      tt_int_op(0, ==, context_data->connect_admission.jitter);
+
+    end:
+      iotc_evtd_destroy_instance(evtd);
+      tt_int_op(iotc_is_whole_memory_deallocated(), >, 0);
+    })
+
+IOTC_TT_TESTCASE(
+    utest__iotc_connect_scheduler_submit__1000_contexts_reconnect_at_once__bounded_handshakes_and_recovery_time,
+    {
+      iotc_evtd_instance_t* evtd = iotc_evtd_create_instance();
+      tt_ptr_op(NULL, !=, evtd);
+
+      utest_connect_scheduler_reset(evtd);
+      iotc_connect_scheduler_set_max_concurrent(8);
+
+      size_t i = 0;
+      for (; i < IOTC_UTEST_CONNECT_SCHEDULER_CONTEXTS; ++i) {
+        tt_int_op(IOTC_STATE_OK, ==,
+                  utest_connect_scheduler_submit(
+                      &utest_connect_scheduler_contexts[i], 0));
+      }
+
+      /* every step finishes the handshakes started in the previous one */
+      iotc_time_t now = 0;
+      for (; utest_connect_scheduler_started_no <
+                 IOTC_UTEST_CONNECT_SCHEDULER_CONTEXTS &&
+             now < 2 * IOTC_UTEST_CONNECT_SCHEDULER_CONTEXTS;
+           ++now) {
+        iotc_evtd_step(evtd, now);
+        utest_connect_scheduler_finish_in_flight(IOTC_STATE_OK);
+      }
+
+      tt_int_op(IOTC_UTEST_CONNECT_SCHEDULER_CONTEXTS, ==,
+                utest_connect_scheduler_started_no);
+      tt_int_op(8, ==, utest_connect_scheduler_max_in_flight_no);
+      tt_int_op(now, <=, IOTC_UTEST_CONNECT_SCHEDULER_CONTEXTS / 8 + 2);
+      tt_int_op(0, ==, iotc_globals.connect_scheduler.admitted_count);
+
+    end:
+      iotc_connect_scheduler_set_max_concurrent(IOTC_MAX_CONCURRENT_CONNECTS);
+      iotc_evtd_destroy_instance(evtd);
+      tt_int_op(iotc_is_whole_memory_deallocated(), >, 0);
+    })
+
+IOTC_TT_TESTGROUP_END
+
+#ifndef IOTC_TT_TESTCASE_ENUMERATION__SECONDPREPROCESSORRUN
+#define IOTC_TT_TESTCASE_ENUMERATION__SECONDPREPROCESSORRUN
+#include __FILE__
+#undef IOTC_TT_TESTCASE_ENUMERATION__SECONDPREPROCESSORRUN
+#endif
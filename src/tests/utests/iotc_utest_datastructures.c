@@ -20,6 +20,7 @@
 #include "tinytest_macros.h"
 
 #include "iotc_memory_checks.h"
+#include "iotc_mpsc_queue.h"
 #include "iotc_vector.h"
 
 #include <errno.h>
@@ -30,6 +31,11 @@
 
 #ifndef IOTC_TT_TESTCASE_ENUMERATION__SECONDPREPROCESSORRUN
 
+typedef struct utest_mpsc_elem_s {
+  iotc_mpsc_queue_node_t node;
+  int value;
+} utest_mpsc_elem_t;
+
 int8_t vector_is_odd(union iotc_vector_selector_u* e0) {
   if ((e0->i32_value & 1) > 0) {
     return 1;
@@ -243,6 +249,42 @@ end:;
   tt_want_int_op(iotc_is_whole_memory_deallocated(), >, 0);
 })
 
+/* more elements than an int8_t index can address, one per socket of a few
+ * hundred connections on one event dispatcher */
+IOTC_TT_TESTCASE(test_vector_push_find_del__more_than_127_elements, {
+  iotc_vector_t* sv = iotc_vector_create();
+  tt_assert(sv != 0);
+
+  int32_t i = 0;
+  for (; i < 300; ++i) {
+    tt_assert(NULL != iotc_vector_push(sv, IOTC_VEC_CONST_VALUE_PARAM(
+                                               IOTC_VEC_VALUE_I32(i))));
+  }
+
+  tt_int_op(sv->elem_no, ==, 300);
+
+  for (i = 0; i < 300; ++i) {
+    tt_int_op(iotc_vector_find(
+                  sv, IOTC_VEC_CONST_VALUE_PARAM(IOTC_VEC_VALUE_I32(i)),
+                  &utest_datastructures_cmp_vector_i32),
+              ==, i);
+  }
+
+  iotc_vector_del(sv, 200);
+  tt_int_op(sv->elem_no, ==, 299);
+  tt_int_op(iotc_vector_find(
+                sv, IOTC_VEC_CONST_VALUE_PARAM(IOTC_VEC_VALUE_I32(200)),
+                &utest_datastructures_cmp_vector_i32),
+            ==, -1);
+  tt_int_op(iotc_vector_find(
+                sv, IOTC_VEC_CONST_VALUE_PARAM(IOTC_VEC_VALUE_I32(299)),
+                &utest_datastructures_cmp_vector_i32),
+            !=, -1);
+end:;
+  iotc_vector_destroy(sv);
+  tt_want_int_op(iotc_is_whole_memory_deallocated(), >, 0);
+})
+
 IOTC_TT_TESTCASE(test_vector_del, {
   iotc_vector_t* sv = iotc_vector_create();
 
@@ -430,6 +472,62 @@ IOTC_TT_TESTCASE(test_vector_remove_if_PTR, {
   tt_want_int_op(iotc_is_whole_memory_deallocated(), >, 0);
 })
 
+IOTC_TT_TESTCASE(test_mpsc_queue_init__queue_is_empty, {
+  iotc_mpsc_queue_t queue;
+  iotc_mpsc_queue_init(&queue);
+
+  tt_want_int_op(iotc_mpsc_queue_is_empty(&queue), ==, 1);
+  tt_want_ptr_op(iotc_mpsc_queue_pop(&queue), ==, NULL);
+})
+
+IOTC_TT_TESTCASE(test_mpsc_queue_push_pop__elements_popped_in_fifo_order, {
+  iotc_mpsc_queue_t queue;
+  iotc_mpsc_queue_init(&queue);
+
+  utest_mpsc_elem_t elems[10];
+
+  int i = 0;
+  for (; i < 10; ++i) {
+    elems[i].value = i;
+    iotc_mpsc_queue_push(&queue, &elems[i].node);
+  }
+
+  tt_want_int_op(iotc_mpsc_queue_is_empty(&queue), ==, 0);
+
+  for (i = 0; i < 10; ++i) {
+    utest_mpsc_elem_t* elem = (utest_mpsc_elem_t*)iotc_mpsc_queue_pop(&queue);
+    tt_want_ptr_op(elem, ==, &elems[i]);
+  }
+
+  tt_want_int_op(iotc_mpsc_queue_is_empty(&queue), ==, 1);
+  tt_want_ptr_op(iotc_mpsc_queue_pop(&queue), ==, NULL);
+})
+
+IOTC_TT_TESTCASE(test_mpsc_queue_push_pop__interleaved__queue_reusable, {
+  iotc_mpsc_queue_t queue;
+  iotc_mpsc_queue_init(&queue);
+
+  utest_mpsc_elem_t elems[3];
+
+  int round = 0;
+  for (; round < 3; ++round) {
+    /* every round drains the queue, this puts the stub back each time */
+    iotc_mpsc_queue_push(&queue, &elems[0].node);
+    tt_want_ptr_op(iotc_mpsc_queue_pop(&queue), ==, &elems[0].node);
+
+    iotc_mpsc_queue_push(&queue, &elems[1].node);
+    iotc_mpsc_queue_push(&queue, &elems[2].node);
+    tt_want_ptr_op(iotc_mpsc_queue_pop(&queue), ==, &elems[1].node);
+
+    iotc_mpsc_queue_push(&queue, &elems[0].node);
+    tt_want_ptr_op(iotc_mpsc_queue_pop(&queue), ==, &elems[2].node);
+    tt_want_ptr_op(iotc_mpsc_queue_pop(&queue), ==, &elems[0].node);
+
+    tt_want_int_op(iotc_mpsc_queue_is_empty(&queue), ==, 1);
+    tt_want_ptr_op(iotc_mpsc_queue_pop(&queue), ==, NULL);
+  }
+})
+
 IOTC_TT_TESTGROUP_END
 
 #ifndef IOTC_TT_TESTCASE_ENUMERATION__SECONDPREPROCESSORRUN
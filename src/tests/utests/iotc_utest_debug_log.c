@@ -0,0 +1,253 @@
+/* Copyright 2018-2020 Google LLC
+ *
+ * This is part of the Google Cloud IoT Device SDK for Embedded C.
+ * It is licensed under the BSD 3-Clause license; you may not use this file
+ * except in compliance with the License.
+ *
+ * You may obtain a copy of the License at:
+ *  https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "iotc_tt_testcase_management.h"
+#include "tinytest.h"
+#include "tinytest_macros.h"
+
+#include "iotc_debug.h"
+#include "iotc_debug_log.h"
+
+#ifdef IOTC_PLATFORM_BASE_POSIX
+#include <pthread.h>
+#endif
+
+#ifndef IOTC_TT_TESTCASE_ENUMERATION__SECONDPREPROCESSORRUN
+
+typedef struct utest_debug_log_output_s {
+  char buffer[16384];
+  size_t length;
+} utest_debug_log_output_t;
+
+static utest_debug_log_output_t utest_debug_log_output;
+
+static void utest_debug_log_writer(const char* text, size_t length,
+                                   void* user_data) {
+  utest_debug_log_output_t* output = (utest_debug_log_output_t*)user_data;
+
+  if (output->length + length < sizeof(output->buffer)) {
+    memcpy(output->buffer + output->length, text, length);
+    output->length += length;
+    output->buffer[output->length] = '\0';
+  }
+}
+
+static void utest_debug_log_discard(const char* text, size_t length,
+                                    void* user_data) {
+  (void)text;
+  (void)length;
+  (void)user_data;
+}
+
+/* Drops what the library logged before the test. */
+static void utest_debug_log_setup(void) {
+  iotc_debug_log_set_filter(IOTC_DEBUG_LOG_LEVEL_DEBUG,
+                            IOTC_DEBUG_LOG_MODULE_ALL);
+  iotc_debug_log_drain(&utest_debug_log_discard, NULL);
+  memset(&utest_debug_log_output, 0, sizeof(utest_debug_log_output));
+}
+
+static const char* utest_debug_log_drain(void) {
+  iotc_debug_log_drain(&utest_debug_log_writer, &utest_debug_log_output);
+  return utest_debug_log_output.buffer;
+}
+
+#ifdef IOTC_PLATFORM_BASE_POSIX
+static void* utest_debug_log_thread(void* data) {
+  iotc_debug_format("thread record %d", (int)(intptr_t)data);
+  return NULL;
+}
+#endif
+
+#endif /* IOTC_TT_TESTCASE_ENUMERATION__SECONDPREPROCESSORRUN */
+
+IOTC_TT_TESTGROUP_BEGIN(utest_debug_log)
+
+IOTC_TT_TESTCASE(
+    utest__iotc_debug_log_drain__integer_string_and_char_conversions__formatted_like_printf,
+    {
+      utest_debug_log_setup();
+
+      iotc_debug_format("value %d %u %lld %s %c %% %hhx", -5, 7u,
+                        1234567890123LL, "abc", 'x', 0x1ff);
+
+      const char* log = utest_debug_log_drain();
+      tt_ptr_op(NULL, !=,
+                strstr(log, "(utest__iotc_debug_log_drain__integer_string_and_"
+                            "char_conversions__formatted_like_printf)] "));
+      tt_ptr_op(NULL, !=,
+                strstr(log, "] value -5 7 1234567890123 abc x % ff\n"));
+
+    end:;
+    })
+
+IOTC_TT_TESTCASE(
+    utest__iotc_debug_log_drain__width_and_precision_arguments__applied, {
+      utest_debug_log_setup();
+
+      iotc_debug_format("[%08x] [%-4d] [%*d] [%-*d] [%.*s] [%.2f]", 0xbeef, 3,
+                        5, 42, 4, 7, 3, "abcdef", 1.5);
+
+      const char* log = utest_debug_log_drain();
+      tt_ptr_op(NULL, !=,
+                strstr(log,
+                       "] [0000beef] [3   ] [   42] [7   ] [abc] [1.50]\n"));
+
+    end:;
+    })
+
+IOTC_TT_TESTCASE(
+    utest__iotc_debug_log_drain__pointer_and_size_conversions__formatted_like_printf,
+    {
+      utest_debug_log_setup();
+
+      void* pointer = (void*)&utest_debug_log_output;
+      const size_t size = 99;
+      iotc_debug_format("%p %zu", pointer, size);
+
+      char expected[64] = {0};
+      snprintf(expected, sizeof(expected), "] %p %zu\n", pointer, size);
+
+      const char* log = utest_debug_log_drain();
+      tt_ptr_op(NULL, !=, strstr(log, expected));
+
+    end:;
+    })
+
+IOTC_TT_TESTCASE(
+    utest__iotc_debug_log_write__source_string_changed__logged_value_kept, {
+      utest_debug_log_setup();
+
+      char topic[] = "config";
+      iotc_debug_format("topic %s", topic);
+      strcpy(topic, "gone!!");
+
+      const char* log = utest_debug_log_drain();
+      tt_ptr_op(NULL, !=, strstr(log, "] topic config\n"));
+
+    end:;
+    })
+
+IOTC_TT_TESTCASE(utest__iotc_debug_log_set_filter__level_and_modules__applied,
+                 {
+                   utest_debug_log_setup();
+
+                   /* the trace level is filtered out by default */
+                   iotc_debug_printf("trace %d\n", 1);
+
+                   iotc_debug_log_set_filter(IOTC_DEBUG_LOG_LEVEL_TRACE,
+                                             IOTC_DEBUG_LOG_MODULE_ALL);
+                   iotc_debug_printf("trace %d\n", 2);
+
+                   /* this file belongs to the core module */
+                   iotc_debug_log_set_filter(IOTC_DEBUG_LOG_LEVEL_TRACE,
+                                             IOTC_DEBUG_LOG_MODULE_MQTT);
+                   iotc_debug_printf("trace %d\n", 3);
+
+                   iotc_debug_log_set_filter(IOTC_DEBUG_LOG_LEVEL_NONE,
+                                             IOTC_DEBUG_LOG_MODULE_ALL);
+                   iotc_debug_format("debug %d", 4);
+
+                   iotc_debug_log_set_filter(IOTC_DEBUG_LOG_LEVEL_DEBUG,
+                                             IOTC_DEBUG_LOG_MODULE_ALL);
+
+                   const char* log = utest_debug_log_drain();
+                   tt_int_op(0, ==, strcmp(log, "trace 2\n"));
+
+                 end:;
+                 })
+
+IOTC_TT_TESTCASE(utest__iotc_debug_log_write__arguments_too_long__message_cut,
+                 {
+                   utest_debug_log_setup();
+
+                   char payload[IOTC_DEBUG_LOG_ARGS_SIZE * 2] = {0};
+                   memset(payload, 'p', sizeof(payload) - 1);
+
+                   iotc_debug_format("%s %d", payload, 5);
+
+                   const char* log = utest_debug_log_drain();
+                   tt_ptr_op(NULL, !=, strstr(log, "pppp ...\n"));
+                   tt_ptr_op(NULL, ==, strstr(log, " 5"));
+
+                 end:;
+                 })
+
+IOTC_TT_TESTCASE(utest__iotc_debug_log_write__ring_full__records_dropped, {
+  utest_debug_log_setup();
+
+  int i = 0;
+  for (; i < IOTC_DEBUG_LOG_RING_SIZE + 5; ++i) {
+    iotc_debug_format("record %d", i);
+  }
+
+  const char* log = utest_debug_log_drain();
+  tt_int_op(0, ==, strncmp(log, "[5 debug log records dropped]\n", 30));
+  tt_ptr_op(NULL, !=, strstr(log, "] record 0\n"));
+
+  char last[32] = {0};
+  snprintf(last, sizeof(last), "] record %d\n", IOTC_DEBUG_LOG_RING_SIZE - 1);
+  tt_ptr_op(NULL, !=, strstr(log, last));
+
+end:;
+})
+
+IOTC_TT_TESTCASE(
+    utest__iotc_debug_log_write__more_short_lived_threads_than_rings__no_record_dropped,
+    {
+#ifdef IOTC_PLATFORM_BASE_POSIX
+      utest_debug_log_setup();
+
+      /* each thread exits, and hands its ring back, before the next starts */
+      const int thread_count = 3 * IOTC_DEBUG_LOG_MAX_THREADS;
+      int i = 0;
+      for (; i < thread_count; ++i) {
+        pthread_t thread;
+        tt_int_op(0, ==,
+                  pthread_create(&thread, NULL, &utest_debug_log_thread,
+                                 (void*)(intptr_t)i));
+        tt_int_op(0, ==, pthread_join(thread, NULL));
+      }
+
+      const char* log = utest_debug_log_drain();
+      tt_ptr_op(NULL, ==, strstr(log, "dropped"));
+
+      for (i = 0; i < thread_count; ++i) {
+        char record[32] = {0};
+        snprintf(record, sizeof(record), "] thread record %d\n", i);
+        tt_ptr_op(NULL, !=, strstr(log, record));
+      }
+#else
+      tt_skip();
+#endif
+    end:;
+    })
+
+IOTC_TT_TESTCASE(utest__iotc_debug_log_drain__null_writer__invalid_parameter, {
+  tt_int_op(IOTC_INVALID_PARAMETER, ==, iotc_debug_log_drain(NULL, NULL));
+end:;
+})
+
+IOTC_TT_TESTGROUP_END
+
+#ifndef IOTC_TT_TESTCASE_ENUMERATION__SECONDPREPROCESSORRUN
+#define IOTC_TT_TESTCASE_ENUMERATION__SECONDPREPROCESSORRUN
+#include __FILE__
+#undef IOTC_TT_TESTCASE_ENUMERATION__SECONDPREPROCESSORRUN
+#endif
@@ -0,0 +1,632 @@
+/* Copyright 2018-2020 Google LLC
+ *
+ * This is part of the Google Cloud IoT Device SDK for Embedded C.
+ * It is licensed under the BSD 3-Clause license; you may not use this file
+ * except in compliance with the License.
+ *
+ * You may obtain a copy of the License at:
+ *  https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "iotc_memory_checks.h"
+#include "iotc_tt_testcase_management.h"
+#include "tinytest.h"
+#include "tinytest_macros.h"
+
+#include "iotc_dns_cache.h"
+#include "iotc_dns_message.h"
+#include "iotc_dns_resolver.h"
+#include "iotc_event_dispatcher_api.h"
+#include "iotc_event_loop.h"
+#include "iotc_macros.h"
+
+#include <iotc_bsp_time.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#ifdef IOTC_PLATFORM_BASE_POSIX
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#ifndef IOTC_TT_TESTCASE_ENUMERATION__SECONDPREPROCESSORRUN
+
+/* CNAME broker.example.com -> edge.example.com (TTL 300), two A records of
+ * edge.example.com with TTLs 120 and 60 */
+static const uint8_t utest_dns_response_cname_a[] = {
+    0x12, 0x34, 0x81, 0x80, 0x00, 0x01, 0x00, 0x03, 0x00, 0x00, 0x00, 0x00,
+    /* question */
+    0x06, 'b', 'r', 'o', 'k', 'e', 'r', 0x07, 'e', 'x', 'a', 'm', 'p', 'l',
+    'e', 0x03, 'c', 'o', 'm', 0x00, 0x00, 0x01, 0x00, 0x01,
+    /* CNAME */
+    0xC0, 0x0C, 0x00, 0x05, 0x00, 0x01, 0x00, 0x00, 0x01, 0x2C, 0x00, 0x07,
+    0x04, 'e', 'd', 'g', 'e', 0xC0, 0x13,
+    /* A 10.0.0.1 */
+    0xC0, 0x30, 0x00, 0x01, 0x00, 0x01, 0x00, 0x00, 0x00, 0x78, 0x00, 0x04,
+    0x0A, 0x00, 0x00, 0x01,
+    /* A 10.0.0.2 */
+    0xC0, 0x30, 0x00, 0x01, 0x00, 0x01, 0x00, 0x00, 0x00, 0x3C, 0x00, 0x04,
+    0x0A, 0x00, 0x00, 0x02};
+
+/* NXDOMAIN for missing.example.com with the SOA of example.com, TTL 900 and
+ * minimum 30 */
+static const uint8_t utest_dns_response_nxdomain[] = {
+    0xAB, 0xCD, 0x81, 0x83, 0x00, 0x01, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00,
+    /* question */
+    0x07, 'm', 'i', 's', 's', 'i', 'n', 'g', 0x07, 'e', 'x', 'a', 'm', 'p',
+    'l', 'e', 0x03, 'c', 'o', 'm', 0x00, 0x00, 0x1C, 0x00, 0x01,
+    /* SOA */
+    0xC0, 0x14, 0x00, 0x06, 0x00, 0x01, 0x00, 0x00, 0x03, 0x84, 0x00, 0x20,
+    0x02, 'n', 's', 0xC0, 0x14, 0x04, 'h', 'o', 's', 't', 0xC0, 0x14, 0x00,
+    0x00, 0x00, 0x01, 0x00, 0x00, 0x0E, 0x10, 0x00, 0x00, 0x02, 0x58, 0x00,
+    0x09, 0x3A, 0x80, 0x00, 0x00, 0x00, 0x1E};
+
+/* A 10.6.6.6 of evil.example.com, which is not on the chain of
+ * broker.example.com, then A 10.0.0.1 of broker.example.com */
+static const uint8_t utest_dns_response_off_chain_a[] = {
+    0x55, 0x66, 0x81, 0x80, 0x00, 0x01, 0x00, 0x02, 0x00, 0x00, 0x00, 0x00,
+    /* question */
+    0x06, 'b', 'r', 'o', 'k', 'e', 'r', 0x07, 'e', 'x', 'a', 'm', 'p', 'l',
+    'e', 0x03, 'c', 'o', 'm', 0x00, 0x00, 0x01, 0x00, 0x01,
+    /* A 10.6.6.6 of evil.example.com */
+    0x04, 'e', 'v', 'i', 'l', 0xC0, 0x13, 0x00, 0x01, 0x00, 0x01, 0x00, 0x00,
+    0x00, 0x78, 0x00, 0x04, 0x0A, 0x06, 0x06, 0x06,
+    /* A 10.0.0.1 */
+    0xC0, 0x0C, 0x00, 0x01, 0x00, 0x01, 0x00, 0x00, 0x00, 0x3C, 0x00, 0x04,
+    0x0A, 0x00, 0x00, 0x01};
+
+static uint8_t utest_dns_continuation_calls = 0;
+
+iotc_state_t utest_dns_continuation(void* data) {
+  IOTC_UNUSED(data);
+  utest_dns_continuation_calls += 1;
+  return IOTC_STATE_OK;
+}
+
+#ifdef IOTC_PLATFORM_BASE_POSIX
+
+/* answers every A query with 192.0.2.<n> and every AAAA query with
+ * 2001:db8::<n>, or with NXDOMAIN if is_nxdomain is set */
+typedef struct utest_dns_stub_server_s {
+  int fd;
+  uint16_t port;
+  uint8_t is_nxdomain;
+  uint32_t ttl;
+  uint16_t queries_received;
+} utest_dns_stub_server_t;
+
+uint8_t utest_dns_stub_server_start(utest_dns_stub_server_t* server) {
+  struct sockaddr_in addr;
+  socklen_t addr_len = sizeof(addr);
+
+  memset(server, 0, sizeof(utest_dns_stub_server_t));
+  memset(&addr, 0, sizeof(addr));
+
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  addr.sin_port = 0;
+
+  server->fd = socket(AF_INET, SOCK_DGRAM, 0);
+
+  if (0 > server->fd ||
+      0 != bind(server->fd, (struct sockaddr*)&addr, sizeof(addr)) ||
+      0 != getsockname(server->fd, (struct sockaddr*)&addr, &addr_len)) {
+    return 0;
+  }
+
+  server->port = ntohs(addr.sin_port);
+  server->ttl = 300;
+
+  return 1;
+}
+
+void utest_dns_stub_server_stop(utest_dns_stub_server_t* server) {
+  if (0 <= server->fd) {
+    close(server->fd);
+  }
+}
+
+/* answers up to max_queries queries arriving within the timeout, returns
+ * their number */
+uint16_t utest_dns_stub_server_serve(utest_dns_stub_server_t* server,
+                                     uint16_t max_queries, long timeout_ms) {
+  uint16_t served = 0;
+
+  while (served < max_queries) {
+    fd_set rfds;
+    struct timeval tv = {0, timeout_ms * 1000};
+
+    FD_ZERO(&rfds);
+    FD_SET(server->fd, &rfds);
+
+    if (0 >= select(server->fd + 1, &rfds, NULL, NULL, &tv)) {
+      return served;
+    }
+
+    uint8_t msg[IOTC_DNS_MESSAGE_MAX_SIZE];
+    struct sockaddr_storage from;
+    socklen_t from_len = sizeof(from);
+
+    const ssize_t len = recvfrom(server->fd, msg, sizeof(msg) - 32, 0,
+                                 (struct sockaddr*)&from, &from_len);
+
+    if (12 + 5 > len) {
+      continue;
+    }
+
+    served += 1;
+    server->queries_received += 1;
+
+    const uint16_t type = (uint16_t)((msg[len - 4] << 8) | msg[len - 3]);
+    size_t pos = (size_t)len;
+
+    /* QR, RD, RA and the rcode */
+    msg[2] = 0x81;
+    msg[3] = server->is_nxdomain ? 0x83 : 0x80;
+    msg[7] = server->is_nxdomain ? 0 : 1;
+
+    if (0 == server->is_nxdomain) {
+      const uint8_t record[] = {0xC0,
+                                0x0C,
+                                0x00,
+                                (uint8_t)type,
+                                0x00,
+                                0x01,
+                                (uint8_t)(server->ttl >> 24),
+                                (uint8_t)(server->ttl >> 16),
+                                (uint8_t)(server->ttl >> 8),
+                                (uint8_t)server->ttl,
+                                0x00,
+                                IOTC_DNS_TYPE_A == type ? 4 : 16};
+      memcpy(msg + pos, record, sizeof(record));
+      pos += sizeof(record);
+
+      if (IOTC_DNS_TYPE_A == type) {
+        const uint8_t ip[] = {192, 0, 2, (uint8_t)server->queries_received};
+        memcpy(msg + pos, ip, sizeof(ip));
+        pos += sizeof(ip);
+      } else {
+        const uint8_t ip[] = {0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0,
+                              0,    0,    0,    0,    0, 0, 0,
+                              (uint8_t)server->queries_received};
+        memcpy(msg + pos, ip, sizeof(ip));
+        pos += sizeof(ip);
+      }
+    }
+
+    sendto(server->fd, msg, pos, 0, (struct sockaddr*)&from, from_len);
+  }
+
+  return served;
+}
+
+/* runs the event loop until the continuation has been called */
+void utest_dns_run_until_resolved(iotc_evtd_instance_t* evtd) {
+  uint8_t iterations = 0;
+
+  for (; 0 == utest_dns_continuation_calls && iterations < 10; ++iterations) {
+    iotc_event_loop_with_evtds(1, &evtd, 1);
+  }
+}
+
+#endif /* IOTC_PLATFORM_BASE_POSIX */
+
+#endif /* IOTC_TT_TESTCASE_ENUMERATION__SECONDPREPROCESSORRUN */
+
+IOTC_TT_TESTGROUP_BEGIN(utest_dns)
+
+IOTC_TT_TESTCASE(
+    utest__iotc_dns_message_encode_query__valid_host__labels_and_question_encoded,
+    {
+      uint8_t buffer[IOTC_DNS_MESSAGE_MAX_SIZE];
+      size_t len = 0;
+
+      const uint8_t expected[] = {0x12, 0x34, 0x01, 0x00, 0x00, 0x01, 0x00,
+                                  0x00, 0x00, 0x00, 0x00, 0x00, 0x04, 'm',
+                                  'q',  't',  't',  0x02, 'i', 'o', 0x00,
+                                  0x00, 0x1C, 0x00, 0x01};
+
+      tt_int_op(IOTC_STATE_OK, ==,
+                iotc_dns_message_encode_query(0x1234, "mqtt.io.",
+                                              IOTC_DNS_TYPE_AAAA, buffer,
+                                              sizeof(buffer), &len));
+      tt_int_op(sizeof(expected), ==, len);
+      tt_assert(0 == memcmp(expected, buffer, len));
+
+      tt_int_op(IOTC_INVALID_PARAMETER, ==,
+                iotc_dns_message_encode_query(1, "mqtt..io", IOTC_DNS_TYPE_A,
+                                              buffer, sizeof(buffer), &len));
+      tt_int_op(IOTC_INVALID_PARAMETER, ==,
+                iotc_dns_message_encode_query(1, "", IOTC_DNS_TYPE_A, buffer,
+                                              sizeof(buffer), &len));
+      tt_int_op(IOTC_BUFFER_TOO_SMALL_ERROR, ==,
+                iotc_dns_message_encode_query(1, "mqtt.io", IOTC_DNS_TYPE_A,
+                                              buffer, 16, &len));
+    end:;
+    })
+
+IOTC_TT_TESTCASE(
+    utest__iotc_dns_message_parse_response__cname_chain__addresses_with_lowest_ttl,
+    {
+      iotc_dns_addresses_t addresses;
+      uint32_t ttl = 0;
+
+      memset(&addresses, 0, sizeof(addresses));
+
+      tt_int_op(IOTC_DNS_ANSWER_ADDRESSES, ==,
+                iotc_dns_message_parse_response(
+                    utest_dns_response_cname_a,
+                    sizeof(utest_dns_response_cname_a), 0x1234,
+                    "broker.example.com", IOTC_DNS_TYPE_A, &addresses, &ttl));
+
+      tt_int_op(2, ==, addresses.count);
+      tt_int_op(PROTOCOL_IPV4, ==, addresses.address[0].protocol);
+      tt_str_op("10.0.0.1", ==, addresses.address[0].host);
+      tt_str_op("10.0.0.2", ==, addresses.address[1].host);
+      tt_int_op(60, ==, ttl);
+
+      /* answers to other queries are ignored */
+      tt_int_op(IOTC_DNS_ANSWER_MALFORMED, ==,
+                iotc_dns_message_parse_response(
+                    utest_dns_response_cname_a,
+                    sizeof(utest_dns_response_cname_a), 0x4321,
+                    "broker.example.com", IOTC_DNS_TYPE_A, &addresses, &ttl));
+      tt_int_op(IOTC_DNS_ANSWER_MALFORMED, ==,
+                iotc_dns_message_parse_response(
+                    utest_dns_response_cname_a,
+                    sizeof(utest_dns_response_cname_a), 0x1234,
+                    "broker.example.com", IOTC_DNS_TYPE_AAAA, &addresses,
+                    &ttl));
+      tt_int_op(IOTC_DNS_ANSWER_MALFORMED, ==,
+                iotc_dns_message_parse_response(
+                    utest_dns_response_cname_a,
+                    sizeof(utest_dns_response_cname_a) - 1, 0x1234,
+                    "broker.example.com", IOTC_DNS_TYPE_A, &addresses, &ttl));
+      tt_int_op(2, ==, addresses.count);
+    end:;
+    })
+
+IOTC_TT_TESTCASE(
+    utest__iotc_dns_message_parse_response__question_of_other_host__ignored,
+    {
+      iotc_dns_addresses_t addresses;
+      uint32_t ttl = 0;
+
+      memset(&addresses, 0, sizeof(addresses));
+
+      tt_int_op(IOTC_DNS_ANSWER_MALFORMED, ==,
+                iotc_dns_message_parse_response(
+                    utest_dns_response_cname_a,
+                    sizeof(utest_dns_response_cname_a), 0x1234,
+                    "other.example.com", IOTC_DNS_TYPE_A, &addresses, &ttl));
+      tt_int_op(IOTC_DNS_ANSWER_MALFORMED, ==,
+                iotc_dns_message_parse_response(
+                    utest_dns_response_cname_a,
+                    sizeof(utest_dns_response_cname_a), 0x1234, "broker",
+                    IOTC_DNS_TYPE_A, &addresses, &ttl));
+      tt_int_op(0, ==, addresses.count);
+
+      /* names are case insensitive, the root label is optional */
+      tt_int_op(IOTC_DNS_ANSWER_ADDRESSES, ==,
+                iotc_dns_message_parse_response(
+                    utest_dns_response_cname_a,
+                    sizeof(utest_dns_response_cname_a), 0x1234,
+                    "BROKER.Example.com.", IOTC_DNS_TYPE_A, &addresses, &ttl));
+      tt_int_op(2, ==, addresses.count);
+    end:;
+    })
+
+IOTC_TT_TESTCASE(
+    utest__iotc_dns_message_parse_response__record_off_the_cname_chain__skipped,
+    {
+      iotc_dns_addresses_t addresses;
+      uint32_t ttl = 0;
+
+      memset(&addresses, 0, sizeof(addresses));
+
+      tt_int_op(IOTC_DNS_ANSWER_ADDRESSES, ==,
+                iotc_dns_message_parse_response(
+                    utest_dns_response_off_chain_a,
+                    sizeof(utest_dns_response_off_chain_a), 0x5566,
+                    "broker.example.com", IOTC_DNS_TYPE_A, &addresses, &ttl));
+
+      tt_int_op(1, ==, addresses.count);
+      tt_str_op("10.0.0.1", ==, addresses.address[0].host);
+      tt_int_op(60, ==, ttl);
+
+    end:;
+    })
+
+IOTC_TT_TESTCASE(
+    utest__iotc_dns_message_parse_response__nxdomain_with_soa__negative_ttl_from_soa,
+    {
+      iotc_dns_addresses_t addresses;
+      uint32_t ttl = 0;
+
+      memset(&addresses, 0, sizeof(addresses));
+
+      tt_int_op(IOTC_DNS_ANSWER_NAME_ERROR, ==,
+                iotc_dns_message_parse_response(
+                    utest_dns_response_nxdomain,
+                    sizeof(utest_dns_response_nxdomain), 0xABCD,
+                    "missing.example.com", IOTC_DNS_TYPE_AAAA, &addresses,
+                    &ttl));
+
+      tt_int_op(0, ==, addresses.count);
+      tt_int_op(30, ==, ttl);
+    end:;
+    })
+
+IOTC_TT_TESTCASE(
+    utest__iotc_dns_message_is_address_literal__hosts_and_literals__literals_detected,
+    {
+      tt_int_op(1, ==, iotc_dns_message_is_address_literal("127.0.0.1"));
+      tt_int_op(1, ==, iotc_dns_message_is_address_literal("::1"));
+      tt_int_op(1, ==, iotc_dns_message_is_address_literal("2001:db8::1"));
+      tt_int_op(0, ==, iotc_dns_message_is_address_literal("localhost"));
+      tt_int_op(0, ==,
+                iotc_dns_message_is_address_literal("mqtt.2030.ltsapis.goog"));
+      tt_int_op(0, ==, iotc_dns_message_is_address_literal(""));
+    end:;
+    })
+
+IOTC_TT_TESTCASE(
+    utest__iotc_dns_cache_lookup__ttl_elapsed__entry_expired, {
+      iotc_dns_addresses_t addresses;
+      iotc_dns_addresses_t cached;
+      iotc_state_t state = IOTC_STATE_OK;
+
+      memset(&addresses, 0, sizeof(addresses));
+      addresses.count = 1;
+      strcpy(addresses.address[0].host, "10.0.0.1");
+
+      iotc_dns_cache_flush();
+      iotc_dns_cache_store("Broker.Example.com", &addresses, 60, 1000);
+
+      /* names are case insensitive */
+      tt_int_op(1, ==,
+                iotc_dns_cache_lookup("broker.example.com.", 1059, &cached,
+                                      &state));
+      tt_int_op(IOTC_STATE_OK, ==, state);
+      tt_str_op("10.0.0.1", ==, cached.address[0].host);
+
+      tt_int_op(0, ==,
+                iotc_dns_cache_lookup("broker.example.com", 1060, &cached,
+                                      &state));
+
+      /* a zero TTL is not cached at all */
+      iotc_dns_cache_store("broker.example.com", &addresses, 0, 2000);
+      tt_int_op(0, ==,
+                iotc_dns_cache_lookup("broker.example.com", 2000, &cached,
+                                      &state));
+
+      /* TTLs are capped */
+      iotc_dns_cache_store("broker.example.com", &addresses, UINT32_MAX, 0);
+      tt_int_op(0, ==,
+                iotc_dns_cache_lookup("broker.example.com",
+                                      IOTC_DNS_CACHE_MAX_TTL, &cached, &state));
+
+    end:
+      iotc_dns_cache_flush();
+    })
+
+IOTC_TT_TESTCASE(
+    utest__iotc_dns_cache_store__negative_entry__lookup_reports_resolution_error,
+    {
+      iotc_dns_addresses_t cached;
+      iotc_state_t state = IOTC_STATE_OK;
+
+      iotc_dns_cache_flush();
+      iotc_dns_cache_store("missing.example.com", NULL, 30, 0);
+
+      tt_int_op(1, ==,
+                iotc_dns_cache_lookup("missing.example.com", 29, &cached,
+                                      &state));
+      tt_int_op(IOTC_SOCKET_GETHOSTBYNAME_ERROR, ==, state);
+      tt_int_op(0, ==, cached.count);
+
+      /* negative entries are capped lower than positive ones */
+      iotc_dns_cache_store("missing.example.com", NULL, UINT32_MAX, 0);
+      tt_int_op(0, ==,
+                iotc_dns_cache_lookup("missing.example.com",
+                                      IOTC_DNS_NEGATIVE_CACHE_MAX_TTL, &cached,
+                                      &state));
+
+    end:
+      iotc_dns_cache_flush();
+    })
+
+IOTC_TT_TESTCASE(
+    utest__iotc_dns_cache_store__cache_full__entry_closest_to_expiry_replaced,
+    {
+      iotc_dns_addresses_t addresses;
+      iotc_dns_addresses_t cached;
+      iotc_state_t state = IOTC_STATE_OK;
+      char host[16];
+
+      memset(&addresses, 0, sizeof(addresses));
+      addresses.count = 1;
+
+      iotc_dns_cache_flush();
+
+      int i = 0;
+      for (; i < IOTC_DNS_CACHE_SIZE; ++i) {
+        sprintf(host, "host%d.test", i);
+        /* host1 expires first */
+        iotc_dns_cache_store(host, &addresses, 1 == i ? 10 : 100, 0);
+      }
+
+      iotc_dns_cache_store("newcomer.test", &addresses, 100, 1);
+
+      tt_int_op(1, ==,
+                iotc_dns_cache_lookup("newcomer.test", 1, &cached, &state));
+      tt_int_op(0, ==,
+                iotc_dns_cache_lookup("host1.test", 1, &cached, &state));
+      tt_int_op(1, ==,
+                iotc_dns_cache_lookup("host0.test", 1, &cached, &state));
+
+    end:
+      iotc_dns_cache_flush();
+    })
+
+#ifdef IOTC_PLATFORM_BASE_POSIX
+
+IOTC_TT_TESTCASE(
+    utest__iotc_dns_resolve__stub_server_answers__addresses_resolved_and_cached,
+    {
+      utest_dns_stub_server_t server;
+      iotc_dns_result_t result;
+      iotc_evtd_instance_t* evtd = iotc_evtd_create_instance();
+
+      tt_ptr_op(NULL, !=, evtd);
+      tt_int_op(1, ==, utest_dns_stub_server_start(&server));
+      tt_int_op(IOTC_STATE_OK, ==,
+                iotc_dns_resolver_set_server("127.0.0.1", server.port));
+      tt_int_op(1, ==, iotc_dns_resolver_is_needed("broker.test"));
+      tt_int_op(0, ==, iotc_dns_resolver_is_needed("127.0.0.1"));
+
+      iotc_evtd_step(evtd, iotc_bsp_time_getcurrenttime_seconds());
+      utest_dns_continuation_calls = 0;
+
+      tt_int_op(IOTC_STATE_WANT_READ, ==,
+                iotc_dns_resolve(evtd, "broker.test", &result,
+                                 iotc_make_handle(&utest_dns_continuation,
+                                                  NULL)));
+      tt_ptr_op(NULL, !=, result.query);
+
+      /* the A and the AAAA query */
+      tt_int_op(2, ==, utest_dns_stub_server_serve(&server, 2, 500));
+
+      utest_dns_run_until_resolved(evtd);
+
+      tt_int_op(1, ==, utest_dns_continuation_calls);
+      tt_ptr_op(NULL, ==, result.query);
+      tt_int_op(IOTC_STATE_OK, ==, result.state);
+      tt_int_op(2, ==, result.addresses.count);
+
+      /* the next connect is served from the cache without a query */
+      tt_int_op(IOTC_STATE_OK, ==,
+                iotc_dns_resolve(evtd, "broker.test", &result,
+                                 iotc_make_handle(&utest_dns_continuation,
+                                                  NULL)));
+      tt_int_op(IOTC_STATE_OK, ==, result.state);
+      tt_int_op(2, ==, result.addresses.count);
+      tt_int_op(0, ==, utest_dns_stub_server_serve(&server, 1, 100));
+
+    end:
+      iotc_dns_resolver_set_server(NULL, 0);
+      utest_dns_stub_server_stop(&server);
+      iotc_evtd_destroy_instance(evtd);
+      tt_int_op(iotc_is_whole_memory_deallocated(), >, 0);
+    })
+
+IOTC_TT_TESTCASE(
+    utest__iotc_dns_resolve__stub_server_nxdomain__failure_negatively_cached,
+    {
+      utest_dns_stub_server_t server;
+      iotc_dns_result_t result;
+      iotc_evtd_instance_t* evtd = iotc_evtd_create_instance();
+
+      tt_ptr_op(NULL, !=, evtd);
+      tt_int_op(1, ==, utest_dns_stub_server_start(&server));
+      tt_int_op(IOTC_STATE_OK, ==,
+                iotc_dns_resolver_set_server("127.0.0.1", server.port));
+
+      server.is_nxdomain = 1;
+
+      iotc_evtd_step(evtd, iotc_bsp_time_getcurrenttime_seconds());
+      utest_dns_continuation_calls = 0;
+
+      tt_int_op(IOTC_STATE_WANT_READ, ==,
+                iotc_dns_resolve(evtd, "missing.test", &result,
+                                 iotc_make_handle(&utest_dns_continuation,
+                                                  NULL)));
+      tt_int_op(2, ==, utest_dns_stub_server_serve(&server, 2, 500));
+
+      utest_dns_run_until_resolved(evtd);
+
+      tt_int_op(1, ==, utest_dns_continuation_calls);
+      tt_int_op(IOTC_SOCKET_GETHOSTBYNAME_ERROR, ==, result.state);
+
+      tt_int_op(IOTC_STATE_OK, ==,
+                iotc_dns_resolve(evtd, "missing.test", &result,
+                                 iotc_make_handle(&utest_dns_continuation,
+                                                  NULL)));
+      tt_int_op(IOTC_SOCKET_GETHOSTBYNAME_ERROR, ==, result.state);
+      tt_int_op(0, ==, utest_dns_stub_server_serve(&server, 1, 100));
+
+    end:
+      iotc_dns_resolver_set_server(NULL, 0);
+      utest_dns_stub_server_stop(&server);
+      iotc_evtd_destroy_instance(evtd);
+      tt_int_op(iotc_is_whole_memory_deallocated(), >, 0);
+    })
+
+IOTC_TT_TESTCASE(
+    utest__iotc_dns_resolve__server_silent__queries_retried_then_failure_not_cached,
+    {
+      utest_dns_stub_server_t server;
+      iotc_dns_result_t result;
+      iotc_evtd_instance_t* evtd = iotc_evtd_create_instance();
+
+      tt_ptr_op(NULL, !=, evtd);
+      tt_int_op(1, ==, utest_dns_stub_server_start(&server));
+      tt_int_op(IOTC_STATE_OK, ==,
+                iotc_dns_resolver_set_server("127.0.0.1", server.port));
+
+      utest_dns_continuation_calls = 0;
+
+      tt_int_op(IOTC_STATE_WANT_READ, ==,
+                iotc_dns_resolve(evtd, "silent.test", &result,
+                                 iotc_make_handle(&utest_dns_continuation,
+                                                  NULL)));
+
+      /* the queries are never answered, only the timeouts move on */
+      iotc_time_t now = 0;
+      int attempt = 0;
+      for (; attempt < IOTC_DNS_QUERY_ATTEMPTS; ++attempt) {
+        now += IOTC_DNS_QUERY_TIMEOUT;
+        iotc_evtd_step(evtd, now);
+      }
+
+      tt_int_op(1, ==, utest_dns_continuation_calls);
+      tt_int_op(IOTC_SOCKET_GETHOSTBYNAME_ERROR, ==, result.state);
+      tt_int_op(0, ==, result.addresses.count);
+
+      close(server.fd);
+      server.fd = -1;
+
+      /* a failure of the server is not remembered */
+      tt_int_op(IOTC_STATE_WANT_READ, ==,
+                iotc_dns_resolve(evtd, "silent.test", &result,
+                                 iotc_make_handle(&utest_dns_continuation,
+                                                  NULL)));
+      iotc_dns_resolve_cancel(&result);
+      tt_ptr_op(NULL, ==, result.query);
+
+    end:
+      iotc_dns_resolver_set_server(NULL, 0);
+      utest_dns_stub_server_stop(&server);
+      iotc_evtd_destroy_instance(evtd);
+      tt_int_op(iotc_is_whole_memory_deallocated(), >, 0);
+    })
+
+#endif /* IOTC_PLATFORM_BASE_POSIX */
+
+IOTC_TT_TESTGROUP_END
+
+#ifndef IOTC_TT_TESTCASE_ENUMERATION__SECONDPREPROCESSORRUN
+#define IOTC_TT_TESTCASE_ENUMERATION__SECONDPREPROCESSORRUN
+#include __FILE__
+#undef IOTC_TT_TESTCASE_ENUMERATION__SECONDPREPROCESSORRUN
+#endif
@@ -27,6 +27,9 @@
 #include "tinytest_macros.h"
 
 #include "iotc_event_dispatcher_api.h"
+#include "iotc_event_loop.h"
+
+#include <iotc_bsp_io_net.h>
 
 #ifndef IOTC_TT_TESTCASE_ENUMERATION__SECONDPREPROCESSORRUN
 
@@ -60,6 +63,29 @@ iotc_state_t continuation1_5(iotc_event_handle_arg1_t a) {
 static iotc_evtd_instance_t* evtd_g_i = 0;
 static iotc_event_handle_t evtd_handle_g;
 
+/* not part of a header, the event loop calls it after the bsp select */
+extern iotc_state_t iotc_bsp_event_loop_update_event_dispatcher(
+    iotc_evtd_instance_t** in_event_dispatchers, uint8_t in_num_evtds,
+    iotc_bsp_socket_events_t* in_socket_events_array,
+    size_t in_socket_events_array_length);
+
+/* closes socket 22 and opens socket 23, like a handler that drops a
+ * connection and starts a new one */
+iotc_state_t close_and_open_socket(iotc_event_handle_arg1_t a) {
+  *((uint32_t*)a) += 1;
+
+  iotc_evtd_unregister_socket_fd(evtd_g_i, 22);
+
+  iotc_event_handle_t evtd_handle = {
+      IOTC_EVENT_HANDLE_ARGC1,
+      .handlers.h1 = {&continuation1_1, (iotc_event_handle_arg1_t)a}};
+  iotc_evtd_register_socket_fd(evtd_g_i, 23, evtd_handle);
+  iotc_evtd_continue_when_evt_on_socket(evtd_g_i, IOTC_EVENT_WANT_READ,
+                                        evtd_handle, 23);
+
+  return 0;
+}
+
 iotc_state_t proc_loop(iotc_event_handle_arg1_t a) {
   *((uint32_t*)a) -= 1;
 
@@ -350,6 +376,64 @@ end:
   iotc_evtd_destroy_instance(evtd_g_i);
 })
 
+IOTC_TT_TESTCASE(
+    utest__event_loop_update__handler_closes_socket__selected_sockets_updated,
+    {
+      uint32_t counter_21 = 0;
+      uint32_t counter_22 = 0;
+      uint32_t counter_24 = 0;
+
+      evtd_g_i = iotc_evtd_create_instance();
+
+      {
+        iotc_event_handle_t evtd_handle = {
+            IOTC_EVENT_HANDLE_ARGC1,
+            .handlers.h1 = {&close_and_open_socket,
+                            (iotc_event_handle_arg1_t)&counter_21}};
+        tt_assert(iotc_evtd_register_socket_fd(evtd_g_i, 21, evtd_handle));
+      }
+      {
+        iotc_event_handle_t evtd_handle = {
+            IOTC_EVENT_HANDLE_ARGC1,
+            .handlers.h1 = {&continuation1_1,
+                            (iotc_event_handle_arg1_t)&counter_22}};
+        tt_assert(iotc_evtd_register_socket_fd(evtd_g_i, 22, evtd_handle));
+      }
+      {
+        iotc_event_handle_t evtd_handle = {
+            IOTC_EVENT_HANDLE_ARGC1,
+            .handlers.h1 = {&continuation1_1,
+                            (iotc_event_handle_arg1_t)&counter_24}};
+        tt_assert(iotc_evtd_register_socket_fd(evtd_g_i, 24, evtd_handle));
+      }
+
+      /* all three sockets came out of the select readable */
+      iotc_bsp_socket_events_t socket_events[3];
+      memset(socket_events, 0, sizeof(socket_events));
+      socket_events[0].iotc_socket = 21;
+      socket_events[0].out_socket_can_read = 1;
+      socket_events[1].iotc_socket = 22;
+      socket_events[1].out_socket_can_read = 1;
+      socket_events[2].iotc_socket = 24;
+      socket_events[2].out_socket_can_read = 1;
+
+      tt_int_op(IOTC_STATE_OK, ==,
+                iotc_bsp_event_loop_update_event_dispatcher(&evtd_g_i, 1,
+                                                            socket_events, 3));
+
+      /* 22 was closed before its turn and 23 wasn't part of the select */
+      tt_int_op(1, ==, counter_21);
+      tt_int_op(0, ==, counter_22);
+      tt_int_op(1, ==, counter_24);
+
+      iotc_evtd_unregister_socket_fd(evtd_g_i, 21);
+      iotc_evtd_unregister_socket_fd(evtd_g_i, 23);
+      iotc_evtd_unregister_socket_fd(evtd_g_i, 24);
+
+    end:
+      iotc_evtd_destroy_instance(evtd_g_i);
+    })
+
 /* skipped because this feature is not yet implemented */
 SKIP_IOTC_TT_TESTCASE(
     utest__iotc_evtd__events_to_call_added__overlap_timer__proper_events_executed,
@@ -91,6 +91,34 @@ iotc_state_t iotc_utest_local_action__io_timed(void* arg1, void* vector,
   return IOTC_STATE_OK;
 }
 
+iotc_evtd_instance_t* iotc_utest_local_postpone_evtd = NULL;
+iotc_time_t iotc_utest_local_last_activity = 0;
+
+iotc_state_t iotc_utest_local_action__io_postponed(void* arg1, void* vector,
+                                                   iotc_state_t state,
+                                                   void* execution_counter) {
+  IOTC_UNUSED(state);
+
+  iotc_io_timeout_t* timeout_element = (iotc_io_timeout_t*)arg1;
+  iotc_time_event_handle_t* event = &timeout_element->timeout;
+  iotc_evtd_instance_t* evtd = iotc_utest_local_postpone_evtd;
+
+  iotc_io_timeouts_remove(event, vector);
+
+  if (1 == iotc_io_timeouts_postpone(
+               evtd,
+               iotc_make_handle(&iotc_utest_local_action__io_postponed,
+                                timeout_element, vector, IOTC_STATE_OK,
+                                execution_counter),
+               10, iotc_utest_local_last_activity, vector, event)) {
+    return IOTC_STATE_OK;
+  }
+
+  *((int*)execution_counter) += 1;
+
+  return IOTC_STATE_OK;
+}
+
 #endif  // IOTC_TT_TESTCASE_ENUMERATION__SECONDPREPROCESSORRUN
 
 IOTC_TT_TESTGROUP_BEGIN(utest_event_dispatcher_timed)
@@ -264,18 +292,17 @@ IOTC_TT_TESTCASE(
     })
 
 IOTC_TT_TESTCASE(
-    utest__iotc_evtd_io_restart__delayed_execution__events_should_be_restarted,
-    {
-      // This test checks if event dispatcher reschedules handles.
+    utest__iotc_evtd_io_remove__delayed_execution__events_should_be_removed, {
+      // This test checks if event dispatcher removes events from events vector.
 
       iotc_evtd_instance_t* evtd = iotc_evtd_create_instance();
 
       int index = 0;
-      uint32_t time_counter = 0;
       uint32_t execution_counter = 0;
       iotc_state_t state = IOTC_STATE_OK;
       iotc_vector_t* vector = iotc_vector_create();
       iotc_vector_t* test_vector = iotc_vector_create();
+      iotc_vector_t* element_vector = iotc_vector_create();
       iotc_time_event_handle_t* time_event_handle = NULL;
 
       // Schedule 50 handles.
@@ -298,25 +325,31 @@ IOTC_TT_TESTCASE(
                            IOTC_VEC_CONST_VALUE_PARAM(
                                IOTC_VEC_VALUE_PTR(time_event_handle)));
         }
+
+        // Store event in the test vector.
+        iotc_vector_push(
+            element_vector,
+            IOTC_VEC_CONST_VALUE_PARAM(IOTC_VEC_VALUE_PTR(timeout_element)));
       }
 
-      // Simulate time stepping.
-      while (time_counter < 20) {
-        // Restart first 25 elements.
-        if (time_counter == 6) {
-          iotc_io_timeouts_restart(evtd, 10, test_vector);
-        }
-        // Check if last 25 was executed.
-        if (time_counter == 11) {
-          tt_assert(execution_counter == 25);
-        }
-        // Check if first 25 was executed after restart.
-        if (time_counter == 16) {
-          tt_assert(execution_counter == 50);
-        }
-        iotc_evtd_step(evtd, time_counter);
+      // Removing events.
+      for (index = 0; index < 25; index++) {
+        iotc_vector_elem_t element = test_vector->array[index];
+        time_event_handle = element.selector_t.ptr_value;
 
-        time_counter += 1;
+        iotc_io_timeouts_remove(time_event_handle, vector);
+      }
+
+      // Check if the last 25 were removed.
+      tt_assert(vector->elem_no == 25);
+
+      // Cleanup.
+      for (index = 0; index < 50; ++index) {
+        iotc_vector_elem_t element = element_vector->array[index];
+        iotc_io_timeout_t* timeout_element = element.selector_t.ptr_value;
+        iotc_time_event_handle_t* event = &timeout_element->timeout;
+        iotc_io_timeouts_cancel(evtd, event, vector);
+        IOTC_SAFE_FREE(timeout_element);
       }
 
       goto end;
@@ -327,71 +360,55 @@ IOTC_TT_TESTCASE(
     end:
       iotc_vector_destroy(vector);
       iotc_vector_destroy(test_vector);
+      iotc_vector_destroy(element_vector);
       iotc_evtd_destroy_instance(evtd);
 
       tt_want_int_op(iotc_is_whole_memory_deallocated(), >, 0);
     })
 
 IOTC_TT_TESTCASE(
-    utest__iotc_evtd_io_remove__delayed_execution__events_should_be_removed, {
-      // This test checks if event dispatcher removes events from events vector.
-
+    utest__iotc_io_timeouts_postpone__activity_within_period__execution_postponed,
+    {
       iotc_evtd_instance_t* evtd = iotc_evtd_create_instance();
 
-      int index = 0;
       uint32_t execution_counter = 0;
+      iotc_time_t time_counter = 0;
       iotc_state_t state = IOTC_STATE_OK;
       iotc_vector_t* vector = iotc_vector_create();
-      iotc_vector_t* test_vector = iotc_vector_create();
-      iotc_vector_t* element_vector = iotc_vector_create();
-      iotc_time_event_handle_t* time_event_handle = NULL;
 
-      // Schedule 50 handles.
-      for (index = 0; index < 50; index++) {
-        IOTC_ALLOC(iotc_io_timeout_t, timeout_element, state);
-
-        time_event_handle = &timeout_element->timeout;
+      IOTC_ALLOC(iotc_io_timeout_t, timeout_element, state);
 
-        iotc_event_handle_t evtd_handle = iotc_make_handle(
-            &iotc_utest_local_action__io_timed, timeout_element, vector,
-            IOTC_STATE_OK, &execution_counter);
+      iotc_utest_local_postpone_evtd = evtd;
+      iotc_utest_local_last_activity = 0;
+      iotc_evtd_step(evtd, 0);
 
-        // Schedule handle execution.
-        iotc_io_timeouts_create(evtd, evtd_handle, 10, vector,
-                                time_event_handle);
+      iotc_io_timeouts_create(
+          evtd,
+          iotc_make_handle(&iotc_utest_local_action__io_postponed,
+                           timeout_element, vector, IOTC_STATE_OK,
+                           &execution_counter),
+          10, vector, &timeout_element->timeout);
 
-        // Store first 25 events in the test vector.
-        if (index < 25) {
-          iotc_vector_push(test_vector,
-                           IOTC_VEC_CONST_VALUE_PARAM(
-                               IOTC_VEC_VALUE_PTR(time_event_handle)));
+      while (time_counter < 30) {
+        // Activity at 6 moves the deadline from 10 to 16.
+        if (time_counter == 6) {
+          iotc_utest_local_last_activity = time_counter;
         }
+        // The postponed timeout is still in the vector.
+        if (time_counter == 12) {
+          tt_assert(execution_counter == 0);
+          tt_assert(vector->elem_no == 1);
+        }
+        if (time_counter == 17) {
+          tt_assert(execution_counter == 1);
+          tt_assert(vector->elem_no == 0);
+        }
+        iotc_evtd_step(evtd, time_counter);
 
-        // Store event in the test vector.
-        iotc_vector_push(
-            element_vector,
-            IOTC_VEC_CONST_VALUE_PARAM(IOTC_VEC_VALUE_PTR(timeout_element)));
-      }
-
-      // Removing events.
-      for (index = 0; index < 25; index++) {
-        iotc_vector_elem_t element = test_vector->array[index];
-        time_event_handle = element.selector_t.ptr_value;
-
-        iotc_io_timeouts_remove(time_event_handle, vector);
+        time_counter += 1;
       }
 
-      // Check if the last 25 were removed.
-      tt_assert(vector->elem_no == 25);
-
-      // Cleanup.
-      for (index = 0; index < 50; ++index) {
-        iotc_vector_elem_t element = element_vector->array[index];
-        iotc_io_timeout_t* timeout_element = element.selector_t.ptr_value;
-        iotc_time_event_handle_t* event = &timeout_element->timeout;
-        iotc_io_timeouts_cancel(evtd, event, vector);
-        IOTC_SAFE_FREE(timeout_element);
-      }
+      tt_assert(execution_counter == 1);
 
       goto end;
 
@@ -399,9 +416,8 @@ IOTC_TT_TESTCASE(
       tt_abort_msg("test should not fail");
 
     end:
+      IOTC_SAFE_FREE(timeout_element);
       iotc_vector_destroy(vector);
-      iotc_vector_destroy(test_vector);
-      iotc_vector_destroy(element_vector);
       iotc_evtd_destroy_instance(evtd);
 
       tt_want_int_op(iotc_is_whole_memory_deallocated(), >, 0);
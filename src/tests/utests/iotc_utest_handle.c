@@ -22,7 +22,6 @@
 #include "iotc.h"
 #include "iotc_handle.h"
 #include "iotc_types_internal.h"
-#include "iotc_vector.h"
 
 #ifndef IOTC_TT_TESTCASE_ENUMERATION__SECONDPREPROCESSORRUN
 #endif
@@ -30,73 +29,73 @@
 IOTC_TT_TESTGROUP_BEGIN(utest_handle)
 
 IOTC_TT_TESTCASE(utest__iotc_object_for_handle__object_found, {
-  iotc_vector_t* vector = iotc_vector_create();
+  iotc_handle_table_t* table = iotc_handle_table_create(5);
 
   void* object = (void*)(intptr_t)333;
-  iotc_register_handle_for_object(vector, 5, object);
+  iotc_register_handle_for_object(table, object, NULL);
   iotc_handle_t handle;
-  iotc_find_handle_for_object(vector, object, &handle);
+  iotc_find_handle_for_object(table, object, &handle);
 
-  void* object2 = iotc_object_for_handle(vector, handle);
+  void* object2 = iotc_object_for_handle(table, handle);
 
   tt_want_ptr_op(object, ==, object2);
 
-  iotc_vector_destroy(vector);
+  iotc_handle_table_destroy(table);
 
   tt_int_op(iotc_is_whole_memory_deallocated(), >, 0);
 end:;
 })
 
 IOTC_TT_TESTCASE(utest__iotc_object_for_handle__object_not_found, {
-  iotc_vector_t* vector = iotc_vector_create();
+  iotc_handle_table_t* table = iotc_handle_table_create(5);
 
   void* object = (void*)(intptr_t)333;
-  iotc_register_handle_for_object(vector, 5, object);
+  iotc_register_handle_for_object(table, object, NULL);
   iotc_handle_t handle;
-  iotc_find_handle_for_object(vector, object, &handle);
+  iotc_find_handle_for_object(table, object, &handle);
   handle += 1;
 
-  iotc_context_t* object2 = iotc_object_for_handle(vector, handle);
+  iotc_context_t* object2 = iotc_object_for_handle(table, handle);
 
   tt_want_ptr_op(object, !=, object2);
   tt_want_ptr_op(object2, ==, NULL);
 
-  iotc_vector_destroy(vector);
+  iotc_handle_table_destroy(table);
 
   tt_int_op(iotc_is_whole_memory_deallocated(), >, 0);
 end:;
 })
 
 IOTC_TT_TESTCASE(utest__iotc_find_handle_for_object__handle_found, {
-  iotc_vector_t* vector = iotc_vector_create();
+  iotc_handle_table_t* table = iotc_handle_table_create(5);
 
   void* object = (void*)(intptr_t)333;
-  iotc_register_handle_for_object(vector, 5, object);
+  iotc_register_handle_for_object(table, object, NULL);
   iotc_handle_t handle = IOTC_INVALID_CONTEXT_HANDLE;
-  iotc_state_t state = iotc_find_handle_for_object(vector, object, &handle);
+  iotc_state_t state = iotc_find_handle_for_object(table, object, &handle);
 
   tt_want_int_op(state, ==, IOTC_STATE_OK);
   tt_want_int_op(handle, >, IOTC_INVALID_CONTEXT_HANDLE);
 
-  iotc_vector_destroy(vector);
+  iotc_handle_table_destroy(table);
 
   tt_int_op(iotc_is_whole_memory_deallocated(), >, 0);
 end:;
 })
 
 IOTC_TT_TESTCASE(utest__iotc_find_handle_for_object__handle_not_found, {
-  iotc_vector_t* vector = iotc_vector_create();
+  iotc_handle_table_t* table = iotc_handle_table_create(5);
 
   void* object = (void*)(intptr_t)333;
-  iotc_register_handle_for_object(vector, 5, object);
+  iotc_register_handle_for_object(table, object, NULL);
   iotc_context_handle_t handle = IOTC_INVALID_CONTEXT_HANDLE;
   object = (intptr_t*)object + 1;  // cast required to keep IAR happy
-  iotc_state_t state = iotc_find_handle_for_object(vector, object, &handle);
+  iotc_state_t state = iotc_find_handle_for_object(table, object, &handle);
 
   tt_want_int_op(state, ==, IOTC_ELEMENT_NOT_FOUND);
   tt_want_int_op(handle, ==, IOTC_INVALID_CONTEXT_HANDLE);
 
-  iotc_vector_destroy(vector);
+  iotc_handle_table_destroy(table);
 
   tt_int_op(iotc_is_whole_memory_deallocated(), >, 0);
 end:;
@@ -104,40 +103,40 @@ end:;
 
 IOTC_TT_TESTCASE(
     utest__iotc_delete_handle_for_object__delete_success_handle_not_found, {
-      iotc_vector_t* vector = iotc_vector_create();
+      iotc_handle_table_t* table = iotc_handle_table_create(5);
 
       void* object = (void*)(intptr_t)333;
-      iotc_register_handle_for_object(vector, 5, object);
+      iotc_register_handle_for_object(table, object, NULL);
       iotc_state_t state = IOTC_STATE_OK;
       iotc_context_handle_t handle = IOTC_INVALID_CONTEXT_HANDLE;
 
-      state = iotc_find_handle_for_object(vector, object, &handle);
+      state = iotc_find_handle_for_object(table, object, &handle);
       tt_want_int_op(state, ==, IOTC_STATE_OK);
       tt_want_int_op(handle, >, IOTC_INVALID_CONTEXT_HANDLE);
 
-      iotc_state_t delete_state = iotc_delete_handle_for_object(vector, object);
+      iotc_state_t delete_state = iotc_delete_handle_for_object(table, object);
       tt_want_int_op(delete_state, ==, IOTC_STATE_OK);
 
-      state = iotc_find_handle_for_object(vector, object, &handle);
+      state = iotc_find_handle_for_object(table, object, &handle);
       tt_want_int_op(state, ==, IOTC_ELEMENT_NOT_FOUND);
       tt_want_int_op(handle, ==, IOTC_INVALID_CONTEXT_HANDLE);
 
-      iotc_vector_destroy(vector);
+      iotc_handle_table_destroy(table);
 
       tt_int_op(iotc_is_whole_memory_deallocated(), >, 0);
     end:;
     })
 
 IOTC_TT_TESTCASE(utest__iotc_delete_handle_for_object__unsuccessful_delete, {
-  iotc_vector_t* vector = iotc_vector_create();
+  iotc_handle_table_t* table = iotc_handle_table_create(5);
 
   void* unregistered_object = (void*)(intptr_t)444;
   iotc_state_t delete_state =
-      iotc_delete_handle_for_object(vector, unregistered_object);
+      iotc_delete_handle_for_object(table, unregistered_object);
 
   tt_want_int_op(delete_state, ==, IOTC_ELEMENT_NOT_FOUND);
 
-  iotc_vector_destroy(vector);
+  iotc_handle_table_destroy(table);
 
   tt_int_op(iotc_is_whole_memory_deallocated(), >, 0);
 end:;
@@ -145,19 +144,19 @@ end:;
 
 IOTC_TT_TESTCASE(
     utest__iotc_register_handle_for_object__successful_registration, {
-      iotc_vector_t* vector = iotc_vector_create();
-
       int32_t max_num_contexts = 10;
+      iotc_handle_table_t* table = iotc_handle_table_create(max_num_contexts);
+
       int i;
       for (i = 0; i < max_num_contexts; ++i) {
         void* object = (void*)(intptr_t)222;
         iotc_state_t state =
-            iotc_register_handle_for_object(vector, max_num_contexts, object);
+            iotc_register_handle_for_object(table, object, NULL);
 
         tt_want_int_op(state, ==, IOTC_STATE_OK);
       }
 
-      iotc_vector_destroy(vector);
+      iotc_handle_table_destroy(table);
 
       tt_int_op(iotc_is_whole_memory_deallocated(), >, 0);
     end:;
@@ -165,21 +164,99 @@ IOTC_TT_TESTCASE(
 
 IOTC_TT_TESTCASE(
     utest__iotc_register_handle_for_object__unsuccessful_registration, {
-      iotc_vector_t* vector = iotc_vector_create();
-
       int32_t max_num_contexts = 10;
+      iotc_handle_table_t* table = iotc_handle_table_create(max_num_contexts);
+
       int i;
       for (i = 0; i < max_num_contexts; ++i) {
         void* object = (void*)(intptr_t)222;
-        iotc_register_handle_for_object(vector, max_num_contexts, object);
+        iotc_register_handle_for_object(table, object, NULL);
       }
 
       void* object = (void*)(intptr_t)333;
       iotc_state_t state =
-          iotc_register_handle_for_object(vector, max_num_contexts, object);
+          iotc_register_handle_for_object(table, object, NULL);
       tt_want_int_op(state, ==, IOTC_NO_MORE_RESOURCE_AVAILABLE);
 
-      iotc_vector_destroy(vector);
+      iotc_handle_table_destroy(table);
+
+      tt_int_op(iotc_is_whole_memory_deallocated(), >, 0);
+    end:;
+    })
+
+IOTC_TT_TESTCASE(
+    utest__iotc_object_for_handle__stale_handle_after_slot_reuse__object_not_found,
+    {
+      iotc_handle_table_t* table = iotc_handle_table_create(1);
+
+      void* object = (void*)(intptr_t)333;
+      void* new_object = (void*)(intptr_t)444;
+      iotc_handle_t handle = IOTC_INVALID_CONTEXT_HANDLE;
+      iotc_handle_t new_handle = IOTC_INVALID_CONTEXT_HANDLE;
+
+      tt_want_int_op(iotc_register_handle_for_object(table, object, &handle),
+                     ==, IOTC_STATE_OK);
+      tt_want_int_op(iotc_delete_handle_for_object(table, object), ==,
+                     IOTC_STATE_OK);
+
+      /* the only slot is reused with a new generation */
+      tt_want_int_op(
+          iotc_register_handle_for_object(table, new_object, &new_handle), ==,
+          IOTC_STATE_OK);
+      tt_want_int_op(IOTC_HANDLE_INDEX(handle), ==,
+                     IOTC_HANDLE_INDEX(new_handle));
+      tt_want_int_op(handle, !=, new_handle);
+
+      tt_want_ptr_op(iotc_object_for_handle(table, handle), ==, NULL);
+      tt_want_ptr_op(iotc_object_for_handle(table, new_handle), ==,
+                     new_object);
+
+      iotc_handle_table_destroy(table);
+
+      tt_int_op(iotc_is_whole_memory_deallocated(), >, 0);
+    end:;
+    })
+
+IOTC_TT_TESTCASE(
+    utest__iotc_register_handle_for_object__thousands_of_objects__all_handles_resolved,
+    {
+      const int32_t num_objects = 4000;
+      iotc_handle_table_t* table = iotc_handle_table_create(num_objects);
+      iotc_handle_t handle = IOTC_INVALID_CONTEXT_HANDLE;
+      int32_t i;
+
+      /* objects are fake pointers, any distinct non-NULL value will do */
+      for (i = 1; i <= num_objects; ++i) {
+        tt_want_int_op(iotc_register_handle_for_object(
+                           table, (void*)(intptr_t)(i * 16), &handle),
+                       ==, IOTC_STATE_OK);
+      }
+
+      tt_want_int_op(
+          iotc_register_handle_for_object(table, (void*)(intptr_t)8, &handle),
+          ==, IOTC_NO_MORE_RESOURCE_AVAILABLE);
+
+      /* every other object is deleted, the others stay reachable */
+      for (i = 1; i <= num_objects; i += 2) {
+        tt_want_int_op(
+            iotc_delete_handle_for_object(table, (void*)(intptr_t)(i * 16)),
+            ==, IOTC_STATE_OK);
+      }
+
+      for (i = 1; i <= num_objects; ++i) {
+        void* object = (void*)(intptr_t)(i * 16);
+        const iotc_state_t state =
+            iotc_find_handle_for_object(table, object, &handle);
+
+        if (i % 2) {
+          tt_want_int_op(state, ==, IOTC_ELEMENT_NOT_FOUND);
+        } else {
+          tt_want_int_op(state, ==, IOTC_STATE_OK);
+          tt_want_ptr_op(iotc_object_for_handle(table, handle), ==, object);
+        }
+      }
+
+      iotc_handle_table_destroy(table);
 
       tt_int_op(iotc_is_whole_memory_deallocated(), >, 0);
     end:;
@@ -0,0 +1,278 @@
+/* Copyright 2018-2020 Google LLC
+ *
+ * This is part of the Google Cloud IoT Device SDK for Embedded C.
+ * It is licensed under the BSD 3-Clause license; you may not use this file
+ * except in compliance with the License.
+ *
+ * You may obtain a copy of the License at:
+ *  https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "iotc_memory_checks.h"
+#include "iotc_tt_testcase_management.h"
+#include "tinytest.h"
+#include "tinytest_macros.h"
+
+#include "iotc_event_dispatcher_api.h"
+#include "iotc_event_loop.h"
+#include "iotc_io_net_race.h"
+#include "iotc_macros.h"
+
+#include <iotc_bsp_time.h>
+
+#include <string.h>
+
+#ifdef IOTC_PLATFORM_BASE_POSIX
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#ifndef IOTC_TT_TESTCASE_ENUMERATION__SECONDPREPROCESSORRUN
+
+static uint8_t utest_io_net_race_continuation_calls = 0;
+
+iotc_state_t utest_io_net_race_continuation(void* data) {
+  IOTC_UNUSED(data);
+  utest_io_net_race_continuation_calls += 1;
+  return IOTC_STATE_OK;
+}
+
+#ifdef IOTC_PLATFORM_BASE_POSIX
+
+/* listens on 127.0.0.1 only, so the same port on 127.0.0.2 refuses */
+int utest_io_net_race_listen(uint16_t* port) {
+  struct sockaddr_in addr;
+  socklen_t addr_len = sizeof(addr);
+
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+  const int fd = socket(AF_INET, SOCK_STREAM, 0);
+
+  if (0 > fd || 0 != bind(fd, (struct sockaddr*)&addr, sizeof(addr)) ||
+      0 != listen(fd, 4) ||
+      0 != getsockname(fd, (struct sockaddr*)&addr, &addr_len)) {
+    if (0 <= fd) {
+      close(fd);
+    }
+    return -1;
+  }
+
+  *port = ntohs(addr.sin_port);
+  return fd;
+}
+
+void utest_io_net_race_run_until_decided(iotc_evtd_instance_t* evtd) {
+  uint8_t iterations = 0;
+
+  for (; 0 == utest_io_net_race_continuation_calls && iterations < 10;
+       ++iterations) {
+    iotc_event_loop_with_evtds(1, &evtd, 1);
+  }
+}
+
+#endif /* IOTC_PLATFORM_BASE_POSIX */
+
+#endif /* IOTC_TT_TESTCASE_ENUMERATION__SECONDPREPROCESSORRUN */
+
+IOTC_TT_TESTGROUP_BEGIN(utest_io_net_race)
+
+IOTC_TT_TESTCASE(
+    utest__iotc_io_net_race_order__mixed_families__families_alternate_ipv6_first,
+    {
+      iotc_dns_addresses_t addresses;
+      const char* hosts[IOTC_IO_NET_RACE_MAX_ATTEMPTS] = {NULL};
+
+      memset(&addresses, 0, sizeof(addresses));
+      addresses.count = 4;
+      addresses.address[0].protocol = PROTOCOL_IPV4;
+      strcpy(addresses.address[0].host, "192.0.2.1");
+      addresses.address[1].protocol = PROTOCOL_IPV4;
+      strcpy(addresses.address[1].host, "192.0.2.2");
+      addresses.address[2].protocol = PROTOCOL_IPV4;
+      strcpy(addresses.address[2].host, "192.0.2.3");
+      addresses.address[3].protocol = PROTOCOL_IPV6;
+      strcpy(addresses.address[3].host, "2001:db8::1");
+
+      tt_int_op(4, ==, iotc_io_net_race_order(&addresses, hosts));
+      tt_str_op("2001:db8::1", ==, hosts[0]);
+      tt_str_op("192.0.2.1", ==, hosts[1]);
+      tt_str_op("192.0.2.2", ==, hosts[2]);
+      tt_str_op("192.0.2.3", ==, hosts[3]);
+    end:;
+    })
+
+#ifdef IOTC_PLATFORM_BASE_POSIX
+
+IOTC_TT_TESTCASE(
+    utest__iotc_io_net_race_start__first_address_refuses__next_address_wins_without_delay,
+    {
+      iotc_io_net_race_t race;
+      uint16_t port = 0;
+      const char* hosts[] = {"127.0.0.2", "127.0.0.1"};
+      const int listen_fd = utest_io_net_race_listen(&port);
+      iotc_evtd_instance_t* evtd = iotc_evtd_create_instance();
+
+      tt_ptr_op(NULL, !=, evtd);
+      tt_int_op(0, <=, listen_fd);
+
+      iotc_evtd_step(evtd, iotc_bsp_time_getcurrenttime_seconds());
+      utest_io_net_race_continuation_calls = 0;
+
+      const iotc_time_t started_at = iotc_bsp_time_getcurrenttime_seconds();
+
+      tt_int_op(IOTC_STATE_WANT_WRITE, ==,
+                iotc_io_net_race_start(
+                    &race, evtd, hosts, 2, port, NULL,
+                    iotc_make_handle(&utest_io_net_race_continuation, NULL)));
+
+      utest_io_net_race_run_until_decided(evtd);
+
+      tt_int_op(1, ==, utest_io_net_race_continuation_calls);
+      tt_int_op(IOTC_STATE_OK, ==, race.state);
+      tt_int_op(2, ==, race.started_count);
+      tt_int_op(0, ==, race.attempt[0].is_open);
+      /* the refusal started the second attempt, not the attempt delay */
+      tt_int_op(iotc_bsp_time_getcurrenttime_seconds() - started_at, <,
+                IOTC_IO_NET_RACE_ATTEMPT_DELAY + 1);
+
+      close(race.socket);
+
+    end:
+      if (0 <= listen_fd) {
+        close(listen_fd);
+      }
+      iotc_evtd_destroy_instance(evtd);
+      tt_int_op(iotc_is_whole_memory_deallocated(), >, 0);
+    })
+
+IOTC_TT_TESTCASE(
+    utest__iotc_io_net_race_start__first_address_connects__other_addresses_not_tried,
+    {
+      iotc_io_net_race_t race;
+      uint16_t port = 0;
+      const char* hosts[] = {"127.0.0.1", "127.0.0.2"};
+      const int listen_fd = utest_io_net_race_listen(&port);
+      iotc_evtd_instance_t* evtd = iotc_evtd_create_instance();
+
+      tt_ptr_op(NULL, !=, evtd);
+      tt_int_op(0, <=, listen_fd);
+
+      iotc_evtd_step(evtd, iotc_bsp_time_getcurrenttime_seconds());
+      utest_io_net_race_continuation_calls = 0;
+
+      tt_int_op(IOTC_STATE_WANT_WRITE, ==,
+                iotc_io_net_race_start(
+                    &race, evtd, hosts, 2, port, NULL,
+                    iotc_make_handle(&utest_io_net_race_continuation, NULL)));
+
+      utest_io_net_race_run_until_decided(evtd);
+
+      tt_int_op(1, ==, utest_io_net_race_continuation_calls);
+      tt_int_op(IOTC_STATE_OK, ==, race.state);
+      tt_int_op(1, ==, race.started_count);
+      tt_ptr_op(NULL, ==, race.next_attempt.ptr_to_position);
+
+      close(race.socket);
+
+    end:
+      if (0 <= listen_fd) {
+        close(listen_fd);
+      }
+      iotc_evtd_destroy_instance(evtd);
+      tt_int_op(iotc_is_whole_memory_deallocated(), >, 0);
+    })
+
+IOTC_TT_TESTCASE(
+    utest__iotc_io_net_race_start__all_addresses_refuse__connection_error,
+    {
+      iotc_io_net_race_t race;
+      uint16_t port = 0;
+      const char* hosts[] = {"127.0.0.2", "127.0.0.3"};
+      const int listen_fd = utest_io_net_race_listen(&port);
+      iotc_evtd_instance_t* evtd = iotc_evtd_create_instance();
+
+      tt_ptr_op(NULL, !=, evtd);
+      tt_int_op(0, <=, listen_fd);
+
+      iotc_evtd_step(evtd, iotc_bsp_time_getcurrenttime_seconds());
+      utest_io_net_race_continuation_calls = 0;
+
+      tt_int_op(IOTC_STATE_WANT_WRITE, ==,
+                iotc_io_net_race_start(
+                    &race, evtd, hosts, 2, port, NULL,
+                    iotc_make_handle(&utest_io_net_race_continuation, NULL)));
+
+      utest_io_net_race_run_until_decided(evtd);
+
+      tt_int_op(1, ==, utest_io_net_race_continuation_calls);
+      tt_int_op(IOTC_SOCKET_CONNECTION_ERROR, ==, race.state);
+      tt_int_op(2, ==, race.started_count);
+      tt_int_op(0, ==, race.attempt[0].is_open);
+      tt_int_op(0, ==, race.attempt[1].is_open);
+
+    end:
+      if (0 <= listen_fd) {
+        close(listen_fd);
+      }
+      iotc_evtd_destroy_instance(evtd);
+      tt_int_op(iotc_is_whole_memory_deallocated(), >, 0);
+    })
+
+IOTC_TT_TESTCASE(
+    utest__iotc_io_net_race_cancel__race_running__attempts_closed_no_continuation,
+    {
+      iotc_io_net_race_t race;
+      uint16_t port = 0;
+      const char* hosts[] = {"127.0.0.1", "127.0.0.1"};
+      const int listen_fd = utest_io_net_race_listen(&port);
+      iotc_evtd_instance_t* evtd = iotc_evtd_create_instance();
+
+      tt_ptr_op(NULL, !=, evtd);
+      tt_int_op(0, <=, listen_fd);
+
+      iotc_evtd_step(evtd, iotc_bsp_time_getcurrenttime_seconds());
+      utest_io_net_race_continuation_calls = 0;
+
+      tt_int_op(IOTC_STATE_WANT_WRITE, ==,
+                iotc_io_net_race_start(
+                    &race, evtd, hosts, 2, port, NULL,
+                    iotc_make_handle(&utest_io_net_race_continuation, NULL)));
+      tt_ptr_op(NULL, !=, race.next_attempt.ptr_to_position);
+
+      iotc_io_net_race_cancel(&race);
+
+      tt_int_op(0, ==, race.is_running);
+      tt_int_op(0, ==, race.attempt[0].is_open);
+      tt_ptr_op(NULL, ==, race.next_attempt.ptr_to_position);
+
+      iotc_evtd_step(evtd, iotc_bsp_time_getcurrenttime_seconds() +
+                               IOTC_IO_NET_RACE_ATTEMPT_DELAY);
+      tt_int_op(0, ==, utest_io_net_race_continuation_calls);
+
+    end:
+      if (0 <= listen_fd) {
+        close(listen_fd);
+      }
+      iotc_evtd_destroy_instance(evtd);
+      tt_int_op(iotc_is_whole_memory_deallocated(), >, 0);
+    })
+
+#endif /* IOTC_PLATFORM_BASE_POSIX */
+
+IOTC_TT_TESTGROUP_END
+
+#ifndef IOTC_TT_TESTCASE_ENUMERATION__SECONDPREPROCESSORRUN
+#define IOTC_TT_TESTCASE_ENUMERATION__SECONDPREPROCESSORRUN
+#include __FILE__
+#undef IOTC_TT_TESTCASE_ENUMERATION__SECONDPREPROCESSORRUN
+#endif
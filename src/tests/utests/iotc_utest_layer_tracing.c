@@ -0,0 +1,239 @@
+/* Copyright 2018-2020 Google LLC
+ *
+ * This is part of the Google Cloud IoT Device SDK for Embedded C.
+ * It is licensed under the BSD 3-Clause license; you may not use this file
+ * except in compliance with the License.
+ *
+ * You may obtain a copy of the License at:
+ *  https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "iotc_tt_testcase_management.h"
+#include "tinytest.h"
+#include "tinytest_macros.h"
+
+#include "iotc_event_dispatcher_api.h"
+#include "iotc_layer_api.h"
+#include "iotc_layer_tracing.h"
+#include "iotc_layers_ids.h"
+
+#ifndef IOTC_TT_TESTCASE_ENUMERATION__SECONDPREPROCESSORRUN
+
+typedef struct utest_layer_tracing_output_s {
+  char buffer[8192];
+  size_t length;
+  size_t chunks;
+  size_t flow_starts;
+} utest_layer_tracing_output_t;
+
+static utest_layer_tracing_output_t utest_layer_tracing_output;
+
+static void* utest_layer_tracing_pushed_data = NULL;
+
+static iotc_state_t utest_layer_tracing_push(void* context, void* data,
+                                             iotc_state_t state) {
+  (void)context;
+  (void)state;
+
+  utest_layer_tracing_pushed_data = data;
+  return IOTC_STATE_TIMEOUT;
+}
+
+static void utest_layer_tracing_writer(const char* chunk, size_t length,
+                                       void* user_data) {
+  utest_layer_tracing_output_t* output =
+      (utest_layer_tracing_output_t*)user_data;
+
+  ++output->chunks;
+  if (NULL != strstr(chunk, "\"ph\":\"s\"")) {
+    ++output->flow_starts;
+  }
+
+  if (output->length + length < sizeof(output->buffer)) {
+    memcpy(output->buffer + output->length, chunk, length);
+    output->length += length;
+    output->buffer[output->length] = '\0';
+  }
+}
+
+static void utest_layer_tracing_init_layer(
+    iotc_layer_t* layer, iotc_layer_interface_t* funcs,
+    iotc_layer_type_id_t layer_type_id) {
+  memset(layer, 0, sizeof(iotc_layer_t));
+  layer->layer_funcs = funcs;
+  layer->layer_connection.self = layer;
+  layer->layer_type_id = layer_type_id;
+}
+
+#endif /* IOTC_TT_TESTCASE_ENUMERATION__SECONDPREPROCESSORRUN */
+
+IOTC_TT_TESTGROUP_BEGIN(utest_layer_tracing)
+
+IOTC_TT_TESTCASE(
+    utest__iotc_layer_tracing_make_handle__handle_executed__function_called_and_three_records,
+    {
+      iotc_layer_interface_t funcs;
+      memset(&funcs, 0, sizeof(funcs));
+      funcs.push = &utest_layer_tracing_push;
+
+      iotc_layer_t from_layer;
+      iotc_layer_t to_layer;
+      utest_layer_tracing_init_layer(&from_layer, &funcs,
+                                     IOTC_LAYER_TYPE_MQTT_LOGIC);
+      utest_layer_tracing_init_layer(&to_layer, &funcs,
+                                     IOTC_LAYER_TYPE_MQTT_CODEC);
+
+      int data = 42;
+      utest_layer_tracing_pushed_data = NULL;
+
+      iotc_layer_tracing_clear();
+
+      iotc_event_handle_t handle = iotc_layer_tracing_make_handle(
+          &utest_layer_tracing_push, &from_layer.layer_connection,
+          &to_layer.layer_connection, &data, IOTC_STATE_OK);
+      tt_int_op(1, ==, iotc_layer_tracing_get_record_count());
+
+      iotc_evtd_execute_handle(&handle);
+
+      tt_ptr_op(&data, ==, utest_layer_tracing_pushed_data);
+      tt_int_op(3, ==, iotc_layer_tracing_get_record_count());
+
+    end:;
+    })
+
+IOTC_TT_TESTCASE(
+    utest__iotc_layer_tracing_export__traced_push__chrome_trace_events, {
+      iotc_layer_interface_t funcs;
+      memset(&funcs, 0, sizeof(funcs));
+      funcs.push = &utest_layer_tracing_push;
+
+      iotc_layer_t from_layer;
+      iotc_layer_t to_layer;
+      utest_layer_tracing_init_layer(&from_layer, &funcs,
+                                     IOTC_LAYER_TYPE_MQTT_LOGIC);
+      utest_layer_tracing_init_layer(&to_layer, &funcs,
+                                     IOTC_LAYER_TYPE_MQTT_CODEC);
+
+      int data = 42;
+
+      iotc_layer_tracing_clear();
+
+      iotc_event_handle_t handle = iotc_layer_tracing_make_handle(
+          &utest_layer_tracing_push, &from_layer.layer_connection,
+          &to_layer.layer_connection, &data, IOTC_STATE_OK);
+      iotc_evtd_execute_handle(&handle);
+
+      memset(&utest_layer_tracing_output, 0,
+             sizeof(utest_layer_tracing_output));
+      tt_int_op(IOTC_STATE_OK, ==,
+                iotc_layer_tracing_export(&utest_layer_tracing_writer,
+                                          &utest_layer_tracing_output));
+
+      const char* trace = utest_layer_tracing_output.buffer;
+      tt_int_op(0, ==, strncmp(trace, "{\"displayTimeUnit\":\"ms\",", 24));
+      tt_int_op(0, ==, strcmp(trace + utest_layer_tracing_output.length - 3,
+                              "]}\n"));
+
+      tt_ptr_op(NULL, !=, strstr(trace, "\"name\":\"mqtt codec layer\""));
+      tt_ptr_op(NULL, !=, strstr(trace, "\"name\":\"mqtt codec push\""));
+
+      tt_ptr_op(NULL, !=, strstr(trace, "\"ph\":\"s\",\"id\":1,"));
+      tt_ptr_op(NULL, !=,
+                strstr(trace, "\"ph\":\"f\",\"bp\":\"e\",\"id\":1,"));
+      tt_ptr_op(NULL, !=, strstr(trace, "\"ph\":\"B\""));
+
+      /* the end event carries the state returned by the layer function */
+      const char* end_event = strstr(trace, "\"ph\":\"E\"");
+      tt_ptr_op(NULL, !=, end_event);
+
+      char expected_state[32] = {0};
+      snprintf(expected_state, sizeof(expected_state), "\"state\":%d}",
+               IOTC_STATE_TIMEOUT);
+      tt_ptr_op(NULL, !=, strstr(end_event, expected_state));
+
+    end:;
+    })
+
+IOTC_TT_TESTCASE(
+    utest__iotc_layer_tracing_export__ring_overflowed__only_latest_records_exported,
+    {
+      iotc_layer_interface_t funcs;
+      memset(&funcs, 0, sizeof(funcs));
+      funcs.push = &utest_layer_tracing_push;
+
+      iotc_layer_t layer;
+      utest_layer_tracing_init_layer(&layer, &funcs, IOTC_LAYER_TYPE_IO);
+
+      const uint32_t transitions = IOTC_LAYER_TRACING_BUFFER_SIZE + 10;
+
+      iotc_layer_tracing_clear();
+
+      uint32_t i = 0;
+      for (; i < transitions; ++i) {
+        iotc_layer_tracing_make_handle(&utest_layer_tracing_push,
+                                       &layer.layer_connection,
+                                       &layer.layer_connection, NULL,
+                                       IOTC_STATE_OK);
+      }
+
+      tt_int_op(transitions, ==, iotc_layer_tracing_get_record_count());
+
+      memset(&utest_layer_tracing_output, 0,
+             sizeof(utest_layer_tracing_output));
+      iotc_layer_tracing_export(&utest_layer_tracing_writer,
+                                &utest_layer_tracing_output);
+
+      tt_int_op(IOTC_LAYER_TRACING_BUFFER_SIZE, ==,
+                utest_layer_tracing_output.flow_starts);
+
+    end:;
+    })
+
+IOTC_TT_TESTCASE(
+    utest__iotc_layer_tracing_export__null_writer__invalid_parameter, {
+      tt_int_op(IOTC_INVALID_PARAMETER, ==,
+                iotc_layer_tracing_export(NULL, NULL));
+    end:;
+    })
+
+IOTC_TT_TESTCASE(utest__iotc_layer_tracing_clear__records_dropped, {
+  iotc_layer_interface_t funcs;
+  memset(&funcs, 0, sizeof(funcs));
+  funcs.push = &utest_layer_tracing_push;
+
+  iotc_layer_t layer;
+  utest_layer_tracing_init_layer(&layer, &funcs, IOTC_LAYER_TYPE_IO);
+
+  iotc_layer_tracing_make_handle(&utest_layer_tracing_push,
+                                 &layer.layer_connection,
+                                 &layer.layer_connection, NULL, IOTC_STATE_OK);
+  iotc_layer_tracing_clear();
+
+  tt_int_op(0, ==, iotc_layer_tracing_get_record_count());
+
+  memset(&utest_layer_tracing_output, 0, sizeof(utest_layer_tracing_output));
+  iotc_layer_tracing_export(&utest_layer_tracing_writer,
+                            &utest_layer_tracing_output);
+
+  /* the header and the footer only */
+  tt_int_op(2, ==, utest_layer_tracing_output.chunks);
+
+end:;
+})
+
+IOTC_TT_TESTGROUP_END
+
+#ifndef IOTC_TT_TESTCASE_ENUMERATION__SECONDPREPROCESSORRUN
+#define IOTC_TT_TESTCASE_ENUMERATION__SECONDPREPROCESSORRUN
+#include __FILE__
+#undef IOTC_TT_TESTCASE_ENUMERATION__SECONDPREPROCESSORRUN
+#endif
@@ -0,0 +1,334 @@
+/* Copyright 2018-2020 Google LLC
+ *
+ * This is part of the Google Cloud IoT Device SDK for Embedded C.
+ * It is licensed under the BSD 3-Clause license; you may not use this file
+ * except in compliance with the License.
+ *
+ * You may obtain a copy of the License at:
+ *  https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "iotc_macros.h"
+#include "iotc_tt_testcase_management.h"
+#include "iotc_utest_basic_testcase_frame.h"
+#include "tinytest.h"
+#include "tinytest_macros.h"
+
+#include "iotc.h"
+#include "iotc_config.h"
+#include "iotc_event_dispatcher_api.h"
+#include "iotc_handle.h"
+#include "iotc_memory_accounting.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef IOTC_TT_TESTCASE_ENUMERATION__SECONDPREPROCESSORRUN
+
+#define IOTC_UTEST_ACCOUNTING_OWNER 1
+
+const size_t utest_memory_accounting_header_size =
+    sizeof(iotc_memory_accounting_header_t);
+
+static void* utest_memory_accounting_scheduled_ptr = NULL;
+
+iotc_state_t utest_memory_accounting_alloc_handle(void) {
+  utest_memory_accounting_scheduled_ptr = iotc_alloc(64);
+  return IOTC_STATE_OK;
+}
+
+#endif /* IOTC_TT_TESTCASE_ENUMERATION__SECONDPREPROCESSORRUN */
+
+IOTC_TT_TESTGROUP_BEGIN(utest_memory_accounting)
+
+IOTC_TT_TESTCASE(
+    utest__iotc_memory_accounting_owner_for_context__valid_and_invalid_handles__slot_returned,
+    {
+      tt_int_op(IOTC_MEMORY_ACCOUNTING_OWNER_NONE, ==,
+                iotc_memory_accounting_owner_for_context(
+                    IOTC_INVALID_CONTEXT_HANDLE));
+      tt_int_op(1, ==, iotc_memory_accounting_owner_for_context(0));
+      tt_int_op(IOTC_MEMORY_ACCOUNTING_MAX_CONTEXTS, ==,
+                iotc_memory_accounting_owner_for_context(
+                    IOTC_MEMORY_ACCOUNTING_MAX_CONTEXTS - 1));
+      tt_int_op(IOTC_MEMORY_ACCOUNTING_OWNER_NONE, ==,
+                iotc_memory_accounting_owner_for_context(
+                    IOTC_MEMORY_ACCOUNTING_MAX_CONTEXTS));
+    end:;
+    })
+
+IOTC_TT_TESTCASE(
+    utest__iotc_memory_accounting_alloc__owner_set__usage_accounted_to_owner,
+    {
+      iotc_memory_accounting_stats_t before;
+      iotc_memory_accounting_stats_t after;
+      const size_t allocation_size = 128;
+
+      iotc_memory_accounting_get_stats(IOTC_UTEST_ACCOUNTING_OWNER, &before);
+
+      const iotc_memory_accounting_owner_t prev_owner =
+          iotc_memory_accounting_set_owner(IOTC_UTEST_ACCOUNTING_OWNER);
+      void* ptr = iotc_alloc(allocation_size);
+      iotc_memory_accounting_set_owner(prev_owner);
+
+      tt_ptr_op(NULL, !=, ptr);
+
+      iotc_memory_accounting_get_stats(IOTC_UTEST_ACCOUNTING_OWNER, &after);
+      tt_int_op(after.current, ==,
+                before.current + allocation_size +
+                    utest_memory_accounting_header_size);
+      tt_int_op(after.peak, >=, after.current);
+      tt_int_op(after.allocations, ==, before.allocations + 1);
+
+      /* the owner is read from the header, not from the current scope */
+      iotc_free(ptr);
+
+      iotc_memory_accounting_get_stats(IOTC_UTEST_ACCOUNTING_OWNER, &after);
+      tt_int_op(after.current, ==, before.current);
+      tt_int_op(after.frees, ==, before.frees + 1);
+    end:;
+    })
+
+IOTC_TT_TESTCASE(
+    utest__iotc_memory_accounting_realloc__different_scope__block_stays_with_its_owner,
+    {
+      iotc_memory_accounting_stats_t before;
+      iotc_memory_accounting_stats_t after;
+
+      iotc_memory_accounting_get_stats(IOTC_UTEST_ACCOUNTING_OWNER, &before);
+
+      const iotc_memory_accounting_owner_t prev_owner =
+          iotc_memory_accounting_set_owner(IOTC_UTEST_ACCOUNTING_OWNER);
+      char* ptr = iotc_alloc(16);
+      iotc_memory_accounting_set_owner(prev_owner);
+
+      tt_ptr_op(NULL, !=, ptr);
+      memcpy(ptr, "accounting", 11);
+
+      ptr = iotc_realloc(ptr, 256);
+      tt_ptr_op(NULL, !=, ptr);
+      tt_str_op(ptr, ==, "accounting");
+
+      iotc_memory_accounting_get_stats(IOTC_UTEST_ACCOUNTING_OWNER, &after);
+      tt_int_op(after.current, ==,
+                before.current + 256 + utest_memory_accounting_header_size);
+
+      iotc_free(ptr);
+
+      iotc_memory_accounting_get_stats(IOTC_UTEST_ACCOUNTING_OWNER, &after);
+      tt_int_op(after.current, ==, before.current);
+    end:;
+    })
+
+IOTC_TT_TESTCASE(
+    utest__iotc_memory_accounting_set_budget__budget_exceeded__application_allocation_fails_system_allocation_succeeds,
+    {
+      void* ptr1 = NULL;
+      void* ptr2 = NULL;
+      void* ptr3 = NULL;
+      iotc_memory_accounting_stats_t stats;
+
+      const iotc_memory_accounting_owner_t prev_owner =
+          iotc_memory_accounting_set_owner(IOTC_UTEST_ACCOUNTING_OWNER);
+
+      tt_int_op(IOTC_STATE_OK, ==,
+                iotc_memory_accounting_set_budget(
+                    IOTC_UTEST_ACCOUNTING_OWNER,
+                    256 + utest_memory_accounting_header_size));
+
+      ptr1 = iotc_alloc(256);
+      tt_ptr_op(NULL, !=, ptr1);
+
+      ptr2 = iotc_alloc(1);
+      tt_ptr_op(NULL, ==, ptr2);
+
+      ptr3 = iotc_alloc_system(128);
+      tt_ptr_op(NULL, !=, ptr3);
+
+      iotc_memory_accounting_get_stats(IOTC_UTEST_ACCOUNTING_OWNER, &stats);
+      tt_int_op(stats.failures, >=, 1);
+
+      /* other owners are not affected by the budget */
+      iotc_memory_accounting_set_owner(IOTC_MEMORY_ACCOUNTING_OWNER_NONE);
+      ptr2 = iotc_alloc(1);
+      tt_ptr_op(NULL, !=, ptr2);
+
+    end:
+      iotc_memory_accounting_set_owner(prev_owner);
+      iotc_memory_accounting_set_budget(IOTC_UTEST_ACCOUNTING_OWNER, 0);
+      iotc_free(ptr1);
+      iotc_free(ptr2);
+      iotc_free(ptr3);
+    })
+
+IOTC_TT_TESTCASE(
+    utest__iotc_set_maximum_heap_usage__accounting_enabled__limit_enforced,
+    {
+      void* ptr = NULL;
+      size_t heap_usage = 0;
+
+      tt_int_op(IOTC_STATE_OK, ==, iotc_get_heap_usage(&heap_usage));
+      /* the limit has to leave room for the system allocations */
+      tt_int_op(IOTC_OUT_OF_MEMORY, ==,
+                iotc_set_maximum_heap_usage(heap_usage + 1));
+
+      tt_int_op(IOTC_STATE_OK, ==,
+                iotc_set_maximum_heap_usage(
+                    heap_usage + IOTC_MEMORY_ACCOUNTING_SYSTEM_MEMORY_RESERVE +
+                    1024));
+
+      ptr = iotc_alloc(2048);
+      tt_ptr_op(NULL, ==, ptr);
+
+      ptr = iotc_alloc(512);
+      tt_ptr_op(NULL, !=, ptr);
+
+      tt_int_op(IOTC_STATE_OK, ==, iotc_get_heap_usage(&heap_usage));
+
+    end:
+      iotc_free(ptr);
+      iotc_set_maximum_heap_usage(0);
+    })
+
+IOTC_TT_TESTCASE(
+    utest__iotc_evtd_execute__handle_scheduled_by_owner__handle_allocations_accounted_to_owner,
+    {
+      iotc_memory_accounting_stats_t before;
+      iotc_memory_accounting_stats_t after;
+
+      iotc_evtd_instance_t* evtd = iotc_evtd_create_instance();
+      tt_ptr_op(NULL, !=, evtd);
+
+      const iotc_memory_accounting_owner_t prev_owner =
+          iotc_memory_accounting_set_owner(IOTC_UTEST_ACCOUNTING_OWNER);
+      iotc_evtd_execute(evtd,
+                        iotc_make_handle(&utest_memory_accounting_alloc_handle));
+      iotc_memory_accounting_set_owner(prev_owner);
+
+      iotc_memory_accounting_get_stats(IOTC_UTEST_ACCOUNTING_OWNER, &before);
+
+      /* the dispatcher runs outside of the owner's scope */
+      iotc_evtd_step(evtd, 0);
+
+      tt_int_op(iotc_memory_accounting_get_owner(), ==, prev_owner);
+      tt_ptr_op(NULL, !=, utest_memory_accounting_scheduled_ptr);
+
+      iotc_memory_accounting_get_stats(IOTC_UTEST_ACCOUNTING_OWNER, &after);
+      tt_int_op(after.allocations, ==, before.allocations + 1);
+
+    end:
+      IOTC_SAFE_FREE(utest_memory_accounting_scheduled_ptr);
+      iotc_evtd_destroy_instance(evtd);
+    })
+
+IOTC_TT_TESTCASE_WITH_SETUP(
+    utest__iotc_create_context__slot_of_deleted_context_reused__usage_and_limit_start_fresh,
+    iotc_utest_setup_basic, iotc_utest_teardown_basic, NULL, {
+      void* ptr = NULL;
+      size_t heap_usage = 0;
+      iotc_memory_accounting_stats_t stats;
+
+      /* keeps the handle table, and the generations of its slots, alive */
+      iotc_context_handle_t other_context = iotc_create_context();
+      tt_int_op(0, <=, other_context);
+
+      iotc_context_handle_t old_context = iotc_create_context();
+      tt_int_op(0, <=, old_context);
+
+      const iotc_memory_accounting_owner_t owner =
+          iotc_memory_accounting_owner_for_context(old_context);
+      tt_int_op(IOTC_MEMORY_ACCOUNTING_OWNER_NONE, !=, owner);
+
+      tt_int_op(IOTC_STATE_OK, ==,
+                iotc_set_context_maximum_heap_usage(old_context, 1024));
+
+      const iotc_memory_accounting_owner_t prev_owner =
+          iotc_memory_accounting_set_owner(owner);
+      ptr = iotc_alloc(512);
+      iotc_memory_accounting_set_owner(prev_owner);
+      tt_ptr_op(NULL, !=, ptr);
+      IOTC_SAFE_FREE(ptr);
+
+      iotc_delete_context(old_context);
+
+      /* the handle of the deleted context is rejected */
+      tt_int_op(IOTC_INVALID_PARAMETER, ==,
+                iotc_set_context_maximum_heap_usage(old_context, 1024));
+      tt_int_op(IOTC_INVALID_PARAMETER, ==,
+                iotc_get_context_heap_usage(old_context, &heap_usage));
+
+      iotc_context_handle_t new_context = iotc_create_context();
+      tt_int_op(0, <=, new_context);
+      tt_int_op(old_context, !=, new_context);
+      tt_int_op(IOTC_HANDLE_INDEX(old_context), ==,
+                IOTC_HANDLE_INDEX(new_context));
+
+      tt_int_op(IOTC_STATE_OK, ==,
+                iotc_get_context_heap_usage(new_context, &heap_usage));
+      tt_int_op(0, ==, heap_usage);
+
+      tt_int_op(IOTC_STATE_OK, ==,
+                iotc_memory_accounting_get_stats(owner, &stats));
+      tt_int_op(0, ==, stats.budget);
+      tt_int_op(0, ==, stats.peak);
+      tt_int_op(0, ==, stats.allocations);
+      tt_int_op(0, ==, stats.frees);
+
+      /* the budget of the deleted context would refuse this */
+      iotc_memory_accounting_set_owner(owner);
+      ptr = iotc_alloc(2048);
+      iotc_memory_accounting_set_owner(prev_owner);
+      tt_ptr_op(NULL, !=, ptr);
+
+      iotc_delete_context(new_context);
+      iotc_delete_context(other_context);
+    end:
+      IOTC_SAFE_FREE(ptr);
+    })
+
+IOTC_TT_TESTCASE_WITH_SETUP(
+    utest__iotc_set_context_maximum_heap_usage__every_context_of_the_table__own_slot_and_budget,
+    iotc_utest_setup_basic, iotc_utest_teardown_basic, NULL, {
+      iotc_context_handle_t contexts[IOTC_MAX_NUM_CONTEXTS];
+      int created = 0;
+
+      /* the slot count follows IOTC_MAX_NUM_CONTEXTS, even the last context
+       * is not accounted as unowned */
+      for (; created < IOTC_MAX_NUM_CONTEXTS; ++created) {
+        contexts[created] = iotc_create_context();
+        tt_assert(0 <= contexts[created]);
+
+        const iotc_memory_accounting_owner_t owner =
+            iotc_memory_accounting_owner_for_context(contexts[created]);
+        tt_int_op(IOTC_HANDLE_INDEX(contexts[created]) + 1, ==, owner);
+
+        tt_int_op(IOTC_STATE_OK, ==,
+                  iotc_set_context_maximum_heap_usage(contexts[created], 1024));
+      }
+
+      /* a context past the limit isn't created at all */
+      tt_int_op(-IOTC_NO_MORE_RESOURCE_AVAILABLE, ==, iotc_create_context());
+
+    end:
+      while (0 < created) {
+        created -= 1;
+        if (0 <= contexts[created]) {
+          iotc_delete_context(contexts[created]);
+        }
+      }
+    })
+
+IOTC_TT_TESTGROUP_END
+
+#ifndef IOTC_TT_TESTCASE_ENUMERATION__SECONDPREPROCESSORRUN
+#define IOTC_TT_TESTCASE_ENUMERATION__SECONDPREPROCESSORRUN
+#include __FILE__
+#undef IOTC_TT_TESTCASE_ENUMERATION__SECONDPREPROCESSORRUN
+#endif
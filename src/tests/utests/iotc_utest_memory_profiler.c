@@ -0,0 +1,189 @@
+/* Copyright 2018-2020 Google LLC
+ *
+ * This is part of the Google Cloud IoT Device SDK for Embedded C.
+ * It is licensed under the BSD 3-Clause license; you may not use this file
+ * except in compliance with the License.
+ *
+ * You may obtain a copy of the License at:
+ *  https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "iotc_tt_testcase_management.h"
+#include "tinytest.h"
+#include "tinytest_macros.h"
+
+#include "iotc.h"
+#include "iotc_allocator.h"
+#include "iotc_memory_limiter.h"
+
+#ifndef IOTC_TT_TESTCASE_ENUMERATION__SECONDPREPROCESSORRUN
+
+typedef struct utest_memory_profiler_output_s {
+  char buffer[65536];
+  size_t length;
+} utest_memory_profiler_output_t;
+
+static utest_memory_profiler_output_t utest_memory_profiler_output;
+
+static size_t utest_memory_profiler_alloc_line;
+static size_t utest_memory_profiler_realloc_line;
+
+static void utest_memory_profiler_writer(const char* text, size_t length,
+                                         void* user_data) {
+  utest_memory_profiler_output_t* output =
+      (utest_memory_profiler_output_t*)user_data;
+
+  if (output->length + length < sizeof(output->buffer)) {
+    memcpy(output->buffer + output->length, text, length);
+    output->length += length;
+    output->buffer[output->length] = '\0';
+  }
+}
+
+/* Every allocation of the tests comes from one of these two sites. */
+static void* utest_memory_profiler_alloc(size_t size) {
+  utest_memory_profiler_alloc_line = __LINE__ + 1;
+  return iotc_alloc(size);
+}
+
+static void* utest_memory_profiler_realloc(void* ptr, size_t size) {
+  utest_memory_profiler_realloc_line = __LINE__ + 1;
+  return iotc_realloc(ptr, size);
+}
+
+static const char* utest_memory_profiler_dump(
+    iotc_heap_profile_format_t format) {
+  memset(&utest_memory_profiler_output, 0,
+         sizeof(utest_memory_profiler_output));
+  iotc_memory_limiter_dump_profile(format, &utest_memory_profiler_writer,
+                                   &utest_memory_profiler_output);
+  return utest_memory_profiler_output.buffer;
+}
+
+static int utest_memory_profiler_has_line(const char* csv, size_t line,
+                                          const char* counters) {
+  char expected[512] = {0};
+  snprintf(expected, sizeof(expected), "\n%s,%lu,%s\n", __FILE__,
+           (unsigned long)line, counters);
+  return NULL != strstr(csv, expected);
+}
+
+#endif /* IOTC_TT_TESTCASE_ENUMERATION__SECONDPREPROCESSORRUN */
+
+IOTC_TT_TESTGROUP_BEGIN(utest_memory_profiler)
+
+IOTC_TT_TESTCASE(
+    utest__iotc_memory_limiter_dump_profile__allocs_and_frees__counted_per_site,
+    {
+      iotc_memory_limiter_reset_profile();
+
+      void* small = utest_memory_profiler_alloc(10);
+      void* medium = utest_memory_profiler_alloc(100);
+      void* large = utest_memory_profiler_alloc(3000);
+      iotc_free(medium);
+
+      const char* csv =
+          utest_memory_profiler_dump(IOTC_HEAP_PROFILE_FORMAT_CSV);
+
+      tt_ptr_op(NULL, !=, strstr(csv, "file,line,allocs,frees,live_allocs,"));
+      tt_want_int_op(1, ==,
+                     utest_memory_profiler_has_line(
+                         csv, utest_memory_profiler_alloc_line,
+                         "3,1,2,3010,3110,3110,1,0,0,1,0,0,0,0,1"));
+
+      iotc_free(small);
+      iotc_free(large);
+    end:;
+    })
+
+IOTC_TT_TESTCASE(
+    utest__iotc_memory_limiter_dump_profile__realloc__moves_the_block_to_the_realloc_site,
+    {
+      iotc_memory_limiter_reset_profile();
+
+      void* ptr = utest_memory_profiler_alloc(10);
+      ptr = utest_memory_profiler_realloc(ptr, 200);
+      tt_ptr_op(NULL, !=, ptr);
+
+      const char* csv =
+          utest_memory_profiler_dump(IOTC_HEAP_PROFILE_FORMAT_CSV);
+
+      tt_want_int_op(1, ==,
+                     utest_memory_profiler_has_line(
+                         csv, utest_memory_profiler_alloc_line,
+                         "1,1,0,0,10,10,1,0,0,0,0,0,0,0,0"));
+      tt_want_int_op(1, ==,
+                     utest_memory_profiler_has_line(
+                         csv, utest_memory_profiler_realloc_line,
+                         "1,0,1,200,200,200,0,0,0,0,1,0,0,0,0"));
+
+    end:
+      iotc_free(ptr);
+    })
+
+IOTC_TT_TESTCASE(
+    utest__iotc_memory_limiter_reset_profile__live_allocations__carried_over, {
+      void* ptr = utest_memory_profiler_alloc(40);
+      void* freed = utest_memory_profiler_alloc(40);
+      tt_ptr_op(NULL, !=, freed);
+      iotc_free(freed);
+
+      iotc_memory_limiter_reset_profile();
+
+      const char* csv =
+          utest_memory_profiler_dump(IOTC_HEAP_PROFILE_FORMAT_CSV);
+
+      /* the histogram only covers the allocations of the window */
+      tt_want_int_op(1, ==,
+                     utest_memory_profiler_has_line(
+                         csv, utest_memory_profiler_alloc_line,
+                         "1,0,1,40,40,40,0,0,0,0,0,0,0,0,0"));
+
+      iotc_free(ptr);
+    end:;
+    })
+
+IOTC_TT_TESTCASE(
+    utest__iotc_memory_limiter_dump_profile__pprof__legacy_heap_profile, {
+      iotc_memory_limiter_reset_profile();
+
+      void* ptr = utest_memory_profiler_alloc(64);
+
+      const char* profile =
+          utest_memory_profiler_dump(IOTC_HEAP_PROFILE_FORMAT_PPROF);
+
+      tt_int_op(0, ==, strncmp(profile, "heap profile: ", 14));
+      tt_ptr_op(NULL, !=, strstr(profile, "] @ heapprofile\n"));
+      tt_ptr_op(NULL, !=, strstr(profile, "\n1: 64 [1: 64] @ 0x"));
+      tt_ptr_op(NULL, !=, strstr(profile, "\nMAPPED_LIBRARIES:\n"));
+
+      iotc_free(ptr);
+    end:;
+    })
+
+IOTC_TT_TESTCASE(utest__iotc_dump_heap_profile__invalid_arguments__rejected, {
+  tt_int_op(IOTC_INVALID_PARAMETER, ==,
+            iotc_dump_heap_profile(IOTC_HEAP_PROFILE_FORMAT_CSV, NULL, NULL));
+  tt_int_op(IOTC_INVALID_PARAMETER, ==,
+            iotc_dump_heap_profile((iotc_heap_profile_format_t)42,
+                                   &utest_memory_profiler_writer,
+                                   &utest_memory_profiler_output));
+end:;
+})
+
+IOTC_TT_TESTGROUP_END
+
+#ifndef IOTC_TT_TESTCASE_ENUMERATION__SECONDPREPROCESSORRUN
+#define IOTC_TT_TESTCASE_ENUMERATION__SECONDPREPROCESSORRUN
+#include __FILE__
+#undef IOTC_TT_TESTCASE_ENUMERATION__SECONDPREPROCESSORRUN
+#endif
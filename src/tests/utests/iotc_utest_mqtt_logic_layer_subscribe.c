@@ -27,6 +27,7 @@
 #include "iotc_mqtt_logic_layer_data.h"
 #include "iotc_mqtt_logic_layer_subscribe_command.h"
 #include "iotc_mqtt_message.h"
+#include "iotc_queue.h"
 #include "iotc_user_sub_call_wrapper.h"
 
 #include <iotc_error.h>
@@ -169,7 +170,7 @@ IOTC_TT_TESTCASE_WITH_SETUP(
 
       // take the pointer to context
       iotc_context_t* iotc_context = iotc_object_for_handle(
-          iotc_globals.context_handles_vector, iotc_context_handle);
+          iotc_globals.context_handles, iotc_context_handle);
       tt_assert(NULL != iotc_context);
 
       // set the task data
@@ -209,7 +210,8 @@ IOTC_TT_TESTCASE_WITH_SETUP(
       iotc_mqtt_logic_layer_data_t logic_layer_data;
       memset(&logic_layer_data, 0, sizeof(iotc_mqtt_logic_layer_data_t));
 
-      logic_layer_data.q12_tasks_queue = task;
+      IOTC_QUEUE_PUSH_BACK(iotc_mqtt_logic_task_t,
+                           logic_layer_data.q12_tasks_queue, task);
 
       logic_layer_data.handlers_for_topics = iotc_vector_create();
 
@@ -265,7 +267,7 @@ IOTC_TT_TESTCASE_WITH_SETUP(
 
       // take the pointer to context
       iotc_context_t* iotc_context = iotc_object_for_handle(
-          iotc_globals.context_handles_vector, iotc_context_handle);
+          iotc_globals.context_handles, iotc_context_handle);
       tt_assert(NULL != iotc_context);
 
       // set the task data
@@ -304,7 +306,8 @@ IOTC_TT_TESTCASE_WITH_SETUP(
       iotc_mqtt_logic_layer_data_t logic_layer_data;
       memset(&logic_layer_data, 0, sizeof(iotc_mqtt_logic_layer_data_t));
 
-      logic_layer_data.q12_tasks_queue = task;
+      IOTC_QUEUE_PUSH_BACK(iotc_mqtt_logic_task_t,
+                           logic_layer_data.q12_tasks_queue, task);
 
       logic_layer_data.handlers_for_topics = iotc_vector_create();
 
@@ -0,0 +1,300 @@
+/* Copyright 2018-2020 Google LLC
+ *
+ * This is part of the Google Cloud IoT Device SDK for Embedded C.
+ * It is licensed under the BSD 3-Clause license; you may not use this file
+ * except in compliance with the License.
+ *
+ * You may obtain a copy of the License at:
+ *  https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "iotc_memory_checks.h"
+#include "iotc_tt_testcase_management.h"
+#include "tinytest.h"
+#include "tinytest_macros.h"
+
+#include "iotc_event_dispatcher_api.h"
+#include "iotc_fs_api.h"
+#include "iotc_internals.h"
+#include "iotc_offline_queue.h"
+
+#include <string.h>
+
+#ifndef IOTC_TT_TESTCASE_ENUMERATION__SECONDPREPROCESSORRUN
+
+#define IOTC_UTEST_OFFLINE_QUEUE_RESOURCE "utest_offline_queue.bin"
+
+static iotc_state_t utest_offline_queue_dropped_state = IOTC_STATE_OK;
+static size_t utest_offline_queue_dropped_no = 0;
+
+/* stands for the wrapper of the user's publish callback */
+iotc_state_t utest_offline_queue_callback(void* context, void* data,
+                                          iotc_state_t state) {
+  IOTC_UNUSED(context);
+  IOTC_UNUSED(data);
+
+  utest_offline_queue_dropped_state = state;
+  utest_offline_queue_dropped_no += 1;
+
+  return IOTC_STATE_OK;
+}
+
+iotc_state_t utest_offline_queue_push(iotc_offline_queue_t* queue,
+                                      const char* topic, const char* payload,
+                                      iotc_evtd_instance_t* evtd) {
+  return iotc_offline_queue_push(
+      queue, topic, iotc_make_desc_from_string_copy(payload),
+      IOTC_MQTT_QOS_AT_LEAST_ONCE,
+      iotc_make_handle(&utest_offline_queue_callback, NULL, NULL,
+                       IOTC_STATE_OK),
+      evtd);
+}
+
+/* writes the bytes as the whole persistence resource */
+iotc_state_t utest_offline_queue_write_resource(const uint8_t* bytes,
+                                                size_t length) {
+  const iotc_fs_functions_t* fs = &iotc_internals.fs_functions;
+  iotc_fs_resource_handle_t resource_handle = iotc_fs_init_resource_handle();
+  size_t bytes_written = 0;
+
+  iotc_state_t state = fs->open_resource(
+      NULL, IOTC_FS_CONFIG_DATA, IOTC_UTEST_OFFLINE_QUEUE_RESOURCE,
+      IOTC_FS_OPEN_WRITE, &resource_handle);
+
+  if (IOTC_STATE_OK == state) {
+    state = fs->write_resource(NULL, resource_handle, bytes, length, 0,
+                               &bytes_written);
+    fs->close_resource(NULL, resource_handle);
+  }
+
+  return (IOTC_STATE_OK == state && length != bytes_written)
+             ? IOTC_FS_WRITE_ERROR
+             : state;
+}
+
+#endif
+
+IOTC_TT_TESTGROUP_BEGIN(utest_offline_queue)
+
+#ifdef IOTC_MODULE_THREAD_ENABLED
+#include "iotc_utest_platform_offline_queue.h"
+#endif
+
+IOTC_TT_TESTCASE(
+    utest__iotc_offline_queue_push__drop_oldest_budget_exceeded__oldest_dropped_with_overflow,
+    {
+      iotc_offline_queue_t queue;
+      memset(&queue, 0, sizeof(queue));
+
+      iotc_evtd_instance_t* evtd = iotc_evtd_create_instance();
+      tt_ptr_op(NULL, !=, evtd);
+
+      const iotc_offline_queue_config_t config = {
+          2, 0, IOTC_OFFLINE_QUEUE_DROP_OLDEST, NULL};
+      tt_int_op(IOTC_STATE_OK, ==,
+                iotc_offline_queue_configure(&queue, &config, evtd));
+
+      utest_offline_queue_dropped_no = 0;
+
+      tt_int_op(IOTC_STATE_OK, ==,
+                utest_offline_queue_push(&queue, "a", "1", evtd));
+      tt_int_op(IOTC_STATE_OK, ==,
+                utest_offline_queue_push(&queue, "b", "22", evtd));
+      tt_int_op(IOTC_STATE_OK, ==,
+                utest_offline_queue_push(&queue, "c", "333", evtd));
+
+      tt_int_op(2, ==, queue.count);
+      tt_int_op(strlen("b22c333"), ==, queue.bytes);
+
+      iotc_evtd_step(evtd, 1);
+
+      tt_int_op(1, ==, utest_offline_queue_dropped_no);
+      tt_int_op(IOTC_BUFFER_OVERFLOW, ==, utest_offline_queue_dropped_state);
+
+      iotc_offline_message_t* message = iotc_offline_queue_pop(&queue);
+      tt_ptr_op(NULL, !=, message);
+      tt_str_op("b", ==, message->topic);
+      iotc_offline_queue_free_message(&message);
+
+      message = iotc_offline_queue_pop(&queue);
+      tt_ptr_op(NULL, !=, message);
+      tt_str_op("c", ==, message->topic);
+      iotc_offline_queue_free_message(&message);
+
+      tt_int_op(1, ==, iotc_offline_queue_is_empty(&queue));
+      tt_int_op(0, ==, queue.bytes);
+
+    end:
+      iotc_offline_queue_destroy(&queue);
+      iotc_evtd_destroy_instance(evtd);
+      tt_int_op(iotc_is_whole_memory_deallocated(), >, 0);
+    })
+
+IOTC_TT_TESTCASE(
+    utest__iotc_offline_queue_push__drop_newest_byte_budget_exceeded__new_message_rejected,
+    {
+      iotc_offline_queue_t queue;
+      memset(&queue, 0, sizeof(queue));
+
+      iotc_evtd_instance_t* evtd = iotc_evtd_create_instance();
+      tt_ptr_op(NULL, !=, evtd);
+
+      const iotc_offline_queue_config_t config = {
+          10, 8, IOTC_OFFLINE_QUEUE_DROP_NEWEST, NULL};
+      tt_int_op(IOTC_STATE_OK, ==,
+                iotc_offline_queue_configure(&queue, &config, evtd));
+
+      utest_offline_queue_dropped_no = 0;
+
+      tt_int_op(IOTC_STATE_OK, ==,
+                utest_offline_queue_push(&queue, "a", "123", evtd));
+      tt_int_op(IOTC_BUFFER_OVERFLOW, ==,
+                utest_offline_queue_push(&queue, "b", "4567", evtd));
+
+      /* never fits, not even in an empty queue */
+      tt_int_op(IOTC_BUFFER_OVERFLOW, ==,
+                utest_offline_queue_push(&queue, "c", "123456789", evtd));
+
+      iotc_evtd_step(evtd, 1);
+
+      tt_int_op(1, ==, queue.count);
+      tt_int_op(4, ==, queue.bytes);
+      tt_str_op("a", ==, queue.messages.head->topic);
+
+      /* the caller learns about a rejection from the return value */
+      tt_int_op(0, ==, utest_offline_queue_dropped_no);
+
+    end:
+      iotc_offline_queue_destroy(&queue);
+      iotc_evtd_destroy_instance(evtd);
+      tt_int_op(iotc_is_whole_memory_deallocated(), >, 0);
+    })
+
+IOTC_TT_TESTCASE(
+    utest__iotc_offline_queue_configure__budget_disabled__push_rejected, {
+      iotc_offline_queue_t queue;
+      memset(&queue, 0, sizeof(queue));
+
+      tt_int_op(0, ==, iotc_offline_queue_is_enabled(&queue));
+      tt_int_op(IOTC_BUFFER_OVERFLOW, ==,
+                utest_offline_queue_push(&queue, "a", "1", NULL));
+      tt_int_op(1, ==, iotc_offline_queue_is_empty(&queue));
+
+    end:
+      iotc_offline_queue_destroy(&queue);
+      tt_int_op(iotc_is_whole_memory_deallocated(), >, 0);
+    })
+
+#ifdef IOTC_FS_POSIX
+IOTC_TT_TESTCASE(
+    utest__iotc_offline_queue_save__persistence_resource_set__restored_in_order_and_removed,
+    {
+      iotc_offline_queue_t queue;
+      memset(&queue, 0, sizeof(queue));
+
+      const iotc_offline_queue_config_t config = {
+          10, 0, IOTC_OFFLINE_QUEUE_DROP_OLDEST,
+          IOTC_UTEST_OFFLINE_QUEUE_RESOURCE};
+
+      tt_int_op(IOTC_STATE_OK, ==,
+                iotc_offline_queue_configure(&queue, &config, NULL));
+
+      tt_int_op(IOTC_STATE_OK, ==,
+                utest_offline_queue_push(&queue, "first/topic", "payload",
+                                         NULL));
+      tt_int_op(IOTC_STATE_OK, ==,
+                utest_offline_queue_push(&queue, "second/topic", "2", NULL));
+
+      tt_int_op(IOTC_STATE_OK, ==, iotc_offline_queue_save(&queue));
+      iotc_offline_queue_destroy(&queue);
+
+      tt_int_op(IOTC_STATE_OK, ==,
+                iotc_offline_queue_configure(&queue, &config, NULL));
+
+      tt_int_op(2, ==, queue.count);
+
+      iotc_offline_message_t* message = iotc_offline_queue_pop(&queue);
+      tt_ptr_op(NULL, !=, message);
+      tt_str_op("first/topic", ==, message->topic);
+      tt_int_op(strlen("payload"), ==, message->data->length);
+      tt_int_op(0, ==, memcmp("payload", message->data->data_ptr,
+                              message->data->length));
+      tt_int_op(IOTC_MQTT_QOS_AT_LEAST_ONCE, ==, message->qos);
+      /* the callback didn't survive the save */
+      tt_int_op(1, ==, iotc_handle_disposed(&message->callback));
+      iotc_offline_queue_free_message(&message);
+
+      message = iotc_offline_queue_pop(&queue);
+      tt_ptr_op(NULL, !=, message);
+      tt_str_op("second/topic", ==, message->topic);
+      tt_int_op(1, ==, message->data->length);
+      iotc_offline_queue_free_message(&message);
+
+      /* restored once only */
+      iotc_fs_stat_t resource_stat;
+      tt_int_op(IOTC_FS_RESOURCE_NOT_AVAILABLE, ==,
+                iotc_internals.fs_functions.stat_resource(
+                    NULL, IOTC_FS_CONFIG_DATA,
+                    IOTC_UTEST_OFFLINE_QUEUE_RESOURCE, &resource_stat));
+
+    end:
+      iotc_offline_queue_destroy(&queue);
+      iotc_internals.fs_functions.remove_resource(
+          NULL, IOTC_FS_CONFIG_DATA, IOTC_UTEST_OFFLINE_QUEUE_RESOURCE);
+      tt_int_op(iotc_is_whole_memory_deallocated(), >, 0);
+    })
+
+IOTC_TT_TESTCASE(
+    utest__iotc_offline_queue_configure__truncated_persistence_resource__kept_and_nothing_queued,
+    {
+      iotc_offline_queue_t queue;
+      memset(&queue, 0, sizeof(queue));
+
+      /* a whole record of topic "t" and payload "1", then a cut header */
+      const uint8_t truncated[] = {'I', 'O', 'Q', '1',          /* magic */
+                                   1,   0,   1,   0,   0, 0, 1, /* header */
+                                   't', '1',                    /* record */
+                                   1,   0,   1};
+      tt_int_op(IOTC_STATE_OK, ==,
+                utest_offline_queue_write_resource(truncated,
+                                                   sizeof(truncated)));
+
+      const iotc_offline_queue_config_t config = {
+          10, 0, IOTC_OFFLINE_QUEUE_DROP_OLDEST,
+          IOTC_UTEST_OFFLINE_QUEUE_RESOURCE};
+
+      tt_int_op(IOTC_SERIALIZATION_ERROR, ==,
+                iotc_offline_queue_configure(&queue, &config, NULL));
+
+      /* not even the whole record is queued, the queue works anyway */
+      tt_int_op(0, ==, queue.count);
+      tt_int_op(1, ==, iotc_offline_queue_is_enabled(&queue));
+
+      iotc_fs_stat_t resource_stat;
+      tt_int_op(IOTC_STATE_OK, ==,
+                iotc_internals.fs_functions.stat_resource(
+                    NULL, IOTC_FS_CONFIG_DATA,
+                    IOTC_UTEST_OFFLINE_QUEUE_RESOURCE, &resource_stat));
+      tt_int_op(sizeof(truncated), ==, resource_stat.resource_size);
+
+    end:
+      iotc_offline_queue_destroy(&queue);
+      iotc_internals.fs_functions.remove_resource(
+          NULL, IOTC_FS_CONFIG_DATA, IOTC_UTEST_OFFLINE_QUEUE_RESOURCE);
+      tt_int_op(iotc_is_whole_memory_deallocated(), >, 0);
+    })
+#endif
+
+IOTC_TT_TESTGROUP_END
+
+#ifndef IOTC_TT_TESTCASE_ENUMERATION__SECONDPREPROCESSORRUN
+#define IOTC_TT_TESTCASE_ENUMERATION__SECONDPREPROCESSORRUN
+#include __FILE__
+#undef IOTC_TT_TESTCASE_ENUMERATION__SECONDPREPROCESSORRUN
+#endif
@@ -0,0 +1,254 @@
+/* Copyright 2018-2020 Google LLC
+ *
+ * This is part of the Google Cloud IoT Device SDK for Embedded C.
+ * It is licensed under the BSD 3-Clause license; you may not use this file
+ * except in compliance with the License.
+ *
+ * You may obtain a copy of the License at:
+ *  https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "iotc_utest_basic_testcase_frame.h"
+#include "tinytest.h"
+#include "tinytest_macros.h"
+
+#include "iotc_list.h"
+#include "iotc_macros.h"
+#include "iotc_queue.h"
+#include "iotc_tt_testcase_management.h"
+
+#ifdef IOTC_PLATFORM_BASE_POSIX
+#include <time.h>
+#endif
+
+#ifndef IOTC_TT_TESTCASE_ENUMERATION__SECONDPREPROCESSORRUN
+
+/**
+ * @brief structure used for testing purposes
+ */
+typedef struct iotc_utest_queue_elem_s {
+  int value;
+  struct iotc_utest_queue_elem_s* __next;
+  struct iotc_utest_queue_elem_s* __prev;
+} iotc_utest_queue_elem_t;
+
+typedef struct {
+  iotc_utest_queue_elem_t* head;
+  iotc_utest_queue_elem_t* tail;
+} iotc_utest_queue_t;
+
+static void iotc_utest_queue_fill(iotc_utest_queue_t* queue,
+                                  iotc_utest_queue_elem_t* elems,
+                                  size_t elem_no) {
+  size_t i = 0;
+  for (; i < elem_no; ++i) {
+    elems[i].value = (int)i;
+    IOTC_QUEUE_PUSH_BACK(iotc_utest_queue_elem_t, *queue, &elems[i]);
+  }
+}
+
+/* returns the number of elements if the links are consistent in both
+ * directions, -1 otherwise */
+static int iotc_utest_queue_verify_links(const iotc_utest_queue_t* queue) {
+  const iotc_utest_queue_elem_t* prev = NULL;
+  const iotc_utest_queue_elem_t* curr = queue->head;
+  int count = 0;
+
+  while (NULL != curr) {
+    if (curr->__prev != prev) {
+      return -1;
+    }
+
+    prev = curr;
+    curr = curr->__next;
+    ++count;
+  }
+
+  return (queue->tail == prev) ? count : -1;
+}
+
+static int iotc_utest_queue_number_odd_predicate(void* arg,
+                                                 iotc_utest_queue_elem_t* elem,
+                                                 int pos) {
+  IOTC_UNUSED(arg);
+  IOTC_UNUSED(pos);
+
+  return (elem->value % 2) != 0;
+}
+
+#define IOTC_UTEST_QUEUE_HAS_VALUE(elem, val) ((elem)->value == (val))
+
+#endif
+
+IOTC_TT_TESTGROUP_BEGIN(utest_queue)
+
+IOTC_TT_TESTCASE(utest__iotc_queue_push_back_pop_front__fifo_order_kept, {
+  iotc_utest_queue_elem_t elems[5];
+  iotc_utest_queue_elem_t* out = NULL;
+  iotc_utest_queue_t queue;
+  int i = 0;
+
+  IOTC_QUEUE_INIT(queue);
+  tt_int_op(IOTC_QUEUE_EMPTY(queue), ==, 1);
+
+  iotc_utest_queue_fill(&queue, elems, 5);
+  tt_int_op(iotc_utest_queue_verify_links(&queue), ==, 5);
+
+  for (; i < 5; ++i) {
+    IOTC_QUEUE_POP_FRONT(iotc_utest_queue_elem_t, queue, out);
+    tt_ptr_op(out, ==, &elems[i]);
+    tt_ptr_op(out->__next, ==, NULL);
+    tt_ptr_op(out->__prev, ==, NULL);
+    tt_int_op(iotc_utest_queue_verify_links(&queue), ==, 4 - i);
+  }
+
+  IOTC_QUEUE_POP_FRONT(iotc_utest_queue_elem_t, queue, out);
+  tt_ptr_op(out, ==, NULL);
+  tt_ptr_op(queue.tail, ==, NULL);
+
+end:;
+})
+
+IOTC_TT_TESTCASE(utest__iotc_queue_push_front__element_becomes_head, {
+  iotc_utest_queue_elem_t elems[3];
+  iotc_utest_queue_elem_t priority;
+  iotc_utest_queue_t queue;
+
+  IOTC_QUEUE_INIT(queue);
+
+  IOTC_QUEUE_PUSH_FRONT(iotc_utest_queue_elem_t, queue, &priority);
+  tt_ptr_op(queue.head, ==, &priority);
+  tt_ptr_op(queue.tail, ==, &priority);
+
+  iotc_utest_queue_fill(&queue, elems, 3);
+  IOTC_QUEUE_UNLINK(iotc_utest_queue_elem_t, queue, &priority);
+  IOTC_QUEUE_PUSH_FRONT(iotc_utest_queue_elem_t, queue, &priority);
+
+  tt_ptr_op(queue.head, ==, &priority);
+  tt_ptr_op(queue.tail, ==, &elems[2]);
+  tt_int_op(iotc_utest_queue_verify_links(&queue), ==, 4);
+
+end:;
+})
+
+IOTC_TT_TESTCASE(utest__iotc_queue_unlink__head_middle_tail__links_updated, {
+  iotc_utest_queue_elem_t elems[5];
+  iotc_utest_queue_t queue;
+
+  IOTC_QUEUE_INIT(queue);
+  iotc_utest_queue_fill(&queue, elems, 5);
+
+  IOTC_QUEUE_UNLINK(iotc_utest_queue_elem_t, queue, &elems[2]);
+  tt_int_op(iotc_utest_queue_verify_links(&queue), ==, 4);
+  tt_ptr_op(elems[1].__next, ==, &elems[3]);
+
+  IOTC_QUEUE_UNLINK(iotc_utest_queue_elem_t, queue, &elems[0]);
+  tt_int_op(iotc_utest_queue_verify_links(&queue), ==, 3);
+  tt_ptr_op(queue.head, ==, &elems[1]);
+
+  IOTC_QUEUE_UNLINK(iotc_utest_queue_elem_t, queue, &elems[4]);
+  tt_int_op(iotc_utest_queue_verify_links(&queue), ==, 2);
+  tt_ptr_op(queue.tail, ==, &elems[3]);
+
+  /* already unlinked, nothing happens */
+  IOTC_QUEUE_UNLINK(iotc_utest_queue_elem_t, queue, &elems[2]);
+  tt_int_op(iotc_utest_queue_verify_links(&queue), ==, 2);
+
+  IOTC_QUEUE_UNLINK(iotc_utest_queue_elem_t, queue, &elems[1]);
+  IOTC_QUEUE_UNLINK(iotc_utest_queue_elem_t, queue, &elems[3]);
+  tt_int_op(IOTC_QUEUE_EMPTY(queue), ==, 1);
+  tt_ptr_op(queue.tail, ==, NULL);
+
+end:;
+})
+
+IOTC_TT_TESTCASE(utest__iotc_queue_split__odd_elements__moved_in_order, {
+  iotc_utest_queue_elem_t elems[10];
+  iotc_utest_queue_t queue;
+  iotc_utest_queue_t odd_queue;
+  iotc_utest_queue_elem_t* found = NULL;
+
+  IOTC_QUEUE_INIT(queue);
+  IOTC_QUEUE_INIT(odd_queue);
+  iotc_utest_queue_fill(&queue, elems, 10);
+
+  IOTC_QUEUE_SPLIT_I(iotc_utest_queue_elem_t, queue,
+                     iotc_utest_queue_number_odd_predicate, NULL, odd_queue);
+
+  tt_int_op(iotc_utest_queue_verify_links(&queue), ==, 5);
+  tt_int_op(iotc_utest_queue_verify_links(&odd_queue), ==, 5);
+  tt_ptr_op(odd_queue.head, ==, &elems[1]);
+  tt_ptr_op(odd_queue.tail, ==, &elems[9]);
+
+  /* the list macros walk the queue */
+  IOTC_LIST_FIND(iotc_utest_queue_elem_t, odd_queue.head,
+                 IOTC_UTEST_QUEUE_HAS_VALUE, 7, found);
+  tt_ptr_op(found, ==, &elems[7]);
+
+  /* a detached list is attached back with its tail */
+  IOTC_QUEUE_ATTACH(iotc_utest_queue_elem_t, queue, odd_queue.head);
+  tt_int_op(iotc_utest_queue_verify_links(&queue), ==, 5);
+  tt_ptr_op(queue.tail, ==, &elems[9]);
+
+end:;
+})
+
+#ifdef IOTC_PLATFORM_BASE_POSIX
+IOTC_TT_TESTCASE(utest__iotc_queue_push_back__100k_elements__constant_time, {
+  const size_t elem_no = 100000;
+  iotc_utest_queue_elem_t* elems =
+      calloc(elem_no, sizeof(iotc_utest_queue_elem_t));
+  iotc_utest_queue_elem_t* out = NULL;
+  iotc_utest_queue_t queue;
+  struct timespec start;
+  struct timespec stop;
+  size_t i = 0;
+
+  tt_ptr_op(elems, !=, NULL);
+
+  IOTC_QUEUE_INIT(queue);
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  iotc_utest_queue_fill(&queue, elems, elem_no);
+  clock_gettime(CLOCK_MONOTONIC, &stop);
+
+  const double elapsed_sec =
+      (stop.tv_sec - start.tv_sec) + (stop.tv_nsec - start.tv_nsec) / 1e9;
+
+  printf("enqueued %zu elements in %.3f ms, %.1f ns per element\n", elem_no,
+         elapsed_sec * 1e3, elapsed_sec * 1e9 / elem_no);
+
+  /* the walking push back needs seconds for this */
+  tt_want(elapsed_sec < 0.5);
+
+  for (; i < elem_no; ++i) {
+    IOTC_QUEUE_POP_FRONT(iotc_utest_queue_elem_t, queue, out);
+    if (out != &elems[i]) {
+      tt_fail_msg("wrong order");
+      break;
+    }
+  }
+
+  tt_int_op(IOTC_QUEUE_EMPTY(queue), ==, 1);
+
+end:
+  free(elems);
+})
+#endif
+
+IOTC_TT_TESTGROUP_END
+
+#ifndef IOTC_TT_TESTCASE_ENUMERATION__SECONDPREPROCESSORRUN
+#define IOTC_TT_TESTCASE_ENUMERATION__SECONDPREPROCESSORRUN
+#include __FILE__
+#undef IOTC_TT_TESTCASE_ENUMERATION__SECONDPREPROCESSORRUN
+#endif
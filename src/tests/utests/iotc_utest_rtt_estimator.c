@@ -0,0 +1,141 @@
+/* Copyright 2018-2020 Google LLC
+ *
+ * This is part of the Google Cloud IoT Device SDK for Embedded C.
+ * It is licensed under the BSD 3-Clause license; you may not use this file
+ * except in compliance with the License.
+ *
+ * You may obtain a copy of the License at:
+ *  https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "iotc_tt_testcase_management.h"
+#include "tinytest.h"
+#include "tinytest_macros.h"
+
+#include "iotc_rtt_estimator.h"
+
+IOTC_TT_TESTGROUP_BEGIN(utest_rtt_estimator)
+
+IOTC_TT_TESTCASE(
+    utest__iotc_rtt_estimator_timeout__no_sample__configured_timeout, {
+      iotc_rtt_estimator_t estimator;
+      memset(&estimator, 0, sizeof(estimator));
+
+      tt_int_op(0, ==, iotc_rtt_estimator_rto_ms(&estimator));
+      tt_int_op(60, ==, iotc_rtt_estimator_timeout(&estimator, 2, 60));
+
+    end:;
+    })
+
+IOTC_TT_TESTCASE(
+    utest__iotc_rtt_estimator_add_sample__first_sample__srtt_and_half_rttvar, {
+      iotc_rtt_estimator_t estimator;
+      memset(&estimator, 0, sizeof(estimator));
+
+      iotc_rtt_estimator_add_sample(&estimator, 800);
+
+      tt_int_op(800, ==, estimator.srtt_ms);
+      tt_int_op(400, ==, estimator.rttvar_ms);
+      /* 800 + 4 * 400 */
+      tt_int_op(2400, ==, iotc_rtt_estimator_rto_ms(&estimator));
+      tt_int_op(3, ==, iotc_rtt_estimator_timeout(&estimator, 2, 60));
+
+    end:;
+    })
+
+IOTC_TT_TESTCASE(
+    utest__iotc_rtt_estimator_add_sample__next_samples__rfc6298_gains, {
+      iotc_rtt_estimator_t estimator;
+      memset(&estimator, 0, sizeof(estimator));
+
+      iotc_rtt_estimator_add_sample(&estimator, 800);
+      iotc_rtt_estimator_add_sample(&estimator, 1600);
+
+      /* RTTVAR = 3/4 * 400 + 1/4 * |800 - 1600| */
+      tt_int_op(500, ==, estimator.rttvar_ms);
+      /* SRTT = 7/8 * 800 + 1/8 * 1600 */
+      tt_int_op(900, ==, estimator.srtt_ms);
+
+      /* a steady link makes the variance decay */
+      int i = 0;
+      for (; i < 64; ++i) {
+        iotc_rtt_estimator_add_sample(&estimator, 100);
+      }
+
+      tt_int_op(estimator.srtt_ms, <=, 110);
+      tt_int_op(estimator.rttvar_ms, <=, 10);
+      tt_int_op(2, ==, iotc_rtt_estimator_timeout(&estimator, 2, 60));
+
+    end:;
+    })
+
+IOTC_TT_TESTCASE(
+    utest__iotc_rtt_estimator_backoff__timeouts__doubled_until_next_sample, {
+      iotc_rtt_estimator_t estimator;
+      memset(&estimator, 0, sizeof(estimator));
+
+      iotc_rtt_estimator_add_sample(&estimator, 2000);
+      tt_int_op(6000, ==, iotc_rtt_estimator_rto_ms(&estimator));
+
+      iotc_rtt_estimator_backoff(&estimator);
+      tt_int_op(12000, ==, iotc_rtt_estimator_rto_ms(&estimator));
+
+      iotc_rtt_estimator_backoff(&estimator);
+      tt_int_op(24000, ==, iotc_rtt_estimator_rto_ms(&estimator));
+      tt_int_op(20, ==, iotc_rtt_estimator_timeout(&estimator, 2, 20));
+
+      /* the backoff is capped */
+      int i = 0;
+      for (; i < 32; ++i) {
+        iotc_rtt_estimator_backoff(&estimator);
+      }
+      tt_int_op(6000 << IOTC_RTT_MAX_BACKOFF, ==,
+                iotc_rtt_estimator_rto_ms(&estimator));
+
+      iotc_rtt_estimator_add_sample(&estimator, 2000);
+      tt_int_op(0, ==, estimator.backoff);
+
+    end:;
+    })
+
+IOTC_TT_TESTCASE(
+    utest__iotc_rtt_estimator_pingresp_received__pending_pingreq__sampled, {
+      iotc_rtt_estimator_t estimator;
+      memset(&estimator, 0, sizeof(estimator));
+
+      /* no PINGREQ pending */
+      tt_int_op(-1, ==,
+                iotc_rtt_estimator_pingresp_received(&estimator, 5000));
+      tt_int_op(0, ==, estimator.has_sample);
+
+      iotc_rtt_estimator_pingreq_sent(&estimator, 10000);
+      tt_int_op(250, ==,
+                iotc_rtt_estimator_pingresp_received(&estimator, 10250));
+      tt_int_op(250, ==, estimator.srtt_ms);
+
+      /* the clock set back gives no sample */
+      iotc_rtt_estimator_pingreq_sent(&estimator, 20000);
+      tt_int_op(-1, ==,
+                iotc_rtt_estimator_pingresp_received(&estimator, 15000));
+      tt_int_op(250, ==, estimator.srtt_ms);
+      tt_int_op(0, ==, estimator.pingreq_time_ms);
+
+    end:;
+    })
+
+IOTC_TT_TESTGROUP_END
+
+#ifndef IOTC_TT_TESTCASE_ENUMERATION__SECONDPREPROCESSORRUN
+#define IOTC_TT_TESTCASE_ENUMERATION__SECONDPREPROCESSORRUN
+#include __FILE__
+#undef IOTC_TT_TESTCASE_ENUMERATION__SECONDPREPROCESSORRUN
+#endif
@@ -0,0 +1,193 @@
+/* Copyright 2018-2020 Google LLC
+ *
+ * This is part of the Google Cloud IoT Device SDK for Embedded C.
+ * It is licensed under the BSD 3-Clause license; you may not use this file
+ * except in compliance with the License.
+ *
+ * You may obtain a copy of the License at:
+ *  https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "iotc_memory_checks.h"
+#include "iotc_tt_testcase_management.h"
+#include "tinytest.h"
+#include "tinytest_macros.h"
+
+#include "iotc_fs_api.h"
+#include "iotc_internals.h"
+#include "iotc_session_store.h"
+
+#include <string.h>
+
+#ifndef IOTC_TT_TESTCASE_ENUMERATION__SECONDPREPROCESSORRUN
+
+#define IOTC_UTEST_SESSION_STORE_RESOURCE "utest_session_store.log"
+
+iotc_state_t utest_session_store_record_publish(iotc_session_store_t* store,
+                                                uint16_t msg_id,
+                                                const char* topic,
+                                                const char* payload) {
+  iotc_data_desc_t* data = iotc_make_desc_from_string_copy(payload);
+  const iotc_state_t state =
+      iotc_session_store_record_publish(store, msg_id, topic, data);
+  iotc_free_desc(&data);
+
+  return state;
+}
+
+#endif
+
+IOTC_TT_TESTGROUP_BEGIN(utest_session_store)
+
+IOTC_TT_TESTCASE(
+    utest__iotc_session_store_record_publish__no_log__nothing_recorded, {
+      iotc_session_store_t store;
+      memset(&store, 0, sizeof(store));
+
+      tt_int_op(0, ==, iotc_session_store_is_enabled(&store));
+
+      const iotc_session_store_config_t config = {NULL, 0};
+      tt_int_op(IOTC_STATE_OK, ==,
+                iotc_session_store_configure(&store, &config, NULL));
+      tt_int_op(1, ==, iotc_session_store_is_enabled(&store));
+
+      /* the tasks keep the publishes in memory, there's nothing to copy */
+      tt_int_op(IOTC_STATE_OK, ==,
+                utest_session_store_record_publish(&store, 1, "topic", "1"));
+      tt_int_op(0, ==, store.count);
+      tt_ptr_op(NULL, ==, iotc_session_store_adopt_restored(&store));
+
+      tt_int_op(IOTC_STATE_OK, ==,
+                iotc_session_store_configure(&store, NULL, NULL));
+      tt_int_op(0, ==, iotc_session_store_is_enabled(&store));
+
+    end:
+      iotc_session_store_destroy(&store);
+      tt_int_op(iotc_is_whole_memory_deallocated(), >, 0);
+    })
+
+#ifdef IOTC_FS_POSIX
+IOTC_TT_TESTCASE(
+    utest__iotc_session_store_configure__log_with_unacked_publish__only_unacked_restored,
+    {
+      iotc_session_store_t store;
+      memset(&store, 0, sizeof(store));
+
+      char* topic = NULL;
+      iotc_data_desc_t* data = NULL;
+
+      const iotc_session_store_config_t config = {
+          IOTC_UTEST_SESSION_STORE_RESOURCE, 0};
+
+      tt_int_op(IOTC_STATE_OK, ==,
+                iotc_session_store_configure(&store, &config, NULL));
+
+      tt_int_op(IOTC_STATE_OK, ==,
+                utest_session_store_record_publish(&store, 7, "acked/topic",
+                                                   "acked"));
+      tt_int_op(IOTC_STATE_OK, ==,
+                utest_session_store_record_publish(&store, 8, "inflight/topic",
+                                                   "payload"));
+      iotc_session_store_record_ack(&store, 7);
+      tt_int_op(IOTC_STATE_OK, ==, iotc_session_store_flush(&store));
+
+      /* three records appended after the magic */
+      tt_int_op(3, ==, store.log_records);
+
+      /* a restart */
+      iotc_session_store_destroy(&store);
+      tt_int_op(IOTC_STATE_OK, ==,
+                iotc_session_store_configure(&store, &config, NULL));
+
+      tt_int_op(1, ==, store.count);
+      /* compacted right away */
+      tt_int_op(1, ==, store.log_records);
+
+      iotc_session_store_entry_t* entry =
+          iotc_session_store_adopt_restored(&store);
+      tt_ptr_op(NULL, !=, entry);
+      tt_int_op(8, ==, entry->msg_id);
+
+      tt_int_op(IOTC_STATE_OK, ==,
+                iotc_session_store_entry_publish(entry, &topic, &data));
+      tt_str_op("inflight/topic", ==, topic);
+      tt_int_op(strlen("payload"), ==, data->length);
+      tt_int_op(0, ==, memcmp("payload", data->data_ptr, data->length));
+
+      /* adopted once only */
+      tt_ptr_op(NULL, ==, iotc_session_store_adopt_restored(&store));
+
+    end:
+      IOTC_SAFE_FREE(topic);
+      iotc_free_desc(&data);
+      iotc_session_store_destroy(&store);
+      iotc_internals.fs_functions.remove_resource(
+          NULL, IOTC_FS_CONFIG_DATA, IOTC_UTEST_SESSION_STORE_RESOURCE);
+      tt_int_op(iotc_is_whole_memory_deallocated(), >, 0);
+    })
+
+IOTC_TT_TESTCASE(
+    utest__iotc_session_store_flush__obsolete_records_over_threshold__log_compacted,
+    {
+      iotc_session_store_t store;
+      memset(&store, 0, sizeof(store));
+
+      const iotc_session_store_config_t config = {
+          IOTC_UTEST_SESSION_STORE_RESOURCE, 4};
+
+      tt_int_op(IOTC_STATE_OK, ==,
+                iotc_session_store_configure(&store, &config, NULL));
+
+      tt_int_op(IOTC_STATE_OK, ==,
+                utest_session_store_record_publish(&store, 1, "live", "1"));
+      tt_int_op(IOTC_STATE_OK, ==, iotc_session_store_flush(&store));
+      tt_int_op(1, ==, store.log_records);
+
+      tt_int_op(IOTC_STATE_OK, ==,
+                utest_session_store_record_publish(&store, 2, "acked", "2"));
+      iotc_session_store_record_ack(&store, 2);
+      tt_int_op(IOTC_STATE_OK, ==, iotc_session_store_flush(&store));
+
+      /* two obsolete records, below the threshold */
+      tt_int_op(3, ==, store.log_records);
+
+      tt_int_op(IOTC_STATE_OK, ==,
+                utest_session_store_record_publish(&store, 3, "acked", "3"));
+      iotc_session_store_record_ack(&store, 3);
+      tt_int_op(IOTC_STATE_OK, ==, iotc_session_store_flush(&store));
+
+      /* rewritten with the live publish only */
+      tt_int_op(1, ==, store.log_records);
+      tt_int_op(1, ==, store.count);
+
+      iotc_session_store_destroy(&store);
+      tt_int_op(IOTC_STATE_OK, ==,
+                iotc_session_store_configure(&store, &config, NULL));
+
+      iotc_session_store_entry_t* entry =
+          iotc_session_store_adopt_restored(&store);
+      tt_ptr_op(NULL, !=, entry);
+      tt_int_op(1, ==, entry->msg_id);
+      tt_ptr_op(NULL, ==, iotc_session_store_adopt_restored(&store));
+
+    end:
+      iotc_session_store_destroy(&store);
+      iotc_internals.fs_functions.remove_resource(
+          NULL, IOTC_FS_CONFIG_DATA, IOTC_UTEST_SESSION_STORE_RESOURCE);
+      tt_int_op(iotc_is_whole_memory_deallocated(), >, 0);
+    })
+#endif
+
+IOTC_TT_TESTGROUP_END
+
+#ifndef IOTC_TT_TESTCASE_ENUMERATION__SECONDPREPROCESSORRUN
+#define IOTC_TT_TESTCASE_ENUMERATION__SECONDPREPROCESSORRUN
+#include __FILE__
+#undef IOTC_TT_TESTCASE_ENUMERATION__SECONDPREPROCESSORRUN
+#endif
@@ -21,6 +21,9 @@
 #include "iotc_thread_ids.h"
 #include "iotc_thread_threadpool.h"
 
+#include <sched.h>
+#include <string.h>
+
 #ifndef IOTC_TT_TESTCASE_ENUMERATION__SECONDPREPROCESSORRUN
 
 #include "iotc_utest_thread_util_actions.h"
@@ -44,6 +47,40 @@ void iotc_utest_local__add_handler__threadpool(
   }
 }
 
+#define IOTC_UTEST_THREADPOOL_ORDERING_KEYS 8
+
+typedef struct iotc_utest_threadpool_ordering_s {
+  uint32_t next_seq[IOTC_UTEST_THREADPOOL_ORDERING_KEYS];
+  uint32_t out_of_order[IOTC_UTEST_THREADPOOL_ORDERING_KEYS];
+} iotc_utest_threadpool_ordering_t;
+
+/* a single argument carries both the ordering key and the sequence number */
+#define iotc_utest_threadpool_message(key, seq) \
+  (void*)(intptr_t)((seq)*IOTC_UTEST_THREADPOOL_ORDERING_KEYS + (key))
+
+iotc_state_t iotc_utest_local_action_check_order(void* ordering_ptr,
+                                                 void* message) {
+  iotc_utest_threadpool_ordering_t* ordering =
+      (iotc_utest_threadpool_ordering_t*)ordering_ptr;
+  const intptr_t key = (intptr_t)message % IOTC_UTEST_THREADPOOL_ORDERING_KEYS;
+  const uint32_t seq = (intptr_t)message / IOTC_UTEST_THREADPOOL_ORDERING_KEYS;
+
+  /* the handles of one key never run in parallel, no lock needed */
+  if (ordering->next_seq[key] != seq) {
+    ++ordering->out_of_order[key];
+  }
+
+  ordering->next_seq[key] = seq + 1;
+
+  return IOTC_STATE_OK;
+}
+
+iotc_state_t iotc_utest_local_action_count(void* counter_ptr) {
+  __atomic_add_fetch((uint32_t*)counter_ptr, 1, __ATOMIC_RELAXED);
+
+  return IOTC_STATE_OK;
+}
+
 #endif  // IOTC_TT_TESTCASE_ENUMERATION__SECONDPREPROCESSORRUN
 
 IOTC_TT_TESTGROUP_BEGIN(utest_thread_threadpool)
@@ -253,6 +290,114 @@ IOTC_TT_TESTCASE(
       iotc_destroy_critical_section(&iotc_uteset_local_action_store_cs);
     })
 
+IOTC_TT_TESTCASE(
+    utest__iotc_threadpool_execute_ordered__multikeys_multithreads__events_of_each_key_executed_in_order,
+    {
+      iotc_utest_threadpool_ordering_t ordering;
+      const uint32_t events_per_key = iotc_test_load_level ? 20000 : 500;
+
+      memset(&ordering, 0, sizeof(ordering));
+
+      iotc_threadpool_t* threadpool = iotc_threadpool_create_instance(3);
+      tt_ptr_op(NULL, !=, threadpool);
+
+      uint32_t seq = 0;
+      for (; seq < events_per_key; ++seq) {
+        intptr_t key = 0;
+        for (; key < IOTC_UTEST_THREADPOOL_ORDERING_KEYS; ++key) {
+          iotc_event_handle_t handle =
+              iotc_make_handle(&iotc_utest_local_action_check_order, &ordering,
+                               iotc_utest_threadpool_message(key, seq));
+
+          while (NULL ==
+                 iotc_threadpool_execute_ordered(threadpool, handle, key)) {
+            sched_yield(); /* memory limit reached, let the workers catch up */
+          }
+        }
+      }
+
+      /* destroy runs all the enqueued events */
+      iotc_threadpool_destroy_instance(&threadpool);
+
+      intptr_t key = 0;
+      for (; key < IOTC_UTEST_THREADPOOL_ORDERING_KEYS; ++key) {
+        tt_want_int_op(events_per_key, ==, ordering.next_seq[key]);
+        tt_want_int_op(0, ==, ordering.out_of_order[key]);
+      }
+
+    end:
+      iotc_threadpool_destroy_instance(&threadpool);
+    })
+
+IOTC_TT_TESTCASE(
+    utest__iotc_threadpool_create_instance_with_config__pinned_threads__alleventsexecuted,
+    {
+      const iotc_threadpool_config_t config = {4, 1};
+      uint32_t counter = 0;
+      const uint32_t events = 1000;
+
+      iotc_threadpool_t* threadpool =
+          iotc_threadpool_create_instance_with_config(&config);
+      tt_ptr_op(NULL, !=, threadpool);
+      tt_int_op(4, ==, threadpool->workerthreads->elem_no);
+
+      uint32_t counter_event = 0;
+      for (; counter_event < events; ++counter_event) {
+        while (NULL == iotc_threadpool_execute(
+                           threadpool,
+                           iotc_make_handle(&iotc_utest_local_action_count,
+                                            &counter))) {
+          sched_yield();
+        }
+      }
+
+      iotc_threadpool_destroy_instance(&threadpool);
+
+      tt_int_op(events, ==, counter);
+
+    end:
+      iotc_threadpool_destroy_instance(&threadpool);
+    })
+
+/* The throughput of the pool is measured by the BM_Threadpool* microbenchmarks
+ * in iotc_thread_posix_threadpool_benchmark.cc, this only checks that stealing
+ * loses no events whatever the number of workers. */
+IOTC_TT_TESTCASE(
+    utest__iotc_threadpool_execute__1_to_8_threads__alleventsexecuted, {
+      const uint8_t test_cases_thread_multiplicity[] = {1, 2, 4, 8};
+      const uint32_t events = iotc_test_load_level ? 200000 : 5000;
+
+      uint8_t counter_testcase = 0;
+      for (; counter_testcase < IOTC_ARRAYSIZE(test_cases_thread_multiplicity);
+           ++counter_testcase) {
+        uint32_t counter = 0;
+
+        iotc_threadpool_t* threadpool = iotc_threadpool_create_instance(
+            test_cases_thread_multiplicity[counter_testcase]);
+        tt_ptr_op(NULL, !=, threadpool);
+
+        uint32_t counter_event = 0;
+        for (; counter_event < events; ++counter_event) {
+          while (NULL == iotc_threadpool_execute(
+                             threadpool,
+                             iotc_make_handle(&iotc_utest_local_action_count,
+                                              &counter))) {
+            sched_yield();
+          }
+        }
+
+        while (__atomic_load_n(&counter, __ATOMIC_RELAXED) < events) {
+          sched_yield();
+        }
+
+        iotc_threadpool_destroy_instance(&threadpool);
+
+        tt_int_op(events, ==, counter);
+      }
+
+    end:;
+    })
+
 IOTC_TT_TESTGROUP_END
 
 #ifndef IOTC_TT_TESTCASE_ENUMERATION__SECONDPREPROCESSORRUN
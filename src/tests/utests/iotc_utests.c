@@ -45,6 +45,7 @@
 #define IOTC_TT_RESOURCE_MANAGER                  ( IOTC_TT_FS << 1 )
 #define IOTC_TT_IO_LAYER                          ( IOTC_TT_RESOURCE_MANAGER << 1 )
 #define IOTC_TT_TIME_EVENT                        ( IOTC_TT_IO_LAYER << 1 )
+#define IOTC_TT_MEMORY_ACCOUNTING                 ( IOTC_TT_TIME_EVENT << 1 )
 
 // clang-format on
 
@@ -62,6 +63,7 @@ IOTC_TT_TESTCASE_PREDECLARATION(utest_event_dispatcher);
 IOTC_TT_TESTCASE_PREDECLARATION(utest_event_dispatcher_timed);
 IOTC_TT_TESTCASE_PREDECLARATION(utest_datastructures);
 IOTC_TT_TESTCASE_PREDECLARATION(utest_list);
+IOTC_TT_TESTCASE_PREDECLARATION(utest_queue);
 IOTC_TT_TESTCASE_PREDECLARATION(utest_data_desc);
 IOTC_TT_TESTCASE_PREDECLARATION(utest_backoff);
 IOTC_TT_TESTCASE_PREDECLARATION(utest_memory_calloc);
@@ -75,11 +77,34 @@ IOTC_TT_TESTCASE_PREDECLARATION(utest_helper_functions);
 IOTC_TT_TESTCASE_PREDECLARATION(utest_mqtt_serializer);
 IOTC_TT_TESTCASE_PREDECLARATION(utest_handle);
 IOTC_TT_TESTCASE_PREDECLARATION(utest_timed_task);
+IOTC_TT_TESTCASE_PREDECLARATION(utest_connect_scheduler);
+IOTC_TT_TESTCASE_PREDECLARATION(utest_offline_queue);
+IOTC_TT_TESTCASE_PREDECLARATION(utest_session_store);
+IOTC_TT_TESTCASE_PREDECLARATION(utest_rtt_estimator);
+IOTC_TT_TESTCASE_PREDECLARATION(utest_dns);
+IOTC_TT_TESTCASE_PREDECLARATION(utest_io_net_race);
+IOTC_TT_TESTCASE_PREDECLARATION(utest_bsp_io_net);
 
 #ifdef IOTC_MEMORY_LIMITER_ENABLED
 IOTC_TT_TESTCASE_PREDECLARATION(utest_memory_limiter);
 #endif
 
+#ifdef IOTC_MEMORY_LIMITER_PROFILER_ENABLED
+IOTC_TT_TESTCASE_PREDECLARATION(utest_memory_profiler);
+#endif
+
+#ifdef IOTC_MEMORY_ACCOUNTING_ENABLED
+IOTC_TT_TESTCASE_PREDECLARATION(utest_memory_accounting);
+#endif
+
+#ifdef IOTC_LAYER_TRACING_ENABLED
+IOTC_TT_TESTCASE_PREDECLARATION(utest_layer_tracing);
+#endif
+
+#ifdef IOTC_DEBUG_BINARY_LOG
+IOTC_TT_TESTCASE_PREDECLARATION(utest_debug_log);
+#endif
+
 IOTC_TT_TESTCASE_PREDECLARATION(utest_rng);
 
 #ifdef IOTC_MODULE_THREAD_ENABLED
@@ -121,6 +146,7 @@ struct testgroup_t groups[] = {
 #if (IOTC_TT_TEST_SET & IOTC_TT_DATASTRUCTURES)
     {"utest_datastructures - ", utest_datastructures},
     {"utest_list - ", utest_list},
+    {"utest_queue - ", utest_queue},
 #endif
 
 #if (IOTC_TT_TEST_SET & IOTC_TT_EVENT_DISPATCHER)
@@ -173,6 +199,24 @@ struct testgroup_t groups[] = {
 #endif
 #endif
 
+#ifdef IOTC_MEMORY_LIMITER_PROFILER_ENABLED
+    {"utest_memory_profiler - ", utest_memory_profiler},
+#endif
+
+#ifdef IOTC_MEMORY_ACCOUNTING_ENABLED
+#if (IOTC_TT_TEST_SET & IOTC_TT_MEMORY_ACCOUNTING)
+    {"utest_memory_accounting - ", utest_memory_accounting},
+#endif
+#endif
+
+#ifdef IOTC_LAYER_TRACING_ENABLED
+    {"utest_layer_tracing - ", utest_layer_tracing},
+#endif
+
+#ifdef IOTC_DEBUG_BINARY_LOG
+    {"utest_debug_log - ", utest_debug_log},
+#endif
+
 #ifdef IOTC_MODULE_THREAD_ENABLED
 #if (IOTC_TT_TEST_SET & IOTC_TT_THREAD)
     {"utest_thread - ", utest_thread},
@@ -196,6 +240,19 @@ struct testgroup_t groups[] = {
 
     {"utest_timed_task - ", utest_timed_task},
 
+    {"utest_connect_scheduler - ", utest_connect_scheduler},
+
+    {"utest_offline_queue - ", utest_offline_queue},
+    {"utest_session_store - ", utest_session_store},
+
+    {"utest_rtt_estimator - ", utest_rtt_estimator},
+
+    {"utest_dns - ", utest_dns},
+
+    {"utest_io_net_race - ", utest_io_net_race},
+
+    {"utest_bsp_io_net - ", utest_bsp_io_net},
+
     {"utest_memory_calloc  - ", utest_memory_calloc},
 
 #if (IOTC_TT_TEST_SET & IOTC_TT_MQTT_CODEC_LAYER_DATA)
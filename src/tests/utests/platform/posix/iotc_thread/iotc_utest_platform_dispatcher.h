@@ -18,11 +18,74 @@
 #include "tinytest_macros.h"
 
 #include "iotc_event_dispatcher_api.h"
+#include "iotc_bsp_time.h"
+#include "iotc_event_loop.h"
+#include "iotc_event_loop_shards.h"
 
 #include "iotc_critical_section_def.h"
 
+#include <inttypes.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+
 #ifndef IOTC_TT_TESTCASE_ENUMERATION__SECONDPREPROCESSORRUN
 
+#define IOTC_UTEST_MPSC_MAX_PRODUCERS 16
+
+typedef struct utest_mpsc_consumer_s {
+  uint32_t next_seq[IOTC_UTEST_MPSC_MAX_PRODUCERS];
+  uint32_t consumed;
+  uint32_t out_of_order;
+} utest_mpsc_consumer_t;
+
+typedef struct utest_mpsc_producer_s {
+  pthread_t thread;
+  iotc_evtd_instance_t* evtd;
+  utest_mpsc_consumer_t* consumer;
+  intptr_t producer_id;
+  uint32_t messages;
+} utest_mpsc_producer_t;
+
+/* a single argument carries both the producer and its sequence number */
+#define utest_mpsc_message(producer_id, seq) \
+  (void*)(intptr_t)((seq)*IOTC_UTEST_MPSC_MAX_PRODUCERS + (producer_id))
+
+iotc_state_t utest_mpsc_consume(void* consumer_ptr, void* message) {
+  utest_mpsc_consumer_t* consumer = (utest_mpsc_consumer_t*)consumer_ptr;
+  const intptr_t producer_id =
+      (intptr_t)message % IOTC_UTEST_MPSC_MAX_PRODUCERS;
+  const uint32_t seq = (intptr_t)message / IOTC_UTEST_MPSC_MAX_PRODUCERS;
+
+  /* the queue keeps the order of every single producer */
+  if (consumer->next_seq[producer_id] != seq) {
+    ++consumer->out_of_order;
+  }
+
+  consumer->next_seq[producer_id] = seq + 1;
+  ++consumer->consumed;
+
+  return IOTC_STATE_OK;
+}
+
+void* utest_mpsc_produce(void* producer_ptr) {
+  utest_mpsc_producer_t* producer = (utest_mpsc_producer_t*)producer_ptr;
+
+  uint32_t seq = 0;
+  for (; seq < producer->messages; ++seq) {
+    while (NULL ==
+           iotc_evtd_execute(
+               producer->evtd,
+               iotc_make_handle(
+                   &utest_mpsc_consume, producer->consumer,
+                   utest_mpsc_message(producer->producer_id, seq)))) {
+      sched_yield(); /* memory limit reached, let the consumer catch up */
+    }
+  }
+
+  return NULL;
+}
+
 iotc_state_t register_evtd_handle(iotc_event_handle_arg1_t a) {
   tt_want_int_op(evtd_g_i->cs->cs_state, ==, 0);
 
@@ -63,6 +126,59 @@ iotc_state_t proc_loop_thread(iotc_event_handle_arg1_t a) {
   return 0;
 }
 
+typedef struct utest_wakeup_probe_s {
+  struct timespec executed_at;
+  volatile uint8_t executed;
+} utest_wakeup_probe_t;
+
+iotc_state_t utest_wakeup_probe(void* probe_ptr) {
+  utest_wakeup_probe_t* probe = (utest_wakeup_probe_t*)probe_ptr;
+
+  clock_gettime(CLOCK_MONOTONIC, &probe->executed_at);
+  __atomic_store_n(&probe->executed, 1, __ATOMIC_RELEASE);
+
+  return IOTC_STATE_OK;
+}
+
+iotc_state_t utest_wakeup_noop(void) { return IOTC_STATE_OK; }
+
+void* utest_wakeup_event_loop(void* evtd_ptr) {
+  iotc_evtd_instance_t* evtd = (iotc_evtd_instance_t*)evtd_ptr;
+
+  iotc_event_loop_with_evtds(0, &evtd, 1);
+
+  return NULL;
+}
+
+/* Submits the probe from the test thread while the loop thread is blocked in
+ * select and returns the submit-to-execute latency in milliseconds. */
+double utest_wakeup_measure_latency(iotc_evtd_instance_t* evtd,
+                                    uint8_t use_timed_event) {
+  utest_wakeup_probe_t probe;
+  struct timespec submitted_at;
+
+  memset(&probe, 0, sizeof(probe));
+
+  /* give the loop time to enter the wait */
+  IOTC_TIME_MILLISLEEP(100, deltatime);
+
+  clock_gettime(CLOCK_MONOTONIC, &submitted_at);
+
+  if (1 == use_timed_event) {
+    iotc_evtd_execute_in(evtd, iotc_make_handle(&utest_wakeup_probe, &probe),
+                         0, NULL);
+  } else {
+    iotc_evtd_execute(evtd, iotc_make_handle(&utest_wakeup_probe, &probe));
+  }
+
+  while (0 == __atomic_load_n(&probe.executed, __ATOMIC_ACQUIRE)) {
+    IOTC_TIME_MILLISLEEP(1, polltime);
+  }
+
+  return (probe.executed_at.tv_sec - submitted_at.tv_sec) * 1e3 +
+         (probe.executed_at.tv_nsec - submitted_at.tv_nsec) / 1e6;
+}
+
 #endif
 
 IOTC_TT_TESTCASE(utest__thread_safety_clash__entities_must_not_clash, {
@@ -145,3 +261,189 @@ IOTC_TT_TESTCASE(
 
     end:;
     })
+
+/* Contention benchmark of iotc_evtd_execute: N threads post handles to a
+ * single dispatcher stepped by the test thread. The throughput is reported
+ * through the debug log, the test itself checks that nothing is lost or
+ * reordered. */
+IOTC_TT_TESTCASE(
+    utest__iotc_evtd_execute__concurrent_producers__all_handles_executed_in_producer_order,
+    {
+      const uint8_t nb_producers[] = {1, 2, 4, 8, 16};
+      const uint32_t messages_per_producer =
+          iotc_test_load_level ? 100000 : 2000;
+
+      size_t id_producers = 0;
+      for (; id_producers < IOTC_ARRAYSIZE(nb_producers); ++id_producers) {
+        const uint8_t producers_no = nb_producers[id_producers];
+        utest_mpsc_producer_t producers[IOTC_UTEST_MPSC_MAX_PRODUCERS];
+        utest_mpsc_consumer_t consumer;
+        struct timespec start;
+        struct timespec stop;
+
+        memset(&consumer, 0, sizeof(consumer));
+
+        iotc_evtd_instance_t* evtd = iotc_evtd_create_instance();
+        tt_ptr_op(NULL, !=, evtd);
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+
+        uint8_t id_producer = 0;
+        for (; id_producer < producers_no; ++id_producer) {
+          producers[id_producer].evtd = evtd;
+          producers[id_producer].consumer = &consumer;
+          producers[id_producer].producer_id = id_producer;
+          producers[id_producer].messages = messages_per_producer;
+          pthread_create(&producers[id_producer].thread, NULL,
+                         &utest_mpsc_produce, &producers[id_producer]);
+        }
+
+        const uint32_t expected = producers_no * messages_per_producer;
+        while (consumer.consumed < expected) {
+          iotc_evtd_step(evtd, 0);
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &stop);
+
+        for (id_producer = 0; id_producer < producers_no; ++id_producer) {
+          pthread_join(producers[id_producer].thread, NULL);
+        }
+
+        const double elapsed_sec = (stop.tv_sec - start.tv_sec) +
+                                   (stop.tv_nsec - start.tv_nsec) / 1e9;
+        iotc_debug_format("[mpsc] producers: %d, handles: %" PRIu32
+                          ", %.0f handles/s",
+                          producers_no, expected, expected / elapsed_sec);
+
+        tt_want_int_op(consumer.consumed, ==, expected);
+        tt_want_int_op(consumer.out_of_order, ==, 0);
+        tt_want_int_op(iotc_mpsc_queue_is_empty(&evtd->call_queue), ==, 1);
+
+        iotc_evtd_destroy_instance(evtd);
+      }
+
+    end:;
+    })
+
+/* Without the wakeup the loop below sleeps in select until the far timed
+ * event, IOTC_MAX_IDLE_TIMEOUT seconds. */
+IOTC_TT_TESTCASE(
+    utest__iotc_evtd_enable_wakeup__submission_while_loop_blocked__executed_without_waiting_for_timeout,
+    {
+      pthread_t loop_thread;
+      iotc_time_event_handle_t far_event = iotc_make_empty_time_event_handle();
+
+      iotc_evtd_instance_t* evtd = iotc_evtd_create_instance();
+      tt_ptr_op(NULL, !=, evtd);
+      tt_int_op(IOTC_STATE_OK, ==, iotc_evtd_enable_wakeup(evtd));
+
+      /* timed events are relative to the last step */
+      iotc_evtd_step(evtd, iotc_bsp_time_getcurrenttime_seconds());
+      iotc_evtd_execute_in(evtd, iotc_make_handle(&utest_wakeup_noop),
+                           IOTC_MAX_IDLE_TIMEOUT * 10, &far_event);
+
+      pthread_create(&loop_thread, NULL, &utest_wakeup_event_loop, evtd);
+
+      const double call_queue_latency_ms =
+          utest_wakeup_measure_latency(evtd, 0);
+      const double timed_event_latency_ms =
+          utest_wakeup_measure_latency(evtd, 1);
+
+      iotc_debug_format("[wakeup] submit-to-execute latency: %.3f ms, "
+                        "timed event latency: %.3f ms",
+                        call_queue_latency_ms, timed_event_latency_ms);
+
+      iotc_evtd_stop(evtd);
+      pthread_join(loop_thread, NULL);
+
+      tt_want_int_op(call_queue_latency_ms, <, 500);
+      tt_want_int_op(timed_event_latency_ms, <, 500);
+
+      iotc_evtd_cancel(evtd, &far_event);
+      iotc_evtd_destroy_instance(evtd);
+
+    end:;
+    })
+
+#ifndef IOTC_TT_TESTCASE_ENUMERATION__SECONDPREPROCESSORRUN
+
+#define IOTC_UTEST_NUM_SHARDS 4
+
+typedef struct utest_shard_probe_s {
+  pthread_t executed_on;
+  volatile uint8_t executed;
+} utest_shard_probe_t;
+
+iotc_state_t utest_shard_probe(void* probe_ptr) {
+  utest_shard_probe_t* probe = (utest_shard_probe_t*)probe_ptr;
+
+  probe->executed_on = pthread_self();
+  __atomic_store_n(&probe->executed, 1, __ATOMIC_RELEASE);
+
+  return IOTC_STATE_OK;
+}
+
+#endif
+
+IOTC_TT_TESTCASE(
+    utest__iotc_event_loop_shards_acquire__shards_running__contexts_spread_evenly_and_handles_run_on_shard_threads,
+    {
+      iotc_evtd_instance_t* acquired[IOTC_UTEST_NUM_SHARDS * 2];
+      utest_shard_probe_t probes[IOTC_UTEST_NUM_SHARDS];
+      size_t i = 0;
+      size_t j = 0;
+
+      memset(probes, 0, sizeof(probes));
+
+      tt_int_op(IOTC_INVALID_PARAMETER, ==, iotc_event_loop_shards_start(0));
+      tt_ptr_op(NULL, ==, iotc_event_loop_shards_acquire());
+
+      tt_int_op(IOTC_STATE_OK, ==,
+                iotc_event_loop_shards_start(IOTC_UTEST_NUM_SHARDS));
+      tt_int_op(IOTC_ALREADY_INITIALIZED, ==,
+                iotc_event_loop_shards_start(IOTC_UTEST_NUM_SHARDS));
+
+      for (i = 0; i < IOTC_UTEST_NUM_SHARDS * 2; ++i) {
+        acquired[i] = iotc_event_loop_shards_acquire();
+        tt_ptr_op(NULL, !=, acquired[i]);
+      }
+
+      /* the least loaded shard is picked, every shard gets two contexts */
+      for (i = 0; i < IOTC_UTEST_NUM_SHARDS; ++i) {
+        size_t same_shard = 0;
+        for (j = 0; j < IOTC_UTEST_NUM_SHARDS * 2; ++j) {
+          same_shard += (acquired[i] == acquired[j]) ? 1 : 0;
+        }
+        tt_int_op(2, ==, same_shard);
+      }
+
+      /* shards can't go away under their contexts */
+      tt_int_op(IOTC_INVALID_PARAMETER, ==, iotc_event_loop_shards_stop());
+
+      for (i = 0; i < IOTC_UTEST_NUM_SHARDS; ++i) {
+        iotc_evtd_execute(acquired[i],
+                          iotc_make_handle(&utest_shard_probe, &probes[i]));
+      }
+
+      for (i = 0; i < IOTC_UTEST_NUM_SHARDS; ++i) {
+        while (0 == __atomic_load_n(&probes[i].executed, __ATOMIC_ACQUIRE)) {
+          IOTC_TIME_MILLISLEEP(1, polltime);
+        }
+
+        tt_want(0 == pthread_equal(pthread_self(), probes[i].executed_on));
+
+        for (j = 0; j < i; ++j) {
+          tt_want(0 ==
+                  pthread_equal(probes[j].executed_on, probes[i].executed_on));
+        }
+      }
+
+      for (i = 0; i < IOTC_UTEST_NUM_SHARDS * 2; ++i) {
+        iotc_event_loop_shards_release(acquired[i]);
+      }
+
+      tt_int_op(IOTC_STATE_OK, ==, iotc_event_loop_shards_stop());
+
+    end:
+      iotc_event_loop_shards_stop();
+    })
@@ -0,0 +1,158 @@
+/* Copyright 2018-2020 Google LLC
+ *
+ * This is part of the Google Cloud IoT Device SDK for Embedded C.
+ * It is licensed under the BSD 3-Clause license; you may not use this file
+ * except in compliance with the License.
+ *
+ * You may obtain a copy of the License at:
+ *  https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tinytest.h"
+#include "tinytest_macros.h"
+
+#include "iotc_offline_queue.h"
+
+#include <inttypes.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifndef IOTC_TT_TESTCASE_ENUMERATION__SECONDPREPROCESSORRUN
+
+typedef struct utest_offline_queue_publisher_s {
+  pthread_t thread;
+  iotc_offline_queue_t* queue;
+  uint32_t messages;
+  volatile uint32_t published;
+  uint32_t sent_directly;
+  uint32_t first_sent_directly;
+  uint32_t rejected;
+} utest_offline_queue_publisher_t;
+
+/* flipped by the test's "event loop" when the CONNACK arrives */
+static volatile uint8_t utest_offline_queue_online = 0;
+
+uint8_t utest_offline_queue_is_online(iotc_context_handle_t context_handle) {
+  IOTC_UNUSED(context_handle);
+
+  return utest_offline_queue_online;
+}
+
+/* stands for the application's thread calling iotc_publish(), the payload is
+ * the sequence number of the message */
+void* utest_offline_queue_publish(void* publisher_ptr) {
+  utest_offline_queue_publisher_t* publisher =
+      (utest_offline_queue_publisher_t*)publisher_ptr;
+
+  uint32_t seq = 0;
+  for (; seq < publisher->messages; ++seq) {
+    char payload[11] = {0};
+    snprintf(payload, sizeof(payload), "%" PRIu32, seq);
+
+    iotc_data_desc_t* data = iotc_make_desc_from_string_copy(payload);
+    iotc_state_t state = IOTC_STATE_OK;
+
+    if (NULL == data) {
+      ++publisher->rejected;
+    } else if (0 == iotc_offline_queue_push_unless_online(
+                        publisher->queue, &utest_offline_queue_is_online,
+                        IOTC_INVALID_CONTEXT_HANDLE, "topic", data,
+                        IOTC_MQTT_QOS_AT_LEAST_ONCE, iotc_make_empty_handle(),
+                        NULL, &state)) {
+      /* published directly, after everything the drain popped */
+      if (0 == publisher->sent_directly) {
+        publisher->first_sent_directly = seq;
+      }
+
+      ++publisher->sent_directly;
+      iotc_free_desc(&data);
+    } else if (IOTC_STATE_OK != state) {
+      ++publisher->rejected;
+    }
+
+    publisher->published = seq + 1;
+
+    /* lets the drain run in between the publishes */
+    sched_yield();
+  }
+
+  return NULL;
+}
+
+#endif  // IOTC_TT_TESTCASE_ENUMERATION__SECONDPREPROCESSORRUN
+
+IOTC_TT_TESTCASE(
+    utest__iotc_offline_queue_push_unless_online__publishing_while_drained__nothing_left_behind_and_order_kept,
+    {
+      const uint32_t messages = iotc_test_load_level ? 60000 : 2000;
+
+      iotc_offline_queue_t queue;
+      memset(&queue, 0, sizeof(queue));
+
+      const iotc_offline_queue_config_t config = {
+          (uint16_t)messages, 0, IOTC_OFFLINE_QUEUE_DROP_OLDEST, NULL};
+      tt_int_op(IOTC_STATE_OK, ==,
+                iotc_offline_queue_configure(&queue, &config, NULL));
+
+      utest_offline_queue_publisher_t publisher;
+      memset(&publisher, 0, sizeof(publisher));
+      publisher.queue = &queue;
+      publisher.messages = messages;
+      publisher.first_sent_directly = messages;
+
+      utest_offline_queue_online = 0;
+
+      pthread_create(&publisher.thread, NULL, &utest_offline_queue_publish,
+                     &publisher);
+
+      /* the CONNACK arrives while the application keeps publishing */
+      while (publisher.published < messages / 4) {
+        sched_yield();
+      }
+
+      utest_offline_queue_online = 1;
+
+      /* the drain, popping until the queue is empty once */
+      uint32_t drained = 0;
+      uint32_t out_of_order = 0;
+      iotc_offline_message_t* message = NULL;
+
+      while (NULL != (message = iotc_offline_queue_pop(&queue))) {
+        char payload[11] = {0};
+        memcpy(payload, message->data->data_ptr,
+               IOTC_MIN(message->data->length, sizeof(payload) - 1));
+
+        if (drained != (uint32_t)strtoul(payload, NULL, 10)) {
+          ++out_of_order;
+        }
+
+        ++drained;
+        iotc_offline_queue_free_message(&message);
+
+        /* the publisher keeps pushing while the queue is drained, the drain
+         * yields half as often so that it catches up with it */
+        if (0 == drained % 2) {
+          sched_yield();
+        }
+      }
+
+      pthread_join(publisher.thread, NULL);
+
+      tt_int_op(0, ==, publisher.rejected);
+      tt_int_op(0, ==, out_of_order);
+      tt_int_op(messages, ==, drained + publisher.sent_directly);
+      tt_int_op(drained, ==, publisher.first_sent_directly);
+      tt_int_op(1, ==, iotc_offline_queue_is_empty(&queue));
+
+    end:
+      iotc_offline_queue_destroy(&queue);
+      tt_int_op(iotc_is_whole_memory_deallocated(), >, 0);
+    })
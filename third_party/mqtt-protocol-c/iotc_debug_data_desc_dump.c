@@ -49,10 +49,7 @@ void iotc_debug_data_desc_dump_ascii(const iotc_data_desc_t* buffer) {
     return;
   }
 
-  size_t i = 0;
-  for (; i < buffer->length; ++i) {
-    iotc_debug_printf("%c", buffer->data_ptr[i]);
-  }
+  iotc_debug_printf("%.*s", (int)buffer->length, (const char*)buffer->data_ptr);
 }
 
 void iotc_debug_data_desc_dump_hex(const iotc_data_desc_t* buffer) {
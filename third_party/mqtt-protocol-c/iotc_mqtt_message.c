@@ -23,6 +23,11 @@
 
 #if IOTC_DEBUG_OUTPUT
 void iotc_debug_mqtt_message_dump(const iotc_mqtt_message_t* message) {
+  if (!iotc_debug_is_enabled(IOTC_DEBUG_LOG_LEVEL_TRACE,
+                             IOTC_DEBUG_LOG_MODULE_MQTT)) {
+    return;
+  }
+
   iotc_debug_printf("message\n");
   iotc_debug_printf("  type:              %d\n",
                     message->common.common_u.common_bits.type);